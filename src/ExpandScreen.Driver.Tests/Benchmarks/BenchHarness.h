@@ -0,0 +1,113 @@
+/*++
+
+Module Name:
+    BenchHarness.h
+
+Abstract:
+    驱动可移植核心的基准测试框架与计时工具
+
+--*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace BenchHarness {
+
+using Clock = std::chrono::steady_clock;
+
+struct Benchmark
+{
+    const char* Name;
+    std::function<void()> Body;
+};
+
+inline std::vector<Benchmark>& Registry()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct Registrar
+{
+    Registrar(const char* name, std::function<void()> body)
+    {
+        Registry().push_back({ name, std::move(body) });
+    }
+};
+
+inline double SecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+inline double MicrosecondsBetween(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// 返回第p百分位（0-100），会对输入排序
+inline double Percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    size_t index = (size_t)((p / 100.0) * (double)(samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+struct DisplayMode
+{
+    int32_t Width;
+    int32_t Height;
+    int32_t RefreshRate;
+};
+
+// 与Driver.h中的g_SupportedModes一致（驱动头文件依赖WDK，这里无法包含）
+constexpr DisplayMode DriverModes[] =
+{
+    { 1920, 1080, 60 },
+    { 1920, 1080, 120 },
+    { 2560, 1600, 60 },
+    { 1280, 720, 60 },
+    { 3840, 2160, 60 }
+};
+
+// DriverModes中不同的分辨率，按面积从小到大。逐帧开销与刷新率无关的基准用它去重
+inline std::vector<DisplayMode> DriverResolutions()
+{
+    std::vector<DisplayMode> modes(std::begin(DriverModes), std::end(DriverModes));
+    std::sort(modes.begin(), modes.end(), [](const DisplayMode& a, const DisplayMode& b)
+    {
+        const int64_t areaA = (int64_t)a.Width * a.Height, areaB = (int64_t)b.Width * b.Height;
+        return areaA != areaB ? areaA < areaB : a.Width < b.Width;
+    });
+    modes.erase(std::unique(modes.begin(), modes.end(), [](const DisplayMode& a, const DisplayMode& b)
+    {
+        return a.Width == b.Width && a.Height == b.Height;
+    }), modes.end());
+    return modes;
+}
+
+// 防止编译器优化掉基准结果
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace BenchHarness
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static BenchHarness::Registrar name##_registrar(#name, name); \
+    static void name()
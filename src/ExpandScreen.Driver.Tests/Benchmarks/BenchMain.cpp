@@ -0,0 +1,35 @@
+/*++
+
+Module Name:
+    BenchMain.cpp
+
+Abstract:
+    基准入口，不带参数时运行全部基准，否则按名称子串过滤
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    for (const BenchHarness::Benchmark& benchmark : BenchHarness::Registry())
+    {
+        bool selected = (argc <= 1);
+        for (int i = 1; i < argc && !selected; i++)
+        {
+            selected = (std::strstr(benchmark.Name, argv[i]) != nullptr);
+        }
+
+        if (!selected)
+        {
+            continue;
+        }
+
+        std::printf("== %s\n", benchmark.Name);
+        benchmark.Body();
+    }
+
+    return 0;
+}
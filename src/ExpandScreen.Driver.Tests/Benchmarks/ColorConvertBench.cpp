@@ -0,0 +1,71 @@
+/*++
+
+Module Name:
+    ColorConvertBench.cpp
+
+Abstract:
+    BGRA到NV12转换基准：g_SupportedModes中的每个分辨率 x 每个SIMD内核，
+    报告每帧耗时与像素吞吐
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "ColorConvert.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+BENCHMARK(ColorConvert_Nv12Modes)
+{
+    // 刷新率不影响转换开销，按分辨率去重
+    for (const DisplayMode& mode : DriverResolutions())
+    {
+        const size_t pitch = (size_t)mode.Width * 4;
+        std::vector<uint8_t> bgra(pitch * mode.Height);
+        std::mt19937 rng(1);
+        for (uint8_t& b : bgra)
+        {
+            b = (uint8_t)rng();
+        }
+
+        std::vector<uint8_t> nv12((size_t)mode.Width * mode.Height * 3 / 2);
+        Nv12Surface surface = { nv12.data(), (size_t)mode.Width,
+            nv12.data() + (size_t)mode.Width * mode.Height, (size_t)mode.Width };
+
+        double scalarMs = 0;
+        for (CpuLevel level : { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 })
+        {
+            if (ClampCpuLevel(level) != level)
+            {
+                std::printf("  %4dx%-4d %-8s 本机不支持\n", mode.Width, mode.Height, CpuLevelName(level));
+                continue;
+            }
+
+            Nv12Converter converter(YuvMatrix::Bt709, YuvRange::Limited, level);
+            converter.ConvertFrame(bgra.data(), pitch, mode.Width, mode.Height, surface);
+
+            std::vector<double> frameMs;
+            const int iterations = mode.Width >= 3840 ? 30 : 60;
+            for (int i = 0; i < iterations; i++)
+            {
+                auto start = Clock::now();
+                converter.ConvertFrame(bgra.data(), pitch, mode.Width, mode.Height, surface);
+                frameMs.push_back(MicrosecondsBetween(start, Clock::now()) / 1000.0);
+            }
+            DoNotOptimize(nv12[0]);
+
+            double p50 = Percentile(frameMs, 50);
+            if (level == CpuLevel::Scalar)
+            {
+                scalarMs = p50;
+            }
+
+            std::printf("  %4dx%-4d %-8s p50=%6.3fms  %7.1f Mpx/s  x%.1f\n",
+                mode.Width, mode.Height, CpuLevelName(level), p50,
+                (double)mode.Width * mode.Height / p50 / 1e3, scalarMs / p50);
+        }
+    }
+}
@@ -0,0 +1,212 @@
+/*++
+
+Module Name:
+    CursorChannelBench.cpp
+
+Abstract:
+    硬件光标通道基准：只移动指针的轨迹下，光标合成进桌面（每个60Hz帧的脏区域为
+    光标新旧位置，经DirtyRegionCoalescer对齐后以NV12交给编码器）与硬件光标
+    （1000Hz采样经CursorStateTracker去重后发布到光标通道）每秒需要处理的字节数，
+    以及光标事件经共享内存发布与取出的耗时
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "SharedMemory.h"
+#include "CursorChannel.h"
+#include "DirtyRegion.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 1920;
+const int32_t Height = 1080;
+const int SampleRate = 1000;        // 鼠标采样率（Hz）
+const int RefreshRate = 60;
+const int Seconds = 10;
+
+struct PointerSample
+{
+    int32_t X;
+    int32_t Y;
+};
+
+struct PointerTrace
+{
+    const char* Name;
+    std::vector<PointerSample> Samples;     // 每毫秒一个
+};
+
+// 水平来回扫过屏幕，1500像素/秒
+PointerTrace Sweep()
+{
+    PointerTrace trace{ "sweep", {} };
+    for (int i = 0; i < SampleRate * Seconds; i++)
+    {
+        int32_t span = Width - 64;
+        int32_t x = (int32_t)((int64_t)i * 1500 / SampleRate % (2 * span));
+        trace.Samples.push_back({ x < span ? x : 2 * span - x, Height / 2 });
+    }
+    return trace;
+}
+
+// 半径200像素画圈，每秒一圈
+PointerTrace Circle()
+{
+    PointerTrace trace{ "circle", {} };
+    for (int i = 0; i < SampleRate * Seconds; i++)
+    {
+        double angle = 2.0 * 3.14159265358979 * i / SampleRate;
+        trace.Samples.push_back({ Width / 2 + (int32_t)(200 * std::cos(angle)), Height / 2 + (int32_t)(200 * std::sin(angle)) });
+    }
+    return trace;
+}
+
+// 悬停：停在按钮上，手的轻微抖动偶尔移动1~2像素
+PointerTrace Hover()
+{
+    PointerTrace trace{ "hover", {} };
+    std::mt19937 rng(11);
+    int32_t x = 800, y = 600;
+    for (int i = 0; i < SampleRate * Seconds; i++)
+    {
+        if (rng() % 40 == 0)
+        {
+            x += (int32_t)(rng() % 5) - 2;
+            y += (int32_t)(rng() % 5) - 2;
+        }
+        trace.Samples.push_back({ x, y });
+    }
+    return trace;
+}
+
+// 快速甩动：100ms内移动800像素，再停400ms
+PointerTrace Flick()
+{
+    PointerTrace trace{ "flick", {} };
+    std::mt19937 rng(12);
+    int32_t x = 200, y = 200;
+    int32_t targetX = x, targetY = y;
+    for (int i = 0; i < SampleRate * Seconds; i++)
+    {
+        int phase = i % 500;
+        if (phase == 0)
+        {
+            targetX = 100 + (int32_t)(rng() % (Width - 300));
+            targetY = 100 + (int32_t)(rng() % (Height - 300));
+        }
+        if (phase < 100)
+        {
+            x += (targetX - x) / (100 - phase);
+            y += (targetY - y) / (100 - phase);
+        }
+        trace.Samples.push_back({ x, y });
+    }
+    return trace;
+}
+
+FrameRect CursorRect(const PointerSample& sample, int32_t cursorSize)
+{
+    return { sample.X, sample.Y, sample.X + cursorSize, sample.Y + cursorSize };
+}
+
+void RunTrace(const PointerTrace& trace, int32_t cursorSize)
+{
+    // 光标合成进桌面：每个刷新区间光标移动过就发布一帧，脏区域为新旧位置
+    DirtyRegionCoalescer coalescer;
+    FrameRect dirty[64];
+    uint64_t compositedFrames = 0;
+    double compositedBytes = 0;
+    const size_t frames = trace.Samples.size() * RefreshRate / SampleRate;
+
+    for (size_t frame = 1; frame < frames; frame++)
+    {
+        const PointerSample& previous = trace.Samples[(frame - 1) * SampleRate / RefreshRate];
+        const PointerSample& current = trace.Samples[frame * SampleRate / RefreshRate];
+        if (previous.X == current.X && previous.Y == current.Y)
+        {
+            continue;
+        }
+
+        const FrameRect rects[] = { CursorRect(previous, cursorSize), CursorRect(current, cursorSize) };
+        uint32_t count = coalescer.Coalesce(rects, 2, Width, Height, dirty, 64);
+        for (uint32_t r = 0; r < count; r++)
+        {
+            compositedBytes += (double)dirty[r].Area() * 3 / 2;
+        }
+        compositedFrames++;
+    }
+
+    // 硬件光标：每个采样查询一次，只有变化才发布事件；形状只发布一次
+    SharedMemoryRegion region(CursorChannelLayout::RequiredSize());
+    if (!region.IsValid() || !CursorChannelProducer::Format(region.Writable(), region.Size()))
+    {
+        std::printf("  无法分配共享内存\n");
+        return;
+    }
+
+    CursorChannelProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    CursorChannelConsumer consumer;
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    const CursorShapeInfo shape = { 1, CursorShapeType::Alpha, (uint32_t)cursorSize, (uint32_t)cursorSize, (uint32_t)cursorSize * 4, 0 };
+    const CursorShapeRef shapeRef = { 1, 0, 0, 0 };
+    std::vector<uint8_t> shapePixels((size_t)cursorSize * cursorSize * 4, 0x80);
+    producer.PublishShape(0, shape, shapePixels.data());
+
+    CursorStateTracker tracker;
+    CursorEvent event;
+    CursorEvent polled[64];
+    uint64_t events = 0;
+    uint64_t received = 0;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < trace.Samples.size(); i++)
+    {
+        const PointerSample& sample = trace.Samples[i];
+        if (tracker.Update(true, sample.X, sample.Y, i == 0 ? &shapeRef : nullptr, (int64_t)i, event))
+        {
+            producer.PublishEvent(event);
+            events++;
+        }
+
+        // 消费者每个刷新区间取一次
+        if (i % (size_t)(SampleRate / RefreshRate) == 0)
+        {
+            received += consumer.Poll(polled, 64);
+        }
+    }
+    received += consumer.Poll(polled, 64);
+    const double us = MicrosecondsBetween(start, Clock::now());
+    DoNotOptimize(polled[0]);
+
+    const double cursorBytes = (double)events * sizeof(CursorEvent) + (double)shapePixels.size();
+    std::printf("  %-6s 光标%2dpx  合成: %5.1f帧/秒 编码输入%8.1fKB/秒  硬件光标: %6.1f事件/秒 %6.2fKB/秒 (取出%llu 丢失%llu)  减少 x%.0f  每事件%.0fns\n",
+        trace.Name, cursorSize,
+        (double)compositedFrames / Seconds, compositedBytes / Seconds / 1024,
+        (double)events / Seconds, cursorBytes / Seconds / 1024,
+        (unsigned long long)received, (unsigned long long)consumer.LostEvents(),
+        cursorBytes > 0 ? compositedBytes / cursorBytes : 0.0,
+        events != 0 ? us * 1000 / (double)events : 0.0);
+}
+
+} // namespace
+
+BENCHMARK(CursorChannel_PointerOnlyTraces)
+{
+    const PointerTrace traces[] = { Sweep(), Circle(), Hover(), Flick() };
+    for (int32_t cursorSize : { 32, 64 })
+    {
+        for (const PointerTrace& trace : traces)
+        {
+            RunTrace(trace, cursorSize);
+        }
+    }
+}
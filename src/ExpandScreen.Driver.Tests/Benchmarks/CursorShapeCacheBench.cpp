@@ -0,0 +1,175 @@
+/*++
+
+Module Name:
+    CursorShapeCacheBench.cpp
+
+Abstract:
+    光标形状缓存基准：
+        1. 各SIMD级别对常见光标尺寸计算形状哈希的耗时
+        2. 命中（哈希+逐字节确认）与未命中（哈希+复制）的单次查找耗时
+        3. 编辑器/绘图工具频繁切换光标时，有无缓存需要发布的位图字节数
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "CursorShapeCache.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+struct Shape
+{
+    CursorShapeInfo Info;
+    std::vector<uint8_t> Pixels;
+};
+
+Shape MakeShape(uint32_t size, uint32_t seed)
+{
+    Shape shape{ { 0, CursorShapeType::Alpha, size, size, size * 4, 0 }, std::vector<uint8_t>((size_t)size * size * 4) };
+    std::mt19937 rng(seed);
+    for (uint8_t& b : shape.Pixels)
+    {
+        b = (uint8_t)rng();
+    }
+    return shape;
+}
+
+} // namespace
+
+BENCHMARK(CursorShapeCache_HashCost)
+{
+    const CpuLevel levels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+    const int Iterations = 20000;
+
+    for (uint32_t size : { 32u, 48u, 64u, 128u, 256u })
+    {
+        const Shape shape = MakeShape(size, size);
+        std::printf("  %3ux%-3u", size, size);
+
+        for (CpuLevel level : levels)
+        {
+            if (ClampCpuLevel(level) != level)
+            {
+                continue;
+            }
+
+            CursorShapeCache cache(CursorShapeSlotCount, level);
+            uint64_t sink = 0;
+            auto start = Clock::now();
+            for (int i = 0; i < Iterations; i++)
+            {
+                sink += cache.Hash(shape.Info, shape.Pixels.data());
+            }
+            const double ns = MicrosecondsBetween(start, Clock::now()) * 1000 / Iterations;
+            DoNotOptimize(sink);
+
+            std::printf("  %s %7.0fns (%5.1fGB/s)", CpuLevelName(level), ns, (double)shape.Pixels.size() / ns);
+        }
+        std::printf("\n");
+    }
+}
+
+BENCHMARK(CursorShapeCache_LookupCost)
+{
+    const int Iterations = 20000;
+
+    for (uint32_t size : { 32u, 64u, 256u })
+    {
+        // 缓存装满，查找的形状在最后一个槽位，命中前与其他条目比较哈希
+        std::vector<Shape> shapes;
+        for (uint32_t i = 0; i < CursorShapeSlotCount; i++)
+        {
+            shapes.push_back(MakeShape(size, 100 + i));
+        }
+
+        CursorShapeCache cache;
+        CursorShapeLookup result;
+        for (const Shape& shape : shapes)
+        {
+            cache.Lookup(shape.Info, shape.Pixels.data(), result);
+        }
+
+        auto start = Clock::now();
+        for (int i = 0; i < Iterations; i++)
+        {
+            cache.Lookup(shapes.back().Info, shapes.back().Pixels.data(), result);
+        }
+        const double hitNs = MicrosecondsBetween(start, Clock::now()) * 1000 / Iterations;
+
+        // 两个形状轮流进出容量为1的缓存，每次都未命中
+        CursorShapeCache single(1);
+        start = Clock::now();
+        for (int i = 0; i < Iterations; i++)
+        {
+            const Shape& shape = shapes[i & 1];
+            single.Lookup(shape.Info, shape.Pixels.data(), result);
+        }
+        const double missNs = MicrosecondsBetween(start, Clock::now()) * 1000 / Iterations;
+        DoNotOptimize(result);
+
+        std::printf("  %3ux%-3u 命中 %7.0fns  未命中 %7.0fns\n", size, size, hitNs, missNs);
+    }
+}
+
+BENCHMARK(CursorShapeCache_ShapeFlipTraces)
+{
+    struct Trace
+    {
+        const char* Name;
+        uint32_t ShapeCount;        // 轮换的不同光标数
+        uint32_t FlipsPerSecond;
+        uint32_t Size;
+    };
+
+    // 编辑器：箭头/I形/手形；绘图工具：画笔、橡皮、吸管、十字等；60秒
+    const Trace traces[] = {
+        { "editor", 3, 8, 32 },
+        { "editor-hidpi", 3, 8, 64 },
+        { "drawing", 6, 15, 64 },
+        { "drawing-hidpi", 6, 15, 128 },
+        { "many-shapes", 24, 10, 48 },
+    };
+    const uint32_t Seconds = 60;
+
+    for (const Trace& trace : traces)
+    {
+        std::vector<Shape> shapes;
+        for (uint32_t i = 0; i < trace.ShapeCount; i++)
+        {
+            shapes.push_back(MakeShape(trace.Size, 200 + i));
+        }
+
+        CursorShapeCache cache;
+        CursorShapeLookup result;
+        std::mt19937 rng(7);
+        uint64_t rawBytes = 0;
+        uint32_t previous = 0;
+        const uint32_t flips = trace.FlipsPerSecond * Seconds;
+
+        for (uint32_t i = 0; i < flips; i++)
+        {
+            // 大部分切换发生在最常用的几个光标之间
+            uint32_t next = (rng() % 4 != 0) ? rng() % (trace.ShapeCount < 3 ? trace.ShapeCount : 3) : rng() % trace.ShapeCount;
+            if (next == previous && i != 0)
+            {
+                next = (next + 1) % trace.ShapeCount;
+            }
+            previous = next;
+
+            rawBytes += shapes[next].Pixels.size();
+            cache.Lookup(shapes[next].Info, shapes[next].Pixels.data(), result);
+        }
+
+        // 命中时只发布缓存ID与热点（随事件发布，事件本身两种方式都要发）
+        const CursorShapeCacheStats& stats = cache.Stats();
+        std::printf("  %-14s %2u个%3upx光标 %2u次/秒  无缓存 %8.1fKB/秒  有缓存 %7.2fKB/秒  命中率 %5.1f%%  淘汰 %llu\n",
+            trace.Name, trace.ShapeCount, trace.Size, trace.FlipsPerSecond,
+            (double)rawBytes / Seconds / 1024, (double)stats.UploadedBytes / Seconds / 1024,
+            100.0 * (double)stats.Hits / (double)stats.Lookups, (unsigned long long)stats.Evictions);
+    }
+}
@@ -0,0 +1,79 @@
+/*++
+
+Module Name:
+    DirtyRegionBench.cpp
+
+Abstract:
+    脏矩形合并基准：每帧耗时、输出矩形数与面积放大倍数（相对输入面积，并与单一包围矩形对比）
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "DirtyRectTraces.h"
+#include "DirtyRegion.h"
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+void RunTrace(const DirtyRectTraces::Trace& trace, const RegionCostModel& model)
+{
+    DirtyRegionCoalescer coalescer(model);
+    FrameRect output[64];
+
+    double inputRects = 0, outputRects = 0, inputArea = 0, outputArea = 0, boundsArea = 0;
+    std::vector<double> frameUs;
+    frameUs.reserve(trace.Frames.size());
+
+    for (const DirtyRectTraces::Frame& frame : trace.Frames)
+    {
+        auto start = Clock::now();
+        uint32_t count = coalescer.Coalesce(
+            frame.data(), (uint32_t)frame.size(), trace.Width, trace.Height, output, 64);
+        frameUs.push_back(MicrosecondsBetween(start, Clock::now()));
+
+        FrameRect bounds = { 0, 0, 0, 0 };
+        for (const FrameRect& r : frame)
+        {
+            bounds = UnionRect(bounds, r);
+        }
+
+        inputRects += frame.size();
+        outputRects += count;
+        inputArea += (double)coalescer.LastStats().InputArea;
+        outputArea += (double)coalescer.LastStats().OutputArea;
+        boundsArea += (double)bounds.Area();
+    }
+
+    double frames = (double)trace.Frames.size();
+    std::printf("  %-12s tile=%-2d rects %5.1f -> %4.1f  area out/in %.2f (bbox %.2f)  p50=%.1fus p99=%.1fus\n",
+        trace.Name, model.TileSize, inputRects / frames, outputRects / frames,
+        outputArea / inputArea, boundsArea / inputArea,
+        Percentile(frameUs, 50), Percentile(frameUs, 99));
+}
+
+} // namespace
+
+BENCHMARK(DirtyRegion_Traces)
+{
+    const int32_t width = 3840, height = 2160;
+    std::vector<DirtyRectTraces::Trace> traces =
+    {
+        DirtyRectTraces::Typing(width, height, 2000),
+        DirtyRectTraces::WebScroll(width, height, 2000),
+        DirtyRectTraces::WindowDrag(width, height, 2000),
+        DirtyRectTraces::Scattered(width, height, 2000)
+    };
+
+    for (int32_t tileSize : { 16, 64 })
+    {
+        RegionCostModel model;
+        model.TileSize = tileSize;
+        model.PerRectCost = (int64_t)tileSize * tileSize * 8;
+        for (const DirtyRectTraces::Trace& trace : traces)
+        {
+            RunTrace(trace, model);
+        }
+    }
+}
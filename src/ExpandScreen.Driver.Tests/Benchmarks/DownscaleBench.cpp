@@ -0,0 +1,358 @@
+/*++
+
+Module Name:
+    DownscaleBench.cpp
+
+Abstract:
+    缩小基准：
+        1. g_SupportedModes中每个分辨率缩小到常用串流分辨率（2:1、4:1盒式与任意
+           比例双线性/Lanczos-2），BGRA与NV12，各SIMD级别的每帧耗时
+        2. 画质：合成桌面图像（文字、渐变、照片区域）缩小后与双精度同滤波器结果的
+           PSNR（定点误差），以及缩小再放大回原尺寸与原图的PSNR（细节保留）
+        3. 常驻目标只按损伤区域更新（打字、滚动条带）与整帧缩小的耗时对比
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "Downscale.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+struct ScaleTarget
+{
+    const char* Name;
+    int32_t Width, Height;
+    ScaleFilter Filter;
+};
+
+std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed)
+{
+    std::vector<uint8_t> bytes(size);
+    std::mt19937 rng(seed);
+    for (uint8_t& b : bytes)
+    {
+        b = (uint8_t)rng();
+    }
+    return bytes;
+}
+
+//
+// 合成桌面：上部为浅色背景上的文字笔画，左下为渐变，右下为平滑的“照片”
+//
+std::vector<uint8_t> MakeDesktop(int32_t width, int32_t height)
+{
+    std::vector<uint8_t> bgra((size_t)width * height * 4);
+    std::mt19937 rng(3);
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < width; x++)
+        {
+            uint8_t* p = &bgra[((size_t)y * width + x) * 4];
+            int value;
+            if (y < height / 2)
+            {
+                // 12像素行高的“文字”：每个字形格内随机的1像素横竖笔画
+                const int cellX = x / 8, cellY = y / 12, inX = x % 8, inY = y % 12;
+                const uint32_t glyph = (uint32_t)(cellX * 2654435761u) ^ (uint32_t)(cellY * 40503u);
+                const bool stroke = inY >= 2 && inY < 10 && inX < 6 &&
+                    (((glyph >> inX) & 1) != 0 ? inY == 2 + (int)(glyph >> 8) % 8 : inX == (int)(glyph >> 12) % 6);
+                value = stroke ? 30 : 240;
+                p[0] = p[1] = p[2] = (uint8_t)value;
+            }
+            else if (x < width / 2)
+            {
+                p[0] = (uint8_t)(x * 255 / (width / 2));
+                p[1] = (uint8_t)((y - height / 2) * 255 / (height - height / 2));
+                p[2] = 128;
+            }
+            else
+            {
+                const double fx = x * 0.013, fy = y * 0.021;
+                p[0] = (uint8_t)(128 + 90 * std::sin(fx + std::cos(fy * 1.7)) + (int)(rng() % 9) - 4);
+                p[1] = (uint8_t)(128 + 80 * std::cos(fy + std::sin(fx * 1.3)) + (int)(rng() % 9) - 4);
+                p[2] = (uint8_t)(128 + 70 * std::sin(fx * 0.7 + fy));
+            }
+            p[3] = 255;
+        }
+    }
+    return bgra;
+}
+
+double Psnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+    double squared = 0.0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        const double d = (double)a[i] - b[i];
+        squared += d * d;
+    }
+    const double mse = squared / a.size();
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+//
+// 双精度可分离重采样（与定点实现相同的窗口与滤波器，不做中间舍入）
+//
+std::vector<uint8_t> ScaleReference(
+    const std::vector<uint8_t>& bgra, int32_t width, int32_t height,
+    int32_t targetWidth, int32_t targetHeight, ScaleFilter filter)
+{
+    struct Tap { int32_t Index; double Weight; };
+    auto weights = [filter](int32_t source, int32_t target)
+    {
+        std::vector<std::vector<Tap>> table(target);
+        const double scale = (double)source / target;
+        const double filterScale = std::max(scale, 1.0);
+        const double support = ScaleDetail::FilterSupport(filter) * filterScale;
+        for (int32_t i = 0; i < target; i++)
+        {
+            const double center = (i + 0.5) * scale;
+            const int32_t begin = std::max((int32_t)(center - support + 0.5), 0);
+            const int32_t end = std::min((int32_t)(center + support + 0.5), source);
+            double total = 0.0;
+            for (int32_t x = begin; x < end; x++)
+            {
+                const double w = ScaleDetail::FilterWeight(filter, (x - center + 0.5) / filterScale);
+                table[i].push_back({ x, w });
+                total += w;
+            }
+            for (Tap& tap : table[i])
+            {
+                tap.Weight /= total;
+            }
+        }
+        return table;
+    };
+
+    const auto horizontal = weights(width, targetWidth);
+    const auto vertical = weights(height, targetHeight);
+    std::vector<uint8_t> out((size_t)targetWidth * targetHeight * 4);
+    std::vector<double> row((size_t)width * 4);
+    for (int32_t y = 0; y < targetHeight; y++)
+    {
+        std::fill(row.begin(), row.end(), 0.0);
+        for (const Tap& v : vertical[y])
+        {
+            for (size_t b = 0; b < row.size(); b++)
+            {
+                row[b] += v.Weight * bgra[(size_t)v.Index * width * 4 + b];
+            }
+        }
+        for (int32_t x = 0; x < targetWidth; x++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                double sum = 0.0;
+                for (const Tap& h : horizontal[x])
+                {
+                    sum += h.Weight * row[(size_t)h.Index * 4 + c];
+                }
+                out[((size_t)y * targetWidth + x) * 4 + c] = (uint8_t)std::min(std::max(std::lround(sum), 0L), 255L);
+            }
+        }
+    }
+    return out;
+}
+
+// 双线性放大回原尺寸（像素中心对齐），用于衡量缩小后保留的细节
+std::vector<uint8_t> UpscaleBilinear(const std::vector<uint8_t>& bgra, int32_t width, int32_t height, int32_t targetWidth, int32_t targetHeight)
+{
+    std::vector<uint8_t> out((size_t)targetWidth * targetHeight * 4);
+    for (int32_t y = 0; y < targetHeight; y++)
+    {
+        const double sy = std::min(std::max((y + 0.5) * height / targetHeight - 0.5, 0.0), height - 1.0);
+        const int32_t y0 = (int32_t)sy, y1 = std::min(y0 + 1, height - 1);
+        const double fy = sy - y0;
+        for (int32_t x = 0; x < targetWidth; x++)
+        {
+            const double sx = std::min(std::max((x + 0.5) * width / targetWidth - 0.5, 0.0), width - 1.0);
+            const int32_t x0 = (int32_t)sx, x1 = std::min(x0 + 1, width - 1);
+            const double fx = sx - x0;
+            for (int c = 0; c < 4; c++)
+            {
+                auto at = [&](int32_t px, int32_t py) { return (double)bgra[((size_t)py * width + px) * 4 + c]; };
+                const double top = at(x0, y0) * (1 - fx) + at(x1, y0) * fx;
+                const double bottom = at(x0, y1) * (1 - fx) + at(x1, y1) * fx;
+                out[((size_t)y * targetWidth + x) * 4 + c] = (uint8_t)std::lround(top * (1 - fy) + bottom * fy);
+            }
+        }
+    }
+    return out;
+}
+
+double MeasureMs(int iterations, const std::function<void()>& body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = Clock::now();
+        body();
+        samples.push_back(MicrosecondsBetween(start, Clock::now()) / 1000.0);
+    }
+    return Percentile(samples, 50);
+}
+
+} // namespace
+
+BENCHMARK(Downscale_ModesThroughput)
+{
+    const CpuLevel levels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2 };
+
+    // 刷新率不影响缩小开销，按分辨率去重
+    for (const DisplayMode& mode : DriverResolutions())
+    {
+        // 2:1、4:1盒式；2/3比例的双线性与Lanczos-2（任意比例）
+        const int32_t width23 = (mode.Width * 2 / 3) & ~1;
+        const int32_t height23 = (mode.Height * 2 / 3) & ~1;
+        const ScaleTarget targets[] =
+        {
+            { "box 2:1", mode.Width / 2, mode.Height / 2, ScaleFilter::Box },
+            { "box 4:1", mode.Width / 4, mode.Height / 4, ScaleFilter::Box },
+            { "bilinear", width23, height23, ScaleFilter::Bilinear },
+            { "lanczos2", width23, height23, ScaleFilter::Lanczos2 },
+        };
+
+        for (PixelFormat format : { PixelFormat::Bgra8, PixelFormat::Nv12 })
+        {
+            const bool bgra = format == PixelFormat::Bgra8;
+            const size_t pitch = (size_t)mode.Width * (bgra ? 4 : 1);
+            std::vector<uint8_t> source = RandomBytes(pitch * mode.Height * (bgra ? 2 : 3) / 2, 1);
+            Nv12Surface sourceSurface = { source.data(), pitch, source.data() + pitch * mode.Height, pitch };
+
+            for (const ScaleTarget& target : targets)
+            {
+                if (((target.Width | target.Height) & 1) != 0 && !bgra)
+                {
+                    continue;
+                }
+
+                const size_t targetPitch = (size_t)target.Width * (bgra ? 4 : 1);
+                std::vector<uint8_t> out(targetPitch * target.Height * (bgra ? 2 : 3) / 2);
+                Nv12Surface targetSurface = { out.data(), targetPitch, out.data() + targetPitch * target.Height, targetPitch };
+
+                std::printf("  %4dx%-4d %-4s -> %4dx%-4d %-8s", mode.Width, mode.Height, bgra ? "BGRA" : "NV12",
+                    target.Width, target.Height, target.Name);
+                double scalarMs = 0;
+                for (CpuLevel level : levels)
+                {
+                    if (ClampCpuLevel(level) != level)
+                    {
+                        continue;
+                    }
+
+                    Downscaler scaler;
+                    scaler.Configure(format, mode.Width, mode.Height, target.Width, target.Height, target.Filter, level);
+                    const double ms = MeasureMs(mode.Width >= 3840 ? 15 : 30, [&]()
+                    {
+                        if (bgra)
+                        {
+                            scaler.ScaleBgraFrame(source.data(), pitch, out.data(), targetPitch);
+                        }
+                        else
+                        {
+                            scaler.ScaleNv12Frame(sourceSurface, targetSurface);
+                        }
+                    });
+                    DoNotOptimize(out[0]);
+                    if (level == CpuLevel::Scalar)
+                    {
+                        scalarMs = ms;
+                    }
+                    std::printf("  %s %6.3fms(x%4.1f)", CpuLevelName(level), ms, scalarMs / ms);
+                }
+                std::printf("\n");
+            }
+        }
+    }
+}
+
+BENCHMARK(Downscale_QualityPsnr)
+{
+    const struct { int32_t Width, Height, TargetWidth, TargetHeight; } cases[] =
+    {
+        { 2560, 1600, 1280, 800 },
+        { 2560, 1600, 960, 600 },
+        { 3840, 2160, 1280, 720 },
+        { 1920, 1080, 1280, 720 },
+    };
+
+    for (const auto& c : cases)
+    {
+        const std::vector<uint8_t> desktop = MakeDesktop(c.Width, c.Height);
+
+        // 逐点抽取作为对照：带宽受限时最省事但混叠最严重的做法
+        std::vector<uint8_t> nearest((size_t)c.TargetWidth * c.TargetHeight * 4);
+        for (int32_t y = 0; y < c.TargetHeight; y++)
+        {
+            for (int32_t x = 0; x < c.TargetWidth; x++)
+            {
+                const size_t sx = (size_t)((x + 0.5) * c.Width / c.TargetWidth);
+                const size_t sy = (size_t)((y + 0.5) * c.Height / c.TargetHeight);
+                std::memcpy(&nearest[((size_t)y * c.TargetWidth + x) * 4], &desktop[(sy * c.Width + sx) * 4], 4);
+            }
+        }
+        std::printf("  %4dx%-4d -> %4dx%-4d  nearest  往返 %5.2fdB\n", c.Width, c.Height, c.TargetWidth, c.TargetHeight,
+            Psnr(desktop, UpscaleBilinear(nearest, c.TargetWidth, c.TargetHeight, c.Width, c.Height)));
+
+        for (ScaleFilter filter : { ScaleFilter::Box, ScaleFilter::Bilinear, ScaleFilter::Lanczos2 })
+        {
+            Downscaler scaler;
+            scaler.Configure(PixelFormat::Bgra8, c.Width, c.Height, c.TargetWidth, c.TargetHeight, filter);
+            std::vector<uint8_t> scaled((size_t)c.TargetWidth * c.TargetHeight * 4);
+            scaler.ScaleBgraFrame(desktop.data(), (size_t)c.Width * 4, scaled.data(), (size_t)c.TargetWidth * 4);
+
+            const std::vector<uint8_t> reference = ScaleReference(desktop, c.Width, c.Height, c.TargetWidth, c.TargetHeight, filter);
+            const std::vector<uint8_t> back = UpscaleBilinear(scaled, c.TargetWidth, c.TargetHeight, c.Width, c.Height);
+            std::printf("  %4dx%-4d -> %4dx%-4d  %-8s 往返 %5.2fdB  相对双精度 %5.2fdB\n",
+                c.Width, c.Height, c.TargetWidth, c.TargetHeight, ScaleFilterName(filter),
+                Psnr(desktop, back), Psnr(reference, scaled));
+        }
+    }
+}
+
+BENCHMARK(Downscale_DamagedRegionUpdate)
+{
+    const int32_t width = 2560, height = 1600;
+    const size_t pitch = (size_t)width;
+    std::vector<uint8_t> source = RandomBytes(pitch * height * 3 / 2, 2);
+    Nv12Surface sourceSurface = { source.data(), pitch, source.data() + pitch * height, pitch };
+
+    const struct { const char* Name; FrameRect Rect; } damages[] =
+    {
+        { "打字 16x20", { 700, 400, 716, 420 } },
+        { "光标行 900x24", { 300, 800, 1200, 824 } },
+        { "滚动条带 2560x120", { 0, 1400, 2560, 1520 } },
+        { "整帧", { 0, 0, width, height } },
+    };
+
+    for (ScaleFilter filter : { ScaleFilter::Box, ScaleFilter::Lanczos2 })
+    {
+        Downscaler scaler;
+        const int32_t targetWidth = filter == ScaleFilter::Box ? 1280 : 1152;
+        const int32_t targetHeight = filter == ScaleFilter::Box ? 800 : 720;
+        scaler.Configure(PixelFormat::Nv12, width, height, targetWidth, targetHeight, filter);
+        std::vector<uint8_t> target((size_t)targetWidth * targetHeight * 3 / 2);
+        Nv12Surface targetSurface = { target.data(), (size_t)targetWidth,
+            target.data() + (size_t)targetWidth * targetHeight, (size_t)targetWidth };
+        scaler.ScaleNv12Frame(sourceSurface, targetSurface);
+
+        for (const auto& damage : damages)
+        {
+            const FrameRect mapped = scaler.MapRect(damage.Rect);
+            const double ms = MeasureMs(50, [&]() { scaler.ScaleNv12(sourceSurface, targetSurface, damage.Rect); });
+            DoNotOptimize(target[0]);
+            std::printf("  NV12 %dx%d -> %dx%d %-8s %-18s 目标区域 %4dx%-4d %8.1fus\n",
+                width, height, targetWidth, targetHeight, ScaleFilterName(filter), damage.Name,
+                mapped.Width(), mapped.Height(), ms * 1000.0);
+        }
+    }
+}
@@ -0,0 +1,166 @@
+/*++
+
+Module Name:
+    FrameDiffBench.cpp
+
+Abstract:
+    逐像素帧比较基准（4K BGRA）：
+        1. 各SIMD行比较内核比较整帧（无变化，最坏情况）的吞吐，与块哈希对照
+        2. 典型损伤负载下与块哈希过滤对比剩余脏面积和每帧耗时
+           光标原样重绘、整窗无效化（只有进度条变化）、整窗无效化（一行文字变化）、
+           打字、视频
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "DirtyRectTraces.h"
+#include "FrameDiff.h"
+#include "TileHash.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 3840;
+const int32_t Height = 2160;
+const size_t Pitch = (size_t)Width * 4;
+
+struct Result
+{
+    double RemainingPercent;
+    double P50;
+    double P99;
+};
+
+template <typename Filter>
+Result RunWorkload(const DirtyRectTraces::DamageTrace& workload, Filter filter)
+{
+    std::vector<uint8_t> frame(Pitch * Height, 0x20);
+    std::vector<FrameRect> output;
+    std::mt19937 rng(1);
+    double inputArea = 0, outputArea = 0;
+    std::vector<double> frameUs;
+
+    for (size_t i = 0; i < workload.Dirty.size(); i++)
+    {
+        for (const FrameRect& rect : workload.Changed[i])
+        {
+            DirtyRectTraces::FillRandom(frame, Pitch, rect, rng);
+        }
+
+        auto start = Clock::now();
+        filter(frame, workload.Dirty[i], output);
+        double us = MicrosecondsBetween(start, Clock::now());
+
+        // 首帧没有参考内容，不计入统计
+        if (i == 0)
+        {
+            continue;
+        }
+
+        frameUs.push_back(us);
+        for (const FrameRect& rect : workload.Dirty[i])
+        {
+            inputArea += (double)IntersectRect(rect, { 0, 0, Width, Height }).Area();
+        }
+        for (const FrameRect& rect : output)
+        {
+            outputArea += (double)rect.Area();
+        }
+    }
+
+    return { 100.0 * outputArea / inputArea, Percentile(frameUs, 50), Percentile(frameUs, 99) };
+}
+
+} // namespace
+
+BENCHMARK(FrameDiff_Throughput)
+{
+    // 两帧内容相同，每行都要完整比较
+    std::vector<uint8_t> current(Pitch * Height), reference;
+    std::mt19937 rng(7);
+    for (uint8_t& b : current)
+    {
+        b = (uint8_t)rng();
+    }
+    reference = current;
+
+    for (CpuLevel level : { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 })
+    {
+        if (ClampCpuLevel(level) != level)
+        {
+            std::printf("  %-8s 本机不支持\n", CpuLevelName(level));
+            continue;
+        }
+
+        RowDifferenceFunction first = SelectFirstDifference(level);
+        const int iterations = 20;
+        int64_t sink = 0;
+
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            for (int32_t y = 0; y < Height; y++)
+            {
+                sink += first(current.data() + (size_t)y * Pitch, reference.data() + (size_t)y * Pitch, Width);
+            }
+        }
+        double diffSeconds = SecondsSince(start);
+        DoNotOptimize(sink);
+
+        TileHashFunction hash = SelectTileHash(level);
+        uint64_t hashSink = 0;
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            for (int32_t y = 0; y < Height; y += 64)
+            {
+                uint32_t rows = (uint32_t)(Height - y < 64 ? Height - y : 64);
+                for (int32_t x = 0; x < Width; x += 64)
+                {
+                    hashSink += hash(current.data() + (size_t)y * Pitch + (size_t)x * 4, Pitch, 256, rows);
+                }
+            }
+        }
+        double hashSeconds = SecondsSince(start);
+        DoNotOptimize(hashSink);
+
+        std::printf("  %-8s 比较 %6.2f GB/s (%.2fms/4K帧)  块哈希 %6.2f GB/s (%.2fms/4K帧)\n", CpuLevelName(level),
+            (double)current.size() * iterations / diffSeconds / 1e9, diffSeconds * 1000.0 / iterations,
+            (double)current.size() * iterations / hashSeconds / 1e9, hashSeconds * 1000.0 / iterations);
+    }
+}
+
+BENCHMARK(FrameDiff_VersusTileHash)
+{
+    std::printf("  内核: %s，剩余为输出面积占上报脏面积的比例（越小越好）\n", CpuLevelName(DetectCpuLevel()));
+    std::printf("  %-16s %28s   %28s\n", "", "块哈希(64x64)", "逐像素比较");
+
+    using namespace DirtyRectTraces;
+    for (const DamageTrace& workload : { CaretRedraw(600), WindowProgress(600), WindowTextLine(600),
+        TypingRedraw(600), VideoPlayback(300) })
+    {
+        TileHasher hasher;
+        Result hashed = RunWorkload(workload,
+            [&](const std::vector<uint8_t>& frame, const std::vector<FrameRect>& dirty, std::vector<FrameRect>& output)
+            {
+                hasher.Filter(frame.data(), Pitch, Width, Height, dirty.data(), (uint32_t)dirty.size(), output);
+            });
+
+        FrameDiffer differ;
+        Result diffed = RunWorkload(workload,
+            [&](const std::vector<uint8_t>& frame, const std::vector<FrameRect>& dirty, std::vector<FrameRect>& output)
+            {
+                differ.Diff(frame.data(), Pitch, Width, Height, dirty.data(), (uint32_t)dirty.size(),
+                    nullptr, 0, output);
+            });
+
+        std::printf("  %-16s 剩余 %6.2f%% p50=%5.0fus p99=%5.0fus   剩余 %6.2f%% p50=%5.0fus p99=%5.0fus\n",
+            workload.Name, hashed.RemainingPercent, hashed.P50, hashed.P99,
+            diffed.RemainingPercent, diffed.P50, diffed.P99);
+    }
+}
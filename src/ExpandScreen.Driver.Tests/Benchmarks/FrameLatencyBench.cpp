@@ -0,0 +1,135 @@
+/*++
+
+Module Name:
+    FrameLatencyBench.cpp
+
+Abstract:
+    逐帧延迟打点基准：
+        1. 每帧打点并计入统计块的开销（驱动侧3个时间戳、用户态完整7个）
+        2. 读者复制统计快照与计算分位数的开销
+        3. 模拟流水线（60Hz提交、定速等待、编码耗时抖动）的分位数报告示例
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "SharedMemory.h"
+#include "FrameLatency.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+const int64_t TicksPerUs = TicksPerSecond / 1000000;
+
+} // namespace
+
+BENCHMARK(FrameLatency_RecordAndSnapshotCost)
+{
+    SharedMemoryRegion region(sizeof(LatencyStatsBlock));
+    LatencyStatsWriter::Format(region.Writable(), region.Size(), TicksPerSecond);
+    LatencyStatsWriter writer;
+    writer.Attach(region.Writable(), region.Size());
+    FrameLatencyTracker tracker(&writer);
+
+    const int Frames = 1000000;
+    std::mt19937 rng(1);
+
+    // 驱动侧：三个时间戳直接计入
+    auto start = Clock::now();
+    for (int i = 1; i <= Frames; i++)
+    {
+        FrameTimestamps timestamps = {};
+        timestamps.FrameNumber = (uint64_t)i;
+        timestamps.Stamp(LatencyStage::Present, (int64_t)i * 166666);
+        timestamps.Stamp(LatencyStage::Acquire, (int64_t)i * 166666 + 2000 + (rng() & 1023));
+        timestamps.Stamp(LatencyStage::Publish, (int64_t)i * 166666 + 40000 + (rng() & 8191));
+        writer.Record(timestamps);
+    }
+    const double driverNs = MicrosecondsBetween(start, Clock::now()) * 1000 / Frames;
+
+    // 用户态：开始记录、就地打点、完成
+    writer.Reset();
+    start = Clock::now();
+    for (int i = 1; i <= Frames; i++)
+    {
+        const int64_t present = (int64_t)i * 166666;
+        FrameTimestamps* record = tracker.Begin((uint64_t)i, present, present + 2000, present + 40000, present + 42000);
+        record->Stamp(LatencyStage::EncodeStart, present + 43000 + (rng() & 1023));
+        record->Stamp(LatencyStage::EncodeEnd, present + 90000 + (rng() & 16383));
+        record->Stamp(LatencyStage::Send, present + 95000 + (rng() & 4095));
+        tracker.Complete((uint64_t)i);
+    }
+    const double userNs = MicrosecondsBetween(start, Clock::now()) * 1000 / Frames;
+
+    LatencyStatsReader reader;
+    reader.Attach(region.ReadOnly(), region.Size());
+    LatencyStatsSnapshot snapshot;
+    const int Snapshots = 10000;
+    uint64_t sink = 0;
+    start = Clock::now();
+    for (int i = 0; i < Snapshots; i++)
+    {
+        reader.Snapshot(snapshot);
+        sink += snapshot.Intervals[LatencyTotalInterval].PercentileUs(99);
+    }
+    const double snapshotUs = MicrosecondsBetween(start, Clock::now()) / Snapshots;
+    DoNotOptimize(sink);
+
+    std::printf("  驱动侧记录 %.1fns/帧  用户态追踪 %.1fns/帧  快照+p99 %.2fus（统计块%zu字节）\n",
+        driverNs, userNs, snapshotUs, sizeof(LatencyStatsBlock));
+}
+
+BENCHMARK(FrameLatency_SimulatedPipelineReport)
+{
+    SharedMemoryRegion region(sizeof(LatencyStatsBlock));
+    LatencyStatsWriter::Format(region.Writable(), region.Size(), TicksPerSecond);
+    LatencyStatsWriter writer;
+    writer.Attach(region.Writable(), region.Size());
+    FrameLatencyTracker tracker(&writer);
+
+    // 60Hz提交；获取延迟0.1~1ms；发布等到下一个刷新区间边界；取出0.2ms；
+    // 编码3~8ms，偶尔出现20ms的长帧；发送0.5~2ms
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int64_t> acquireUs(100, 1000);
+    std::uniform_int_distribution<int64_t> encodeUs(3000, 8000);
+    std::uniform_int_distribution<int64_t> sendUs(500, 2000);
+    const int64_t period = TicksPerSecond / 60;
+
+    for (uint64_t frame = 1; frame <= 36000; frame++)
+    {
+        const int64_t present = (int64_t)frame * period + (int64_t)(rng() % (uint32_t)period);
+        const int64_t acquire = present + acquireUs(rng) * TicksPerUs;
+        const int64_t publish = (acquire / period + 1) * period;
+        const int64_t consume = publish + 200 * TicksPerUs;
+
+        FrameTimestamps* record = tracker.Begin(frame, present, acquire, publish, consume);
+        const int64_t encodeStart = consume + 50 * TicksPerUs;
+        const int64_t encodeEnd = encodeStart + (rng() % 200 == 0 ? 20000 : encodeUs(rng)) * TicksPerUs;
+        record->Stamp(LatencyStage::EncodeStart, encodeStart);
+        record->Stamp(LatencyStage::EncodeEnd, encodeEnd);
+        record->Stamp(LatencyStage::Send, encodeEnd + sendUs(rng) * TicksPerUs);
+        tracker.Complete(frame);
+    }
+
+    LatencyStatsReader reader;
+    reader.Attach(region.ReadOnly(), region.Size());
+    LatencyStatsSnapshot snapshot;
+    reader.Snapshot(snapshot);
+
+    std::printf("  %llu帧（10分钟）\n", (unsigned long long)snapshot.Frames);
+    for (uint32_t interval = 1; interval <= LatencyStageCount; interval++)
+    {
+        const uint32_t index = interval % LatencyStageCount;     // 各区间在前，总延迟最后
+        const LatencyHistogram& histogram = snapshot.Intervals[index];
+        std::printf("  %-18s p50=%6lluus p90=%6lluus p99=%6lluus p99.9=%6lluus max=%6lluus\n",
+            LatencyIntervalName(index),
+            (unsigned long long)histogram.PercentileUs(50), (unsigned long long)histogram.PercentileUs(90),
+            (unsigned long long)histogram.PercentileUs(99), (unsigned long long)histogram.PercentileUs(99.9),
+            (unsigned long long)histogram.MaxUs);
+    }
+}
@@ -0,0 +1,119 @@
+/*++
+
+Module Name:
+    FramePacerBench.cpp
+
+Abstract:
+    定速基准（模拟时钟，确定性）：不同提交节奏与唤醒延迟下，60Hz/120Hz定速的
+    每秒发布帧数、合并的提交数、提交到发布的延迟与抖动、区间边界误差
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "SimulatedClock.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+const int64_t Seconds = 10;
+
+struct Workload
+{
+    const char* Name;
+    std::vector<int64_t> Presents;
+};
+
+// 固定间隔提交，每次在±jitterUs内抖动
+Workload Cadence(const char* name, double hz, double jitterUs, uint32_t seed)
+{
+    Workload workload{ name, {} };
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-jitterUs, jitterUs);
+
+    const double interval = (double)TicksPerSecond / hz;
+    int64_t last = 0;
+    for (int64_t i = 0; (double)i * interval < (double)(TicksPerSecond * Seconds); i++)
+    {
+        int64_t time = (int64_t)((double)i * interval + jitter(rng) * TicksPerSecond / 1e6) + TicksPerSecond;
+        if (time < last)
+        {
+            time = last;
+        }
+        workload.Presents.push_back(time);
+        last = time;
+    }
+    return workload;
+}
+
+// 成簇提交：每50ms一簇，簇内按144Hz连续提交8帧（拖动窗口一类的负载）
+Workload Bursts()
+{
+    Workload workload{ "144Hz成簇", {} };
+    const int64_t interval = TicksPerSecond / 144;
+    for (int64_t burst = TicksPerSecond; burst < TicksPerSecond * (Seconds + 1); burst += TicksPerSecond / 20)
+    {
+        for (int64_t i = 0; i < 8; i++)
+        {
+            workload.Presents.push_back(burst + i * interval);
+        }
+    }
+    return workload;
+}
+
+void Run(const Workload& workload, uint32_t refreshHz, const char* latencyName, int64_t maxLatencyUs)
+{
+    SimulatedClock clock(TicksPerSecond);
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, refreshHz, 1);
+
+    WakeLatencyModel latency;
+    latency.Max = clock.FromMicroseconds((double)maxLatencyUs);
+
+    std::vector<PacingEmit> emits = SimulatePacing(pacer, clock, workload.Presents, latency);
+    DoNotOptimize(emits);
+
+    const FramePacerStats& stats = pacer.Stats();
+    const double emits1 = stats.Emits ? (double)stats.Emits : 1.0;
+    const double deferred = stats.Deferred ? (double)stats.Deferred : 1.0;
+    std::printf("  %-12s %3uHz 唤醒%-7s 发布 %6.1f帧/秒  合并 %5llu/%5llu  延迟 均值%7.1fus 最大%7.1fus 抖动%6.1fus  边界误差 均值%6.1fus 最大%6.1fus\n",
+        workload.Name, refreshHz, latencyName,
+        (double)stats.Emits / (double)Seconds,
+        (unsigned long long)stats.Coalesced, (unsigned long long)stats.Presents,
+        clock.ToMicroseconds(stats.LatencyTotal) / emits1,
+        clock.ToMicroseconds(stats.LatencyMax),
+        clock.ToMicroseconds(stats.Jitter),
+        clock.ToMicroseconds(stats.BoundaryErrorTotal) / deferred,
+        clock.ToMicroseconds(stats.BoundaryErrorMax));
+}
+
+} // namespace
+
+BENCHMARK(FramePacer_Simulated)
+{
+    const Workload workloads[] = {
+        Cadence("DWM 60fps", 60.0, 1000.0, 1),
+        Cadence("游戏 240fps", 240.0, 300.0, 2),
+        Cadence("视频 24fps", 24.0, 200.0, 3),
+        Bursts(),
+    };
+    const struct { const char* Name; int64_t MaxUs; } latencies[] = {
+        { "0", 0 }, { "<=500us", 500 }, { "<=2ms", 2000 },
+    };
+
+    for (uint32_t refreshHz : { 60u, 120u })
+    {
+        for (const Workload& workload : workloads)
+        {
+            for (const auto& latency : latencies)
+            {
+                Run(workload, refreshHz, latency.Name, latency.MaxUs);
+            }
+        }
+    }
+}
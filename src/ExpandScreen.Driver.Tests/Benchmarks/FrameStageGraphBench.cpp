@@ -0,0 +1,249 @@
+/*++
+
+Module Name:
+    FrameStageGraphBench.cpp
+
+Abstract:
+    流水线阶段图基准：与驱动相同的分工，获取线程把表面拷出到作业的暂存缓冲区
+    （代替CopyResource+Map），比较级用FrameDiffer找出实际变化的区域，发布级做
+    增量NV12转换、写入帧环槽位并EndWrite。同一负载分别串行（各级在获取线程上
+    依次执行，即原来的做法）与流水线运行，输出帧率、每帧延迟与各级占用率。
+
+    负载为大面积持续变化的画面（视频播放/快速滚动），这是串行路径的帧率上限
+    低于刷新率的情形；各级都只处理变化区域，空闲桌面两种方式没有差别。
+    流水线帧率的上限是最慢一级的吞吐（占用率接近100%的那一级），串行则是
+    各级耗时之和。
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "SharedMemory.h"
+#include "FrameDiff.h"
+#include "FrameRing.h"
+#include "FrameStageGraph.h"
+#include "IncrementalConvert.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const uint32_t JobCount = 4;
+const uint32_t SlotCount = 3;
+const uint32_t SourceCount = 6;
+const int FrameCount = 240;
+
+struct StagedPipeline
+{
+    FrameStageGraph* Graph = nullptr;
+    int32_t Width = 0;
+    int32_t Height = 0;
+    size_t Pitch = 0;
+
+    // 每个作业：暂存画面、提交时间、比较出的变化区域
+    std::vector<uint8_t> Staging[JobCount];
+    Clock::time_point Submitted[JobCount];
+    uint64_t FrameNumber[JobCount] = {};
+    std::vector<FrameRect> Changed[JobCount];
+
+    // 比较级
+    FrameDiffer Differ;
+
+    // 发布级
+    IncrementalNv12Converter Converter;
+    FrameRingProducer Producer;
+    uint64_t SlotFrames[SlotCount] = {};
+    std::vector<double> LatencyMs;
+    uint64_t Published = 0;
+    uint64_t Unchanged = 0;
+
+    static bool Diff(void* context, uint32_t job)
+    {
+        StagedPipeline* self = static_cast<StagedPipeline*>(context);
+        const FrameRect full = { 0, 0, self->Width, self->Height };
+        self->Differ.Diff(self->Staging[job].data(), self->Pitch, self->Width, self->Height,
+            &full, 1, nullptr, 0, self->Changed[job]);
+        if (self->Changed[job].empty())
+        {
+            self->Unchanged++;
+            self->Graph->Complete(job);
+            return false;
+        }
+        return true;
+    }
+
+    static bool Publish(void* context, uint32_t job)
+    {
+        StagedPipeline* self = static_cast<StagedPipeline*>(context);
+        const std::vector<FrameRect>& changed = self->Changed[job];
+        const uint64_t frameNumber = self->FrameNumber[job];
+
+        self->Converter.Update(self->Staging[job].data(), self->Pitch, self->Width, self->Height,
+            changed.data(), (uint32_t)changed.size(), nullptr, 0, frameNumber);
+
+        FrameWriteSlot slot = self->Producer.BeginWrite();
+        const uint32_t index = (uint32_t)(slot.FrameNumber % SlotCount);
+        uint8_t* pixels = slot.Pixels;
+        const size_t width = (size_t)self->Width;
+        self->Converter.CopyTo(Nv12Surface{ pixels, width, pixels + width * (size_t)self->Height, width },
+            self->SlotFrames[index]);
+        self->SlotFrames[index] = frameNumber;
+
+        const FrameDescriptor descriptor = { (uint32_t)self->Width, (uint32_t)self->Height, (uint32_t)self->Width,
+            PixelFormat::Nv12, 0, 0, YuvMatrix::Bt709, YuvRange::Limited, 0, 0, frameNumber };
+        self->Producer.EndWrite(slot, descriptor, changed.data(), (uint32_t)changed.size());
+
+        self->LatencyMs.push_back(MicrosecondsBetween(self->Submitted[job], Clock::now()) / 1000.0);
+        self->Published++;
+        self->Graph->Complete(job);
+        return true;
+    }
+};
+
+//
+// 桌面背景上一块占画面约六成的“视频”，每帧内容不同
+//
+std::vector<std::vector<uint8_t>> MakeSources(int32_t width, int32_t height)
+{
+    const size_t pitch = (size_t)width * 4;
+    std::vector<std::vector<uint8_t>> sources;
+    for (uint32_t s = 0; s < SourceCount; s++)
+    {
+        std::vector<uint8_t> frame(pitch * height);
+        for (int32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = frame.data() + (size_t)y * pitch;
+            const bool inVideoRows = y >= height / 8 && y < height * 7 / 8;
+            for (int32_t x = 0; x < width; x++)
+            {
+                uint8_t* pixel = row + (size_t)x * 4;
+                if (inVideoRows && x >= width / 8 && x < width * 7 / 8)
+                {
+                    pixel[0] = (uint8_t)(x * 3 + y + s * 41);
+                    pixel[1] = (uint8_t)(x + y * 2 + s * 17);
+                    pixel[2] = (uint8_t)((x ^ y) + s * 73);
+                }
+                else
+                {
+                    pixel[0] = 0xF0;
+                    pixel[1] = 0xEE;
+                    pixel[2] = (uint8_t)(0xE0 + (y & 7));
+                }
+                pixel[3] = 0xFF;
+            }
+        }
+        sources.push_back(std::move(frame));
+    }
+    return sources;
+}
+
+struct RunResult
+{
+    double Fps = 0.0;
+    double LatencyP50 = 0.0;
+    double LatencyP99 = 0.0;
+    double Occupancy[3] = {};
+    double AverageQueue[2] = {};
+    uint64_t JobWaits = 0;
+};
+
+RunResult Run(int32_t width, int32_t height, const std::vector<std::vector<uint8_t>>& sources, bool threaded)
+{
+    RunResult result;
+    const size_t pitch = (size_t)width * 4;
+    const uint64_t planeBytes = (uint64_t)width * height * 3 / 2;
+
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(SlotCount, planeBytes));
+    FrameStageGraph graph;
+    StagedPipeline pipeline;
+    pipeline.Graph = &graph;
+    pipeline.Width = width;
+    pipeline.Height = height;
+    pipeline.Pitch = pitch;
+    if (!region.IsValid() ||
+        !FrameRingProducer::Format(region.Writable(), region.Size(), SlotCount, planeBytes) ||
+        !pipeline.Producer.Attach(region.Writable(), region.Size()))
+    {
+        std::printf("  无法分配共享内存\n");
+        return result;
+    }
+    for (std::vector<uint8_t>& staging : pipeline.Staging)
+    {
+        staging.assign(pitch * height, 0);
+    }
+
+    const FrameStageFunction stages[] = { &StagedPipeline::Diff, &StagedPipeline::Publish };
+    graph.Start(stages, 2, &pipeline, JobCount, threaded);
+
+    // 获取线程：拷出（按最快速度提交，帧率由流水线决定）
+    double copyNs = 0.0;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < FrameCount; i++)
+    {
+        uint32_t job = 0;
+        if (!graph.AcquireJob(job))
+        {
+            break;
+        }
+        const Clock::time_point copyStart = Clock::now();
+        pipeline.Submitted[job] = copyStart;
+        std::memcpy(pipeline.Staging[job].data(), sources[(size_t)i % SourceCount].data(), pitch * height);
+        copyNs += MicrosecondsBetween(copyStart, Clock::now()) * 1000.0;
+        pipeline.FrameNumber[job] = (uint64_t)i + 1;
+        graph.Submit(job);
+    }
+    graph.Stop();
+
+    const double seconds = SecondsSince(start);
+    const FrameStageGraphStats stats = graph.Stats();
+    result.Fps = (double)pipeline.Published / seconds;
+    result.LatencyP50 = Percentile(pipeline.LatencyMs, 50);
+    result.LatencyP99 = Percentile(pipeline.LatencyMs, 99);
+    result.Occupancy[0] = copyNs / (double)stats.ElapsedNs;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        const FrameStageStats stage = graph.StageStats(i);
+        result.Occupancy[i + 1] = (double)stage.BusyNs / (double)stats.ElapsedNs;
+        result.AverageQueue[i] = stage.Jobs == 0 ? 0.0 : (double)stage.QueueDepthTotal / (double)stage.Jobs;
+    }
+    result.JobWaits = stats.JobWaits;
+    DoNotOptimize(pipeline.Published);
+    return result;
+}
+
+void RunMode(int32_t width, int32_t height)
+{
+    const std::vector<std::vector<uint8_t>> sources = MakeSources(width, height);
+
+    // 预热一次（页面错误、转换器缓冲区）
+    Run(width, height, sources, false);
+
+    const RunResult serial = Run(width, height, sources, false);
+    const RunResult pipelined = Run(width, height, sources, true);
+
+    const RunResult* results[] = { &serial, &pipelined };
+    const char* names[] = { "串行", "流水线" };
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        const RunResult& r = *results[i];
+        std::printf("  %dx%d %-8s %7.1f fps  延迟 p50=%6.2fms p99=%6.2fms  占用 拷出=%3.0f%% 比较=%3.0f%% 发布=%3.0f%%  队列 %.2f/%.2f  等待槽位 %llu\n",
+            width, height, names[i], r.Fps, r.LatencyP50, r.LatencyP99,
+            r.Occupancy[0] * 100.0, r.Occupancy[1] * 100.0, r.Occupancy[2] * 100.0,
+            r.AverageQueue[0], r.AverageQueue[1], (unsigned long long)r.JobWaits);
+    }
+    std::printf("  %dx%d 流水线/串行 x%.2f\n", width, height, pipelined.Fps / serial.Fps);
+}
+
+} // namespace
+
+BENCHMARK(FrameStageGraph_SerialVsPipelined)
+{
+    // 流水线需要每一级各有一个核，核数不足时各级线程轮流运行，不会快于串行
+    std::printf("  硬件线程: %u\n", std::thread::hardware_concurrency());
+    RunMode(1920, 1080);
+    RunMode(2560, 1440);
+}
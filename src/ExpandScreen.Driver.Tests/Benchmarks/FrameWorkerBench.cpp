@@ -0,0 +1,83 @@
+/*++
+
+Module Name:
+    FrameWorkerBench.cpp
+
+Abstract:
+    帧处理线程吞吐（帧/秒）与唤醒延迟基准
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "FakeSwapChain.h"
+
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+struct LatencySink
+{
+    std::vector<double> LatencyUs;
+
+    void OnFrame(const FakeSwapChain::Frame& frame)
+    {
+        LatencyUs.push_back(MicrosecondsBetween(frame.PresentTime, Clock::now()));
+    }
+
+    void OnDrained()
+    {
+    }
+};
+
+void RunWorker(int frameCount, std::chrono::microseconds interval)
+{
+    FakeSwapChain swapChain;
+    LatencySink sink;
+    sink.LatencyUs.reserve(frameCount);
+    FrameWorkerLoop<FakeSwapChain, LatencySink> loop(swapChain, sink);
+
+    std::thread worker([&] { loop.Run(); });
+
+    auto start = Clock::now();
+    for (int i = 0; i < frameCount; i++)
+    {
+        swapChain.Present();
+        if (interval.count() > 0)
+        {
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    while (swapChain.Released() < (uint64_t)frameCount)
+    {
+        std::this_thread::yield();
+    }
+    double seconds = SecondsSince(start);
+
+    swapChain.RequestTerminate();
+    worker.join();
+
+    const FrameWorkerStats& stats = loop.Stats();
+    std::printf("  interval=%lldus frames=%d fps=%.0f wakeups=%llu empty=%llu maxBurst=%llu\n",
+        (long long)interval.count(), frameCount, frameCount / seconds,
+        (unsigned long long)stats.Wakeups, (unsigned long long)stats.EmptyWakeups,
+        (unsigned long long)stats.MaxBurst);
+    std::printf("  present->acquire latency: p50=%.1fus p99=%.1fus max=%.1fus\n",
+        Percentile(sink.LatencyUs, 50), Percentile(sink.LatencyUs, 99), Percentile(sink.LatencyUs, 100));
+}
+
+} // namespace
+
+BENCHMARK(FrameWorker_MaxRate)
+{
+    RunWorker(200000, std::chrono::microseconds(0));
+}
+
+BENCHMARK(FrameWorker_Paced120Hz)
+{
+    RunWorker(240, std::chrono::microseconds(8333));
+}
@@ -0,0 +1,155 @@
+/*++
+
+Module Name:
+    IncrementalConvertBench.cpp
+
+Abstract:
+    增量NV12转换基准：打字、滚动、视频负载下，每帧整帧转换进槽位与
+    常驻NV12图像增量转换再补拷进槽位（3个槽位，与FRAME_RING_SLOT_COUNT一致）
+    的每帧耗时、转换面积与拷贝字节。脏矩形先经DirtyRegionCoalescer合并，与驱动一致
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "DirtyRectTraces.h"
+#include "DirtyRegion.h"
+#include "IncrementalConvert.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const uint32_t SlotCount = 3;
+
+struct Workload
+{
+    const char* Name;
+    int32_t Width;
+    int32_t Height;
+    std::vector<DirtyRectTraces::MoveFrame> Frames;
+};
+
+Workload FromTrace(const DirtyRectTraces::Trace& trace)
+{
+    Workload workload{ trace.Name, trace.Width, trace.Height, {} };
+    for (const DirtyRectTraces::Frame& frame : trace.Frames)
+    {
+        workload.Frames.push_back({ frame, {} });
+    }
+    return workload;
+}
+
+Workload FromTrace(const DirtyRectTraces::MoveTrace& trace)
+{
+    return { trace.Name, trace.Width, trace.Height, trace.Frames };
+}
+
+// 在BGRA帧上重放一帧：先执行移动区域，再用新内容填充脏矩形
+void Replay(std::vector<uint8_t>& bgra, const Workload& workload, const DirtyRectTraces::MoveFrame& frame, int index)
+{
+    const uint32_t pitch = (uint32_t)workload.Width * 4;
+    ApplyMoveRegions(bgra.data(), pitch, 4, frame.Moves.data(), (uint32_t)frame.Moves.size(),
+        workload.Width, workload.Height);
+
+    for (const FrameRect& rect : frame.Dirty)
+    {
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            uint8_t* row = bgra.data() + (size_t)y * pitch + (size_t)rect.Left * 4;
+            std::fill(row, row + (size_t)rect.Width() * 4, (uint8_t)(index * 37 + y));
+        }
+    }
+}
+
+void RunWorkload(const Workload& workload)
+{
+    const int32_t width = workload.Width, height = workload.Height;
+    const size_t pitch = (size_t)width * 4;
+    const size_t planeBytes = (size_t)width * height * 3 / 2;
+
+    std::vector<uint8_t> bgra(pitch * height, 0x40);
+    std::vector<std::vector<uint8_t>> slots(SlotCount, std::vector<uint8_t>(planeBytes));
+    std::vector<uint64_t> slotFrames(SlotCount, 0);
+
+    auto slotSurface = [&](uint32_t index)
+    {
+        uint8_t* pixels = slots[index].data();
+        return Nv12Surface{ pixels, (size_t)width, pixels + (size_t)width * height, (size_t)width };
+    };
+
+    Nv12Converter full;
+    IncrementalNv12Converter incremental;
+    DirtyRegionCoalescer coalescer;
+    FrameRect dirty[64];
+
+    std::vector<double> fullMs, incrementalMs;
+    double convertedArea = 0, movedArea = 0, copiedBytes = 0;
+
+    for (size_t i = 0; i < workload.Frames.size(); i++)
+    {
+        const DirtyRectTraces::MoveFrame& frame = workload.Frames[i];
+        Replay(bgra, workload, frame, (int)i);
+
+        const uint64_t frameNumber = i + 1;
+        const uint32_t index = (uint32_t)(frameNumber % SlotCount);
+
+        auto start = Clock::now();
+        full.ConvertFrame(bgra.data(), pitch, width, height, slotSurface(index));
+        double us = MicrosecondsBetween(start, Clock::now());
+
+        // 首帧两种方式都是整帧转换，不计入统计
+        if (i != 0)
+        {
+            fullMs.push_back(us / 1000.0);
+        }
+
+        start = Clock::now();
+        uint32_t dirtyCount = coalescer.Coalesce(frame.Dirty.data(), (uint32_t)frame.Dirty.size(),
+            width, height, dirty, 64);
+        incremental.Update(bgra.data(), pitch, width, height, dirty, dirtyCount,
+            frame.Moves.data(), (uint32_t)frame.Moves.size(), frameNumber);
+        incremental.CopyTo(slotSurface(index), slotFrames[index]);
+        us = MicrosecondsBetween(start, Clock::now());
+        slotFrames[index] = frameNumber;
+
+        if (i != 0)
+        {
+            incrementalMs.push_back(us / 1000.0);
+            convertedArea += (double)incremental.LastStats().ConvertedArea;
+            movedArea += (double)incremental.LastStats().MovedArea;
+            copiedBytes += (double)incremental.LastStats().CopiedBytes;
+        }
+    }
+    DoNotOptimize(slots[0][0]);
+
+    const double frames = (double)fullMs.size();
+    const double fullP50 = Percentile(fullMs, 50);
+    const double incrementalP50 = Percentile(incrementalMs, 50);
+    std::printf("  %-14s %dx%d  整帧 p50=%6.3fms  增量 p50=%6.3fms p99=%6.3fms  x%.1f\n",
+        workload.Name, width, height, fullP50, incrementalP50, Percentile(incrementalMs, 99),
+        fullP50 / incrementalP50);
+    std::printf("  %-14s 每帧 转换 %.3fMpx (%.1f%%)  NV12移动 %.3fMpx  补拷 %.2fMB\n",
+        "", convertedArea / frames / 1e6, 100.0 * convertedArea / frames / ((double)width * height),
+        movedArea / frames / 1e6, copiedBytes / frames / 1e6);
+}
+
+} // namespace
+
+BENCHMARK(IncrementalConvert_Traces)
+{
+    std::printf("  内核: %s\n", CpuLevelName(DetectCpuLevel()));
+
+    const struct { int32_t Width, Height; } modes[] = { { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& mode : modes)
+    {
+        RunWorkload(FromTrace(DirtyRectTraces::Typing(mode.Width, mode.Height, 240)));
+        RunWorkload(FromTrace(DirtyRectTraces::BrowserScroll(mode.Width, mode.Height, 240)));
+        RunWorkload(FromTrace(DirtyRectTraces::IdeScroll(mode.Width, mode.Height, 240)));
+        RunWorkload(FromTrace(DirtyRectTraces::SmoothScroll(mode.Width, mode.Height, 240)));
+        RunWorkload(FromTrace(DirtyRectTraces::Video(mode.Width, mode.Height, 240)));
+    }
+}
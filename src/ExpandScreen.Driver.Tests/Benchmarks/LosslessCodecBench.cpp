@@ -0,0 +1,276 @@
+/*++
+
+Module Name:
+    LosslessCodecBench.cpp
+
+Abstract:
+    无损瓦片编解码基准：三幅合成的1080p界面截图（IDE文字、设置面板、含照片的网页），
+    按TileHash的64x64瓦片和整帧两种粒度编码，报告压缩率与编码/解码吞吐（MB/s，按
+    原始BGRA字节计），与zlib（级别1、6）和LZ4对比。zlib/LZ4在构建时找不到则跳过
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "LosslessCodec.h"
+#include "ScreenContent.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef EXPANDSCREEN_BENCH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef EXPANDSCREEN_BENCH_LZ4
+#include <lz4.h>
+#endif
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 1920;
+const int32_t Height = 1080;
+const size_t Pitch = (size_t)Width * 4;
+
+struct Screenshot
+{
+    const char* Name;
+    std::vector<uint8_t> Bgra;
+};
+
+std::vector<Screenshot> MakeScreenshots()
+{
+    int32_t photo[4];
+    std::vector<Screenshot> shots;
+    shots.push_back({ "IDE文字", ScreenContent::DrawIde(Width, Height).Bytes() });
+    shots.push_back({ "设置面板", ScreenContent::DrawSettings(Width, Height).Bytes() });
+    shots.push_back({ "网页含照片", ScreenContent::DrawWebPage(Width, Height, photo).Bytes() });
+    return shots;
+}
+
+std::vector<FrameRect> TileGrid(int32_t tile)
+{
+    std::vector<FrameRect> tiles;
+    if (tile == 0)
+    {
+        tiles.push_back({ 0, 0, Width, Height });
+        return tiles;
+    }
+    for (int32_t y = 0; y < Height; y += tile)
+    {
+        for (int32_t x = 0; x < Width; x += tile)
+        {
+            tiles.push_back({ x, y, std::min(x + tile, Width), std::min(y + tile, Height) });
+        }
+    }
+    return tiles;
+}
+
+struct Measurement
+{
+    double Ratio;
+    double EncodeMBps;
+    double DecodeMBps;
+};
+
+void Report(const char* codec, const Measurement& m)
+{
+    std::printf("    %-18s 压缩率 %7.1f:1  编码 %8.0f MB/s  解码 %8.0f MB/s\n",
+        codec, m.Ratio, m.EncodeMBps, m.DecodeMBps);
+}
+
+//
+// 重复编码/解码整幅截图至少minimum秒
+//
+template <typename Encode, typename Decode>
+Measurement Measure(Encode encode, Decode decode)
+{
+    const double rawMB = (double)Pitch * Height / 1e6;
+    const double minimum = 0.3;
+
+    size_t compressed = 0;
+    int rounds = 0;
+    auto start = Clock::now();
+    do
+    {
+        compressed = encode();
+        rounds++;
+    } while (SecondsSince(start) < minimum);
+    const double encodeSeconds = SecondsSince(start) / rounds;
+
+    rounds = 0;
+    start = Clock::now();
+    do
+    {
+        decode();
+        rounds++;
+    } while (SecondsSince(start) < minimum);
+    const double decodeSeconds = SecondsSince(start) / rounds;
+
+    return { (double)Pitch * Height / (double)compressed, rawMB / encodeSeconds, rawMB / decodeSeconds };
+}
+
+//
+// 通用压缩器按瓦片压缩：每个瓦片先拷贝成连续字节（与网络包一致），
+// 压缩数据前记4字节长度
+//
+template <typename Compress, typename Decompress>
+Measurement MeasureGeneric(const Screenshot& shot, const std::vector<FrameRect>& tiles,
+    Compress compress, Decompress decompress)
+{
+    std::vector<uint8_t> tile(Pitch * Height);
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> output(Pitch * Height);
+    std::vector<size_t> sizes(tiles.size());
+
+    return Measure(
+        [&]
+        {
+            stream.clear();
+            for (size_t i = 0; i < tiles.size(); i++)
+            {
+                const FrameRect& rect = tiles[i];
+                const size_t rowBytes = (size_t)rect.Width() * 4;
+                for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                {
+                    std::memcpy(&tile[(size_t)(y - rect.Top) * rowBytes], &shot.Bgra[(size_t)y * Pitch + (size_t)rect.Left * 4], rowBytes);
+                }
+                const size_t rawBytes = rowBytes * rect.Height();
+                const size_t offset = stream.size();
+                stream.resize(offset + rawBytes + rawBytes / 16 + 1024);
+                sizes[i] = compress(tile.data(), rawBytes, stream.data() + offset, stream.size() - offset);
+                stream.resize(offset + sizes[i]);
+            }
+            return stream.size() + tiles.size() * 4;
+        },
+        [&]
+        {
+            size_t offset = 0;
+            for (size_t i = 0; i < tiles.size(); i++)
+            {
+                const FrameRect& rect = tiles[i];
+                const size_t rowBytes = (size_t)rect.Width() * 4;
+                decompress(stream.data() + offset, sizes[i], tile.data(), rowBytes * rect.Height());
+                offset += sizes[i];
+                for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                {
+                    std::memcpy(&output[(size_t)y * Pitch + (size_t)rect.Left * 4], &tile[(size_t)(y - rect.Top) * rowBytes], rowBytes);
+                }
+            }
+            DoNotOptimize(output[0]);
+        });
+}
+
+} // namespace
+
+BENCHMARK(LosslessCodec_ScreenContent)
+{
+    const std::vector<Screenshot> shots = MakeScreenshots();
+    const CpuLevel best = DetectCpuLevel();
+
+    for (const Screenshot& shot : shots)
+    {
+        for (int32_t tileSize : { 64, 0 })
+        {
+            const std::vector<FrameRect> tiles = TileGrid(tileSize);
+            std::printf("  %s，%s：\n", shot.Name, tileSize != 0 ? "64x64瓦片" : "整帧");
+
+            for (CpuLevel level : { CpuLevel::Scalar, best })
+            {
+                LosslessTileEncoder encoder(level);
+                LosslessTileDecoder decoder;
+                std::vector<uint8_t> stream;
+                std::vector<uint8_t> output(Pitch * Height);
+
+                const Measurement m = Measure(
+                    [&]
+                    {
+                        stream.clear();
+                        for (const FrameRect& rect : tiles)
+                        {
+                            encoder.Encode(shot.Bgra.data(), Pitch, rect, stream);
+                        }
+                        return stream.size();
+                    },
+                    [&]
+                    {
+                        size_t offset = 0;
+                        for (const FrameRect& rect : tiles)
+                        {
+                            offset += decoder.Decode(stream.data() + offset, stream.size() - offset, output.data(),
+                                Pitch, Width, Height, rect.Left, rect.Top);
+                        }
+                        DoNotOptimize(offset);
+                    });
+
+                char name[64];
+                std::snprintf(name, sizeof(name), "本编解码(%s)", CpuLevelName(level));
+                Report(name, m);
+                if (std::memcmp(output.data(), shot.Bgra.data(), output.size()) != 0)
+                {
+                    std::printf("    解码结果与原图不一致\n");
+                }
+
+                if (level == best)
+                {
+                    // 单次编码的瓦片模式分布
+                    LosslessTileEncoder counter(level);
+                    for (const FrameRect& rect : tiles)
+                    {
+                        counter.Encode(shot.Bgra.data(), Pitch, rect, stream);
+                    }
+                    const LosslessCodecStats& stats = counter.Stats();
+                    std::printf("    %-18s 原始 %llu  调色板 %llu  预测 %llu\n", "瓦片模式",
+                        (unsigned long long)stats.ModeTiles[(uint32_t)LosslessTileMode::Raw],
+                        (unsigned long long)stats.ModeTiles[(uint32_t)LosslessTileMode::Palette],
+                        (unsigned long long)stats.ModeTiles[(uint32_t)LosslessTileMode::Predictive]);
+                    break;
+                }
+            }
+
+#ifdef EXPANDSCREEN_BENCH_ZLIB
+            for (int zlibLevel : { 1, 6 })
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "zlib-%d", zlibLevel);
+                Report(name, MeasureGeneric(shot, tiles,
+                    [zlibLevel](const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+                    {
+                        uLongf length = (uLongf)capacity;
+                        compress2(destination, &length, source, (uLong)size, zlibLevel);
+                        return (size_t)length;
+                    },
+                    [](const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+                    {
+                        uLongf length = (uLongf)capacity;
+                        uncompress(destination, &length, source, (uLong)size);
+                    }));
+            }
+#endif
+
+#ifdef EXPANDSCREEN_BENCH_LZ4
+            Report("LZ4", MeasureGeneric(shot, tiles,
+                [](const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+                {
+                    return (size_t)LZ4_compress_default(reinterpret_cast<const char*>(source),
+                        reinterpret_cast<char*>(destination), (int)size, (int)capacity);
+                },
+                [](const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+                {
+                    LZ4_decompress_safe(reinterpret_cast<const char*>(source),
+                        reinterpret_cast<char*>(destination), (int)size, (int)capacity);
+                }));
+#endif
+        }
+    }
+
+#ifndef EXPANDSCREEN_BENCH_ZLIB
+    std::printf("  构建时未找到zlib，跳过zlib对比\n");
+#endif
+#ifndef EXPANDSCREEN_BENCH_LZ4
+    std::printf("  构建时未找到LZ4，跳过LZ4对比\n");
+#endif
+}
@@ -0,0 +1,89 @@
+/*++
+
+Module Name:
+    MoveRegionBench.cpp
+
+Abstract:
+    移动区域基准：滚动负载下，携带移动区域相对“目标区域当作脏区域”
+    和整帧处理，每帧少转换/编码的字节数，以及消费者执行移动的耗时
+
+    转换字节按BGRA输入计（4字节/像素），编码字节按NV12输入计（1.5字节/像素）
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "DirtyRectTraces.h"
+#include "DirtyRegion.h"
+#include "MoveRegion.h"
+
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+void RunTrace(const DirtyRectTraces::MoveTrace& trace)
+{
+    DirtyRegionCoalescer coalescer;
+    FrameRect output[64];
+    std::vector<FrameRect> withoutMoves;
+    std::vector<uint8_t> surface((size_t)trace.Width * trace.Height * 4, 0x3C);
+    const uint32_t pitch = (uint32_t)trace.Width * 4;
+
+    double frameArea = (double)trace.Width * trace.Height;
+    double movesArea = 0, noMovesArea = 0, movedNotDirty = 0;
+    std::vector<double> applyUs;
+    applyUs.reserve(trace.Frames.size());
+
+    for (const DirtyRectTraces::MoveFrame& frame : trace.Frames)
+    {
+        // 携带移动区域：只有脏矩形需要转换
+        coalescer.Coalesce(frame.Dirty.data(), (uint32_t)frame.Dirty.size(),
+            trace.Width, trace.Height, output, 64);
+        movesArea += (double)coalescer.LastStats().OutputArea;
+
+        // 丢弃移动区域：目标区域也必须当作脏区域
+        withoutMoves = frame.Dirty;
+        for (const FrameMoveRegion& move : frame.Moves)
+        {
+            withoutMoves.push_back(move.Destination);
+        }
+        coalescer.Coalesce(withoutMoves.data(), (uint32_t)withoutMoves.size(),
+            trace.Width, trace.Height, output, 64);
+        noMovesArea += (double)coalescer.LastStats().OutputArea;
+
+        movedNotDirty += (double)MovedAreaNotDirty(frame.Moves.data(), (uint32_t)frame.Moves.size(),
+            frame.Dirty.data(), (uint32_t)frame.Dirty.size());
+
+        auto start = Clock::now();
+        ApplyMoveRegions(surface.data(), pitch, 4, frame.Moves.data(), (uint32_t)frame.Moves.size(),
+            trace.Width, trace.Height);
+        applyUs.push_back(MicrosecondsBetween(start, Clock::now()));
+        DoNotOptimize(surface[0]);
+    }
+
+    double frames = (double)trace.Frames.size();
+    double avoided = (noMovesArea - movesArea) / frames;
+    std::printf("  %-14s %dx%d  转换面积/帧 整帧 %.2fMpx  无移动 %.2fMpx  有移动 %.2fMpx (%.1f%%)\n",
+        trace.Name, trace.Width, trace.Height,
+        frameArea / 1e6, noMovesArea / frames / 1e6, movesArea / frames / 1e6,
+        100.0 * movesArea / noMovesArea);
+    std::printf("  %-14s 节省/帧 BGRA %.2fMB  NV12 %.2fMB  (移动且未脏 %.2fMpx)  移动耗时 p50=%.0fus p99=%.0fus\n",
+        "", avoided * 4 / 1e6, avoided * 1.5 / 1e6, movedNotDirty / frames / 1e6,
+        Percentile(applyUs, 50), Percentile(applyUs, 99));
+}
+
+} // namespace
+
+BENCHMARK(MoveRegion_ScrollTraces)
+{
+    const struct { int32_t Width, Height; } modes[] = { { 1920, 1080 }, { 3840, 2160 } };
+
+    for (const auto& mode : modes)
+    {
+        RunTrace(DirtyRectTraces::BrowserScroll(mode.Width, mode.Height, 600));
+        RunTrace(DirtyRectTraces::IdeScroll(mode.Width, mode.Height, 600));
+        RunTrace(DirtyRectTraces::SmoothScroll(mode.Width, mode.Height, 600));
+    }
+}
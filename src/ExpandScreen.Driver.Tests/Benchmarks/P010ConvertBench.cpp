@@ -0,0 +1,86 @@
+/*++
+
+Module Name:
+    P010ConvertBench.cpp
+
+Abstract:
+    P010转换基准：g_SupportedModes中的每个模式 x 两种源格式 x 每个SIMD内核，
+    报告每帧耗时、像素吞吐，以及占该模式刷新区间的比例（10位输出的预算）
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "P010Convert.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const char* SourceName(PixelFormat source)
+{
+    return source == PixelFormat::Bgra8 ? "BGRA8" : "RGB10A2";
+}
+
+} // namespace
+
+BENCHMARK(P010Convert_SupportedModes)
+{
+    // 逐个模式（含刷新率，用于换算每帧预算）
+    for (const DisplayMode& mode : DriverModes)
+    {
+        const size_t pitch = (size_t)mode.Width * 4;
+        std::vector<uint8_t> pixels(pitch * mode.Height);
+        std::mt19937 rng(1);
+        for (uint8_t& b : pixels)
+        {
+            b = (uint8_t)rng();
+        }
+
+        const size_t yPitch = (size_t)mode.Width * 2;
+        std::vector<uint8_t> p010(yPitch * mode.Height * 3 / 2);
+        P010Surface surface = { p010.data(), yPitch, p010.data() + yPitch * mode.Height, yPitch };
+        const double intervalMs = 1000.0 / mode.RefreshRate;
+
+        for (PixelFormat source : { PixelFormat::Bgra8, PixelFormat::R10G10B10A2 })
+        {
+            double scalarMs = 0;
+            for (CpuLevel level : { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 })
+            {
+                if (ClampCpuLevel(level) != level)
+                {
+                    std::printf("  %4dx%-4d@%-3d %-7s %-8s 本机不支持\n",
+                        mode.Width, mode.Height, mode.RefreshRate, SourceName(source), CpuLevelName(level));
+                    continue;
+                }
+
+                P010Converter converter(source, YuvMatrix::Bt709, YuvRange::Limited, level);
+                converter.ConvertFrame(pixels.data(), pitch, mode.Width, mode.Height, surface);
+
+                std::vector<double> frameMs;
+                const int iterations = mode.Width >= 3840 ? 30 : 60;
+                for (int i = 0; i < iterations; i++)
+                {
+                    auto start = Clock::now();
+                    converter.ConvertFrame(pixels.data(), pitch, mode.Width, mode.Height, surface);
+                    frameMs.push_back(MicrosecondsBetween(start, Clock::now()) / 1000.0);
+                }
+                DoNotOptimize(p010[0]);
+
+                double p50 = Percentile(frameMs, 50);
+                double p99 = Percentile(frameMs, 99);
+                if (level == CpuLevel::Scalar)
+                {
+                    scalarMs = p50;
+                }
+
+                std::printf("  %4dx%-4d@%-3d %-7s %-8s p50=%6.3fms p99=%6.3fms  %7.1f Mpx/s  x%-4.1f 占刷新区间 %5.1f%%\n",
+                    mode.Width, mode.Height, mode.RefreshRate, SourceName(source), CpuLevelName(level), p50, p99,
+                    (double)mode.Width * mode.Height / p50 / 1e3, scalarMs / p50, 100.0 * p99 / intervalMs);
+            }
+        }
+    }
+}
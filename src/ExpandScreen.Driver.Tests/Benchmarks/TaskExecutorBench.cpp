@@ -0,0 +1,138 @@
+/*++
+
+Module Name:
+    TaskExecutorBench.cpp
+
+Abstract:
+    多监视器扩展性基准：1~16个模拟的1080p监视器，每个监视器一个交换链线程，
+    每帧整帧损伤（视频/滚动）做增量NV12转换。对比每个监视器在自己的线程上
+    串行转换与按行带交给共享的工作窃取执行器：
+        1. 不定速时所有监视器合计的吞吐（帧/秒）
+        2. 各监视器按60Hz提交时，从提交到转换完成的p99帧延迟
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "IncrementalConvert.h"
+#include "TaskExecutor.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 1920;
+const int32_t Height = 1080;
+const size_t Pitch = (size_t)Width * 4;
+
+struct Result
+{
+    double FramesPerSecond;
+    double P50;
+    double P99;
+};
+
+Result RunMonitors(const std::vector<uint8_t>& bgra, uint32_t monitorCount, WorkStealingExecutor* executor)
+{
+    const FrameRect fullFrame = { 0, 0, Width, Height };
+    std::vector<std::unique_ptr<IncrementalNv12Converter>> converters;
+    for (uint32_t i = 0; i < monitorCount; i++)
+    {
+        converters.emplace_back(new IncrementalNv12Converter());
+        converters.back()->SetExecutor(executor);
+    }
+
+    // 不定速：各交换链线程在固定时长内尽量多地处理帧
+    std::atomic<uint64_t> frames{ 0 };
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < monitorCount; i++)
+    {
+        threads.emplace_back([&, i]
+        {
+            for (uint64_t frame = 1; !stop.load(std::memory_order_relaxed); frame++)
+            {
+                converters[i]->Update(bgra.data(), Pitch, Width, Height, &fullFrame, 1, nullptr, 0, frame);
+                frames.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stop = true;
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    const double framesPerSecond = (double)frames.load() / SecondsSince(start);
+    threads.clear();
+
+    // 60Hz定速：各监视器错开提交时刻，延迟从提交时刻算到转换完成
+    const int pacedFrames = 60;
+    const auto interval = std::chrono::microseconds(16667);
+    std::vector<std::vector<double>> latency(monitorCount);
+    const auto base = Clock::now() + std::chrono::milliseconds(5);
+    for (uint32_t i = 0; i < monitorCount; i++)
+    {
+        threads.emplace_back([&, i]
+        {
+            const auto offset = interval * i / monitorCount;
+            for (int frame = 0; frame < pacedFrames; frame++)
+            {
+                const auto present = base + offset + interval * frame;
+                std::this_thread::sleep_until(present);
+                converters[i]->Update(bgra.data(), Pitch, Width, Height, &fullFrame, 1, nullptr, 0,
+                    1000000 + (uint64_t)frame);
+                latency[i].push_back(MicrosecondsBetween(present, Clock::now()));
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<double> all;
+    for (const std::vector<double>& samples : latency)
+    {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    return { framesPerSecond, Percentile(all, 50), Percentile(all, 99) };
+}
+
+} // namespace
+
+BENCHMARK(TaskExecutor_MonitorScaling)
+{
+    std::vector<uint8_t> bgra(Pitch * Height);
+    std::mt19937 rng(5);
+    for (uint8_t& b : bgra)
+    {
+        b = (uint8_t)rng();
+    }
+
+    WorkStealingExecutor executor;
+    std::printf("  %u核，执行器%u个工作线程，内核: %s，每帧1080p整帧转换\n",
+        std::thread::hardware_concurrency(), executor.WorkerCount(), CpuLevelName(DetectCpuLevel()));
+    std::printf("  %-6s %38s   %38s\n", "监视器", "每监视器串行", "共享执行器（64行行带）");
+
+    for (uint32_t monitors : { 1u, 2u, 4u, 8u, 16u })
+    {
+        const Result serial = RunMonitors(bgra, monitors, nullptr);
+        const Result shared = RunMonitors(bgra, monitors, &executor);
+        std::printf("  %-6u %7.0f帧/s p50=%6.0fus p99=%6.0fus   %7.0f帧/s p50=%6.0fus p99=%6.0fus\n",
+            monitors, serial.FramesPerSecond, serial.P50, serial.P99,
+            shared.FramesPerSecond, shared.P50, shared.P99);
+    }
+
+    const TaskExecutorStats stats = executor.Stats();
+    std::printf("  任务 %llu，窃取 %llu，等待线程协助 %llu，队列满直接执行 %llu\n",
+        (unsigned long long)stats.Submitted, (unsigned long long)stats.Stolen,
+        (unsigned long long)stats.Helped, (unsigned long long)stats.Inline);
+}
@@ -0,0 +1,104 @@
+/*++
+
+Module Name:
+    TileClassifierBench.cpp
+
+Abstract:
+    块内容分类基准：4K桌面（左半IDE，右半含照片的网页）整帧损伤时每帧分类耗时
+    （p50/p99，目标0.5ms以内），以及照片区域按刷新周期持续更新（视频播放）时
+    各类别的块数
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "ScreenContent.h"
+#include "TileClassifier.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 3840;
+const int32_t Height = 2160;
+const size_t Pitch = (size_t)Width * 4;
+const int64_t Period = 1000;
+
+//
+// 左半IDE，右半网页；photo返回网页中照片区域的帧坐标
+//
+ScreenContent::Canvas DrawDesktop(int32_t photo[4])
+{
+    ScreenContent::Canvas desktop(Width, Height, 0);
+    const ScreenContent::Canvas ide = ScreenContent::DrawIde(Width / 2, Height);
+    const ScreenContent::Canvas web = ScreenContent::DrawWebPage(Width / 2, Height, photo);
+    for (int32_t y = 0; y < Height; y++)
+    {
+        std::memcpy(&desktop.At(0, y), ide.Data() + (size_t)y * ide.Pitch(), ide.Pitch());
+        std::memcpy(&desktop.At(Width / 2, y), web.Data() + (size_t)y * web.Pitch(), web.Pitch());
+    }
+    photo[0] += Width / 2;
+    photo[2] += Width / 2;
+    return desktop;
+}
+
+void PrintClasses(const char* label, const TileClassifierStats& stats)
+{
+    std::printf("    %-12s 文字/界面 %u  自然图像 %u  视频 %u\n", label,
+        stats.Classes[(uint32_t)TileContent::Text],
+        stats.Classes[(uint32_t)TileContent::Natural],
+        stats.Classes[(uint32_t)TileContent::Video]);
+}
+
+} // namespace
+
+BENCHMARK(TileClassifier_Desktop4K)
+{
+    int32_t photo[4];
+    ScreenContent::Canvas desktop = DrawDesktop(photo);
+    const FrameRect fullFrame = { 0, 0, Width, Height };
+    const CpuLevel best = DetectCpuLevel();
+
+    std::printf("  3840x2160整帧损伤，每帧分类耗时：\n");
+    for (int level = 0; level <= (int)best; level++)
+    {
+        TileContentClassifier classifier((CpuLevel)level);
+        classifier.Configure(ContentClassifierConfig(), Period);
+
+        // 时间戳每次跳过很久，避免全部块被判为视频
+        std::vector<double> frameMs;
+        for (int frame = 1; frame <= 200; frame++)
+        {
+            auto start = Clock::now();
+            classifier.Classify(desktop.Data(), desktop.Pitch(), Width, Height, &fullFrame, 1, frame * Period * 100);
+            frameMs.push_back(MicrosecondsBetween(start, Clock::now()) / 1000.0);
+        }
+        std::printf("    %-12s p50 %.3f ms  p99 %.3f ms\n", CpuLevelName((CpuLevel)level),
+            Percentile(frameMs, 50), Percentile(frameMs, 99));
+        if (level == (int)best)
+        {
+            PrintClasses("静态桌面", classifier.LastStats());
+        }
+    }
+
+    // 视频播放：照片区域每个刷新周期更新一次，只有它是脏的
+    TileContentClassifier classifier(best);
+    ContentClassifierConfig config;
+    classifier.Configure(config, Period);
+    classifier.Classify(desktop.Data(), desktop.Pitch(), Width, Height, &fullFrame, 1, 0);
+    const FrameRect playing = { photo[0], photo[1], photo[2], photo[3] };
+    std::vector<double> frameMs;
+    for (uint32_t frame = 1; frame <= config.VideoMinUpdates + 30; frame++)
+    {
+        desktop.Photo(photo[0], photo[1], photo[2], photo[3], 11 + frame, frame * 0.15);
+        auto start = Clock::now();
+        classifier.Classify(desktop.Data(), desktop.Pitch(), Width, Height, &playing, 1, frame * Period);
+        frameMs.push_back(MicrosecondsBetween(start, Clock::now()) / 1000.0);
+    }
+    std::printf("  视频播放（%dx%d区域每周期更新）：p50 %.3f ms\n", photo[2] - photo[0], photo[3] - photo[1],
+        Percentile(frameMs, 50));
+    PrintClasses("播放区域", classifier.LastStats());
+}
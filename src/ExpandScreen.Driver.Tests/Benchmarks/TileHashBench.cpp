@@ -0,0 +1,118 @@
+/*++
+
+Module Name:
+    TileHashBench.cpp
+
+Abstract:
+    分块内容哈希基准：
+        1. 各SIMD内核哈希4K整帧的吞吐（GB/s）
+        2. 合成负载下被剔除的脏区域比例与每帧过滤耗时
+           光标原样重绘、整窗无效化（只有进度条变化）、打字（行重绘多为原样）、视频
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "DirtyRectTraces.h"
+#include "TileHash.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 3840;
+const int32_t Height = 2160;
+const size_t Pitch = (size_t)Width * 4;
+
+void RunWorkload(const DirtyRectTraces::DamageTrace& workload, std::vector<uint8_t>& frame)
+{
+    TileHasher hasher;
+    std::vector<FrameRect> output;
+    std::mt19937 rng(1);
+    double inputArea = 0, outputArea = 0, hashedBytes = 0;
+    std::vector<double> frameUs;
+
+    for (size_t i = 0; i < workload.Dirty.size(); i++)
+    {
+        for (const FrameRect& rect : workload.Changed[i])
+        {
+            DirtyRectTraces::FillRandom(frame, Pitch, rect, rng);
+        }
+
+        auto start = Clock::now();
+        hasher.Filter(frame.data(), Pitch, Width, Height,
+            workload.Dirty[i].data(), (uint32_t)workload.Dirty[i].size(), output);
+        double us = MicrosecondsBetween(start, Clock::now());
+
+        // 首帧所有块未知，不计入统计
+        if (i == 0)
+        {
+            continue;
+        }
+
+        frameUs.push_back(us);
+        inputArea += (double)hasher.LastStats().InputArea;
+        outputArea += (double)hasher.LastStats().OutputArea;
+        hashedBytes += (double)hasher.LastStats().HashedBytes;
+    }
+
+    double frames = (double)frameUs.size();
+    std::printf("  %-18s 剔除 %5.1f%% 脏面积  哈希 %6.2fMB/帧  p50=%.0fus p99=%.0fus\n",
+        workload.Name, 100.0 * (1.0 - outputArea / inputArea), hashedBytes / frames / 1e6,
+        Percentile(frameUs, 50), Percentile(frameUs, 99));
+}
+
+} // namespace
+
+BENCHMARK(TileHash_Throughput)
+{
+    std::vector<uint8_t> frame(Pitch * Height);
+    std::mt19937 rng(7);
+    DirtyRectTraces::FillRandom(frame, Pitch, { 0, 0, Width, Height }, rng);
+
+    for (CpuLevel level : { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 })
+    {
+        if (ClampCpuLevel(level) != level)
+        {
+            std::printf("  %-8s 本机不支持\n", CpuLevelName(level));
+            continue;
+        }
+
+        TileHashFunction hash = SelectTileHash(level);
+        const int iterations = 20;
+        uint64_t sink = 0;
+
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            // 按64x64块哈希整帧，与TileHasher的访问模式一致
+            for (int32_t y = 0; y < Height; y += 64)
+            {
+                uint32_t rows = (uint32_t)(Height - y < 64 ? Height - y : 64);
+                for (int32_t x = 0; x < Width; x += 64)
+                {
+                    sink += hash(frame.data() + (size_t)y * Pitch + (size_t)x * 4, Pitch, 256, rows);
+                }
+            }
+        }
+        double seconds = SecondsSince(start);
+        DoNotOptimize(sink);
+
+        std::printf("  %-8s %6.2f GB/s  (%.2fms/4K帧)\n", CpuLevelName(level),
+            (double)frame.size() * iterations / seconds / 1e9, seconds * 1000.0 / iterations);
+    }
+}
+
+BENCHMARK(TileHash_Suppression)
+{
+    std::vector<uint8_t> frame(Pitch * Height, 0x20);
+    std::printf("  内核: %s\n", CpuLevelName(DetectCpuLevel()));
+
+    RunWorkload(DirtyRectTraces::CaretRedraw(600), frame);
+    RunWorkload(DirtyRectTraces::WindowProgress(600), frame);
+    RunWorkload(DirtyRectTraces::TypingRedraw(600), frame);
+    RunWorkload(DirtyRectTraces::VideoPlayback(300), frame);
+}
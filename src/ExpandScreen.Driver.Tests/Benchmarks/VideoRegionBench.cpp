@@ -0,0 +1,99 @@
+/*++
+
+Module Name:
+    VideoRegionBench.cpp
+
+Abstract:
+    视频区域检测基准：4K桌面上每帧的Update耗时（微秒），分三种轨迹：
+        1. 1080p视频窗口稳定播放，另有打字与光标闪烁
+        2. 只有光标闪烁（几乎空闲）
+        3. 每帧整帧损伤（全屏视频）
+
+--*/
+
+#include "Benchmarks/BenchHarness.h"
+#include "VideoRegion.h"
+
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace BenchHarness;
+
+namespace {
+
+const int32_t Width = 3840;
+const int32_t Height = 2160;
+const int64_t Period = 1000;
+
+struct Scenario
+{
+    const char* Name;
+    std::vector<FrameRect> (*Damage)(int64_t interval);
+};
+
+std::vector<FrameRect> WindowedVideo(int64_t interval)
+{
+    std::vector<FrameRect> rects;
+    if (interval % 2 == 0)
+    {
+        rects.push_back({ 1200, 500, 3120, 1580 });
+    }
+    if (interval % 7 == 0)
+    {
+        rects.push_back({ 100, 1700 + (int32_t)(interval % 5) * 18, 900, 1718 + (int32_t)(interval % 5) * 18 });
+    }
+    if (interval % 32 == 0)
+    {
+        rects.push_back({ 480, 1702, 482, 1720 });
+    }
+    return rects;
+}
+
+std::vector<FrameRect> CaretOnly(int64_t interval)
+{
+    std::vector<FrameRect> rects;
+    rects.push_back({ 480, 1702, 482, 1720 });
+    (void)interval;
+    return rects;
+}
+
+std::vector<FrameRect> FullScreen(int64_t interval)
+{
+    (void)interval;
+    return { { 0, 0, Width, Height } };
+}
+
+} // namespace
+
+BENCHMARK(VideoRegion_Desktop4K)
+{
+    const Scenario scenarios[] = {
+        { "窗口视频+打字", WindowedVideo },
+        { "光标闪烁", CaretOnly },
+        { "全屏视频", FullScreen },
+    };
+
+    for (const Scenario& scenario : scenarios)
+    {
+        VideoRegionDetector detector;
+        detector.Configure(VideoRegionConfig(), Period);
+
+        std::vector<double> frameUs;
+        uint32_t regions = 0;
+        for (int64_t interval = 1; interval <= 3000; interval++)
+        {
+            const std::vector<FrameRect> rects = scenario.Damage(interval);
+            if (rects.empty())
+            {
+                continue;
+            }
+            auto start = Clock::now();
+            regions = detector.Update(Width, Height, rects.data(), (uint32_t)rects.size(), interval * Period);
+            frameUs.push_back(MicrosecondsBetween(start, Clock::now()));
+        }
+
+        std::printf("  %-14s p50 %6.2f us  p99 %6.2f us  区域 %u  热块 %u  重建 %llu\n", scenario.Name,
+            Percentile(frameUs, 50), Percentile(frameUs, 99), regions, detector.HotTiles(),
+            (unsigned long long)detector.Stats().Rebuilds);
+    }
+}
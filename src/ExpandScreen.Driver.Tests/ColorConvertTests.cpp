@@ -0,0 +1,174 @@
+/*++
+
+Module Name:
+    ColorConvertTests.cpp
+
+Abstract:
+    BGRA到NV12转换测试：各SIMD内核与标量参考逐位一致（含尾部、行距填充、
+    子矩形），以及BT.601/BT.709、有限/完整范围的已知颜色取值
+
+--*/
+
+#include "TestHarness.h"
+#include "ColorConvert.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const CpuLevel AllLevels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+const YuvMatrix AllMatrices[] = { YuvMatrix::Bt601, YuvMatrix::Bt709 };
+const YuvRange AllRanges[] = { YuvRange::Limited, YuvRange::Full };
+
+struct Nv12Buffer
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;
+    std::vector<uint8_t> Bytes;
+
+    Nv12Buffer(int32_t width, int32_t height, size_t padding = 0)
+        : Width(width), Height(height), Pitch((size_t)width + padding),
+          Bytes(Pitch * (size_t)height * 3 / 2, 0xCD)
+    {
+    }
+
+    Nv12Surface Surface()
+    {
+        return { Bytes.data(), Pitch, Bytes.data() + Pitch * (size_t)Height, Pitch };
+    }
+};
+
+std::vector<uint8_t> RandomBgra(int32_t width, int32_t height, size_t pitch, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> bgra(pitch * (size_t)height);
+    for (uint8_t& b : bgra)
+    {
+        b = (uint8_t)rng();
+    }
+
+    // 混入纯黑、纯白与饱和色，覆盖钳位边界
+    uint32_t specials[] = { 0xFF000000u, 0xFFFFFFFFu, 0xFFFF0000u, 0xFF00FF00u, 0xFF0000FFu, 0x00FFFF00u };
+    for (int i = 0; i < width * height / 8; i++)
+    {
+        size_t x = rng() % (uint32_t)width, y = rng() % (uint32_t)height;
+        std::memcpy(&bgra[y * pitch + x * 4], &specials[rng() % 6], 4);
+    }
+    return bgra;
+}
+
+// 单一颜色2x2帧转换结果
+void ConvertSolid(uint32_t bgra, YuvMatrix matrix, YuvRange range, uint8_t& y, uint8_t& u, uint8_t& v)
+{
+    uint32_t pixels[4] = { bgra, bgra, bgra, bgra };
+    Nv12Buffer nv12(2, 2);
+    Nv12Converter(matrix, range, CpuLevel::Scalar).ConvertFrame(
+        reinterpret_cast<const uint8_t*>(pixels), 8, 2, 2, nv12.Surface());
+    y = nv12.Bytes[0];
+    u = nv12.Bytes[4];
+    v = nv12.Bytes[5];
+}
+
+bool Near(int expected, int actual)
+{
+    return actual >= expected - 1 && actual <= expected + 1;
+}
+
+} // namespace
+
+TEST_CASE(ColorConvert_AllKernelsMatchScalarReference)
+{
+    for (int32_t width : { 2, 14, 16, 18, 30, 32, 34, 62, 64, 66, 130, 258, 1922 })
+    {
+        const int32_t height = 6;
+        const size_t pitch = (size_t)width * 4 + 20;
+        std::vector<uint8_t> bgra = RandomBgra(width, height, pitch, (uint32_t)width);
+
+        for (YuvMatrix matrix : AllMatrices)
+        {
+            for (YuvRange range : AllRanges)
+            {
+                Nv12Buffer expected(width, height, 6);
+                Nv12Converter(matrix, range, CpuLevel::Scalar).ConvertFrame(
+                    bgra.data(), pitch, width, height, expected.Surface());
+
+                for (CpuLevel level : AllLevels)
+                {
+                    Nv12Buffer actual(width, height, 6);
+                    Nv12Converter(matrix, range, level).ConvertFrame(
+                        bgra.data(), pitch, width, height, actual.Surface());
+                    EXPECT_TRUE(actual.Bytes == expected.Bytes);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(ColorConvert_RectConversionTouchesOnlyAlignedRect)
+{
+    const int32_t width = 200, height = 40;
+    const size_t pitch = (size_t)width * 4;
+    std::vector<uint8_t> bgra = RandomBgra(width, height, pitch, 3);
+
+    for (CpuLevel level : AllLevels)
+    {
+        Nv12Converter converter(YuvMatrix::Bt709, YuvRange::Limited, level);
+        Nv12Buffer full(width, height);
+        converter.ConvertFrame(bgra.data(), pitch, width, height, full.Surface());
+
+        // 奇数边界向外对齐到(36, 4)-(172, 24)
+        Nv12Buffer partial(width, height);
+        converter.Convert(bgra.data(), pitch, width, height, partial.Surface(), { 37, 5, 171, 23 });
+
+        for (int32_t y = 0; y < height; y++)
+        {
+            for (int32_t x = 0; x < width; x++)
+            {
+                bool inside = x >= 36 && x < 172 && y >= 4 && y < 24;
+                uint8_t expectedY = inside ? full.Bytes[(size_t)y * full.Pitch + x] : 0xCD;
+                ASSERT_TRUE(partial.Bytes[(size_t)y * partial.Pitch + x] == expectedY);
+            }
+        }
+
+        const size_t uvOffset = full.Pitch * height;
+        for (int32_t y = 0; y < height / 2; y++)
+        {
+            for (int32_t x = 0; x < width; x++)
+            {
+                bool inside = x >= 36 && x < 172 && y >= 2 && y < 12;
+                size_t index = uvOffset + (size_t)y * full.Pitch + x;
+                ASSERT_TRUE(partial.Bytes[index] == (inside ? full.Bytes[index] : 0xCD));
+            }
+        }
+    }
+}
+
+TEST_CASE(ColorConvert_KnownColors)
+{
+    uint8_t y, u, v;
+
+    // 黑、白、灰
+    ConvertSolid(0xFF000000u, YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+    EXPECT_EQ(16, y); EXPECT_EQ(128, u); EXPECT_EQ(128, v);
+    ConvertSolid(0xFFFFFFFFu, YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+    EXPECT_EQ(235, y); EXPECT_EQ(128, u); EXPECT_EQ(128, v);
+    ConvertSolid(0xFFFFFFFFu, YuvMatrix::Bt601, YuvRange::Full, y, u, v);
+    EXPECT_EQ(255, y); EXPECT_EQ(128, u); EXPECT_EQ(128, v);
+    ConvertSolid(0xFF808080u, YuvMatrix::Bt601, YuvRange::Full, y, u, v);
+    EXPECT_EQ(128, y); EXPECT_EQ(128, u); EXPECT_EQ(128, v);
+
+    // 纯红：BT.601有限范围(81, 90, 240)，BT.709有限范围(63, 102, 240)
+    ConvertSolid(0xFFFF0000u, YuvMatrix::Bt601, YuvRange::Limited, y, u, v);
+    EXPECT_TRUE(Near(81, y)); EXPECT_TRUE(Near(90, u)); EXPECT_TRUE(Near(240, v));
+    ConvertSolid(0xFFFF0000u, YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+    EXPECT_TRUE(Near(63, y)); EXPECT_TRUE(Near(102, u)); EXPECT_TRUE(Near(240, v));
+
+    // 纯蓝完整范围：U达到上限255
+    ConvertSolid(0xFF0000FFu, YuvMatrix::Bt601, YuvRange::Full, y, u, v);
+    EXPECT_TRUE(Near(29, y)); EXPECT_EQ(255, u); EXPECT_TRUE(Near(107, v));
+}
@@ -0,0 +1,272 @@
+/*++
+
+Module Name:
+    ContentCadenceTests.cpp
+
+Abstract:
+    内容节奏测试（模拟时间线）：120Hz模式下播放器每个刷新周期都提交、内容只按
+    24/30fps变化时，锁定后发布率降到内容帧率且内容帧不增加延迟；内容与刷新率
+    相同或节奏不稳定时不降频；光标输入与内容区域之外的损伤立即恢复按刷新率发布，
+    输入后的保持期内不重新进入
+
+--*/
+
+#include "TestHarness.h"
+#include "SimulatedClock.h"
+#include "ContentCadence.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+const FrameRect Movie = { 320, 180, 1600, 900 };
+
+struct TimelinePresent
+{
+    int64_t Time;
+    FrameRect Damage;
+    bool Content;               // 本次提交的内容是否变化（否则是重复提交，发布时被比较丢弃）
+    bool Input = false;         // 提交前有光标输入
+};
+
+struct TimelineEmit
+{
+    int64_t Time;
+    int64_t PresentTime;        // 本帧最新一次提交的时间
+    bool Content;
+};
+
+//
+// 模拟交换链路径：提交经节奏检测得到挂起时间交给定速器，发布时内容变化的帧
+// 交给节奏检测；唤醒无延迟
+//
+std::vector<TimelineEmit> Simulate(
+    FramePacer& pacer,
+    ContentCadenceDetector& cadence,
+    const std::vector<TimelinePresent>& presents)
+{
+    const int64_t never = std::numeric_limits<int64_t>::max();
+    std::vector<TimelineEmit> emits;
+    SimulatedClock clock(TicksPerSecond);
+    size_t next = 0;
+    bool pendingContent = false;
+    FrameRect pendingBounds = {};
+    int64_t pendingPresent = 0;
+
+    while (next < presents.size() || pacer.HasPending())
+    {
+        int64_t wake = next < presents.size() ? presents[next].Time : never;
+        if (pacer.HasPending())
+        {
+            wake = std::min(wake, std::max(pacer.Deadline(), clock.Now()));
+        }
+        clock.AdvanceTo(wake);
+
+        while (next < presents.size() && presents[next].Time <= clock.Now())
+        {
+            const TimelinePresent& present = presents[next++];
+            if (present.Input)
+            {
+                cadence.OnInput(present.Time);
+            }
+            if (!pacer.HasPending())
+            {
+                pendingContent = false;
+                pendingBounds = FrameRect();
+            }
+            pacer.OnPresent(present.Time, cadence.OnPresent(present.Time, present.Damage));
+            pendingContent |= present.Content;
+            pendingBounds = UnionRect(pendingBounds, present.Damage);
+            pendingPresent = present.Time;
+        }
+
+        if (pacer.ShouldEmit(clock.Now()))
+        {
+            pacer.OnEmit(clock.Now());
+            if (pendingContent)
+            {
+                cadence.OnContentFrame(pendingPresent, pendingBounds);
+            }
+            emits.push_back({ clock.Now(), pendingPresent, pendingContent });
+        }
+    }
+
+    return emits;
+}
+
+//
+// 播放器每个刷新周期提交一次，每contentEvery次提交内容变化一次
+//
+std::vector<TimelinePresent> Playback(int64_t period, int count, int contentEvery, const FrameRect& damage = Movie)
+{
+    std::vector<TimelinePresent> presents;
+    for (int i = 0; i < count; i++)
+    {
+        presents.push_back({ period * i, damage, i % contentEvery == 0 });
+    }
+    return presents;
+}
+
+struct Counts
+{
+    size_t Emits = 0;
+    size_t ContentEmits = 0;
+};
+
+Counts CountEmits(const std::vector<TimelineEmit>& emits, int64_t from, int64_t to)
+{
+    Counts counts;
+    for (const TimelineEmit& emit : emits)
+    {
+        if (emit.Time >= from && emit.Time < to)
+        {
+            counts.Emits++;
+            counts.ContentEmits += emit.Content ? 1 : 0;
+        }
+    }
+    return counts;
+}
+
+} // namespace
+
+TEST_CASE(ContentCadence_MovieAt120HzDropsToContentRate)
+{
+    for (int contentEvery : { 5, 4 })
+    {
+        FramePacer pacer;
+        pacer.Configure(TicksPerSecond, 120, 1);
+        const int64_t period = pacer.Period();
+        ContentCadenceDetector cadence;
+        cadence.Configure(ContentCadenceConfig(), period);
+
+        // 4秒：24fps（每5次提交变化一次）与30fps（每4次）
+        const std::vector<TimelineEmit> emits = Simulate(pacer, cadence, Playback(period, 480, contentEvery));
+        EXPECT_TRUE(cadence.Active());
+        EXPECT_EQ(1u, (uint32_t)cadence.Stats().Activations);
+        EXPECT_EQ(period * contentEvery, cadence.ContentInterval());
+        EXPECT_TRUE(cadence.ContentBounds() == Movie);
+
+        // 积累MinFrames个间隔之前按刷新率发布，锁定后（1秒之后）每次发布都是内容帧
+        const int64_t lockIn = (int64_t)ContentCadenceConfig().MinFrames * contentEvery;
+        EXPECT_EQ((size_t)lockIn, CountEmits(emits, 0, period * lockIn).Emits);
+        const Counts locked = CountEmits(emits, period * 120, period * 480);
+        EXPECT_EQ((size_t)(360 / contentEvery), locked.Emits);
+        EXPECT_EQ(locked.Emits, locked.ContentEmits);
+        EXPECT_TRUE(cadence.Stats().HeldPresents >= (uint64_t)(360 - 360 / contentEvery));
+
+        // 内容帧在提交时刻立即发布
+        for (const TimelineEmit& emit : emits)
+        {
+            if (emit.Time >= period * 120 && emit.Time < period * 480)
+            {
+                EXPECT_EQ(emit.PresentTime, emit.Time);
+            }
+        }
+    }
+}
+
+TEST_CASE(ContentCadence_FastOrIrregularContentKeepsRefreshRate)
+{
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 120, 1);
+    const int64_t period = pacer.Period();
+
+    // 内容与刷新率相同
+    {
+        ContentCadenceDetector cadence;
+        cadence.Configure(ContentCadenceConfig(), period);
+        const std::vector<TimelineEmit> emits = Simulate(pacer, cadence, Playback(period, 240, 1));
+        EXPECT_EQ(240u, emits.size());
+        EXPECT_EQ(0u, (uint32_t)cadence.Stats().Activations);
+    }
+
+    // 帧时间不稳定的游戏：内容间隔在2~6个周期之间随机
+    {
+        pacer.Configure(TicksPerSecond, 120, 1);
+        ContentCadenceDetector cadence;
+        cadence.Configure(ContentCadenceConfig(), period);
+        std::mt19937 rng(9);
+        std::vector<TimelinePresent> presents;
+        int nextContent = 0;
+        for (int i = 0; i < 480; i++)
+        {
+            const bool content = i == nextContent;
+            nextContent += content ? 2 + (int)(rng() % 5) : 0;
+            presents.push_back({ period * i, Movie, content });
+        }
+        const std::vector<TimelineEmit> emits = Simulate(pacer, cadence, presents);
+        EXPECT_EQ(480u, emits.size());
+        EXPECT_EQ(0u, (uint32_t)cadence.Stats().HeldPresents);
+    }
+}
+
+TEST_CASE(ContentCadence_InputAndOutsideDamageSnapBack)
+{
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 120, 1);
+    const int64_t period = pacer.Period();
+    ContentCadenceConfig config;
+    ContentCadenceDetector cadence;
+    cadence.Configure(config, period);
+
+    // 24fps播放2秒后在内容帧之间出现区域外的损伤（通知弹出），3秒时有光标输入
+    std::vector<TimelinePresent> presents = Playback(period, 720, 5);
+    const FrameRect toast = { 1700, 900, 1900, 1000 };
+    presents[242].Damage = UnionRect(Movie, toast);
+    presents[242].Content = true;
+    presents[362].Input = true;
+    const std::vector<TimelineEmit> emits = Simulate(pacer, cadence, presents);
+
+    const ContentCadenceStats& stats = cadence.Stats();
+    EXPECT_EQ(1u, (uint32_t)stats.Exits[(uint32_t)CadenceExitReason::Damage]);
+    EXPECT_EQ(1u, (uint32_t)stats.Exits[(uint32_t)CadenceExitReason::Input]);
+
+    // 两处都在提交时刻立即发布，之后恢复按刷新率发布
+    auto emittedAt = [&](int64_t time)
+    {
+        return std::any_of(emits.begin(), emits.end(), [&](const TimelineEmit& emit) { return emit.Time == time; });
+    };
+    EXPECT_TRUE(emittedAt(period * 242));
+    EXPECT_TRUE(emittedAt(period * 362));
+    EXPECT_EQ(10u, CountEmits(emits, period * 243, period * 253).Emits);
+    EXPECT_EQ(10u, CountEmits(emits, period * 363, period * 373).Emits);
+
+    // 区域外损伤之后重新积累MinFrames个间隔即再次降频；输入之后还要等待保持期
+    EXPECT_EQ(3u, (uint32_t)stats.Activations);
+    const int64_t holdoffEnd = period * (362 + config.InputHoldoffPeriods);
+    EXPECT_EQ((size_t)config.InputHoldoffPeriods, CountEmits(emits, period * 362, holdoffEnd).Emits);
+    EXPECT_TRUE(cadence.Active());
+    const Counts tail = CountEmits(emits, period * 600, period * 720);
+    EXPECT_EQ(24u, tail.Emits);
+}
+
+TEST_CASE(ContentCadence_UnpacedOrResetDisables)
+{
+    ContentCadenceDetector cadence;
+    cadence.Configure(ContentCadenceConfig(), 0);
+    for (int i = 0; i < 40; i++)
+    {
+        cadence.OnContentFrame(1000 * i, Movie);
+    }
+    EXPECT_TRUE(!cadence.Active());
+    EXPECT_EQ(0, cadence.OnPresent(40000, Movie));
+
+    // 锁定后Reset（尺寸变化）立即退出
+    const int64_t period = 1000;
+    cadence.Configure(ContentCadenceConfig(), period);
+    for (int i = 0; i < 10; i++)
+    {
+        cadence.OnContentFrame(period * 5 * i, Movie);
+    }
+    EXPECT_TRUE(cadence.Active());
+    EXPECT_TRUE(cadence.OnPresent(period * 46, Movie) != 0);
+    cadence.Reset();
+    EXPECT_TRUE(!cadence.Active());
+    EXPECT_EQ(0, cadence.OnPresent(period * 47, Movie));
+}
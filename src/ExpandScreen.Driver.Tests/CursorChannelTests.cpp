@@ -0,0 +1,213 @@
+/*++
+
+Module Name:
+    CursorChannelTests.cpp
+
+Abstract:
+    硬件光标通道测试：状态去重、事件与形状的跨映射往返、消费者落后超过一圈时
+    跳到最新事件、并发读写不接受撕裂的事件
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "CursorChannel.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+CursorEvent MakeEvent(int32_t x, int32_t y)
+{
+    CursorEvent event = {};
+    event.Flags = CursorEventPosition;
+    event.ShapeId = 1;
+    event.X = x;
+    event.Y = y;
+    event.Visible = 1;
+    event.Time = x;
+    return event;
+}
+
+} // namespace
+
+TEST_CASE(CursorChannel_TrackerOnlyEmitsChanges)
+{
+    CursorStateTracker tracker;
+    CursorEvent event = {};
+
+    const CursorShapeRef arrow = { 7, 0, 1, 1 };
+    const CursorShapeRef beam = { 8, 1, 4, 8 };
+
+    // 第一次查询总是产生完整事件
+    ASSERT_TRUE(tracker.Update(true, 10, 20, &arrow, 100, event));
+    EXPECT_EQ(CursorEventPosition | CursorEventVisibility | CursorEventShape, event.Flags);
+    EXPECT_EQ(7u, event.ShapeId);
+    EXPECT_EQ(7u, tracker.ShapeId());
+
+    EXPECT_FALSE(tracker.Update(true, 10, 20, nullptr, 200, event));
+    EXPECT_EQ(1u, tracker.Suppressed());
+
+    ASSERT_TRUE(tracker.Update(true, 11, 20, nullptr, 300, event));
+    EXPECT_EQ(CursorEventPosition, event.Flags);
+    EXPECT_EQ(7u, event.ShapeId);
+    EXPECT_EQ(300, event.Time);
+
+    ASSERT_TRUE(tracker.Update(false, 11, 20, &beam, 400, event));
+    EXPECT_EQ(CursorEventVisibility | CursorEventShape, event.Flags);
+    EXPECT_EQ(0u, event.Visible);
+    EXPECT_EQ(1u, event.ShapeSlot);
+    EXPECT_EQ(8, event.YHot);
+
+    // 同一形状重复上报不算变化，只换热点算
+    EXPECT_FALSE(tracker.Update(false, 11, 20, &beam, 500, event));
+    const CursorShapeRef beamMoved = { 8, 1, 5, 8 };
+    ASSERT_TRUE(tracker.Update(false, 11, 20, &beamMoved, 550, event));
+    EXPECT_EQ(CursorEventShape, event.Flags);
+    EXPECT_EQ(5, event.XHot);
+
+    tracker.Reset();
+    ASSERT_TRUE(tracker.Update(false, 11, 20, nullptr, 600, event));
+    EXPECT_EQ(CursorEventPosition | CursorEventVisibility, event.Flags);
+}
+
+TEST_CASE(CursorChannel_EventsAndShapeRoundTrip)
+{
+    SharedMemoryRegion region(CursorChannelLayout::RequiredSize());
+    ASSERT_TRUE(region.IsValid());
+
+    CursorChannelConsumer consumer;
+    EXPECT_FALSE(consumer.Attach(region.ReadOnly(), region.Size()));
+
+    ASSERT_TRUE(CursorChannelProducer::Format(region.Writable(), region.Size()));
+    CursorChannelProducer producer;
+    ASSERT_TRUE(producer.Attach(region.Writable(), region.Size()));
+    ASSERT_TRUE(consumer.Attach(region.ReadOnly(), region.Size()));
+
+    CursorShapeInfo info = {};
+    std::vector<uint8_t> shapePixels((size_t)CursorMaxShapeBytes);
+    EXPECT_FALSE(consumer.ReadShape(0, info, shapePixels.data()));
+
+    // 32x32 alpha形状写入槽位2
+    CursorShapeInfo shape = { 5, CursorShapeType::Alpha, 32, 32, 128, 0 };
+    std::vector<uint8_t> pixels(128 * 32);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = (uint8_t)(i * 7);
+    }
+    ASSERT_TRUE(producer.PublishShape(2, shape, pixels.data()));
+
+    // 超过最大尺寸的形状与越界槽位被拒绝，原形状保留
+    CursorShapeInfo huge = { 6, CursorShapeType::Alpha, CursorMaxShapeSize + 1, 8, (CursorMaxShapeSize + 1) * 4, 0 };
+    std::vector<uint8_t> hugePixels((size_t)huge.Pitch * huge.Height);
+    EXPECT_FALSE(producer.PublishShape(2, huge, hugePixels.data()));
+    EXPECT_FALSE(producer.PublishShape(CursorShapeSlotCount, shape, pixels.data()));
+
+    EXPECT_FALSE(consumer.ReadShape(0, info, shapePixels.data()));
+    ASSERT_TRUE(consumer.ReadShape(2, info, shapePixels.data()));
+    EXPECT_EQ(5u, info.ShapeId);
+    EXPECT_TRUE(info.Type == CursorShapeType::Alpha);
+    EXPECT_EQ(0, std::memcmp(pixels.data(), shapePixels.data(), pixels.size()));
+
+    CursorEvent events[8];
+    EXPECT_EQ(0u, consumer.Poll(events, 8));
+
+    for (int32_t i = 1; i <= 3; i++)
+    {
+        EXPECT_EQ((uint64_t)i, producer.PublishEvent(MakeEvent(i, -i)));
+    }
+
+    ASSERT_TRUE(consumer.Poll(events, 2) == 2);
+    EXPECT_EQ(1, events[0].X);
+    EXPECT_EQ(-2, events[1].Y);
+    ASSERT_TRUE(consumer.Poll(events, 8) == 1);
+    EXPECT_EQ(3, events[0].X);
+    EXPECT_EQ(3u, consumer.LastEvent());
+    EXPECT_EQ(0u, consumer.LostEvents());
+}
+
+TEST_CASE(CursorChannel_LaggingConsumerSkipsToLatest)
+{
+    SharedMemoryRegion region(CursorChannelLayout::RequiredSize());
+    ASSERT_TRUE(CursorChannelProducer::Format(region.Writable(), region.Size()));
+
+    CursorChannelProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    CursorChannelConsumer consumer;
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    const int32_t count = (int32_t)CursorEventCapacity * 3 + 5;
+    for (int32_t i = 1; i <= count; i++)
+    {
+        producer.PublishEvent(MakeEvent(i, 0));
+    }
+
+    CursorEvent events[4];
+    ASSERT_TRUE(consumer.Poll(events, 4) == 1);
+    EXPECT_EQ(count, events[0].X);
+    EXPECT_EQ((uint64_t)count - 1, consumer.LostEvents());
+
+    // 落后不足一圈时按序取出
+    for (int32_t i = 1; i <= 3; i++)
+    {
+        producer.PublishEvent(MakeEvent(count + i, 0));
+    }
+    ASSERT_TRUE(consumer.Poll(events, 4) == 3);
+    EXPECT_EQ(count + 1, events[0].X);
+    EXPECT_EQ((uint64_t)count - 1, consumer.LostEvents());
+}
+
+TEST_CASE(CursorChannel_ConcurrentStressNeverAcceptsTornEvent)
+{
+    SharedMemoryRegion region(CursorChannelLayout::RequiredSize());
+    ASSERT_TRUE(CursorChannelProducer::Format(region.Writable(), region.Size()));
+
+    const int32_t eventCount = 200000;
+    std::atomic<bool> done{ false };
+    uint64_t received = 0;
+    uint64_t corrupt = 0;
+    bool ordered = true;
+
+    std::thread consumerThread([&] {
+        CursorChannelConsumer consumer;
+        consumer.Attach(region.ReadOnly(), region.Size());
+        CursorEvent events[32];
+        int32_t last = 0;
+
+        while (!done.load(std::memory_order_acquire) || (int32_t)consumer.LastEvent() < eventCount)
+        {
+            uint32_t count = consumer.Poll(events, 32);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                // 事件内各字段由同一个值派生，撕裂的事件不满足
+                if (events[i].Y != -events[i].X || events[i].Time != events[i].X)
+                {
+                    corrupt++;
+                }
+                if (events[i].X <= last)
+                {
+                    ordered = false;
+                }
+                last = events[i].X;
+            }
+            received += count;
+        }
+    });
+
+    CursorChannelProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    for (int32_t i = 1; i <= eventCount; i++)
+    {
+        producer.PublishEvent(MakeEvent(i, -i));
+    }
+    done.store(true, std::memory_order_release);
+    consumerThread.join();
+
+    EXPECT_EQ(0u, corrupt);
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(received > 0);
+}
@@ -0,0 +1,225 @@
+/*++
+
+Module Name:
+    CursorShapeCacheTests.cpp
+
+Abstract:
+    光标形状缓存测试：同内容同ID（忽略行尾填充）、类型与尺寸参与区分、LRU淘汰与
+    槽位复用、各SIMD级别ID一致，以及经光标通道只在新ID时读取位图的端到端流程
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "CursorShapeCache.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+struct Shape
+{
+    CursorShapeInfo Info;
+    std::vector<uint8_t> Pixels;
+
+    Shape(uint32_t width, uint32_t height, uint32_t seed, uint32_t padding = 0, CursorShapeType type = CursorShapeType::Alpha)
+        : Info{ 0, type, width, height, width * 4 + padding, 0 },
+          Pixels((size_t)Info.Pitch * height)
+    {
+        std::mt19937 rng(seed);
+        for (uint8_t& b : Pixels)
+        {
+            b = (uint8_t)rng();
+        }
+    }
+
+    // 只改变行尾填充，可见像素不变
+    Shape WithPadding(uint32_t padding) const
+    {
+        Shape padded(Info.Width, Info.Height, 0, padding, Info.Type);
+        const size_t rowBytes = (size_t)Info.Width * 4;
+        for (uint32_t y = 0; y < Info.Height; y++)
+        {
+            std::memcpy(&padded.Pixels[y * padded.Info.Pitch], &Pixels[y * Info.Pitch], rowBytes);
+        }
+        return padded;
+    }
+};
+
+CursorShapeLookup Lookup(CursorShapeCache& cache, const Shape& shape)
+{
+    CursorShapeLookup result = {};
+    EXPECT_TRUE(cache.Lookup(shape.Info, shape.Pixels.data(), result));
+    return result;
+}
+
+} // namespace
+
+TEST_CASE(CursorShapeCache_SameContentGetsSameId)
+{
+    CursorShapeCache cache;
+    const Shape arrow(32, 32, 1);
+    const Shape beam(16, 24, 2);
+
+    CursorShapeLookup first = Lookup(cache, arrow);
+    EXPECT_FALSE(first.Hit);
+    EXPECT_EQ(1u, first.ShapeId);
+    EXPECT_EQ(0u, first.EvictedShapeId);
+
+    CursorShapeLookup other = Lookup(cache, beam);
+    EXPECT_FALSE(other.Hit);
+    EXPECT_EQ(2u, other.ShapeId);
+    EXPECT_TRUE(other.Slot != first.Slot);
+
+    // 行尾填充不同、内容相同仍然命中
+    CursorShapeLookup again = Lookup(cache, arrow.WithPadding(64));
+    EXPECT_TRUE(again.Hit);
+    EXPECT_EQ(first.ShapeId, again.ShapeId);
+    EXPECT_EQ(first.Slot, again.Slot);
+
+    const CursorShapeCacheStats& stats = cache.Stats();
+    EXPECT_EQ(3u, stats.Lookups);
+    EXPECT_EQ(1u, stats.Hits);
+    EXPECT_EQ((uint64_t)(32 * 4 * 32 + 16 * 4 * 24), stats.UploadedBytes);
+
+    // 超过通道上限的形状被拒绝
+    const Shape huge(CursorMaxShapeSize + 1, 4, 3);
+    CursorShapeLookup rejected;
+    EXPECT_FALSE(cache.Lookup(huge.Info, huge.Pixels.data(), rejected));
+}
+
+TEST_CASE(CursorShapeCache_TypeAndSizeAreSeparateShapes)
+{
+    CursorShapeCache cache;
+    const Shape alpha(32, 64, 5);
+
+    Shape masked = alpha;
+    masked.Info.Type = CursorShapeType::MaskedColor;
+
+    // 字节完全相同，宽高互换
+    Shape transposed = alpha;
+    transposed.Info.Width = 64;
+    transposed.Info.Height = 32;
+    transposed.Info.Pitch = 256;
+
+    // 只差一个像素
+    Shape nearly = alpha;
+    nearly.Pixels[31 * 128 + 17] ^= 1;
+
+    const uint32_t id = Lookup(cache, alpha).ShapeId;
+    EXPECT_TRUE(Lookup(cache, masked).ShapeId != id);
+    EXPECT_TRUE(Lookup(cache, transposed).ShapeId != id);
+    EXPECT_TRUE(Lookup(cache, nearly).ShapeId != id);
+    EXPECT_EQ(0u, cache.Stats().Hits);
+}
+
+TEST_CASE(CursorShapeCache_EvictsLeastRecentlyUsed)
+{
+    CursorShapeCache cache(3);
+    EXPECT_EQ(3u, cache.Capacity());
+
+    const Shape a(32, 32, 10), b(32, 32, 11), c(32, 32, 12), d(32, 32, 13);
+    CursorShapeLookup la = Lookup(cache, a);
+    CursorShapeLookup lb = Lookup(cache, b);
+    Lookup(cache, c);
+    EXPECT_TRUE(Lookup(cache, a).Hit);
+
+    // b最久未用，d复用b的槽位
+    CursorShapeLookup ld = Lookup(cache, d);
+    EXPECT_FALSE(ld.Hit);
+    EXPECT_EQ(lb.ShapeId, ld.EvictedShapeId);
+    EXPECT_EQ(lb.Slot, ld.Slot);
+    EXPECT_EQ(1u, cache.Stats().Evictions);
+
+    EXPECT_TRUE(Lookup(cache, a).Hit);
+    EXPECT_EQ(la.ShapeId, Lookup(cache, a).ShapeId);
+
+    // 被淘汰的内容再次出现时分配新ID，不复用旧ID
+    CursorShapeLookup lb2 = Lookup(cache, b);
+    EXPECT_FALSE(lb2.Hit);
+    EXPECT_TRUE(lb2.ShapeId > ld.ShapeId);
+
+    // 清空后ID继续递增
+    cache.Clear();
+    CursorShapeLookup cleared = Lookup(cache, a);
+    EXPECT_FALSE(cleared.Hit);
+    EXPECT_TRUE(cleared.ShapeId > lb2.ShapeId);
+}
+
+TEST_CASE(CursorShapeCache_HashIsIdenticalAcrossSimdLevels)
+{
+    const CpuLevel levels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+    const uint32_t sizes[][2] = { { 1, 1 }, { 17, 5 }, { 32, 32 }, { 48, 48 }, { 256, 256 } };
+
+    for (const auto& size : sizes)
+    {
+        const Shape shape(size[0], size[1], size[0] * 7 + size[1], 12);
+        const uint64_t reference = CursorShapeCache(CursorShapeSlotCount, CpuLevel::Scalar).Hash(shape.Info, shape.Pixels.data());
+        for (CpuLevel level : levels)
+        {
+            EXPECT_EQ(reference, CursorShapeCache(CursorShapeSlotCount, level).Hash(shape.Info, shape.Pixels.data()));
+        }
+    }
+}
+
+TEST_CASE(CursorShapeCache_ConsumerReadsBitmapOnlyForNewIds)
+{
+    SharedMemoryRegion region(CursorChannelLayout::RequiredSize());
+    ASSERT_TRUE(CursorChannelProducer::Format(region.Writable(), region.Size()));
+
+    CursorChannelProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    CursorChannelConsumer consumer;
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    // 编辑器在箭头、I形、手形之间切换，缓存只放得下两个
+    const Shape shapes[] = { Shape(32, 32, 20), Shape(16, 32, 21), Shape(32, 32, 22) };
+    const int sequence[] = { 0, 1, 0, 1, 0, 1, 2, 0, 2, 0, 1, 1, 0 };
+    CursorShapeCache cache(2);
+    CursorStateTracker tracker;
+
+    std::map<uint32_t, int> known;              // 消费者已读取的缓存ID -> 形状
+    std::vector<uint8_t> pixels((size_t)CursorMaxShapeBytes);
+    uint32_t bitmapReads = 0;
+
+    for (int i = 0; i < (int)(sizeof(sequence) / sizeof(sequence[0])); i++)
+    {
+        const Shape& shape = shapes[sequence[i]];
+        CursorShapeLookup lookup = Lookup(cache, shape);
+        if (!lookup.Hit)
+        {
+            CursorShapeInfo info = shape.Info;
+            info.ShapeId = lookup.ShapeId;
+            ASSERT_TRUE(producer.PublishShape(lookup.Slot, info, shape.Pixels.data()));
+        }
+
+        const CursorShapeRef ref = { lookup.ShapeId, lookup.Slot, i, 0 };
+        CursorEvent event;
+        ASSERT_TRUE(tracker.Update(true, 100, 100, &ref, i, event));
+        producer.PublishEvent(event);
+
+        CursorEvent polled;
+        ASSERT_TRUE(consumer.Poll(&polled, 1) == 1);
+        EXPECT_EQ(i, polled.XHot);
+
+        if (known.find(polled.ShapeId) == known.end())
+        {
+            CursorShapeInfo info;
+            ASSERT_TRUE(consumer.ReadShape(polled.ShapeSlot, info, pixels.data()));
+            EXPECT_EQ(polled.ShapeId, info.ShapeId);
+            EXPECT_EQ(0, std::memcmp(shape.Pixels.data(), pixels.data(), shape.Pixels.size()));
+            known[polled.ShapeId] = sequence[i];
+            bitmapReads++;
+        }
+
+        EXPECT_EQ(sequence[i], known[polled.ShapeId]);
+    }
+
+    // 13次切换只有发布过的位图需要读取
+    EXPECT_EQ((uint32_t)(cache.Stats().Lookups - cache.Stats().Hits), bitmapReads);
+    EXPECT_TRUE(bitmapReads < 13);
+}
@@ -0,0 +1,370 @@
+/*++
+
+Module Name:
+    DirtyRectTraces.h
+
+Abstract:
+    典型桌面负载的脏矩形序列生成器（打字、滚动网页、拖动窗口、散点更新、视频播放），
+    按DWM的上报特征构造：大量小矩形、相互重叠、未对齐；
+    带移动区域的滚动序列（浏览器、IDE、平滑滚动）；
+    以及上报脏矩形与实际变化区域分开的序列（原样重绘、整窗无效化），用于按内容剔除的基准
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace DirtyRectTraces {
+
+using ExpandScreen::Pipeline::FrameMoveRegion;
+using ExpandScreen::Pipeline::FrameRect;
+using Frame = std::vector<FrameRect>;
+
+struct Trace
+{
+    const char* Name;
+    int32_t Width;
+    int32_t Height;
+    std::vector<Frame> Frames;
+};
+
+inline FrameRect Clip(FrameRect rect, int32_t width, int32_t height)
+{
+    if (rect.Left < 0) rect.Left = 0;
+    if (rect.Top < 0) rect.Top = 0;
+    if (rect.Right > width) rect.Right = width;
+    if (rect.Bottom > height) rect.Bottom = height;
+    return rect;
+}
+
+// 编辑器中打字：光标、新字形、整行重绘，偶尔状态栏
+inline Trace Typing(int32_t width, int32_t height, int frames, uint32_t seed = 1)
+{
+    std::mt19937 rng(seed);
+    Trace trace{ "typing", width, height, {} };
+    int32_t x = 120, y = 200;
+
+    for (int i = 0; i < frames; i++)
+    {
+        Frame frame;
+        frame.push_back({ x, y, x + 9, y + 19 });               // 新字形
+        frame.push_back({ x + 9, y + 1, x + 11, y + 18 });      // 光标
+        frame.push_back({ 100, y - 2, 100 + (int32_t)(rng() % 900) + 40, y + 21 });  // 行重绘
+        if (rng() % 4 == 0)
+        {
+            frame.push_back({ 0, height - 24, 320, height });   // 状态栏
+        }
+        if (rng() % 8 == 0)
+        {
+            frame.push_back({ width - 140, height - 40, width - 20, height - 8 });  // 时钟
+        }
+
+        x += 9;
+        if (x > 1100)
+        {
+            x = 120;
+            y += 20;
+            if (y > height - 100) y = 200;
+        }
+
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// 浏览器滚动：内容区多个重叠条带加侧边元素
+inline Trace WebScroll(int32_t width, int32_t height, int frames, uint32_t seed = 2)
+{
+    std::mt19937 rng(seed);
+    Trace trace{ "web-scroll", width, height, {} };
+    const int32_t left = width / 8, right = width - width / 8;
+
+    for (int i = 0; i < frames; i++)
+    {
+        Frame frame;
+        int bands = 20 + (int)(rng() % 40);
+        for (int b = 0; b < bands; b++)
+        {
+            int32_t top = 120 + (int32_t)(rng() % (uint32_t)(height - 200));
+            int32_t h = 8 + (int32_t)(rng() % 90);
+            int32_t l = left + (int32_t)(rng() % 200);
+            int32_t r = right - (int32_t)(rng() % 200);
+            frame.push_back(Clip({ l, top, r, top + h }, width, height));
+        }
+        frame.push_back({ right + 4, 120, right + 18, height - 20 });   // 滚动条
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// 拖动窗口：新旧位置两个大矩形加阴影边
+inline Trace WindowDrag(int32_t width, int32_t height, int frames, uint32_t seed = 3)
+{
+    std::mt19937 rng(seed);
+    Trace trace{ "window-drag", width, height, {} };
+    int32_t x = 100, y = 100;
+    const int32_t w = width / 3, h = height / 3;
+
+    for (int i = 0; i < frames; i++)
+    {
+        int32_t dx = (int32_t)(rng() % 13) - 4, dy = (int32_t)(rng() % 9) - 4;
+        Frame frame;
+        frame.push_back(Clip({ x - 12, y - 12, x + w + 12, y + h + 12 }, width, height));
+        x += dx;
+        y += dy;
+        frame.push_back(Clip({ x - 12, y - 12, x + w + 12, y + h + 12 }, width, height));
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// 散点：通知、托盘图标、多个小控件同时刷新
+inline Trace Scattered(int32_t width, int32_t height, int frames, uint32_t seed = 4)
+{
+    std::mt19937 rng(seed);
+    Trace trace{ "scattered", width, height, {} };
+
+    for (int i = 0; i < frames; i++)
+    {
+        Frame frame;
+        int count = 16 + (int)(rng() % 48);
+        for (int c = 0; c < count; c++)
+        {
+            int32_t l = (int32_t)(rng() % (uint32_t)width);
+            int32_t t = (int32_t)(rng() % (uint32_t)height);
+            int32_t w = 4 + (int32_t)(rng() % 60);
+            int32_t h = 4 + (int32_t)(rng() % 40);
+            frame.push_back(Clip({ l, t, l + w, t + h }, width, height));
+        }
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// 窗口内播放视频：画面区域每帧整体重绘，进度条与时间码约每秒更新一次
+inline Trace Video(int32_t width, int32_t height, int frames)
+{
+    Trace trace{ "video", width, height, {} };
+    const FrameRect picture = { width / 4, height / 4, width / 4 + width / 2, height / 4 + height / 2 };
+
+    for (int i = 0; i < frames; i++)
+    {
+        Frame frame;
+        frame.push_back(picture);
+        if (i % 60 == 0)
+        {
+            frame.push_back({ picture.Left, picture.Bottom + 8, picture.Right, picture.Bottom + 40 });
+        }
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+//
+// 带移动区域的帧：DWM对滚动的上报是一个移动区域加新露出的条带
+//
+struct MoveFrame
+{
+    Frame Dirty;
+    std::vector<FrameMoveRegion> Moves;
+};
+
+struct MoveTrace
+{
+    const char* Name;
+    int32_t Width;
+    int32_t Height;
+    std::vector<MoveFrame> Frames;
+};
+
+// 窗格内垂直滚动dy（正值向上滚动，内容上移），返回移动区域并追加露出的条带
+inline FrameMoveRegion ScrollPane(const FrameRect& pane, int32_t dy, Frame& dirty)
+{
+    if (dy > 0)
+    {
+        dirty.push_back({ pane.Left, pane.Bottom - dy, pane.Right, pane.Bottom });
+        return { pane.Left, pane.Top + dy, { pane.Left, pane.Top, pane.Right, pane.Bottom - dy } };
+    }
+
+    dirty.push_back({ pane.Left, pane.Top, pane.Right, pane.Top - dy });
+    return { pane.Left, pane.Top, { pane.Left, pane.Top - dy, pane.Right, pane.Bottom } };
+}
+
+// 浏览器滚轮滚动：内容区每帧移动一到三个滚轮刻度，滚动条与偶发的动画元素重绘
+inline MoveTrace BrowserScroll(int32_t width, int32_t height, int frames, uint32_t seed = 5)
+{
+    std::mt19937 rng(seed);
+    MoveTrace trace{ "browser-scroll", width, height, {} };
+    const FrameRect content = { 0, 140, width - 18, height - 40 };
+
+    for (int i = 0; i < frames; i++)
+    {
+        MoveFrame frame;
+        int32_t dy = 40 * (1 + (int32_t)(rng() % 3));
+        if ((i / 60) % 2 == 1)
+        {
+            dy = -dy;
+        }
+
+        frame.Moves.push_back(ScrollPane(content, dy, frame.Dirty));
+        frame.Dirty.push_back({ width - 18, 140, width, height - 40 });     // 滚动条
+        if (rng() % 5 == 0)
+        {
+            int32_t top = 200 + (int32_t)(rng() % (uint32_t)(height - 500));
+            frame.Dirty.push_back({ width / 2, top, width / 2 + 300, top + 250 });   // 动画图片
+        }
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// IDE按行滚动：编辑区与行号栏分别移动，小地图整体重绘
+inline MoveTrace IdeScroll(int32_t width, int32_t height, int frames, uint32_t seed = 6)
+{
+    std::mt19937 rng(seed);
+    MoveTrace trace{ "ide-scroll", width, height, {} };
+    const FrameRect gutter = { 300, 90, 360, height - 30 };
+    const FrameRect editor = { 360, 90, width - 140, height - 30 };
+
+    for (int i = 0; i < frames; i++)
+    {
+        MoveFrame frame;
+        int32_t dy = 20 * (1 + (int32_t)(rng() % 3));
+        if (rng() % 3 == 0)
+        {
+            dy = -dy;
+        }
+
+        frame.Moves.push_back(ScrollPane(gutter, dy, frame.Dirty));
+        frame.Moves.push_back(ScrollPane(editor, dy, frame.Dirty));
+        frame.Dirty.push_back({ width - 140, 90, width - 20, height - 30 });   // 小地图
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+// 触控板平滑滚动：每帧位移小，两个并排窗格交替滚动
+inline MoveTrace SmoothScroll(int32_t width, int32_t height, int frames, uint32_t seed = 7)
+{
+    std::mt19937 rng(seed);
+    MoveTrace trace{ "smooth-scroll", width, height, {} };
+    const FrameRect panes[2] =
+    {
+        { 0, 60, width / 2, height - 60 },
+        { width / 2, 60, width, height - 60 }
+    };
+
+    for (int i = 0; i < frames; i++)
+    {
+        MoveFrame frame;
+        int32_t dy = 2 + (int32_t)(rng() % 14);
+        frame.Moves.push_back(ScrollPane(panes[(i / 90) % 2], (i / 45) % 2 ? -dy : dy, frame.Dirty));
+        trace.Frames.push_back(frame);
+    }
+
+    return trace;
+}
+
+//
+// 上报与实际变化分开的帧：应用常把未变化的区域也重绘一遍，DWM照样上报为脏。
+// 坐标按3840x2160的帧给出
+//
+struct DamageTrace
+{
+    const char* Name;
+    std::vector<Frame> Dirty;       // DWM上报
+    std::vector<Frame> Changed;     // 实际变化
+};
+
+// 在rect内填入随机像素（BGRA），模拟实际变化的内容
+inline void FillRandom(std::vector<uint8_t>& frame, size_t pitch, const FrameRect& rect, std::mt19937& rng)
+{
+    for (int32_t y = rect.Top; y < rect.Bottom; y++)
+    {
+        uint32_t* row = reinterpret_cast<uint32_t*>(&frame[(size_t)y * pitch]);
+        for (int32_t x = rect.Left; x < rect.Right; x++)
+        {
+            row[x] = rng();
+        }
+    }
+}
+
+// 每帧重绘光标，每30帧（60Hz下500ms）才真正闪烁一次
+inline DamageTrace CaretRedraw(int frames)
+{
+    DamageTrace trace{ "caret-redraw", {}, {} };
+    const FrameRect caret = { 900, 600, 902, 620 };
+    for (int i = 0; i < frames; i++)
+    {
+        trace.Dirty.push_back({ caret });
+        trace.Changed.push_back(i % 30 == 0 ? Frame{ caret } : Frame{});
+    }
+    return trace;
+}
+
+// 应用每帧无效化整个窗口，实际只有进度条在前进
+inline DamageTrace WindowProgress(int frames)
+{
+    DamageTrace trace{ "window-progress", {}, {} };
+    const FrameRect window = { 400, 300, 2400, 1500 };
+    for (int i = 0; i < frames; i++)
+    {
+        int32_t x = 500 + (i * 3) % 1800;
+        trace.Dirty.push_back({ window });
+        trace.Changed.push_back({ { x, 1400, x + 3, 1420 } });
+    }
+    return trace;
+}
+
+// 整窗无效化，实际只有一行文字（日志追加、聊天消息）
+inline DamageTrace WindowTextLine(int frames)
+{
+    DamageTrace trace{ "window-textline", {}, {} };
+    const FrameRect window = { 400, 300, 2400, 1500 };
+    for (int i = 0; i < frames; i++)
+    {
+        int32_t y = 320 + (i * 18) % 1160;
+        trace.Dirty.push_back({ window });
+        trace.Changed.push_back({ { 420, y, 420 + 40 + (i * 37) % 1200, y + 16 } });
+    }
+    return trace;
+}
+
+// 打字：新字形与光标真正变化，整行重绘、状态栏和时钟多为原样
+inline DamageTrace TypingRedraw(int frames)
+{
+    DamageTrace trace{ "typing", {}, {} };
+    for (const Frame& frame : Typing(3840, 2160, frames).Frames)
+    {
+        trace.Dirty.push_back(frame);
+        trace.Changed.push_back({ frame[0], frame[1] });
+    }
+    return trace;
+}
+
+// 视频播放：区域内每帧全部变化，几乎没有可剔除的部分
+inline DamageTrace VideoPlayback(int frames)
+{
+    DamageTrace trace{ "video", {}, {} };
+    const FrameRect video = { 960, 540, 2880, 1620 };
+    for (int i = 0; i < frames; i++)
+    {
+        trace.Dirty.push_back({ video });
+        trace.Changed.push_back({ video });
+    }
+    return trace;
+}
+
+} // namespace DirtyRectTraces
@@ -0,0 +1,178 @@
+/*++
+
+Module Name:
+    DirtyRegionTests.cpp
+
+Abstract:
+    脏矩形合并引擎测试：覆盖性、互不重叠、对齐、数量上限与代价模型
+
+--*/
+
+#include "TestHarness.h"
+#include "DirtyRectTraces.h"
+#include "DirtyRegion.h"
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+bool Covers(const FrameRect* rects, uint32_t count, int32_t x, int32_t y)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (x >= rects[i].Left && x < rects[i].Right && y >= rects[i].Top && y < rects[i].Bottom)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 检查输出是否满足引擎的全部不变量
+void CheckInvariants(
+    const std::vector<FrameRect>& input,
+    const FrameRect* output,
+    uint32_t count,
+    const RegionCostModel& model,
+    int32_t width,
+    int32_t height)
+{
+    EXPECT_TRUE(count <= model.MaxRects);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const FrameRect& r = output[i];
+        EXPECT_FALSE(r.IsEmpty());
+        EXPECT_EQ(0, r.Left % model.TileSize);
+        EXPECT_EQ(0, r.Top % model.TileSize);
+        EXPECT_TRUE(r.Right % model.TileSize == 0 || r.Right == width);
+        EXPECT_TRUE(r.Bottom % model.TileSize == 0 || r.Bottom == height);
+
+        for (uint32_t j = i + 1; j < count; j++)
+        {
+            EXPECT_FALSE(RectsOverlap(r, output[j]));
+        }
+    }
+
+    // 输入矩形的四角与中心都必须被覆盖
+    for (const FrameRect& r : input)
+    {
+        if (r.IsEmpty())
+        {
+            continue;
+        }
+        EXPECT_TRUE(Covers(output, count, r.Left, r.Top));
+        EXPECT_TRUE(Covers(output, count, r.Right - 1, r.Bottom - 1));
+        EXPECT_TRUE(Covers(output, count, r.Right - 1, r.Top));
+        EXPECT_TRUE(Covers(output, count, r.Left, r.Bottom - 1));
+        EXPECT_TRUE(Covers(output, count, (r.Left + r.Right) / 2, (r.Top + r.Bottom) / 2));
+    }
+}
+
+} // namespace
+
+TEST_CASE(DirtyRegion_OverlappingRectsMergeToAlignedBounds)
+{
+    DirtyRegionCoalescer coalescer;
+    FrameRect input[] = { { 3, 3, 20, 20 }, { 10, 10, 30, 30 } };
+    FrameRect output[16];
+
+    uint32_t count = coalescer.Coalesce(input, 2, 1920, 1080, output, 16);
+
+    ASSERT_TRUE(count == 1);
+    EXPECT_TRUE(output[0] == (FrameRect{ 0, 0, 32, 32 }));
+}
+
+TEST_CASE(DirtyRegion_ClipsToFrameAndDropsEmpty)
+{
+    DirtyRegionCoalescer coalescer;
+    FrameRect input[] = { { 1900, 1070, 2000, 1200 }, { 50, 50, 50, 80 }, { -10, -10, -1, -1 } };
+    FrameRect output[16];
+
+    uint32_t count = coalescer.Coalesce(input, 3, 1920, 1080, output, 16);
+
+    ASSERT_TRUE(count == 1);
+    EXPECT_TRUE(output[0] == (FrameRect{ 1888, 1056, 1920, 1080 }));
+}
+
+TEST_CASE(DirtyRegion_PerRectCostControlsDistantMerges)
+{
+    FrameRect input[] = { { 0, 0, 16, 16 }, { 64, 0, 80, 16 } };
+    FrameRect output[16];
+
+    RegionCostModel cheapRects;
+    cheapRects.PerRectCost = 0;
+    DirtyRegionCoalescer separate(cheapRects);
+    EXPECT_EQ(2u, separate.Coalesce(input, 2, 256, 256, output, 16));
+
+    // 合并浪费3块（768像素），开销高于此时合并更划算
+    RegionCostModel expensiveRects;
+    expensiveRects.PerRectCost = 1024;
+    DirtyRegionCoalescer merged(expensiveRects);
+    EXPECT_EQ(1u, merged.Coalesce(input, 2, 256, 256, output, 16));
+    EXPECT_TRUE(output[0] == (FrameRect{ 0, 0, 80, 16 }));
+}
+
+TEST_CASE(DirtyRegion_MaxRectsIsHardBound)
+{
+    RegionCostModel model;
+    model.PerRectCost = 0;
+    model.MaxRects = 4;
+    DirtyRegionCoalescer coalescer(model);
+
+    std::vector<FrameRect> input;
+    for (int i = 0; i < 20; i++)
+    {
+        input.push_back({ i * 100, i * 50, i * 100 + 10, i * 50 + 10 });
+    }
+
+    FrameRect output[16];
+    uint32_t count = coalescer.Coalesce(input.data(), (uint32_t)input.size(), 2560, 1600, output, 16);
+
+    EXPECT_EQ(4u, count);
+    CheckInvariants(input, output, count, model, 2560, 1600);
+}
+
+TEST_CASE(DirtyRegion_StatsReportAreas)
+{
+    DirtyRegionCoalescer coalescer;
+    FrameRect input[] = { { 0, 0, 10, 10 }, { 0, 0, 10, 10 } };
+    FrameRect output[16];
+
+    coalescer.Coalesce(input, 2, 100, 100, output, 16);
+
+    EXPECT_EQ(2u, coalescer.LastStats().InputRects);
+    EXPECT_EQ(200, coalescer.LastStats().InputArea);
+    EXPECT_EQ(256, coalescer.LastStats().CoveredArea);
+    EXPECT_EQ(256, coalescer.LastStats().OutputArea);
+}
+
+TEST_CASE(DirtyRegion_TraceInvariantsHoldForAllTileSizes)
+{
+    const int32_t width = 2560, height = 1600;
+    std::vector<DirtyRectTraces::Trace> traces =
+    {
+        DirtyRectTraces::Typing(width, height, 50),
+        DirtyRectTraces::WebScroll(width, height, 50),
+        DirtyRectTraces::WindowDrag(width, height, 50),
+        DirtyRectTraces::Scattered(width, height, 50)
+    };
+
+    for (int32_t tileSize : { 16, 64 })
+    {
+        RegionCostModel model;
+        model.TileSize = tileSize;
+        DirtyRegionCoalescer coalescer(model);
+
+        for (const DirtyRectTraces::Trace& trace : traces)
+        {
+            for (const DirtyRectTraces::Frame& frame : trace.Frames)
+            {
+                FrameRect output[32];
+                uint32_t count = coalescer.Coalesce(
+                    frame.data(), (uint32_t)frame.size(), width, height, output, 32);
+                CheckInvariants(frame, output, count, model, width, height);
+            }
+        }
+    }
+}
@@ -0,0 +1,253 @@
+/*++
+
+Module Name:
+    DownscaleTests.cpp
+
+Abstract:
+    缩小测试：各SIMD内核与标量参考逐位一致（BGRA与NV12、整数倍盒式与任意比例、
+    含尾部），盒式块平均与纯色保持，只按损伤区域更新常驻目标与整帧缩小一致，
+    以及非法配置被拒绝
+
+--*/
+
+#include "TestHarness.h"
+#include "Downscale.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const CpuLevel AllLevels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+
+struct ScaleCase
+{
+    int32_t SourceWidth, SourceHeight;
+    int32_t TargetWidth, TargetHeight;
+    ScaleFilter Filter;
+};
+
+// 整数倍盒式、非整数倍盒式、任意比例（含SIMD尾部宽度）
+const ScaleCase Cases[] =
+{
+    { 160, 24, 80, 12, ScaleFilter::Box },
+    { 232, 24, 58, 6, ScaleFilter::Box },
+    { 180, 18, 60, 6, ScaleFilter::Box },
+    { 200, 30, 134, 20, ScaleFilter::Bilinear },
+    { 202, 32, 96, 14, ScaleFilter::Bilinear },
+    { 200, 30, 134, 20, ScaleFilter::Lanczos2 },
+    { 256, 40, 86, 14, ScaleFilter::Lanczos2 },
+    { 64, 64, 64, 64, ScaleFilter::Lanczos2 },
+};
+
+struct Image
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;
+    std::vector<uint8_t> Bytes;
+
+    // BGRA：每像素4字节；NV12：Y平面后接UV平面，行距相同
+    Image(PixelFormat format, int32_t width, int32_t height, size_t padding = 0)
+        : Width(width), Height(height),
+          Pitch((size_t)width * (format == PixelFormat::Bgra8 ? 4 : 1) + padding),
+          Bytes(Pitch * (size_t)height * (format == PixelFormat::Bgra8 ? 2 : 3) / 2, 0xCD)
+    {
+    }
+
+    Nv12Surface Surface()
+    {
+        return { Bytes.data(), Pitch, Bytes.data() + Pitch * (size_t)Height, Pitch };
+    }
+
+    void Randomize(uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        for (uint8_t& b : Bytes)
+        {
+            b = (uint8_t)rng();
+        }
+    }
+};
+
+void ScaleFrame(Downscaler& scaler, PixelFormat format, Image& source, Image& target)
+{
+    if (format == PixelFormat::Bgra8)
+    {
+        scaler.ScaleBgraFrame(source.Bytes.data(), source.Pitch, target.Bytes.data(), target.Pitch);
+    }
+    else
+    {
+        scaler.ScaleNv12Frame(source.Surface(), target.Surface());
+    }
+}
+
+FrameRect ScaleRect(Downscaler& scaler, PixelFormat format, Image& source, Image& target, const FrameRect& rect)
+{
+    if (format == PixelFormat::Bgra8)
+    {
+        return scaler.ScaleBgra(source.Bytes.data(), source.Pitch, target.Bytes.data(), target.Pitch, rect);
+    }
+
+    return scaler.ScaleNv12(source.Surface(), target.Surface(), rect);
+}
+
+} // namespace
+
+TEST_CASE(Downscale_AllKernelsMatchScalarReference)
+{
+    for (PixelFormat format : { PixelFormat::Bgra8, PixelFormat::Nv12 })
+    {
+        for (const ScaleCase& c : Cases)
+        {
+            Image source(format, c.SourceWidth, c.SourceHeight, 12);
+            source.Randomize((uint32_t)(c.SourceWidth * 31 + c.TargetWidth));
+
+            Downscaler reference;
+            ASSERT_TRUE(reference.Configure(format, c.SourceWidth, c.SourceHeight, c.TargetWidth, c.TargetHeight,
+                c.Filter, CpuLevel::Scalar));
+            Image expected(format, c.TargetWidth, c.TargetHeight, 6);
+            ScaleFrame(reference, format, source, expected);
+
+            for (CpuLevel level : AllLevels)
+            {
+                Downscaler scaler;
+                ASSERT_TRUE(scaler.Configure(format, c.SourceWidth, c.SourceHeight, c.TargetWidth, c.TargetHeight,
+                    c.Filter, level));
+                Image actual(format, c.TargetWidth, c.TargetHeight, 6);
+                ScaleFrame(scaler, format, source, actual);
+                EXPECT_TRUE(actual.Bytes == expected.Bytes);
+            }
+        }
+    }
+}
+
+TEST_CASE(Downscale_BoxAveragesBlocksAndFiltersKeepSolidColor)
+{
+    // 4x4 BGRA块内B通道取0..15，平均7.5向上舍入为8；2:1时左上2x2块为(0+1+4+5)/4=2.5->3
+    Image source(PixelFormat::Bgra8, 4, 4);
+    for (int32_t y = 0; y < 4; y++)
+    {
+        for (int32_t x = 0; x < 4; x++)
+        {
+            uint8_t* p = &source.Bytes[(size_t)y * source.Pitch + (size_t)x * 4];
+            p[0] = (uint8_t)(y * 4 + x);
+            p[1] = 200;
+            p[2] = 0;
+            p[3] = 255;
+        }
+    }
+
+    for (CpuLevel level : AllLevels)
+    {
+        Downscaler quarter;
+        ASSERT_TRUE(quarter.Configure(PixelFormat::Bgra8, 4, 4, 1, 1, ScaleFilter::Box, level));
+        Image one(PixelFormat::Bgra8, 1, 1);
+        ScaleFrame(quarter, PixelFormat::Bgra8, source, one);
+        EXPECT_EQ(8, one.Bytes[0]);
+        EXPECT_EQ(200, one.Bytes[1]);
+
+        Downscaler half;
+        ASSERT_TRUE(half.Configure(PixelFormat::Bgra8, 4, 4, 2, 2, ScaleFilter::Box, level));
+        Image two(PixelFormat::Bgra8, 2, 2);
+        ScaleFrame(half, PixelFormat::Bgra8, source, two);
+        EXPECT_EQ(3, two.Bytes[0]);
+        EXPECT_EQ(255, two.Bytes[3]);
+    }
+
+    // 权重和精确为1：纯色经任何滤波器（含Lanczos负瓣）都保持不变
+    for (ScaleFilter filter : { ScaleFilter::Box, ScaleFilter::Bilinear, ScaleFilter::Lanczos2 })
+    {
+        Image solid(PixelFormat::Nv12, 190, 46);
+        std::fill(solid.Bytes.begin(), solid.Bytes.end(), (uint8_t)173);
+
+        Downscaler scaler;
+        ASSERT_TRUE(scaler.Configure(PixelFormat::Nv12, 190, 46, 74, 18, filter));
+        Image target(PixelFormat::Nv12, 74, 18);
+        ScaleFrame(scaler, PixelFormat::Nv12, solid, target);
+        for (uint8_t b : target.Bytes)
+        {
+            ASSERT_TRUE(b == 173);
+        }
+    }
+}
+
+TEST_CASE(Downscale_DamagedRegionMatchesFullRescale)
+{
+    std::mt19937 rng(5);
+
+    for (PixelFormat format : { PixelFormat::Bgra8, PixelFormat::Nv12 })
+    {
+        for (const ScaleCase& c : Cases)
+        {
+            Downscaler scaler;
+            ASSERT_TRUE(scaler.Configure(format, c.SourceWidth, c.SourceHeight, c.TargetWidth, c.TargetHeight, c.Filter));
+
+            Image source(format, c.SourceWidth, c.SourceHeight);
+            source.Randomize(1);
+            Image persistent(format, c.TargetWidth, c.TargetHeight);
+            ScaleFrame(scaler, format, source, persistent);
+
+            for (int frame = 0; frame < 6; frame++)
+            {
+                // 随机损伤区域，改写其中的像素（NV12同时改写对应的UV）
+                const int32_t left = (int32_t)(rng() % (uint32_t)c.SourceWidth);
+                const int32_t top = (int32_t)(rng() % (uint32_t)c.SourceHeight);
+                const FrameRect damage = IntersectRect(
+                    { left, top, left + 1 + (int32_t)(rng() % 40), top + 1 + (int32_t)(rng() % 12) },
+                    { 0, 0, c.SourceWidth, c.SourceHeight });
+
+                const FrameRect written = format == PixelFormat::Nv12 ?
+                    AlignToChroma(damage, c.SourceWidth, c.SourceHeight) : damage;
+                const size_t bytesPerPixel = format == PixelFormat::Bgra8 ? 4 : 1;
+                for (int32_t y = written.Top; y < written.Bottom; y++)
+                {
+                    for (size_t b = written.Left * bytesPerPixel; b < written.Right * bytesPerPixel; b++)
+                    {
+                        source.Bytes[(size_t)y * source.Pitch + b] = (uint8_t)rng();
+                        if (format == PixelFormat::Nv12)
+                        {
+                            source.Bytes[((size_t)c.SourceHeight + y / 2) * source.Pitch + b] = (uint8_t)rng();
+                        }
+                    }
+                }
+
+                const FrameRect updated = ScaleRect(scaler, format, source, persistent, damage);
+                EXPECT_TRUE(updated == scaler.MapRect(damage));
+                EXPECT_FALSE(updated.IsEmpty());
+
+                Image full(format, c.TargetWidth, c.TargetHeight);
+                ScaleFrame(scaler, format, source, full);
+                ASSERT_TRUE(persistent.Bytes == full.Bytes);
+            }
+
+            // 小损伤区域只影响局部
+            if (c.TargetWidth < c.SourceWidth)
+            {
+                const FrameRect mapped = scaler.MapRect({ 10, 4, 12, 6 });
+                EXPECT_TRUE(mapped.Area() * 4 < (int64_t)c.TargetWidth * c.TargetHeight);
+            }
+        }
+    }
+}
+
+TEST_CASE(Downscale_RejectsInvalidConfigurations)
+{
+    Downscaler scaler;
+    EXPECT_FALSE(scaler.Configure(PixelFormat::Bgra8, 640, 480, 1280, 960, ScaleFilter::Bilinear));   // 放大
+    EXPECT_FALSE(scaler.Configure(PixelFormat::Bgra8, 640, 480, 0, 240, ScaleFilter::Bilinear));
+    EXPECT_FALSE(scaler.Configure(PixelFormat::Nv12, 640, 480, 319, 240, ScaleFilter::Bilinear));     // NV12奇数
+    EXPECT_FALSE(scaler.Configure(PixelFormat::P010, 640, 480, 320, 240, ScaleFilter::Box));
+    EXPECT_FALSE(scaler.IsValid());
+
+    // 未配置时不写目标
+    std::vector<uint8_t> source(640 * 4 * 4, 1), target(16, 0xCD);
+    EXPECT_TRUE(scaler.ScaleBgra(source.data(), 640 * 4, target.data(), 16, { 0, 0, 640, 4 }).IsEmpty());
+    EXPECT_EQ(0xCD, target[0]);
+
+    EXPECT_TRUE(scaler.Configure(PixelFormat::Nv12, 2560, 1600, 1280, 800, ScaleFilter::Box));
+    EXPECT_TRUE(scaler.IsValid());
+    EXPECT_TRUE(scaler.Format() == PixelFormat::Nv12);
+}
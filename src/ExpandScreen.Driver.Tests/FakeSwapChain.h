@@ -0,0 +1,136 @@
+/*++
+
+Module Name:
+    FakeSwapChain.h
+
+Abstract:
+    模拟IddCx交换链：生产者线程调用Present提交帧并触发自动重置事件，
+    FrameWorkerLoop通过Acquire/Release/Wait消费
+
+--*/
+
+#pragma once
+
+#include "FrameWorker.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+class FakeSwapChain
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame
+    {
+        uint64_t FrameNumber;
+        Clock::time_point PresentTime;
+    };
+
+    // 生产者提交一帧并触发新帧事件
+    void Present()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Queue.push_back({ m_NextFrameNumber++, Clock::now() });
+        m_FrameEvent = true;
+        m_Condition.notify_one();
+    }
+
+    void RequestTerminate()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_TerminateEvent = true;
+        m_Condition.notify_one();
+    }
+
+    // 模拟设备丢失：之后的Acquire全部失败
+    void Invalidate()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Invalid = true;
+        m_FrameEvent = true;
+        m_Condition.notify_one();
+    }
+
+    ExpandScreen::Pipeline::AcquireResult Acquire(Frame& frame)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+
+        if (m_Invalid)
+        {
+            return ExpandScreen::Pipeline::AcquireResult::Failed;
+        }
+
+        if (m_Queue.empty())
+        {
+            return ExpandScreen::Pipeline::AcquireResult::Pending;
+        }
+
+        frame = m_Queue.front();
+        m_Queue.pop_front();
+        m_Outstanding++;
+        return ExpandScreen::Pipeline::AcquireResult::Acquired;
+    }
+
+    void Release(Frame&)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Outstanding--;
+        m_Released++;
+    }
+
+    ExpandScreen::Pipeline::WaitResult Wait()
+    {
+        std::unique_lock<std::mutex> lock(m_Lock);
+
+        bool signaled = m_Condition.wait_for(lock, m_WaitTimeout,
+            [this] { return m_FrameEvent || m_TerminateEvent; });
+
+        if (!signaled)
+        {
+            return ExpandScreen::Pipeline::WaitResult::Timeout;
+        }
+
+        // 与WaitForMultipleObjects一致：新帧事件优先，自动重置
+        if (m_FrameEvent)
+        {
+            m_FrameEvent = false;
+            return ExpandScreen::Pipeline::WaitResult::FrameAvailable;
+        }
+
+        m_TerminateEvent = false;
+        return ExpandScreen::Pipeline::WaitResult::Terminate;
+    }
+
+    void SetWaitTimeout(std::chrono::milliseconds timeout)
+    {
+        m_WaitTimeout = timeout;
+    }
+
+    int Outstanding()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Outstanding;
+    }
+
+    uint64_t Released()
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        return m_Released;
+    }
+
+private:
+    std::mutex m_Lock;
+    std::condition_variable m_Condition;
+    std::deque<Frame> m_Queue;
+    uint64_t m_NextFrameNumber = 1;
+    uint64_t m_Released = 0;
+    int m_Outstanding = 0;
+    bool m_FrameEvent = false;
+    bool m_TerminateEvent = false;
+    bool m_Invalid = false;
+    std::chrono::milliseconds m_WaitTimeout{ 100 };
+};
@@ -0,0 +1,172 @@
+/*++
+
+Module Name:
+    FrameAllocationTests.cpp
+
+Abstract:
+    完整的每帧处理路径（损伤合并、逐像素比较、脏区域合并、增量NV12转换、
+    从池中取缓冲交给消费者）在稳态下不调用堆分配器
+
+    本文件替换了全局operator new/delete以统计堆分配次数，因此单独编译为
+    ExpandScreen.Driver.AllocationTests，不影响其他测试使用的分配器。
+    只在g_CountAllocations置位期间计数，替换本身不改变分配行为
+
+--*/
+
+#include "TestHarness.h"
+#include "DirtyRectTraces.h"
+#include "DirtyRegion.h"
+#include "FrameDiff.h"
+#include "FramePacer.h"
+#include "FramePool.h"
+#include "IncrementalConvert.h"
+#include "MoveRegion.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> g_CountAllocations(false);
+std::atomic<uint64_t> g_HeapAllocations(0);
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    if (g_CountAllocations.load(std::memory_order_relaxed))
+    {
+        g_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size != 0 ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+using namespace ExpandScreen::Pipeline;
+
+TEST_CASE(FrameAllocation_SteadyStateFramesDoNotAllocate)
+{
+    // 与驱动相同的每帧路径：合并待发布损伤 -> 逐像素比较 -> 脏区域合并 ->
+    // 增量NV12转换 -> 从池中取缓冲并补拷损伤 -> 交给消费者（消费者持有最近两帧）
+    const int32_t width = 1280, height = 720;
+    const size_t pitch = (size_t)width * 4;
+    const int frames = 120;
+
+    DirtyRectTraces::Trace typing = DirtyRectTraces::Typing(width, height, frames);
+    DirtyRectTraces::MoveTrace scroll = DirtyRectTraces::IdeScroll(width, height, frames);
+
+    std::vector<uint8_t> screen(pitch * height, 0x40);
+    FrameBufferPool pool;
+    ASSERT_TRUE(pool.Configure(PixelFormat::Nv12, width, height, 4));
+    FrameArena arena;
+    FrameDamageAccumulator damage;
+    FrameDiffer differ;
+    DirtyRegionCoalescer coalescer;
+    IncrementalNv12Converter nv12;
+    std::vector<FrameRect> changed;
+    uint64_t bufferFrame[FrameBufferPool::MaxBuffers] = {};
+    FrameBufferRef consumerHeld[2];
+    std::mt19937 rng(3);
+    uint64_t frameNumber = 0;
+    bool ok = true;
+
+    auto runFrame = [&](const DirtyRectTraces::Frame& dirty, const std::vector<FrameMoveRegion>& moves)
+    {
+        arena.Reset();
+        int64_t* timestamps = arena.Allocate<int64_t>(4);
+        FrameRect* rects = arena.Copy(dirty.data(), dirty.size());
+        FrameMoveRegion* moveRects = arena.Copy(moves.data(), moves.size());
+        ok = ok && timestamps != nullptr && rects != nullptr && moveRects != nullptr;
+        timestamps[0] = (int64_t)frameNumber;
+
+        ApplyMoveRegions(screen.data(), (uint32_t)pitch, 4, moveRects, (uint32_t)moves.size(), width, height);
+        for (size_t i = 0; i < dirty.size(); i++)
+        {
+            const FrameRect rect = IntersectRect(rects[i], { 0, 0, width, height });
+            for (int32_t y = rect.Top; y < rect.Bottom; y += 3)
+            {
+                std::memset(&screen[(size_t)y * pitch + (size_t)rect.Left * 4], (int)(rng() & 0xFF),
+                    (size_t)rect.Width() * 4);
+            }
+        }
+
+        damage.Add(rects, (uint32_t)dirty.size(), moveRects, (uint32_t)moves.size());
+        differ.Diff(screen.data(), pitch, width, height, damage.Dirty().data(), (uint32_t)damage.Dirty().size(),
+            damage.Moves().data(), (uint32_t)damage.Moves().size(), changed);
+
+        FrameRect* coalesced = arena.Allocate<FrameRect>(64);
+        ok = ok && coalesced != nullptr;
+        const uint32_t count = coalescer.Coalesce(
+            changed.data(), (uint32_t)changed.size(), width, height, coalesced, 64);
+
+        nv12.Update(screen.data(), pitch, width, height, coalesced, count,
+            damage.Moves().data(), (uint32_t)damage.Moves().size(), ++frameNumber);
+
+        FrameBufferRef buffer = pool.TryAcquire();
+        ok = ok && (bool)buffer;
+        if (buffer)
+        {
+            const Nv12Surface surface = { buffer.Data(), buffer.Layout().Pitch, buffer.Chroma(), buffer.Layout().Pitch };
+            nv12.CopyTo(surface, bufferFrame[buffer.Index()]);
+            bufferFrame[buffer.Index()] = frameNumber;
+            consumerHeld[frameNumber % 2] = std::move(buffer);
+        }
+
+        damage.Clear();
+    };
+
+    // 第一遍让各阶段的容器增长到高水位，第二遍重放同样的负载并计数
+    for (int pass = 0; pass < 2; pass++)
+    {
+        g_HeapAllocations.store(0);
+        g_CountAllocations.store(pass == 1);
+        for (int i = 0; i < frames; i++)
+        {
+            runFrame(typing.Frames[(size_t)i], {});
+            runFrame(scroll.Frames[(size_t)i].Dirty, scroll.Frames[(size_t)i].Moves);
+        }
+        g_CountAllocations.store(false);
+
+        if (pass == 1)
+        {
+            EXPECT_EQ(0u, g_HeapAllocations.load());
+        }
+    }
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(0u, arena.Overflows());
+    EXPECT_EQ(0u, pool.Stats().Exhausted);
+    EXPECT_EQ(4u, pool.Stats().Allocations);
+}
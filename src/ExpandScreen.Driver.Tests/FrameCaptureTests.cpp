@@ -0,0 +1,414 @@
+/*++
+
+Module Name:
+    FrameCaptureTests.cpp
+
+Abstract:
+    帧录制测试：打字、滚动与整帧切换组成的会话录制后按记录顺序逐像素还原（无损与
+    原始补丁），尺寸变化、损伤未知、漏记之后写关键帧，空间不足的记录被丢弃而之前
+    的记录仍可回放；未提交、越界与篡改的记录读取或还原失败；同一录制多次回放
+    （不同工作线程数）的发布结果摘要相同
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "ScreenContent.h"
+#include "FrameCapture.h"
+#include "Replay/FrameReplay.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+const int64_t Period = TicksPerSecond / 60;
+const int32_t Width = 640;
+const int32_t Height = 360;
+
+struct Present
+{
+    std::vector<uint8_t> Pixels;
+    std::vector<FrameRect> Dirty;
+    std::vector<FrameMoveRegion> Moves;
+    bool DamageKnown = true;
+};
+
+//
+// 编辑区向上滚动一行：目标区域从下方一行处移动过来，露出的最后一行重绘
+//
+void Scroll(ScreenContent::Canvas& canvas, const FrameRect& area, int32_t lineHeight)
+{
+    for (int32_t y = area.Top; y < area.Bottom - lineHeight; y++)
+    {
+        for (int32_t x = area.Left; x < area.Right; x++)
+        {
+            canvas.At(x, y) = canvas.At(x, y + lineHeight);
+        }
+    }
+    canvas.Fill(area.Left, area.Bottom - lineHeight, area.Right, area.Bottom, 0xFFFFFFFFu);
+    canvas.Text(area.Left, area.Bottom - lineHeight, area.Right, 1, 0xFF000000u, 77);
+}
+
+//
+// 典型会话：IDE中打字，滚动一次，重复提交未变化的内容，再切换到网页
+//
+std::vector<Present> Session()
+{
+    std::vector<Present> presents;
+    ScreenContent::Canvas screen = ScreenContent::DrawIde(Width, Height);
+
+    Present first;
+    first.Pixels = screen.Bytes();
+    first.Dirty.push_back({ 0, 0, Width, Height });
+    presents.push_back(first);
+
+    for (int32_t i = 0; i < 12; i++)
+    {
+        const FrameRect glyph = { 360 + i * 8, 62, 368 + i * 8, 80 };
+        screen.Fill(glyph.Left, glyph.Top, glyph.Right, glyph.Bottom, 0xFFFFFFFFu);
+        screen.Fill(glyph.Left + 1, glyph.Top + 3, glyph.Right - 2, glyph.Bottom - 3, 0xFF1E1E1Eu + (uint32_t)i);
+
+        Present present;
+        present.Pixels = screen.Bytes();
+        present.Dirty.push_back(glyph);
+        presents.push_back(present);
+    }
+
+    const FrameRect editor = { 360, 44, 620, 314 };
+    Scroll(screen, editor, 18);
+    Present scroll;
+    scroll.Pixels = screen.Bytes();
+    scroll.Moves.push_back({ editor.Left, editor.Top + 18, { editor.Left, editor.Top, editor.Right, editor.Bottom - 18 } });
+    scroll.Dirty.push_back({ editor.Left, editor.Bottom - 18, editor.Right, editor.Bottom });
+    presents.push_back(scroll);
+
+    // DWM重复提交，上报的区域内容未变化
+    for (int32_t i = 0; i < 3; i++)
+    {
+        Present repeat;
+        repeat.Pixels = screen.Bytes();
+        repeat.Dirty.push_back(editor);
+        presents.push_back(repeat);
+    }
+
+    int32_t photo[4];
+    Present page;
+    page.Pixels = ScreenContent::DrawWebPage(Width, Height, photo).Bytes();
+    page.DamageKnown = false;
+    presents.push_back(page);
+
+    return presents;
+}
+
+CaptureFrameRecord MakeRecord(int32_t width, int32_t height, int64_t time, uint64_t number)
+{
+    CaptureFrameRecord record = {};
+    record.Width = (uint32_t)width;
+    record.Height = (uint32_t)height;
+    record.PresentTime = time;
+    record.AcquireTime = time + 1000;
+    record.PresentFrameNumber = number;
+    return record;
+}
+
+//
+// 每个刷新周期提交一次，每两次提交之间有一次光标移动
+//
+void Record(FrameCaptureWriter& writer, const std::vector<Present>& presents)
+{
+    for (size_t i = 0; i < presents.size(); i++)
+    {
+        const Present& present = presents[i];
+        const int64_t time = Period * (int64_t)(i + 1);
+        writer.WriteFrame(
+            MakeRecord(Width, Height, time, i + 1),
+            present.Pixels.data(),
+            (size_t)Width * 4,
+            present.Dirty.data(),
+            (uint32_t)present.Dirty.size(),
+            present.Moves.data(),
+            (uint32_t)present.Moves.size(),
+            present.DamageKnown);
+
+        CursorEvent event = {};
+        event.Flags = CursorEventPosition;
+        event.Visible = 1;
+        event.X = 400 + (int32_t)i;
+        event.Y = 100;
+        event.Time = time + Period / 2;
+        writer.WriteCursor(event);
+    }
+}
+
+const uint64_t CaptureSize = 16ull << 20;
+
+} // namespace
+
+TEST_CASE(FrameCapture_ReplayReproducesEveryPresent)
+{
+    const std::vector<Present> presents = Session();
+
+    for (CapturePatchEncoding encoding : { CapturePatchEncoding::Lossless, CapturePatchEncoding::Raw })
+    {
+        SharedMemoryRegion memory((size_t)CaptureSize);
+        ASSERT_TRUE(memory.IsValid());
+        ASSERT_TRUE(FrameCaptureWriter::Format(memory.Writable(), CaptureSize, 0, TicksPerSecond, 60, 1));
+
+        FrameCaptureWriter writer;
+        ASSERT_TRUE(writer.Attach(memory.Writable(), CaptureSize));
+        writer.SetEncoding(encoding);
+        Record(writer, presents);
+
+        // 第一帧与损伤未知的网页是关键帧，其余只存变化的像素
+        const FrameCaptureStats& stats = writer.Stats();
+        EXPECT_EQ((uint64_t)presents.size(), stats.Frames);
+        EXPECT_EQ(2u, (uint32_t)stats.Keyframes);
+        EXPECT_EQ(0u, (uint32_t)writer.DroppedRecords());
+        EXPECT_TRUE(stats.PatchPixelBytes < (uint64_t)Width * Height * 4 * presents.size() / 4);
+        if (encoding == CapturePatchEncoding::Lossless)
+        {
+            EXPECT_TRUE(stats.StoredBytes < stats.PatchPixelBytes / 2);
+        }
+
+        FrameCaptureReader reader;
+        ASSERT_TRUE(reader.Attach(memory.ReadOnly(), writer.UsedSize()));
+        EXPECT_EQ(TicksPerSecond, reader.Header().TicksPerSecond);
+        EXPECT_EQ((uint32_t)presents.size() * 2, reader.RecordCount());
+
+        CaptureFrameCanvas canvas;
+        size_t frame = 0;
+        uint32_t cursors = 0;
+        for (uint32_t i = 0; i < reader.RecordCount(); i++)
+        {
+            CaptureRecordView record;
+            ASSERT_TRUE(reader.Record(i, record));
+
+            CaptureFrameView view;
+            CursorEvent event;
+            if (FrameCaptureReader::ParseFrame(record, view))
+            {
+                ASSERT_TRUE(frame < presents.size());
+                const Present& present = presents[frame];
+                EXPECT_EQ(Period * (int64_t)(frame + 1) + 1000, record.Time);
+                EXPECT_EQ((uint64_t)frame + 1, view.Frame.PresentFrameNumber);
+                EXPECT_EQ((uint32_t)present.Dirty.size() * (present.DamageKnown ? 1 : 0), view.Frame.DirtyRectCount);
+                EXPECT_EQ((uint32_t)present.Moves.size(), view.Frame.MoveRegionCount);
+                EXPECT_EQ(present.DamageKnown ? 0u : CaptureFrameDamageUnknown, view.Frame.Flags & CaptureFrameDamageUnknown);
+
+                ASSERT_TRUE(canvas.Apply(view));
+                ASSERT_TRUE(canvas.Width() == Width && canvas.Height() == Height);
+                EXPECT_TRUE(std::memcmp(canvas.Pixels(), present.Pixels.data(), present.Pixels.size()) == 0);
+                frame++;
+            }
+            else
+            {
+                ASSERT_TRUE(FrameCaptureReader::ParseCursor(record, event));
+                EXPECT_EQ(400 + (int32_t)frame - 1, event.X);
+                cursors++;
+            }
+        }
+        EXPECT_EQ(presents.size(), frame);
+        EXPECT_EQ((uint32_t)presents.size(), cursors);
+    }
+}
+
+TEST_CASE(FrameCapture_KeyframesAndFullFile)
+{
+    const std::vector<uint8_t> ide = ScreenContent::DrawIde(Width, Height).Bytes();
+    const std::vector<uint8_t> small = ScreenContent::DrawSettings(320, 240).Bytes();
+    const FrameRect dirty = { 10, 10, 50, 30 };
+
+    // 原始补丁便于按像素数计算空间：数据区只够一个整帧和一个小补丁
+    const uint64_t dataOffset = FrameCaptureLayout::DataOffset(FrameCaptureLayout::DefaultMaxRecords(0));
+    const uint64_t size = dataOffset + (uint64_t)Width * Height * 4 + 4096 + 2048;
+    SharedMemoryRegion memory((size_t)size);
+    ASSERT_TRUE(memory.IsValid());
+    ASSERT_TRUE(FrameCaptureWriter::Format(memory.Writable(), size, 0, TicksPerSecond, 60, 1));
+
+    FrameCaptureWriter writer;
+    ASSERT_TRUE(writer.Attach(memory.Writable(), size));
+    writer.SetEncoding(CapturePatchEncoding::Raw);
+
+    EXPECT_TRUE(writer.WriteFrame(MakeRecord(Width, Height, Period, 1), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true));
+    EXPECT_TRUE(writer.WriteFrame(MakeRecord(Width, Height, Period * 2, 2), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true));
+    EXPECT_EQ(1u, (uint32_t)writer.Stats().Keyframes);
+
+    // 尺寸变化需要关键帧，数据区不足而丢弃；之后的记录也放不下
+    EXPECT_FALSE(writer.WriteFrame(MakeRecord(320, 240, Period * 3, 3), small.data(), 320 * 4, &dirty, 1, nullptr, 0, true));
+    CursorEvent event = {};
+    event.Time = Period * 3;
+    EXPECT_FALSE(writer.WriteCursor(event));
+    EXPECT_EQ(1u, (uint32_t)writer.Stats().DroppedFrames);
+    EXPECT_EQ(2u, (uint32_t)writer.DroppedRecords());
+    EXPECT_TRUE(writer.UsedSize() <= size);
+
+    FrameCaptureReader reader;
+    ASSERT_TRUE(reader.Attach(memory.ReadOnly(), size));
+    EXPECT_EQ(4u, reader.RecordCount());
+    CaptureRecordView record;
+    EXPECT_TRUE(reader.Record(0, record));
+    EXPECT_TRUE(reader.Record(1, record));
+    EXPECT_FALSE(reader.Record(2, record));
+    EXPECT_FALSE(reader.Record(3, record));
+    EXPECT_FALSE(reader.Record(4, record));
+
+    // 漏记或损伤未知的提交之后写关键帧
+    SharedMemoryRegion large((size_t)CaptureSize);
+    ASSERT_TRUE(large.IsValid());
+    ASSERT_TRUE(FrameCaptureWriter::Format(large.Writable(), CaptureSize, 0, TicksPerSecond, 0, 0));
+    ASSERT_TRUE(writer.Attach(large.Writable(), CaptureSize));
+    ASSERT_TRUE(reader.Attach(large.ReadOnly(), CaptureSize));
+
+    writer.WriteFrame(MakeRecord(Width, Height, Period, 1), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true);
+    writer.WriteFrame(MakeRecord(Width, Height, Period * 2, 2), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true);
+    writer.RequestKeyframe();
+    writer.WriteFrame(MakeRecord(Width, Height, Period * 3, 3), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true);
+    writer.WriteFrame(MakeRecord(Width, Height, Period * 4, 4), ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, false);
+    writer.WriteFrame(MakeRecord(320, 240, Period * 5, 5), small.data(), 320 * 4, &dirty, 1, nullptr, 0, true);
+
+    const uint32_t expected[] = {
+        CaptureFrameKeyframe, 0, CaptureFrameKeyframe, CaptureFrameKeyframe | CaptureFrameDamageUnknown, CaptureFrameKeyframe
+    };
+    ASSERT_TRUE(reader.RecordCount() == 5);
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        CaptureFrameView view;
+        ASSERT_TRUE(reader.Record(i, record) && FrameCaptureReader::ParseFrame(record, view));
+        EXPECT_EQ(expected[i], view.Frame.Flags);
+    }
+}
+
+TEST_CASE(FrameCapture_ReaderRejectsInvalidRecords)
+{
+    const std::vector<uint8_t> ide = ScreenContent::DrawIde(Width, Height).Bytes();
+    const FrameRect dirty = { 360, 62, 420, 80 };
+
+    SharedMemoryRegion memory((size_t)CaptureSize);
+    ASSERT_TRUE(memory.IsValid());
+    ASSERT_TRUE(FrameCaptureWriter::Format(memory.Writable(), CaptureSize, 0, TicksPerSecond, 60, 1));
+    FrameCaptureWriter writer;
+    ASSERT_TRUE(writer.Attach(memory.Writable(), CaptureSize));
+    for (int64_t i = 0; i < 4; i++)
+    {
+        writer.WriteFrame(MakeRecord(Width, Height, Period * (i + 1), (uint64_t)i + 1),
+            ide.data(), (size_t)Width * 4, &dirty, 1, nullptr, 0, true);
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(memory.Writable());
+    const FrameCaptureHeader* header = static_cast<const FrameCaptureHeader*>(memory.Writable());
+    CaptureIndexEntry* index = reinterpret_cast<CaptureIndexEntry*>(base + header->IndexOffset);
+    auto writable = [&](const uint8_t* readOnly)
+    {
+        return base + (readOnly - static_cast<const uint8_t*>(memory.ReadOnly()));
+    };
+
+    FrameCaptureReader reader;
+    EXPECT_FALSE(reader.Attach(memory.ReadOnly(), FrameCaptureLayout::IndexOffset() - 1));
+    ASSERT_TRUE(reader.Attach(memory.ReadOnly(), writer.UsedSize()));
+
+    // 写入中途终止的记录与越界的长度
+    CaptureRecordView record;
+    index[1].State.store(CaptureRecordPending);
+    EXPECT_FALSE(reader.Record(1, record));
+    index[1].State.store(CaptureRecordCommitted);
+    const uint64_t size = index[1].Size;
+    index[1].Size = writer.UsedSize();
+    EXPECT_FALSE(reader.Record(1, record));
+    index[1].Size = size;
+    EXPECT_TRUE(reader.Record(1, record));
+
+    CaptureFrameCanvas canvas;
+    CaptureFrameView view;
+
+    // 没有关键帧作基准的增量帧
+    ASSERT_TRUE(FrameCaptureReader::ParseFrame(record, view));
+    EXPECT_FALSE(canvas.Apply(view));
+
+    // 补丁矩形越界、数据被篡改：图像作废直到下一个关键帧
+    ASSERT_TRUE(reader.Record(0, record) && FrameCaptureReader::ParseFrame(record, view));
+    ASSERT_TRUE(canvas.Apply(view));
+    ASSERT_TRUE(reader.Record(2, record) && FrameCaptureReader::ParseFrame(record, view));
+    CapturePatchHeader* patch = reinterpret_cast<CapturePatchHeader*>(writable(view.Patches));
+    patch->Rect.Right = Width + 8;
+    EXPECT_FALSE(canvas.Apply(view));
+    EXPECT_EQ(0, canvas.Width());
+    patch->Rect.Right = dirty.Right;
+
+    ASSERT_TRUE(reader.Record(0, record) && FrameCaptureReader::ParseFrame(record, view));
+    ASSERT_TRUE(canvas.Apply(view));
+    ASSERT_TRUE(reader.Record(3, record) && FrameCaptureReader::ParseFrame(record, view));
+    writable(view.Patches)[sizeof(CapturePatchHeader)] ^= 0xFF;
+    EXPECT_FALSE(canvas.Apply(view));
+
+    // 补丁数多于数据
+    ASSERT_TRUE(reader.Record(0, record) && FrameCaptureReader::ParseFrame(record, view));
+    view.Frame.PatchCount++;
+    EXPECT_FALSE(canvas.Apply(view));
+
+    // 帧头声明的矩形数超出记录
+    CaptureFrameRecord* frame = reinterpret_cast<CaptureFrameRecord*>(base + index[1].Offset);
+    frame->DirtyRectCount = 1u << 30;
+    ASSERT_TRUE(reader.Record(1, record));
+    EXPECT_FALSE(FrameCaptureReader::ParseFrame(record, view));
+    CursorEvent event;
+    EXPECT_FALSE(FrameCaptureReader::ParseCursor(record, event));
+
+    // 文件头无效
+    std::vector<uint8_t> copy(static_cast<const uint8_t*>(memory.ReadOnly()),
+        static_cast<const uint8_t*>(memory.ReadOnly()) + writer.UsedSize());
+    reinterpret_cast<FrameCaptureHeader*>(copy.data())->Magic = 0;
+    EXPECT_FALSE(reader.Attach(copy.data(), copy.size()));
+}
+
+TEST_CASE(FrameCapture_ReplayIsDeterministic)
+{
+    const std::vector<Present> presents = Session();
+    SharedMemoryRegion memory((size_t)CaptureSize);
+    ASSERT_TRUE(memory.IsValid());
+    ASSERT_TRUE(FrameCaptureWriter::Format(memory.Writable(), CaptureSize, 0, TicksPerSecond, 60, 1));
+    FrameCaptureWriter writer;
+    ASSERT_TRUE(writer.Attach(memory.Writable(), CaptureSize));
+    Record(writer, presents);
+
+    FrameCaptureReader reader;
+    ASSERT_TRUE(reader.Attach(memory.ReadOnly(), writer.UsedSize()));
+
+    ReplayConfig serial;
+    serial.Workers = 0;
+    FrameReplayer first(serial);
+    ASSERT_TRUE(first.Run(reader));
+    const ReplayStats stats = first.Stats();
+
+    // 每次提交都在下一次之前发布；重复提交被丢弃；最后一帧静止后发布补偿帧
+    EXPECT_EQ((uint64_t)presents.size(), stats.Presents);
+    EXPECT_EQ((uint64_t)presents.size(), stats.CursorEvents);
+    EXPECT_EQ(0u, (uint32_t)stats.InvalidRecords);
+    EXPECT_EQ((uint64_t)presents.size() - 3, stats.Frames);
+    EXPECT_EQ(3u, (uint32_t)stats.Drops[(uint32_t)FrameDropReason::Unchanged]);
+    EXPECT_TRUE(stats.Refinements >= 1);
+    EXPECT_EQ(Period * (int64_t)presents.size() + Period / 2 - (Period + 1000), stats.Duration);
+    EXPECT_EQ(stats.Frames, (uint64_t)first.StageSamples(ReplayStage::Convert).size() - stats.Refinements);
+    EXPECT_EQ((uint64_t)presents.size(), (uint64_t)first.StageSamples(ReplayStage::Decode).size());
+
+    // 再次回放与多线程转换的结果逐帧相同
+    ASSERT_TRUE(first.Run(reader));
+    EXPECT_EQ(stats.Digest, first.Stats().Digest);
+    EXPECT_EQ(stats.Frames, first.Stats().Frames);
+
+    FrameReplayer parallel;
+    ASSERT_TRUE(parallel.Run(reader));
+    EXPECT_EQ(stats.Digest, parallel.Stats().Digest);
+    EXPECT_EQ(stats.Refinements, parallel.Stats().Refinements);
+
+    // 输出格式不同则摘要不同
+    ReplayConfig bgra;
+    bgra.OutputFormat = PixelFormat::Bgra8;
+    FrameReplayer other(bgra);
+    ASSERT_TRUE(other.Run(reader));
+    EXPECT_EQ(stats.Frames, other.Stats().Frames);
+    EXPECT_TRUE(stats.Digest != other.Stats().Digest);
+}
@@ -0,0 +1,275 @@
+/*++
+
+Module Name:
+    FrameDiffTests.cpp
+
+Abstract:
+    逐像素帧比较测试：各SIMD行比较内核与穷举结果一致，脏矩形收缩为变化像素的
+    精确包围盒（含按未变化行拆分），原样重绘被剔除，移动区域在参考帧上执行后
+    消费者镜像始终与新画面一致
+
+--*/
+
+#include "TestHarness.h"
+#include "FrameDiff.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const CpuLevel AllLevels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+
+struct Image
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;
+    std::vector<uint8_t> Bytes;
+
+    Image(int32_t width, int32_t height, uint32_t seed, size_t padding = 0)
+        : Width(width), Height(height), Pitch((size_t)width * 4 + padding),
+          Bytes(Pitch * (size_t)height)
+    {
+        std::mt19937 rng(seed);
+        for (uint8_t& b : Bytes)
+        {
+            b = (uint8_t)rng();
+        }
+    }
+
+    uint32_t* Pixel(int32_t x, int32_t y)
+    {
+        return reinterpret_cast<uint32_t*>(&Bytes[(size_t)y * Pitch + (size_t)x * 4]);
+    }
+
+    void Fill(const FrameRect& rect, std::mt19937& rng)
+    {
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            for (int32_t x = rect.Left; x < rect.Right; x++)
+            {
+                *Pixel(x, y) = rng();
+            }
+        }
+    }
+
+    uint32_t Diff(FrameDiffer& differ, const std::vector<FrameRect>& dirty, std::vector<FrameRect>& output,
+        const std::vector<FrameMoveRegion>& moves = {})
+    {
+        return differ.Diff(Bytes.data(), Pitch, Width, Height, dirty.data(), (uint32_t)dirty.size(),
+            moves.data(), (uint32_t)moves.size(), output);
+    }
+};
+
+} // namespace
+
+TEST_CASE(FrameDiff_AllKernelsMatchExhaustiveSearch)
+{
+    std::mt19937 rng(3);
+
+    for (int32_t pixels : { 0, 1, 2, 3, 15, 16, 17, 31, 33, 64, 65, 127, 200, 3840 })
+    {
+        std::vector<uint32_t> a((size_t)pixels + 1), b;
+        for (uint32_t& p : a)
+        {
+            p = rng();
+        }
+
+        // 无差异、单个差异（遍历位置，含单字节差异）、两个差异
+        std::vector<std::vector<int32_t>> patterns = { {} };
+        for (int32_t i = 0; i < pixels; i += (pixels > 200 ? 97 : 1))
+        {
+            patterns.push_back({ i });
+        }
+        if (pixels >= 2)
+        {
+            patterns.push_back({ 0, pixels - 1 });
+            patterns.push_back({ pixels / 3, pixels / 2 });
+        }
+
+        for (const std::vector<int32_t>& pattern : patterns)
+        {
+            b = a;
+            for (int32_t i : pattern)
+            {
+                b[(size_t)i] ^= 1u << (rng() % 32);
+            }
+            // 越过行尾的像素不同也不应被看到
+            b[(size_t)pixels] ^= 0xFF;
+
+            int32_t first = pixels, last = 0;
+            for (int32_t i = 0; i < pixels; i++)
+            {
+                if (a[(size_t)i] != b[(size_t)i])
+                {
+                    first = i < first ? i : first;
+                    last = i + 1;
+                }
+            }
+
+            const uint8_t* pa = reinterpret_cast<const uint8_t*>(a.data());
+            const uint8_t* pb = reinterpret_cast<const uint8_t*>(b.data());
+            for (CpuLevel level : AllLevels)
+            {
+                EXPECT_EQ(first, SelectFirstDifference(level)(pa, pb, pixels));
+                EXPECT_EQ(last, SelectLastDifference(level)(pa, pb, pixels));
+            }
+        }
+    }
+}
+
+TEST_CASE(FrameDiff_ShrinksDirtyRectToChangedPixels)
+{
+    for (CpuLevel level : AllLevels)
+    {
+        Image image(300, 200, 1, 20);
+        FrameDiffer differ(4, level);
+        std::vector<FrameRect> output;
+
+        // 首帧参考帧无效，原样输出
+        EXPECT_EQ(1u, image.Diff(differ, { { 10, 10, 290, 190 } }, output));
+        EXPECT_TRUE(differ.LastStats().FullFrame);
+
+        // 整窗上报，只有一个像素变化
+        *image.Pixel(150, 80) ^= 0x00010000u;
+        EXPECT_EQ(1u, image.Diff(differ, { { 10, 10, 290, 190 } }, output));
+        EXPECT_TRUE(output[0] == FrameRect({ 150, 80, 151, 81 }));
+        EXPECT_FALSE(differ.LastStats().FullFrame);
+
+        // 相距不超过合并间隔的变化行并入同一包围盒，超过时另起一个
+        *image.Pixel(40, 20) += 1;
+        *image.Pixel(60, 24) += 1;
+        *image.Pixel(100, 60) += 1;
+        *image.Pixel(30, 61) += 1;
+        EXPECT_EQ(2u, image.Diff(differ, { { 10, 10, 290, 190 } }, output));
+        EXPECT_TRUE(output[0] == FrameRect({ 40, 20, 61, 25 }));
+        EXPECT_TRUE(output[1] == FrameRect({ 30, 60, 101, 62 }));
+        EXPECT_EQ(4u, differ.LastStats().ChangedRows);
+
+        // 变化超出上报的脏矩形时不越界输出
+        *image.Pixel(200, 100) += 1;
+        *image.Pixel(250, 100) += 1;
+        EXPECT_EQ(1u, image.Diff(differ, { { 10, 90, 220, 110 } }, output));
+        EXPECT_TRUE(output[0] == FrameRect({ 200, 100, 201, 101 }));
+
+        // 上次未上报的变化此后被上报时仍能发现
+        EXPECT_EQ(1u, image.Diff(differ, { { 0, 0, 300, 200 } }, output));
+        EXPECT_TRUE(output[0] == FrameRect({ 250, 100, 251, 101 }));
+    }
+}
+
+TEST_CASE(FrameDiff_IdenticalRedrawIsSuppressed)
+{
+    Image image(257, 99, 2, 4);
+    FrameDiffer differ;
+    std::vector<FrameRect> output;
+    const std::vector<FrameRect> full = { { 0, 0, 257, 99 } };
+
+    image.Diff(differ, full, output);
+    EXPECT_EQ(0u, image.Diff(differ, full, output));
+    EXPECT_EQ(0, differ.LastStats().OutputArea);
+    EXPECT_EQ(257u * 99u * 4u, differ.LastStats().ComparedBytes);
+
+    // 作废后整帧视为变化
+    differ.Reset();
+    EXPECT_EQ(1u, image.Diff(differ, full, output));
+    EXPECT_TRUE(differ.LastStats().FullFrame);
+
+    // 分辨率变化后重新开始
+    Image larger(300, 120, 3);
+    EXPECT_EQ(1u, larger.Diff(differ, { { 0, 0, 300, 120 } }, output));
+    EXPECT_TRUE(differ.LastStats().FullFrame);
+    EXPECT_EQ(0u, larger.Diff(differ, { { 0, 0, 300, 120 } }, output));
+}
+
+TEST_CASE(FrameDiff_MirrorStaysIdenticalWithMoves)
+{
+    std::mt19937 rng(11);
+
+    for (CpuLevel level : AllLevels)
+    {
+        Image image(333, 211, 5, 12);
+        FrameDiffer differ(FrameDiffer::DefaultMergeGap, level);
+        std::vector<FrameRect> output;
+
+        // 消费者镜像：按顺序执行移动区域，再拷贝输出矩形
+        image.Diff(differ, { { 0, 0, image.Width, image.Height } }, output);
+        Image mirror = image;
+
+        for (int frame = 0; frame < 200; frame++)
+        {
+            std::vector<FrameMoveRegion> moves;
+            std::vector<FrameRect> dirty;
+
+            if (rng() % 3 == 0)
+            {
+                // 窗格内滚动：先在画面上移动，再为露出的条带上报脏矩形
+                const FrameRect pane = { 20, 30, 300, 190 };
+                const int32_t dy = (int32_t)(rng() % 21) - 10;
+                FrameMoveRegion move = { pane.Left, pane.Top,
+                    { pane.Left, pane.Top - dy, pane.Right, pane.Bottom - dy } };
+                move.Destination = IntersectRect(move.Destination, pane);
+                move.SourceY = move.Destination.Top + dy;
+                if (!move.Destination.IsEmpty())
+                {
+                    ApplyMoveRegions(image.Bytes.data(), (uint32_t)image.Pitch, 4, &move, 1, image.Width, image.Height);
+                    moves.push_back(move);
+                }
+
+                const FrameRect exposed = dy > 0 ?
+                    FrameRect({ pane.Left, pane.Bottom - dy, pane.Right, pane.Bottom }) :
+                    FrameRect({ pane.Left, pane.Top, pane.Right, pane.Top - dy });
+                if (!exposed.IsEmpty())
+                {
+                    image.Fill(exposed, rng);
+                    dirty.push_back(exposed);
+                }
+            }
+
+            const int count = 1 + (int)(rng() % 5);
+            for (int i = 0; i < count; i++)
+            {
+                int32_t l = (int32_t)(rng() % 320), t = (int32_t)(rng() % 200);
+                FrameRect rect = IntersectRect(
+                    { l, t, l + 1 + (int32_t)(rng() % 80), t + 1 + (int32_t)(rng() % 60) },
+                    { 0, 0, image.Width, image.Height });
+                dirty.push_back(rect);
+
+                // 原样重绘、整块变化或零星像素变化
+                const uint32_t kind = rng() % 3;
+                if (kind == 1)
+                {
+                    image.Fill(rect, rng);
+                }
+                else if (kind == 2)
+                {
+                    for (int p = 0; p < 3; p++)
+                    {
+                        *image.Pixel(rect.Left + (int32_t)(rng() % (uint32_t)rect.Width()),
+                            rect.Top + (int32_t)(rng() % (uint32_t)rect.Height())) += 1;
+                    }
+                }
+            }
+
+            image.Diff(differ, dirty, output, moves);
+            EXPECT_TRUE(differ.LastStats().OutputArea <= differ.LastStats().InputArea);
+
+            ApplyMoveRegions(mirror.Bytes.data(), (uint32_t)mirror.Pitch, 4, moves.data(), (uint32_t)moves.size(),
+                mirror.Width, mirror.Height);
+            for (const FrameRect& rect : output)
+            {
+                for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                {
+                    for (int32_t x = rect.Left; x < rect.Right; x++)
+                    {
+                        *mirror.Pixel(x, y) = *image.Pixel(x, y);
+                    }
+                }
+            }
+            ASSERT_TRUE(mirror.Bytes == image.Bytes);
+        }
+    }
+}
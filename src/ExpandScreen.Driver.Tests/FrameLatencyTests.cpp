@@ -0,0 +1,304 @@
+/*++
+
+Module Name:
+    FrameLatencyTests.cpp
+
+Abstract:
+    逐帧延迟打点测试：直方图分桶与分位数误差、统计块的区间与总延迟、
+    经帧环头只读映射读取驱动侧统计、用户态追踪器就地追加与覆盖计数、
+    并发更新时快照一致
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "FrameRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;      // 与Windows QPC常见频率相同，1tick=100ns
+const int64_t TicksPerUs = TicksPerSecond / 1000000;
+
+FrameTimestamps MakeTimestamps(uint64_t frameNumber, int64_t present, const int64_t (&deltasUs)[LatencyStageCount - 1])
+{
+    FrameTimestamps timestamps = {};
+    timestamps.FrameNumber = frameNumber;
+    timestamps.Time[0] = present;
+    for (uint32_t stage = 1; stage < LatencyStageCount; stage++)
+    {
+        timestamps.Time[stage] = timestamps.Time[stage - 1] + deltasUs[stage - 1] * TicksPerUs;
+    }
+    return timestamps;
+}
+
+} // namespace
+
+TEST_CASE(FrameLatency_HistogramBucketsAreContiguous)
+{
+    // 相邻桶首尾相接：桶上界落在本桶，上界加1落在下一个桶
+    for (uint32_t bucket = 0; bucket + 1 < LatencyHistogram::BucketCount; bucket++)
+    {
+        const uint64_t bound = LatencyHistogram::BucketUpperBound(bucket);
+        EXPECT_EQ(bucket, LatencyHistogram::BucketOf(bound));
+        EXPECT_EQ(bucket + 1, LatencyHistogram::BucketOf(bound + 1));
+    }
+
+    // 桶宽不超过下界的1/16
+    for (uint32_t bucket = LatencyHistogram::SubBuckets; bucket < LatencyHistogram::BucketCount; bucket++)
+    {
+        const uint64_t low = LatencyHistogram::BucketUpperBound(bucket - 1) + 1;
+        const uint64_t width = LatencyHistogram::BucketUpperBound(bucket) - low + 1;
+        EXPECT_TRUE(width * LatencyHistogram::SubBuckets <= low);
+    }
+
+    std::mt19937_64 rng(3);
+    for (int i = 0; i < 100000; i++)
+    {
+        const uint64_t us = rng() >> (rng() % 64);
+        const uint32_t bucket = LatencyHistogram::BucketOf(us);
+        ASSERT_TRUE(bucket < LatencyHistogram::BucketCount);
+        if (bucket < LatencyHistogram::BucketCount - 1)
+        {
+            EXPECT_TRUE(us <= LatencyHistogram::BucketUpperBound(bucket));
+            EXPECT_TRUE(bucket == 0 || us > LatencyHistogram::BucketUpperBound(bucket - 1));
+        }
+    }
+}
+
+TEST_CASE(FrameLatency_PercentilesWithinBucketError)
+{
+    LatencyHistogram histogram;
+    histogram.Reset();
+    EXPECT_EQ(0u, histogram.PercentileUs(50));
+
+    // 对数正态分布的延迟，中位数约8ms
+    std::mt19937 rng(5);
+    std::lognormal_distribution<double> distribution(9.0, 0.6);
+    std::vector<uint64_t> samples;
+    for (int i = 0; i < 50000; i++)
+    {
+        uint64_t us = (uint64_t)distribution(rng);
+        samples.push_back(us);
+        histogram.Record(us);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    for (double p : { 50.0, 90.0, 99.0, 99.9 })
+    {
+        const uint64_t exact = samples[(size_t)(p / 100.0 * (double)samples.size() + 0.5) - 1];
+        const uint64_t estimate = histogram.PercentileUs(p);
+        EXPECT_TRUE(estimate >= exact);
+        EXPECT_TRUE((double)estimate <= (double)exact * (1.0 + 1.0 / LatencyHistogram::SubBuckets) + 1);
+    }
+
+    EXPECT_EQ(samples.back(), histogram.PercentileUs(100));
+    EXPECT_EQ(samples.back(), histogram.MaxUs);
+    EXPECT_EQ(50000u, histogram.Count);
+}
+
+TEST_CASE(FrameLatency_StatsBlockRecordsIntervalsAndTotal)
+{
+    std::vector<uint8_t> memory(sizeof(LatencyStatsBlock) + 64);
+    void* aligned = memory.data() + (64 - (reinterpret_cast<uintptr_t>(memory.data()) & 63)) % 64;
+
+    LatencyStatsWriter writer;
+    EXPECT_FALSE(writer.Attach(aligned, sizeof(LatencyStatsBlock)));
+    ASSERT_TRUE(LatencyStatsWriter::Format(aligned, sizeof(LatencyStatsBlock), TicksPerSecond));
+    ASSERT_TRUE(writer.Attach(aligned, sizeof(LatencyStatsBlock)));
+
+    const int64_t deltas[] = { 200, 1500, 300, 100, 4000, 800 };
+    writer.Record(MakeTimestamps(1, 1000000, deltas));
+
+    // 只有驱动打点的帧：总延迟到发布为止，后续区间不计
+    FrameTimestamps driverOnly = MakeTimestamps(2, 2000000, deltas);
+    for (uint32_t stage = (uint32_t)LatencyStage::Consume; stage < LatencyStageCount; stage++)
+    {
+        driverOnly.Time[stage] = 0;
+    }
+    writer.Record(driverOnly);
+
+    // 没有提交时间的帧不计入
+    FrameTimestamps noPresent = {};
+    noPresent.Stamp(LatencyStage::Publish, 5);
+    writer.Record(noPresent);
+
+    LatencyStatsReader reader;
+    ASSERT_TRUE(reader.Attach(aligned, sizeof(LatencyStatsBlock)));
+    LatencyStatsSnapshot snapshot;
+    ASSERT_TRUE(reader.Snapshot(snapshot));
+
+    EXPECT_EQ(2u, snapshot.Frames);
+    EXPECT_EQ(TicksPerSecond, snapshot.TicksPerSecond);
+    EXPECT_EQ(2u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::Acquire)].Count);
+    EXPECT_EQ(200u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::Acquire)].MaxUs);
+    EXPECT_EQ(1u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::EncodeEnd)].Count);
+    EXPECT_EQ(4000u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::EncodeEnd)].MaxUs);
+    EXPECT_EQ(6900u, snapshot.Intervals[LatencyTotalInterval].MaxUs);
+    EXPECT_EQ((6900u + 1700u) / 2, snapshot.Intervals[LatencyTotalInterval].MeanUs());
+
+    writer.Reset();
+    ASSERT_TRUE(reader.Snapshot(snapshot));
+    EXPECT_EQ(0u, snapshot.Frames);
+    EXPECT_EQ(0u, snapshot.Intervals[LatencyTotalInterval].Count);
+}
+
+TEST_CASE(FrameLatency_DriverStampsTravelWithFrameAndTrackerAppends)
+{
+    SharedMemoryRegion ring(FrameRingLayout::RequiredSize(3, 4096));
+    ASSERT_TRUE(FrameRingProducer::Format(ring.Writable(), ring.Size(), 3, 4096));
+
+    FrameRingProducer producer;
+    ASSERT_TRUE(producer.Attach(ring.Writable(), ring.Size()));
+    ASSERT_TRUE(LatencyStatsWriter::Format(producer.Latency(), sizeof(LatencyStatsBlock), TicksPerSecond));
+    LatencyStatsWriter driverStats;
+    ASSERT_TRUE(driverStats.Attach(producer.Latency(), sizeof(LatencyStatsBlock)));
+
+    // 用户态统计块在自己的共享内存中
+    SharedMemoryRegion userRegion(sizeof(LatencyStatsBlock));
+    ASSERT_TRUE(LatencyStatsWriter::Format(userRegion.Writable(), userRegion.Size(), TicksPerSecond));
+    LatencyStatsWriter userStats;
+    ASSERT_TRUE(userStats.Attach(userRegion.Writable(), userRegion.Size()));
+    FrameLatencyTracker tracker(&userStats);
+
+    FrameRingConsumer consumer;
+    ASSERT_TRUE(consumer.Attach(ring.ReadOnly(), ring.Size()));
+
+    int64_t now = 1000000;
+    for (uint64_t frame = 1; frame <= 10; frame++)
+    {
+        // 驱动：提交、获取、发布
+        FrameDescriptor descriptor = { 16, 16, 64, PixelFormat::Bgra8, now, now + 3000 * TicksPerUs, YuvMatrix::Bt709, YuvRange::Limited, 0,
+            now + 500 * TicksPerUs, 1000 + frame };
+        FrameWriteSlot slot = producer.BeginWrite();
+        producer.EndWrite(slot, descriptor, nullptr, 0);
+
+        FrameTimestamps driver = {};
+        driver.FrameNumber = slot.FrameNumber;
+        driver.Stamp(LatencyStage::Present, descriptor.PresentTime);
+        driver.Stamp(LatencyStage::Acquire, descriptor.AcquireTime);
+        driver.Stamp(LatencyStage::Publish, descriptor.PublishTime);
+        driverStats.Record(driver);
+
+        // 用户态：取出后就地追加编码与发送时间
+        FrameReadView view;
+        ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+        EXPECT_EQ(1000 + frame, view.Descriptor.PresentFrameNumber);
+        const int64_t consume = view.Descriptor.PublishTime + 200 * TicksPerUs;
+        FrameTimestamps* record = tracker.Begin(view.FrameNumber,
+            view.Descriptor.PresentTime, view.Descriptor.AcquireTime, view.Descriptor.PublishTime, consume);
+        EXPECT_TRUE(consumer.EndRead(view));
+
+        record->Stamp(LatencyStage::EncodeStart, consume + 100 * TicksPerUs);
+        EXPECT_TRUE(tracker.Stamp(view.FrameNumber, LatencyStage::EncodeEnd, consume + 5100 * TicksPerUs));
+        EXPECT_TRUE(tracker.Stamp(view.FrameNumber, LatencyStage::Send, consume + 5600 * TicksPerUs));
+        EXPECT_TRUE(tracker.Complete(view.FrameNumber));
+        EXPECT_FALSE(tracker.Complete(view.FrameNumber));
+
+        now += TicksPerSecond / 60;
+    }
+
+    // 驱动侧统计经只读映射读取
+    LatencyStatsReader driverReader;
+    ASSERT_TRUE(driverReader.Attach(consumer.Latency(), sizeof(LatencyStatsBlock)));
+    LatencyStatsSnapshot snapshot;
+    ASSERT_TRUE(driverReader.Snapshot(snapshot));
+    EXPECT_EQ(10u, snapshot.Frames);
+    EXPECT_EQ(500u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::Acquire)].MaxUs);
+    EXPECT_EQ(3000u, snapshot.Intervals[LatencyTotalInterval].MaxUs);
+
+    LatencyStatsReader userReader;
+    ASSERT_TRUE(userReader.Attach(userRegion.ReadOnly(), userRegion.Size()));
+    ASSERT_TRUE(userReader.Snapshot(snapshot));
+    EXPECT_EQ(10u, snapshot.Frames);
+    EXPECT_EQ(0u, snapshot.Dropped);
+    EXPECT_EQ(5000u, snapshot.Intervals[LatencyIntervalOf(LatencyStage::EncodeEnd)].PercentileUs(50));
+    EXPECT_EQ(3000u + 200u + 5600u, snapshot.Intervals[LatencyTotalInterval].MaxUs);
+}
+
+TEST_CASE(FrameLatency_TrackerCountsOverwrittenRecords)
+{
+    std::vector<LatencyStatsBlock> storage(1);
+    ASSERT_TRUE(LatencyStatsWriter::Format(storage.data(), sizeof(LatencyStatsBlock), TicksPerSecond));
+    LatencyStatsWriter writer;
+    ASSERT_TRUE(writer.Attach(storage.data(), sizeof(LatencyStatsBlock)));
+    FrameLatencyTracker tracker(&writer);
+
+    // 从未完成的帧在环绕一圈后被覆盖
+    const uint64_t count = FrameLatencyTracker::Capacity + 10;
+    for (uint64_t frame = 1; frame <= count; frame++)
+    {
+        tracker.Begin(frame, 100, 200, 300, 400);
+    }
+
+    EXPECT_TRUE(tracker.Find(1) == nullptr);
+    EXPECT_TRUE(tracker.Find(count) != nullptr);
+    EXPECT_FALSE(tracker.Stamp(5, LatencyStage::Send, 1));
+    EXPECT_TRUE(tracker.Complete(count));
+
+    LatencyStatsReader reader;
+    ASSERT_TRUE(reader.Attach(storage.data(), sizeof(LatencyStatsBlock)));
+    LatencyStatsSnapshot snapshot;
+    ASSERT_TRUE(reader.Snapshot(snapshot));
+    EXPECT_EQ(10u, snapshot.Dropped);
+    EXPECT_EQ(1u, snapshot.Frames);
+}
+
+TEST_CASE(FrameLatency_ConcurrentSnapshotsAreConsistent)
+{
+    SharedMemoryRegion region(sizeof(LatencyStatsBlock));
+    ASSERT_TRUE(LatencyStatsWriter::Format(region.Writable(), region.Size(), TicksPerSecond));
+
+    const int frames = 100000;
+    std::atomic<bool> done{ false };
+    std::atomic<uint64_t> snapshots{ 0 };
+    uint64_t inconsistent = 0;
+
+    std::thread readerThread([&] {
+        LatencyStatsReader reader;
+        reader.Attach(region.ReadOnly(), region.Size());
+        LatencyStatsSnapshot snapshot;
+        while (!done.load(std::memory_order_acquire))
+        {
+            if (!reader.Snapshot(snapshot))
+            {
+                continue;
+            }
+
+            // 同一次更新写入的计数必须同时可见
+            for (uint32_t interval = 0; interval < LatencyStageCount; interval++)
+            {
+                if (snapshot.Intervals[interval].Count != snapshot.Frames)
+                {
+                    inconsistent++;
+                }
+            }
+            snapshots.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    LatencyStatsWriter writer;
+    writer.Attach(region.Writable(), region.Size());
+    const int64_t deltas[] = { 100, 200, 300, 400, 500, 600 };
+    // 写者连续突发更新，偶尔让出CPU；至少等读者取得若干快照
+    for (int i = 1; i <= frames || snapshots.load(std::memory_order_relaxed) < 100; i++)
+    {
+        writer.Record(MakeTimestamps((uint64_t)i, i * 1000, deltas));
+        if (i % 64 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    readerThread.join();
+
+    EXPECT_EQ(0u, inconsistent);
+    EXPECT_TRUE(snapshots.load() >= 100);
+}
@@ -0,0 +1,200 @@
+/*++
+
+Module Name:
+    FramePacerTests.cpp
+
+Abstract:
+    定速测试（模拟时钟）：每个刷新区间最多发布一帧且落在区间边界上，
+    跳过的提交合并进下一帧，空闲后的提交立即发布；挂起的提交推迟到挂起时间；
+    损伤合并对移动区域的降级
+
+--*/
+
+#include "TestHarness.h"
+#include "SimulatedClock.h"
+
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+
+std::vector<int64_t> EvenPresents(int64_t start, int64_t interval, int count)
+{
+    std::vector<int64_t> times;
+    for (int i = 0; i < count; i++)
+    {
+        times.push_back(start + interval * i);
+    }
+    return times;
+}
+
+} // namespace
+
+TEST_CASE(FramePacer_AtMostOneEmitPerIntervalOnTheGrid)
+{
+    SimulatedClock clock(TicksPerSecond);
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 60, 1);
+    const int64_t period = pacer.Period();
+    EXPECT_EQ(TicksPerSecond / 60, period);
+
+    // 240Hz提交一秒，唤醒无延迟
+    const int64_t start = 12345;
+    std::vector<PacingEmit> emits = SimulatePacing(
+        pacer, clock, EvenPresents(start, TicksPerSecond / 240, 240));
+
+    EXPECT_TRUE(emits.size() >= 60 && emits.size() <= 61);
+    uint64_t presents = 0;
+    for (size_t i = 0; i < emits.size(); i++)
+    {
+        presents += emits[i].Presents;
+
+        // 第一帧决定相位，此后每帧都恰好落在区间边界上
+        EXPECT_EQ(0, (emits[i].Time - start) % period);
+        if (i != 0)
+        {
+            EXPECT_TRUE(emits[i].Time - emits[i - 1].Time >= period);
+        }
+    }
+
+    const FramePacerStats& stats = pacer.Stats();
+    EXPECT_EQ(240u, presents);
+    EXPECT_EQ(240u, stats.Presents);
+    EXPECT_EQ((uint64_t)emits.size(), stats.Emits);
+    EXPECT_EQ(stats.Presents - stats.Emits, stats.Coalesced);
+    EXPECT_EQ(0, stats.BoundaryErrorMax);
+    EXPECT_TRUE(stats.LatencyMax <= period);
+}
+
+TEST_CASE(FramePacer_WakeLatencyShowsUpAsBoundaryError)
+{
+    SimulatedClock clock(TicksPerSecond);
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 120, 1);
+
+    WakeLatencyModel latency;
+    latency.Min = clock.FromMicroseconds(50);
+    latency.Max = clock.FromMicroseconds(400);
+
+    std::vector<PacingEmit> emits = SimulatePacing(
+        pacer, clock, EvenPresents(0, TicksPerSecond / 500, 1000), latency);
+
+    const FramePacerStats& stats = pacer.Stats();
+    EXPECT_TRUE(stats.Deferred > 0);
+    EXPECT_TRUE(stats.BoundaryErrorMax >= latency.Min);
+    EXPECT_TRUE(stats.BoundaryErrorMax <= latency.Max);
+
+    // 唤醒延迟使发布晚于边界，但每个区间（以第一个提交为相位）仍最多发布一帧
+    for (size_t i = 1; i < emits.size(); i++)
+    {
+        EXPECT_TRUE(emits[i].Time / pacer.Period() > emits[i - 1].Time / pacer.Period());
+    }
+
+    // 同样的输入与种子得到同样的结果
+    SimulatedClock replayClock(TicksPerSecond);
+    FramePacer replay;
+    replay.Configure(TicksPerSecond, 120, 1);
+    std::vector<PacingEmit> replayEmits = SimulatePacing(
+        replay, replayClock, EvenPresents(0, TicksPerSecond / 500, 1000), latency);
+    EXPECT_EQ(emits.size(), replayEmits.size());
+    EXPECT_EQ(stats.LatencyTotal, replay.Stats().LatencyTotal);
+    EXPECT_EQ(stats.Jitter, replay.Stats().Jitter);
+}
+
+TEST_CASE(FramePacer_IdlePresentEmitsImmediatelyAndRealigns)
+{
+    SimulatedClock clock(TicksPerSecond);
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 60000, 1001);
+    const int64_t period = pacer.Period();
+    EXPECT_EQ(TicksPerSecond * 1001 / 60000, period);
+
+    // 两帧之间空闲远超一个周期，第二帧不必等待
+    std::vector<int64_t> presents = { 0, period * 10 + period / 3, period * 10 + period / 2 };
+    std::vector<PacingEmit> emits = SimulatePacing(pacer, clock, presents);
+
+    EXPECT_EQ(3u, emits.size());
+    EXPECT_EQ(0, emits[0].Time);
+    EXPECT_EQ(presents[1], emits[1].Time);
+
+    // 第三帧与第二帧同一区间，延后到区间边界
+    EXPECT_EQ(period * 11, emits[2].Time);
+    EXPECT_EQ(1u, pacer.Stats().Deferred);
+}
+
+TEST_CASE(FramePacer_UnpacedEmitsEveryDrain)
+{
+    SimulatedClock clock(TicksPerSecond);
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 0, 0);
+    EXPECT_EQ(0, pacer.Period());
+
+    // 同一时刻的突发在一次取空内合并
+    std::vector<int64_t> presents = { 100, 100, 100, 200, 300 };
+    std::vector<PacingEmit> emits = SimulatePacing(pacer, clock, presents);
+
+    EXPECT_EQ(3u, emits.size());
+    EXPECT_EQ(3u, emits[0].Presents);
+    EXPECT_EQ(0, pacer.Stats().LatencyMax);
+}
+
+TEST_CASE(FramePacer_HeldPresentsWaitUnlessAnyIsNotHeld)
+{
+    FramePacer pacer;
+    pacer.Configure(TicksPerSecond, 120, 1);
+    const int64_t period = pacer.Period();
+
+    pacer.OnPresent(0);
+    EXPECT_TRUE(pacer.ShouldEmit(0));
+    pacer.OnEmit(0);
+
+    // 全部挂起：推迟到挂起时间，边界误差按挂起时间计
+    pacer.OnPresent(period, period * 4);
+    pacer.OnPresent(period * 2, period * 5);
+    EXPECT_EQ(period * 4, pacer.Deadline());
+    EXPECT_FALSE(pacer.ShouldEmit(period * 3));
+    EXPECT_TRUE(pacer.ShouldEmit(period * 4));
+    pacer.OnEmit(period * 4);
+    EXPECT_EQ(0, pacer.Stats().BoundaryErrorMax);
+
+    // 任一提交不挂起即回到区间边界；挂起不跨发布保留
+    pacer.OnPresent(period * 4 + 10, period * 9);
+    pacer.OnPresent(period * 4 + 20);
+    EXPECT_EQ(period * 5, pacer.Deadline());
+    pacer.OnEmit(period * 5);
+    pacer.OnPresent(period * 7);
+    EXPECT_TRUE(pacer.ShouldEmit(period * 7));
+}
+
+TEST_CASE(FramePacer_DamageAccumulatorDemotesMovesWhenCoalescing)
+{
+    const FrameRect dirty = { 0, 0, 10, 10 };
+    const FrameMoveRegion move = { 0, 40, { 0, 20, 100, 60 } };
+
+    FrameDamageAccumulator damage;
+    damage.Add(&dirty, 1, &move, 1);
+    EXPECT_EQ(1u, damage.Moves().size());
+    EXPECT_EQ(1u, damage.Dirty().size());
+
+    // 第二个提交可能搬运尚未发布的脏内容，移动区域全部降级为目标区域
+    const FrameRect second = { 50, 50, 60, 60 };
+    damage.Add(&second, 1, nullptr, 0);
+    EXPECT_EQ(0u, damage.Moves().size());
+    EXPECT_EQ(3u, damage.Dirty().size());
+    EXPECT_TRUE(damage.Dirty()[1] == move.Destination);
+    EXPECT_EQ(2u, damage.FrameCount());
+
+    damage.Clear();
+    damage.Add(&dirty, 1, nullptr, 0);
+    damage.Add(&second, 1, nullptr, 0);
+    EXPECT_EQ(2u, damage.Dirty().size());
+    EXPECT_FALSE(damage.FullFrame());
+
+    damage.AddFullFrame();
+    damage.Add(nullptr, 0, &move, 1);
+    EXPECT_TRUE(damage.FullFrame());
+    EXPECT_EQ(0u, damage.Moves().size());
+}
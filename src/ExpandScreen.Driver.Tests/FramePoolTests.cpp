@@ -0,0 +1,189 @@
+/*++
+
+Module Name:
+    FramePoolTests.cpp
+
+Abstract:
+    帧缓冲池与每帧线性分配区测试：按格式计算布局，缓冲页对齐、按引用计数循环
+    使用且可跨线程释放，线性分配的对齐、溢出与复位
+
+    完整的每帧处理路径在稳态下不调用堆分配器的测试见FrameAllocationTests.cpp
+
+--*/
+
+#include "TestHarness.h"
+#include "FramePool.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+TEST_CASE(FramePool_LayoutFollowsFormat)
+{
+    FrameBufferLayout bgra = FrameBufferLayout::For(PixelFormat::Bgra8, 1920, 1080);
+    EXPECT_EQ(7680u, bgra.Pitch);
+    EXPECT_EQ(7680u * 1080u, bgra.Bytes);
+    EXPECT_EQ(0u, bgra.ChromaOffset);
+
+    // 行距按64字节对齐，UV平面紧跟Y平面
+    FrameBufferLayout nv12 = FrameBufferLayout::For(PixelFormat::Nv12, 1366, 768);
+    EXPECT_EQ(1408u, nv12.Pitch);
+    EXPECT_EQ(1408u * 768u, nv12.ChromaOffset);
+    EXPECT_EQ(1408u * 768u * 3 / 2, nv12.Bytes);
+
+    FrameBufferLayout p010 = FrameBufferLayout::For(PixelFormat::P010, 3840, 2160);
+    EXPECT_EQ(7680u, p010.Pitch);
+    EXPECT_EQ(7680u * 2160u * 3 / 2, p010.Bytes);
+
+    EXPECT_FALSE(FrameBufferLayout::For(PixelFormat::Nv12, 1365, 768).IsValid());
+    EXPECT_FALSE(FrameBufferLayout::For(PixelFormat::Unknown, 64, 64).IsValid());
+    EXPECT_FALSE(FrameBufferLayout::For(PixelFormat::Bgra8, 0, 64).IsValid());
+}
+
+TEST_CASE(FramePool_BuffersArePageAlignedAndRecycled)
+{
+    FrameBufferPool pool;
+    EXPECT_FALSE(pool.TryAcquire());
+    ASSERT_TRUE(pool.Configure(PixelFormat::Nv12, 640, 360, 3));
+    EXPECT_EQ(3u, pool.Stats().Allocations);
+
+    FrameBufferRef a = pool.TryAcquire();
+    FrameBufferRef b = pool.TryAcquire();
+    FrameBufferRef c = pool.TryAcquire();
+    ASSERT_TRUE(a && b && c);
+    EXPECT_FALSE(pool.TryAcquire());
+    EXPECT_EQ(2u, pool.Stats().Exhausted);      // 含配置前的一次
+
+    for (const FrameBufferRef* ref : { &a, &b, &c })
+    {
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ref->Data()) % 4096);
+        EXPECT_TRUE(ref->Chroma() == ref->Data() + 640 * 360);
+        EXPECT_EQ(0, ref->Data()[ref->Layout().Bytes - 1]);     // 预先写零
+    }
+    EXPECT_TRUE(a.Data() != b.Data() && b.Data() != c.Data());
+
+    // 复制加引用，所有引用释放后缓冲才回到池中
+    const uint32_t index = b.Index();
+    FrameBufferRef held = b;
+    EXPECT_EQ(2u, b.UseCount());
+    b.Reset();
+    EXPECT_FALSE(b);
+    EXPECT_FALSE(pool.TryAcquire());
+    EXPECT_EQ(1u, held.UseCount());
+
+    held = FrameBufferRef();
+    FrameBufferRef again = pool.TryAcquire();
+    ASSERT_TRUE(again);
+    EXPECT_EQ(index, again.Index());
+
+    // 仍有引用时不能重新配置；相同配置不重新分配
+    EXPECT_FALSE(pool.Configure(PixelFormat::Bgra8, 640, 360, 3));
+    EXPECT_TRUE(pool.Configure(PixelFormat::Nv12, 640, 360, 3));
+    EXPECT_EQ(3u, pool.Outstanding());
+
+    a.Reset();
+    c.Reset();
+    again.Reset();
+    EXPECT_EQ(0u, pool.Outstanding());
+    EXPECT_TRUE(pool.Configure(PixelFormat::Bgra8, 640, 360, 2));
+    EXPECT_EQ(5u, pool.Stats().Allocations);
+    EXPECT_TRUE(pool.TryAcquire().Chroma() == nullptr);
+}
+
+TEST_CASE(FramePool_ReferencesReleaseAcrossThreads)
+{
+    FrameBufferPool pool;
+    ASSERT_TRUE(pool.Configure(PixelFormat::Bgra8, 64, 64, 4));
+
+    // 生产者写入帧号后把引用交给消费者，消费者校验内容后在自己的线程释放
+    const uint32_t frames = 20000;
+    std::vector<FrameBufferRef> queue(4);
+    std::atomic<uint32_t> produced(0), consumed(0);
+    std::atomic<uint32_t> mismatches(0);
+
+    std::thread consumer([&]()
+    {
+        while (consumed.load() < frames)
+        {
+            const uint32_t next = consumed.load();
+            if (produced.load(std::memory_order_acquire) == next)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            FrameBufferRef ref = std::move(queue[next % 4]);
+            uint32_t value;
+            std::memcpy(&value, ref.Data(), sizeof(value));
+            mismatches += value != next ? 1 : 0;
+            ref.Reset();
+            consumed.store(next + 1, std::memory_order_release);
+        }
+    });
+
+    uint32_t exhausted = 0;
+    for (uint32_t i = 0; i < frames;)
+    {
+        if (i - consumed.load(std::memory_order_acquire) >= 4)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        FrameBufferRef ref = pool.TryAcquire();
+        if (!ref)
+        {
+            exhausted++;
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::memcpy(ref.Data(), &i, sizeof(i));
+        queue[i % 4] = std::move(ref);
+        produced.store(++i, std::memory_order_release);
+    }
+
+    consumer.join();
+    EXPECT_EQ(0u, mismatches.load());
+    EXPECT_EQ(0u, pool.Outstanding());
+    EXPECT_EQ((uint64_t)frames, pool.Stats().Acquired);
+    EXPECT_EQ((uint64_t)exhausted, pool.Stats().Exhausted);
+}
+
+TEST_CASE(FrameArena_BumpAllocatesAndResets)
+{
+    FrameArena arena(4096);
+    EXPECT_EQ(4096u, arena.Capacity());
+
+    uint8_t* flag = arena.Allocate<uint8_t>(1);
+    FrameRect* rects = arena.Allocate<FrameRect>(10);
+    int64_t* times = arena.Allocate<int64_t>(3);
+    ASSERT_TRUE(flag != nullptr && rects != nullptr && times != nullptr);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(rects) % alignof(FrameRect));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(times) % alignof(int64_t));
+    EXPECT_TRUE(reinterpret_cast<uint8_t*>(rects) >= flag + 1);
+    EXPECT_TRUE(reinterpret_cast<uint8_t*>(times) >= reinterpret_cast<uint8_t*>(rects + 10));
+
+    const FrameRect source[2] = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } };
+    FrameRect* copy = arena.Copy(source, 2);
+    ASSERT_TRUE(copy != nullptr);
+    EXPECT_TRUE(copy[1] == source[1]);
+
+    // 容量不足时返回nullptr，不破坏已分配的内容
+    const size_t used = arena.Used();
+    EXPECT_TRUE(arena.Allocate<FrameRect>(4096) == nullptr);
+    EXPECT_TRUE(arena.Allocate<uint8_t>((size_t)-1) == nullptr);
+    EXPECT_EQ(2u, arena.Overflows());
+    EXPECT_EQ(used, arena.Used());
+    EXPECT_TRUE(arena.Allocate<uint8_t>(4096 - used) != nullptr);
+    EXPECT_TRUE(arena.Allocate<uint8_t>(1) == nullptr);
+
+    // 复位后从头分配，高水位保留
+    arena.Reset();
+    EXPECT_EQ(0u, arena.Used());
+    EXPECT_EQ(4096u, arena.HighWater());
+    EXPECT_TRUE(arena.Allocate<uint8_t>(1) == flag);
+}
@@ -0,0 +1,57 @@
+/*++
+
+Module Name:
+    FrameRingFixture.h
+
+Abstract:
+    帧环测试共用的小帧（64x32 BGRA）：帧描述、整帧填同一个像素值、
+    检查读到的整帧是否都是该值
+
+--*/
+
+#pragma once
+
+#include "FrameRing.h"
+
+#include <cstdint>
+
+namespace FrameRingFixture {
+
+using ExpandScreen::Pipeline::FrameDescriptor;
+using ExpandScreen::Pipeline::FrameReadView;
+using ExpandScreen::Pipeline::FrameWriteSlot;
+
+constexpr uint32_t TestWidth = 64;
+constexpr uint32_t TestHeight = 32;
+constexpr uint32_t TestPitch = TestWidth * 4;
+constexpr uint64_t TestPixelBytes = (uint64_t)TestPitch * TestHeight;
+
+inline FrameDescriptor MakeDescriptor(int64_t presentTime)
+{
+    using namespace ExpandScreen::Pipeline;
+    return { TestWidth, TestHeight, TestPitch, PixelFormat::Bgra8, presentTime, presentTime + 1, YuvMatrix::Bt709, YuvRange::Limited, 0, 0, 0 };
+}
+
+inline void FillSlot(const FrameWriteSlot& slot, uint32_t value)
+{
+    uint32_t* pixels = reinterpret_cast<uint32_t*>(slot.Pixels);
+    for (uint64_t i = 0; i < TestPixelBytes / 4; i++)
+    {
+        pixels[i] = value;
+    }
+}
+
+inline bool FrameHasContent(const FrameReadView& view, uint32_t value)
+{
+    const uint32_t* pixels = reinterpret_cast<const uint32_t*>(view.Pixels);
+    for (uint64_t i = 0; i < TestPixelBytes / 4; i++)
+    {
+        if (pixels[i] != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace FrameRingFixture
@@ -0,0 +1,577 @@
+/*++
+
+Module Name:
+    FrameRingTests.cpp
+
+Abstract:
+    共享内存帧环测试，包括跨进程（fork）与并发覆盖压力测试；
+    背压：消费者落后时覆盖未取走的帧并合并损伤，注入停顿的压力测试中
+    消费者只按脏矩形/移动区域更新的镜像始终与帧内容一致；块内容类别图与视频区域提示随帧发布
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "FrameRingFixture.h"
+#include "FrameRing.h"
+#include "MoveRegion.h"
+
+#include <sys/wait.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace FrameRingFixture;
+
+namespace {
+
+// 每个像素写入帧号，消费者据此检测撕裂
+void FillFrame(const FrameWriteSlot& slot)
+{
+    FillSlot(slot, (uint32_t)slot.FrameNumber);
+}
+
+bool FrameIsUniform(const FrameReadView& view)
+{
+    return FrameHasContent(view, (uint32_t)view.FrameNumber);
+}
+
+void PublishFrame(FrameRingProducer& producer, const FrameRect* rects, uint32_t rectCount)
+{
+    FrameWriteSlot slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.EndWrite(slot, MakeDescriptor((int64_t)slot.FrameNumber * 100), rects, rectCount);
+}
+
+} // namespace
+
+TEST_CASE(FrameRing_ConsumerAttachFailsOnUnformattedMemory)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    ASSERT_TRUE(region.IsValid());
+
+    FrameRingConsumer consumer;
+    EXPECT_FALSE(consumer.Attach(region.ReadOnly(), region.Size()));
+    EXPECT_FALSE(FrameRingProducer::Format(region.Writable(), region.Size() - 1, 3, TestPixelBytes * 2));
+}
+
+TEST_CASE(FrameRing_PublishedFrameIsReadableThroughReadOnlyMapping)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    ASSERT_TRUE(region.IsValid());
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    ASSERT_TRUE(producer.Attach(region.Writable(), region.Size()));
+    ASSERT_TRUE(consumer.Attach(region.ReadOnly(), region.Size()));
+
+    FrameReadView view;
+    EXPECT_TRUE(consumer.BeginRead(view) == FrameReadResult::NoNewFrame);
+
+    FrameRect rects[] = { { 0, 0, 10, 10 }, { 20, 5, 30, 8 } };
+    PublishFrame(producer, rects, 2);
+
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(1u, view.FrameNumber);
+    EXPECT_EQ(TestWidth, view.Descriptor.Width);
+    EXPECT_EQ(100, view.Descriptor.PresentTime);
+    EXPECT_EQ(2u, view.DirtyRectCount);
+    EXPECT_TRUE(view.DirtyRects[1] == rects[1]);
+    EXPECT_TRUE(FrameIsUniform(view));
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    EXPECT_TRUE(consumer.BeginRead(view) == FrameReadResult::NoNewFrame);
+}
+
+TEST_CASE(FrameRing_TooManyDirtyRectsCollapseToBounds)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(2, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 2, TestPixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    FrameRect rects[FrameRingMaxDirtyRects + 1];
+    for (uint32_t i = 0; i <= FrameRingMaxDirtyRects; i++)
+    {
+        rects[i] = { (int32_t)i, (int32_t)i, (int32_t)i + 2, (int32_t)i + 1 };
+    }
+    PublishFrame(producer, rects, FrameRingMaxDirtyRects + 1);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(1u, view.DirtyRectCount);
+    EXPECT_TRUE(view.DirtyRects[0] == (FrameRect{ 0, 0, 66, 65 }));
+}
+
+TEST_CASE(FrameRing_ContentClassesTravelWithFrame)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(2, TestPixelBytes));
+    SharedMemoryRegion ackRegion(FrameAckBlockSize);
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 2, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::FormatAck(ackRegion.Writable(), ackRegion.Size()));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    producer.AttachAck(ackRegion.ReadOnly(), ackRegion.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    const FrameRect dirty = { 0, 0, 8, 8 };
+    const uint8_t classes[] = { (uint8_t)TileContent::Text, (uint8_t)TileContent::Video };
+    FrameWriteSlot slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetContentClasses(slot, 2, 1, classes);
+    producer.EndWrite(slot, MakeDescriptor(100), &dirty, 1);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(2u, view.ContentColumns);
+    EXPECT_EQ(1u, view.ContentRows);
+    EXPECT_TRUE(std::memcmp(view.ContentClasses, classes, sizeof(classes)) == 0);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 未填写类别图的新帧不沿用槽位中旧帧的类别图，超过容量的类别图不发布
+    PublishFrame(producer, &dirty, 1);
+    PublishFrame(producer, &dirty, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.ContentColumns * view.ContentRows);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetContentClasses(slot, FrameRingMaxContentTiles, 2, classes);
+    producer.EndWrite(slot, MakeDescriptor(400), &dirty, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.ContentColumns);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 覆盖未取走的帧时未重新填写则保留被覆盖帧的类别图
+    consumer.AttachAck(ackRegion.Writable(), ackRegion.Size());
+    slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetContentClasses(slot, 2, 1, classes);
+    producer.EndWrite(slot, MakeDescriptor(500), &dirty, 1);
+    slot = producer.BeginWrite();
+    EXPECT_TRUE(slot.Supersedes);
+    FillFrame(slot);
+    producer.EndWrite(slot, MakeDescriptor(600), &dirty, 1);
+
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(600, view.Descriptor.PresentTime);
+    EXPECT_EQ(2u, view.ContentColumns);
+    EXPECT_EQ((uint32_t)TileContent::Video, (uint32_t)view.ContentClasses[1]);
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(FrameRing_VideoRegionsTravelWithFrame)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(2, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 2, TestPixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    VideoRegionHint regions[FrameRingMaxVideoRegions + 2] = {};
+    for (uint32_t i = 0; i < FrameRingMaxVideoRegions + 2; i++)
+    {
+        regions[i].Rect = { (int32_t)i * 64, 0, (int32_t)i * 64 + 64, 128 };
+        regions[i].Interval = 2000 + i;
+        regions[i].Tiles = 20 - i;
+    }
+
+    const FrameRect dirty = { 0, 0, 8, 8 };
+    FrameWriteSlot slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetVideoRegions(slot, regions, 2);
+    producer.EndWrite(slot, MakeDescriptor(100), &dirty, 1);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    ASSERT_TRUE(view.VideoRegionCount == 2);
+    EXPECT_TRUE(view.VideoRegions[1].Rect == regions[1].Rect);
+    EXPECT_EQ(2001, view.VideoRegions[1].Interval);
+    EXPECT_EQ(20u, view.VideoRegions[0].Tiles);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 未填写的新帧没有区域；超过容量时只发布前FrameRingMaxVideoRegions个
+    PublishFrame(producer, &dirty, 1);
+    PublishFrame(producer, &dirty, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.VideoRegionCount);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetVideoRegions(slot, regions, FrameRingMaxVideoRegions + 2);
+    producer.EndWrite(slot, MakeDescriptor(400), &dirty, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(FrameRingMaxVideoRegions, view.VideoRegionCount);
+    EXPECT_TRUE(view.VideoRegions[FrameRingMaxVideoRegions - 1].Rect == regions[FrameRingMaxVideoRegions - 1].Rect);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    slot = producer.BeginWrite();
+    FillFrame(slot);
+    producer.SetVideoRegions(slot, nullptr, 3);
+    producer.EndWrite(slot, MakeDescriptor(500), &dirty, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.VideoRegionCount);
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(FrameRing_OverwrittenSlotDuringReadIsDetected)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(2, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 2, TestPixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    PublishFrame(producer, nullptr, 0);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+
+    // 消费者读取期间生产者绕环一圈覆盖同一槽位
+    PublishFrame(producer, nullptr, 0);
+    PublishFrame(producer, nullptr, 0);
+
+    EXPECT_FALSE(consumer.EndRead(view));
+    EXPECT_EQ(1u, consumer.TornReads());
+
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(3u, view.FrameNumber);
+    EXPECT_FALSE(view.Contiguous);
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(FrameRing_ProducerReattachContinuesFrameNumbering)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+
+    {
+        FrameRingProducer producer;
+        producer.Attach(region.Writable(), region.Size());
+        PublishFrame(producer, nullptr, 0);
+        PublishFrame(producer, nullptr, 0);
+    }
+
+    FrameRingProducer producer;
+    ASSERT_TRUE(producer.Attach(region.Writable(), region.Size()));
+    EXPECT_EQ(3u, producer.BeginWrite().FrameNumber);
+}
+
+TEST_CASE(FrameRing_ConcurrentStressNeverAcceptsTornFrame)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+
+    const uint64_t frameCount = 200000;
+    std::atomic<bool> done{ false };
+    uint64_t accepted = 0;
+    uint64_t corrupt = 0;
+    uint64_t lastFrame = 0;
+    bool ordered = true;
+
+    std::thread consumerThread([&] {
+        FrameRingConsumer consumer;
+        consumer.Attach(region.ReadOnly(), region.Size());
+
+        while (!done.load(std::memory_order_acquire) || consumer.LastFrame() < frameCount)
+        {
+            FrameReadView view;
+            if (consumer.BeginRead(view) != FrameReadResult::Ok)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            bool uniform = FrameIsUniform(view);
+            if (consumer.EndRead(view))
+            {
+                accepted++;
+                corrupt += uniform ? 0 : 1;
+                ordered = ordered && view.FrameNumber > lastFrame;
+                lastFrame = view.FrameNumber;
+            }
+        }
+    });
+
+    FrameRingProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    for (uint64_t i = 0; i < frameCount; i++)
+    {
+        PublishFrame(producer, nullptr, 0);
+    }
+    done.store(true, std::memory_order_release);
+    consumerThread.join();
+
+    EXPECT_TRUE(accepted > 0);
+    EXPECT_EQ(0u, corrupt);
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(frameCount, lastFrame);
+}
+
+TEST_CASE(FrameRing_CrossProcessConsumerSeesFrames)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(4, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 4, TestPixelBytes));
+
+    const uint64_t frameCount = 20000;
+
+    pid_t child = fork();
+    ASSERT_TRUE(child >= 0);
+
+    if (child == 0)
+    {
+        // 子进程只使用只读映射
+        FrameRingConsumer consumer;
+        if (!consumer.Attach(region.ReadOnly(), region.Size()))
+        {
+            _exit(2);
+        }
+
+        while (consumer.LastFrame() < frameCount)
+        {
+            FrameReadView view;
+            if (consumer.BeginRead(view) != FrameReadResult::Ok)
+            {
+                continue;
+            }
+
+            bool uniform = FrameIsUniform(view);
+            if (consumer.EndRead(view) && !uniform)
+            {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+
+    FrameRingProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    for (uint64_t i = 0; i < frameCount; i++)
+    {
+        PublishFrame(producer, nullptr, 0);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST_CASE(FrameRing_SlowConsumerSupersedesPendingFrame)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    SharedMemoryRegion ackRegion(FrameAckBlockSize);
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::FormatAck(ackRegion.Writable(), ackRegion.Size()));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    ASSERT_TRUE(producer.AttachAck(ackRegion.ReadOnly(), ackRegion.Size()));
+    consumer.Attach(region.ReadOnly(), region.Size());
+    EXPECT_FALSE(consumer.AttachAck(region.Writable(), 16));
+    ASSERT_TRUE(consumer.AttachAck(ackRegion.Writable(), ackRegion.Size()));
+
+    const FrameRect first = { 0, 0, 8, 8 };
+    PublishFrame(producer, &first, 1);
+
+    // 消费者正在读取帧1，新帧使用新帧号
+    FrameReadView reading;
+    ASSERT_TRUE(consumer.BeginRead(reading) == FrameReadResult::Ok);
+    const FrameRect second = { 10, 0, 20, 4 };
+    PublishFrame(producer, &second, 1);
+
+    // 帧2既未确认也未读取，之后的帧覆盖它：帧号不变，损伤为并集，移动区域降级
+    FrameWriteSlot slot = producer.BeginWrite();
+    EXPECT_TRUE(slot.Supersedes);
+    EXPECT_EQ(2u, slot.FrameNumber);
+    EXPECT_EQ(3u, slot.PublishNumber);
+    EXPECT_EQ(2u, slot.PreviousPublish);
+    FillFrame(slot);
+    const FrameRect third[] = { { 12, 1, 18, 3 }, { 40, 20, 50, 30 } };
+    const FrameMoveRegion move = { 0, 16, { 0, 0, 64, 8 } };
+    FrameDescriptor descriptor = MakeDescriptor(300);
+    descriptor.Flags = FrameFlagRefinement;
+    producer.EndWrite(slot, descriptor, third, 2, &move, 1);
+    EXPECT_EQ(1u, producer.Drops(FrameDropReason::Superseded));
+
+    // 读取中的帧1未被触及
+    EXPECT_TRUE(consumer.EndRead(reading));
+    EXPECT_EQ(1u, producer.AckedFrame());
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(2u, view.FrameNumber);
+    EXPECT_TRUE(view.Contiguous);
+    EXPECT_EQ(300, view.Descriptor.PresentTime);
+    EXPECT_EQ(0u, view.Descriptor.Flags);
+    EXPECT_EQ(0u, view.MoveRegionCount);
+    ASSERT_TRUE(view.DirtyRectCount == 3);
+    EXPECT_TRUE(view.DirtyRects[0] == second);
+    EXPECT_TRUE(view.DirtyRects[1] == third[1]);
+    EXPECT_TRUE(view.DirtyRects[2] == move.Destination);
+    EXPECT_TRUE(consumer.EndRead(view));
+    EXPECT_EQ(1u, consumer.Drops(FrameDropReason::Superseded));
+
+    // 消费者已取走最新帧，下一帧恢复使用新帧号
+    PublishFrame(producer, &first, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(3u, view.FrameNumber);
+    EXPECT_TRUE(consumer.EndRead(view));
+    EXPECT_EQ(0u, consumer.SkippedFrames());
+
+    // 断开确认块后不再背压，落后的消费者跳过帧
+    consumer.DetachAck();
+    PublishFrame(producer, &first, 1);
+    PublishFrame(producer, &first, 1);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(5u, view.FrameNumber);
+    EXPECT_FALSE(view.Contiguous);
+    EXPECT_EQ(1u, producer.Drops(FrameDropReason::Superseded));
+}
+
+TEST_CASE(FrameRing_BackpressureStressWithConsumerStalls)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    SharedMemoryRegion ackRegion(FrameAckBlockSize);
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::FormatAck(ackRegion.Writable(), ackRegion.Size()));
+
+    const uint64_t publishCount = 30000;
+    std::atomic<uint64_t> finalFrame{ 0 };
+    uint64_t accepted = 0;
+    uint64_t mismatches = 0;
+    uint64_t discontinuous = 0;
+    uint64_t stalls = 0;
+    FrameRingConsumer consumer;
+    consumer.Attach(region.ReadOnly(), region.Size());
+    consumer.AttachAck(ackRegion.Writable(), ackRegion.Size());
+
+    // 消费者镜像只按脏矩形与移动区域更新（帧不连续时整帧拷贝），并注入随机停顿
+    std::thread consumerThread([&] {
+        std::mt19937 rng(9);
+        std::vector<uint32_t> mirror(TestPixelBytes / 4), pixels(TestPixelBytes / 4);
+
+        for (;;)
+        {
+            const uint64_t target = finalFrame.load(std::memory_order_acquire);
+            if (target != 0 && consumer.LastFrame() == target)
+            {
+                break;
+            }
+
+            FrameReadView view;
+            if (consumer.BeginRead(view) != FrameReadResult::Ok)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::memcpy(pixels.data(), view.Pixels, TestPixelBytes);
+            if (rng() % 64 == 0)
+            {
+                stalls++;
+                std::this_thread::sleep_for(std::chrono::microseconds(200 + rng() % 2000));
+            }
+            if (!consumer.EndRead(view))
+            {
+                continue;
+            }
+
+            accepted++;
+            if (view.Contiguous)
+            {
+                ApplyMoveRegions(reinterpret_cast<uint8_t*>(mirror.data()), TestPitch, 4,
+                    view.MoveRegions, view.MoveRegionCount, (int32_t)TestWidth, (int32_t)TestHeight);
+                for (uint32_t i = 0; i < view.DirtyRectCount; i++)
+                {
+                    const FrameRect& rect = view.DirtyRects[i];
+                    for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                    {
+                        for (int32_t x = rect.Left; x < rect.Right; x++)
+                        {
+                            mirror[(size_t)y * TestWidth + x] = pixels[(size_t)y * TestWidth + x];
+                        }
+                    }
+                }
+            }
+            else
+            {
+                discontinuous++;
+                mirror = pixels;
+            }
+            mismatches += mirror == pixels ? 0 : 1;
+        }
+    });
+
+    // 生产者每次改一块随机矩形，偶尔整体滚动一行
+    FrameRingProducer producer;
+    producer.Attach(region.Writable(), region.Size());
+    producer.AttachAck(ackRegion.ReadOnly(), ackRegion.Size());
+    std::mt19937 rng(4);
+    std::vector<uint32_t> image(TestPixelBytes / 4, 0);
+    uint64_t lastFrame = 0;
+    bool publishOrdered = true;
+    for (uint64_t i = 1; i <= publishCount; i++)
+    {
+        FrameMoveRegion move = { 0, 1, { 0, 0, (int32_t)TestWidth, (int32_t)TestHeight - 1 } };
+        const bool scroll = rng() % 8 == 0;
+        if (scroll)
+        {
+            ApplyMoveRegions(reinterpret_cast<uint8_t*>(image.data()), TestPitch, 4, &move, 1,
+                (int32_t)TestWidth, (int32_t)TestHeight);
+        }
+
+        const int32_t left = (int32_t)(rng() % TestWidth), top = (int32_t)(rng() % TestHeight);
+        const FrameRect rect = IntersectRect({ left, top, left + 1 + (int32_t)(rng() % 16), top + 1 + (int32_t)(rng() % 8) },
+            { 0, 0, (int32_t)TestWidth, (int32_t)TestHeight });
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            for (int32_t x = rect.Left; x < rect.Right; x++)
+            {
+                image[(size_t)y * TestWidth + x] = (uint32_t)i;
+            }
+        }
+
+        FrameWriteSlot slot = producer.BeginWrite();
+        publishOrdered = publishOrdered && slot.PublishNumber == i;
+        std::memcpy(slot.Pixels, image.data(), TestPixelBytes);
+        producer.EndWrite(slot, MakeDescriptor((int64_t)i), &rect, 1, &move, scroll ? 1 : 0);
+        lastFrame = slot.FrameNumber;
+
+        if (i % 16 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    finalFrame.store(lastFrame, std::memory_order_release);
+    consumerThread.join();
+
+    // 覆盖的帧不计入帧号，消费者看到的帧号连续；只有读取与覆盖恰好竞争时才会不连续
+    const uint64_t superseded = producer.Drops(FrameDropReason::Superseded);
+    EXPECT_TRUE(publishOrdered);
+    EXPECT_EQ(publishCount, lastFrame + superseded);
+    EXPECT_TRUE(stalls > 0);
+    EXPECT_TRUE(superseded > 0);
+    EXPECT_TRUE(accepted > 0);
+    EXPECT_EQ(0u, mismatches);
+    EXPECT_TRUE(discontinuous * 100 <= accepted);
+    EXPECT_EQ(lastFrame, consumer.LastFrame());
+}
@@ -0,0 +1,363 @@
+/*++
+
+Module Name:
+    FrameStageGraphTests.cpp
+
+Abstract:
+    流水线阶段图测试：每一级按提交顺序处理，提前结束的作业不经过之后的各级，
+    同时在途的作业数不超过槽位数且全部在途时获取槽位等待，Stop处理完已提交的
+    作业，串行与流水线结果一致；接在FrameWorkerLoop后面时表面在拷出后即释放，
+    获取线程可以领先于仍在处理前一帧的慢阶段
+
+--*/
+
+#include "TestHarness.h"
+#include "FakeSwapChain.h"
+#include "FrameStageGraph.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+//
+// 每个槽位带一个帧号与累积值，每一级只写自己的记录
+//
+struct OrderRecorder
+{
+    FrameStageGraph* Graph = nullptr;
+    uint64_t Frames[FrameStageMaxJobs] = {};
+    uint64_t Values[FrameStageMaxJobs] = {};
+    std::vector<uint64_t> Seen[3];
+    std::vector<uint64_t> Output;
+    bool DropOdd = false;
+    std::chrono::microseconds LastStageDelay{ 0 };
+
+    static bool First(void* context, uint32_t job)
+    {
+        OrderRecorder* self = static_cast<OrderRecorder*>(context);
+        self->Seen[0].push_back(self->Frames[job]);
+        self->Values[job] = self->Frames[job] * 2654435761u;
+        if (self->DropOdd && (self->Frames[job] & 1) != 0)
+        {
+            self->Graph->Complete(job);
+            return false;
+        }
+        return true;
+    }
+
+    static bool Second(void* context, uint32_t job)
+    {
+        OrderRecorder* self = static_cast<OrderRecorder*>(context);
+        self->Seen[1].push_back(self->Frames[job]);
+        self->Values[job] ^= self->Values[job] >> 13;
+        return true;
+    }
+
+    static bool Third(void* context, uint32_t job)
+    {
+        OrderRecorder* self = static_cast<OrderRecorder*>(context);
+        if (self->LastStageDelay.count() != 0)
+        {
+            std::this_thread::sleep_for(self->LastStageDelay);
+        }
+        self->Seen[2].push_back(self->Frames[job]);
+        self->Output.push_back(self->Values[job]);
+        self->Graph->Complete(job);
+        return true;
+    }
+};
+
+const FrameStageFunction RecorderStages[] = { &OrderRecorder::First, &OrderRecorder::Second, &OrderRecorder::Third };
+
+void SubmitFrames(FrameStageGraph& graph, OrderRecorder& recorder, uint64_t count)
+{
+    for (uint64_t frame = 0; frame < count; frame++)
+    {
+        uint32_t job = 0;
+        ASSERT_TRUE(graph.AcquireJob(job));
+        recorder.Frames[job] = frame;
+        graph.Submit(job);
+    }
+}
+
+bool IsSequence(const std::vector<uint64_t>& frames, uint64_t count, uint64_t step)
+{
+    if (frames.size() != count)
+    {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++)
+    {
+        if (frames[i] != i * step)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE(FrameStageGraph_EveryStageSeesSubmitOrder)
+{
+    OrderRecorder recorder;
+    FrameStageGraph graph;
+    recorder.Graph = &graph;
+    ASSERT_TRUE(graph.Start(RecorderStages, 3, &recorder, 4, true));
+    EXPECT_TRUE(graph.Threaded());
+
+    SubmitFrames(graph, recorder, 500);
+    graph.Stop();
+
+    for (const std::vector<uint64_t>& seen : recorder.Seen)
+    {
+        EXPECT_TRUE(IsSequence(seen, 500, 1));
+    }
+
+    const FrameStageGraphStats stats = graph.Stats();
+    EXPECT_EQ(500u, (uint32_t)stats.Submitted);
+    EXPECT_EQ(500u, (uint32_t)stats.Completed);
+    EXPECT_TRUE(stats.MaxInFlight <= 4);
+    EXPECT_TRUE(stats.ElapsedNs > 0);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const FrameStageStats stage = graph.StageStats(i);
+        EXPECT_EQ(500u, (uint32_t)stage.Jobs);
+        EXPECT_EQ(500u, (uint32_t)stage.Forwarded);
+        EXPECT_TRUE(stage.MaxQueueDepth >= 1 && stage.MaxQueueDepth <= 4);
+        EXPECT_TRUE(stage.QueueDepthTotal >= stage.Jobs);
+    }
+}
+
+TEST_CASE(FrameStageGraph_EarlyExitSkipsLaterStages)
+{
+    for (bool threaded : { false, true })
+    {
+        OrderRecorder recorder;
+        recorder.DropOdd = true;
+        FrameStageGraph graph;
+        recorder.Graph = &graph;
+        ASSERT_TRUE(graph.Start(RecorderStages, 3, &recorder, 3, threaded));
+
+        SubmitFrames(graph, recorder, 100);
+        graph.Stop();
+
+        EXPECT_TRUE(IsSequence(recorder.Seen[0], 100, 1));
+        EXPECT_TRUE(IsSequence(recorder.Seen[1], 50, 2));
+        EXPECT_TRUE(IsSequence(recorder.Seen[2], 50, 2));
+        EXPECT_EQ(100u, (uint32_t)graph.StageStats(0).Jobs);
+        EXPECT_EQ(50u, (uint32_t)graph.StageStats(0).Forwarded);
+        EXPECT_EQ(50u, (uint32_t)graph.StageStats(1).Jobs);
+        EXPECT_EQ(100u, (uint32_t)graph.Stats().Completed);
+    }
+}
+
+TEST_CASE(FrameStageGraph_SerialMatchesPipelined)
+{
+    OrderRecorder serial;
+    {
+        FrameStageGraph graph;
+        serial.Graph = &graph;
+        ASSERT_TRUE(graph.Start(RecorderStages, 3, &serial, 4, false));
+        EXPECT_FALSE(graph.Threaded());
+        SubmitFrames(graph, serial, 300);
+
+        // 串行时Submit返回即已处理完
+        EXPECT_EQ(300u, serial.Output.size());
+        EXPECT_EQ(0u, graph.ActiveJobs());
+        EXPECT_EQ(1u, graph.Stats().MaxInFlight);
+        graph.Stop();
+    }
+
+    OrderRecorder pipelined;
+    {
+        FrameStageGraph graph;
+        pipelined.Graph = &graph;
+        ASSERT_TRUE(graph.Start(RecorderStages, 3, &pipelined, 4, true));
+        SubmitFrames(graph, pipelined, 300);
+        graph.Stop();
+    }
+
+    EXPECT_TRUE(serial.Output == pipelined.Output);
+}
+
+TEST_CASE(FrameStageGraph_BackpressureBoundsInFlight)
+{
+    OrderRecorder recorder;
+    recorder.LastStageDelay = std::chrono::microseconds(2000);
+    FrameStageGraph graph;
+    recorder.Graph = &graph;
+    ASSERT_TRUE(graph.Start(RecorderStages, 3, &recorder, 2, true));
+
+    uint32_t first = 0;
+    uint32_t second = 0;
+    uint32_t third = 0;
+    ASSERT_TRUE(graph.TryAcquireJob(first));
+    ASSERT_TRUE(graph.TryAcquireJob(second));
+    EXPECT_TRUE(first != second);
+    EXPECT_FALSE(graph.TryAcquireJob(third));
+
+    recorder.Frames[first] = 0;
+    graph.Submit(first);
+    recorder.Frames[second] = 1;
+    graph.Submit(second);
+
+    // 两个槽位都在途，等到最后一级归还第一个
+    ASSERT_TRUE(graph.AcquireJob(third));
+    EXPECT_EQ(first, third);
+    recorder.Frames[third] = 2;
+    graph.Submit(third);
+
+    graph.WaitIdle();
+    EXPECT_EQ(0u, graph.ActiveJobs());
+    EXPECT_EQ(3u, recorder.Seen[2].size());
+
+    const FrameStageGraphStats stats = graph.Stats();
+    EXPECT_EQ(2u, stats.MaxInFlight);
+    EXPECT_EQ(1u, (uint32_t)stats.JobWaits);
+    EXPECT_TRUE(stats.JobWaitNs > 0);
+
+    const FrameStageStats last = graph.StageStats(2);
+    EXPECT_TRUE(last.BusyNs >= 3u * 2000000u);
+    graph.Stop();
+
+    // 停止后不再分配槽位
+    EXPECT_FALSE(graph.AcquireJob(third));
+}
+
+TEST_CASE(FrameStageGraph_StopDrainsSubmittedJobs)
+{
+    OrderRecorder recorder;
+    recorder.LastStageDelay = std::chrono::microseconds(1000);
+    FrameStageGraph graph;
+    recorder.Graph = &graph;
+    ASSERT_TRUE(graph.Start(RecorderStages, 3, &recorder, 8, true));
+
+    SubmitFrames(graph, recorder, 8);
+    graph.Stop();
+
+    EXPECT_TRUE(IsSequence(recorder.Seen[2], 8, 1));
+    EXPECT_FALSE(graph.IsRunning());
+
+    // 可以重新启动
+    OrderRecorder again;
+    again.Graph = &graph;
+    ASSERT_TRUE(graph.Start(RecorderStages, 3, &again, 4, true));
+    SubmitFrames(graph, again, 10);
+    graph.Stop();
+    EXPECT_TRUE(IsSequence(again.Seen[2], 10, 1));
+    EXPECT_EQ(10u, (uint32_t)graph.Stats().Submitted);
+}
+
+TEST_CASE(FrameStageGraph_RejectsInvalidConfiguration)
+{
+    FrameStageGraph graph;
+    OrderRecorder recorder;
+    EXPECT_FALSE(graph.Start(nullptr, 3, &recorder, 4, true));
+    EXPECT_FALSE(graph.Start(RecorderStages, 0, &recorder, 4, true));
+    EXPECT_FALSE(graph.Start(RecorderStages, 3, &recorder, 0, true));
+    EXPECT_FALSE(graph.Start(RecorderStages, 3, &recorder, FrameStageMaxJobs + 1, true));
+    EXPECT_FALSE(graph.IsRunning());
+
+    uint32_t job = 0;
+    EXPECT_FALSE(graph.TryAcquireJob(job));
+}
+
+namespace {
+
+//
+// 接在FrameWorkerLoop后面：OnFrame把帧拷到槽位后交给阶段图，返回后立即Release
+//
+struct StagedSink
+{
+    FakeSwapChain* SwapChain = nullptr;
+    FrameStageGraph* Graph = nullptr;
+    uint64_t Frames[FrameStageMaxJobs] = {};
+    std::atomic<uint64_t> Submitted{ 0 };
+
+    // 慢阶段处理帧N时已经释放的表面数减N，大于0说明获取线程领先
+    std::vector<int64_t> Lead;
+
+    void OnFrame(const FakeSwapChain::Frame& frame)
+    {
+        uint32_t job = 0;
+        if (!Graph->AcquireJob(job))
+        {
+            return;
+        }
+        Frames[job] = frame.FrameNumber;
+        Graph->Submit(job);
+        Submitted.fetch_add(1);
+    }
+
+    void OnDrained()
+    {
+    }
+
+    static bool Diff(void* context, uint32_t job)
+    {
+        (void)context;
+        (void)job;
+        return true;
+    }
+
+    static bool Convert(void* context, uint32_t job)
+    {
+        StagedSink* self = static_cast<StagedSink*>(context);
+        std::this_thread::sleep_for(std::chrono::microseconds(2000));
+        self->Lead.push_back((int64_t)self->SwapChain->Released() - (int64_t)self->Frames[job]);
+        self->Graph->Complete(job);
+        return true;
+    }
+};
+
+} // namespace
+
+TEST_CASE(FrameStageGraph_SurfaceReleasedBeforeSlowStage)
+{
+    FakeSwapChain swapChain;
+    FrameStageGraph graph;
+    StagedSink sink;
+    sink.SwapChain = &swapChain;
+    sink.Graph = &graph;
+
+    const FrameStageFunction stages[] = { &StagedSink::Diff, &StagedSink::Convert };
+    ASSERT_TRUE(graph.Start(stages, 2, &sink, 4, true));
+
+    FrameWorkerLoop<FakeSwapChain, StagedSink> loop(swapChain, sink);
+    std::thread worker([&] { loop.Run(); });
+
+    for (int i = 0; i < 16; i++)
+    {
+        swapChain.Present();
+    }
+
+    const auto deadline = FakeSwapChain::Clock::now() + std::chrono::seconds(5);
+    while (sink.Submitted.load() < 16 && FakeSwapChain::Clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    swapChain.RequestTerminate();
+    worker.join();
+    graph.Stop();
+
+    EXPECT_EQ(16u, (uint32_t)sink.Submitted.load());
+    EXPECT_EQ(16u, (uint32_t)swapChain.Released());
+    EXPECT_EQ(0, swapChain.Outstanding());
+    ASSERT_TRUE(sink.Lead.size() == 16);
+
+    // 每一帧到达慢阶段时它的表面都已释放，且获取线程领先了若干帧（受槽位数限制）
+    int64_t maxLead = 0;
+    for (int64_t lead : sink.Lead)
+    {
+        EXPECT_TRUE(lead >= 0);
+        maxLead = lead > maxLead ? lead : maxLead;
+    }
+    EXPECT_TRUE(maxLead >= 1 && maxLead <= 4);
+    EXPECT_TRUE(graph.Stats().JobWaits > 0);
+}
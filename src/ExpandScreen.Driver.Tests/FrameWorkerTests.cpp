@@ -0,0 +1,149 @@
+/*++
+
+Module Name:
+    FrameWorkerTests.cpp
+
+Abstract:
+    FrameWorkerLoop状态机测试
+
+--*/
+
+#include "TestHarness.h"
+#include "FakeSwapChain.h"
+
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+struct RecordingSink
+{
+    std::vector<uint64_t> FrameNumbers;
+    FakeSwapChain* SwapChain = nullptr;
+    int MaxOutstanding = 0;
+    int Drains = 0;
+
+    void OnFrame(const FakeSwapChain::Frame& frame)
+    {
+        FrameNumbers.push_back(frame.FrameNumber);
+        if (SwapChain != nullptr && SwapChain->Outstanding() > MaxOutstanding)
+        {
+            MaxOutstanding = SwapChain->Outstanding();
+        }
+    }
+
+    void OnDrained()
+    {
+        Drains++;
+    }
+};
+
+} // namespace
+
+TEST_CASE(FrameWorker_DrainsBurstInSingleWakeup)
+{
+    FakeSwapChain swapChain;
+    RecordingSink sink;
+    FrameWorkerLoop<FakeSwapChain, RecordingSink> loop(swapChain, sink);
+
+    for (int i = 0; i < 5; i++)
+    {
+        swapChain.Present();
+    }
+    swapChain.RequestTerminate();
+
+    EXPECT_TRUE(loop.Run() == WorkerExitReason::Terminated);
+    EXPECT_EQ(5u, sink.FrameNumbers.size());
+    EXPECT_EQ(5u, loop.Stats().MaxBurst);
+    EXPECT_EQ(5u, loop.Stats().FramesProcessed);
+
+    // 每次取空后通知一次：取到突发的那次，以及残留事件引起的一次空唤醒
+    EXPECT_EQ(2, sink.Drains);
+}
+
+TEST_CASE(FrameWorker_ReleasesEveryFrameBeforeAcquiringNext)
+{
+    FakeSwapChain swapChain;
+    RecordingSink sink;
+    sink.SwapChain = &swapChain;
+    FrameWorkerLoop<FakeSwapChain, RecordingSink> loop(swapChain, sink);
+
+    for (int i = 0; i < 8; i++)
+    {
+        swapChain.Present();
+    }
+    swapChain.RequestTerminate();
+    loop.Run();
+
+    EXPECT_EQ(1, sink.MaxOutstanding);
+    EXPECT_EQ(0, swapChain.Outstanding());
+    EXPECT_EQ(8u, swapChain.Released());
+}
+
+TEST_CASE(FrameWorker_ExitsWhenSwapChainInvalidated)
+{
+    FakeSwapChain swapChain;
+    RecordingSink sink;
+    FrameWorkerLoop<FakeSwapChain, RecordingSink> loop(swapChain, sink);
+
+    swapChain.Present();
+    swapChain.Invalidate();
+
+    EXPECT_TRUE(loop.Run() == WorkerExitReason::AcquireFailed);
+    EXPECT_EQ(0u, sink.FrameNumbers.size());
+}
+
+TEST_CASE(FrameWorker_ThreadedProducerDeliversAllFramesInOrder)
+{
+    const int frameCount = 2000;
+    FakeSwapChain swapChain;
+    RecordingSink sink;
+    FrameWorkerLoop<FakeSwapChain, RecordingSink> loop(swapChain, sink);
+
+    WorkerExitReason reason = WorkerExitReason::AcquireFailed;
+    std::thread worker([&] { reason = loop.Run(); });
+
+    for (int i = 0; i < frameCount; i++)
+    {
+        swapChain.Present();
+        if ((i % 64) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    // 等待消费完再终止，终止必须在线程退出前生效
+    while (swapChain.Released() < (uint64_t)frameCount)
+    {
+        std::this_thread::yield();
+    }
+    swapChain.RequestTerminate();
+    worker.join();
+
+    EXPECT_TRUE(reason == WorkerExitReason::Terminated);
+    ASSERT_TRUE(sink.FrameNumbers.size() == (size_t)frameCount);
+    for (int i = 0; i < frameCount; i++)
+    {
+        EXPECT_EQ((uint64_t)(i + 1), sink.FrameNumbers[i]);
+    }
+}
+
+TEST_CASE(FrameWorker_TerminateWhileIdleReturnsPromptly)
+{
+    FakeSwapChain swapChain;
+    swapChain.SetWaitTimeout(std::chrono::milliseconds(10000));
+    RecordingSink sink;
+    FrameWorkerLoop<FakeSwapChain, RecordingSink> loop(swapChain, sink);
+
+    auto start = FakeSwapChain::Clock::now();
+    std::thread worker([&] { loop.Run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    swapChain.RequestTerminate();
+    worker.join();
+
+    // 远小于等待超时，说明由终止事件唤醒而不是轮询
+    EXPECT_TRUE(FakeSwapChain::Clock::now() - start < std::chrono::milliseconds(2000));
+    EXPECT_EQ(0u, loop.Stats().Timeouts);
+}
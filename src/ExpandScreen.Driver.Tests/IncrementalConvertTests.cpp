@@ -0,0 +1,223 @@
+/*++
+
+Module Name:
+    IncrementalConvertTests.cpp
+
+Abstract:
+    增量NV12转换测试：脏矩形与移动区域（偶数对齐与未对齐）序列下常驻图像
+    始终等于当前帧的整帧转换；多槽位按帧号补拷损伤区域后与常驻图像一致
+
+--*/
+
+#include "TestHarness.h"
+#include "IncrementalConvert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int32_t TestWidth = 256;
+const int32_t TestHeight = 128;
+const size_t TestPitch = (size_t)TestWidth * 4;
+
+void FillRect(std::vector<uint8_t>& bgra, const FrameRect& rect, std::mt19937& rng)
+{
+    for (int32_t y = rect.Top; y < rect.Bottom; y++)
+    {
+        for (int32_t x = rect.Left; x < rect.Right; x++)
+        {
+            uint32_t pixel = rng() | 0xFF000000u;
+            std::memcpy(&bgra[(size_t)y * TestPitch + (size_t)x * 4], &pixel, 4);
+        }
+    }
+}
+
+FrameRect RandomRect(std::mt19937& rng)
+{
+    int32_t left = (int32_t)(rng() % (TestWidth - 8));
+    int32_t top = (int32_t)(rng() % (TestHeight - 8));
+    return
+    {
+        left,
+        top,
+        left + 1 + (int32_t)(rng() % (uint32_t)(TestWidth - left - 1)),
+        top + 1 + (int32_t)(rng() % (uint32_t)(TestHeight - top - 1))
+    };
+}
+
+// 垂直滚动：窗格内容移动dy，露出的条带记为脏矩形
+FrameMoveRegion Scroll(const FrameRect& pane, int32_t dy, std::vector<FrameRect>& dirty)
+{
+    if (dy > 0)
+    {
+        dirty.push_back({ pane.Left, pane.Bottom - dy, pane.Right, pane.Bottom });
+        return { pane.Left, pane.Top + dy, { pane.Left, pane.Top, pane.Right, pane.Bottom - dy } };
+    }
+
+    dirty.push_back({ pane.Left, pane.Top, pane.Right, pane.Top - dy });
+    return { pane.Left, pane.Top, { pane.Left, pane.Top - dy, pane.Right, pane.Bottom } };
+}
+
+std::vector<uint8_t> ConvertFull(const Nv12Converter& converter, const std::vector<uint8_t>& bgra)
+{
+    std::vector<uint8_t> nv12((size_t)TestWidth * TestHeight * 3 / 2);
+    Nv12Surface surface = { nv12.data(), (size_t)TestWidth,
+        nv12.data() + (size_t)TestWidth * TestHeight, (size_t)TestWidth };
+    converter.ConvertFrame(bgra.data(), TestPitch, TestWidth, TestHeight, surface);
+    return nv12;
+}
+
+std::vector<uint8_t> SurfaceBytes(IncrementalNv12Converter& incremental)
+{
+    const uint8_t* pixels = incremental.Surface().Y;
+    return std::vector<uint8_t>(pixels, pixels + (size_t)TestWidth * TestHeight * 3 / 2);
+}
+
+} // namespace
+
+TEST_CASE(IncrementalConvert_MatchesFullConversionUnderDirtyAndMoves)
+{
+    for (CpuLevel level : { CpuLevel::Scalar, CpuLevel::Avx512 })
+    {
+        std::mt19937 rng(11);
+        std::vector<uint8_t> bgra(TestPitch * TestHeight);
+        FillRect(bgra, { 0, 0, TestWidth, TestHeight }, rng);
+
+        IncrementalNv12Converter incremental(YuvMatrix::Bt709, YuvRange::Limited, level);
+        EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, nullptr, 0, nullptr, 0, 1));
+        EXPECT_TRUE(incremental.LastStats().FullFrame);
+        EXPECT_TRUE(SurfaceBytes(incremental) == ConvertFull(incremental.Converter(), bgra));
+
+        bool sawMoved = false;
+        for (uint64_t frame = 2; frame < 80; frame++)
+        {
+            std::vector<FrameRect> dirty;
+            std::vector<FrameMoveRegion> moves;
+
+            // 偶数位移可在NV12上直接移动，奇数位移（含奇数窗格边界）必须重新转换
+            if (frame % 3 != 0)
+            {
+                const FrameRect pane = frame % 2 ? FrameRect{ 16, 8, 200, 120 } : FrameRect{ 3, 5, 97, 111 };
+                int32_t dy = 1 + (int32_t)(rng() % 24);
+                moves.push_back(Scroll(pane, frame % 4 < 2 ? dy : -dy, dirty));
+                ApplyMoveRegions(bgra.data(), (uint32_t)TestPitch, 4, moves.data(), 1, TestWidth, TestHeight);
+            }
+
+            for (uint32_t i = rng() % 4; i > 0; i--)
+            {
+                dirty.push_back(RandomRect(rng));
+            }
+
+            for (const FrameRect& rect : dirty)
+            {
+                FillRect(bgra, rect, rng);
+            }
+
+            EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight,
+                dirty.data(), (uint32_t)dirty.size(), moves.data(), (uint32_t)moves.size(), frame));
+            EXPECT_FALSE(incremental.LastStats().FullFrame);
+            sawMoved = sawMoved || incremental.LastStats().MovedArea != 0;
+            ASSERT_TRUE(SurfaceBytes(incremental) == ConvertFull(incremental.Converter(), bgra));
+
+            for (const FrameRect& rect : incremental.Damage())
+            {
+                EXPECT_TRUE(((rect.Left | rect.Top | rect.Right | rect.Bottom) & 1) == 0);
+            }
+        }
+
+        EXPECT_TRUE(sawMoved);
+    }
+}
+
+TEST_CASE(IncrementalConvert_SlotsCatchUpFromTheirLastFrame)
+{
+    const uint32_t slotCount = 3;
+    const size_t planeBytes = (size_t)TestWidth * TestHeight * 3 / 2;
+    std::mt19937 rng(5);
+    std::vector<uint8_t> bgra(TestPitch * TestHeight);
+    FillRect(bgra, { 0, 0, TestWidth, TestHeight }, rng);
+
+    IncrementalNv12Converter incremental(YuvMatrix::Bt601, YuvRange::Full, CpuLevel::Avx2, 4);
+    std::vector<std::vector<uint8_t>> slots(slotCount, std::vector<uint8_t>(planeBytes, 0));
+    std::vector<uint64_t> slotFrames(slotCount, 0);
+
+    for (uint64_t frame = 1; frame < 40; frame++)
+    {
+        FrameRect dirty = { 20, 10, 52, 26 };
+        if (frame > 1)
+        {
+            dirty = RandomRect(rng);
+            dirty.Right = std::min(dirty.Right, dirty.Left + 40);
+            dirty.Bottom = std::min(dirty.Bottom, dirty.Top + 20);
+            FillRect(bgra, dirty, rng);
+        }
+
+        incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, &dirty, 1, nullptr, 0, frame);
+
+        // 帧号frame写入第frame % slotCount个槽位；第20帧模拟槽位内容被破坏
+        const uint32_t index = (uint32_t)(frame % slotCount);
+        uint64_t slotFrame = slotFrames[index];
+        if (frame == 20)
+        {
+            slots[index].assign(planeBytes, 0x55);
+            slotFrame = 0;
+        }
+
+        std::vector<uint8_t>& slot = slots[index];
+        Nv12Surface target = { slot.data(), (size_t)TestWidth,
+            slot.data() + (size_t)TestWidth * TestHeight, (size_t)TestWidth };
+        incremental.CopyTo(target, slotFrame);
+        slotFrames[index] = frame;
+
+        ASSERT_TRUE(slot == SurfaceBytes(incremental));
+        if (frame > slotCount && frame != 20)
+        {
+            // 三帧的损伤远小于整帧，只补拷损伤区域
+            EXPECT_TRUE(incremental.LastStats().CopiedBytes < planeBytes / 4);
+        }
+        else
+        {
+            EXPECT_EQ(incremental.LastStats().CopiedBytes, (uint64_t)planeBytes);
+        }
+    }
+
+    // 槽位落后超过历史深度时整帧拷贝
+    std::vector<uint8_t> stale(planeBytes, 0);
+    Nv12Surface target = { stale.data(), (size_t)TestWidth,
+        stale.data() + (size_t)TestWidth * TestHeight, (size_t)TestWidth };
+    incremental.CopyTo(target, incremental.CurrentFrame() - 5);
+    EXPECT_EQ(incremental.LastStats().CopiedBytes, (uint64_t)planeBytes);
+    EXPECT_TRUE(stale == SurfaceBytes(incremental));
+}
+
+TEST_CASE(IncrementalConvert_ResizeAndInvalidateForceFullFrame)
+{
+    std::mt19937 rng(9);
+    std::vector<uint8_t> bgra(TestPitch * TestHeight);
+    FillRect(bgra, { 0, 0, TestWidth, TestHeight }, rng);
+    const FrameRect dirty = { 0, 0, 2, 2 };
+
+    IncrementalNv12Converter incremental;
+    EXPECT_FALSE(incremental.Update(bgra.data(), TestPitch, TestWidth - 1, TestHeight, &dirty, 1, nullptr, 0, 1));
+    EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, &dirty, 1, nullptr, 0, 1));
+    EXPECT_TRUE(incremental.LastStats().FullFrame);
+
+    // 帧号必须递增
+    EXPECT_FALSE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, &dirty, 1, nullptr, 0, 1));
+
+    EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, &dirty, 1, nullptr, 0, 2));
+    EXPECT_EQ(incremental.LastStats().ConvertedArea, (int64_t)4);
+
+    incremental.Invalidate();
+    EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth, TestHeight, &dirty, 1, nullptr, 0, 3));
+    EXPECT_TRUE(incremental.LastStats().FullFrame);
+
+    EXPECT_TRUE(incremental.Update(bgra.data(), TestPitch, TestWidth / 2, TestHeight, &dirty, 1, nullptr, 0, 4));
+    EXPECT_TRUE(incremental.LastStats().FullFrame);
+    EXPECT_EQ(incremental.Width(), TestWidth / 2);
+}
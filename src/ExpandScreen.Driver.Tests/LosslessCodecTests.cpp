@@ -0,0 +1,359 @@
+/*++
+
+Module Name:
+    LosslessCodecTests.cpp
+
+Abstract:
+    无损瓦片编解码测试：平坦界面、抗锯齿文字和噪声分别走调色板、预测和原始模式，
+    各种宽高、游程与上一行匹配的边界都逐像素还原，各SIMD级别输出逐字节一致；
+    截断、篡改和越界放置的数据被拒绝
+
+--*/
+
+#include "TestHarness.h"
+#include "LosslessCodec.h"
+
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+struct Image
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;
+    std::vector<uint8_t> Pixels;
+
+    Image(int32_t width, int32_t height)
+        : Width(width), Height(height), Pitch((size_t)width * 4 + 12), Pixels(Pitch * height, 0)
+    {
+    }
+
+    uint32_t& At(int32_t x, int32_t y)
+    {
+        return reinterpret_cast<uint32_t*>(Pixels.data() + (size_t)y * Pitch)[x];
+    }
+
+    void Fill(const FrameRect& rect, uint32_t color)
+    {
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            for (int32_t x = rect.Left; x < rect.Right; x++)
+            {
+                At(x, y) = color;
+            }
+        }
+    }
+};
+
+//
+// 几个平坦色块加上少量颜色的“文字”笔画
+//
+void DrawFlatUi(Image& image, std::mt19937& rng, uint32_t colors)
+{
+    std::vector<uint32_t> palette;
+    for (uint32_t i = 0; i < colors; i++)
+    {
+        palette.push_back(0xFF000000u | (rng() & 0xFFFFFF));
+    }
+    image.Fill({ 0, 0, image.Width, image.Height }, palette[0]);
+    for (int i = 0; i < 12; i++)
+    {
+        const int32_t l = (int32_t)(rng() % image.Width), t = (int32_t)(rng() % image.Height);
+        const int32_t r = l + 1 + (int32_t)(rng() % 200), b = t + 1 + (int32_t)(rng() % 40);
+        image.Fill(IntersectRect({ l, t, r, b }, { 0, 0, image.Width, image.Height }), palette[rng() % colors]);
+    }
+}
+
+//
+// 抗锯齿文字：背景上的短笔画，边缘是与背景混合的灰阶
+//
+void DrawText(Image& image, std::mt19937& rng)
+{
+    image.Fill({ 0, 0, image.Width, image.Height }, 0xFFFFFFFFu);
+    for (int32_t y = 0; y < image.Height; y++)
+    {
+        if (y % 16 >= 11)
+        {
+            continue;
+        }
+        for (int32_t x = 0; x < image.Width; x++)
+        {
+            if (rng() % 3 == 0)
+            {
+                const uint32_t level = rng() % 256;
+                image.At(x, y) = 0xFF000000u | (level << 16) | (level << 8) | level;
+            }
+        }
+    }
+}
+
+void DrawNoise(Image& image, std::mt19937& rng)
+{
+    for (int32_t y = 0; y < image.Height; y++)
+    {
+        for (int32_t x = 0; x < image.Width; x++)
+        {
+            image.At(x, y) = rng();
+        }
+    }
+}
+
+bool RegionEqual(Image& a, Image& b, const FrameRect& rect, int32_t dx, int32_t dy)
+{
+    for (int32_t y = rect.Top; y < rect.Bottom; y++)
+    {
+        for (int32_t x = rect.Left; x < rect.Right; x++)
+        {
+            if (a.At(x, y) != b.At(x + dx, y + dy))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool RoundTrip(LosslessTileEncoder& encoder, Image& source, const FrameRect& rect, LosslessTileMode& mode)
+{
+    std::vector<uint8_t> stream(3, 0xAA);
+    const size_t size = encoder.Encode(source.Pixels.data(), source.Pitch, rect, stream);
+    mode = encoder.LastMode();
+    if (size == 0 || stream.size() != 3 + size || size > LosslessTileEncoder::MaxEncodedSize(rect.Width(), rect.Height()))
+    {
+        return false;
+    }
+
+    // 解码到另一幅图像的偏移位置
+    Image target(source.Width + 9, source.Height + 5);
+    LosslessTileDecoder decoder;
+    if (decoder.Decode(stream.data() + 3, size, target.Pixels.data(), target.Pitch, target.Width, target.Height,
+        rect.Left + 7, rect.Top + 3) != size)
+    {
+        return false;
+    }
+    return RegionEqual(source, target, rect, 7, 3);
+}
+
+} // namespace
+
+TEST_CASE(LosslessCodec_ChoosesModeByContent)
+{
+    std::mt19937 rng(31);
+    Image flat(256, 128), text(256, 128), noise(64, 64);
+    DrawFlatUi(flat, rng, 6);
+    DrawText(text, rng);
+    DrawNoise(noise, rng);
+
+    for (int level = 0; level <= (int)DetectCpuLevel(); level++)
+    {
+        LosslessTileEncoder encoder((CpuLevel)level);
+        LosslessTileMode mode;
+
+        EXPECT_TRUE(RoundTrip(encoder, flat, { 0, 0, 256, 128 }, mode));
+        EXPECT_TRUE(mode == LosslessTileMode::Palette);
+        EXPECT_TRUE(encoder.Stats().OutputBytes * 20 < encoder.Stats().InputBytes);
+
+        EXPECT_TRUE(RoundTrip(encoder, text, { 0, 0, 256, 128 }, mode));
+        EXPECT_TRUE(mode == LosslessTileMode::Predictive);
+
+        EXPECT_TRUE(RoundTrip(encoder, noise, { 3, 5, 60, 61 }, mode));
+        EXPECT_TRUE(mode == LosslessTileMode::Raw);
+
+        // 原始模式最坏只多一个头
+        const LosslessCodecStats& stats = encoder.Stats();
+        EXPECT_EQ(3u, (uint32_t)stats.Tiles);
+        EXPECT_EQ(1u, (uint32_t)stats.ModeTiles[(uint32_t)LosslessTileMode::Raw]);
+    }
+}
+
+TEST_CASE(LosslessCodec_RoundTripsEdgeShapesAtEveryLevel)
+{
+    std::mt19937 rng(7);
+    const CpuLevel best = DetectCpuLevel();
+
+    for (int iteration = 0; iteration < 300; iteration++)
+    {
+        const int32_t width = 1 + (int32_t)(rng() % 150);
+        const int32_t height = 1 + (int32_t)(rng() % 40);
+        Image image(width, height);
+
+        switch (iteration % 4)
+        {
+        case 0:
+            DrawFlatUi(image, rng, 1 + rng() % 15);
+            break;
+        case 1:
+            DrawFlatUi(image, rng, 16 + rng() % 20);
+            break;
+        case 2:
+            DrawText(image, rng);
+            break;
+        default:
+            // 重复的行（上一行匹配）夹杂单个像素的变化和alpha变化
+            DrawFlatUi(image, rng, 40);
+            for (int32_t y = 1; y < height; y++)
+            {
+                if (rng() % 2 == 0)
+                {
+                    std::memcpy(&image.At(0, y), &image.At(0, y - 1), (size_t)width * 4);
+                }
+                image.At((int32_t)(rng() % width), y) ^= rng() % 2 == 0 ? 0x01000000u : 0x00010203u;
+            }
+            break;
+        }
+
+        const int32_t l = (int32_t)(rng() % width), t = (int32_t)(rng() % height);
+        const FrameRect rect = { l, t, l + 1 + (int32_t)(rng() % (width - l)), t + 1 + (int32_t)(rng() % (height - t)) };
+
+        // 各SIMD级别的输出逐字节一致
+        std::vector<uint8_t> reference;
+        for (int level = 0; level <= (int)best; level++)
+        {
+            LosslessTileEncoder encoder((CpuLevel)level);
+            LosslessTileMode mode;
+            ASSERT_TRUE(RoundTrip(encoder, image, rect, mode));
+
+            std::vector<uint8_t> stream;
+            encoder.Encode(image.Pixels.data(), image.Pitch, rect, stream);
+            if (level == 0)
+            {
+                reference = stream;
+            }
+            EXPECT_TRUE(stream == reference);
+        }
+    }
+}
+
+TEST_CASE(LosslessCodec_SmallPaletteTilesStayWithinBound)
+{
+    // 调色板（1+4N字节）加记号可能超过小瓦片的原始大小：1x1瓦片需要6字节而原始只有4字节。
+    // 编码器不得写出MaxEncodedSize之外，改用原样存储（越界写入由ASan构建检出，见CMakeLists.txt）
+    std::mt19937 rng(11);
+    for (int32_t width = 1; width <= 4; width++)
+    {
+        for (int32_t height = 1; height <= 4; height++)
+        {
+            Image image(width, height);
+            for (int32_t y = 0; y < height; y++)
+            {
+                for (int32_t x = 0; x < width; x++)
+                {
+                    image.At(x, y) = 0xFF000000u | (uint32_t)(rng() % 3) * 0x00404040u;
+                }
+            }
+
+            LosslessTileEncoder encoder;
+            LosslessTileMode mode;
+            EXPECT_TRUE(RoundTrip(encoder, image, { 0, 0, width, height }, mode));
+            if (width * height == 1)
+            {
+                EXPECT_TRUE(mode == LosslessTileMode::Raw);
+            }
+        }
+    }
+}
+
+TEST_CASE(LosslessCodec_LongRunsAndRowMatches)
+{
+    // 游程长度跨过记号内联长度（16、48）与变长整数字节边界（128）
+    for (int32_t width : { 15, 16, 17, 47, 48, 49, 50, 64, 177, 200, 3000 })
+    {
+        Image image(width, 6);
+        image.Fill({ 0, 0, width, 6 }, 0xFF202020u);
+        image.Fill({ width / 3, 1, width, 2 }, 0xFF8080FFu);
+        for (int32_t x = 0; x < width; x++)
+        {
+            // 第3行每个像素不同（文字），第4行与其相同（上一行匹配）
+            image.At(x, 3) = 0xFF000000u | (((uint32_t)x * 2654435761u) >> 8);
+            image.At(x, 4) = image.At(x, 3);
+        }
+        image.At(width - 1, 5) = 0x80FFFFFFu;
+
+        LosslessTileEncoder encoder;
+        LosslessTileMode mode;
+        EXPECT_TRUE(RoundTrip(encoder, image, { 0, 0, width, 6 }, mode));
+        EXPECT_TRUE(RoundTrip(encoder, image, { 0, 0, width, 3 }, mode));
+        EXPECT_TRUE(mode == LosslessTileMode::Palette);
+    }
+
+    // 空矩形与过大的矩形不编码
+    Image image(4, 4);
+    LosslessTileEncoder encoder;
+    std::vector<uint8_t> stream;
+    EXPECT_EQ(0u, (uint32_t)encoder.Encode(image.Pixels.data(), image.Pitch, { 2, 2, 2, 4 }, stream));
+    EXPECT_EQ(0u, (uint32_t)encoder.Encode(image.Pixels.data(), image.Pitch, { 0, 0, 70000, 1 }, stream));
+    EXPECT_TRUE(stream.empty());
+}
+
+TEST_CASE(LosslessCodec_RejectsMalformedInput)
+{
+    std::mt19937 rng(3);
+    Image flat(96, 24), text(96, 24);
+    DrawFlatUi(flat, rng, 5);
+    DrawText(text, rng);
+    Image target(96, 24);
+    LosslessTileDecoder decoder;
+
+    for (Image* source : { &flat, &text })
+    {
+        LosslessTileEncoder encoder;
+        std::vector<uint8_t> stream;
+        const size_t size = encoder.Encode(source->Pixels.data(), source->Pitch, { 0, 0, 96, 24 }, stream);
+        ASSERT_TRUE(size > 0);
+
+        // 任何截断都缺少像素
+        for (size_t prefix = 0; prefix < size; prefix++)
+        {
+            EXPECT_EQ(0u, (uint32_t)decoder.Decode(stream.data(), prefix, target.Pixels.data(), target.Pitch,
+                96, 24, 0, 0));
+        }
+
+        // 放置越界
+        EXPECT_EQ(0u, (uint32_t)decoder.Decode(stream.data(), size, target.Pixels.data(), target.Pitch, 96, 24, 1, 0));
+        EXPECT_EQ(0u, (uint32_t)decoder.Decode(stream.data(), size, target.Pixels.data(), target.Pitch, 96, 24, 0, -1));
+        EXPECT_EQ(0u, (uint32_t)decoder.Decode(stream.data(), size, target.Pixels.data(), target.Pitch, 95, 24, 0, 0));
+
+        // 随机篡改：可以解码成别的像素，但不能越界读写或多消耗数据
+        for (int i = 0; i < 2000; i++)
+        {
+            std::vector<uint8_t> corrupt = stream;
+            for (int j = 0; j < 3; j++)
+            {
+                corrupt[rng() % size] = (uint8_t)rng();
+            }
+            const size_t consumed = decoder.Decode(corrupt.data(), size, target.Pixels.data(), target.Pitch,
+                96, 24, 0, 0);
+            EXPECT_TRUE(consumed <= size);
+        }
+    }
+
+    // 无效模式、零宽高、调色板颜色数无效、第一行引用上一行
+    const uint8_t badMode[] = { 3, 1, 0, 1, 0, 0, 0, 0, 0 };
+    const uint8_t zeroWidth[] = { 0, 0, 0, 1, 0 };
+    const uint8_t badPalette[] = { 1, 1, 0, 1, 0, 16 };
+    const uint8_t upOnFirstRow[] = { 1, 2, 0, 1, 0, 1, 1, 2, 3, 4, 0xF1 };
+    const uint8_t predictiveUp[] = { 2, 2, 0, 1, 0, 0xF1, 1 };
+    for (const auto& bad : { std::vector<uint8_t>(std::begin(badMode), std::end(badMode)),
+        std::vector<uint8_t>(std::begin(zeroWidth), std::end(zeroWidth)),
+        std::vector<uint8_t>(std::begin(badPalette), std::end(badPalette)),
+        std::vector<uint8_t>(std::begin(upOnFirstRow), std::end(upOnFirstRow)),
+        std::vector<uint8_t>(std::begin(predictiveUp), std::end(predictiveUp)) })
+    {
+        EXPECT_EQ(0u, (uint32_t)decoder.Decode(bad.data(), bad.size(), target.Pixels.data(), target.Pitch,
+            96, 24, 0, 0));
+    }
+
+    // 预测模式中未定义的操作码0xF2..0xFD（后随一个字节，按亮度差值解释会成功）
+    for (uint32_t op = 0xF2; op <= 0xFD; op++)
+    {
+        const uint8_t undefinedOp[] = { 2, 1, 0, 1, 0, (uint8_t)op, 0x88 };
+        EXPECT_EQ(0u, (uint32_t)decoder.Decode(undefinedOp, sizeof(undefinedOp), target.Pixels.data(), target.Pitch,
+            96, 24, 0, 0));
+    }
+}
@@ -0,0 +1,225 @@
+/*++
+
+Module Name:
+    MoveRegionTests.cpp
+
+Abstract:
+    移动区域测试：裁剪、重叠移动的正确性、节省面积统计，
+    以及经帧环发布后消费者用“移动+脏矩形”精确重建滚动帧
+
+--*/
+
+#include "TestHarness.h"
+#include "SharedMemory.h"
+#include "DirtyRectTraces.h"
+#include "FrameRing.h"
+#include "MoveRegion.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int32_t TestWidth = 96;
+const int32_t TestHeight = 64;
+const uint32_t TestPitch = TestWidth * 4;
+
+std::vector<uint32_t> RandomImage(uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> image((size_t)TestWidth * TestHeight);
+    for (uint32_t& pixel : image)
+    {
+        pixel = rng();
+    }
+    return image;
+}
+
+// 参考实现：目标区域逐像素从原图快照读取
+std::vector<uint32_t> ReferenceMove(const std::vector<uint32_t>& image, const FrameMoveRegion& move)
+{
+    std::vector<uint32_t> result = image;
+    for (int32_t y = 0; y < move.Destination.Height(); y++)
+    {
+        for (int32_t x = 0; x < move.Destination.Width(); x++)
+        {
+            result[(size_t)(move.Destination.Top + y) * TestWidth + move.Destination.Left + x] =
+                image[(size_t)(move.SourceY + y) * TestWidth + move.SourceX + x];
+        }
+    }
+    return result;
+}
+
+void CheckMove(const FrameMoveRegion& move)
+{
+    std::vector<uint32_t> image = RandomImage(7);
+    std::vector<uint32_t> expected = ReferenceMove(image, move);
+
+    ApplyMoveRegions(reinterpret_cast<uint8_t*>(image.data()), TestPitch, 4, &move, 1, TestWidth, TestHeight);
+    EXPECT_TRUE(image == expected);
+}
+
+} // namespace
+
+TEST_CASE(MoveRegion_OverlappingMovesMatchReference)
+{
+    CheckMove({ 4, 12, { 4, 2, 90, 52 } });     // 向上滚动
+    CheckMove({ 4, 2, { 4, 12, 90, 60 } });     // 向下滚动
+    CheckMove({ 10, 5, { 3, 5, 80, 50 } });     // 向左
+    CheckMove({ 3, 5, { 10, 5, 87, 50 } });     // 向右
+    CheckMove({ 3, 9, { 10, 2, 87, 50 } });     // 斜向
+}
+
+TEST_CASE(MoveRegion_ClipKeepsSourceAndDestinationInsideFrame)
+{
+    FrameMoveRegion moves[] =
+    {
+        { 0, 20, { 0, 0, 96, 64 } },            // 源越过底边
+        { -8, 0, { 0, 0, 40, 40 } },            // 源越过左边
+        { 5, 5, { 5, 5, 20, 20 } },             // 零位移
+        { 200, 0, { 0, 0, 10, 10 } }            // 源完全在帧外
+    };
+
+    uint32_t count = ClipMoveRegions(moves, 4, TestWidth, TestHeight);
+    ASSERT_TRUE(count == 2);
+
+    EXPECT_TRUE(moves[0].Destination == (FrameRect{ 0, 0, 96, 44 }));
+    EXPECT_EQ(20, moves[0].SourceY);
+    EXPECT_TRUE(moves[1].Destination == (FrameRect{ 8, 0, 40, 40 }));
+    EXPECT_EQ(0, moves[1].SourceX);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        FrameRect source = moves[i].Source();
+        EXPECT_TRUE(source == IntersectRect(source, { 0, 0, TestWidth, TestHeight }));
+    }
+}
+
+TEST_CASE(MoveRegion_MovedAreaNotDirtyCountsEachPixelOnce)
+{
+    FrameMoveRegion moves[] =
+    {
+        { 0, 10, { 0, 0, 100, 50 } },
+        { 0, 40, { 0, 30, 100, 60 } }           // 与第一个目标重叠20行
+    };
+    FrameRect dirty[] = { { 0, 45, 100, 60 }, { 10, 0, 20, 10 }, { 15, 5, 30, 10 } };
+
+    // 目标并集100x60，减去底部脏条带100x15，再减去左上两个相交小块的并集（100 + 75 - 25）
+    int64_t expected = 100 * 60 - 100 * 15 - (10 * 10 + 15 * 5 - 5 * 5);
+    EXPECT_EQ(expected, MovedAreaNotDirty(moves, 2, dirty, 3));
+    EXPECT_EQ(0, MovedAreaNotDirty(moves, 0, dirty, 3));
+}
+
+TEST_CASE(MoveRegion_RingCarriesMovesAndOverflowFallsBackToDirty)
+{
+    const uint64_t pixelBytes = (uint64_t)TestPitch * TestHeight;
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(2, pixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 2, pixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    ASSERT_TRUE(producer.Attach(region.Writable(), region.Size()));
+    ASSERT_TRUE(consumer.Attach(region.ReadOnly(), region.Size()));
+
+    const FrameDescriptor descriptor = { (uint32_t)TestWidth, (uint32_t)TestHeight, TestPitch, PixelFormat::Bgra8, 0, 0, YuvMatrix::Bt709, YuvRange::Limited, 0, 0, 0 };
+    FrameRect strip = { 0, 56, 96, 64 };
+    FrameMoveRegion scroll = { 0, 8, { 0, 0, 96, 56 } };
+
+    FrameWriteSlot slot = producer.BeginWrite();
+    producer.EndWrite(slot, descriptor, &strip, 1, &scroll, 1);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(1u, view.DirtyRectCount);
+    EXPECT_EQ(1u, view.MoveRegionCount);
+    EXPECT_EQ(8, view.MoveRegions[0].SourceY);
+    EXPECT_TRUE(view.MoveRegions[0].Destination == scroll.Destination);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 移动区域超过容量：全部放弃，目标区域并入脏矩形包围盒
+    FrameMoveRegion many[FrameRingMaxMoveRegions + 1];
+    for (uint32_t i = 0; i <= FrameRingMaxMoveRegions; i++)
+    {
+        many[i] = { 0, (int32_t)i + 1, { 0, (int32_t)i, 10, (int32_t)i + 1 } };
+    }
+
+    slot = producer.BeginWrite();
+    producer.EndWrite(slot, descriptor, &strip, 1, many, FrameRingMaxMoveRegions + 1);
+
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.MoveRegionCount);
+    EXPECT_EQ(1u, view.DirtyRectCount);
+    EXPECT_TRUE(view.DirtyRects[0] == (FrameRect{ 0, 0, 96, 64 }));
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(MoveRegion_ConsumerReconstructsScrollFromMovesAndDirtyStrips)
+{
+    const uint64_t pixelBytes = (uint64_t)TestPitch * TestHeight;
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, pixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, pixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    ASSERT_TRUE(producer.Attach(region.Writable(), region.Size()));
+    ASSERT_TRUE(consumer.Attach(region.ReadOnly(), region.Size()));
+
+    const FrameDescriptor descriptor = { (uint32_t)TestWidth, (uint32_t)TestHeight, TestPitch, PixelFormat::Bgra8, 0, 0, YuvMatrix::Bt709, YuvRange::Limited, 0, 0, 0 };
+    const FrameRect pane = { 8, 4, 88, 60 };
+
+    // 生产者侧的“屏幕”，消费者侧持有上一帧的副本
+    std::vector<uint32_t> screen = RandomImage(11);
+    std::vector<uint32_t> mirror = screen;
+    std::mt19937 rng(3);
+
+    for (int frame = 0; frame < 40; frame++)
+    {
+        int32_t dy = 1 + (int32_t)(rng() % 9);
+        if (frame % 10 >= 5)
+        {
+            dy = -dy;
+        }
+
+        // 屏幕上执行滚动，并在露出的条带中画新内容
+        std::vector<FrameRect> dirty;
+        FrameMoveRegion move = DirtyRectTraces::ScrollPane(pane, dy, dirty);
+        ApplyMoveRegions(reinterpret_cast<uint8_t*>(screen.data()), TestPitch, 4, &move, 1, TestWidth, TestHeight);
+        for (const FrameRect& rect : dirty)
+        {
+            for (int32_t y = rect.Top; y < rect.Bottom; y++)
+            {
+                for (int32_t x = rect.Left; x < rect.Right; x++)
+                {
+                    screen[(size_t)y * TestWidth + x] = rng();
+                }
+            }
+        }
+
+        FrameWriteSlot slot = producer.BeginWrite();
+        std::memcpy(slot.Pixels, screen.data(), pixelBytes);
+        producer.EndWrite(slot, descriptor, dirty.data(), (uint32_t)dirty.size(), &move, 1);
+
+        // 消费者：先移动，再只从共享内存拷贝脏矩形
+        FrameReadView view;
+        ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+        ASSERT_TRUE(view.Contiguous);
+
+        ApplyMoveRegions(reinterpret_cast<uint8_t*>(mirror.data()), TestPitch, 4,
+            view.MoveRegions, view.MoveRegionCount, TestWidth, TestHeight);
+        for (uint32_t i = 0; i < view.DirtyRectCount; i++)
+        {
+            const FrameRect& rect = view.DirtyRects[i];
+            for (int32_t y = rect.Top; y < rect.Bottom; y++)
+            {
+                std::memcpy(&mirror[(size_t)y * TestWidth + rect.Left],
+                    view.Pixels + (size_t)y * TestPitch + (size_t)rect.Left * 4,
+                    (size_t)rect.Width() * 4);
+            }
+        }
+
+        EXPECT_TRUE(consumer.EndRead(view));
+        EXPECT_TRUE(mirror == screen);
+    }
+}
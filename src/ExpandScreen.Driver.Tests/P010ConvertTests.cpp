@@ -0,0 +1,272 @@
+/*++
+
+Module Name:
+    P010ConvertTests.cpp
+
+Abstract:
+    P010转换测试：两种源格式下各SIMD内核与标量参考逐位一致（含尾部、行距填充、
+    子矩形），已知颜色取值、8位源扩展与NV12结果一致，以及10位渐变不再出现8位台阶
+
+--*/
+
+#include "TestHarness.h"
+#include "P010Convert.h"
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const CpuLevel AllLevels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+const PixelFormat AllSources[] = { PixelFormat::Bgra8, PixelFormat::R10G10B10A2 };
+const YuvMatrix AllMatrices[] = { YuvMatrix::Bt601, YuvMatrix::Bt709 };
+const YuvRange AllRanges[] = { YuvRange::Limited, YuvRange::Full };
+
+struct P010Buffer
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;                   // 字节
+    std::vector<uint16_t> Samples;
+
+    P010Buffer(int32_t width, int32_t height, size_t padding = 0)
+        : Width(width), Height(height), Pitch(((size_t)width + padding) * 2),
+          Samples(Pitch / 2 * (size_t)height * 3 / 2, 0xCDCD)
+    {
+    }
+
+    P010Surface Surface()
+    {
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(Samples.data());
+        return { bytes, Pitch, bytes + Pitch * (size_t)Height, Pitch };
+    }
+
+    uint16_t Y(int32_t x, int32_t y) const
+    {
+        return Samples[(size_t)y * (Pitch / 2) + x];
+    }
+
+    uint16_t UV(int32_t index, int32_t row) const
+    {
+        return Samples[(size_t)(Height + row) * (Pitch / 2) + index];
+    }
+};
+
+uint32_t PackR10(uint32_t r, uint32_t g, uint32_t b)
+{
+    return r | (g << 10) | (b << 20) | (3u << 30);
+}
+
+std::vector<uint8_t> RandomPixels(PixelFormat source, int32_t width, int32_t height, size_t pitch, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> pixels(pitch * (size_t)height);
+    for (uint8_t& b : pixels)
+    {
+        b = (uint8_t)rng();
+    }
+
+    // 混入纯黑、纯白与饱和色，覆盖钳位边界
+    const uint32_t specials8[] = { 0xFF000000u, 0xFFFFFFFFu, 0xFFFF0000u, 0xFF00FF00u, 0xFF0000FFu, 0x00FFFF00u };
+    const uint32_t specials10[] = { PackR10(0, 0, 0), PackR10(1023, 1023, 1023), PackR10(1023, 0, 0),
+        PackR10(0, 1023, 0), PackR10(0, 0, 1023), PackR10(1023, 1023, 0) };
+    const uint32_t* specials = source == PixelFormat::Bgra8 ? specials8 : specials10;
+    for (int i = 0; i < width * height / 8; i++)
+    {
+        size_t x = rng() % (uint32_t)width, y = rng() % (uint32_t)height;
+        std::memcpy(&pixels[y * pitch + x * 4], &specials[rng() % 6], 4);
+    }
+    return pixels;
+}
+
+// 单一颜色2x2帧转换结果（10位值）
+void ConvertSolid(PixelFormat source, uint32_t pixel, YuvMatrix matrix, YuvRange range, int& y, int& u, int& v)
+{
+    uint32_t pixels[4] = { pixel, pixel, pixel, pixel };
+    P010Buffer p010(2, 2);
+    P010Converter(source, matrix, range, CpuLevel::Scalar).ConvertFrame(
+        reinterpret_cast<const uint8_t*>(pixels), 8, 2, 2, p010.Surface());
+    y = p010.Y(0, 0) >> 6;
+    u = p010.UV(0, 0) >> 6;
+    v = p010.UV(1, 0) >> 6;
+}
+
+} // namespace
+
+TEST_CASE(P010Convert_AllKernelsMatchScalarReference)
+{
+    for (PixelFormat source : AllSources)
+    {
+        for (int32_t width : { 2, 6, 8, 10, 14, 16, 18, 30, 32, 34, 62, 66, 130, 1922 })
+        {
+            const int32_t height = 6;
+            const size_t pitch = (size_t)width * 4 + 20;
+            std::vector<uint8_t> pixels = RandomPixels(source, width, height, pitch, (uint32_t)width);
+
+            for (YuvMatrix matrix : AllMatrices)
+            {
+                for (YuvRange range : AllRanges)
+                {
+                    P010Buffer expected(width, height, 6);
+                    P010Converter(source, matrix, range, CpuLevel::Scalar).ConvertFrame(
+                        pixels.data(), pitch, width, height, expected.Surface());
+
+                    for (CpuLevel level : AllLevels)
+                    {
+                        P010Buffer actual(width, height, 6);
+                        P010Converter(source, matrix, range, level).ConvertFrame(
+                            pixels.data(), pitch, width, height, actual.Surface());
+                        EXPECT_TRUE(actual.Samples == expected.Samples);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(P010Convert_RectConversionTouchesOnlyAlignedRect)
+{
+    const int32_t width = 200, height = 40;
+    const size_t pitch = (size_t)width * 4;
+
+    for (PixelFormat source : AllSources)
+    {
+        std::vector<uint8_t> pixels = RandomPixels(source, width, height, pitch, 3);
+        for (CpuLevel level : AllLevels)
+        {
+            P010Converter converter(source, YuvMatrix::Bt709, YuvRange::Limited, level);
+            P010Buffer full(width, height);
+            converter.ConvertFrame(pixels.data(), pitch, width, height, full.Surface());
+
+            // 奇数边界向外对齐到(36, 4)-(172, 24)
+            P010Buffer partial(width, height);
+            converter.Convert(pixels.data(), pitch, width, height, partial.Surface(), { 37, 5, 171, 23 });
+
+            for (int32_t y = 0; y < height; y++)
+            {
+                for (int32_t x = 0; x < width; x++)
+                {
+                    bool inside = x >= 36 && x < 172 && y >= 4 && y < 24;
+                    ASSERT_TRUE(partial.Y(x, y) == (inside ? full.Y(x, y) : 0xCDCD));
+                }
+            }
+
+            for (int32_t y = 0; y < height / 2; y++)
+            {
+                for (int32_t x = 0; x < width; x++)
+                {
+                    bool inside = x >= 36 && x < 172 && y >= 2 && y < 12;
+                    ASSERT_TRUE(partial.UV(x, y) == (inside ? full.UV(x, y) : 0xCDCD));
+                }
+            }
+        }
+    }
+
+    // 不支持的源格式不写任何样本
+    P010Converter invalid(PixelFormat::Nv12);
+    EXPECT_FALSE(invalid.IsValid());
+    P010Buffer untouched(4, 4);
+    std::vector<uint8_t> pixels(64, 0xFF);
+    invalid.ConvertFrame(pixels.data(), 16, 4, 4, untouched.Surface());
+    EXPECT_EQ(0xCDCD, untouched.Y(0, 0));
+}
+
+TEST_CASE(P010Convert_KnownColors)
+{
+    int y, u, v;
+
+    // 黑、白：8位与10位源得到相同的10位端点
+    for (PixelFormat source : AllSources)
+    {
+        const bool bgra = source == PixelFormat::Bgra8;
+        ConvertSolid(source, bgra ? 0xFF000000u : PackR10(0, 0, 0), YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+        EXPECT_EQ(64, y); EXPECT_EQ(512, u); EXPECT_EQ(512, v);
+        ConvertSolid(source, bgra ? 0xFFFFFFFFu : PackR10(1023, 1023, 1023), YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+        EXPECT_EQ(940, y); EXPECT_EQ(512, u); EXPECT_EQ(512, v);
+        ConvertSolid(source, bgra ? 0xFFFFFFFFu : PackR10(1023, 1023, 1023), YuvMatrix::Bt601, YuvRange::Full, y, u, v);
+        EXPECT_EQ(1023, y); EXPECT_EQ(512, u); EXPECT_EQ(512, v);
+    }
+
+    // 纯红BT.709有限范围：(250, 409, 960)
+    ConvertSolid(PixelFormat::R10G10B10A2, PackR10(1023, 0, 0), YuvMatrix::Bt709, YuvRange::Limited, y, u, v);
+    EXPECT_TRUE(y >= 249 && y <= 251); EXPECT_TRUE(u >= 408 && u <= 410); EXPECT_EQ(960, v);
+
+    // 纯蓝完整范围：U钳位到上限1023
+    ConvertSolid(PixelFormat::Bgra8, 0xFF0000FFu, YuvMatrix::Bt601, YuvRange::Full, y, u, v);
+    EXPECT_TRUE(y >= 115 && y <= 117); EXPECT_EQ(1023, u);
+}
+
+TEST_CASE(P010Convert_Bgra8ExpansionMatchesNv12)
+{
+    // 有限范围下10位结果应约为8位结果的4倍（8位已舍入，允许±2）
+    const int32_t width = 64, height = 8;
+    const size_t pitch = (size_t)width * 4;
+    std::vector<uint8_t> bgra = RandomPixels(PixelFormat::Bgra8, width, height, pitch, 9);
+
+    for (YuvMatrix matrix : AllMatrices)
+    {
+        std::vector<uint8_t> nv12((size_t)width * height * 3 / 2);
+        Nv12Surface nv12Surface = { nv12.data(), (size_t)width, nv12.data() + (size_t)width * height, (size_t)width };
+        Nv12Converter(matrix, YuvRange::Limited).ConvertFrame(bgra.data(), pitch, width, height, nv12Surface);
+
+        P010Buffer p010(width, height);
+        P010Converter(PixelFormat::Bgra8, matrix, YuvRange::Limited).ConvertFrame(
+            bgra.data(), pitch, width, height, p010.Surface());
+
+        for (int32_t y = 0; y < height; y++)
+        {
+            for (int32_t x = 0; x < width; x++)
+            {
+                const int expected = nv12[(size_t)y * width + x] * 4;
+                const int actual = p010.Y(x, y) >> 6;
+                ASSERT_TRUE(actual >= expected - 2 && actual <= expected + 2);
+                ASSERT_TRUE((p010.Y(x, y) & 0x3F) == 0);
+            }
+        }
+
+        for (int32_t y = 0; y < height / 2; y++)
+        {
+            for (int32_t x = 0; x < width; x++)
+            {
+                const int expected = nv12[(size_t)width * height + (size_t)y * width + x] * 4;
+                const int actual = p010.UV(x, y) >> 6;
+                ASSERT_TRUE(actual >= expected - 2 && actual <= expected + 2);
+            }
+        }
+    }
+}
+
+TEST_CASE(P010Convert_TenBitGradientKeepsAllLevels)
+{
+    // 横向1024级灰阶：NV12只剩220级，P010保留有限范围内的全部877级
+    const int32_t width = 1024, height = 2;
+    std::vector<uint32_t> ramp((size_t)width * height);
+    for (int32_t y = 0; y < height; y++)
+    {
+        for (int32_t x = 0; x < width; x++)
+        {
+            ramp[(size_t)y * width + x] = PackR10((uint32_t)x, (uint32_t)x, (uint32_t)x);
+        }
+    }
+
+    P010Buffer p010(width, height);
+    P010Converter(PixelFormat::R10G10B10A2, YuvMatrix::Bt709, YuvRange::Limited).ConvertFrame(
+        reinterpret_cast<const uint8_t*>(ramp.data()), (size_t)width * 4, width, height, p010.Surface());
+
+    std::set<uint16_t> levels;
+    uint16_t previous = 0;
+    for (int32_t x = 0; x < width; x++)
+    {
+        const uint16_t value = p010.Y(x, 0);
+        EXPECT_TRUE(value >= previous);
+        levels.insert(value);
+        previous = value;
+    }
+    EXPECT_EQ(877u, levels.size());
+    EXPECT_EQ(64, p010.Y(0, 0) >> 6);
+    EXPECT_EQ(940, p010.Y(width - 1, 0) >> 6);
+}
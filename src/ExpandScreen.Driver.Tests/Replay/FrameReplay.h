@@ -0,0 +1,773 @@
+/*++
+
+Module Name:
+    FrameReplay.h
+
+Abstract:
+    帧录制回放：把录制文件（见Pipeline/FrameCapture.h）中的提交与光标事件按记录
+    时间重新送进驱动交换链路径所用的同一套可移植模块，逐阶段计时。
+
+    FrameReplayer按驱动FrameRing.cpp与SwapChain.cpp的顺序调用这些模块：
+        CaptureFrame        损伤合并、内容节奏、定速
+        DiffStage           逐像素比较/块哈希剔除、合并
+        PublishStage        分类、视频区域、写槽位；补偿帧为静止后的补偿帧
+    驱动的比较级与发布级在流水线上并行（FrameStageGraph），回放与关闭流水线时一样
+    在同一线程上依次执行，发布结果相同，Frame阶段为两级耗时之和。
+    驱动侧的IddCx与D3D部分（获取缓冲区、拷贝到暂存纹理、映射）在此由录制的补丁
+    还原图像代替，不计入阶段耗时。
+
+    所有决策只依赖记录中的时间戳：唤醒时间为下一条记录的时间或定速/补偿的截止
+    时间，与回放速度无关，同一录制与配置的发布结果（Digest）逐次相同。调用者可以
+    传入等待函数，在每次唤醒前按原速等到对应的墙钟时间。
+
+--*/
+
+#pragma once
+
+#include "ContentCadence.h"
+#include "DirtyRegion.h"
+#include "FrameCapture.h"
+#include "FrameDiff.h"
+#include "FramePacer.h"
+#include "FrameRing.h"
+#include "IncrementalConvert.h"
+#include "StaticRefinement.h"
+#include "TaskExecutor.h"
+#include "TileClassifier.h"
+#include "TileHash.h"
+#include "VideoRegion.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//
+// 计时的阶段，与驱动中的调用一一对应
+//
+enum class ReplayStage : uint32_t
+{
+    Decode,         // 还原录制的图像（代替拷贝到暂存纹理，不属于驱动路径）
+    Capture,        // CaptureFrame：损伤合并、内容节奏、定速
+    Filter,         // FrameDiff/TileHash剔除未变化的区域
+    Coalesce,       // DirtyRegions.Coalesce
+    Classify,       // ContentClassifier.Classify
+    Regions,        // VideoRegions.Update与Cadence.OnContentFrame
+    Convert,        // NV12增量转换并拷入槽位（BGRA时为整帧拷贝）
+    Publish,        // 写槽位元数据与EndWrite
+    Frame,          // 一帧经过比较级与发布级的总耗时
+    Count
+};
+
+constexpr uint32_t ReplayStageCount = (uint32_t)ReplayStage::Count;
+
+inline const char* ReplayStageName(ReplayStage stage)
+{
+    static const char* const names[ReplayStageCount] =
+    {
+        "Decode", "Capture", "Filter", "Coalesce", "Classify", "Regions", "Convert", "Publish", "Frame"
+    };
+    return (uint32_t)stage < ReplayStageCount ? names[(uint32_t)stage] : "?";
+}
+
+//
+// 回放配置，默认值与驱动一致
+//
+struct ReplayConfig
+{
+    bool ExactDiff = true;
+    ExpandScreen::Pipeline::PixelFormat OutputFormat = ExpandScreen::Pipeline::PixelFormat::Nv12;
+    uint32_t SlotCount = 3;
+    uint32_t Workers = ExpandScreen::Pipeline::WorkStealingExecutor::DefaultWorkerCount(); // 0表示在回放线程上转换
+    ExpandScreen::Pipeline::StaticRefinementConfig Refinement;
+    ExpandScreen::Pipeline::ContentClassifierConfig Content;
+    ExpandScreen::Pipeline::VideoRegionConfig Video;
+    ExpandScreen::Pipeline::ContentCadenceConfig Cadence;
+};
+
+struct ReplayStats
+{
+    uint64_t Presents = 0;          // 回放的提交数
+    uint64_t CursorEvents = 0;
+    uint64_t InvalidRecords = 0;    // 未提交、被丢弃或无法解析的记录
+    uint64_t Frames = 0;            // 发布的帧数（不含补偿帧）
+    uint64_t Refinements = 0;       // 发布的补偿帧数
+    uint64_t Drops[ExpandScreen::Pipeline::FrameDropReasonCount] = {};
+    uint64_t Digest = 0;            // 全部发布帧的描述、脏矩形与像素的哈希
+    int64_t Duration = 0;           // 第一条到最后一条记录的录制时长（计数）
+};
+
+class FrameReplayer
+{
+public:
+    using WaitFunction = std::function<void(int64_t time)>;
+
+    explicit FrameReplayer(const ReplayConfig& config = ReplayConfig())
+        : m_Config(config)
+    {
+        if (m_Config.Workers != 0)
+        {
+            m_Executor.reset(new ExpandScreen::Pipeline::WorkStealingExecutor(m_Config.Workers));
+            m_Nv12Frame.SetExecutor(m_Executor.get());
+        }
+    }
+
+    ~FrameReplayer()
+    {
+        std::free(m_Ring);
+    }
+
+    FrameReplayer(const FrameReplayer&) = delete;
+    FrameReplayer& operator=(const FrameReplayer&) = delete;
+
+    //
+    // 回放整个录制。wait在每次唤醒前以录制时间调用，为空时按最快速度
+    //
+    bool Run(const ExpandScreen::Pipeline::FrameCaptureReader& reader, const WaitFunction& wait = WaitFunction())
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        if (!reader.IsAttached())
+        {
+            return false;
+        }
+
+        // 帧环槽位按录制中最大的帧分配
+        const uint32_t count = reader.RecordCount();
+        uint64_t maxPixelBytes = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CaptureRecordView record;
+            CaptureFrameView frame;
+            if (reader.Record(i, record) && FrameCaptureReader::ParseFrame(record, frame))
+            {
+                const uint64_t bytes = (uint64_t)frame.Frame.Width * frame.Frame.Height * 4;
+                maxPixelBytes = bytes > maxPixelBytes ? bytes : maxPixelBytes;
+            }
+        }
+
+        if (maxPixelBytes == 0 || !Start(reader.Header(), maxPixelBytes))
+        {
+            return false;
+        }
+
+        bool first = true;
+        int64_t firstTime = 0;
+        int64_t lastTime = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CaptureRecordView record;
+            if (!reader.Record(i, record))
+            {
+                m_Stats.InvalidRecords++;
+                continue;
+            }
+
+            firstTime = first ? record.Time : firstTime;
+            lastTime = record.Time > lastTime || first ? record.Time : lastTime;
+            first = false;
+
+            RunTimers(record.Time, wait);
+            if (wait)
+            {
+                wait(record.Time);
+            }
+
+            CaptureFrameView frame;
+            CursorEvent event;
+            if (FrameCaptureReader::ParseFrame(record, frame))
+            {
+                if (!CaptureFrame(frame))
+                {
+                    m_Stats.InvalidRecords++;
+                    continue;
+                }
+                OnDrained(record.Time);
+            }
+            else if (FrameCaptureReader::ParseCursor(record, event))
+            {
+                m_Stats.CursorEvents++;
+                m_InputTime = event.Time;
+            }
+            else
+            {
+                m_Stats.InvalidRecords++;
+            }
+        }
+
+        // 最后一次提交之后的定速发布与补偿帧
+        RunTimers(INT64_MAX, wait);
+
+        m_Stats.Duration = lastTime - firstTime;
+        for (uint32_t i = 0; i < FrameDropReasonCount; i++)
+        {
+            m_Stats.Drops[i] = m_Producer.Drops((FrameDropReason)i);
+        }
+        return true;
+    }
+
+    const ReplayStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 某一阶段每次调用的耗时（微秒）
+    //
+    const std::vector<double>& StageSamples(ReplayStage stage) const
+    {
+        return m_Samples[(uint32_t)stage];
+    }
+
+    const ExpandScreen::Pipeline::FramePacer& Pacer() const
+    {
+        return m_Pacer;
+    }
+
+    const ExpandScreen::Pipeline::ContentCadenceDetector& Cadence() const
+    {
+        return m_Cadence;
+    }
+
+    const ExpandScreen::Pipeline::VideoRegionDetector& VideoRegions() const
+    {
+        return m_VideoRegions;
+    }
+
+    const ExpandScreen::Pipeline::StaticRefinementPolicy& Refinement() const
+    {
+        return m_Refinement;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    //
+    // 计时一个阶段
+    //
+    class StageTimer
+    {
+    public:
+        StageTimer(FrameReplayer& owner, ReplayStage stage)
+            : m_Owner(owner), m_Stage(stage), m_Start(Clock::now())
+        {
+        }
+
+        ~StageTimer()
+        {
+            m_Owner.m_Samples[(uint32_t)m_Stage].push_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - m_Start).count());
+        }
+
+    private:
+        FrameReplayer& m_Owner;
+        ReplayStage m_Stage;
+        Clock::time_point m_Start;
+    };
+
+    //
+    // 按录制头配置各模块，与StartSwapChainProcessing一致
+    //
+    bool Start(const ExpandScreen::Pipeline::FrameCaptureHeader& header, uint64_t maxPixelBytes)
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        m_Stats = ReplayStats();
+        for (std::vector<double>& samples : m_Samples)
+        {
+            samples.clear();
+        }
+
+        m_Pacer.Configure(header.TicksPerSecond, header.RefreshNumerator, header.RefreshDenominator);
+        m_Pacer.ResetStats();
+        m_Damage.Clear();
+        m_Now = 0;
+        m_Width = 0;
+        m_Height = 0;
+        m_PendingPresentTime = 0;
+        m_PendingAcquireTime = 0;
+        m_PendingPresentFrameNumber = 0;
+        m_InputTime = 0;
+        m_Canvas.Reset();
+        m_FrameDiff.Reset();
+        m_TileHashes.Reset();
+
+        // 帧环重新格式化后发布序号从1开始，转换历史需一并丢弃
+        m_Nv12Frame = ExpandScreen::Pipeline::IncrementalNv12Converter();
+        m_Nv12Frame.SetExecutor(m_Executor.get());
+
+        const int64_t period = m_Pacer.Period() != 0 ? m_Pacer.Period() : header.TicksPerSecond / 60;
+        m_Refinement.Configure(m_Config.Refinement, period);
+        m_Refinement.ResetStats();
+        m_ContentClassifier.Configure(m_Config.Content, period);
+        m_VideoRegions.Configure(m_Config.Video, period);
+        m_VideoRegions.ResetStats();
+        m_Cadence.Configure(m_Config.Cadence, m_Pacer.Period());
+        m_Cadence.ResetStats();
+
+        const uint64_t ringSize = FrameRingLayout::RequiredSize(m_Config.SlotCount, maxPixelBytes);
+        if (ringSize > m_RingSize)
+        {
+            std::free(m_Ring);
+            m_RingSize = ringSize;
+            m_Ring = std::aligned_alloc(FrameRingPageSize, (size_t)m_RingSize);
+        }
+        return m_Ring != nullptr &&
+            FrameRingProducer::Format(m_Ring, m_RingSize, m_Config.SlotCount, maxPixelBytes) &&
+            m_Producer.Attach(m_Ring, m_RingSize);
+    }
+
+    //
+    // 处理截止时间不晚于until的定速发布与补偿帧（驱动中由定速定时器唤醒）
+    //
+    void RunTimers(int64_t until, const WaitFunction& wait)
+    {
+        for (;;)
+        {
+            int64_t deadline;
+            if (m_Pacer.HasPending())
+            {
+                deadline = m_Pacer.Deadline() > m_Now ? m_Pacer.Deadline() : m_Now;
+            }
+            else if (m_Refinement.HasPending())
+            {
+                deadline = m_Refinement.Deadline() > m_Now ? m_Refinement.Deadline() : m_Now;
+            }
+            else
+            {
+                return;
+            }
+
+            if (deadline > until)
+            {
+                return;
+            }
+            if (wait)
+            {
+                wait(deadline);
+            }
+            OnDrained(deadline);
+        }
+    }
+
+    //
+    // SwapChainFrameSink::OnDrained
+    //
+    void OnDrained(int64_t now)
+    {
+        m_Now = now;
+        m_Published = nullptr;
+        if (m_Pacer.ShouldEmit(now))
+        {
+            StageTimer timer(*this, ReplayStage::Frame);
+            PublishPendingFrame(now);
+        }
+        else if (!m_Pacer.HasPending() && m_Refinement.ShouldRefine(now))
+        {
+            PublishRefinementFrame(now);
+        }
+
+        if (m_Published != nullptr)
+        {
+            Digest();
+        }
+    }
+
+    //
+    // CaptureFrame：暂存纹理换成录制还原的图像
+    //
+    bool CaptureFrame(const ExpandScreen::Pipeline::CaptureFrameView& view)
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        {
+            StageTimer timer(*this, ReplayStage::Decode);
+            if (!m_Canvas.Apply(view))
+            {
+                return false;
+            }
+        }
+
+        StageTimer timer(*this, ReplayStage::Capture);
+        m_Stats.Presents++;
+        m_Now = view.Frame.AcquireTime > m_Now ? view.Frame.AcquireTime : m_Now;
+
+        const int32_t width = (int32_t)view.Frame.Width;
+        const int32_t height = (int32_t)view.Frame.Height;
+        if (width != m_Width || height != m_Height)
+        {
+            m_Cadence.Reset();
+            m_Damage.Clear();
+            m_Damage.AddFullFrame();
+            m_Width = width;
+            m_Height = height;
+        }
+
+        // 录制中的矩形不保证对齐，拷出后使用
+        m_RawDirtyRects.resize(view.Frame.DirtyRectCount);
+        m_RawMoveRegions.resize(view.Frame.MoveRegionCount);
+        if (!m_RawDirtyRects.empty())
+        {
+            std::memcpy(m_RawDirtyRects.data(), view.DirtyRects, m_RawDirtyRects.size() * sizeof(FrameRect));
+        }
+        if (!m_RawMoveRegions.empty())
+        {
+            std::memcpy(m_RawMoveRegions.data(), view.MoveRegions, m_RawMoveRegions.size() * sizeof(FrameMoveRegion));
+        }
+
+        FrameRect presentBounds = { 0, 0, width, height };
+        if ((view.Frame.Flags & CaptureFrameDamageUnknown) == 0)
+        {
+            m_Damage.Add(
+                m_RawDirtyRects.data(),
+                (uint32_t)m_RawDirtyRects.size(),
+                m_RawMoveRegions.data(),
+                (uint32_t)m_RawMoveRegions.size());
+
+            presentBounds = FrameRect();
+            for (const FrameRect& rect : m_RawDirtyRects)
+            {
+                presentBounds = UnionRect(presentBounds, rect);
+            }
+            for (const FrameMoveRegion& move : m_RawMoveRegions)
+            {
+                presentBounds = UnionRect(presentBounds, move.Destination);
+            }
+        }
+        else
+        {
+            m_Damage.AddFullFrame();
+        }
+
+        m_PendingPresentTime = view.Frame.PresentTime;
+        m_PendingAcquireTime = view.Frame.AcquireTime;
+        m_PendingPresentFrameNumber = view.Frame.PresentFrameNumber;
+
+        if (m_InputTime != 0)
+        {
+            m_Cadence.OnInput(m_InputTime);
+        }
+        m_Pacer.OnPresent(view.Frame.PresentTime, m_Cadence.OnPresent(view.Frame.PresentTime, presentBounds));
+        return true;
+    }
+
+    //
+    // SubmitPendingFrame：比较级（DiffStage）与发布级（PublishStage）依次执行
+    //
+    void PublishPendingFrame(int64_t now)
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        m_Pacer.OnEmit(now);
+
+        const int32_t width = m_Width;
+        const int32_t height = m_Height;
+
+        if (m_Damage.FrameCount() > 1)
+        {
+            m_Producer.RecordDrop(FrameDropReason::Coalesced, m_Damage.FrameCount() - 1);
+        }
+
+        if ((uint64_t)width * 4 * height > m_Producer.MaxPixelBytes())
+        {
+            m_Producer.RecordDrop(FrameDropReason::Failed);
+            m_Damage.Clear();
+            return;
+        }
+
+        const uint8_t* pixels = m_Canvas.Pixels();
+        const size_t pitch = m_Canvas.Pitch();
+
+        const FrameRect fullFrame = { 0, 0, width, height };
+        const FrameRect* filterInput = m_Damage.Dirty().data();
+        uint32_t filterCount = (uint32_t)m_Damage.Dirty().size();
+        const FrameMoveRegion* moveRegions = m_Damage.Moves().data();
+        uint32_t moveRegionCount = (uint32_t)m_Damage.Moves().size();
+
+        FrameRect dirtyRects[FrameRingMaxDirtyRects];
+        uint32_t dirtyRectCount;
+        FrameRect reportedBounds = {};
+        {
+            StageTimer timer(*this, ReplayStage::Filter);
+            if (m_Damage.FullFrame())
+            {
+                m_FrameDiff.Reset();
+                m_TileHashes.Reset();
+                filterInput = &fullFrame;
+                filterCount = 1;
+                moveRegionCount = 0;
+            }
+            else if (!m_Config.ExactDiff)
+            {
+                for (uint32_t i = 0; i < moveRegionCount; i++)
+                {
+                    m_TileHashes.Invalidate(&moveRegions[i].Destination, 1);
+                }
+            }
+
+            for (uint32_t i = 0; i < filterCount; i++)
+            {
+                reportedBounds = UnionRect(reportedBounds, filterInput[i]);
+            }
+            for (uint32_t i = 0; i < moveRegionCount; i++)
+            {
+                reportedBounds = UnionRect(reportedBounds, moveRegions[i].Destination);
+            }
+
+            if (m_Config.ExactDiff)
+            {
+                m_FrameDiff.Diff(pixels, pitch, width, height, filterInput, filterCount,
+                    moveRegions, moveRegionCount, m_ChangedRects);
+            }
+            else
+            {
+                m_TileHashes.Filter(pixels, pitch, width, height, filterInput, filterCount, m_ChangedRects);
+            }
+        }
+
+        {
+            StageTimer timer(*this, ReplayStage::Coalesce);
+            dirtyRectCount = m_DirtyRegions.Coalesce(
+                m_ChangedRects.data(),
+                (uint32_t)m_ChangedRects.size(),
+                width,
+                height,
+                dirtyRects,
+                FrameRingMaxDirtyRects);
+        }
+
+        if (dirtyRectCount == 0 && moveRegionCount == 0)
+        {
+            m_Producer.RecordDrop(FrameDropReason::Unchanged);
+            m_Damage.Clear();
+            return;
+        }
+
+        FrameRect damageRects[FrameRingMaxDirtyRects + FrameRingMaxMoveRegions];
+        uint32_t damageCount = 0;
+        for (uint32_t i = 0; i < dirtyRectCount; i++)
+        {
+            damageRects[damageCount++] = dirtyRects[i];
+        }
+        for (uint32_t i = 0; i < moveRegionCount && i < FrameRingMaxMoveRegions; i++)
+        {
+            damageRects[damageCount++] = moveRegions[i].Destination;
+        }
+
+        {
+            StageTimer timer(*this, ReplayStage::Classify);
+            m_ContentClassifier.Classify(pixels, pitch, width, height, damageRects, damageCount, now);
+        }
+        {
+            StageTimer timer(*this, ReplayStage::Regions);
+            m_VideoRegions.Update(width, height, damageRects, damageCount, now);
+            m_Cadence.OnContentFrame(m_PendingPresentTime, reportedBounds);
+        }
+
+        WriteFrameSlot(dirtyRects, dirtyRectCount, moveRegions, moveRegionCount,
+            dirtyRects, dirtyRectCount, 0, now);
+        m_Stats.Frames++;
+
+        m_Refinement.OnDamage(damageRects, damageCount, width, height, now);
+        m_Damage.Clear();
+    }
+
+    //
+    // SubmitRefinementFrame：发布级以最近发布的内容发布补偿帧
+    //
+    void PublishRefinementFrame(int64_t now)
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        FrameRect regionRects[FrameRingMaxDirtyRects];
+        const std::vector<FrameRect>& region = m_Refinement.Region();
+        uint32_t regionCount = 0;
+        for (; regionCount < (uint32_t)region.size() && regionCount < FrameRingMaxDirtyRects; regionCount++)
+        {
+            regionRects[regionCount] = region[regionCount];
+        }
+
+        m_Refinement.OnRefined(now);
+        if (regionCount == 0 || m_Width == 0 ||
+            (uint64_t)m_Width * 4 * m_Height > m_Producer.MaxPixelBytes())
+        {
+            return;
+        }
+
+        m_VideoRegions.Update(m_Width, m_Height, nullptr, 0, now);
+        WriteFrameSlot(nullptr, 0, nullptr, 0, regionRects, regionCount, FrameFlagRefinement, now);
+        m_Stats.Refinements++;
+    }
+
+    //
+    // WriteFrameSlot
+    //
+    void WriteFrameSlot(
+        const ExpandScreen::Pipeline::FrameRect* convertRects,
+        uint32_t convertCount,
+        const ExpandScreen::Pipeline::FrameMoveRegion* moveRegions,
+        uint32_t moveRegionCount,
+        const ExpandScreen::Pipeline::FrameRect* dirtyRects,
+        uint32_t dirtyRectCount,
+        uint32_t flags,
+        int64_t publishTime)
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        const int32_t width = m_Width;
+        const int32_t height = m_Height;
+        const uint32_t pitch = (uint32_t)width * 4;
+        FrameWriteSlot slot;
+        FrameDescriptor descriptor = {};
+        uint64_t slotPublish = 0;
+
+        // 写元数据分在转换前后两段，合计为一次Publish
+        Clock::time_point start = Clock::now();
+        {
+            slot = m_Producer.BeginWrite();
+            m_Producer.SetContentClasses(
+                slot, m_ContentClassifier.Columns(), m_ContentClassifier.Rows(), m_ContentClassifier.Classes());
+            m_Producer.SetVideoRegions(slot, m_VideoRegions.Regions(), m_VideoRegions.RegionCount());
+
+            const FrameDescriptor& previous = slot.Header->Descriptor;
+            if (previous.Format == PixelFormat::Nv12 &&
+                previous.Width == (uint32_t)width &&
+                previous.Height == (uint32_t)height &&
+                previous.Pitch == (uint32_t)width)
+            {
+                slotPublish = slot.PreviousPublish;
+            }
+            descriptor.Width = (uint32_t)width;
+            descriptor.Height = (uint32_t)height;
+        }
+        double publishUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        {
+            StageTimer timer(*this, ReplayStage::Convert);
+            if (m_Config.OutputFormat == PixelFormat::Nv12 &&
+                m_Nv12Frame.Update(
+                    m_Canvas.Pixels(),
+                    m_Canvas.Pitch(),
+                    width,
+                    height,
+                    convertRects,
+                    convertCount,
+                    moveRegions,
+                    moveRegionCount,
+                    slot.PublishNumber))
+            {
+                Nv12Surface target = {};
+                target.Y = slot.Pixels;
+                target.YPitch = (size_t)width;
+                target.UV = slot.Pixels + (size_t)width * height;
+                target.UVPitch = (size_t)width;
+
+                m_Nv12Frame.CopyTo(target, slotPublish);
+
+                descriptor.Pitch = (uint32_t)width;
+                descriptor.Format = PixelFormat::Nv12;
+                descriptor.Matrix = m_Nv12Frame.Converter().Matrix();
+                descriptor.Range = m_Nv12Frame.Converter().Range();
+            }
+            else
+            {
+                for (int32_t y = 0; y < height; y++)
+                {
+                    std::memcpy(slot.Pixels + (size_t)y * pitch, m_Canvas.Pixels() + (size_t)y * m_Canvas.Pitch(), pitch);
+                }
+                descriptor.Pitch = pitch;
+                descriptor.Format = PixelFormat::Bgra8;
+            }
+        }
+
+        start = Clock::now();
+        {
+            descriptor.PresentTime = m_PendingPresentTime;
+            descriptor.AcquireTime = m_PendingAcquireTime;
+            descriptor.PublishTime = publishTime;
+            descriptor.PresentFrameNumber = m_PendingPresentFrameNumber;
+            descriptor.Flags = flags;
+            m_Producer.EndWrite(slot, descriptor, dirtyRects, dirtyRectCount, moveRegions, moveRegionCount);
+        }
+        publishUs += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        m_Samples[(uint32_t)ReplayStage::Publish].push_back(publishUs);
+
+        m_Published = slot.Header;
+        m_PublishedPixels = slot.Pixels;
+    }
+
+    //
+    // 把刚发布的槽位并入摘要，在阶段计时之外调用
+    //
+    void Digest()
+    {
+        using namespace ExpandScreen::Pipeline;
+
+        const FrameSlotHeader& header = *m_Published;
+        const FrameDescriptor& descriptor = header.Descriptor;
+        const uint32_t rows = descriptor.Format == PixelFormat::Nv12 ? descriptor.Height * 3 / 2 : descriptor.Height;
+        const uint32_t rowBytes = descriptor.Format == PixelFormat::Nv12 ? descriptor.Width : descriptor.Width * 4;
+
+        Mix(descriptor.Width);
+        Mix(descriptor.Height);
+        Mix((uint64_t)descriptor.Format);
+        Mix(descriptor.Flags);
+        Mix((uint64_t)descriptor.PresentTime);
+        Mix((uint64_t)descriptor.PublishTime);
+        Mix(header.FrameNumber);
+        Mix(header.DirtyRectCount);
+        Mix(header.MoveRegionCount);
+        for (uint32_t i = 0; i < header.DirtyRectCount; i++)
+        {
+            const FrameRect& rect = header.DirtyRects[i];
+            Mix(((uint64_t)(uint32_t)rect.Left << 32) | (uint32_t)rect.Top);
+            Mix(((uint64_t)(uint32_t)rect.Right << 32) | (uint32_t)rect.Bottom);
+        }
+        Mix(header.VideoRegionCount);
+        Mix(m_HashPixels(m_PublishedPixels, rowBytes, rowBytes, rows));
+    }
+
+    void Mix(uint64_t value)
+    {
+        m_Stats.Digest = (m_Stats.Digest ^ value) * 0x100000001B3ull + 0x9E3779B97F4A7C15ull;
+    }
+
+    ReplayConfig m_Config;
+    ReplayStats m_Stats;
+    std::vector<double> m_Samples[ReplayStageCount];
+    int64_t m_Now = 0;
+    const ExpandScreen::Pipeline::FrameSlotHeader* m_Published = nullptr;   // 本次唤醒发布的槽位
+    const uint8_t* m_PublishedPixels = nullptr;
+
+    // 与FRAME_PIPELINE对应
+    std::vector<ExpandScreen::Pipeline::FrameRect> m_RawDirtyRects;
+    ExpandScreen::Pipeline::DirtyRegionCoalescer m_DirtyRegions;
+    std::vector<ExpandScreen::Pipeline::FrameMoveRegion> m_RawMoveRegions;
+    ExpandScreen::Pipeline::TileHasher m_TileHashes;
+    ExpandScreen::Pipeline::FrameDiffer m_FrameDiff;
+    std::vector<ExpandScreen::Pipeline::FrameRect> m_ChangedRects;
+    ExpandScreen::Pipeline::IncrementalNv12Converter m_Nv12Frame;
+    ExpandScreen::Pipeline::FramePacer m_Pacer;
+    ExpandScreen::Pipeline::FrameDamageAccumulator m_Damage;
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    int64_t m_PendingPresentTime = 0;
+    int64_t m_PendingAcquireTime = 0;
+    uint64_t m_PendingPresentFrameNumber = 0;
+    ExpandScreen::Pipeline::StaticRefinementPolicy m_Refinement;
+    ExpandScreen::Pipeline::TileContentClassifier m_ContentClassifier;
+    ExpandScreen::Pipeline::VideoRegionDetector m_VideoRegions;
+    ExpandScreen::Pipeline::ContentCadenceDetector m_Cadence;
+    int64_t m_InputTime = 0;
+
+    std::unique_ptr<ExpandScreen::Pipeline::WorkStealingExecutor> m_Executor;
+    ExpandScreen::Pipeline::CaptureFrameCanvas m_Canvas;
+    void* m_Ring = nullptr;
+    uint64_t m_RingSize = 0;
+    ExpandScreen::Pipeline::FrameRingProducer m_Producer;
+    ExpandScreen::Pipeline::TileHashFunction m_HashPixels =
+        ExpandScreen::Pipeline::SelectTileHash(ExpandScreen::Pipeline::DetectCpuLevel());
+};
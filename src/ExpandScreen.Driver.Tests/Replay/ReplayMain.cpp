@@ -0,0 +1,253 @@
+/*++
+
+Module Name:
+    ReplayMain.cpp
+
+Abstract:
+    帧录制回放工具：把驱动录制的文件送进交换链路径的可移植模块，输出发布统计、
+    摘要与各阶段耗时分布。
+
+        ExpandScreen.Driver.Replay <录制文件> [选项]
+            --realtime      按录制时的节奏回放（默认按最快速度）
+            --repeat N      回放N次，耗时合并统计，并检查每次的摘要相同
+            --workers N     NV12转换的工作线程数，0表示在回放线程上转换
+            --bgra          发布BGRA而非NV12
+            --tile-hash     用块哈希代替逐像素比较剔除未变化的区域
+
+    摘要只取决于录制与选项，不同构建之间摘要不同说明发布结果变了，摘要相同时
+    阶段耗时的差异即为性能差异。
+
+--*/
+
+#include "Replay/FrameReplay.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+double Percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    size_t index = (size_t)((p / 100.0) * (double)(samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+int Usage()
+{
+    std::fprintf(stderr,
+        "用法：ExpandScreen.Driver.Replay <录制文件> [--realtime] [--repeat N] [--workers N] [--bgra] [--tile-hash]\n");
+    return 2;
+}
+
+//
+// 只读映射录制文件
+//
+class MappedFile
+{
+public:
+    explicit MappedFile(const char* path)
+    {
+        m_Fd = open(path, O_RDONLY);
+        struct stat info;
+        if (m_Fd < 0 || fstat(m_Fd, &info) != 0 || info.st_size <= 0)
+        {
+            return;
+        }
+
+        void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_Fd, 0);
+        if (view != MAP_FAILED)
+        {
+            m_View = view;
+            m_Size = (size_t)info.st_size;
+        }
+    }
+
+    ~MappedFile()
+    {
+        if (m_View != nullptr)
+        {
+            munmap(m_View, m_Size);
+        }
+        if (m_Fd >= 0)
+        {
+            close(m_Fd);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const void* View() const { return m_View; }
+    size_t Size() const { return m_Size; }
+
+private:
+    int m_Fd = -1;
+    void* m_View = nullptr;
+    size_t m_Size = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    bool realtime = false;
+    uint32_t repeat = 1;
+    ReplayConfig config;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--realtime") == 0)
+        {
+            realtime = true;
+        }
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = (uint32_t)std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            config.Workers = (uint32_t)std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--bgra") == 0)
+        {
+            config.OutputFormat = PixelFormat::Bgra8;
+        }
+        else if (std::strcmp(argv[i], "--tile-hash") == 0)
+        {
+            config.ExactDiff = false;
+        }
+        else if (argv[i][0] != '-' && path == nullptr)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (path == nullptr)
+    {
+        return Usage();
+    }
+
+    MappedFile file(path);
+    FrameCaptureReader reader;
+    if (file.View() == nullptr || !reader.Attach(file.View(), file.Size()))
+    {
+        std::fprintf(stderr, "无法读取录制文件：%s\n", path);
+        return 1;
+    }
+
+    const FrameCaptureHeader& header = reader.Header();
+    std::printf("录制：%s，记录%u条（丢弃%llu），计数频率%lld，刷新率%u/%u\n",
+        path,
+        reader.RecordCount(),
+        (unsigned long long)header.DroppedRecords.load(),
+        (long long)header.TicksPerSecond,
+        header.RefreshNumerator,
+        header.RefreshDenominator);
+
+    // 原速回放：第一次唤醒对齐到当前墙钟，之后按录制时间差等待
+    bool started = false;
+    int64_t base = 0;
+    std::chrono::steady_clock::time_point origin;
+    FrameReplayer::WaitFunction wait;
+    if (realtime && header.TicksPerSecond > 0)
+    {
+        wait = [&](int64_t time)
+        {
+            if (!started)
+            {
+                started = true;
+                base = time;
+                origin = std::chrono::steady_clock::now();
+                return;
+            }
+            const double seconds = (double)(time - base) / (double)header.TicksPerSecond;
+            std::this_thread::sleep_until(origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(seconds)));
+        };
+    }
+
+    FrameReplayer replayer(config);
+    std::vector<double> samples[ReplayStageCount];
+    ReplayStats stats;
+    for (uint32_t run = 0; run < repeat; run++)
+    {
+        started = false;
+        if (!replayer.Run(reader, wait))
+        {
+            std::fprintf(stderr, "录制中没有可回放的帧\n");
+            return 1;
+        }
+        if (run != 0 && replayer.Stats().Digest != stats.Digest)
+        {
+            std::fprintf(stderr, "第%u次回放的摘要与第一次不同\n", run + 1);
+            return 1;
+        }
+        stats = replayer.Stats();
+        for (uint32_t stage = 0; stage < ReplayStageCount; stage++)
+        {
+            const std::vector<double>& current = replayer.StageSamples((ReplayStage)stage);
+            samples[stage].insert(samples[stage].end(), current.begin(), current.end());
+        }
+    }
+
+    std::printf("提交%llu，光标事件%llu，无效记录%llu，时长%.2fs\n",
+        (unsigned long long)stats.Presents,
+        (unsigned long long)stats.CursorEvents,
+        (unsigned long long)stats.InvalidRecords,
+        header.TicksPerSecond > 0 ? (double)stats.Duration / (double)header.TicksPerSecond : 0.0);
+    std::printf("发布%llu，补偿帧%llu，合并%llu，未变化%llu，覆盖%llu，失败%llu\n",
+        (unsigned long long)stats.Frames,
+        (unsigned long long)stats.Refinements,
+        (unsigned long long)stats.Drops[(uint32_t)FrameDropReason::Coalesced],
+        (unsigned long long)stats.Drops[(uint32_t)FrameDropReason::Unchanged],
+        (unsigned long long)stats.Drops[(uint32_t)FrameDropReason::Superseded],
+        (unsigned long long)stats.Drops[(uint32_t)FrameDropReason::Failed]);
+    std::printf("定速合并提交%llu，节奏降频%llu次\n",
+        (unsigned long long)replayer.Pacer().Stats().Coalesced,
+        (unsigned long long)replayer.Cadence().Stats().Activations);
+    std::printf("摘要：%016llx\n", (unsigned long long)stats.Digest);
+
+    std::printf("各阶段耗时：\n");
+    for (uint32_t stage = 0; stage < ReplayStageCount; stage++)
+    {
+        std::vector<double>& values = samples[stage];
+        double total = 0.0;
+        for (double value : values)
+        {
+            total += value;
+        }
+        std::printf("  %-8s %7zu次  p50=%8.1fus  p90=%8.1fus  p99=%8.1fus  最大=%8.1fus  合计=%8.2fms\n",
+            ReplayStageName((ReplayStage)stage),
+            values.size(),
+            Percentile(values, 50),
+            Percentile(values, 90),
+            Percentile(values, 99),
+            Percentile(values, 100),
+            total / 1000.0);
+    }
+
+    return 0;
+}
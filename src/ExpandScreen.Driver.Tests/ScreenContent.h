@@ -0,0 +1,218 @@
+/*++
+
+Module Name:
+    ScreenContent.h
+
+Abstract:
+    合成桌面内容的绘制工具：平坦色块、抗锯齿文字、渐变图标、带噪声的“照片”，
+    以及由它们组成的典型截图（IDE、设置面板、含照片的网页）
+
+--*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace ScreenContent {
+
+class Canvas
+{
+public:
+    Canvas(int32_t width, int32_t height, uint32_t background)
+        : m_Width(width), m_Height(height), m_Pixels((size_t)width * height, background)
+    {
+    }
+
+    int32_t Width() const { return m_Width; }
+    int32_t Height() const { return m_Height; }
+    size_t Pitch() const { return (size_t)m_Width * 4; }
+
+    const uint8_t* Data() const
+    {
+        return reinterpret_cast<const uint8_t*>(m_Pixels.data());
+    }
+
+    uint32_t& At(int32_t x, int32_t y)
+    {
+        return m_Pixels[(size_t)y * m_Width + x];
+    }
+
+    std::vector<uint8_t> Bytes() const
+    {
+        std::vector<uint8_t> bytes(Pitch() * m_Height);
+        std::memcpy(bytes.data(), m_Pixels.data(), bytes.size());
+        return bytes;
+    }
+
+    void Fill(int32_t left, int32_t top, int32_t right, int32_t bottom, uint32_t color)
+    {
+        for (int32_t y = std::max(top, 0); y < std::min(bottom, m_Height); y++)
+        {
+            for (int32_t x = std::max(left, 0); x < std::min(right, m_Width); x++)
+            {
+                At(x, y) = color;
+            }
+        }
+    }
+
+    //
+    // 抗锯齿文字：每个8像素字形格内的横竖笔画，笔画两侧各一个与背景混合的过渡像素；
+    // lineHeight为行距，每行长度随机
+    //
+    void Text(int32_t left, int32_t top, int32_t right, int32_t lines, uint32_t ink, uint32_t seed,
+        int32_t lineHeight = 18)
+    {
+        std::mt19937 rng(seed);
+        for (int32_t line = 0; line < lines; line++)
+        {
+            const int32_t baseline = top + line * lineHeight;
+            const int32_t length = left + (right - left) * (40 + (int32_t)(rng() % 60)) / 100;
+            for (int32_t cell = left; cell + 8 <= length; cell += 8)
+            {
+                const uint32_t glyph = rng();
+                if ((glyph & 15) == 0)
+                {
+                    continue;   // 空格
+                }
+                const int32_t stemX = cell + 1 + (int32_t)((glyph >> 4) % 5);
+                const int32_t barY = baseline + 3 + (int32_t)((glyph >> 8) % 8);
+                for (int32_t y = baseline + 2; y < baseline + 13; y++)
+                {
+                    Blend(stemX, y, ink, 255);
+                    Blend(stemX - 1, y, ink, 60 + (glyph >> 12) % 64);
+                    Blend(stemX + 1, y, ink, 40 + (glyph >> 18) % 64);
+                }
+                for (int32_t x = cell; x < cell + 7; x++)
+                {
+                    Blend(x, barY, ink, 255);
+                    Blend(x, barY + 1, ink, 90);
+                }
+            }
+        }
+    }
+
+    //
+    // 图标：径向渐变的圆
+    //
+    void Icon(int32_t centerX, int32_t centerY, int32_t radius, uint32_t color)
+    {
+        for (int32_t y = centerY - radius; y < centerY + radius; y++)
+        {
+            for (int32_t x = centerX - radius; x < centerX + radius; x++)
+            {
+                const double d = std::sqrt((double)(x - centerX) * (x - centerX) + (double)(y - centerY) * (y - centerY));
+                if (d < radius)
+                {
+                    Blend(x, y, color, (uint32_t)(255 * (1.0 - d / radius * 0.6)));
+                }
+            }
+        }
+    }
+
+    //
+    // 照片：平滑起伏的色彩加传感器噪声；phase平移画面，连续的phase模拟视频帧
+    //
+    void Photo(int32_t left, int32_t top, int32_t right, int32_t bottom, uint32_t seed = 11, double phase = 0.0)
+    {
+        std::mt19937 rng(seed);
+        for (int32_t y = std::max(top, 0); y < std::min(bottom, m_Height); y++)
+        {
+            for (int32_t x = std::max(left, 0); x < std::min(right, m_Width); x++)
+            {
+                const double fx = x * 0.013 + phase, fy = y * 0.021 + phase * 0.5;
+                const uint32_t b = (uint32_t)(128 + 90 * std::sin(fx + std::cos(fy * 1.7)) + (int)(rng() % 9) - 4) & 0xFF;
+                const uint32_t g = (uint32_t)(128 + 80 * std::cos(fy + std::sin(fx * 1.3)) + (int)(rng() % 9) - 4) & 0xFF;
+                const uint32_t r = (uint32_t)(128 + 70 * std::sin(fx * 0.7 + fy)) & 0xFF;
+                At(x, y) = 0xFF000000u | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+
+    void Blend(int32_t x, int32_t y, uint32_t color, uint32_t alpha)
+    {
+        if (x < 0 || y < 0 || x >= m_Width || y >= m_Height)
+        {
+            return;
+        }
+        uint32_t& pixel = At(x, y);
+        uint32_t result = 0xFF000000u;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            const uint32_t a = (pixel >> shift) & 0xFF, b = (color >> shift) & 0xFF;
+            result |= ((a * (255 - alpha) + b * alpha + 127) / 255) << shift;
+        }
+        pixel = result;
+    }
+
+private:
+    int32_t m_Width;
+    int32_t m_Height;
+    std::vector<uint32_t> m_Pixels;
+};
+
+//
+// IDE：深色标题栏、侧边栏文件树、浅色编辑区大量文字、选中行、状态栏
+//
+inline Canvas DrawIde(int32_t width, int32_t height)
+{
+    Canvas ide(width, height, 0xFFFFFFFFu);
+    ide.Fill(0, 0, width, 32, 0xFF2D2D30u);
+    ide.Fill(0, 32, 300, height, 0xFFF3F3F3u);
+    ide.Fill(300, 32, 348, height, 0xFFEBEBEBu);
+    ide.Fill(348, 302, width, 320, 0xFFADD6FFu);
+    ide.Text(8, 8, 400, 1, 0xFFCCCCCCu, 1);
+    ide.Text(20, 44, 290, (height - 70) / 18, 0xFF333333u, 2);
+    ide.Text(306, 44, 344, (height - 70) / 18, 0xFF2B91AFu, 3);
+    ide.Text(360, 44, width - 20, (height - 70) / 18, 0xFF000000u, 4);
+    ide.Fill(0, height - 24, width, height, 0xFF007ACCu);
+    ide.Text(8, height - 22, 900, 1, 0xFFFFFFFFu, 5);
+    return ide;
+}
+
+//
+// 设置面板：平坦卡片、按钮、图标，少量文字
+//
+inline Canvas DrawSettings(int32_t width, int32_t height)
+{
+    Canvas settings(width, height, 0xFFF0F0F0u);
+    settings.Fill(0, 0, width, 40, 0xFFFFFFFFu);
+    settings.Text(16, 12, 300, 1, 0xFF000000u, 6);
+    for (int32_t i = 0; 80 + i * 120 + 100 <= height; i++)
+    {
+        const int32_t top = 80 + i * 120;
+        settings.Fill(200, top, width - 200, top + 100, 0xFFFFFFFFu);
+        settings.Fill(200, top + 99, width - 200, top + 100, 0xFFE0E0E0u);
+        settings.Icon(250, top + 50, 22, 0xFF0078D7u + (uint32_t)i * 0x102030u);
+        settings.Text(300, top + 20, 900, 2, 0xFF1F1F1Fu, 10 + (uint32_t)i);
+        settings.Fill(width - 360, top + 34, width - 240, top + 66, 0xFF0078D7u);
+        settings.Text(width - 340, top + 41, width - 260, 1, 0xFFFFFFFFu, 30 + (uint32_t)i);
+    }
+    return settings;
+}
+
+//
+// 网页：地址栏、文字段落中间一张照片（photo返回照片区域）
+//
+inline Canvas DrawWebPage(int32_t width, int32_t height, int32_t photo[4])
+{
+    Canvas web(width, height, 0xFFFFFFFFu);
+    web.Fill(0, 0, width, 72, 0xFFDEE1E6u);
+    web.Text(12, 10, width * 5 / 8, 1, 0xFF202124u, 40);
+    web.Fill(12, 40, width - 12, 66, 0xFFFFFFFFu);
+    web.Text(24, 44, width * 3 / 8, 1, 0xFF5F6368u, 41);
+    web.Text(width * 3 / 16, 110, width * 13 / 16, 14, 0xFF202124u, 42);
+    photo[0] = width * 7 / 24;
+    photo[1] = height * 19 / 54;
+    photo[2] = width * 17 / 24;
+    photo[3] = height * 83 / 108;
+    web.Photo(photo[0], photo[1], photo[2], photo[3]);
+    web.Text(width * 3 / 16, photo[3] + 30, width * 13 / 16, (height - photo[3] - 60) / 18, 0xFF202124u, 43);
+    return web;
+}
+
+} // namespace ScreenContent
@@ -0,0 +1,67 @@
+/*++
+
+Module Name:
+    SharedMemory.h
+
+Abstract:
+    Linux匿名共享内存（memfd），用于模拟驱动与用户态之间的共享节：
+    生产者读写映射，消费者只读映射
+
+--*/
+
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+
+class SharedMemoryRegion
+{
+public:
+    explicit SharedMemoryRegion(size_t size)
+        : m_Size(size)
+    {
+        m_Fd = memfd_create("ExpandScreenFrameRing", 0);
+        if (m_Fd < 0 || ftruncate(m_Fd, (off_t)size) != 0)
+        {
+            return;
+        }
+
+        void* writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_Fd, 0);
+        void* readOnly = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_Fd, 0);
+        m_Writable = (writable == MAP_FAILED) ? nullptr : writable;
+        m_ReadOnly = (readOnly == MAP_FAILED) ? nullptr : readOnly;
+    }
+
+    ~SharedMemoryRegion()
+    {
+        if (m_Writable != nullptr)
+        {
+            munmap(m_Writable, m_Size);
+        }
+        if (m_ReadOnly != nullptr)
+        {
+            munmap(m_ReadOnly, m_Size);
+        }
+        if (m_Fd >= 0)
+        {
+            close(m_Fd);
+        }
+    }
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    bool IsValid() const { return m_Writable != nullptr && m_ReadOnly != nullptr; }
+    void* Writable() const { return m_Writable; }
+    const void* ReadOnly() const { return m_ReadOnly; }
+    size_t Size() const { return m_Size; }
+
+private:
+    int m_Fd = -1;
+    size_t m_Size;
+    void* m_Writable = nullptr;
+    void* m_ReadOnly = nullptr;
+};
@@ -0,0 +1,147 @@
+/*++
+
+Module Name:
+    SimulatedClock.h
+
+Abstract:
+    确定性的模拟时钟，以及按提交时间表驱动FramePacer的帧处理线程模拟：
+    新帧事件与定速定时器各自带有可配置的唤醒延迟（固定种子的伪随机），
+    同样的输入总是得到同样的发布时间序列
+
+--*/
+
+#pragma once
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+class SimulatedClock
+{
+public:
+    explicit SimulatedClock(int64_t ticksPerSecond = 10000000)
+        : m_Frequency(ticksPerSecond)
+    {
+    }
+
+    int64_t Frequency() const
+    {
+        return m_Frequency;
+    }
+
+    int64_t Now() const
+    {
+        return m_Now;
+    }
+
+    void AdvanceTo(int64_t time)
+    {
+        if (time > m_Now)
+        {
+            m_Now = time;
+        }
+    }
+
+    void Advance(int64_t ticks)
+    {
+        m_Now += ticks;
+    }
+
+    int64_t FromMicroseconds(double us) const
+    {
+        return (int64_t)(us * (double)m_Frequency / 1e6);
+    }
+
+    double ToMicroseconds(int64_t ticks) const
+    {
+        return (double)ticks * 1e6 / (double)m_Frequency;
+    }
+
+private:
+    int64_t m_Frequency;
+    int64_t m_Now = 0;
+};
+
+//
+// 唤醒延迟模型：每次唤醒在[Min, Max]内均匀取值（计数）
+//
+struct WakeLatencyModel
+{
+    int64_t Min = 0;
+    int64_t Max = 0;
+    uint32_t Seed = 1;
+};
+
+struct PacingEmit
+{
+    int64_t Time;
+    uint32_t Presents;          // 本次发布合并的提交数
+};
+
+//
+// 模拟帧处理线程：新帧事件唤醒后取空所有已到达的提交，再检查是否发布；
+// 有挂起帧时定时器在区间边界唤醒。presentTimes需升序
+//
+inline std::vector<PacingEmit> SimulatePacing(
+    ExpandScreen::Pipeline::FramePacer& pacer,
+    SimulatedClock& clock,
+    const std::vector<int64_t>& presentTimes,
+    const WakeLatencyModel& latency = WakeLatencyModel())
+{
+    const int64_t never = std::numeric_limits<int64_t>::max();
+    std::mt19937 rng(latency.Seed);
+    auto wakeLatency = [&]()
+    {
+        if (latency.Max <= latency.Min)
+        {
+            return latency.Min;
+        }
+        return latency.Min + (int64_t)(rng() % (uint64_t)(latency.Max - latency.Min + 1));
+    };
+
+    std::vector<PacingEmit> emits;
+    size_t next = 0;
+    int64_t presentWake = next < presentTimes.size() ? presentTimes[next] + wakeLatency() : never;
+    int64_t timerWake = never;
+
+    while (presentWake != never || pacer.HasPending())
+    {
+        if (pacer.HasPending() && timerWake == never)
+        {
+            timerWake = std::max(pacer.Deadline(), clock.Now()) + wakeLatency();
+        }
+
+        clock.AdvanceTo(std::min(presentWake, timerWake));
+        if (clock.Now() >= timerWake)
+        {
+            timerWake = never;
+        }
+
+        // 取空：唤醒时已经到达的提交全部取出
+        while (next < presentTimes.size() && presentTimes[next] <= clock.Now())
+        {
+            pacer.OnPresent(presentTimes[next]);
+            next++;
+        }
+
+        if (clock.Now() >= presentWake)
+        {
+            presentWake = next < presentTimes.size()
+                ? std::max(presentTimes[next] + wakeLatency(), clock.Now())
+                : never;
+        }
+
+        if (pacer.ShouldEmit(clock.Now()))
+        {
+            emits.push_back({ clock.Now(), pacer.PendingCount() });
+            pacer.OnEmit(clock.Now());
+            timerWake = never;
+        }
+    }
+
+    return emits;
+}
@@ -0,0 +1,186 @@
+/*++
+
+Module Name:
+    StaticRefinementTests.cpp
+
+Abstract:
+    静止画质补偿策略测试（模拟时间轴）：静止判定、补偿帧数与间隔、
+    补偿期间出现变化时重新计时、补偿区域的合并与上限
+
+--*/
+
+#include "TestHarness.h"
+#include "SimulatedClock.h"
+#include "StaticRefinement.h"
+
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t TicksPerSecond = 10000000;
+const int64_t Period = TicksPerSecond / 60;
+const int32_t Width = 1920;
+const int32_t Height = 1080;
+
+struct TimelineEvent
+{
+    int64_t Time;
+    FrameRect Damage;
+};
+
+//
+// 按刷新区间推进模拟时间轴：在各自时间发布有变化的帧，每个区间检查一次补偿，
+// 返回补偿帧的发布时间
+//
+std::vector<int64_t> RunTimeline(
+    StaticRefinementPolicy& policy,
+    const std::vector<TimelineEvent>& events,
+    int64_t duration)
+{
+    SimulatedClock clock(TicksPerSecond);
+    std::vector<int64_t> refinements;
+    size_t next = 0;
+
+    while (clock.Now() <= duration)
+    {
+        while (next < events.size() && events[next].Time <= clock.Now())
+        {
+            policy.OnDamage(&events[next].Damage, 1, Width, Height, clock.Now());
+            next++;
+        }
+
+        if (policy.ShouldRefine(clock.Now()))
+        {
+            refinements.push_back(clock.Now());
+            policy.OnRefined(clock.Now());
+        }
+
+        clock.Advance(Period);
+    }
+
+    return refinements;
+}
+
+bool Covers(const std::vector<FrameRect>& region, const FrameRect& rect)
+{
+    int64_t covered = 0;
+    for (const FrameRect& r : region)
+    {
+        covered += IntersectRect(r, rect).Area();
+    }
+    return covered >= rect.Area();
+}
+
+} // namespace
+
+TEST_CASE(StaticRefinement_RefinesAfterIdleThenGoesQuiet)
+{
+    StaticRefinementConfig config;
+    config.IdleIntervals = 30;
+    config.RefineFrames = 3;
+    config.SpacingIntervals = 2;
+
+    StaticRefinementPolicy policy;
+    policy.Configure(config, Period);
+
+    // 打字：10个区间内连续变化，之后静止
+    std::vector<TimelineEvent> events;
+    for (int64_t i = 0; i < 10; i++)
+    {
+        events.push_back({ i * Period, { 100 + (int32_t)i * 16, 200, 116 + (int32_t)i * 16, 232 } });
+    }
+
+    std::vector<int64_t> refinements = RunTimeline(policy, events, Period * 600);
+
+    // 最后一次变化之后30个区间开始，每2个区间一帧，共3帧，此后不再发布
+    ASSERT_TRUE(refinements.size() == 3);
+    EXPECT_EQ(9 * Period + 30 * Period, refinements[0]);
+    EXPECT_EQ(refinements[0] + 2 * Period, refinements[1]);
+    EXPECT_EQ(refinements[1] + 2 * Period, refinements[2]);
+    EXPECT_FALSE(policy.HasPending());
+    EXPECT_TRUE(policy.Region().empty());
+
+    const StaticRefinementStats& stats = policy.Stats();
+    EXPECT_EQ(1u, stats.Activations);
+    EXPECT_EQ(3u, stats.RefinementFrames);
+    EXPECT_EQ(0u, stats.Interrupted);
+    EXPECT_EQ(3 * 10 * 16 * 32, stats.RefinedArea);
+}
+
+TEST_CASE(StaticRefinement_DamageDuringRefinementRestartsTheIdleTimer)
+{
+    StaticRefinementConfig config;
+    config.IdleIntervals = 10;
+    config.RefineFrames = 4;
+    config.SpacingIntervals = 1;
+
+    StaticRefinementPolicy policy;
+    policy.Configure(config, Period);
+
+    const FrameRect first = { 0, 0, 64, 64 };
+    const FrameRect second = { 512, 512, 576, 576 };
+
+    // 第10个区间发布第一帧补偿，下一个区间再次变化
+    std::vector<TimelineEvent> events = { { 0, first }, { 11 * Period, second } };
+    std::vector<int64_t> refinements = RunTimeline(policy, events, Period * 200);
+
+    // 第11个区间的变化打断补偿，重新静止10个区间后补偿4帧，区域包含两次变化
+    ASSERT_TRUE(refinements.size() == 5);
+    EXPECT_EQ(10 * Period, refinements[0]);
+    EXPECT_EQ(21 * Period, refinements[1]);
+    EXPECT_EQ(24 * Period, refinements[4]);
+    EXPECT_EQ(1u, policy.Stats().Interrupted);
+    EXPECT_EQ(2u, policy.Stats().Activations);
+    EXPECT_EQ(first.Area() + 4 * (first.Area() + second.Area()), policy.Stats().RefinedArea);
+}
+
+TEST_CASE(StaticRefinement_RegionIsBoundedAndCoversAllDamage)
+{
+    StaticRefinementConfig config;
+    config.MaxRects = 8;
+
+    StaticRefinementPolicy policy;
+    policy.Configure(config, Period);
+
+    std::vector<FrameRect> damage;
+    for (int32_t i = 0; i < 40; i++)
+    {
+        FrameRect rect = { (i * 97) % 1800, (i * 53) % 1000, (i * 97) % 1800 + 48, (i * 53) % 1000 + 40 };
+        damage.push_back(rect);
+        policy.OnDamage(&rect, 1, Width, Height, i);
+    }
+
+    EXPECT_TRUE(policy.Region().size() <= 8);
+    for (const FrameRect& rect : damage)
+    {
+        EXPECT_TRUE(Covers(policy.Region(), rect));
+    }
+}
+
+TEST_CASE(StaticRefinement_DisabledOrResizedPolicyDropsRegion)
+{
+    StaticRefinementConfig config;
+    config.RefineFrames = 0;
+
+    StaticRefinementPolicy policy;
+    policy.Configure(config, Period);
+
+    const FrameRect rect = { 0, 0, 32, 32 };
+    policy.OnDamage(&rect, 1, Width, Height, 0);
+    EXPECT_FALSE(policy.HasPending());
+    EXPECT_TRUE(RunTimeline(policy, {}, Period * 100).empty());
+
+    // 尺寸变化后旧区域坐标无意义
+    policy.Configure(StaticRefinementConfig(), Period);
+    policy.OnDamage(&rect, 1, Width, Height, 0);
+    const FrameRect small = { 0, 0, 16, 16 };
+    policy.OnDamage(&small, 1, 1280, 720, 1);
+    ASSERT_TRUE(policy.Region().size() == 1);
+    EXPECT_TRUE(policy.Region()[0] == small);
+
+    policy.Reset();
+    EXPECT_FALSE(policy.HasPending());
+    EXPECT_FALSE(policy.ShouldRefine(Period * 1000));
+}
@@ -0,0 +1,414 @@
+/*++
+
+Module Name:
+    SwapChainRecoveryTests.cpp
+
+Abstract:
+    交换链失效恢复测试：状态机的转换与统计、帧环重发最新帧（Republish），
+    以及对模拟交换链注入失效（任意一帧之后、恢复中第一帧之前）的端到端测试：
+    帧环与帧号在多次重新分配之间延续，每次中断只重发一次最后一帧，
+    恢复时间按模拟时钟精确计入
+
+--*/
+
+#include "TestHarness.h"
+#include "FakeSwapChain.h"
+#include "FrameRingFixture.h"
+#include "SharedMemory.h"
+#include "SimulatedClock.h"
+#include "FrameRing.h"
+#include "SwapChainRecovery.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using namespace FrameRingFixture;
+
+namespace {
+
+const int64_t Period = 10000000 / 60;
+
+// 整帧填同一个内容值，读到的像素据此与最后发布的内容比较
+void PublishContent(FrameRingProducer& producer, uint32_t content, int64_t presentTime)
+{
+    FrameWriteSlot slot = producer.BeginWrite();
+    FillSlot(slot, content);
+    const FrameRect dirty = { 0, 0, 8, 8 };
+    producer.EndWrite(slot, MakeDescriptor(presentTime), &dirty, 1);
+}
+
+//
+// 模拟监视器：帧环与恢复状态机随监视器存在，每次分配一个新的模拟交换链。
+// 帧处理回调与驱动一致：取得帧时通知状态机并发布到帧环，第FailAfter帧之后注入失效
+//
+struct RecoveringMonitor
+{
+    SharedMemoryRegion Region{ (size_t)FrameRingLayout::RequiredSize(3, TestPixelBytes) };
+    FrameRingProducer Producer;
+    FrameRingConsumer Consumer;
+    SwapChainRecovery Recovery;
+    SimulatedClock Clock;
+    uint32_t Content = 0;           // 最后发布的内容值
+    FakeSwapChain* SwapChain = nullptr;
+    uint32_t FailAfter = 0;         // 本交换链取得这么多帧后失效，0表示不注入
+    uint32_t Frames = 0;
+
+    bool Initialize()
+    {
+        return Region.IsValid() &&
+            FrameRingProducer::Format(Region.Writable(), Region.Size(), 3, TestPixelBytes) &&
+            Producer.Attach(Region.Writable(), Region.Size()) &&
+            Consumer.Attach(Region.ReadOnly(), Region.Size());
+    }
+
+    void OnFrame(const FakeSwapChain::Frame&)
+    {
+        Clock.Advance(Period);
+        Recovery.OnFrame(Clock.Now());
+        PublishContent(Producer, ++Content, Clock.Now());
+
+        if (++Frames == FailAfter)
+        {
+            SwapChain->Invalidate();
+        }
+    }
+
+    void OnDrained()
+    {
+    }
+
+    //
+    // 分配一个交换链，提交presents帧后运行帧处理循环直到退出。
+    // 失效后重新分配时先重发最后一帧；返回循环的退出原因
+    //
+    WorkerExitReason RunSwapChain(uint32_t presents, uint32_t failAfter, bool failBeforeFirstFrame = false)
+    {
+        FakeSwapChain swapChain;
+        SwapChain = &swapChain;
+        FailAfter = failAfter;
+        Frames = 0;
+
+        Clock.Advance(Period);
+        if (Recovery.OnAssign(Clock.Now()) && Producer.Republish(FrameFlagRecovery, Clock.Now()))
+        {
+            Recovery.OnRetransmit(Clock.Now());
+        }
+
+        for (uint32_t i = 0; i < presents; i++)
+        {
+            swapChain.Present();
+        }
+        if (failBeforeFirstFrame)
+        {
+            swapChain.Invalidate();
+        }
+        else if (failAfter == 0)
+        {
+            swapChain.RequestTerminate();
+        }
+
+        FrameWorkerLoop<FakeSwapChain, RecoveringMonitor> loop(swapChain, *this);
+        const WorkerExitReason reason = loop.Run();
+
+        Clock.Advance(Period);
+        if (reason == WorkerExitReason::AcquireFailed)
+        {
+            Recovery.OnLost(Clock.Now());
+        }
+        Recovery.OnUnassign(Clock.Now());
+        SwapChain = nullptr;
+        return reason;
+    }
+};
+
+} // namespace
+
+TEST_CASE(SwapChainRecovery_NormalUnassignIsNotAnOutage)
+{
+    SwapChainRecovery recovery;
+    EXPECT_TRUE(recovery.State() == SwapChainState::Unassigned);
+
+    // 未分配时的取帧失败（已在取消分配）不请求新的交换链
+    EXPECT_FALSE(recovery.OnLost(10));
+
+    EXPECT_FALSE(recovery.OnAssign(20));
+    EXPECT_TRUE(recovery.State() == SwapChainState::Running);
+    recovery.OnFrame(30);
+    recovery.OnUnassign(40);
+    EXPECT_TRUE(recovery.State() == SwapChainState::Unassigned);
+
+    EXPECT_FALSE(recovery.OnAssign(50));
+    EXPECT_EQ(2u, recovery.Stats().Assigns);
+    EXPECT_EQ(0u, recovery.Stats().Losses);
+    EXPECT_EQ(0u, recovery.Stats().Recoveries);
+}
+
+TEST_CASE(SwapChainRecovery_RetransmitsOncePerOutage)
+{
+    SwapChainRecovery recovery;
+    recovery.OnAssign(0);
+
+    EXPECT_TRUE(recovery.OnLost(100));
+    EXPECT_TRUE(recovery.State() == SwapChainState::Lost);
+    EXPECT_EQ(100, recovery.LossTime());
+
+    // 恢复过程中的取消分配不结束中断
+    recovery.OnUnassign(110);
+    EXPECT_TRUE(recovery.State() == SwapChainState::Lost);
+
+    EXPECT_TRUE(recovery.OnAssign(200));
+    EXPECT_TRUE(recovery.Recovering());
+    recovery.OnRetransmit(210);
+
+    // 第一帧之前再次失效：同一次中断，从最初失效时计时，不再重发
+    EXPECT_TRUE(recovery.OnLost(300));
+    recovery.OnUnassign(310);
+    EXPECT_FALSE(recovery.OnAssign(400));
+    EXPECT_TRUE(recovery.Recovering());
+
+    recovery.OnFrame(450);
+    EXPECT_TRUE(recovery.State() == SwapChainState::Running);
+    recovery.OnFrame(500);
+
+    const SwapChainRecoveryStats& stats = recovery.Stats();
+    EXPECT_EQ(1u, stats.Losses);
+    EXPECT_EQ(1u, stats.Relosses);
+    EXPECT_EQ(1u, stats.Recoveries);
+    EXPECT_EQ(1u, stats.Retransmits);
+    EXPECT_EQ(110, stats.RetransmitTimeMax);
+    EXPECT_EQ(350, stats.RecoveryTimeLast);
+    EXPECT_EQ(350, stats.RecoveryTimeTotal);
+
+    // 下一次中断重新计时，并再次重发
+    EXPECT_TRUE(recovery.OnLost(1000));
+    EXPECT_TRUE(recovery.OnAssign(1100));
+    recovery.OnFrame(1150);
+    EXPECT_EQ(2u, recovery.Stats().Losses);
+    EXPECT_EQ(150, recovery.Stats().RecoveryTimeLast);
+    EXPECT_EQ(350, recovery.Stats().RecoveryTimeMax);
+    EXPECT_EQ(500, recovery.Stats().RecoveryTimeTotal);
+}
+
+TEST_CASE(SwapChainRecovery_AssignFailureKeepsOutageOpen)
+{
+    SwapChainRecovery recovery;
+    recovery.OnAssign(0);
+    EXPECT_TRUE(recovery.OnLost(100));
+
+    // 新适配器上创建设备失败，驱动删除交换链，IddCx再次分配
+    recovery.OnAssignFailed(150);
+    EXPECT_TRUE(recovery.State() == SwapChainState::Lost);
+
+    // 分配成功但启动帧处理线程失败
+    EXPECT_TRUE(recovery.OnAssign(200));
+    recovery.OnAssignFailed(210);
+    EXPECT_TRUE(recovery.State() == SwapChainState::Lost);
+
+    // 还没有重发过，下一次分配仍要求重发
+    EXPECT_TRUE(recovery.OnAssign(300));
+    recovery.OnRetransmit(305);
+    recovery.OnFrame(320);
+    EXPECT_EQ(2u, recovery.Stats().AssignFailures);
+    EXPECT_EQ(1u, recovery.Stats().Recoveries);
+    EXPECT_EQ(220, recovery.Stats().RecoveryTimeLast);
+
+    // 首次分配就失败时回到未分配
+    SwapChainRecovery fresh;
+    fresh.OnAssign(0);
+    fresh.OnAssignFailed(10);
+    EXPECT_TRUE(fresh.State() == SwapChainState::Unassigned);
+    EXPECT_FALSE(fresh.OnLost(20));
+}
+
+TEST_CASE(SwapChainRecovery_RepublishRetransmitsLatestFrame)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+
+    // 尚无已发布帧时没有可重发的内容
+    EXPECT_FALSE(producer.Republish(FrameFlagRecovery, 50));
+
+    const FrameRect dirty = { 0, 0, 8, 8 };
+    const uint8_t classes[] = { (uint8_t)TileContent::Text, (uint8_t)TileContent::Video };
+    const VideoRegionHint hint = { { 16, 0, 48, 32 }, 30, 12, 0 };
+    FrameWriteSlot slot = producer.BeginWrite();
+    std::memset(slot.Pixels, 0x5A, (size_t)TestPixelBytes);
+    producer.SetContentClasses(slot, 2, 1, classes);
+    producer.SetVideoRegions(slot, &hint, 1);
+    FrameDescriptor descriptor = MakeDescriptor(100);
+    descriptor.Flags = FrameFlagRefinement;
+    descriptor.PresentFrameNumber = 7;
+    producer.EndWrite(slot, descriptor, &dirty, 1);
+
+    FrameReadView view;
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 新帧号、新槽位：像素、类别图、视频区域与时间戳照搬，整帧脏矩形，只带恢复标志
+    ASSERT_TRUE(producer.Republish(FrameFlagRecovery, 900));
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(2u, view.FrameNumber);
+    EXPECT_TRUE(view.Contiguous);
+    EXPECT_EQ(FrameFlagRecovery, view.Descriptor.Flags);
+    EXPECT_EQ(100, view.Descriptor.PresentTime);
+    EXPECT_EQ(900, view.Descriptor.PublishTime);
+    EXPECT_EQ(7u, view.Descriptor.PresentFrameNumber);
+    ASSERT_TRUE(view.DirtyRectCount == 1);
+    EXPECT_TRUE(view.DirtyRects[0] == (FrameRect{ 0, 0, (int32_t)TestWidth, (int32_t)TestHeight }));
+    EXPECT_EQ(0u, view.MoveRegionCount);
+    EXPECT_EQ(2u, view.ContentColumns);
+    EXPECT_TRUE(std::memcmp(view.ContentClasses, classes, sizeof(classes)) == 0);
+    ASSERT_TRUE(view.VideoRegionCount == 1);
+    EXPECT_TRUE(view.VideoRegions[0].Rect == hint.Rect);
+    const uint8_t* pixels = view.Pixels;
+    bool same = true;
+    for (uint64_t i = 0; i < TestPixelBytes; i++)
+    {
+        same = same && pixels[i] == 0x5A;
+    }
+    EXPECT_TRUE(same);
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(SwapChainRecovery_SupersedingKeepsRecoveryFlag)
+{
+    SharedMemoryRegion region(FrameRingLayout::RequiredSize(3, TestPixelBytes));
+    SharedMemoryRegion ackRegion(FrameAckBlockSize);
+    ASSERT_TRUE(FrameRingProducer::Format(region.Writable(), region.Size(), 3, TestPixelBytes));
+    ASSERT_TRUE(FrameRingProducer::FormatAck(ackRegion.Writable(), ackRegion.Size()));
+
+    FrameRingProducer producer;
+    FrameRingConsumer consumer;
+    producer.Attach(region.Writable(), region.Size());
+    producer.AttachAck(ackRegion.ReadOnly(), ackRegion.Size());
+    consumer.Attach(region.ReadOnly(), region.Size());
+    consumer.AttachAck(ackRegion.Writable(), ackRegion.Size());
+
+    FrameReadView view;
+    PublishContent(producer, 1, 100);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_TRUE(consumer.EndRead(view));
+    PublishContent(producer, 2, 200);
+
+    // 消费者还没取走帧2：重发覆盖帧2，随后的新内容再覆盖一次，整帧重新编码的要求不丢
+    ASSERT_TRUE(producer.Republish(FrameFlagRecovery, 300));
+    PublishContent(producer, 3, 400);
+    EXPECT_EQ(2u, producer.Drops(FrameDropReason::Superseded));
+
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(2u, view.FrameNumber);
+    EXPECT_EQ(FrameFlagRecovery, view.Descriptor.Flags);
+    EXPECT_TRUE(FrameHasContent(view, 3));
+    FrameRect bounds = {};
+    for (uint32_t i = 0; i < view.DirtyRectCount; i++)
+    {
+        bounds = UnionRect(bounds, view.DirtyRects[i]);
+    }
+    EXPECT_TRUE(bounds == (FrameRect{ 0, 0, (int32_t)TestWidth, (int32_t)TestHeight }));
+    EXPECT_TRUE(consumer.EndRead(view));
+
+    // 之后的普通帧不带恢复标志
+    PublishContent(producer, 4, 500);
+    ASSERT_TRUE(consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(0u, view.Descriptor.Flags);
+    EXPECT_TRUE(consumer.EndRead(view));
+}
+
+TEST_CASE(SwapChainRecovery_FaultInjectionAcrossReassigns)
+{
+    RecoveringMonitor monitor;
+    ASSERT_TRUE(monitor.Initialize());
+    FrameReadView view;
+
+    // 第一个交换链出5帧后失效，帧处理线程以取帧失败退出
+    EXPECT_TRUE(monitor.RunSwapChain(8, 5) == WorkerExitReason::AcquireFailed);
+    EXPECT_TRUE(monitor.Recovery.State() == SwapChainState::Lost);
+    ASSERT_TRUE(monitor.Consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(5u, view.FrameNumber);
+    EXPECT_TRUE(monitor.Consumer.EndRead(view));
+
+    // 新交换链在第一帧之前又失效（适配器仍在重置）：已重发的最后一帧可读，
+    // 内容与失效前最后一帧相同，帧号延续
+    EXPECT_TRUE(monitor.RunSwapChain(0, 0, true) == WorkerExitReason::AcquireFailed);
+    ASSERT_TRUE(monitor.Consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(6u, view.FrameNumber);
+    EXPECT_TRUE(view.Contiguous);
+    EXPECT_EQ(FrameFlagRecovery, view.Descriptor.Flags);
+    EXPECT_TRUE(FrameHasContent(view, 5));
+    EXPECT_TRUE(monitor.Consumer.EndRead(view));
+
+    // 第三个交换链正常出图：不再重发，第一帧结束中断
+    EXPECT_TRUE(monitor.RunSwapChain(3, 0) == WorkerExitReason::Terminated);
+    ASSERT_TRUE(monitor.Consumer.BeginRead(view) == FrameReadResult::Ok);
+    EXPECT_EQ(9u, view.FrameNumber);
+    EXPECT_TRUE(FrameHasContent(view, 8));
+    EXPECT_TRUE(monitor.Consumer.EndRead(view));
+
+    const SwapChainRecoveryStats& stats = monitor.Recovery.Stats();
+    EXPECT_EQ(3u, stats.Assigns);
+    EXPECT_EQ(1u, stats.Losses);
+    EXPECT_EQ(1u, stats.Relosses);
+    EXPECT_EQ(1u, stats.Retransmits);
+    EXPECT_EQ(1u, stats.Recoveries);
+
+    // 失效后：分配并重发、再次失效、再次分配、第一帧各一个区间
+    EXPECT_EQ(4 * Period, stats.RecoveryTimeLast);
+    EXPECT_EQ(Period, stats.RetransmitTimeMax);
+    EXPECT_TRUE(monitor.Recovery.State() == SwapChainState::Unassigned);
+}
+
+TEST_CASE(SwapChainRecovery_RandomFaultsNeverLoseContent)
+{
+    RecoveringMonitor monitor;
+    ASSERT_TRUE(monitor.Initialize());
+    std::mt19937 rng(7);
+    FrameReadView view;
+    uint64_t lastFrame = 0;
+    uint32_t outages = 0;
+
+    for (int cycle = 0; cycle < 40; cycle++)
+    {
+        const bool recovering = monitor.Recovery.State() == SwapChainState::Lost;
+        const uint32_t presents = 1 + rng() % 6;
+        const bool failEarly = recovering && rng() % 4 == 0;
+        const uint32_t failAfter = failEarly ? 0 : 1 + rng() % presents;
+        const uint32_t contentBefore = monitor.Content;
+        const uint64_t retransmitsBefore = monitor.Recovery.Stats().Retransmits;
+
+        const WorkerExitReason reason = monitor.RunSwapChain(presents, failAfter, failEarly);
+        EXPECT_TRUE(reason == WorkerExitReason::AcquireFailed);
+        outages += failEarly ? 0 : 1;
+
+        // 同一次中断里连续在第一帧前失效时既没有新帧也不再重发
+        const bool published = monitor.Content != contentBefore ||
+            monitor.Recovery.Stats().Retransmits != retransmitsBefore;
+        if (!published)
+        {
+            EXPECT_TRUE(monitor.Consumer.BeginRead(view) == FrameReadResult::NoNewFrame);
+            continue;
+        }
+
+        // 消费者每个周期读一次最新帧：帧号只增不减，内容总是最后发布的内容
+        ASSERT_TRUE(monitor.Consumer.BeginRead(view) == FrameReadResult::Ok);
+        EXPECT_TRUE(view.FrameNumber > lastFrame);
+        EXPECT_TRUE(FrameHasContent(view, monitor.Content));
+        lastFrame = view.FrameNumber;
+        EXPECT_TRUE(monitor.Consumer.EndRead(view));
+    }
+
+    const SwapChainRecoveryStats& stats = monitor.Recovery.Stats();
+    EXPECT_EQ(40u, stats.Assigns);
+    EXPECT_EQ((uint64_t)outages, stats.Losses);
+
+    // 除第一个交换链外每次中断都重发恰好一次，且全部恢复（最后一次中断尚未重新分配）
+    EXPECT_EQ(stats.Losses - 1, stats.Retransmits);
+    EXPECT_EQ(stats.Losses - 1, stats.Recoveries);
+    EXPECT_TRUE(stats.RecoveryTimeMax >= 2 * Period);
+}
@@ -0,0 +1,197 @@
+/*++
+
+Module Name:
+    TaskExecutorTests.cpp
+
+Abstract:
+    工作窃取执行器测试：每个任务恰好执行一次（含队列溢出时在提交线程执行），
+    没有工作线程时由Wait执行全部任务，多个提交线程并发的任务组互不干扰且
+    各自的帧顺序不变；按行带并行的增量NV12转换与串行转换逐位一致
+
+--*/
+
+#include "TestHarness.h"
+#include "TaskExecutor.h"
+#include "IncrementalConvert.h"
+
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+struct CountingJob
+{
+    std::vector<std::atomic<uint32_t>> Runs;
+
+    explicit CountingJob(uint32_t count)
+        : Runs(count)
+    {
+    }
+
+    static void Run(void* context, uint32_t index)
+    {
+        static_cast<CountingJob*>(context)->Runs[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool EachRanOnce() const
+    {
+        for (const std::atomic<uint32_t>& runs : Runs)
+        {
+            if (runs.load() != 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+TEST_CASE(TaskExecutor_EveryTaskRunsExactlyOnce)
+{
+    for (uint32_t workers : { 0u, 1u, 3u })
+    {
+        WorkStealingExecutor executor(workers);
+        EXPECT_EQ(workers, executor.WorkerCount());
+
+        for (uint32_t count : { 1u, 7u, 64u, 5000u })
+        {
+            CountingJob job(count);
+            TaskGroup group;
+            executor.ParallelFor(group, count, &CountingJob::Run, &job);
+            executor.Wait(group);
+            EXPECT_EQ(0u, group.Pending.load());
+            EXPECT_TRUE(job.EachRanOnce());
+        }
+
+        // 5000个任务超过队列总容量，多出的在提交线程上执行
+        const TaskExecutorStats stats = executor.Stats();
+        EXPECT_EQ(1u + 7u + 64u + 5000u, (uint32_t)stats.Submitted);
+        EXPECT_TRUE(stats.Inline > 0);
+        if (workers == 0)
+        {
+            EXPECT_EQ(stats.Submitted, stats.Helped + stats.Inline);
+        }
+    }
+
+    // 空任务组立即返回
+    WorkStealingExecutor executor(2);
+    TaskGroup group;
+    executor.ParallelFor(group, 0, &CountingJob::Run, nullptr);
+    executor.Wait(group);
+    EXPECT_EQ(0u, (uint32_t)executor.Stats().Submitted);
+}
+
+TEST_CASE(TaskExecutor_ConcurrentSubmittersKeepFrameOrder)
+{
+    // 模拟多个监视器的交换链线程：每帧把若干行带交给执行器并等待，
+    // 每个任务检查本监视器上一帧已全部完成
+    struct Monitor
+    {
+        uint32_t Frame = 0;
+        std::vector<uint32_t> BandFrame = std::vector<uint32_t>(24, 0);
+        std::atomic<uint32_t> OrderErrors{ 0 };
+
+        static void Band(void* context, uint32_t index)
+        {
+            Monitor& monitor = *static_cast<Monitor*>(context);
+            if (monitor.BandFrame[index] + 1 != monitor.Frame)
+            {
+                monitor.OrderErrors.fetch_add(1);
+            }
+            monitor.BandFrame[index] = monitor.Frame;
+        }
+    };
+
+    for (uint32_t workers : { 0u, 2u })
+    {
+        WorkStealingExecutor executor(workers);
+        std::vector<Monitor> monitors(6);
+        std::vector<std::thread> threads;
+
+        for (Monitor& monitor : monitors)
+        {
+            threads.emplace_back([&executor, &monitor]
+            {
+                for (uint32_t frame = 1; frame <= 300; frame++)
+                {
+                    monitor.Frame = frame;
+                    TaskGroup group;
+                    executor.ParallelFor(group, (uint32_t)monitor.BandFrame.size(), &Monitor::Band, &monitor);
+                    executor.Wait(group);
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const Monitor& monitor : monitors)
+        {
+            EXPECT_EQ(0u, monitor.OrderErrors.load());
+            for (uint32_t bandFrame : monitor.BandFrame)
+            {
+                EXPECT_EQ(300u, bandFrame);
+            }
+        }
+        EXPECT_EQ(6u * 300u * 24u, (uint32_t)executor.Stats().Submitted);
+    }
+}
+
+TEST_CASE(TaskExecutor_BandedConversionMatchesSerial)
+{
+    const int32_t width = 640;
+    const int32_t height = 480;
+    const size_t pitch = (size_t)width * 4 + 32;
+    std::mt19937 rng(17);
+
+    std::vector<uint8_t> bgra(pitch * height);
+    for (uint8_t& b : bgra)
+    {
+        b = (uint8_t)rng();
+    }
+
+    WorkStealingExecutor executor(3);
+    IncrementalNv12Converter serial;
+    IncrementalNv12Converter banded;
+    banded.SetExecutor(&executor);
+
+    const size_t nv12Bytes = (size_t)width * height * 3 / 2;
+    for (uint64_t frame = 1; frame <= 40; frame++)
+    {
+        // 大面积且互相重叠的脏矩形（跨越多个行带），偶尔夹一个小矩形走串行路径
+        std::vector<FrameRect> dirty;
+        const int count = frame % 5 == 0 ? 1 : 2 + (int)(rng() % 4);
+        for (int i = 0; i < count; i++)
+        {
+            const int32_t l = (int32_t)(rng() % 400), t = (int32_t)(rng() % 300);
+            const int32_t size = frame % 5 == 0 ? 9 : 150 + (int32_t)(rng() % 200);
+            FrameRect rect = IntersectRect({ l, t, l + size, t + size + 31 }, { 0, 0, width, height });
+            dirty.push_back(rect);
+            for (int32_t y = rect.Top; y < rect.Bottom; y++)
+            {
+                for (int32_t x = rect.Left * 4; x < rect.Right * 4; x++)
+                {
+                    bgra[(size_t)y * pitch + (size_t)x] = (uint8_t)rng();
+                }
+            }
+        }
+
+        EXPECT_TRUE(serial.Update(bgra.data(), pitch, width, height, dirty.data(), (uint32_t)dirty.size(),
+            nullptr, 0, frame));
+        EXPECT_TRUE(banded.Update(bgra.data(), pitch, width, height, dirty.data(), (uint32_t)dirty.size(),
+            nullptr, 0, frame));
+        EXPECT_EQ(serial.LastStats().ConvertedArea, banded.LastStats().ConvertedArea);
+        ASSERT_TRUE(std::memcmp(serial.Surface().Y, banded.Surface().Y, nv12Bytes) == 0);
+    }
+
+    EXPECT_TRUE(executor.Stats().Submitted > 0);
+}
@@ -0,0 +1,77 @@
+/*++
+
+Module Name:
+    TestHarness.h
+
+Abstract:
+    驱动可移植核心的极简测试框架（不依赖第三方库）
+
+--*/
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace TestHarness {
+
+struct TestCase
+{
+    const char* Name;
+    std::function<void()> Body;
+};
+
+inline std::vector<TestCase>& Registry()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline int& FailureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+
+struct Registrar
+{
+    Registrar(const char* name, std::function<void()> body)
+    {
+        Registry().push_back({ name, std::move(body) });
+    }
+};
+
+inline void ReportFailure(const char* file, int line, const std::string& message)
+{
+    std::printf("  FAILED %s:%d: %s\n", file, line, message.c_str());
+    FailureCount()++;
+}
+
+} // namespace TestHarness
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestHarness::Registrar name##_registrar(#name, name); \
+    static void name()
+
+#define EXPECT_TRUE(expr) \
+    do { if (!(expr)) TestHarness::ReportFailure(__FILE__, __LINE__, #expr); } while (0)
+
+#define EXPECT_FALSE(expr) EXPECT_TRUE(!(expr))
+
+#define EXPECT_EQ(expected, actual) \
+    do { \
+        auto&& expectedValue_ = (expected); \
+        auto&& actualValue_ = (actual); \
+        if (!(expectedValue_ == actualValue_)) \
+        { \
+            TestHarness::ReportFailure(__FILE__, __LINE__, \
+                std::string(#expected " == " #actual " (expected ") + \
+                std::to_string(expectedValue_) + ", actual " + std::to_string(actualValue_) + ")"); \
+        } \
+    } while (0)
+
+#define ASSERT_TRUE(expr) \
+    do { if (!(expr)) { TestHarness::ReportFailure(__FILE__, __LINE__, #expr); return; } } while (0)
@@ -0,0 +1,36 @@
+/*++
+
+Module Name:
+    TestMain.cpp
+
+Abstract:
+    测试入口，可传入测试名子串进行过滤
+
+--*/
+
+#include "TestHarness.h"
+
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    int run = 0;
+
+    for (const TestHarness::TestCase& test : TestHarness::Registry())
+    {
+        if (argc > 1 && std::strstr(test.Name, argv[1]) == nullptr)
+        {
+            continue;
+        }
+
+        int failuresBefore = TestHarness::FailureCount();
+        std::printf("[ RUN  ] %s\n", test.Name);
+        test.Body();
+        std::printf("[ %s ] %s\n",
+            TestHarness::FailureCount() == failuresBefore ? " OK " : "FAIL", test.Name);
+        run++;
+    }
+
+    std::printf("%d tests, %d failures\n", run, TestHarness::FailureCount());
+    return TestHarness::FailureCount() == 0 ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+/*++
+
+Module Name:
+    TileClassifierTests.cpp
+
+Abstract:
+    块内容分类测试：行特征内核在各SIMD级别与标量逐位一致；带标注的合成语料
+    （界面、各种配色与行距的抗锯齿文字、图标、照片、带噪声的渐变）分类正确率；
+    持续更新的照片块判为视频，持续更新的文字仍为文字，间隔很久的更新不算连续；
+    重叠的脏矩形每块只分类一次，尺寸变化时类别图清空
+
+--*/
+
+#include "TestHarness.h"
+#include "ScreenContent.h"
+#include "TileClassifier.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+using ScreenContent::Canvas;
+
+namespace {
+
+const int64_t Period = 1000;       // 模拟的刷新周期（计数）
+
+struct Sample
+{
+    Canvas Image;
+    TileContent Expected;
+};
+
+//
+// 语料：每个样本是3x3块的画布，被测的是中间一块（左侧有真实的邻居像素）
+//
+std::vector<Sample> MakeCorpus()
+{
+    const int32_t size = ContentTileSize * 3;
+    const uint32_t inks[] = { 0xFF000000u, 0xFF333333u, 0xFF0000FFu, 0xFFA31515u, 0xFF008000u, 0xFF795E26u };
+    const uint32_t backgrounds[] = { 0xFFFFFFFFu, 0xFF1E1E1Eu, 0xFFF3F3F3u, 0xFF252526u };
+    std::vector<Sample> corpus;
+    std::mt19937 rng(23);
+
+    for (uint32_t i = 0; i < 48; i++)
+    {
+        // 抗锯齿文字：配色、行距、起始位置各不相同
+        const uint32_t background = backgrounds[i % 4];
+        const uint32_t ink = (background & 0xFF) < 0x80 ? 0xFFD4D4D4u - (i % 3) * 0x101010u : inks[i % 6];
+        Canvas text(size, size, background);
+        text.Text((int32_t)(rng() % 24), (int32_t)(rng() % 12), size, 16, ink, 100 + i, 13 + (int32_t)(i % 8));
+        corpus.push_back({ text, TileContent::Text });
+    }
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        // 界面：卡片、按钮、分隔线、小图标与标签
+        Canvas ui(size, size, backgrounds[i % 4]);
+        const int32_t top = 40 + (int32_t)(rng() % 40);
+        ui.Fill(20, top, size - 20, top + 48, 0xFFFFFFFFu);
+        ui.Fill(20, top + 47, size - 20, top + 48, 0xFFE0E0E0u);
+        ui.Fill(ContentTileSize + 30, top + 12, ContentTileSize + 62, top + 36, 0xFF0078D7u);
+        ui.Icon(ContentTileSize + 8, top + 24, 8 + (int32_t)(i % 4), 0xFF2B91AFu + i * 0x050301u);
+        ui.Text(ContentTileSize + 20, top + 18, size, 1, 0xFF1F1F1Fu, 200 + i);
+        corpus.push_back({ ui, TileContent::Text });
+    }
+
+    for (uint32_t i = 0; i < 48; i++)
+    {
+        // 照片：不同内容与位置；以及带噪声的渐变（天空）
+        Canvas photo(size, size, 0xFF000000u);
+        if (i % 4 != 3)
+        {
+            photo.Photo(0, 0, size, size, 300 + i, i * 1.7);
+        }
+        else
+        {
+            std::mt19937 noise(400 + i);
+            for (int32_t y = 0; y < size; y++)
+            {
+                for (int32_t x = 0; x < size; x++)
+                {
+                    const uint32_t b = (uint32_t)(160 + y / 3 + (int32_t)(noise() % 7)) & 0xFF;
+                    const uint32_t g = (uint32_t)(110 + y / 4 + x / 9 + (int32_t)(noise() % 7)) & 0xFF;
+                    const uint32_t r = (uint32_t)(60 + x / 5 + (int32_t)(noise() % 7)) & 0xFF;
+                    photo.At(x, y) = 0xFF000000u | (r << 16) | (g << 8) | b;
+                }
+            }
+        }
+        corpus.push_back({ photo, TileContent::Natural });
+    }
+
+    return corpus;
+}
+
+TileContent ClassifyCenter(TileContentClassifier& classifier, const Canvas& image, int64_t now)
+{
+    const FrameRect center = { ContentTileSize, ContentTileSize, ContentTileSize * 2, ContentTileSize * 2 };
+    classifier.Classify(image.Data(), image.Pitch(), image.Width(), image.Height(), &center, 1, now);
+    return classifier.ClassAt(1, 1);
+}
+
+} // namespace
+
+TEST_CASE(TileClassifier_RowKernelsMatchScalar)
+{
+    std::mt19937 rng(5);
+    const CpuLevel best = DetectCpuLevel();
+    std::vector<uint32_t> row(80);
+
+    for (int iteration = 0; iteration < 4000; iteration++)
+    {
+        // 平坦段、小差值与大跳变混合，alpha随机（应被忽略）
+        uint32_t pixel = rng();
+        for (uint32_t& value : row)
+        {
+            switch (rng() % 4)
+            {
+            case 0: break;
+            case 1: pixel = (pixel & 0x00FFFFFFu) | (rng() << 24); break;
+            case 2: pixel ^= rng() & 0x00030303u; break;
+            default: pixel = rng(); break;
+            }
+            value = pixel;
+        }
+
+        const int32_t pixels = (int32_t)(rng() % 65);
+        const uint32_t threshold = 1 + rng() % 255;
+        const uint8_t* a = reinterpret_cast<const uint8_t*>(row.data() + 1 + rng() % 8);
+
+        uint32_t expectedEdges;
+        const uint64_t expected = TileClassifierDetail::RowActivityScalar(a, a - 4, pixels, threshold, expectedEdges);
+        for (int level = 1; level <= (int)best; level++)
+        {
+            uint32_t edges;
+            const uint64_t changed = SelectRowActivity((CpuLevel)level)(a, a - 4, pixels, threshold, edges);
+            ASSERT_TRUE(changed == expected);
+            EXPECT_EQ(expectedEdges, edges);
+        }
+    }
+}
+
+TEST_CASE(TileClassifier_LabeledCorpus)
+{
+    const std::vector<Sample> corpus = MakeCorpus();
+
+    for (int level = 0; level <= (int)DetectCpuLevel(); level++)
+    {
+        uint32_t correct[TileContentCount] = {};
+        uint32_t total[TileContentCount] = {};
+
+        for (const Sample& sample : corpus)
+        {
+            // 每个样本用新的分类器，只更新一次：不受更新频率影响
+            TileContentClassifier classifier((CpuLevel)level);
+            classifier.Configure(ContentClassifierConfig(), Period);
+            const TileContent content = ClassifyCenter(classifier, sample.Image, Period);
+            total[(uint32_t)sample.Expected]++;
+            correct[(uint32_t)sample.Expected] += content == sample.Expected ? 1 : 0;
+        }
+
+        for (uint32_t c = 0; c < TileContentCount; c++)
+        {
+            EXPECT_TRUE(correct[c] * 100 >= total[c] * 95);
+        }
+    }
+}
+
+TEST_CASE(TileClassifier_UpdateFrequencySeparatesVideo)
+{
+    const int32_t size = ContentTileSize * 3;
+    TileContentClassifier classifier;
+    ContentClassifierConfig config;
+    classifier.Configure(config, Period);
+
+    // 每个刷新区间都变化的照片块：达到VideoMinUpdates次后为视频
+    int64_t now = 0;
+    for (uint32_t frame = 1; frame <= config.VideoMinUpdates + 2; frame++)
+    {
+        now += Period;
+        Canvas image(size, size, 0);
+        image.Photo(0, 0, size, size, 7, frame * 0.2);
+        const TileContent content = ClassifyCenter(classifier, image, now);
+        EXPECT_TRUE(content == (frame < config.VideoMinUpdates ? TileContent::Natural : TileContent::Video));
+    }
+
+    // 中断超过VideoMaxGapIntervals后重新计数
+    now += Period * (config.VideoMaxGapIntervals + 1);
+    Canvas still(size, size, 0);
+    still.Photo(0, 0, size, size, 7, 0.0);
+    EXPECT_TRUE(ClassifyCenter(classifier, still, now) == TileContent::Natural);
+
+    // 隔一个区间更新仍算连续（视频帧率低于刷新率）
+    for (uint32_t frame = 1; frame < config.VideoMinUpdates; frame++)
+    {
+        now += Period * 2;
+        ClassifyCenter(classifier, still, now);
+    }
+    EXPECT_TRUE(classifier.ClassAt(1, 1) == TileContent::Video);
+
+    // 每帧都在变化的文字（打字、滚动）仍是文字
+    for (uint32_t frame = 1; frame <= 20; frame++)
+    {
+        now += Period;
+        Canvas text(size, size, 0xFFFFFFFFu);
+        text.Text(0, (int32_t)frame % 18, size, 12, 0xFF000000u, frame);
+        EXPECT_TRUE(ClassifyCenter(classifier, text, now) == TileContent::Text);
+    }
+}
+
+TEST_CASE(TileClassifier_GridAndDirtyCoverage)
+{
+    const int32_t width = 300, height = 130;     // 5x3块，最右列与最下行不满
+    Canvas image(width, height, 0xFFFFFFFFu);
+    image.Photo(192, 64, 300, 130);
+
+    TileContentClassifier classifier;
+    classifier.Configure(ContentClassifierConfig(), Period);
+
+    // 未分类前类别为Unknown；重叠的脏矩形每块只分类一次
+    const FrameRect dirty[] = { { 10, 10, 20, 20 }, { 0, 0, 70, 5 }, { 260, 128, 300, 130 }, { -50, -50, 1, 1 } };
+    EXPECT_EQ(3u, classifier.Classify(image.Data(), image.Pitch(), width, height, dirty, 4, Period));
+    EXPECT_EQ(5u, classifier.Columns());
+    EXPECT_EQ(3u, classifier.Rows());
+    EXPECT_TRUE(classifier.ClassAt(0, 0) == TileContent::Text);
+    EXPECT_TRUE(classifier.ClassAt(1, 0) == TileContent::Text);
+    EXPECT_TRUE(classifier.ClassAt(4, 2) == TileContent::Natural);
+    EXPECT_TRUE(classifier.ClassAt(2, 1) == TileContent::Unknown);
+    EXPECT_TRUE(classifier.ClassAt(5, 0) == TileContent::Unknown);
+    EXPECT_EQ(2u, classifier.LastStats().Classes[(uint32_t)TileContent::Text]);
+    EXPECT_TRUE(classifier.LastStats().SampledPixels > 0);
+
+    // 未脏的块保留类别
+    const FrameRect one = { 64, 64, 65, 65 };
+    EXPECT_EQ(1u, classifier.Classify(image.Data(), image.Pitch(), width, height, &one, 1, Period * 2));
+    EXPECT_TRUE(classifier.ClassAt(4, 2) == TileContent::Natural);
+
+    // 尺寸变化时清空
+    EXPECT_EQ(1u, classifier.Classify(image.Data(), image.Pitch(), 128, 128, &one, 1, Period * 3));
+    EXPECT_EQ(2u, classifier.Columns());
+    EXPECT_TRUE(classifier.ClassAt(0, 0) == TileContent::Unknown);
+    EXPECT_TRUE(classifier.ClassAt(1, 1) == TileContent::Text);
+
+    // 宽1像素的帧：最左列没有左邻，不采样，按平坦处理
+    const FrameRect pixel = { 0, 0, 1, 1 };
+    EXPECT_EQ(1u, classifier.Classify(image.Data(), image.Pitch(), 1, 1, &pixel, 1, Period * 4));
+    EXPECT_TRUE(classifier.ClassAt(0, 0) == TileContent::Text);
+    EXPECT_EQ(0u, (uint32_t)classifier.LastStats().SampledPixels);
+}
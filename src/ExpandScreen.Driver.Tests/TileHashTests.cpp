@@ -0,0 +1,214 @@
+/*++
+
+Module Name:
+    TileHashTests.cpp
+
+Abstract:
+    分块内容哈希测试：各SIMD内核与标量参考逐位一致、对行序/条带位置敏感，
+    以及块过滤的剔除、作废与覆盖性
+
+--*/
+
+#include "TestHarness.h"
+#include "TileHash.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const CpuLevel AllLevels[] = { CpuLevel::Scalar, CpuLevel::Sse41, CpuLevel::Avx2, CpuLevel::Avx512 };
+
+struct Image
+{
+    int32_t Width;
+    int32_t Height;
+    size_t Pitch;
+    std::vector<uint8_t> Bytes;
+
+    Image(int32_t width, int32_t height, uint32_t seed, size_t padding = 0)
+        : Width(width), Height(height), Pitch((size_t)width * 4 + padding),
+          Bytes(Pitch * (size_t)height)
+    {
+        std::mt19937 rng(seed);
+        for (uint8_t& b : Bytes)
+        {
+            b = (uint8_t)rng();
+        }
+    }
+
+    uint32_t* Pixel(int32_t x, int32_t y)
+    {
+        return reinterpret_cast<uint32_t*>(&Bytes[(size_t)y * Pitch + (size_t)x * 4]);
+    }
+
+    void Fill(const FrameRect& rect, std::mt19937& rng)
+    {
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            for (int32_t x = rect.Left; x < rect.Right; x++)
+            {
+                *Pixel(x, y) = rng();
+            }
+        }
+    }
+};
+
+bool Covers(const std::vector<FrameRect>& rects, int32_t x, int32_t y)
+{
+    for (const FrameRect& r : rects)
+    {
+        if (x >= r.Left && x < r.Right && y >= r.Top && y < r.Bottom)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE(TileHash_AllKernelsMatchScalarReference)
+{
+    Image image(200, 70, 5, 36);
+    TileHashFunction scalar = SelectTileHash(CpuLevel::Scalar);
+
+    for (uint32_t rowBytes : { 4u, 60u, 64u, 68u, 252u, 256u, 260u, 800u })
+    {
+        for (uint32_t rows : { 1u, 7u, 64u, 70u })
+        {
+            for (size_t offset : { (size_t)0, (size_t)4, (size_t)36 })
+            {
+                uint64_t expected = scalar(image.Bytes.data() + offset, image.Pitch, rowBytes, rows);
+                for (CpuLevel level : AllLevels)
+                {
+                    EXPECT_EQ(expected, SelectTileHash(level)(image.Bytes.data() + offset, image.Pitch, rowBytes, rows));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(TileHash_SensitiveToRowOrderAndStripePosition)
+{
+    Image image(64, 64, 9);
+    for (CpuLevel level : AllLevels)
+    {
+        TileHashFunction hash = SelectTileHash(level);
+        uint64_t original = hash(image.Bytes.data(), image.Pitch, 256, 64);
+
+        // 交换两行
+        Image rows = image;
+        std::swap_ranges(rows.Pixel(0, 3), rows.Pixel(0, 3) + 64, rows.Pixel(0, 40));
+        EXPECT_TRUE(hash(rows.Bytes.data(), rows.Pitch, 256, 64) != original);
+
+        // 同一行内交换两个64字节条带
+        Image stripes = image;
+        std::swap_ranges(stripes.Pixel(0, 10), stripes.Pixel(16, 10), stripes.Pixel(32, 10));
+        EXPECT_TRUE(hash(stripes.Bytes.data(), stripes.Pitch, 256, 64) != original);
+
+        // 单个比特翻转
+        Image bit = image;
+        *bit.Pixel(63, 63) ^= 0x100;
+        EXPECT_TRUE(hash(bit.Bytes.data(), bit.Pitch, 256, 64) != original);
+    }
+}
+
+TEST_CASE(TileHash_IdenticalRedrawIsSuppressed)
+{
+    Image image(256, 192, 1);
+    TileHasher hasher;
+    std::vector<FrameRect> output;
+
+    // 首帧所有块都未知，原样输出
+    FrameRect window = { 10, 10, 250, 180 };
+    EXPECT_EQ(1u, hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &window, 1, output));
+    EXPECT_TRUE(output[0] == window);
+
+    // 原样重绘：全部剔除
+    EXPECT_EQ(0u, hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &window, 1, output));
+    EXPECT_EQ(12u, hasher.LastStats().DirtyTiles);
+    EXPECT_EQ(0u, hasher.LastStats().ChangedTiles);
+
+    // 只改一个像素：输出该块与脏矩形的交集
+    *image.Pixel(200, 20) ^= 1;
+    EXPECT_EQ(1u, hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &window, 1, output));
+    EXPECT_TRUE(output[0] == (FrameRect{ 192, 10, 250, 64 }));
+    EXPECT_EQ(1u, hasher.LastStats().ChangedTiles);
+}
+
+TEST_CASE(TileHash_InvalidatedTilesAreReportedAgain)
+{
+    Image image(128, 128, 2);
+    TileHasher hasher;
+    std::vector<FrameRect> output;
+    FrameRect full = { 0, 0, 128, 128 };
+
+    hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &full, 1, output);
+
+    // 移动区域目标块被作废：即使内容哈希相同，也必须重新上报
+    FrameRect moved = { 70, 0, 128, 60 };
+    hasher.Invalidate(&moved, 1);
+    EXPECT_EQ(1u, hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &full, 1, output));
+    EXPECT_TRUE(output[0] == (FrameRect{ 64, 0, 128, 64 }));
+
+    hasher.Reset();
+    EXPECT_EQ(1u, hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height, &full, 1, output));
+    EXPECT_TRUE(output[0] == full);
+
+    // 分辨率变化后重新开始
+    Image larger(192, 128, 2);
+    EXPECT_EQ(1u, hasher.Filter(larger.Bytes.data(), larger.Pitch, larger.Width, larger.Height, &full, 1, output));
+    EXPECT_EQ(4u, hasher.LastStats().ChangedTiles);
+}
+
+TEST_CASE(TileHash_EveryChangedPixelStaysCovered)
+{
+    Image image(333, 211, 3, 12);
+    std::mt19937 rng(17);
+
+    for (CpuLevel level : AllLevels)
+    {
+        TileHasher hasher(32, level);
+        std::vector<FrameRect> output;
+
+        for (int frame = 0; frame < 200; frame++)
+        {
+            std::vector<FrameRect> dirty;
+            std::vector<FrameRect> changed;
+            int count = 1 + (int)(rng() % 6);
+            for (int i = 0; i < count; i++)
+            {
+                int32_t l = (int32_t)(rng() % 320), t = (int32_t)(rng() % 200);
+                FrameRect rect = { l, t, l + 1 + (int32_t)(rng() % 80), t + 1 + (int32_t)(rng() % 60) };
+                dirty.push_back(rect);
+
+                // 一半的脏矩形只是原样重绘
+                if (rng() % 2 == 0)
+                {
+                    rect = IntersectRect(rect, { 0, 0, image.Width, image.Height });
+                    image.Fill(rect, rng);
+                    changed.push_back(rect);
+                }
+            }
+
+            hasher.Filter(image.Bytes.data(), image.Pitch, image.Width, image.Height,
+                dirty.data(), (uint32_t)dirty.size(), output);
+
+            for (const FrameRect& rect : changed)
+            {
+                for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                {
+                    for (int32_t x = rect.Left; x < rect.Right; x++)
+                    {
+                        ASSERT_TRUE(Covers(output, x, y));
+                    }
+                }
+            }
+
+            EXPECT_TRUE(hasher.LastStats().OutputArea <= hasher.LastStats().InputArea);
+        }
+    }
+}
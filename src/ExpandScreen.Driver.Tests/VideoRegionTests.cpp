@@ -0,0 +1,203 @@
+/*++
+
+Module Name:
+    VideoRegionTests.cpp
+
+Abstract:
+    视频区域检测测试（合成的损伤轨迹）：30fps与24fps播放在达到MinUpdates次后检测为
+    按块对齐的区域，暂停后冷却；光标闪烁、打字、节奏不稳的更新与单块动画不成为区域；
+    多个区域按大小排列，静止的一行不切开区域，稀疏的热块不成为区域；尺寸变化时清空
+
+--*/
+
+#include "TestHarness.h"
+#include "VideoRegion.h"
+
+#include <random>
+#include <vector>
+
+using namespace ExpandScreen::Pipeline;
+
+namespace {
+
+const int64_t Period = 1000;       // 模拟的刷新周期（计数）
+const int32_t Width = 1920;
+const int32_t Height = 1080;
+
+//
+// 以刷新区间为单位推进的损伤轨迹；每个区间只在有损伤时发布一帧
+//
+class Trace
+{
+public:
+    explicit Trace(const VideoRegionConfig& config = VideoRegionConfig())
+    {
+        m_Detector.Configure(config, Period);
+    }
+
+    VideoRegionDetector& Detector()
+    {
+        return m_Detector;
+    }
+
+    int64_t Now() const
+    {
+        return m_Now;
+    }
+
+    //
+    // 前进intervals个刷新区间并发布rects
+    //
+    uint32_t Step(int64_t intervals, std::vector<FrameRect> rects)
+    {
+        m_Now += Period * intervals;
+        return m_Detector.Update(Width, Height, rects.data(), (uint32_t)rects.size(), m_Now);
+    }
+
+private:
+    VideoRegionDetector m_Detector;
+    int64_t m_Now = 0;
+};
+
+} // namespace
+
+TEST_CASE(VideoRegion_SteadyPlaybackIsDetectedAndCools)
+{
+    VideoRegionConfig config;
+    Trace trace(config);
+    const FrameRect video = { 300, 200, 1100, 650 };
+
+    // 30fps：每两个刷新区间一帧，第MinUpdates帧时出现区域
+    for (uint32_t frame = 1; frame < config.MinUpdates; frame++)
+    {
+        EXPECT_EQ(0u, trace.Step(2, { video }));
+    }
+    ASSERT_TRUE(trace.Step(2, { video }) == 1);
+
+    const VideoRegionHint& region = trace.Detector().Regions()[0];
+    const FrameRect expected = { 256, 192, 1152, 704 };
+    EXPECT_TRUE(region.Rect == expected);
+    EXPECT_EQ(Period * 2, region.Interval);
+    EXPECT_EQ(14u * 8u, region.Tiles);
+    EXPECT_EQ(1u, (uint32_t)trace.Detector().Stats().Detections);
+
+    // 继续播放不重建；其他位置的一次性变化不影响区域
+    const uint64_t rebuilds = trace.Detector().Stats().Rebuilds;
+    for (int frame = 0; frame < 30; frame++)
+    {
+        EXPECT_EQ(1u, trace.Step(2, frame == 10 ? std::vector<FrameRect>{ video, { 1500, 900, 1600, 950 } } :
+            std::vector<FrameRect>{ video }));
+    }
+    EXPECT_EQ(rebuilds, trace.Detector().Stats().Rebuilds);
+
+    // 暂停：超过MaxIntervalPeriods个区间没有更新后冷却（无损伤的帧也会冷却）
+    EXPECT_EQ(1u, trace.Step(config.MaxIntervalPeriods, { { 1800, 20, 1850, 40 } }));
+    EXPECT_EQ(0u, trace.Step(1, {}));
+    EXPECT_EQ(0u, trace.Detector().HotTiles());
+
+    // 恢复播放需要重新积累
+    EXPECT_EQ(0u, trace.Step(2, { video }));
+    for (uint32_t frame = 2; frame <= config.MinUpdates; frame++)
+    {
+        trace.Step(2, { video });
+    }
+    EXPECT_EQ(1u, trace.Detector().RegionCount());
+    EXPECT_EQ(2u, (uint32_t)trace.Detector().Stats().Detections);
+}
+
+TEST_CASE(VideoRegion_CadenceSeparatesVideoFromOtherUpdates)
+{
+    VideoRegionConfig config;
+
+    // 24fps在60Hz上：间隔2、3个区间交替，抖动在允许范围内
+    {
+        Trace trace(config);
+        const FrameRect video = { 640, 360, 1280, 720 };
+        for (uint32_t frame = 0; frame < config.MinUpdates * 2; frame++)
+        {
+            trace.Step(2 + frame % 2, { video });
+        }
+        ASSERT_TRUE(trace.Detector().RegionCount() == 1);
+        const int64_t interval = trace.Detector().Regions()[0].Interval;
+        EXPECT_TRUE(interval >= Period * 2 && interval <= Period * 3);
+    }
+
+    // 光标闪烁（约0.5秒）、打字（间隔不规则且常超过上限）、1与4个区间交替的不稳定节奏
+    {
+        Trace trace(config);
+        std::mt19937 rng(3);
+        const FrameRect caret = { 700, 300, 702, 318 };
+        const FrameRect line = { 100, 500, 900, 520 };
+        const FrameRect irregular = { 1200, 100, 1600, 400 };
+        int64_t nextCaret = 32, nextLine = 3, nextIrregular = 1;
+        bool longGap = false;
+        for (int64_t interval = 1; interval <= 600; interval++)
+        {
+            std::vector<FrameRect> rects;
+            if (interval == nextCaret)
+            {
+                rects.push_back(caret);
+                nextCaret += 32;
+            }
+            if (interval == nextLine)
+            {
+                rects.push_back(line);
+                nextLine += 3 + (int64_t)(rng() % 10);
+            }
+            if (interval == nextIrregular)
+            {
+                rects.push_back(irregular);
+                nextIrregular += longGap ? 4 : 1;
+                longGap = !longGap;
+            }
+            EXPECT_EQ(0u, trace.Step(1, rects));
+        }
+        EXPECT_EQ(0u, trace.Detector().HotTiles());
+    }
+
+    // 单块的加载动画节奏稳定，块变热，但不足MinTiles不成为区域
+    {
+        Trace trace(config);
+        for (uint32_t frame = 0; frame < config.MinUpdates * 2; frame++)
+        {
+            EXPECT_EQ(0u, trace.Step(1, { { 70, 70, 90, 90 } }));
+        }
+        EXPECT_TRUE(trace.Detector().IsHot(1, 1));
+        EXPECT_EQ(1u, trace.Detector().HotTiles());
+    }
+}
+
+TEST_CASE(VideoRegion_RegionShapes)
+{
+    VideoRegionConfig config;
+    Trace trace(config);
+
+    // 大视频中间一行块静止（字幕条之类），小视频在右下角；对角线上的动画热块稀疏
+    const FrameRect top = { 0, 0, 640, 192 };
+    const FrameRect bottom = { 0, 256, 640, 448 };
+    const FrameRect small = { 1536, 768, 1792, 960 };
+    std::vector<FrameRect> rects = { top, bottom, small };
+    for (int32_t i = 0; i < 8; i++)
+    {
+        rects.push_back({ 1024 + i * 64, 64 + i * 64, 1024 + i * 64 + 8, 64 + i * 64 + 8 });
+    }
+    for (uint32_t frame = 0; frame < config.MinUpdates; frame++)
+    {
+        trace.Step(1, rects);
+    }
+
+    ASSERT_TRUE(trace.Detector().RegionCount() == 2);
+    const VideoRegionHint* regions = trace.Detector().Regions();
+    const FrameRect merged = { 0, 0, 640, 448 };
+    EXPECT_TRUE(regions[0].Rect == merged);
+    EXPECT_EQ(10u * 6u, regions[0].Tiles);
+    EXPECT_TRUE(regions[1].Rect == small);
+    EXPECT_EQ(Period, regions[1].Interval);
+    EXPECT_EQ(60u + 12u + 8u, trace.Detector().HotTiles());
+    EXPECT_EQ(2u, trace.Detector().Stats().MaxRegions);
+
+    // 尺寸变化时清空
+    trace.Detector().Update(1280, 720, rects.data(), (uint32_t)rects.size(), trace.Now() + Period);
+    EXPECT_EQ(0u, trace.Detector().RegionCount());
+    EXPECT_EQ(0u, trace.Detector().HotTiles());
+}
@@ -61,6 +61,8 @@ NTSTATUS InitializeIddCxAdapter(
     adapterCaps.EndPointDiagnostics.GammaSupport = IDDCX_FEATURE_IMPLEMENTATION_NONE;
     adapterCaps.EndPointDiagnostics.TransmissionType = IDDCX_TRANSMISSION_TYPE_WIRED_OTHER;
 
+    // 静止桌面的补偿帧由每个监视器的StaticRefinementPolicy在驱动内按配置发布，
+    // 不需要系统重复提交静止帧
     adapterCaps.StaticDesktopReencodeFrameCount = 0;
 
     // 设置适配器对象属性
@@ -181,13 +183,34 @@ NTSTATUS ExpandScreenEvtAdapterCommitModes(
 )
 {
     UNREFERENCED_PARAMETER(AdapterObject);
-    UNREFERENCED_PARAMETER(pInArgs);
 
     PAGED_CODE();
 
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_ADAPTER,
         "%!FUNC! 提交显示模式，路径数=%d", pInArgs->PathCount);
 
-    // 简单实现：接受所有模式
+    // 接受所有模式；记录各活动路径的刷新率，交换链分配时据此定速
+    for (UINT i = 0; i < pInArgs->PathCount; i++)
+    {
+        const IDDCX_PATH* path = &pInArgs->pPaths[i];
+        PMONITOR_CONTEXT monitorContext = GetMonitorContext(path->MonitorObject);
+
+        if ((path->Flags & IDDCX_PATH_FLAGS_ACTIVE) == 0)
+        {
+            monitorContext->RefreshNumerator = 0;
+            monitorContext->RefreshDenominator = 0;
+            continue;
+        }
+
+        monitorContext->RefreshNumerator = path->TargetVideoSignalInfo.VSyncFreq.Numerator;
+        monitorContext->RefreshDenominator = path->TargetVideoSignalInfo.VSyncFreq.Denominator;
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_ADAPTER,
+            "监视器ID=%d刷新率=%d/%d",
+            monitorContext->MonitorId,
+            monitorContext->RefreshNumerator,
+            monitorContext->RefreshDenominator);
+    }
+
     return STATUS_SUCCESS;
 }
@@ -0,0 +1,428 @@
+/*++
+
+Module Name:
+    Cursor.cpp
+
+Abstract:
+    硬件光标：向IddCx注册硬件光标，光标位置与形状经独立的共享内存通道发布
+    通道协议见Pipeline/CursorChannel.h，用户态只读映射后在本地叠加光标
+
+    注册硬件光标后DWM不再把光标合成进桌面图像，只移动指针不会产生新帧
+
+Environment:
+    Kernel-mode Driver Framework
+
+--*/
+
+#include "Driver.h"
+#include <avrt.h>
+#include <sddl.h>
+#include "Cursor.tmh"
+
+#ifdef ALLOC_PRAGMA
+#pragma alloc_text(PAGE, CreateCursorChannel)
+#pragma alloc_text(PAGE, DestroyCursorChannel)
+#pragma alloc_text(PAGE, StartCursorProcessing)
+#pragma alloc_text(PAGE, StopCursorProcessing)
+#endif
+
+using namespace ExpandScreen::Pipeline;
+
+namespace
+{
+
+//
+// 查询一次光标数据并发布：形状经内容缓存换成缓存ID，缓存未命中时位图先于
+// 引用它的事件写入槽位，命中时只发布缓存ID与热点
+//
+VOID QueryAndPublishCursor(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _In_ CursorChannelProducer& Producer
+)
+{
+    PCURSOR_CONTEXT cursor = MonitorContext->Cursor;
+
+    IDARG_IN_QUERY_HWCURSOR queryArgs = {};
+    queryArgs.LastShapeId = cursor->LastIddShapeId;
+    queryArgs.ShapeBufferSizeInBytes = (UINT)cursor->ShapeBuffer.size();
+    queryArgs.pShapeBuffer = cursor->ShapeBuffer.data();
+
+    IDARG_OUT_QUERY_HWCURSOR queryArgsOut = {};
+    NTSTATUS status = IddCxMonitorQueryHardwareCursor(MonitorContext->Monitor, &queryArgs, &queryArgsOut);
+    cursor->Queries++;
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_CURSOR,
+            "查询硬件光标失败，状态=%!STATUS!", status);
+        return;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    const IDDCX_CURSOR_SHAPE_INFO& shapeInfo = queryArgsOut.CursorShapeInfo;
+    const CursorShapeRef* shape = nullptr;
+
+    if (queryArgsOut.IsCursorShapeUpdated)
+    {
+        cursor->LastIddShapeId = shapeInfo.ShapeId;
+
+        CursorShapeInfo info = {};
+        info.Type = (CursorShapeType)shapeInfo.CursorType;
+        info.Width = shapeInfo.Width;
+        info.Height = shapeInfo.Height;
+        info.Pitch = shapeInfo.Pitch;
+
+        CursorShapeLookup lookup;
+        if (cursor->ShapeCache.Lookup(info, cursor->ShapeBuffer.data(), lookup))
+        {
+            info.ShapeId = lookup.ShapeId;
+            if (lookup.Hit || Producer.PublishShape(lookup.Slot, info, cursor->ShapeBuffer.data()))
+            {
+                cursor->Shape = { lookup.ShapeId, lookup.Slot, (INT32)shapeInfo.XHot, (INT32)shapeInfo.YHot };
+                shape = &cursor->Shape;
+            }
+        }
+        else
+        {
+            // 形状超出通道容量，位置事件照常发布
+            TraceEvents(TRACE_LEVEL_WARNING, TRACE_CURSOR,
+                "光标形状超出容量，%ux%u", shapeInfo.Width, shapeInfo.Height);
+        }
+    }
+
+    CursorEvent event;
+    if (cursor->Tracker.Update(
+        queryArgsOut.IsCursorVisible != FALSE,
+        queryArgsOut.X,
+        queryArgsOut.Y,
+        shape,
+        now.QuadPart,
+        event))
+    {
+        Producer.PublishEvent(event);
+        cursor->Events++;
+
+        // 用户在操作，帧处理线程据此退出内容节奏降频；录制时记下事件供回放
+        if (MonitorContext->FramePipeline != nullptr)
+        {
+            MonitorContext->FramePipeline->InputTime.store(now.QuadPart, std::memory_order_relaxed);
+            MonitorContext->FramePipeline->Capture.WriteCursor(event);
+        }
+    }
+}
+
+/*++
+
+Routine Description:
+    光标处理线程入口：等待IddCx新光标数据事件，查询后发布到光标通道
+
+Arguments:
+    Parameter - 监视器上下文
+
+Return Value:
+    线程退出码
+
+--*/
+DWORD WINAPI CursorProcessingThread(
+    _In_ LPVOID Parameter
+)
+{
+    PMONITOR_CONTEXT monitorContext = (PMONITOR_CONTEXT)Parameter;
+    PCURSOR_CONTEXT cursor = monitorContext->Cursor;
+
+    // 光标延迟直接影响手感，与帧处理线程一样注册到MMCSS
+    DWORD avTaskIndex = 0;
+    HANDLE avTask = AvSetMmThreadCharacteristicsW(L"Distribution", &avTaskIndex);
+
+    CursorChannelProducer producer;
+    if (producer.Attach(cursor->ChannelView, cursor->ChannelSize))
+    {
+        HANDLE waitHandles[] =
+        {
+            cursor->DataAvailableEvent,
+            cursor->TerminateEvent
+        };
+
+        for (;;)
+        {
+            DWORD waitResult = WaitForMultipleObjects(
+                ARRAYSIZE(waitHandles), waitHandles, FALSE, INFINITE);
+
+            if (waitResult != WAIT_OBJECT_0)
+            {
+                // 终止事件或等待失败都结束线程
+                break;
+            }
+
+            QueryAndPublishCursor(monitorContext, producer);
+        }
+    }
+
+    const CursorShapeCacheStats& shapeStats = cursor->ShapeCache.Stats();
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CURSOR,
+        "光标处理线程退出，查询=%llu，事件=%llu，无变化=%llu，形状=%llu（命中%llu，淘汰%llu，省下%llu字节）",
+        cursor->Queries, cursor->Events, cursor->Tracker.Suppressed(),
+        shapeStats.Lookups, shapeStats.Hits, shapeStats.Evictions, shapeStats.SavedBytes);
+
+    if (avTask != nullptr)
+    {
+        AvRevertMmThreadCharacteristics(avTask);
+    }
+
+    return 0;
+}
+
+} // namespace
+
+/*++
+
+Routine Description:
+    为监视器创建光标上下文与共享内存光标通道
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS CreateCursorChannel(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PSECURITY_DESCRIPTOR securityDescriptor = nullptr;
+    WCHAR sectionName[64];
+
+    PAGED_CODE();
+
+    PCURSOR_CONTEXT cursor = new (std::nothrow) CURSOR_CONTEXT();
+    if (cursor == nullptr)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    MonitorContext->Cursor = cursor;
+    cursor->ShapeBuffer.resize((SIZE_T)CursorMaxShapeBytes);
+
+    UINT64 channelSize = CursorChannelLayout::RequiredSize();
+
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(
+        EXPANDSCREEN_SHARED_SECTION_SDDL, SDDL_REVISION_1, &securityDescriptor, nullptr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_CURSOR,
+            "创建光标通道安全描述符失败，错误=%d", GetLastError());
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    SECURITY_ATTRIBUTES securityAttributes = {};
+    securityAttributes.nLength = sizeof(securityAttributes);
+    securityAttributes.lpSecurityDescriptor = securityDescriptor;
+    securityAttributes.bInheritHandle = FALSE;
+
+    swprintf_s(sectionName, ARRAYSIZE(sectionName),
+        EXPANDSCREEN_CURSOR_CHANNEL_NAME_FORMAT, MonitorContext->MonitorId);
+
+    HANDLE section = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        &securityAttributes,
+        PAGE_READWRITE,
+        (DWORD)(channelSize >> 32),
+        (DWORD)(channelSize & 0xFFFFFFFF),
+        sectionName);
+
+    LocalFree(securityDescriptor);
+
+    if (section == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_CURSOR,
+            "创建光标通道共享内存失败，错误=%d", GetLastError());
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    PVOID view = MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)channelSize);
+    if (view == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_CURSOR,
+            "映射光标通道失败，错误=%d", GetLastError());
+        CloseHandle(section);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (!CursorChannelProducer::Format(view, channelSize))
+    {
+        UnmapViewOfFile(view);
+        CloseHandle(section);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    cursor->ChannelSection = section;
+    cursor->ChannelView = view;
+    cursor->ChannelSize = channelSize;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CURSOR,
+        "%!FUNC! 监视器ID=%d光标通道已创建，大小=%llu字节",
+        MonitorContext->MonitorId, channelSize);
+
+    return STATUS_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+    释放监视器的光标通道与光标上下文，调用前光标处理线程必须已停止
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID DestroyCursorChannel(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PCURSOR_CONTEXT cursor = MonitorContext->Cursor;
+
+    PAGED_CODE();
+
+    if (cursor == nullptr)
+    {
+        return;
+    }
+
+    if (cursor->ChannelView != nullptr)
+    {
+        UnmapViewOfFile(cursor->ChannelView);
+    }
+
+    if (cursor->ChannelSection != nullptr)
+    {
+        CloseHandle(cursor->ChannelSection);
+    }
+
+    delete cursor;
+    MonitorContext->Cursor = nullptr;
+}
+
+/*++
+
+Routine Description:
+    向IddCx注册硬件光标并启动光标处理线程。每次分配交换链后都需要重新注册
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    NTSTATUS。失败时系统继续把光标合成进桌面图像
+
+--*/
+NTSTATUS StartCursorProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PCURSOR_CONTEXT cursor = MonitorContext->Cursor;
+
+    PAGED_CODE();
+
+    if (cursor == nullptr || cursor->ChannelView == nullptr)
+    {
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    // 自动重置事件，IddCx在光标位置或形状变化时触发
+    cursor->DataAvailableEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    cursor->TerminateEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (cursor->DataAvailableEvent == nullptr || cursor->TerminateEvent == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_CURSOR,
+            "创建光标事件失败，错误=%d", GetLastError());
+        StopCursorProcessing(MonitorContext);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    IDARG_IN_SETUP_HWCURSOR setupArgs = {};
+    setupArgs.CursorInfo.Size = sizeof(IDDCX_CURSOR_CAPS);
+    setupArgs.CursorInfo.AlphaCursorSupport = TRUE;
+    setupArgs.CursorInfo.ColorXorCursorSupport = IDDCX_XOR_CURSOR_SUPPORT_FULL;
+    setupArgs.CursorInfo.MaxX = CursorMaxShapeSize;
+    setupArgs.CursorInfo.MaxY = CursorMaxShapeSize;
+    setupArgs.hNewCursorDataAvailable = cursor->DataAvailableEvent;
+
+    NTSTATUS status = IddCxMonitorSetupHardwareCursor(MonitorContext->Monitor, &setupArgs);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_CURSOR,
+            "注册硬件光标失败，光标将合成进桌面，状态=%!STATUS!", status);
+        StopCursorProcessing(MonitorContext);
+        return status;
+    }
+
+    // 新交换链上第一次查询总是发布完整状态与形状；形状缓存与槽位随通道保留
+    cursor->Tracker.Reset();
+    cursor->LastIddShapeId = 0;
+
+    cursor->ProcessingThread = CreateThread(
+        nullptr, 0, CursorProcessingThread, MonitorContext, 0, nullptr);
+
+    if (cursor->ProcessingThread == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_CURSOR,
+            "创建光标处理线程失败，错误=%d", GetLastError());
+        StopCursorProcessing(MonitorContext);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CURSOR,
+        "%!FUNC! 监视器ID=%d硬件光标已注册", MonitorContext->MonitorId);
+
+    return STATUS_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+    停止光标处理线程，返回时线程已退出
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID StopCursorProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PCURSOR_CONTEXT cursor = MonitorContext->Cursor;
+
+    PAGED_CODE();
+
+    if (cursor == nullptr)
+    {
+        return;
+    }
+
+    if (cursor->ProcessingThread != nullptr)
+    {
+        SetEvent(cursor->TerminateEvent);
+        WaitForSingleObject(cursor->ProcessingThread, INFINITE);
+        CloseHandle(cursor->ProcessingThread);
+        cursor->ProcessingThread = nullptr;
+    }
+
+    if (cursor->TerminateEvent != nullptr)
+    {
+        CloseHandle(cursor->TerminateEvent);
+        cursor->TerminateEvent = nullptr;
+    }
+
+    if (cursor->DataAvailableEvent != nullptr)
+    {
+        CloseHandle(cursor->DataAvailableEvent);
+        cursor->DataAvailableEvent = nullptr;
+    }
+}
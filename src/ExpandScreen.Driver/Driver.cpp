@@ -139,6 +139,14 @@ NTSTATUS ExpandScreenEvtDeviceAdd(
     RtlZeroMemory(deviceContext, sizeof(DEVICE_CONTEXT));
     deviceContext->Device = device;
 
+    // 各监视器的交换链线程把一帧内可并行的工作交给共享执行器，空闲核心可以跨监视器窃取
+    deviceContext->Executor = new (std::nothrow) ExpandScreen::Pipeline::WorkStealingExecutor();
+    if (deviceContext->Executor == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_DRIVER, "分配帧处理任务执行器失败");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
     // 初始化IddCx适配器
     status = InitializeIddCxAdapter(device, deviceContext);
     if (!NT_SUCCESS(status))
@@ -261,6 +269,10 @@ VOID ExpandScreenEvtDeviceCleanup(
         deviceContext->Adapter = nullptr;
     }
 
+    // 监视器（及其交换链线程）先于设备清理，此时执行器已没有提交者
+    delete deviceContext->Executor;
+    deviceContext->Executor = nullptr;
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DRIVER,
         "%!FUNC! 设备资源清理完成");
 }
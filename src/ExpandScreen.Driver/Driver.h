@@ -16,10 +16,37 @@ Environment:
 #include <ntddk.h>
 #include <wdf.h>
 #include <IddCx.h>
+#include <d3d11.h>
+#include <dxgi1_5.h>
 
 // WPP跟踪
 #include "Trace.h"
 
+// 帧处理可移植核心
+#include "Pipeline/DirtyRegion.h"
+#include "Pipeline/MoveRegion.h"
+#include "Pipeline/TileHash.h"
+#include "Pipeline/FrameDiff.h"
+#include "Pipeline/ColorConvert.h"
+#include "Pipeline/IncrementalConvert.h"
+#include "Pipeline/FramePacer.h"
+#include "Pipeline/ContentCadence.h"
+#include "Pipeline/TaskExecutor.h"
+#include "Pipeline/StaticRefinement.h"
+#include "Pipeline/TileClassifier.h"
+#include "Pipeline/VideoRegion.h"
+#include "Pipeline/CursorChannel.h"
+#include "Pipeline/CursorShapeCache.h"
+#include "Pipeline/FrameCapture.h"
+#include "Pipeline/FrameRing.h"
+#include "Pipeline/FrameStageGraph.h"
+#include "Pipeline/SwapChainRecovery.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
 // GUID定义
 // {E5F84A51-B5C1-4F42-9C3D-8E9A4B6C7D8E}
 DEFINE_GUID(GUID_DEVINTERFACE_EXPANDSCREEN,
@@ -34,6 +61,7 @@ typedef struct _DEVICE_CONTEXT
     IDDCX_ADAPTER Adapter;               // IddCx适配器对象
     WDF_POWER_DEVICE_STATE PowerState;   // 当前电源状态
     LONG MonitorCount;                   // 当前监视器数量
+    ExpandScreen::Pipeline::WorkStealingExecutor* Executor; // 各监视器共享的帧处理任务执行器
 } DEVICE_CONTEXT, *PDEVICE_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DEVICE_CONTEXT, GetDeviceContext)
@@ -49,6 +77,74 @@ typedef struct _ADAPTER_CONTEXT
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(ADAPTER_CONTEXT, GetAdapterContext)
 
+//
+// 每个交换链的帧作业数（暂存纹理数）：获取线程正在拷入的一个、发布级保留的最近发布的一个
+// （静止补偿帧的内容），其余在比较级与发布级之间
+//
+#define FRAME_JOB_COUNT 4
+#define FRAME_JOB_NONE ((UINT32)-1)
+
+//
+// 一个待发布帧：获取线程拷入暂存纹理并合并损伤区域，定速到期时封存交给比较级，
+// 比较级剔除未变化的区域，发布级写入帧环
+//
+typedef struct _FRAME_JOB
+{
+    ExpandScreen::Pipeline::FrameDamageAccumulator Damage;          // 合并的损伤区域
+    INT32 Width = 0;                                                // 暂存纹理中帧的尺寸
+    INT32 Height = 0;
+    INT64 PresentTime = 0;                                          // 最新一次提交的时间（QPC）
+    INT64 AcquireTime = 0;                                          // 最新一次获取缓冲区的时间（QPC）
+    UINT64 PresentFrameNumber = 0;                                  // 最新一次提交的DWM帧号
+    INT64 PublishTime = 0;                                          // 定速发布时间（QPC）
+    UINT32 Flags = 0;                                               // FrameFlagRefinement：补偿帧，内容取最近发布的作业
+    NTSTATUS Status = 0;                                            // 比较级的结果，失败时发布级只记录丢弃
+    D3D11_MAPPED_SUBRESOURCE Mapped = {};                           // 比较级映射，发布级写完后解除
+    BOOLEAN IsMapped = FALSE;
+    ExpandScreen::Pipeline::FrameRect DirtyRects[ExpandScreen::Pipeline::FrameRingMaxDirtyRects]; // 发布的脏矩形（补偿帧为补偿区域）
+    UINT DirtyRectCount = 0;
+    UINT MoveRegionCount = 0;                                       // 发布的移动区域（Damage.Moves()的前若干个）
+    ExpandScreen::Pipeline::FrameRect ReportedBounds = {};          // 上报损伤的包围矩形，交给节奏检测
+} FRAME_JOB, *PFRAME_JOB;
+
+//
+// 帧处理流水线状态（C++对象，随监视器创建和销毁，交换链重新分配时保留）
+//
+typedef struct _FRAME_PIPELINE
+{
+    std::vector<ExpandScreen::Pipeline::FrameRect> RawDirtyRects;   // IddCx原始脏矩形
+    ExpandScreen::Pipeline::DirtyRegionCoalescer DirtyRegions;      // 脏矩形合并与对齐
+    std::vector<ExpandScreen::Pipeline::FrameMoveRegion> RawMoveRegions; // IddCx原始移动区域
+    ExpandScreen::Pipeline::TileHasher TileHashes;                  // 块内容哈希，剔除原样重绘
+    ExpandScreen::Pipeline::FrameDiffer FrameDiff;                  // 与上一发布帧逐像素比较，收缩脏矩形
+    BOOLEAN ExactDiff = TRUE;                                       // 用逐像素比较（常驻一份BGRA帧），否则用块哈希
+    std::vector<ExpandScreen::Pipeline::FrameRect> ChangedRects;    // 剔除后的脏矩形
+    ExpandScreen::Pipeline::PixelFormat OutputFormat = ExpandScreen::Pipeline::PixelFormat::Nv12; // 帧环像素格式
+    ExpandScreen::Pipeline::IncrementalNv12Converter Nv12Frame;     // 常驻NV12图像，增量转换（默认BT.709有限范围）
+    ExpandScreen::Pipeline::FramePacer Pacer;                       // 按提交模式刷新率定速
+    INT32 PendingWidth = 0;                                         // 获取线程最近拷入的表面尺寸，待发布帧的损伤区域与时间戳在OpenJob中
+    INT32 PendingHeight = 0;
+    ExpandScreen::Pipeline::StaticRefinementConfig RefinementConfig; // 静止画质补偿配置，交换链启动时生效
+    ExpandScreen::Pipeline::StaticRefinementPolicy Refinement;      // 静止后对已发布损伤区域发布补偿帧
+    ExpandScreen::Pipeline::ContentClassifierConfig ContentConfig;  // 块内容分类配置，交换链启动时生效
+    ExpandScreen::Pipeline::TileContentClassifier ContentClassifier; // 脏块的文字/自然图像/视频分类，随帧发布
+    ExpandScreen::Pipeline::VideoRegionConfig VideoConfig;          // 视频区域检测配置，交换链启动时生效
+    ExpandScreen::Pipeline::VideoRegionDetector VideoRegions;       // 按损伤热度检测稳定更新的视频区域，随帧发布
+    ExpandScreen::Pipeline::ContentCadenceConfig CadenceConfig;     // 内容节奏检测配置，交换链启动时生效
+    ExpandScreen::Pipeline::ContentCadenceDetector Cadence;         // 内容帧率低于刷新率时挂起重复提交
+    std::atomic<INT64> InputTime{ 0 };                              // 最近一次光标输入（QPC），由光标线程写入
+    ExpandScreen::Pipeline::FrameCaptureWriter Capture;             // 帧录制，未启用时不挂接；光标线程同时写入光标事件
+    ExpandScreen::Pipeline::FrameStageGraph Stages;                 // 比较级与发布级，随帧处理线程启动和停止
+    FRAME_JOB Jobs[FRAME_JOB_COUNT];                                // 帧作业，下标与暂存纹理一致
+    UINT32 OpenJob = FRAME_JOB_NONE;                                // 获取线程正在拷入的作业
+    UINT32 PublishedJob = FRAME_JOB_NONE;                           // 发布级保留的最近发布的作业
+    BOOLEAN PipelinedStages = TRUE;                                 // 比较级与发布级各在一个线程上，否则在获取线程上串行
+    BOOLEAN DiffFullFrame = FALSE;                                  // 比较级：上一帧内容丢失，下一帧整帧处理
+    BOOLEAN DiffKeepReference = FALSE;                              // 比较级：已重发最后一帧，恢复后的整帧损伤与参考帧比较
+    ExpandScreen::Pipeline::SwapChainRecovery Recovery;             // 交换链失效恢复，帧环与以上状态都跨交换链保留
+    std::mutex FeedbackLock;                                        // 节奏检测与静止补偿：获取线程查询，发布级更新
+} FRAME_PIPELINE, *PFRAME_PIPELINE;
+
 //
 // 监视器上下文结构
 //
@@ -59,6 +155,19 @@ typedef struct _MONITOR_CONTEXT
     UINT MonitorId;                      // 监视器ID
     BOOLEAN IsActive;                    // 是否激活
     IDDCX_SWAPCHAIN SwapChain;           // 交换链对象
+    struct _SWAPCHAIN_CONTEXT* SwapChainContext; // 交换链处理上下文
+    HANDLE FrameRingSection;             // 共享内存帧环节对象
+    PVOID FrameRingView;                 // 帧环映射地址
+    UINT64 FrameRingSize;                // 帧环大小（字节）
+    HANDLE FrameAckSection;              // 消费者确认块节对象（用户态可写）
+    PVOID FrameAckView;                  // 确认块映射地址
+    PFRAME_PIPELINE FramePipeline;       // 帧处理流水线状态
+    UINT RefreshNumerator;               // 已提交模式的刷新率（Hz，分数形式），0表示未知
+    UINT RefreshDenominator;
+    struct _CURSOR_CONTEXT* Cursor;      // 硬件光标通道与处理线程
+    HANDLE CaptureFile;                  // 帧录制文件，未启用录制时为nullptr
+    HANDLE CaptureSection;
+    PVOID CaptureView;
 } MONITOR_CONTEXT, *PMONITOR_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(MONITOR_CONTEXT, GetMonitorContext)
@@ -71,11 +180,36 @@ typedef struct _SWAPCHAIN_CONTEXT
     IDDCX_SWAPCHAIN SwapChain;           // IddCx交换链对象
     PMONITOR_CONTEXT MonitorContext;     // 所属监视器
     HANDLE ProcessingThread;             // 帧处理线程
-    BOOLEAN TerminateThread;             // 线程终止标志
+    HANDLE FrameAvailableEvent;          // IddCx新帧事件（由IddCx拥有）
+    HANDLE TerminateEvent;               // 线程终止事件
+    ID3D11Device* Device;                // 渲染适配器上的D3D设备
+    ID3D11DeviceContext* DeviceContext;  // D3D即时上下文
+    ID3D11Texture2D* StagingTextures[FRAME_JOB_COUNT]; // CPU可读暂存纹理，每个帧作业一个
+    HANDLE PacingTimer;                  // 定速定时器，待发布帧到达区间边界时触发
 } SWAPCHAIN_CONTEXT, *PSWAPCHAIN_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(SWAPCHAIN_CONTEXT, GetSwapChainContext)
 
+//
+// 硬件光标上下文（C++对象，随监视器创建和销毁；处理线程随交换链启动和停止）
+//
+typedef struct _CURSOR_CONTEXT
+{
+    HANDLE ChannelSection;               // 光标通道共享内存节对象
+    PVOID ChannelView;                   // 光标通道映射地址
+    UINT64 ChannelSize;                  // 光标通道大小（字节）
+    HANDLE DataAvailableEvent;           // IddCx新光标数据事件（驱动创建）
+    HANDLE TerminateEvent;               // 线程终止事件
+    HANDLE ProcessingThread;             // 光标处理线程
+    ExpandScreen::Pipeline::CursorStateTracker Tracker;             // 去掉无变化的查询
+    ExpandScreen::Pipeline::CursorShapeCache ShapeCache;            // 形状内容到缓存ID与槽位
+    ExpandScreen::Pipeline::CursorShapeRef Shape = {};              // 当前形状
+    UINT32 LastIddShapeId = 0;                                      // IddCx上次上报的形状ID
+    std::vector<BYTE> ShapeBuffer;                                  // IddCx写入形状的缓冲区
+    UINT64 Queries = 0;                                             // 查询次数
+    UINT64 Events = 0;                                              // 发布的事件数
+} CURSOR_CONTEXT, *PCURSOR_CONTEXT;
+
 //
 // 支持的显示模式定义
 //
@@ -130,14 +264,116 @@ EVT_IDD_CX_MONITOR_GET_DEFAULT_DESCRIPTION_MODES ExpandScreenEvtMonitorGetDefaul
 EVT_IDD_CX_MONITOR_QUERY_TARGET_MODES ExpandScreenEvtMonitorQueryTargetModes;
 EVT_IDD_CX_MONITOR_ASSIGN_SWAPCHAIN ExpandScreenEvtMonitorAssignSwapChain;
 EVT_IDD_CX_MONITOR_UNASSIGN_SWAPCHAIN ExpandScreenEvtMonitorUnassignSwapChain;
+EVT_WDF_OBJECT_CONTEXT_CLEANUP ExpandScreenEvtMonitorContextCleanup;
 
 //
 // 函数声明 - SwapChain.cpp
 //
+NTSTATUS StartSwapChainProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _In_ const IDARG_IN_SETSWAPCHAIN* pInArgs
+);
+
+VOID StopSwapChainProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
 NTSTATUS ProcessSwapChainFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ const IDARG_OUT_RELEASEANDACQUIREBUFFER* Buffer
+);
+
+//
+// 函数声明 - FrameRing.cpp
+//
+NTSTATUS CreateFrameRing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+VOID DestroyFrameRing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+NTSTATUS CaptureFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ const IDARG_OUT_RELEASEANDACQUIREBUFFER* Buffer
+);
+
+NTSTATUS SubmitPendingFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+);
+
+NTSTATUS SubmitRefinementFrame(
     _In_ PSWAPCHAIN_CONTEXT SwapChainContext
 );
 
+NTSTATUS StartFrameStages(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+);
+
+VOID StopFrameStages(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+);
+
+BOOLEAN RetransmitLastFrame(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _In_ INT64 PublishTime
+);
+
+// 每个监视器的帧环槽位数
+#define FRAME_RING_SLOT_COUNT 3
+
+// 帧环共享内存名称，%u为监视器ID；用户态以FILE_MAP_READ打开
+#define EXPANDSCREEN_FRAME_RING_NAME_FORMAT L"Global\\ExpandScreenFrameRing%u"
+
+// 共享内存节的访问控制：系统和LocalService（驱动宿主）完全访问，交互用户与管理员只读
+#define EXPANDSCREEN_SHARED_SECTION_SDDL L"D:P(A;;GA;;;SY)(A;;GA;;;LS)(A;;GR;;;IU)(A;;GR;;;BA)"
+
+// 帧环消费者确认块名称，%u为监视器ID；用户态以FILE_MAP_READ | FILE_MAP_WRITE打开
+#define EXPANDSCREEN_FRAME_ACK_NAME_FORMAT L"Global\\ExpandScreenFrameAck%u"
+
+// 确认块的访问控制：交互用户与管理员可读写（驱动只读取其中的帧号，不信任其内容）
+#define EXPANDSCREEN_ACK_SECTION_SDDL L"D:P(A;;GA;;;SY)(A;;GA;;;LS)(A;;GRGW;;;IU)(A;;GRGW;;;BA)"
+
+//
+// 函数声明 - FrameCapture.cpp
+//
+VOID StartFrameCapture(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+VOID StopFrameCapture(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+// 驱动参数键下的录制文件大小（MB，DWORD），0或不存在时不录制
+#define EXPANDSCREEN_CAPTURE_SIZE_VALUE L"FrameCaptureMegabytes"
+
+// 录制文件路径：临时目录、监视器ID与开始时间
+#define EXPANDSCREEN_CAPTURE_FILE_FORMAT L"%wsExpandScreenCapture%u-%04u%02u%02u-%02u%02u%02u.esfc"
+
+//
+// 函数声明 - Cursor.cpp
+//
+NTSTATUS CreateCursorChannel(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+VOID DestroyCursorChannel(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+NTSTATUS StartCursorProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+VOID StopCursorProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+);
+
+// 光标通道共享内存名称，%u为监视器ID；用户态以FILE_MAP_READ打开
+#define EXPANDSCREEN_CURSOR_CHANNEL_NAME_FORMAT L"Global\\ExpandScreenCursor%u"
+
 //
 // 函数声明 - Edid.cpp
 //
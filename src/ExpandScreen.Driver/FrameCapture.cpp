@@ -0,0 +1,210 @@
+/*++
+
+Module Name:
+    FrameCapture.cpp
+
+Abstract:
+    帧录制：驱动参数键下的FrameCaptureMegabytes非0时，每次分配交换链都在临时目录
+    创建一个该大小的录制文件并映射，帧处理线程记录每次提交，光标线程记录光标事件。
+    文件格式见Pipeline/FrameCapture.h，回放工具见ExpandScreen.Driver.Tests/Replay
+
+    录制只用于诊断：每次提交都要映射暂存纹理读回像素，默认关闭
+
+Environment:
+    Kernel-mode Driver Framework
+
+--*/
+
+#include "Driver.h"
+#include "FrameCapture.tmh"
+
+#ifdef ALLOC_PRAGMA
+#pragma alloc_text(PAGE, StartFrameCapture)
+#pragma alloc_text(PAGE, StopFrameCapture)
+#endif
+
+using namespace ExpandScreen::Pipeline;
+
+namespace
+{
+
+//
+// 读取录制文件大小（MB），未配置时为0
+//
+ULONG QueryCaptureMegabytes()
+{
+    WDFKEY key = nullptr;
+    ULONG megabytes = 0;
+    DECLARE_CONST_UNICODE_STRING(valueName, EXPANDSCREEN_CAPTURE_SIZE_VALUE);
+
+    if (!NT_SUCCESS(WdfDriverOpenParametersRegistryKey(
+        WdfGetDriver(), KEY_READ, WDF_NO_OBJECT_ATTRIBUTES, &key)))
+    {
+        return 0;
+    }
+
+    if (!NT_SUCCESS(WdfRegistryQueryULong(key, &valueName, &megabytes)))
+    {
+        megabytes = 0;
+    }
+
+    WdfRegistryClose(key);
+    return megabytes;
+}
+
+} // namespace
+
+/*++
+
+Routine Description:
+    按配置为监视器创建录制文件并挂接到帧处理流水线，须在帧处理线程与光标线程
+    启动之前调用。录制失败不影响出图
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID StartFrameCapture(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    WCHAR directory[MAX_PATH];
+    WCHAR path[MAX_PATH];
+    SYSTEMTIME now;
+
+    PAGED_CODE();
+
+    const ULONG megabytes = QueryCaptureMegabytes();
+    if (megabytes == 0 || MonitorContext->FramePipeline == nullptr)
+    {
+        return;
+    }
+
+    const UINT64 size = (UINT64)megabytes << 20;
+
+    DWORD length = GetTempPathW(ARRAYSIZE(directory), directory);
+    if (length == 0 || length >= ARRAYSIZE(directory))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "取临时目录失败，错误=%d", GetLastError());
+        return;
+    }
+
+    GetLocalTime(&now);
+    swprintf_s(path, ARRAYSIZE(path), EXPANDSCREEN_CAPTURE_FILE_FORMAT,
+        directory, MonitorContext->MonitorId,
+        now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond);
+
+    HANDLE file = CreateFileW(
+        path,
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建录制文件失败，错误=%d", GetLastError());
+        return;
+    }
+
+    HANDLE section = CreateFileMappingW(
+        file,
+        nullptr,
+        PAGE_READWRITE,
+        (DWORD)(size >> 32),
+        (DWORD)(size & 0xFFFFFFFF),
+        nullptr);
+    PVOID view = section != nullptr ? MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size) : nullptr;
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    if (view == nullptr ||
+        !FrameCaptureWriter::Format(
+            view,
+            size,
+            0,
+            frequency.QuadPart,
+            MonitorContext->RefreshNumerator,
+            MonitorContext->RefreshDenominator))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "映射录制文件失败，大小=%lluMB，错误=%d", (UINT64)megabytes, GetLastError());
+        if (view != nullptr)
+        {
+            UnmapViewOfFile(view);
+        }
+        if (section != nullptr)
+        {
+            CloseHandle(section);
+        }
+        CloseHandle(file);
+        DeleteFileW(path);
+        return;
+    }
+
+    MonitorContext->FramePipeline->Capture.Attach(view, size);
+    MonitorContext->CaptureFile = file;
+    MonitorContext->CaptureSection = section;
+    MonitorContext->CaptureView = view;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "%!FUNC! 监视器ID=%d开始录制到%ws，大小=%lluMB",
+        MonitorContext->MonitorId, path, (UINT64)megabytes);
+}
+
+/*++
+
+Routine Description:
+    结束录制：解除挂接、写回映射并把文件截断到有效长度。须在帧处理线程与光标
+    线程停止之后调用
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID StopFrameCapture(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PAGED_CODE();
+
+    if (MonitorContext->CaptureView == nullptr)
+    {
+        return;
+    }
+
+    FrameCaptureWriter& capture = MonitorContext->FramePipeline->Capture;
+    const FrameCaptureStats& stats = capture.Stats();
+    LARGE_INTEGER used;
+    used.QuadPart = (LONGLONG)capture.UsedSize();
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "录制结束：帧=%llu，关键帧=%llu，丢弃记录=%llu，补丁像素=%lluB，写入=%lluB",
+        stats.Frames, stats.Keyframes, capture.DroppedRecords(), stats.PatchPixelBytes, stats.StoredBytes);
+
+    capture.Detach();
+
+    FlushViewOfFile(MonitorContext->CaptureView, 0);
+    UnmapViewOfFile(MonitorContext->CaptureView);
+    CloseHandle(MonitorContext->CaptureSection);
+
+    if (SetFilePointerEx(MonitorContext->CaptureFile, used, nullptr, FILE_BEGIN))
+    {
+        SetEndOfFile(MonitorContext->CaptureFile);
+    }
+    CloseHandle(MonitorContext->CaptureFile);
+
+    MonitorContext->CaptureFile = nullptr;
+    MonitorContext->CaptureSection = nullptr;
+    MonitorContext->CaptureView = nullptr;
+}
@@ -0,0 +1,1196 @@
+/*++
+
+Module Name:
+    FrameRing.cpp
+
+Abstract:
+    共享内存帧环的创建与帧发布
+    帧环协议见Pipeline/FrameRing.h，用户态只读映射后就地消费
+
+Environment:
+    Kernel-mode Driver Framework
+
+--*/
+
+#include "Driver.h"
+#include "Pipeline/FrameRing.h"
+#include <sddl.h>
+#include <thread>
+#include "FrameRing.tmh"
+
+#ifdef ALLOC_PRAGMA
+#pragma alloc_text(PAGE, CreateFrameRing)
+#pragma alloc_text(PAGE, DestroyFrameRing)
+#endif
+
+using namespace ExpandScreen::Pipeline;
+
+// IddCx的脏矩形与移动区域直接读入可移植类型
+static_assert(sizeof(FrameRect) == sizeof(RECT), "FrameRect布局必须与RECT一致");
+static_assert(sizeof(FrameMoveRegion) == sizeof(DXGI_OUTDUPL_MOVE_RECT),
+    "FrameMoveRegion布局必须与DXGI_OUTDUPL_MOVE_RECT一致");
+
+namespace
+{
+
+//
+// 按支持的最大模式计算槽位像素容量，模式切换时不需要重建帧环
+//
+UINT64 GetMaxFramePixelBytes()
+{
+    UINT64 maxBytes = 0;
+
+    for (UINT i = 0; i < SUPPORTED_MODE_COUNT; i++)
+    {
+        UINT64 bytes = (UINT64)g_SupportedModes[i].Width * g_SupportedModes[i].Height * 4;
+        if (bytes > maxBytes)
+        {
+            maxBytes = bytes;
+        }
+    }
+
+    return maxBytes;
+}
+
+//
+// 确保作业的暂存纹理与交换链表面尺寸一致
+//
+HRESULT EnsureStagingTexture(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ UINT32 Job,
+    _In_ const D3D11_TEXTURE2D_DESC* SurfaceDesc
+)
+{
+    ID3D11Texture2D*& texture = SwapChainContext->StagingTextures[Job];
+
+    if (texture != nullptr)
+    {
+        D3D11_TEXTURE2D_DESC stagingDesc;
+        texture->GetDesc(&stagingDesc);
+
+        if (stagingDesc.Width == SurfaceDesc->Width &&
+            stagingDesc.Height == SurfaceDesc->Height &&
+            stagingDesc.Format == SurfaceDesc->Format)
+        {
+            return S_OK;
+        }
+
+        texture->Release();
+        texture = nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC stagingDesc = *SurfaceDesc;
+    stagingDesc.MipLevels = 1;
+    stagingDesc.ArraySize = 1;
+    stagingDesc.SampleDesc.Count = 1;
+    stagingDesc.SampleDesc.Quality = 0;
+    stagingDesc.Usage = D3D11_USAGE_STAGING;
+    stagingDesc.BindFlags = 0;
+    stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    stagingDesc.MiscFlags = 0;
+
+    return SwapChainContext->Device->CreateTexture2D(&stagingDesc, nullptr, &texture);
+}
+
+//
+// 在比较级/发布级映射作业的暂存纹理。获取线程的CopyResource可能还没在GPU上完成，
+// 阻塞的Map会持有设备锁等待GPU，挡住获取线程的下一次拷贝，因此不等待、让出后重试
+//
+HRESULT MapStagingTexture(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ UINT32 Job,
+    _Out_ D3D11_MAPPED_SUBRESOURCE* Mapped
+)
+{
+    for (;;)
+    {
+        HRESULT hr = SwapChainContext->DeviceContext->Map(
+            SwapChainContext->StagingTextures[Job], 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, Mapped);
+        if (hr != DXGI_ERROR_WAS_STILL_DRAWING)
+        {
+            return hr;
+        }
+        SwitchToThread();
+    }
+}
+
+//
+// 创建消费者确认块：独立的一页共享内存，用户态可写，驱动据此判断消费者是否落后
+//
+NTSTATUS CreateFrameAck(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PSECURITY_DESCRIPTOR securityDescriptor = nullptr;
+    WCHAR sectionName[64];
+
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(
+        EXPANDSCREEN_ACK_SECTION_SDDL, SDDL_REVISION_1, &securityDescriptor, nullptr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建确认块安全描述符失败，错误=%d", GetLastError());
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    SECURITY_ATTRIBUTES securityAttributes = {};
+    securityAttributes.nLength = sizeof(securityAttributes);
+    securityAttributes.lpSecurityDescriptor = securityDescriptor;
+    securityAttributes.bInheritHandle = FALSE;
+
+    swprintf_s(sectionName, ARRAYSIZE(sectionName),
+        EXPANDSCREEN_FRAME_ACK_NAME_FORMAT, MonitorContext->MonitorId);
+
+    HANDLE section = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        &securityAttributes,
+        PAGE_READWRITE,
+        0,
+        (DWORD)FrameAckBlockSize,
+        sectionName);
+
+    LocalFree(securityDescriptor);
+
+    if (section == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建确认块共享内存失败，错误=%d", GetLastError());
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    PVOID view = MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)FrameAckBlockSize);
+    if (view == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "映射确认块失败，错误=%d", GetLastError());
+        CloseHandle(section);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    FrameRingProducer::FormatAck(view, FrameAckBlockSize);
+
+    MonitorContext->FrameAckSection = section;
+    MonitorContext->FrameAckView = view;
+    return STATUS_SUCCESS;
+}
+
+//
+// 连接帧环与消费者确认块
+//
+bool AttachProducer(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _Inout_ FrameRingProducer& Producer
+)
+{
+    if (!Producer.Attach(MonitorContext->FrameRingView, MonitorContext->FrameRingSize))
+    {
+        return false;
+    }
+
+    Producer.AttachAck(MonitorContext->FrameAckView, FrameAckBlockSize);
+    return true;
+}
+
+//
+// 录制一次提交：读回暂存纹理中的完整图像，连同原始损伤区域与时间戳写入录制文件
+//
+VOID RecordCapturedFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ const CaptureFrameRecord& Frame,
+    _In_ BOOLEAN DirtyKnown,
+    _In_ UINT DirtyRectCount,
+    _In_ UINT MoveRegionCount
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    ID3D11Texture2D* texture = SwapChainContext->StagingTextures[pipeline->OpenJob];
+    D3D11_MAPPED_SUBRESOURCE mapped;
+
+    HRESULT hr = SwapChainContext->DeviceContext->Map(texture, 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+    {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_SWAPCHAIN,
+            "录制时映射暂存纹理失败，hr=0x%08X", hr);
+        pipeline->Capture.RequestKeyframe();
+        return;
+    }
+
+    pipeline->Capture.WriteFrame(
+        Frame,
+        static_cast<const UINT8*>(mapped.pData),
+        mapped.RowPitch,
+        pipeline->RawDirtyRects.data(),
+        DirtyRectCount,
+        pipeline->RawMoveRegions.data(),
+        MoveRegionCount,
+        DirtyKnown != FALSE);
+
+    SwapChainContext->DeviceContext->Unmap(texture, 0);
+}
+
+//
+// 把作业暂存纹理中的帧（已映射）写入下一个槽位并发布。ConvertRects为相对上一帧需要
+// 重新转换的区域，DirtyRects为发布给消费者的脏矩形（补偿帧两者不同）
+//
+VOID WriteFrameSlot(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ FrameRingProducer& Producer,
+    _In_ const FRAME_JOB& Content,
+    _In_reads_opt_(ConvertCount) const FrameRect* ConvertRects,
+    _In_ UINT ConvertCount,
+    _In_reads_opt_(MoveRegionCount) const FrameMoveRegion* MoveRegions,
+    _In_ UINT MoveRegionCount,
+    _In_reads_(DirtyRectCount) const FrameRect* DirtyRects,
+    _In_ UINT DirtyRectCount,
+    _In_ UINT32 Flags,
+    _In_ INT64 PublishTime
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    const D3D11_MAPPED_SUBRESOURCE& mapped = Content.Mapped;
+    const INT32 width = Content.Width;
+    const INT32 height = Content.Height;
+    const UINT pitch = (UINT)width * 4;
+
+    // 消费者落后时覆盖它尚未取走的最新帧，帧号不变，损伤区域由EndWrite合并
+    FrameWriteSlot slot = Producer.BeginWrite();
+
+    // 类别图保存每块最近一次的分类，补偿帧沿用；视频区域为当前检测结果
+    Producer.SetContentClasses(
+        slot,
+        pipeline->ContentClassifier.Columns(),
+        pipeline->ContentClassifier.Rows(),
+        pipeline->ContentClassifier.Classes());
+    Producer.SetVideoRegions(slot, pipeline->VideoRegions.Regions(), pipeline->VideoRegions.RegionCount());
+
+    // 槽位上次持有的内容（按写入序号，覆盖时帧号不变），同尺寸NV12时只需补拷此后的损伤区域
+    const FrameDescriptor& previous = slot.Header->Descriptor;
+    UINT64 slotPublish = 0;
+    if (previous.Format == PixelFormat::Nv12 &&
+        previous.Width == (UINT)width &&
+        previous.Height == (UINT)height &&
+        previous.Pitch == (UINT)width)
+    {
+        slotPublish = slot.PreviousPublish;
+    }
+
+    FrameDescriptor descriptor = {};
+    descriptor.Width = (UINT)width;
+    descriptor.Height = (UINT)height;
+
+    // 编码器都需要NV12：常驻NV12图像只重新转换脏矩形、就地执行移动区域，
+    // 再把槽位缺失的损伤区域拷入槽位；NV12要求宽高为偶数
+    const BYTE* source = static_cast<const BYTE*>(mapped.pData);
+    if (pipeline->OutputFormat == PixelFormat::Nv12 &&
+        pipeline->Nv12Frame.Update(
+            source,
+            mapped.RowPitch,
+            width,
+            height,
+            ConvertRects,
+            ConvertCount,
+            MoveRegions,
+            MoveRegionCount,
+            slot.PublishNumber))
+    {
+        Nv12Surface target = {};
+        target.Y = slot.Pixels;
+        target.YPitch = (SIZE_T)width;
+        target.UV = slot.Pixels + (SIZE_T)width * height;
+        target.UVPitch = (SIZE_T)width;
+
+        pipeline->Nv12Frame.CopyTo(target, slotPublish);
+
+        descriptor.Pitch = (UINT)width;
+        descriptor.Format = PixelFormat::Nv12;
+        descriptor.Matrix = pipeline->Nv12Frame.Converter().Matrix();
+        descriptor.Range = pipeline->Nv12Frame.Converter().Range();
+    }
+    else
+    {
+        for (INT32 y = 0; y < height; y++)
+        {
+            memcpy(slot.Pixels + (SIZE_T)y * pitch, source + (SIZE_T)y * mapped.RowPitch, pitch);
+        }
+
+        descriptor.Pitch = pitch;
+        descriptor.Format = PixelFormat::Bgra8;
+    }
+
+    descriptor.PresentTime = Content.PresentTime;
+    descriptor.AcquireTime = Content.AcquireTime;
+    descriptor.PublishTime = PublishTime;
+    descriptor.PresentFrameNumber = Content.PresentFrameNumber;
+    descriptor.Flags = Flags;
+
+    Producer.EndWrite(slot, descriptor, DirtyRects, DirtyRectCount, MoveRegions, MoveRegionCount);
+
+    // 补偿帧沿用最后一次提交的时间戳，不计入延迟统计
+    LatencyStatsWriter latency;
+    if ((Flags & FrameFlagRefinement) == 0 &&
+        latency.Attach(Producer.Latency(), sizeof(LatencyStatsBlock)))
+    {
+        FrameTimestamps timestamps = {};
+        timestamps.FrameNumber = slot.FrameNumber;
+        timestamps.Stamp(LatencyStage::Present, descriptor.PresentTime);
+        timestamps.Stamp(LatencyStage::Acquire, descriptor.AcquireTime);
+        timestamps.Stamp(LatencyStage::Publish, descriptor.PublishTime);
+        latency.Record(timestamps);
+    }
+}
+
+//
+// 发布级：把最近发布的作业（保留着它的暂存纹理）作为内容发布补偿帧
+//
+VOID PublishRefinement(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ FrameRingProducer& Producer,
+    _In_ const FRAME_JOB& Job
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    const UINT32 contentIndex = pipeline->PublishedJob;
+
+    if (contentIndex == FRAME_JOB_NONE || SwapChainContext->StagingTextures[contentIndex] == nullptr)
+    {
+        return;
+    }
+
+    FRAME_JOB& content = pipeline->Jobs[contentIndex];
+    if ((UINT64)content.Width * 4 * content.Height > Producer.MaxPixelBytes())
+    {
+        return;
+    }
+
+    HRESULT hr = MapStagingTexture(SwapChainContext, contentIndex, &content.Mapped);
+    if (FAILED(hr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "映射暂存纹理失败，hr=0x%08X", hr);
+        return;
+    }
+
+    // 静止期间没有损伤，视频区域在此冷却
+    pipeline->VideoRegions.Update(content.Width, content.Height, nullptr, 0, Job.PublishTime);
+
+    // 内容与上一帧相同，不需要重新转换，只把槽位补齐
+    WriteFrameSlot(
+        SwapChainContext,
+        Producer,
+        content,
+        nullptr,
+        0,
+        nullptr,
+        0,
+        Job.DirtyRects,
+        Job.DirtyRectCount,
+        FrameFlagRefinement,
+        Job.PublishTime);
+
+    SwapChainContext->DeviceContext->Unmap(SwapChainContext->StagingTextures[contentIndex], 0);
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
+        "发布静止补偿帧，区域数=%u", Job.DirtyRectCount);
+}
+
+//
+// 比较级：映射作业的暂存纹理，剔除上报损伤中内容未变化的部分并合并为发布的脏矩形。
+// 结果（包括失败与未变化）都交给发布级，帧环只由发布级写入
+//
+bool DiffStage(
+    _In_ void* Context,
+    _In_ UINT32 JobIndex
+)
+{
+    PSWAPCHAIN_CONTEXT swapChainContext = static_cast<PSWAPCHAIN_CONTEXT>(Context);
+    PFRAME_PIPELINE pipeline = swapChainContext->MonitorContext->FramePipeline;
+    FRAME_JOB& job = pipeline->Jobs[JobIndex];
+
+    job.Status = STATUS_SUCCESS;
+    job.MoveRegionCount = 0;
+
+    // 补偿帧的区域由获取线程填写，内容由发布级取最近发布的作业
+    if ((job.Flags & FrameFlagRefinement) != 0)
+    {
+        return true;
+    }
+
+    job.DirtyRectCount = 0;
+
+    const INT32 width = job.Width;
+    const INT32 height = job.Height;
+    if ((UINT64)width * 4 * height > GetMaxFramePixelBytes())
+    {
+        job.Status = STATUS_BUFFER_TOO_SMALL;
+        return true;
+    }
+
+    HRESULT hr = MapStagingTexture(swapChainContext, JobIndex, &job.Mapped);
+    if (FAILED(hr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "映射暂存纹理失败，hr=0x%08X", hr);
+
+        // 本帧内容丢失，下一帧按整帧处理
+        job.Status = STATUS_UNSUCCESSFUL;
+        pipeline->DiffFullFrame = TRUE;
+        return true;
+    }
+    job.IsMapped = TRUE;
+
+    // 变化未知时作废参考帧/块哈希并按整帧处理；否则移动区域的目标内容已变，
+    // 逐像素比较时先在参考帧上执行移动，块哈希时作废目标块
+    const FrameDamageAccumulator& damage = job.Damage;
+    const FrameRect fullFrame = { 0, 0, width, height };
+    const FrameRect* filterInput = damage.Dirty().data();
+    UINT filterCount = (UINT)damage.Dirty().size();
+    const FrameMoveRegion* moveRegions = damage.Moves().data();
+    UINT moveRegionCount = (UINT)damage.Moves().size();
+
+    if (damage.FullFrame() || pipeline->DiffFullFrame)
+    {
+        // 交换链恢复后第一帧的损伤未知，但参考帧/块哈希仍是已重发的最后一帧，
+        // 整帧比较后只发布实际变化的部分（尺寸变化时参考帧自行作废）
+        if (!pipeline->DiffKeepReference || pipeline->DiffFullFrame)
+        {
+            pipeline->FrameDiff.Reset();
+            pipeline->TileHashes.Reset();
+        }
+        pipeline->DiffFullFrame = FALSE;
+        filterInput = &fullFrame;
+        filterCount = 1;
+        moveRegionCount = 0;
+    }
+    else if (!pipeline->ExactDiff)
+    {
+        for (UINT i = 0; i < moveRegionCount; i++)
+        {
+            pipeline->TileHashes.Invalidate(&moveRegions[i].Destination, 1);
+        }
+    }
+    pipeline->DiffKeepReference = FALSE;
+
+    // 上报损伤的包围矩形，内容确实变化时交给节奏检测，作为内容区域
+    FrameRect reportedBounds = {};
+    for (UINT i = 0; i < filterCount; i++)
+    {
+        reportedBounds = UnionRect(reportedBounds, filterInput[i]);
+    }
+    for (UINT i = 0; i < moveRegionCount; i++)
+    {
+        reportedBounds = UnionRect(reportedBounds, moveRegions[i].Destination);
+    }
+    job.ReportedBounds = reportedBounds;
+
+    // 剔除内容未变化的部分，再合并为有界、互不重叠、按编码块对齐的集合
+    if (pipeline->ExactDiff)
+    {
+        pipeline->FrameDiff.Diff(
+            static_cast<const UINT8*>(job.Mapped.pData),
+            job.Mapped.RowPitch,
+            width,
+            height,
+            filterInput,
+            filterCount,
+            moveRegions,
+            moveRegionCount,
+            pipeline->ChangedRects);
+    }
+    else
+    {
+        pipeline->TileHashes.Filter(
+            static_cast<const UINT8*>(job.Mapped.pData),
+            job.Mapped.RowPitch,
+            width,
+            height,
+            filterInput,
+            filterCount,
+            pipeline->ChangedRects);
+    }
+
+    job.DirtyRectCount = pipeline->DirtyRegions.Coalesce(
+        pipeline->ChangedRects.data(),
+        (UINT)pipeline->ChangedRects.size(),
+        width,
+        height,
+        job.DirtyRects,
+        FrameRingMaxDirtyRects);
+    job.MoveRegionCount = moveRegionCount;
+
+    // 上报的区域内容全部未变化，不需要发布级再读像素
+    if (job.DirtyRectCount == 0 && job.MoveRegionCount == 0)
+    {
+        swapChainContext->DeviceContext->Unmap(swapChainContext->StagingTextures[JobIndex], 0);
+        job.IsMapped = FALSE;
+    }
+
+    return true;
+}
+
+//
+// 发布级：分类、视频区域、转换并写入帧环。发布后保留该作业（补偿帧的内容），
+// 归还上一个保留的作业
+//
+bool PublishStage(
+    _In_ void* Context,
+    _In_ UINT32 JobIndex
+)
+{
+    PSWAPCHAIN_CONTEXT swapChainContext = static_cast<PSWAPCHAIN_CONTEXT>(Context);
+    PMONITOR_CONTEXT monitorContext = swapChainContext->MonitorContext;
+    PFRAME_PIPELINE pipeline = monitorContext->FramePipeline;
+    FRAME_JOB& job = pipeline->Jobs[JobIndex];
+    FrameRingProducer producer;
+
+    const bool attached = AttachProducer(monitorContext, producer);
+    bool published = false;
+
+    if (!attached)
+    {
+        // 帧环不可用，内容无处发布
+    }
+    else if ((job.Flags & FrameFlagRefinement) != 0)
+    {
+        PublishRefinement(swapChainContext, producer, job);
+    }
+    else if (!NT_SUCCESS(job.Status))
+    {
+        producer.RecordDrop(FrameDropReason::Failed);
+    }
+    else if (job.DirtyRectCount == 0 && job.MoveRegionCount == 0)
+    {
+        producer.RecordDrop(FrameDropReason::Unchanged);
+        TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
+            "脏区域内容未变化，跳过帧");
+    }
+    else
+    {
+        // 本帧的损伤区域（含移动区域目标）：对其覆盖的块分类（滚动过来的内容类别可能改变）并计入视频区域热度，
+        // 发布后记录下来，静止后对其发布补偿帧
+        const FrameMoveRegion* moveRegions = job.Damage.Moves().data();
+        FrameRect damageRects[FrameRingMaxDirtyRects + FrameRingMaxMoveRegions];
+        UINT damageCount = 0;
+        for (UINT i = 0; i < job.DirtyRectCount; i++)
+        {
+            damageRects[damageCount++] = job.DirtyRects[i];
+        }
+        for (UINT i = 0; i < job.MoveRegionCount && i < FrameRingMaxMoveRegions; i++)
+        {
+            damageRects[damageCount++] = moveRegions[i].Destination;
+        }
+
+        pipeline->ContentClassifier.Classify(
+            static_cast<const UINT8*>(job.Mapped.pData),
+            job.Mapped.RowPitch,
+            job.Width,
+            job.Height,
+            damageRects,
+            damageCount,
+            job.PublishTime);
+        pipeline->VideoRegions.Update(job.Width, job.Height, damageRects, damageCount, job.PublishTime);
+        {
+            std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+            pipeline->Cadence.OnContentFrame(job.PresentTime, job.ReportedBounds);
+        }
+
+        WriteFrameSlot(
+            swapChainContext,
+            producer,
+            job,
+            job.DirtyRects,
+            job.DirtyRectCount,
+            moveRegions,
+            job.MoveRegionCount,
+            job.DirtyRects,
+            job.DirtyRectCount,
+            0,
+            job.PublishTime);
+
+        std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+        pipeline->Refinement.OnDamage(damageRects, damageCount, job.Width, job.Height, job.PublishTime);
+        published = true;
+    }
+
+    // 定速区间内合并的提交
+    if (attached && job.Damage.FrameCount() > 1)
+    {
+        producer.RecordDrop(FrameDropReason::Coalesced, job.Damage.FrameCount() - 1);
+    }
+
+    if (job.IsMapped)
+    {
+        swapChainContext->DeviceContext->Unmap(swapChainContext->StagingTextures[JobIndex], 0);
+        job.IsMapped = FALSE;
+    }
+
+    if (!published)
+    {
+        pipeline->Stages.Complete(JobIndex);
+        return true;
+    }
+
+    const UINT32 previous = pipeline->PublishedJob;
+    pipeline->PublishedJob = JobIndex;
+    if (previous != FRAME_JOB_NONE)
+    {
+        pipeline->Stages.Complete(previous);
+    }
+    return true;
+}
+
+//
+// 为获取线程取一个空闲作业作为下一个待发布帧，各级都满时等待
+//
+NTSTATUS OpenFrameJob(
+    _In_ PFRAME_PIPELINE Pipeline
+)
+{
+    UINT32 job;
+    if (!Pipeline->Stages.AcquireJob(job))
+    {
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    Pipeline->Jobs[job].Damage.Clear();
+    Pipeline->Jobs[job].Flags = 0;
+    Pipeline->OpenJob = job;
+    return STATUS_SUCCESS;
+}
+
+} // namespace
+
+/*++
+
+Routine Description:
+    为监视器创建共享内存帧环
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS CreateFrameRing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PSECURITY_DESCRIPTOR securityDescriptor = nullptr;
+    WCHAR sectionName[64];
+
+    PAGED_CODE();
+
+    UINT64 maxPixelBytes = GetMaxFramePixelBytes();
+    UINT64 ringSize = FrameRingLayout::RequiredSize(FRAME_RING_SLOT_COUNT, maxPixelBytes);
+
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(
+        EXPANDSCREEN_SHARED_SECTION_SDDL, SDDL_REVISION_1, &securityDescriptor, nullptr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建帧环安全描述符失败，错误=%d", GetLastError());
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    SECURITY_ATTRIBUTES securityAttributes = {};
+    securityAttributes.nLength = sizeof(securityAttributes);
+    securityAttributes.lpSecurityDescriptor = securityDescriptor;
+    securityAttributes.bInheritHandle = FALSE;
+
+    swprintf_s(sectionName, ARRAYSIZE(sectionName),
+        EXPANDSCREEN_FRAME_RING_NAME_FORMAT, MonitorContext->MonitorId);
+
+    HANDLE section = CreateFileMappingW(
+        INVALID_HANDLE_VALUE,
+        &securityAttributes,
+        PAGE_READWRITE,
+        (DWORD)(ringSize >> 32),
+        (DWORD)(ringSize & 0xFFFFFFFF),
+        sectionName);
+
+    LocalFree(securityDescriptor);
+
+    if (section == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建帧环共享内存失败，错误=%d", GetLastError());
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    PVOID view = MapViewOfFile(section, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)ringSize);
+    if (view == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "映射帧环失败，错误=%d", GetLastError());
+        CloseHandle(section);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (!FrameRingProducer::Format(view, ringSize, FRAME_RING_SLOT_COUNT, maxPixelBytes))
+    {
+        UnmapViewOfFile(view);
+        CloseHandle(section);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    NTSTATUS status = CreateFrameAck(MonitorContext);
+    if (!NT_SUCCESS(status))
+    {
+        UnmapViewOfFile(view);
+        CloseHandle(section);
+        return status;
+    }
+
+    // 环头内的驱动侧延迟统计以QPC频率换算
+    FrameRingProducer producer;
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    producer.Attach(view, ringSize);
+    LatencyStatsWriter::Format(producer.Latency(), sizeof(LatencyStatsBlock), frequency.QuadPart);
+
+    MonitorContext->FrameRingSection = section;
+    MonitorContext->FrameRingView = view;
+    MonitorContext->FrameRingSize = ringSize;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "%!FUNC! 监视器ID=%d帧环已创建，大小=%llu字节",
+        MonitorContext->MonitorId, ringSize);
+
+    return STATUS_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+    释放监视器的共享内存帧环
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID DestroyFrameRing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PAGED_CODE();
+
+    if (MonitorContext->FrameRingView != nullptr)
+    {
+        UnmapViewOfFile(MonitorContext->FrameRingView);
+        MonitorContext->FrameRingView = nullptr;
+    }
+
+    if (MonitorContext->FrameRingSection != nullptr)
+    {
+        CloseHandle(MonitorContext->FrameRingSection);
+        MonitorContext->FrameRingSection = nullptr;
+    }
+
+    MonitorContext->FrameRingSize = 0;
+
+    if (MonitorContext->FrameAckView != nullptr)
+    {
+        UnmapViewOfFile(MonitorContext->FrameAckView);
+        MonitorContext->FrameAckView = nullptr;
+    }
+
+    if (MonitorContext->FrameAckSection != nullptr)
+    {
+        CloseHandle(MonitorContext->FrameAckSection);
+        MonitorContext->FrameAckSection = nullptr;
+    }
+}
+
+/*++
+
+Routine Description:
+    捕获已获取的交换链表面：拷贝到待发布作业的暂存纹理，取回脏矩形与移动区域并入
+    待发布帧。表面随后即可释放，待发布帧由SubmitPendingFrame按定速交给比较级与发布级
+
+Arguments:
+    SwapChainContext - 交换链上下文
+    Buffer - 本次获取到的缓冲区
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS CaptureFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ const IDARG_OUT_RELEASEANDACQUIREBUFFER* Buffer
+)
+{
+    PMONITOR_CONTEXT monitorContext = SwapChainContext->MonitorContext;
+    PFRAME_PIPELINE pipeline = monitorContext->FramePipeline;
+    ID3D11Texture2D* surface = nullptr;
+    D3D11_TEXTURE2D_DESC surfaceDesc;
+    LARGE_INTEGER acquireTime;
+    HRESULT hr;
+
+    // 缓冲区刚由IddCxSwapChainReleaseAndAcquireBuffer取得
+    QueryPerformanceCounter(&acquireTime);
+
+    const UINT32 jobIndex = pipeline->OpenJob;
+    if (jobIndex == FRAME_JOB_NONE)
+    {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    FRAME_JOB& job = pipeline->Jobs[jobIndex];
+
+    hr = Buffer->MetaData.pSurface->QueryInterface(IID_PPV_ARGS(&surface));
+    if (FAILED(hr))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "获取交换链纹理失败，hr=0x%08X", hr);
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    surface->GetDesc(&surfaceDesc);
+
+    hr = EnsureStagingTexture(SwapChainContext, jobIndex, &surfaceDesc);
+    if (FAILED(hr))
+    {
+        surface->Release();
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建暂存纹理失败，hr=0x%08X", hr);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    // 暂存纹理只保留最新内容，被跳过的提交只贡献损伤区域
+    SwapChainContext->DeviceContext->CopyResource(SwapChainContext->StagingTextures[jobIndex], surface);
+    surface->Release();
+
+    const INT32 width = (INT32)surfaceDesc.Width;
+    const INT32 height = (INT32)surfaceDesc.Height;
+
+    // 尺寸变化时挂起的损伤区域与测得的内容节奏已失效
+    if (width != pipeline->PendingWidth || height != pipeline->PendingHeight)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+            pipeline->Cadence.Reset();
+        }
+        job.Damage.Clear();
+        job.Damage.AddFullFrame();
+        pipeline->PendingWidth = width;
+        pipeline->PendingHeight = height;
+    }
+    // 取回全部原始脏矩形
+    UINT rawCount = Buffer->MetaData.DirtyRectCount;
+    UINT rawDirtyCount = 0;
+    BOOLEAN dirtyKnown = TRUE;
+
+    if (rawCount != 0)
+    {
+        if (pipeline->RawDirtyRects.size() < rawCount)
+        {
+            pipeline->RawDirtyRects.resize(rawCount);
+        }
+
+        IDARG_IN_GETDIRTYRECTS dirtyArgs = {};
+        IDARG_OUT_GETDIRTYRECTS dirtyArgsOut = {};
+        dirtyArgs.DirtyRectInCount = rawCount;
+        dirtyArgs.pDirtyRects = reinterpret_cast<RECT*>(pipeline->RawDirtyRects.data());
+
+        if (NT_SUCCESS(IddCxSwapChainGetDirtyRects(SwapChainContext->SwapChain, &dirtyArgs, &dirtyArgsOut)))
+        {
+            rawDirtyCount = dirtyArgsOut.DirtyRectOutCount;
+        }
+        else
+        {
+            dirtyKnown = FALSE;
+        }
+    }
+
+    // 取回移动区域（滚动提示），消费者据此把滚动变成本地拷贝加细的脏条带
+    UINT moveRegionCount = 0;
+    UINT rawMoveCount = Buffer->MetaData.MoveRegionCount;
+
+    if (rawMoveCount != 0 && dirtyKnown)
+    {
+        if (pipeline->RawMoveRegions.size() < rawMoveCount)
+        {
+            pipeline->RawMoveRegions.resize(rawMoveCount);
+        }
+
+        IDARG_IN_GETMOVEREGIONS moveArgs = {};
+        IDARG_OUT_GETMOVEREGIONS moveArgsOut = {};
+        moveArgs.MoveRegionInCount = rawMoveCount;
+        moveArgs.pMoveRegions = reinterpret_cast<DXGI_OUTDUPL_MOVE_RECT*>(pipeline->RawMoveRegions.data());
+
+        if (NT_SUCCESS(IddCxSwapChainGetMoveRegions(SwapChainContext->SwapChain, &moveArgs, &moveArgsOut)))
+        {
+            moveRegionCount = ClipMoveRegions(
+                pipeline->RawMoveRegions.data(),
+                moveArgsOut.MoveRegionOutCount,
+                width,
+                height);
+        }
+        else
+        {
+            // 移动区域丢失时其目标内容未知，只能按整帧处理
+            dirtyKnown = FALSE;
+        }
+    }
+
+    FrameRect presentBounds = { 0, 0, width, height };
+    if (dirtyKnown)
+    {
+        job.Damage.Add(
+            pipeline->RawDirtyRects.data(),
+            rawDirtyCount,
+            pipeline->RawMoveRegions.data(),
+            moveRegionCount);
+
+        presentBounds = FrameRect();
+        for (UINT i = 0; i < rawDirtyCount; i++)
+        {
+            presentBounds = UnionRect(presentBounds, pipeline->RawDirtyRects[i]);
+        }
+        for (UINT i = 0; i < moveRegionCount; i++)
+        {
+            presentBounds = UnionRect(presentBounds, pipeline->RawMoveRegions[i].Destination);
+        }
+    }
+    else
+    {
+        job.Damage.AddFullFrame();
+    }
+
+    // DWM未给出提交时间时以获取时间代替
+    INT64 presentTime = (INT64)Buffer->MetaData.PresentDisplayQPCTime;
+    if (presentTime == 0)
+    {
+        presentTime = acquireTime.QuadPart;
+    }
+
+    job.PresentTime = presentTime;
+    job.AcquireTime = acquireTime.QuadPart;
+    job.PresentFrameNumber = Buffer->MetaData.PresentationFrameNumber;
+
+    // 诊断录制：每次提交都读回像素，只在配置了录制时进行
+    if (pipeline->Capture.IsAttached())
+    {
+        CaptureFrameRecord record = {};
+        record.Width = (UINT32)width;
+        record.Height = (UINT32)height;
+        record.PresentTime = presentTime;
+        record.AcquireTime = acquireTime.QuadPart;
+        record.PresentFrameNumber = Buffer->MetaData.PresentationFrameNumber;
+        RecordCapturedFrame(SwapChainContext, record, dirtyKnown, rawDirtyCount, moveRegionCount);
+    }
+
+    // 内容帧率稳定低于刷新率时，内容区域内、早于下一个内容帧的提交只挂起不发布；
+    // 光标输入与区域外的损伤立即恢复按刷新率发布
+    const INT64 inputTime = pipeline->InputTime.load(std::memory_order_relaxed);
+    INT64 holdUntil;
+    {
+        std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+        if (inputTime != 0)
+        {
+            pipeline->Cadence.OnInput(inputTime);
+        }
+        holdUntil = pipeline->Cadence.OnPresent(presentTime, presentBounds);
+    }
+    pipeline->Pacer.OnPresent(presentTime, holdUntil);
+
+    return STATUS_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+    封存待发布帧（定速到期时由帧处理线程调用）：交给比较级与发布级，并取下一个空闲
+    作业继续拷入后续提交。流水线运行时立即返回，串行时返回前已发布；比较级与发布级
+    都满时等待其中一帧发布
+
+Arguments:
+    SwapChainContext - 交换链上下文
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS SubmitPendingFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    LARGE_INTEGER publishTime;
+
+    // 无论成功与否，待发布帧都已消耗，下一个区间重新开始合并
+    QueryPerformanceCounter(&publishTime);
+    pipeline->Pacer.OnEmit(publishTime.QuadPart);
+
+    const UINT32 jobIndex = pipeline->OpenJob;
+    if (jobIndex == FRAME_JOB_NONE)
+    {
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    FRAME_JOB& job = pipeline->Jobs[jobIndex];
+    job.Width = pipeline->PendingWidth;
+    job.Height = pipeline->PendingHeight;
+    job.PublishTime = publishTime.QuadPart;
+    job.Flags = 0;
+
+    pipeline->OpenJob = FRAME_JOB_NONE;
+    pipeline->Stages.Submit(jobIndex);
+
+    return OpenFrameJob(pipeline);
+}
+
+/*++
+
+Routine Description:
+    画面静止后提交一个画质补偿帧：内容为最后发布的帧（发布级保留的作业），脏矩形为
+    静止前发布过的损伤区域，带FrameFlagRefinement标志，消费者以高质量重新编码这些区域
+
+Arguments:
+    SwapChainContext - 交换链上下文
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS SubmitRefinementFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    LARGE_INTEGER publishTime;
+    UINT32 jobIndex;
+
+    // 先取作业再加锁，等待作业时发布级需要取得锁才能归还
+    if (!pipeline->Stages.AcquireJob(jobIndex))
+    {
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    FRAME_JOB& job = pipeline->Jobs[jobIndex];
+    job.Damage.Clear();
+    job.Flags = FrameFlagRefinement;
+    job.DirtyRectCount = 0;
+
+    // 无论成功与否都计入，失败时不反复重试
+    QueryPerformanceCounter(&publishTime);
+    job.PublishTime = publishTime.QuadPart;
+    {
+        std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+        const std::vector<FrameRect>& region = pipeline->Refinement.Region();
+        for (; job.DirtyRectCount < (UINT)region.size() && job.DirtyRectCount < FrameRingMaxDirtyRects; job.DirtyRectCount++)
+        {
+            job.DirtyRects[job.DirtyRectCount] = region[job.DirtyRectCount];
+        }
+        pipeline->Refinement.OnRefined(publishTime.QuadPart);
+    }
+
+    if (job.DirtyRectCount == 0)
+    {
+        pipeline->Stages.Complete(jobIndex);
+        return STATUS_SUCCESS;
+    }
+
+    pipeline->Stages.Submit(jobIndex);
+    return STATUS_SUCCESS;
+}
+
+/*++
+
+Routine Description:
+    启动比较级与发布级并取第一个待发布作业，由帧处理线程在进入循环前调用。
+    关闭流水线或只有一个处理器时各级在帧处理线程上串行执行
+
+Arguments:
+    SwapChainContext - 交换链上下文
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS StartFrameStages(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+    static const FrameStageFunction stages[] = { DiffStage, PublishStage };
+
+    const bool threaded = pipeline->PipelinedStages && std::thread::hardware_concurrency() > 1;
+    if (!pipeline->Stages.Start(stages, ARRAYSIZE(stages), SwapChainContext, FRAME_JOB_COUNT, threaded))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    pipeline->PublishedJob = FRAME_JOB_NONE;
+    pipeline->DiffFullFrame = FALSE;
+    return OpenFrameJob(pipeline);
+}
+
+/*++
+
+Routine Description:
+    处理完已提交的作业后停止比较级与发布级，由帧处理线程在退出前调用。
+    返回后暂存纹理不再被映射，可以随交换链设备释放
+
+Arguments:
+    SwapChainContext - 交换链上下文
+
+Return Value:
+    无
+
+--*/
+VOID StopFrameStages(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext
+)
+{
+    PFRAME_PIPELINE pipeline = SwapChainContext->MonitorContext->FramePipeline;
+
+    pipeline->Stages.Stop();
+
+    for (UINT32 i = 0; i < FRAME_JOB_COUNT; i++)
+    {
+        if (pipeline->Jobs[i].IsMapped)
+        {
+            SwapChainContext->DeviceContext->Unmap(SwapChainContext->StagingTextures[i], 0);
+            pipeline->Jobs[i].IsMapped = FALSE;
+        }
+    }
+
+    pipeline->OpenJob = FRAME_JOB_NONE;
+    pipeline->PublishedJob = FRAME_JOB_NONE;
+}
+
+/*++
+
+Routine Description:
+    交换链失效后重新分配时，把帧环中最后发布的帧原样再发布一次（整帧脏矩形，带
+    FrameFlagRecovery），消费者不必等桌面下一次变化就能重新出图。由分配回调在帧处理
+    线程启动前调用，此时没有其他线程写入帧环
+
+Arguments:
+    MonitorContext - 监视器上下文
+    PublishTime - 重发时间（QPC）
+
+Return Value:
+    已重发返回TRUE；帧环不可用或尚无已发布帧时返回FALSE
+
+--*/
+BOOLEAN RetransmitLastFrame(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _In_ INT64 PublishTime
+)
+{
+    PFRAME_PIPELINE pipeline = MonitorContext->FramePipeline;
+    FrameRingProducer producer;
+
+    if (!AttachProducer(MonitorContext, producer) ||
+        !producer.Republish(FrameFlagRecovery, PublishTime))
+    {
+        return FALSE;
+    }
+
+    // 参考帧、块哈希与常驻NV12图像都与重发的帧一致，新交换链的第一帧不必整帧发布
+    pipeline->DiffKeepReference = TRUE;
+    return TRUE;
+}
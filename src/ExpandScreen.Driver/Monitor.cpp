@@ -20,6 +20,7 @@ Environment:
 #pragma alloc_text(PAGE, ExpandScreenEvtMonitorQueryTargetModes)
 #pragma alloc_text(PAGE, ExpandScreenEvtMonitorAssignSwapChain)
 #pragma alloc_text(PAGE, ExpandScreenEvtMonitorUnassignSwapChain)
+#pragma alloc_text(PAGE, ExpandScreenEvtMonitorContextCleanup)
 #endif
 
 // 监视器ID计数器
@@ -80,6 +81,7 @@ NTSTATUS CreateMonitor(
 
     // 设置监视器对象属性
     WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&monitorAttributes, MONITOR_CONTEXT);
+    monitorAttributes.EvtCleanupCallback = ExpandScreenEvtMonitorContextCleanup;
 
     // 创建监视器对象
     IDARG_IN_MONITORCREATE monitorCreate = {};
@@ -105,6 +107,42 @@ NTSTATUS CreateMonitor(
     monitorContext->MonitorId = monitorInfo.ConnectorIndex;
     monitorContext->IsActive = FALSE;
     monitorContext->SwapChain = nullptr;
+    monitorContext->SwapChainContext = nullptr;
+    monitorContext->RefreshNumerator = 0;
+    monitorContext->RefreshDenominator = 0;
+    monitorContext->Cursor = nullptr;
+    monitorContext->CaptureFile = nullptr;
+    monitorContext->CaptureSection = nullptr;
+    monitorContext->CaptureView = nullptr;
+
+    monitorContext->FramePipeline = new (std::nothrow) FRAME_PIPELINE();
+    if (monitorContext->FramePipeline == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_MONITOR, "分配帧处理流水线失败");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    // 大面积损伤按行带在设备共享的执行器上并行转换
+    monitorContext->FramePipeline->Nv12Frame.SetExecutor(
+        GetAdapterContext(Adapter)->DeviceContext->Executor);
+
+    // 帧环随监视器存在，交换链重新分配时保持不变
+    status = CreateFrameRing(monitorContext);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_MONITOR,
+            "创建帧环失败，状态=%!STATUS!", status);
+        return status;
+    }
+
+    // 光标通道与帧环一样随监视器存在
+    status = CreateCursorChannel(monitorContext);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_MONITOR,
+            "创建光标通道失败，状态=%!STATUS!", status);
+        return status;
+    }
 
     // 设置监视器回调
     IDDCX_MONITOR_CALLBACKS monitorCallbacks = {};
@@ -290,11 +328,36 @@ NTSTATUS ExpandScreenEvtMonitorAssignSwapChain(
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_MONITOR,
         "%!FUNC! 为监视器ID=%d分配交换链", monitorContext->MonitorId);
 
+    // 录制（按配置）须在两个处理线程启动前挂接
+    StartFrameCapture(monitorContext);
+
+    NTSTATUS status = StartSwapChainProcessing(monitorContext, pInArgs);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_MONITOR,
+            "启动帧处理失败，状态=%!STATUS!", status);
+        StopFrameCapture(monitorContext);
+
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        monitorContext->FramePipeline->Recovery.OnAssignFailed(now.QuadPart);
+
+        // 分配失败时由驱动删除交换链，IddCx随后会重新分配
+        WdfObjectDelete(pInArgs->hSwapChain);
+        return status;
+    }
+
+    // 硬件光标失败不影响出图，系统会退回到把光标合成进桌面图像
+    status = StartCursorProcessing(monitorContext);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_MONITOR,
+            "硬件光标不可用，使用软件光标，状态=%!STATUS!", status);
+    }
+
     monitorContext->SwapChain = pInArgs->hSwapChain;
     monitorContext->IsActive = TRUE;
 
-    // 注意：实际的帧处理将在SwapChain.cpp中实现
-
     return STATUS_SUCCESS;
 }
 
@@ -321,8 +384,48 @@ NTSTATUS ExpandScreenEvtMonitorUnassignSwapChain(
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_MONITOR,
         "%!FUNC! 取消监视器ID=%d的交换链", monitorContext->MonitorId);
 
+    // 必须在返回前停止帧处理线程，之后IddCx会销毁交换链
+    StopCursorProcessing(monitorContext);
+    StopSwapChainProcessing(monitorContext);
+    StopFrameCapture(monitorContext);
+
+    // 交换链失效引起的取消分配不结束中断，帧环与流水线状态留给重新分配的交换链
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    monitorContext->FramePipeline->Recovery.OnUnassign(now.QuadPart);
+
     monitorContext->SwapChain = nullptr;
     monitorContext->IsActive = FALSE;
 
     return STATUS_SUCCESS;
 }
+
+/*++
+
+Routine Description:
+    监视器对象清理回调，释放帧环、光标通道与帧处理流水线
+
+Arguments:
+    Object - IddCx监视器对象
+
+Return Value:
+    无
+
+--*/
+VOID ExpandScreenEvtMonitorContextCleanup(
+    _In_ WDFOBJECT Object
+)
+{
+    PMONITOR_CONTEXT monitorContext = GetMonitorContext(Object);
+
+    PAGED_CODE();
+
+    StopCursorProcessing(monitorContext);
+    StopSwapChainProcessing(monitorContext);
+    StopFrameCapture(monitorContext);
+    DestroyCursorChannel(monitorContext);
+    DestroyFrameRing(monitorContext);
+
+    delete monitorContext->FramePipeline;
+    monitorContext->FramePipeline = nullptr;
+}
@@ -0,0 +1,550 @@
+/*++
+
+Module Name:
+    ColorConvert.h
+
+Abstract:
+    BGRA8到NV12的颜色转换
+
+    支持BT.601/BT.709矩阵与有限/完整范围。定点实现：亮度系数按2^14缩放，
+    色度先对2x2像素求和再乘以同一组系数（等效缩放2^16）。所有内核只使用
+    精确的整数乘加与算术右移，标量、SSE4.1、AVX2、AVX-512结果逐位一致。
+
+    NV12布局：Y平面每像素1字节；UV平面每2x2像素一对(U, V)，半高。
+    转换按矩形进行，矩形需按2像素对齐（见AlignToChroma）。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "FrameTypes.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 定点系数，由MakeYuvCoefficients生成
+//
+struct YuvCoefficients
+{
+    int16_t YB, YG, YR;
+    int16_t UB, UG, UR;
+    int16_t VB, VG, VR;
+    int32_t YBias;          // (亮度偏移 << 14) + 舍入
+    int32_t ChromaBias;     // (128 << 16) + 舍入
+};
+
+constexpr int YuvLumaShift = 14;
+constexpr int YuvChromaShift = 16;
+
+inline YuvCoefficients MakeYuvCoefficients(YuvMatrix matrix, YuvRange range)
+{
+    const double kr = matrix == YuvMatrix::Bt709 ? 0.2126 : 0.299;
+    const double kb = matrix == YuvMatrix::Bt709 ? 0.0722 : 0.114;
+    const bool full = range == YuvRange::Full;
+    const double lumaScale = (full ? 255.0 : 219.0) / 255.0 * (1 << YuvLumaShift);
+    const double chromaScale = (full ? 255.0 : 224.0) / 255.0 * (1 << YuvLumaShift);
+
+    YuvCoefficients c;
+    c.YR = (int16_t)std::lround(kr * lumaScale);
+    c.YB = (int16_t)std::lround(kb * lumaScale);
+    c.YG = (int16_t)(std::lround(lumaScale) - c.YR - c.YB);     // 系数和精确，白色不溢出
+
+    c.UB = (int16_t)std::lround(0.5 * chromaScale);
+    c.UR = (int16_t)std::lround(-kr / (2.0 * (1.0 - kb)) * chromaScale);
+    c.UG = (int16_t)(-c.UB - c.UR);                             // 系数和为零，灰色精确为128
+
+    c.VR = (int16_t)std::lround(0.5 * chromaScale);
+    c.VB = (int16_t)std::lround(-kb / (2.0 * (1.0 - kr)) * chromaScale);
+    c.VG = (int16_t)(-c.VR - c.VB);
+
+    c.YBias = ((full ? 0 : 16) << YuvLumaShift) + (1 << (YuvLumaShift - 1));
+    c.ChromaBias = (128 << YuvChromaShift) + (1 << (YuvChromaShift - 1));
+    return c;
+}
+
+//
+// NV12目标图像（不持有内存）
+//
+struct Nv12Surface
+{
+    uint8_t* Y;
+    size_t YPitch;
+    uint8_t* UV;
+    size_t UVPitch;
+};
+
+//
+// 矩形向外对齐到偶数坐标并裁剪到帧内
+//
+inline FrameRect AlignToChroma(const FrameRect& rect, int32_t width, int32_t height)
+{
+    FrameRect aligned =
+    {
+        rect.Left & ~1,
+        rect.Top & ~1,
+        (rect.Right + 1) & ~1,
+        (rect.Bottom + 1) & ~1
+    };
+    return IntersectRect(aligned, { 0, 0, width & ~1, height & ~1 });
+}
+
+namespace ColorDetail {
+
+inline uint8_t Clamp255(int32_t value)
+{
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+//
+// 转换一对像素行：bgra0/bgra1为相邻两行，输出两行Y与一行UV。
+// 从第begin个像素（偶数）开始到第end个像素（偶数）为止
+//
+inline void ConvertRowPairScalar(
+    const uint8_t* bgra0,
+    const uint8_t* bgra1,
+    uint8_t* y0,
+    uint8_t* y1,
+    uint8_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    for (uint32_t x = begin; x < end; x += 2)
+    {
+        const uint8_t* p00 = bgra0 + (size_t)x * 4;
+        const uint8_t* p01 = p00 + 4;
+        const uint8_t* p10 = bgra1 + (size_t)x * 4;
+        const uint8_t* p11 = p10 + 4;
+
+        y0[x] = Clamp255((c.YB * p00[0] + c.YG * p00[1] + c.YR * p00[2] + c.YBias) >> YuvLumaShift);
+        y0[x + 1] = Clamp255((c.YB * p01[0] + c.YG * p01[1] + c.YR * p01[2] + c.YBias) >> YuvLumaShift);
+        y1[x] = Clamp255((c.YB * p10[0] + c.YG * p10[1] + c.YR * p10[2] + c.YBias) >> YuvLumaShift);
+        y1[x + 1] = Clamp255((c.YB * p11[0] + c.YG * p11[1] + c.YR * p11[2] + c.YBias) >> YuvLumaShift);
+
+        int32_t b = p00[0] + p01[0] + p10[0] + p11[0];
+        int32_t g = p00[1] + p01[1] + p10[1] + p11[1];
+        int32_t r = p00[2] + p01[2] + p10[2] + p11[2];
+
+        uv[x] = Clamp255((c.UB * b + c.UG * g + c.UR * r + c.ChromaBias) >> YuvChromaShift);
+        uv[x + 1] = Clamp255((c.VB * b + c.VG * g + c.VR * r + c.ChromaBias) >> YuvChromaShift);
+    }
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+// 两个16位系数打包为一个32位通道，供madd_epi16使用
+inline int32_t PackCoefficients(int16_t low, int16_t high)
+{
+    return (int32_t)((uint32_t)(uint16_t)low | ((uint32_t)(uint16_t)high << 16));
+}
+
+//
+// SIMD内核的公共思路（每32位通道一个BGRA像素）：
+//     and 0x00FF00FF   -> 16位通道(B, R)
+//     srli_epi16 8     -> 16位通道(G, A)
+//     madd(BR, (cb, cr)) + madd(GA, (cg, 0)) 得到每像素32位点积
+// 色度先两行相加，再把相邻像素的和移到偶数通道，U在偶数通道、V移入奇数通道，
+// 打包后正好是交错的UV字节。
+//
+
+// 各指令集的常量向量
+struct ConstantsSse41
+{
+    __m128i LowBytes;
+    __m128i YBR, YGA;
+    __m128i UBR, UGA;
+    __m128i VBR, VGA;
+    __m128i YBias;
+    __m128i ChromaBias;
+};
+
+EXPANDSCREEN_TARGET_SSE41
+inline ConstantsSse41 MakeConstantsSse41(const YuvCoefficients& c)
+{
+    ConstantsSse41 k;
+    k.LowBytes = _mm_set1_epi32(0x00FF00FF);
+    k.YBR = _mm_set1_epi32(PackCoefficients(c.YB, c.YR));
+    k.YGA = _mm_set1_epi32(PackCoefficients(c.YG, 0));
+    k.UBR = _mm_set1_epi32(PackCoefficients(c.UB, c.UR));
+    k.UGA = _mm_set1_epi32(PackCoefficients(c.UG, 0));
+    k.VBR = _mm_set1_epi32(PackCoefficients(c.VB, c.VR));
+    k.VGA = _mm_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm_set1_epi32(c.YBias);
+    k.ChromaBias = _mm_set1_epi32(c.ChromaBias);
+    return k;
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i LumaSse41(__m128i pixels, const ConstantsSse41& k)
+{
+    __m128i br = _mm_and_si128(pixels, k.LowBytes);
+    __m128i ga = _mm_srli_epi16(pixels, 8);
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(br, k.YBR), _mm_madd_epi16(ga, k.YGA));
+    return _mm_srai_epi32(_mm_add_epi32(sum, k.YBias), YuvLumaShift);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i ChromaSse41(__m128i row0, __m128i row1, const ConstantsSse41& k)
+{
+    __m128i br = _mm_add_epi16(_mm_and_si128(row0, k.LowBytes), _mm_and_si128(row1, k.LowBytes));
+    __m128i ga = _mm_add_epi16(_mm_srli_epi16(row0, 8), _mm_srli_epi16(row1, 8));
+    br = _mm_add_epi16(br, _mm_srli_epi64(br, 32));
+    ga = _mm_add_epi16(ga, _mm_srli_epi64(ga, 32));
+    __m128i u = _mm_add_epi32(_mm_madd_epi16(br, k.UBR), _mm_madd_epi16(ga, k.UGA));
+    __m128i v = _mm_add_epi32(_mm_madd_epi16(br, k.VBR), _mm_madd_epi16(ga, k.VGA));
+    __m128i both = _mm_blend_epi16(u, _mm_slli_epi64(v, 32), 0xCC);
+    return _mm_srai_epi32(_mm_add_epi32(both, k.ChromaBias), YuvChromaShift);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i PackSse41(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline void ConvertRowPairSse41(
+    const uint8_t* bgra0,
+    const uint8_t* bgra1,
+    uint8_t* y0,
+    uint8_t* y1,
+    uint8_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const ConstantsSse41 k = MakeConstantsSse41(c);
+
+    uint32_t x = begin;
+    for (; x + 16 <= end; x += 16)
+    {
+        const __m128i* src0 = reinterpret_cast<const __m128i*>(bgra0 + (size_t)x * 4);
+        const __m128i* src1 = reinterpret_cast<const __m128i*>(bgra1 + (size_t)x * 4);
+        __m128i a0 = _mm_loadu_si128(src0), a1 = _mm_loadu_si128(src0 + 1);
+        __m128i a2 = _mm_loadu_si128(src0 + 2), a3 = _mm_loadu_si128(src0 + 3);
+        __m128i b0 = _mm_loadu_si128(src1), b1 = _mm_loadu_si128(src1 + 1);
+        __m128i b2 = _mm_loadu_si128(src1 + 2), b3 = _mm_loadu_si128(src1 + 3);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x),
+            PackSse41(LumaSse41(a0, k), LumaSse41(a1, k), LumaSse41(a2, k), LumaSse41(a3, k)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x),
+            PackSse41(LumaSse41(b0, k), LumaSse41(b1, k), LumaSse41(b2, k), LumaSse41(b3, k)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x),
+            PackSse41(ChromaSse41(a0, b0, k), ChromaSse41(a1, b1, k),
+                ChromaSse41(a2, b2, k), ChromaSse41(a3, b3, k)));
+    }
+
+    ConvertRowPairScalar(bgra0, bgra1, y0, y1, uv, x, end, c);
+}
+
+struct ConstantsAvx2
+{
+    __m256i LowBytes;
+    __m256i YBR, YGA;
+    __m256i UBR, UGA;
+    __m256i VBR, VGA;
+    __m256i YBias;
+    __m256i ChromaBias;
+};
+
+EXPANDSCREEN_TARGET_AVX2
+inline ConstantsAvx2 MakeConstantsAvx2(const YuvCoefficients& c)
+{
+    ConstantsAvx2 k;
+    k.LowBytes = _mm256_set1_epi32(0x00FF00FF);
+    k.YBR = _mm256_set1_epi32(PackCoefficients(c.YB, c.YR));
+    k.YGA = _mm256_set1_epi32(PackCoefficients(c.YG, 0));
+    k.UBR = _mm256_set1_epi32(PackCoefficients(c.UB, c.UR));
+    k.UGA = _mm256_set1_epi32(PackCoefficients(c.UG, 0));
+    k.VBR = _mm256_set1_epi32(PackCoefficients(c.VB, c.VR));
+    k.VGA = _mm256_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm256_set1_epi32(c.YBias);
+    k.ChromaBias = _mm256_set1_epi32(c.ChromaBias);
+    return k;
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i LumaAvx2(__m256i pixels, const ConstantsAvx2& k)
+{
+    __m256i br = _mm256_and_si256(pixels, k.LowBytes);
+    __m256i ga = _mm256_srli_epi16(pixels, 8);
+    __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(br, k.YBR), _mm256_madd_epi16(ga, k.YGA));
+    return _mm256_srai_epi32(_mm256_add_epi32(sum, k.YBias), YuvLumaShift);
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i ChromaAvx2(__m256i row0, __m256i row1, const ConstantsAvx2& k)
+{
+    __m256i br = _mm256_add_epi16(_mm256_and_si256(row0, k.LowBytes), _mm256_and_si256(row1, k.LowBytes));
+    __m256i ga = _mm256_add_epi16(_mm256_srli_epi16(row0, 8), _mm256_srli_epi16(row1, 8));
+    br = _mm256_add_epi16(br, _mm256_srli_epi64(br, 32));
+    ga = _mm256_add_epi16(ga, _mm256_srli_epi64(ga, 32));
+    __m256i u = _mm256_add_epi32(_mm256_madd_epi16(br, k.UBR), _mm256_madd_epi16(ga, k.UGA));
+    __m256i v = _mm256_add_epi32(_mm256_madd_epi16(br, k.VBR), _mm256_madd_epi16(ga, k.VGA));
+    __m256i both = _mm256_blend_epi32(u, _mm256_slli_epi64(v, 32), 0xAA);
+    return _mm256_srai_epi32(_mm256_add_epi32(both, k.ChromaBias), YuvChromaShift);
+}
+
+// 打包指令按128位通道交错，最后按32位重排恢复像素顺序
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i PackAvx2(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+    __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+    return _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline void ConvertRowPairAvx2(
+    const uint8_t* bgra0,
+    const uint8_t* bgra1,
+    uint8_t* y0,
+    uint8_t* y1,
+    uint8_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const ConstantsAvx2 k = MakeConstantsAvx2(c);
+
+    uint32_t x = begin;
+    for (; x + 32 <= end; x += 32)
+    {
+        const __m256i* src0 = reinterpret_cast<const __m256i*>(bgra0 + (size_t)x * 4);
+        const __m256i* src1 = reinterpret_cast<const __m256i*>(bgra1 + (size_t)x * 4);
+        __m256i a0 = _mm256_loadu_si256(src0), a1 = _mm256_loadu_si256(src0 + 1);
+        __m256i a2 = _mm256_loadu_si256(src0 + 2), a3 = _mm256_loadu_si256(src0 + 3);
+        __m256i b0 = _mm256_loadu_si256(src1), b1 = _mm256_loadu_si256(src1 + 1);
+        __m256i b2 = _mm256_loadu_si256(src1 + 2), b3 = _mm256_loadu_si256(src1 + 3);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x),
+            PackAvx2(LumaAvx2(a0, k), LumaAvx2(a1, k), LumaAvx2(a2, k), LumaAvx2(a3, k)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x),
+            PackAvx2(LumaAvx2(b0, k), LumaAvx2(b1, k), LumaAvx2(b2, k), LumaAvx2(b3, k)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x),
+            PackAvx2(ChromaAvx2(a0, b0, k), ChromaAvx2(a1, b1, k),
+                ChromaAvx2(a2, b2, k), ChromaAvx2(a3, b3, k)));
+    }
+
+    ConvertRowPairScalar(bgra0, bgra1, y0, y1, uv, x, end, c);
+}
+
+EXPANDSCREEN_AVX512_BEGIN
+
+struct ConstantsAvx512
+{
+    __m512i LowBytes;
+    __m512i YBR, YGA;
+    __m512i UBR, UGA;
+    __m512i VBR, VGA;
+    __m512i YBias;
+    __m512i ChromaBias;
+};
+
+EXPANDSCREEN_TARGET_AVX512
+inline ConstantsAvx512 MakeConstantsAvx512(const YuvCoefficients& c)
+{
+    ConstantsAvx512 k;
+    k.LowBytes = _mm512_set1_epi32(0x00FF00FF);
+    k.YBR = _mm512_set1_epi32(PackCoefficients(c.YB, c.YR));
+    k.YGA = _mm512_set1_epi32(PackCoefficients(c.YG, 0));
+    k.UBR = _mm512_set1_epi32(PackCoefficients(c.UB, c.UR));
+    k.UGA = _mm512_set1_epi32(PackCoefficients(c.UG, 0));
+    k.VBR = _mm512_set1_epi32(PackCoefficients(c.VB, c.VR));
+    k.VGA = _mm512_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm512_set1_epi32(c.YBias);
+    k.ChromaBias = _mm512_set1_epi32(c.ChromaBias);
+    return k;
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i LumaAvx512(__m512i pixels, const ConstantsAvx512& k)
+{
+    __m512i br = _mm512_and_si512(pixels, k.LowBytes);
+    __m512i ga = _mm512_srli_epi16(pixels, 8);
+    __m512i sum = _mm512_add_epi32(_mm512_madd_epi16(br, k.YBR), _mm512_madd_epi16(ga, k.YGA));
+    return _mm512_srai_epi32(_mm512_add_epi32(sum, k.YBias), YuvLumaShift);
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i ChromaAvx512(__m512i row0, __m512i row1, const ConstantsAvx512& k)
+{
+    __m512i br = _mm512_add_epi16(_mm512_and_si512(row0, k.LowBytes), _mm512_and_si512(row1, k.LowBytes));
+    __m512i ga = _mm512_add_epi16(_mm512_srli_epi16(row0, 8), _mm512_srli_epi16(row1, 8));
+    br = _mm512_add_epi16(br, _mm512_srli_epi64(br, 32));
+    ga = _mm512_add_epi16(ga, _mm512_srli_epi64(ga, 32));
+    __m512i u = _mm512_add_epi32(_mm512_madd_epi16(br, k.UBR), _mm512_madd_epi16(ga, k.UGA));
+    __m512i v = _mm512_add_epi32(_mm512_madd_epi16(br, k.VBR), _mm512_madd_epi16(ga, k.VGA));
+    __m512i both = _mm512_mask_blend_epi32(0xAAAA, u, _mm512_slli_epi64(v, 32));
+    return _mm512_srai_epi32(_mm512_add_epi32(both, k.ChromaBias), YuvChromaShift);
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i PackAvx512(__m512i a, __m512i b, __m512i c, __m512i d)
+{
+    __m512i bytes = _mm512_packus_epi16(_mm512_packs_epi32(a, b), _mm512_packs_epi32(c, d));
+    return _mm512_permutexvar_epi32(
+        _mm512_setr_epi32(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15), bytes);
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline void ConvertRowPairAvx512(
+    const uint8_t* bgra0,
+    const uint8_t* bgra1,
+    uint8_t* y0,
+    uint8_t* y1,
+    uint8_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const ConstantsAvx512 k = MakeConstantsAvx512(c);
+
+    uint32_t x = begin;
+    for (; x + 64 <= end; x += 64)
+    {
+        const uint8_t* src0 = bgra0 + (size_t)x * 4;
+        const uint8_t* src1 = bgra1 + (size_t)x * 4;
+        __m512i a0 = _mm512_loadu_si512(src0), a1 = _mm512_loadu_si512(src0 + 64);
+        __m512i a2 = _mm512_loadu_si512(src0 + 128), a3 = _mm512_loadu_si512(src0 + 192);
+        __m512i b0 = _mm512_loadu_si512(src1), b1 = _mm512_loadu_si512(src1 + 64);
+        __m512i b2 = _mm512_loadu_si512(src1 + 128), b3 = _mm512_loadu_si512(src1 + 192);
+
+        _mm512_storeu_si512(y0 + x,
+            PackAvx512(LumaAvx512(a0, k), LumaAvx512(a1, k), LumaAvx512(a2, k), LumaAvx512(a3, k)));
+        _mm512_storeu_si512(y1 + x,
+            PackAvx512(LumaAvx512(b0, k), LumaAvx512(b1, k), LumaAvx512(b2, k), LumaAvx512(b3, k)));
+        _mm512_storeu_si512(uv + x,
+            PackAvx512(ChromaAvx512(a0, b0, k), ChromaAvx512(a1, b1, k),
+                ChromaAvx512(a2, b2, k), ChromaAvx512(a3, b3, k)));
+    }
+
+    // 剩余部分交给AVX2内核（其尾部再交给标量）
+    ConvertRowPairAvx2(bgra0, bgra1, y0, y1, uv, x, end, c);
+}
+
+EXPANDSCREEN_AVX512_END
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+} // namespace ColorDetail
+
+using Nv12RowPairKernel = void (*)(
+    const uint8_t* bgra0,
+    const uint8_t* bgra1,
+    uint8_t* y0,
+    uint8_t* y1,
+    uint8_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& coefficients);
+
+inline Nv12RowPairKernel SelectNv12Kernel(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return ColorDetail::ConvertRowPairAvx512;
+    case CpuLevel::Avx2: return ColorDetail::ConvertRowPairAvx2;
+    case CpuLevel::Sse41: return ColorDetail::ConvertRowPairSse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return ColorDetail::ConvertRowPairScalar;
+}
+
+//
+// BGRA8 -> NV12转换器，内核在构造时按CPU特性选定
+//
+class Nv12Converter
+{
+public:
+    explicit Nv12Converter(
+        YuvMatrix matrix = YuvMatrix::Bt709,
+        YuvRange range = YuvRange::Limited,
+        CpuLevel level = DetectCpuLevel())
+        : m_Matrix(matrix),
+          m_Range(range),
+          m_Level(ClampCpuLevel(level)),
+          m_Coefficients(MakeYuvCoefficients(matrix, range)),
+          m_Kernel(SelectNv12Kernel(level))
+    {
+    }
+
+    YuvMatrix Matrix() const
+    {
+        return m_Matrix;
+    }
+
+    YuvRange Range() const
+    {
+        return m_Range;
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    //
+    // 转换rect覆盖的区域（先按色度对齐）。width/height为帧尺寸，需为偶数
+    //
+    void Convert(
+        const uint8_t* bgra,
+        size_t bgraPitch,
+        int32_t width,
+        int32_t height,
+        const Nv12Surface& target,
+        const FrameRect& rect) const
+    {
+        FrameRect aligned = AlignToChroma(rect, width, height);
+        if (aligned.IsEmpty())
+        {
+            return;
+        }
+
+        for (int32_t y = aligned.Top; y < aligned.Bottom; y += 2)
+        {
+            const uint8_t* row0 = bgra + (size_t)y * bgraPitch;
+            m_Kernel(
+                row0,
+                row0 + bgraPitch,
+                target.Y + (size_t)y * target.YPitch,
+                target.Y + (size_t)(y + 1) * target.YPitch,
+                target.UV + (size_t)(y / 2) * target.UVPitch,
+                (uint32_t)aligned.Left,
+                (uint32_t)aligned.Right,
+                m_Coefficients);
+        }
+    }
+
+    void ConvertFrame(
+        const uint8_t* bgra,
+        size_t bgraPitch,
+        int32_t width,
+        int32_t height,
+        const Nv12Surface& target) const
+    {
+        Convert(bgra, bgraPitch, width, height, target, { 0, 0, width, height });
+    }
+
+private:
+    YuvMatrix m_Matrix;
+    YuvRange m_Range;
+    CpuLevel m_Level;
+    YuvCoefficients m_Coefficients;
+    Nv12RowPairKernel m_Kernel;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
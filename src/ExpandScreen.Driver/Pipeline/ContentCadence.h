@@ -0,0 +1,295 @@
+/*++
+
+Module Name:
+    ContentCadence.h
+
+Abstract:
+    内容节奏检测：刷新率高于内容帧率时（120Hz模式下只有24/30fps的影片在播放），
+    DWM仍按刷新率提交，多数提交内容未变，每次都映射暂存纹理、比较后丢弃。
+
+    按已发布帧中内容确实变化的帧（未变化的帧被FrameDiff丢弃）的提交时间测量内容
+    间隔，最近ContentCadenceConfig::MinFrames个间隔都不短于MinPeriods个刷新周期且
+    波动不超过TolerancePercent时进入降频：此后落在内容区域（这些帧损伤的并集）之内、
+    早于下一个内容帧预期时间的提交只挂起（损伤照常合并），到预期时间窗口内的提交
+    才按正常定速发布，发布率降到内容帧率，内容帧本身不增加延迟。挂起的提交最晚在
+    预期窗口结束时发布。
+
+    内容区域之外的损伤、光标输入、内容帧提前或间隔波动都立即退出降频，之后的提交
+    回到按刷新率发布；重新进入需要重新积累MinFrames个间隔，输入之后还要等待
+    InputHoldoffPeriods个刷新周期。
+
+    所有时间都由调用者以QPC计数传入，本模块不读取时钟。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 节奏检测配置，每个监视器一份
+//
+struct ContentCadenceConfig
+{
+    uint32_t MinFrames = 8;             // 进入降频所需的连续内容帧间隔数（不超过ContentCadenceMaxFrames）
+    uint32_t MinPeriods = 2;            // 内容帧间隔至少为此数个刷新周期才降频
+    uint32_t TolerancePercent = 75;     // 间隔最大值与最小值之差的上限（占刷新周期的百分比），24fps在60Hz上交替2、3个周期
+    uint32_t InputHoldoffPeriods = 60;  // 输入后此数个刷新周期内不进入降频
+};
+
+constexpr uint32_t ContentCadenceMaxFrames = 32;
+
+enum class CadenceExitReason : uint32_t
+{
+    Input,          // 光标输入
+    Damage,         // 内容区域之外的损伤
+    Irregular,      // 内容帧间隔不再稳定（提前、暂停、帧率变化）
+    Count
+};
+
+struct ContentCadenceStats
+{
+    uint64_t Activations = 0;           // 进入降频的次数
+    uint64_t HeldPresents = 0;          // 降频期间挂起的提交数
+    uint64_t Exits[(uint32_t)CadenceExitReason::Count] = {};
+};
+
+class ContentCadenceDetector
+{
+public:
+    //
+    // period为刷新周期（计数）；为0（不定速）时不检测
+    //
+    void Configure(const ContentCadenceConfig& config, int64_t period)
+    {
+        m_Config = config;
+        if (m_Config.MinFrames < 2)
+        {
+            m_Config.MinFrames = 2;
+        }
+        if (m_Config.MinFrames > ContentCadenceMaxFrames)
+        {
+            m_Config.MinFrames = ContentCadenceMaxFrames;
+        }
+        if (m_Config.MinPeriods < 2)
+        {
+            m_Config.MinPeriods = 2;
+        }
+        m_Period = period > 0 ? period : 0;
+        m_HasInput = false;
+        Reset();
+    }
+
+    const ContentCadenceConfig& Config() const
+    {
+        return m_Config;
+    }
+
+    //
+    // 丢弃已测量的间隔并退出降频，例如交换链重新分配之后
+    //
+    void Reset()
+    {
+        m_Active = false;
+        m_HasLast = false;
+        m_Count = 0;
+        m_Next = 0;
+    }
+
+    bool Active() const
+    {
+        return m_Active;
+    }
+
+    //
+    // 降频期间的平均内容间隔（计数），否则为0
+    //
+    int64_t ContentInterval() const
+    {
+        return m_Active ? m_MeanInterval : 0;
+    }
+
+    //
+    // 降频期间的内容区域（已测量内容帧损伤的并集）
+    //
+    const FrameRect& ContentBounds() const
+    {
+        return m_Bounds;
+    }
+
+    const ContentCadenceStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    void ResetStats()
+    {
+        m_Stats = ContentCadenceStats();
+    }
+
+    //
+    // 光标输入（time为输入时间）：立即退出降频，此后一段时间内不再进入
+    //
+    void OnInput(int64_t time)
+    {
+        if (m_HasInput && time <= m_LastInput)
+        {
+            return;
+        }
+
+        m_HasInput = true;
+        m_LastInput = time;
+        if (m_Active)
+        {
+            Exit(CadenceExitReason::Input);
+        }
+    }
+
+    //
+    // 收到一次提交，damage为其损伤的包围矩形（整帧变化时为整帧）。
+    // 返回提交应挂起到的时间，0表示不挂起
+    //
+    int64_t OnPresent(int64_t presentTime, const FrameRect& damage)
+    {
+        if (!m_Active)
+        {
+            return 0;
+        }
+
+        if (!Contains(m_Bounds, damage))
+        {
+            Exit(CadenceExitReason::Damage);
+            return 0;
+        }
+
+        // 预期窗口：最短间隔之前半个周期起可能是下一个内容帧
+        if (presentTime < m_LastContent + m_MinInterval - m_Period / 2)
+        {
+            m_Stats.HeldPresents++;
+            return m_LastContent + m_MaxInterval + m_Period / 2;
+        }
+        return 0;
+    }
+
+    //
+    // 发布了内容确实变化的一帧（内容未变化而被丢弃的帧不调用）：presentTime为其最新
+    // 一次提交的时间，damage为合并的上报损伤的包围矩形
+    //
+    void OnContentFrame(int64_t presentTime, const FrameRect& damage)
+    {
+        if (m_Period == 0)
+        {
+            return;
+        }
+
+        if (m_HasLast)
+        {
+            m_Intervals[m_Next] = presentTime - m_LastContent;
+            m_Damage[m_Next] = damage;
+            m_Next = (m_Next + 1) % m_Config.MinFrames;
+            m_Count = m_Count < m_Config.MinFrames ? m_Count + 1 : m_Config.MinFrames;
+        }
+        m_HasLast = true;
+        m_LastContent = presentTime;
+
+        const bool steady = Measure(presentTime);
+        if (m_Active && !steady)
+        {
+            Exit(CadenceExitReason::Irregular);
+        }
+        else if (!m_Active && steady)
+        {
+            m_Active = true;
+            m_Stats.Activations++;
+        }
+    }
+
+private:
+    static bool Contains(const FrameRect& outer, const FrameRect& inner)
+    {
+        return inner.IsEmpty() ||
+            (inner.Left >= outer.Left && inner.Top >= outer.Top &&
+             inner.Right <= outer.Right && inner.Bottom <= outer.Bottom);
+    }
+
+    //
+    // 最近MinFrames个间隔是否稳定且足够慢，顺带计算间隔范围与内容区域
+    //
+    bool Measure(int64_t now)
+    {
+        if (m_Count < m_Config.MinFrames)
+        {
+            return false;
+        }
+        if (m_HasInput && now - m_LastInput < m_Period * (int64_t)m_Config.InputHoldoffPeriods)
+        {
+            return false;
+        }
+
+        int64_t minimum = m_Intervals[0], maximum = m_Intervals[0], total = 0;
+        FrameRect bounds = m_Damage[0];
+        for (uint32_t i = 0; i < m_Count; i++)
+        {
+            minimum = m_Intervals[i] < minimum ? m_Intervals[i] : minimum;
+            maximum = m_Intervals[i] > maximum ? m_Intervals[i] : maximum;
+            total += m_Intervals[i];
+            bounds = UnionRect(bounds, m_Damage[i]);
+        }
+
+        if (minimum < m_Period * (int64_t)m_Config.MinPeriods ||
+            (maximum - minimum) * 100 > m_Period * (int64_t)m_Config.TolerancePercent)
+        {
+            return false;
+        }
+
+        m_MinInterval = minimum;
+        m_MaxInterval = maximum;
+        m_MeanInterval = total / m_Count;
+        m_Bounds = bounds;
+        return true;
+    }
+
+    //
+    // 退出降频并丢弃已测量的间隔，退出时刻的帧重新作为起点
+    //
+    void Exit(CadenceExitReason reason)
+    {
+        m_Stats.Exits[(uint32_t)reason]++;
+        m_Active = false;
+        m_HasLast = false;
+        m_Count = 0;
+        m_Next = 0;
+    }
+
+    ContentCadenceConfig m_Config;
+    int64_t m_Period = 0;
+
+    bool m_Active = false;
+    bool m_HasLast = false;
+    int64_t m_LastContent = 0;
+    int64_t m_Intervals[ContentCadenceMaxFrames] = {};
+    FrameRect m_Damage[ContentCadenceMaxFrames] = {};
+    uint32_t m_Count = 0;
+    uint32_t m_Next = 0;
+
+    int64_t m_MinInterval = 0;
+    int64_t m_MaxInterval = 0;
+    int64_t m_MeanInterval = 0;
+    FrameRect m_Bounds = {};
+
+    bool m_HasInput = false;
+    int64_t m_LastInput = 0;
+
+    ContentCadenceStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
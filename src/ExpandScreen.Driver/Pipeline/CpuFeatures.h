@@ -0,0 +1,185 @@
+/*++
+
+Module Name:
+    CpuFeatures.h
+
+Abstract:
+    运行时CPU特性检测与SIMD内核分派
+
+    各SIMD内核用EXPANDSCREEN_TARGET_*标注目标指令集，整个工程不需要
+    全局开启/arch或-m选项；运行时按DetectCpuLevel()选择可用的最高级别内核。
+    AVX2/AVX-512还要求操作系统通过XSAVE保存对应寄存器状态。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define EXPANDSCREEN_PIPELINE_X86 1
+#else
+#define EXPANDSCREEN_PIPELINE_X86 0
+#endif
+
+#if EXPANDSCREEN_PIPELINE_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#if EXPANDSCREEN_PIPELINE_X86 && !defined(_MSC_VER)
+#define EXPANDSCREEN_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define EXPANDSCREEN_TARGET_AVX2 __attribute__((target("avx2,bmi2")))
+#define EXPANDSCREEN_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi2")))
+#else
+#define EXPANDSCREEN_TARGET_SSE41
+#define EXPANDSCREEN_TARGET_AVX2
+#define EXPANDSCREEN_TARGET_AVX512
+#endif
+
+// GCC 12的AVX-512头文件内部使用_mm512_undefined_*，会误报-Wmaybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#define EXPANDSCREEN_AVX512_BEGIN \
+    _Pragma("GCC diagnostic push") \
+    _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define EXPANDSCREEN_AVX512_END _Pragma("GCC diagnostic pop")
+#else
+#define EXPANDSCREEN_AVX512_BEGIN
+#define EXPANDSCREEN_AVX512_END
+#endif
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// SIMD级别，高级别包含低级别
+//
+enum class CpuLevel : uint32_t
+{
+    Scalar = 0,
+    Sse41 = 1,
+    Avx2 = 2,
+    Avx512 = 3      // AVX-512 F + BW + VL
+};
+
+inline const char* CpuLevelName(CpuLevel level)
+{
+    switch (level)
+    {
+    case CpuLevel::Sse41: return "sse4.1";
+    case CpuLevel::Avx2: return "avx2";
+    case CpuLevel::Avx512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+namespace Detail {
+
+#if EXPANDSCREEN_PIPELINE_X86
+inline void CpuId(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++)
+    {
+        regs[i] = (uint32_t)info[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t ReadXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+inline CpuLevel QueryCpuLevel()
+{
+    uint32_t regs[4];
+    CpuId(0, 0, regs);
+    uint32_t maxLeaf = regs[0];
+
+    CpuId(1, 0, regs);
+    const bool sse41 = (regs[2] & (1u << 19)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+
+    if (!sse41)
+    {
+        return CpuLevel::Scalar;
+    }
+
+    if (!osxsave || !avx || maxLeaf < 7)
+    {
+        return CpuLevel::Sse41;
+    }
+
+    // XMM/YMM状态（位1、2），AVX-512另需opmask/ZMM状态（位5~7）
+    uint64_t xcr0 = ReadXcr0();
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return CpuLevel::Sse41;
+    }
+
+    CpuId(7, 0, regs);
+    const bool avx2 = (regs[1] & (1u << 5)) != 0;
+    const bool bmi2 = (regs[1] & (1u << 8)) != 0;
+    const bool avx512f = (regs[1] & (1u << 16)) != 0;
+    const bool avx512bw = (regs[1] & (1u << 30)) != 0;
+    const bool avx512vl = (regs[1] & (1u << 31)) != 0;
+
+    if (!avx2 || !bmi2)
+    {
+        return CpuLevel::Sse41;
+    }
+
+    if (avx512f && avx512bw && avx512vl && (xcr0 & 0xE6) == 0xE6)
+    {
+        return CpuLevel::Avx512;
+    }
+
+    return CpuLevel::Avx2;
+}
+#endif
+
+} // namespace Detail
+
+//
+// 本机支持的最高SIMD级别（首次调用时检测并缓存）
+//
+inline CpuLevel DetectCpuLevel()
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    static const CpuLevel level = Detail::QueryCpuLevel();
+    return level;
+#else
+    return CpuLevel::Scalar;
+#endif
+}
+
+//
+// 把请求的级别限制在本机支持范围内，用于测试和基准强制选择内核
+//
+inline CpuLevel ClampCpuLevel(CpuLevel requested)
+{
+    CpuLevel supported = DetectCpuLevel();
+    return (uint32_t)requested < (uint32_t)supported ? requested : supported;
+}
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,502 @@
+/*++
+
+Module Name:
+    CursorChannel.h
+
+Abstract:
+    硬件光标的共享内存通道，与帧环分离
+
+    使用硬件光标后DWM不再把光标合成进桌面图像，只移动指针不会产生新帧。
+    驱动把光标位置、可见性与形状通过本通道单独发布，消费者在本地叠加光标。
+
+    布局（偏移均按页对齐）：
+        [CursorChannelHeader][事件槽位 x EventCapacity]
+        [CursorShapeHeader][形状像素] x ShapeSlotCount
+
+    事件队列：生产者按序号写入环形槽位，每个槽位用seqlock保护。每个事件都携带
+    完整的光标状态（位置、可见性、形状ID）与本次变化的标志，消费者落后超过一圈时
+    只需取最新事件即可恢复，丢失的只是中间位置。
+    形状：ShapeSlotCount个seqlock保护的形状槽位，与驱动侧CursorShapeCache的条目一一对应。
+    事件中的ShapeId是按内容分配的缓存ID，ShapeSlot指明形状所在槽位；热点随事件发布，
+    同一位图换热点不占新槽位。消费者只在见到新ShapeId时读取槽位，之后只需ID与热点。
+    与帧环一样，消费者只读映射，从不写共享内存。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameRing.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+constexpr uint32_t CursorChannelMagic = 0x43435345;     // 'ESCC'
+constexpr uint32_t CursorChannelVersion = 2;
+constexpr uint32_t CursorEventCapacity = 256;           // 必须为2的幂
+constexpr uint32_t CursorMaxShapeSize = 256;            // 形状最大宽高（像素）
+constexpr uint64_t CursorMaxShapeBytes = (uint64_t)CursorMaxShapeSize * CursorMaxShapeSize * 4;
+constexpr uint32_t CursorShapeSlotCount = 16;           // 同时驻留的形状数，即形状缓存容量上限
+
+static_assert((CursorEventCapacity & (CursorEventCapacity - 1)) == 0, "事件容量必须为2的幂");
+
+//
+// 形状类型，取值与IDDCX_CURSOR_SHAPE_TYPE一致
+//
+enum class CursorShapeType : uint32_t
+{
+    Unknown = 0,
+    MaskedColor = 1,    // 32位颜色，alpha为0xFF时按XOR与屏幕合成，为0时直接替换
+    Alpha = 2           // 32位预乘alpha
+};
+
+//
+// CursorEvent::Flags
+//
+constexpr uint32_t CursorEventPosition = 0x1;
+constexpr uint32_t CursorEventVisibility = 0x2;
+constexpr uint32_t CursorEventShape = 0x4;
+
+//
+// 光标事件，携带完整状态
+//
+struct CursorEvent
+{
+    uint32_t Flags;             // 相对上一个事件变化的部分（CursorEvent*）
+    uint32_t ShapeId;           // 当前形状的缓存ID，0表示尚无形状
+    uint32_t ShapeSlot;         // 当前形状所在槽位
+    uint32_t Visible;
+    int32_t X;                  // 光标图像左上角，监视器桌面坐标
+    int32_t Y;
+    int32_t XHot;               // 当前形状的热点
+    int32_t YHot;
+    int64_t Time;               // 驱动取得光标数据的时间（QPC）
+};
+
+//
+// 形状位图描述，不含热点（热点随事件发布）
+//
+struct CursorShapeInfo
+{
+    uint32_t ShapeId;
+    CursorShapeType Type;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Pitch;
+    uint32_t Reserved;
+};
+
+//
+// 事件引用的形状：缓存ID、槽位与热点
+//
+struct CursorShapeRef
+{
+    uint32_t ShapeId;
+    uint32_t Slot;
+    int32_t XHot;
+    int32_t YHot;
+};
+
+struct CursorChannelHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t EventCapacity;
+    uint32_t MaxShapeSize;
+    uint64_t ShapeOffset;
+    uint64_t MaxShapeBytes;
+    uint32_t ShapeSlotCount;
+    uint32_t Reserved;
+
+    alignas(64) std::atomic<uint64_t> LatestEvent;  // 最新已发布事件序号，0表示尚无事件
+};
+
+struct CursorEventSlot
+{
+    alignas(64) std::atomic<uint64_t> Sequence;     // 事件n写入中为2n-1，写完为2n
+    CursorEvent Event;
+};
+
+struct CursorShapeHeader
+{
+    alignas(64) std::atomic<uint64_t> Sequence;     // 偶数=稳定，奇数=写入中
+    CursorShapeInfo Info;
+};
+
+struct CursorChannelLayout
+{
+    static uint64_t HeaderSize()
+    {
+        return AlignToPage(sizeof(CursorChannelHeader));
+    }
+
+    static uint64_t ShapeOffset()
+    {
+        return HeaderSize() + AlignToPage((uint64_t)CursorEventCapacity * sizeof(CursorEventSlot));
+    }
+
+    static uint64_t ShapeSlotStride()
+    {
+        return AlignToPage(sizeof(CursorShapeHeader)) + AlignToPage(CursorMaxShapeBytes);
+    }
+
+    static uint64_t RequiredSize()
+    {
+        return ShapeOffset() + (uint64_t)CursorShapeSlotCount * ShapeSlotStride();
+    }
+};
+
+namespace Detail {
+
+inline bool ValidateCursorChannel(const void* memory, uint64_t size)
+{
+    if (memory == nullptr || size < CursorChannelLayout::RequiredSize())
+    {
+        return false;
+    }
+
+    const CursorChannelHeader* header = static_cast<const CursorChannelHeader*>(memory);
+
+    return header->Magic == CursorChannelMagic &&
+        header->Version == CursorChannelVersion &&
+        header->EventCapacity == CursorEventCapacity &&
+        header->MaxShapeSize == CursorMaxShapeSize &&
+        header->ShapeSlotCount == CursorShapeSlotCount &&
+        header->ShapeOffset == CursorChannelLayout::ShapeOffset();
+}
+
+} // namespace Detail
+
+//
+// 把驱动查询到的光标状态变成事件：只有状态变化时才产生事件
+//
+class CursorStateTracker
+{
+public:
+    //
+    // shape不为空时本次带来了形状（缓存ID、槽位与热点）。返回false表示无变化
+    //
+    bool Update(bool visible, int32_t x, int32_t y, const CursorShapeRef* shape, int64_t time, CursorEvent& event)
+    {
+        uint32_t flags = 0;
+
+        if (!m_HasState || (uint32_t)visible != m_State.Visible)
+        {
+            flags |= CursorEventVisibility;
+        }
+
+        if (!m_HasState || x != m_State.X || y != m_State.Y)
+        {
+            flags |= CursorEventPosition;
+        }
+
+        if (shape != nullptr &&
+            (!m_HasState || shape->ShapeId != m_State.ShapeId || shape->Slot != m_State.ShapeSlot ||
+             shape->XHot != m_State.XHot || shape->YHot != m_State.YHot))
+        {
+            flags |= CursorEventShape;
+            m_State.ShapeId = shape->ShapeId;
+            m_State.ShapeSlot = shape->Slot;
+            m_State.XHot = shape->XHot;
+            m_State.YHot = shape->YHot;
+        }
+
+        if (flags == 0)
+        {
+            m_Suppressed++;
+            return false;
+        }
+
+        m_HasState = true;
+        m_State.Flags = flags;
+        m_State.X = x;
+        m_State.Y = y;
+        m_State.Visible = visible ? 1 : 0;
+        m_State.Time = time;
+
+        event = m_State;
+        return true;
+    }
+
+    //
+    // 丢弃已知状态，下一次查询无论是否变化都产生完整事件（例如交换链重新分配之后）
+    //
+    void Reset()
+    {
+        m_HasState = false;
+        m_State = CursorEvent();
+    }
+
+    uint32_t ShapeId() const
+    {
+        return m_State.ShapeId;
+    }
+
+    uint64_t Suppressed() const
+    {
+        return m_Suppressed;
+    }
+
+private:
+    bool m_HasState = false;
+    CursorEvent m_State = {};
+    uint64_t m_Suppressed = 0;
+};
+
+//
+// 生产者（驱动侧），单线程
+//
+class CursorChannelProducer
+{
+public:
+    static bool Format(void* memory, uint64_t size)
+    {
+        if (memory == nullptr || size < CursorChannelLayout::RequiredSize())
+        {
+            return false;
+        }
+
+        std::memset(memory, 0, (size_t)CursorChannelLayout::ShapeOffset());
+        for (uint32_t slot = 0; slot < CursorShapeSlotCount; slot++)
+        {
+            std::memset(static_cast<uint8_t*>(memory) + CursorChannelLayout::ShapeOffset() + slot * CursorChannelLayout::ShapeSlotStride(),
+                0, sizeof(CursorShapeHeader));
+        }
+
+        CursorChannelHeader* header = static_cast<CursorChannelHeader*>(memory);
+        header->Version = CursorChannelVersion;
+        header->EventCapacity = CursorEventCapacity;
+        header->MaxShapeSize = CursorMaxShapeSize;
+        header->ShapeOffset = CursorChannelLayout::ShapeOffset();
+        header->MaxShapeBytes = CursorMaxShapeBytes;
+        header->ShapeSlotCount = CursorShapeSlotCount;
+        header->LatestEvent.store(0, std::memory_order_relaxed);
+
+        // Magic最后写入，消费者据此判断通道已就绪
+        std::atomic_thread_fence(std::memory_order_release);
+        header->Magic = CursorChannelMagic;
+        return true;
+    }
+
+    bool Attach(void* memory, uint64_t size)
+    {
+        if (!Detail::ValidateCursorChannel(memory, size))
+        {
+            m_Header = nullptr;
+            return false;
+        }
+
+        m_Header = static_cast<CursorChannelHeader*>(memory);
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Header != nullptr;
+    }
+
+    //
+    // 把形状写入槽位。像素按info.Pitch排列，超过最大尺寸或槽位无效时返回false
+    //
+    bool PublishShape(uint32_t slot, const CursorShapeInfo& info, const uint8_t* pixels)
+    {
+        const uint64_t bytes = (uint64_t)info.Pitch * info.Height;
+        if (slot >= CursorShapeSlotCount ||
+            info.Width > CursorMaxShapeSize || info.Height > CursorMaxShapeSize ||
+            info.Pitch < info.Width * 4 || bytes > CursorMaxShapeBytes)
+        {
+            return false;
+        }
+
+        CursorShapeHeader* shape = Shape(slot);
+        uint64_t sequence = shape->Sequence.load(std::memory_order_relaxed);
+        shape->Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        shape->Info = info;
+        std::memcpy(reinterpret_cast<uint8_t*>(shape) + AlignToPage(sizeof(CursorShapeHeader)), pixels, (size_t)bytes);
+
+        shape->Sequence.store(sequence + 2, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // 发布事件，返回事件序号
+    //
+    uint64_t PublishEvent(const CursorEvent& event)
+    {
+        uint64_t number = m_Header->LatestEvent.load(std::memory_order_relaxed) + 1;
+        CursorEventSlot* slot = SlotAt(number);
+
+        slot->Sequence.store(number * 2 - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->Event = event;
+
+        slot->Sequence.store(number * 2, std::memory_order_release);
+        m_Header->LatestEvent.store(number, std::memory_order_release);
+        return number;
+    }
+
+private:
+    CursorEventSlot* SlotAt(uint64_t number) const
+    {
+        uint8_t* events = reinterpret_cast<uint8_t*>(m_Header) + CursorChannelLayout::HeaderSize();
+        return reinterpret_cast<CursorEventSlot*>(events) + ((number - 1) & (CursorEventCapacity - 1));
+    }
+
+    CursorShapeHeader* Shape(uint32_t slot) const
+    {
+        return reinterpret_cast<CursorShapeHeader*>(reinterpret_cast<uint8_t*>(m_Header) + m_Header->ShapeOffset +
+            slot * CursorChannelLayout::ShapeSlotStride());
+    }
+
+    CursorChannelHeader* m_Header = nullptr;
+};
+
+//
+// 消费者（用户态），只需要只读映射
+//
+class CursorChannelConsumer
+{
+public:
+    bool Attach(const void* memory, uint64_t size)
+    {
+        if (!Detail::ValidateCursorChannel(memory, size))
+        {
+            m_Header = nullptr;
+            return false;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_Header = static_cast<const CursorChannelHeader*>(memory);
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Header != nullptr;
+    }
+
+    uint64_t LastEvent() const
+    {
+        return m_LastEvent;
+    }
+
+    //
+    // 取出上次之后的事件，最多capacity个。落后超过一圈（或读取时槽位被覆盖）时跳到
+    // 最新事件，跳过的事件计入LostEvents；每个事件都带完整状态，最新事件即可恢复
+    //
+    uint32_t Poll(CursorEvent* events, uint32_t capacity)
+    {
+        uint32_t count = 0;
+
+        while (count < capacity)
+        {
+            uint64_t latest = m_Header->LatestEvent.load(std::memory_order_acquire);
+            if (latest == m_LastEvent)
+            {
+                break;
+            }
+
+            uint64_t number = m_LastEvent + 1;
+            if (latest - m_LastEvent > CursorEventCapacity)
+            {
+                number = latest;
+            }
+
+            if (ReadEvent(number, events[count]))
+            {
+                m_LostEvents += number - m_LastEvent - 1;
+                m_LastEvent = number;
+                count++;
+                continue;
+            }
+
+            // 读取期间被生产者追上，重新从最新事件开始
+            if (!ReadEvent(latest, events[count]))
+            {
+                break;
+            }
+
+            m_LostEvents += latest - m_LastEvent - 1;
+            m_LastEvent = latest;
+            count++;
+        }
+
+        return count;
+    }
+
+    //
+    // 读取槽位中的形状，调用者应检查info.ShapeId与事件一致。pixels容量至少
+    // CursorMaxShapeBytes；槽位为空或正在更新时返回false，稍后重试
+    //
+    bool ReadShape(uint32_t slot, CursorShapeInfo& info, uint8_t* pixels) const
+    {
+        if (slot >= CursorShapeSlotCount)
+        {
+            return false;
+        }
+
+        const CursorShapeHeader* shape = Shape(slot);
+        uint64_t sequence = shape->Sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0 || sequence == 0)
+        {
+            return false;
+        }
+
+        info = shape->Info;
+        const uint64_t bytes = (uint64_t)info.Pitch * info.Height;
+        if (bytes > CursorMaxShapeBytes)
+        {
+            return false;
+        }
+
+        std::memcpy(pixels, reinterpret_cast<const uint8_t*>(shape) + AlignToPage(sizeof(CursorShapeHeader)), (size_t)bytes);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return shape->Sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    uint64_t LostEvents() const
+    {
+        return m_LostEvents;
+    }
+
+private:
+    bool ReadEvent(uint64_t number, CursorEvent& event) const
+    {
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(m_Header) + CursorChannelLayout::HeaderSize();
+        const CursorEventSlot* slot = reinterpret_cast<const CursorEventSlot*>(base) + ((number - 1) & (CursorEventCapacity - 1));
+
+        if (slot->Sequence.load(std::memory_order_acquire) != number * 2)
+        {
+            return false;
+        }
+
+        event = slot->Event;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot->Sequence.load(std::memory_order_relaxed) == number * 2;
+    }
+
+    const CursorShapeHeader* Shape(uint32_t slot) const
+    {
+        return reinterpret_cast<const CursorShapeHeader*>(reinterpret_cast<const uint8_t*>(m_Header) + m_Header->ShapeOffset +
+            slot * CursorChannelLayout::ShapeSlotStride());
+    }
+
+    const CursorChannelHeader* m_Header = nullptr;
+    uint64_t m_LastEvent = 0;
+    uint64_t m_LostEvents = 0;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,217 @@
+/*++
+
+Module Name:
+    CursorShapeCache.h
+
+Abstract:
+    按内容寻址的光标形状缓存
+
+    文本编辑器、绘图工具等会在少数几个光标之间每秒切换多次，IddCx每次都上报为
+    新形状。驱动对每个新形状按类型、尺寸与像素（不含行尾填充与热点）计算哈希，
+    内容相同的形状得到同一个缓存ID：首次出现时把完整位图写入形状槽位，之后只
+    发布缓存ID与热点。
+
+    缓存ID从1开始单调分配，内容被淘汰后再次出现时分配新ID，因此消费者可以把
+    ID当作内容的永久名字（例如转发给远端时只在远端没见过该ID时才发送位图）。
+    条目数有上限，满时按LRU淘汰，被淘汰条目的槽位由新形状复用；当前形状总是
+    最近使用的，不会被淘汰。哈希相同时再逐字节比较，命中结果是精确的。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CursorChannel.h"
+#include "TileHash.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 单次查找结果
+//
+struct CursorShapeLookup
+{
+    uint32_t ShapeId;           // 缓存ID
+    uint32_t Slot;              // 形状所在槽位
+    bool Hit;                   // true时槽位中已有该形状，无需重新发布
+    uint32_t EvictedShapeId;    // 未命中且淘汰了旧条目时为旧条目ID，否则为0
+};
+
+struct CursorShapeCacheStats
+{
+    uint64_t Lookups = 0;
+    uint64_t Hits = 0;
+    uint64_t Evictions = 0;
+    uint64_t HashedBytes = 0;
+    uint64_t UploadedBytes = 0;     // 未命中时需要发布的位图字节数
+    uint64_t SavedBytes = 0;        // 命中省下的位图字节数
+};
+
+class CursorShapeCache
+{
+public:
+    explicit CursorShapeCache(uint32_t capacity = CursorShapeSlotCount, CpuLevel level = DetectCpuLevel())
+        : m_Hash(SelectTileHash(level))
+    {
+        SetCapacity(capacity);
+    }
+
+    //
+    // 修改容量（1到CursorShapeSlotCount），清空全部条目
+    //
+    void SetCapacity(uint32_t capacity)
+    {
+        if (capacity == 0)
+        {
+            capacity = 1;
+        }
+        if (capacity > CursorShapeSlotCount)
+        {
+            capacity = CursorShapeSlotCount;
+        }
+
+        m_Entries.assign(capacity, Entry());
+    }
+
+    uint32_t Capacity() const
+    {
+        return (uint32_t)m_Entries.size();
+    }
+
+    //
+    // 清空条目，已分配的ID不再复用
+    //
+    void Clear()
+    {
+        for (Entry& entry : m_Entries)
+        {
+            entry = Entry();
+        }
+    }
+
+    const CursorShapeCacheStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 查找形状，未命中时分配新ID与槽位（空槽位优先，否则淘汰最久未用的条目）。
+    // 像素按info.Pitch排列，info.ShapeId被忽略。尺寸超过通道上限时返回false
+    //
+    bool Lookup(const CursorShapeInfo& info, const uint8_t* pixels, CursorShapeLookup& result)
+    {
+        if (info.Width == 0 || info.Height == 0 ||
+            info.Width > CursorMaxShapeSize || info.Height > CursorMaxShapeSize ||
+            info.Pitch < info.Width * 4 || (uint64_t)info.Pitch * info.Height > CursorMaxShapeBytes)
+        {
+            return false;
+        }
+
+        const uint32_t rowBytes = info.Width * 4;
+        const uint64_t hash = Hash(info, pixels);
+
+        m_Stats.Lookups++;
+        m_Stats.HashedBytes += (uint64_t)rowBytes * info.Height;
+        m_Tick++;
+
+        uint32_t victim = 0;
+        for (uint32_t slot = 0; slot < (uint32_t)m_Entries.size(); slot++)
+        {
+            Entry& entry = m_Entries[slot];
+            if (entry.ShapeId != 0 && entry.Hash == hash && Matches(entry, info, pixels))
+            {
+                entry.LastUse = m_Tick;
+                m_Stats.Hits++;
+                m_Stats.SavedBytes += (uint64_t)info.Pitch * info.Height;
+
+                result = { entry.ShapeId, slot, true, 0 };
+                return true;
+            }
+
+            // 空槽位的LastUse为0，总是先于有效条目被选中
+            if (entry.LastUse < m_Entries[victim].LastUse)
+            {
+                victim = slot;
+            }
+        }
+
+        Entry& entry = m_Entries[victim];
+        result = { m_NextId, victim, false, entry.ShapeId };
+        if (entry.ShapeId != 0)
+        {
+            m_Stats.Evictions++;
+        }
+
+        entry.ShapeId = m_NextId++;
+        entry.Hash = hash;
+        entry.LastUse = m_Tick;
+        entry.Type = info.Type;
+        entry.Width = info.Width;
+        entry.Height = info.Height;
+        entry.Pixels.resize((size_t)rowBytes * info.Height);
+        for (uint32_t y = 0; y < info.Height; y++)
+        {
+            std::memcpy(entry.Pixels.data() + (size_t)y * rowBytes, pixels + (size_t)y * info.Pitch, rowBytes);
+        }
+
+        m_Stats.UploadedBytes += (uint64_t)info.Pitch * info.Height;
+        return true;
+    }
+
+    //
+    // 形状内容哈希：类型与尺寸参与哈希，行尾填充不参与
+    //
+    uint64_t Hash(const CursorShapeInfo& info, const uint8_t* pixels) const
+    {
+        const uint64_t content = m_Hash(pixels, info.Pitch, info.Width * 4, info.Height);
+        const uint64_t shape = ((uint64_t)info.Type << 48) ^ ((uint64_t)info.Width << 24) ^ info.Height;
+        return content ^ (shape * TileHashDetail::Prime64_2);
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t ShapeId = 0;
+        uint64_t Hash = 0;
+        uint64_t LastUse = 0;
+        CursorShapeType Type = CursorShapeType::Unknown;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        std::vector<uint8_t> Pixels;    // 去掉行尾填充的副本，用于确认命中
+    };
+
+    static bool Matches(const Entry& entry, const CursorShapeInfo& info, const uint8_t* pixels)
+    {
+        if (entry.Type != info.Type || entry.Width != info.Width || entry.Height != info.Height)
+        {
+            return false;
+        }
+
+        const size_t rowBytes = (size_t)info.Width * 4;
+        for (uint32_t y = 0; y < info.Height; y++)
+        {
+            if (std::memcmp(entry.Pixels.data() + y * rowBytes, pixels + (size_t)y * info.Pitch, rowBytes) != 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    TileHashFunction m_Hash;
+    std::vector<Entry> m_Entries;
+    uint32_t m_NextId = 1;
+    uint64_t m_Tick = 0;
+    CursorShapeCacheStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
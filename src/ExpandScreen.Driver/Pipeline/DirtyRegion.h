@@ -0,0 +1,399 @@
+/*++
+
+Module Name:
+    DirtyRegion.h
+
+Abstract:
+    脏矩形合并与分块引擎
+
+    IddCx报告的脏矩形数量多、互相重叠且未对齐。本模块把它们转换为数量有界、
+    互不重叠、按编码块（16或64像素）对齐的矩形集合，供后续拷贝/转换阶段使用：
+        1. 每个矩形向外对齐到块边界并裁剪到帧内，标记到块位图（去重叠）
+        2. 从位图提取水平连续段，纵向合并相同跨度的段，得到精确覆盖
+        3. 按代价模型贪心合并：代价 = 像素面积 + 每矩形固定开销 * 矩形数，
+           合并后吸收与并集相交的矩形以保持互不重叠，直到代价不再下降
+           且矩形数不超过上限
+
+    所有缓冲区在实例内复用，稳态下每帧不分配内存。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 代价模型
+//
+struct RegionCostModel
+{
+    int32_t TileSize = 16;          // 对齐块大小（像素）
+    uint32_t MaxRects = 16;         // 输出矩形数上限
+    int64_t PerRectCost = 2048;     // 每个矩形的固定开销，以像素面积计
+};
+
+//
+// 单次合并统计
+//
+struct RegionStats
+{
+    uint32_t InputRects = 0;
+    uint32_t OutputRects = 0;
+    int64_t InputArea = 0;          // 输入矩形面积之和（含重叠）
+    int64_t CoveredArea = 0;        // 对齐后实际覆盖面积（合并前）
+    int64_t OutputArea = 0;         // 输出面积
+};
+
+class DirtyRegionCoalescer
+{
+public:
+    DirtyRegionCoalescer() = default;
+
+    explicit DirtyRegionCoalescer(const RegionCostModel& model)
+        : m_Model(model)
+    {
+    }
+
+    void SetCostModel(const RegionCostModel& model)
+    {
+        m_Model = model;
+    }
+
+    const RegionCostModel& CostModel() const
+    {
+        return m_Model;
+    }
+
+    const RegionStats& LastStats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 合并脏矩形，输出写入output，返回输出矩形数（不超过min(capacity, MaxRects)）
+    //
+    uint32_t Coalesce(
+        const FrameRect* input,
+        uint32_t inputCount,
+        int32_t frameWidth,
+        int32_t frameHeight,
+        FrameRect* output,
+        uint32_t outputCapacity)
+    {
+        m_Stats = RegionStats();
+        m_Stats.InputRects = inputCount;
+
+        if (frameWidth <= 0 || frameHeight <= 0 || outputCapacity == 0)
+        {
+            return 0;
+        }
+
+        const int32_t tile = m_Model.TileSize > 0 ? m_Model.TileSize : 1;
+        const FrameRect frame = { 0, 0, frameWidth, frameHeight };
+
+        PrepareGrid(frameWidth, frameHeight, tile);
+
+        bool any = false;
+        for (uint32_t i = 0; i < inputCount; i++)
+        {
+            FrameRect clipped = IntersectRect(input[i], frame);
+            if (clipped.IsEmpty())
+            {
+                continue;
+            }
+
+            m_Stats.InputArea += clipped.Area();
+            MarkTiles(clipped, tile);
+            any = true;
+        }
+
+        if (!any)
+        {
+            return 0;
+        }
+
+        ExtractRects(tile, frameWidth, frameHeight);
+
+        for (const FrameRect& rect : m_Rects)
+        {
+            m_Stats.CoveredArea += rect.Area();
+        }
+
+        uint32_t limit = m_Model.MaxRects < outputCapacity ? m_Model.MaxRects : outputCapacity;
+        if (limit == 0)
+        {
+            limit = 1;
+        }
+
+        MergeByCost(limit);
+
+        uint32_t count = 0;
+        for (const FrameRect& rect : m_Rects)
+        {
+            output[count++] = rect;
+            m_Stats.OutputArea += rect.Area();
+        }
+
+        m_Stats.OutputRects = count;
+        return count;
+    }
+
+private:
+    void PrepareGrid(int32_t frameWidth, int32_t frameHeight, int32_t tile)
+    {
+        int32_t gridWidth = (frameWidth + tile - 1) / tile;
+        int32_t gridHeight = (frameHeight + tile - 1) / tile;
+
+        // 位图在两次调用之间保持全零，只在尺寸变化时重建
+        if (gridWidth != m_GridWidth || gridHeight != m_GridHeight)
+        {
+            m_GridWidth = gridWidth;
+            m_GridHeight = gridHeight;
+            m_Grid.assign((size_t)m_GridWidth * m_GridHeight, 0);
+        }
+
+        m_MinX = m_GridWidth;
+        m_MinY = m_GridHeight;
+        m_MaxX = 0;
+        m_MaxY = 0;
+        m_Rects.clear();
+    }
+
+    void MarkTiles(const FrameRect& rect, int32_t tile)
+    {
+        int32_t x0 = rect.Left / tile;
+        int32_t y0 = rect.Top / tile;
+        int32_t x1 = (rect.Right + tile - 1) / tile;
+        int32_t y1 = (rect.Bottom + tile - 1) / tile;
+
+        for (int32_t y = y0; y < y1; y++)
+        {
+            std::memset(&m_Grid[(size_t)y * m_GridWidth + x0], 1, (size_t)(x1 - x0));
+        }
+
+        m_MinX = std::min(m_MinX, x0);
+        m_MinY = std::min(m_MinY, y0);
+        m_MaxX = std::max(m_MaxX, x1);
+        m_MaxY = std::max(m_MaxY, y1);
+    }
+
+    //
+    // 行扫描提取水平段，与上一行跨度完全相同的段向下延伸
+    //
+    void ExtractRects(int32_t tile, int32_t frameWidth, int32_t frameHeight)
+    {
+        // m_Open保存上一行仍可延伸的矩形在m_Rects中的下标（按块坐标存储）
+        m_Open.clear();
+
+        // 只扫描标记过的包围范围，扫描后清零该行以便下次复用
+        for (int32_t y = m_MinY; y < m_MaxY; y++)
+        {
+            uint8_t* row = &m_Grid[(size_t)y * m_GridWidth];
+            m_NextOpen.clear();
+            size_t openCursor = 0;
+
+            int32_t x = m_MinX;
+            while (x < m_MaxX)
+            {
+                if (row[x] == 0)
+                {
+                    x++;
+                    continue;
+                }
+
+                int32_t start = x;
+                while (x < m_MaxX && row[x] != 0)
+                {
+                    x++;
+                }
+
+                // m_Open按Left有序，向前推进游标寻找相同跨度
+                while (openCursor < m_Open.size() && m_Rects[m_Open[openCursor]].Left < start)
+                {
+                    openCursor++;
+                }
+
+                if (openCursor < m_Open.size() &&
+                    m_Rects[m_Open[openCursor]].Left == start &&
+                    m_Rects[m_Open[openCursor]].Right == x)
+                {
+                    m_Rects[m_Open[openCursor]].Bottom = y + 1;
+                    m_NextOpen.push_back(m_Open[openCursor]);
+                    openCursor++;
+                }
+                else
+                {
+                    m_Rects.push_back({ start, y, x, y + 1 });
+                    m_NextOpen.push_back((uint32_t)m_Rects.size() - 1);
+                }
+            }
+
+            m_Open.swap(m_NextOpen);
+            std::memset(row + m_MinX, 0, (size_t)(m_MaxX - m_MinX));
+        }
+
+        // 块坐标转换为像素坐标并裁剪到帧边界
+        for (FrameRect& rect : m_Rects)
+        {
+            rect.Left *= tile;
+            rect.Top *= tile;
+            rect.Right = rect.Right * tile < frameWidth ? rect.Right * tile : frameWidth;
+            rect.Bottom = rect.Bottom * tile < frameHeight ? rect.Bottom * tile : frameHeight;
+        }
+    }
+
+    //
+    // 与第i个矩形合并代价最低的伙伴（不计吸收，作为估计）
+    //
+    void UpdateBestPartner(size_t i)
+    {
+        m_BestPartner[i] = UINT32_MAX;
+        m_BestCost[i] = INT64_MAX;
+
+        for (size_t j = 0; j < m_Rects.size(); j++)
+        {
+            if (j == i || !m_Alive[j])
+            {
+                continue;
+            }
+
+            int64_t cost = MergeCost(m_Rects[i], m_Rects[j]);
+            if (cost < m_BestCost[i])
+            {
+                m_BestCost[i] = cost;
+                m_BestPartner[i] = (uint32_t)j;
+            }
+        }
+    }
+
+    int64_t MergeCost(const FrameRect& a, const FrameRect& b) const
+    {
+        return UnionRect(a, b).Area() - a.Area() - b.Area() - m_Model.PerRectCost;
+    }
+
+    void MergeByCost(uint32_t limit)
+    {
+        size_t count = m_Rects.size();
+        if (count <= 1)
+        {
+            return;
+        }
+
+        m_Alive.assign(count, 1);
+        m_BestPartner.assign(count, UINT32_MAX);
+        m_BestCost.assign(count, INT64_MAX);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            UpdateBestPartner(i);
+        }
+
+        size_t alive = count;
+
+        while (alive > 1)
+        {
+            size_t best = SIZE_MAX;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (m_Alive[i] && m_BestPartner[i] != UINT32_MAX &&
+                    (best == SIZE_MAX || m_BestCost[i] < m_BestCost[best]))
+                {
+                    best = i;
+                }
+            }
+
+            if (best == SIZE_MAX || (m_BestCost[best] >= 0 && alive <= limit))
+            {
+                break;
+            }
+
+            size_t partner = m_BestPartner[best];
+            FrameRect merged = UnionRect(m_Rects[best], m_Rects[partner]);
+            m_Alive[partner] = 0;
+            alive--;
+
+            // 吸收与并集相交的矩形，直到稳定，保证输出互不重叠
+            bool grown = true;
+            while (grown)
+            {
+                grown = false;
+                for (size_t j = 0; j < count; j++)
+                {
+                    if (j != best && m_Alive[j] && RectsOverlap(merged, m_Rects[j]))
+                    {
+                        merged = UnionRect(merged, m_Rects[j]);
+                        m_Alive[j] = 0;
+                        alive--;
+                        grown = true;
+                    }
+                }
+            }
+
+            m_Rects[best] = merged;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!m_Alive[i])
+                {
+                    continue;
+                }
+
+                if (i == best || m_BestPartner[i] == UINT32_MAX || !m_Alive[m_BestPartner[i]] ||
+                    m_BestPartner[i] == best)
+                {
+                    UpdateBestPartner(i);
+                }
+                else
+                {
+                    int64_t cost = MergeCost(m_Rects[i], merged);
+                    if (cost < m_BestCost[i])
+                    {
+                        m_BestCost[i] = cost;
+                        m_BestPartner[i] = (uint32_t)best;
+                    }
+                }
+            }
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (m_Alive[i])
+            {
+                m_Rects[write++] = m_Rects[i];
+            }
+        }
+        m_Rects.resize(write);
+    }
+
+    RegionCostModel m_Model;
+    RegionStats m_Stats;
+
+    int32_t m_GridWidth = 0;
+    int32_t m_GridHeight = 0;
+    int32_t m_MinX = 0;
+    int32_t m_MinY = 0;
+    int32_t m_MaxX = 0;
+    int32_t m_MaxY = 0;
+    std::vector<uint8_t> m_Grid;
+    std::vector<FrameRect> m_Rects;
+    std::vector<uint32_t> m_Open;
+    std::vector<uint32_t> m_NextOpen;
+    std::vector<uint8_t> m_Alive;
+    std::vector<uint32_t> m_BestPartner;
+    std::vector<int64_t> m_BestCost;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,1231 @@
+/*++
+
+Module Name:
+    Downscale.h
+
+Abstract:
+    BGRA与NV12图像缩小，带宽受限时降低串流分辨率
+
+    两类内核：
+        1. 整数倍盒式滤波（2:1、4:1）：按2x2/4x4块精确求平均，单次舍入
+        2. 任意比例可分离重采样（盒式/双线性/Lanczos-2）：窗口与权重按输出坐标
+           预先计算（缩小时滤波器支撑按比例放大），权重为2^14定点且和精确为1。
+           先纵向把所需的源行合成一行，再横向得到输出行
+
+    每个平面按通道数（BGRA为4，NV12的Y为1、UV为2）选择内核，标量、SSE4.1、AVX2
+    结果逐位一致（AVX-512级别使用AVX2内核）。
+
+    缩小结果可以是常驻图像：MapRect给出源损伤区域影响的目标区域，Scale只重新
+    计算该区域，结果与整帧缩小逐位一致。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "ColorConvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+enum class ScaleFilter : uint32_t
+{
+    Box = 0,
+    Bilinear = 1,
+    Lanczos2 = 2
+};
+
+constexpr int ScaleWeightShift = 14;
+
+inline const char* ScaleFilterName(ScaleFilter filter)
+{
+    switch (filter)
+    {
+    case ScaleFilter::Box: return "box";
+    case ScaleFilter::Bilinear: return "bilinear";
+    case ScaleFilter::Lanczos2: return "lanczos2";
+    default: return "unknown";
+    }
+}
+
+namespace ScaleDetail {
+
+inline double FilterSupport(ScaleFilter filter)
+{
+    switch (filter)
+    {
+    case ScaleFilter::Bilinear: return 1.0;
+    case ScaleFilter::Lanczos2: return 2.0;
+    default: return 0.5;
+    }
+}
+
+inline double Sinc(double x)
+{
+    if (x == 0.0)
+    {
+        return 1.0;
+    }
+
+    x *= 3.14159265358979323846;
+    return std::sin(x) / x;
+}
+
+inline double FilterWeight(ScaleFilter filter, double x)
+{
+    switch (filter)
+    {
+    case ScaleFilter::Bilinear:
+        x = std::fabs(x);
+        return x < 1.0 ? 1.0 - x : 0.0;
+    case ScaleFilter::Lanczos2:
+        return (x > -2.0 && x < 2.0) ? Sinc(x) * Sinc(x / 2.0) : 0.0;
+    default:
+        return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    }
+}
+
+inline uint8_t RoundWeighted(int32_t sum)
+{
+    return ColorDetail::Clamp255((sum + (1 << (ScaleWeightShift - 1))) >> ScaleWeightShift);
+}
+
+} // namespace ScaleDetail
+
+//
+// 一维重采样系数：每个输出坐标对应源窗口[Start, Start + Count)与定点权重。
+// Lanes为横向SIMD内核使用的展开权重：每块16/channels个抽头，存为16个int16
+//
+class ScaleCoefficients
+{
+public:
+    bool Build(int32_t sourceSize, int32_t targetSize, ScaleFilter filter, uint32_t channels)
+    {
+        m_Start.clear();
+        m_Count.clear();
+        m_Weights.clear();
+        m_Lanes.clear();
+        if (sourceSize <= 0 || targetSize <= 0 ||
+            (channels != 1 && channels != 2 && channels != 4))
+        {
+            return false;
+        }
+
+        const double scale = (double)sourceSize / targetSize;
+        const double filterScale = std::max(scale, 1.0);
+        const double support = ScaleDetail::FilterSupport(filter) * filterScale;
+
+        m_Stride = (uint32_t)std::ceil(support) * 2 + 1;
+        m_Start.resize(targetSize);
+        m_Count.resize(targetSize);
+        m_Weights.assign((size_t)targetSize * m_Stride, 0);
+
+        std::vector<double> weights(m_Stride);
+        for (int32_t i = 0; i < targetSize; i++)
+        {
+            const double center = (i + 0.5) * scale;
+            int32_t begin = std::max((int32_t)(center - support + 0.5), 0);
+            int32_t end = std::min((int32_t)(center + support + 0.5), sourceSize);
+            end = std::min(end, begin + (int32_t)m_Stride);
+
+            double total = 0.0;
+            for (int32_t x = begin; x < end; x++)
+            {
+                weights[x - begin] = ScaleDetail::FilterWeight(filter, (x - center + 0.5) / filterScale);
+                total += weights[x - begin];
+            }
+
+            // 定点化后把舍入误差补到最大的权重上，保证和精确为1
+            int16_t* fixed = &m_Weights[(size_t)i * m_Stride];
+            int32_t sum = 0;
+            int32_t largest = 0;
+            for (int32_t x = begin; x < end; x++)
+            {
+                const int32_t t = x - begin;
+                fixed[t] = (int16_t)std::lround(weights[t] / total * (1 << ScaleWeightShift));
+                sum += fixed[t];
+                if (fixed[t] > fixed[largest])
+                {
+                    largest = t;
+                }
+            }
+            fixed[largest] = (int16_t)(fixed[largest] + (1 << ScaleWeightShift) - sum);
+
+            // 去掉两端的零权重
+            int32_t first = 0;
+            int32_t last = end - begin;
+            while (first < last - 1 && fixed[first] == 0)
+            {
+                first++;
+            }
+            while (last - 1 > first && fixed[last - 1] == 0)
+            {
+                last--;
+            }
+            if (first != 0)
+            {
+                std::memmove(fixed, fixed + first, (size_t)(last - first) * sizeof(int16_t));
+                std::fill(fixed + (last - first), fixed + m_Stride, (int16_t)0);
+            }
+
+            m_Start[i] = begin + first;
+            m_Count[i] = (uint32_t)(last - first);
+        }
+
+        // 展开为横向SIMD布局
+        const uint32_t tapsPerChunk = 16 / channels;
+        m_Chunks = (m_Stride + tapsPerChunk - 1) / tapsPerChunk;
+        m_Lanes.assign((size_t)targetSize * m_Chunks * 16, 0);
+        for (int32_t i = 0; i < targetSize; i++)
+        {
+            const int16_t* fixed = Weights(i);
+            int16_t* lanes = &m_Lanes[(size_t)i * m_Chunks * 16];
+            for (uint32_t t = 0; t < m_Count[i]; t++)
+            {
+                const uint32_t chunk = t / tapsPerChunk;
+                const uint32_t tap = t % tapsPerChunk;
+                for (uint32_t copy = 0; copy < channels; copy++)
+                {
+                    lanes[chunk * 16 + copy * tapsPerChunk + tap] = fixed[t];
+                }
+            }
+        }
+
+        m_SourceSize = sourceSize;
+        return true;
+    }
+
+    int32_t TargetSize() const
+    {
+        return (int32_t)m_Start.size();
+    }
+
+    int32_t SourceSize() const
+    {
+        return m_SourceSize;
+    }
+
+    int32_t Start(int32_t index) const
+    {
+        return m_Start[index];
+    }
+
+    uint32_t Count(int32_t index) const
+    {
+        return m_Count[index];
+    }
+
+    uint32_t MaxCount() const
+    {
+        return m_Stride;
+    }
+
+    const int16_t* Weights(int32_t index) const
+    {
+        return &m_Weights[(size_t)index * m_Stride];
+    }
+
+    uint32_t Chunks() const
+    {
+        return m_Chunks;
+    }
+
+    const int16_t* Lanes(int32_t index) const
+    {
+        return &m_Lanes[(size_t)index * m_Chunks * 16];
+    }
+
+    //
+    // 窗口与源区间[begin, end)相交的输出区间，无相交时为空
+    //
+    void MapSpan(int32_t begin, int32_t end, int32_t& targetBegin, int32_t& targetEnd) const
+    {
+        targetBegin = 0;
+        targetEnd = 0;
+        if (begin >= end)
+        {
+            return;
+        }
+
+        // 窗口随输出坐标单调移动，去掉零权重后可能有个别例外，逐个检查
+        const int32_t size = TargetSize();
+        for (int32_t i = 0; i < size; i++)
+        {
+            if (m_Start[i] < end && m_Start[i] + (int32_t)m_Count[i] > begin)
+            {
+                if (targetBegin == targetEnd)
+                {
+                    targetBegin = i;
+                }
+                targetEnd = i + 1;
+            }
+        }
+    }
+
+    //
+    // 输出区间[targetBegin, targetEnd)读取的源区间
+    //
+    void SourceSpan(int32_t targetBegin, int32_t targetEnd, int32_t& begin, int32_t& end) const
+    {
+        begin = m_SourceSize;
+        end = 0;
+        for (int32_t i = targetBegin; i < targetEnd; i++)
+        {
+            begin = std::min(begin, m_Start[i]);
+            end = std::max(end, m_Start[i] + (int32_t)m_Count[i]);
+        }
+    }
+
+private:
+    std::vector<int32_t> m_Start;
+    std::vector<uint32_t> m_Count;
+    std::vector<int16_t> m_Weights;
+    std::vector<int16_t> m_Lanes;
+    uint32_t m_Stride = 0;
+    uint32_t m_Chunks = 0;
+    int32_t m_SourceSize = 0;
+};
+
+namespace ScaleDetail {
+
+//
+// 盒式2:1/4:1：rows为Factor个相邻源行，输出[begin, end)像素
+//
+template <uint32_t Channels, uint32_t Factor>
+inline void BoxScalar(const uint8_t* const* rows, uint8_t* out, uint32_t begin, uint32_t end)
+{
+    const int32_t round = Factor * Factor / 2;
+    const int32_t shift = Factor == 2 ? 2 : 4;
+    for (uint32_t x = begin; x < end; x++)
+    {
+        for (uint32_t c = 0; c < Channels; c++)
+        {
+            int32_t sum = 0;
+            for (uint32_t r = 0; r < Factor; r++)
+            {
+                const uint8_t* p = rows[r] + (size_t)x * Factor * Channels + c;
+                for (uint32_t k = 0; k < Factor; k++)
+                {
+                    sum += p[k * Channels];
+                }
+            }
+            out[(size_t)x * Channels + c] = (uint8_t)((sum + round) >> shift);
+        }
+    }
+}
+
+//
+// 纵向：out[b] = Σ weights[k] * rows[k][b]，b属于[begin, end)（字节）
+//
+inline void VerticalScalar(
+    const uint8_t* const* rows,
+    const int16_t* weights,
+    uint32_t taps,
+    uint32_t begin,
+    uint32_t end,
+    uint8_t* out)
+{
+    for (uint32_t b = begin; b < end; b++)
+    {
+        int32_t sum = 0;
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            sum += weights[k] * rows[k][b];
+        }
+        out[b] = RoundWeighted(sum);
+    }
+}
+
+//
+// 横向：输出像素[begin, end)，源为纵向合成后的一行
+//
+template <uint32_t Channels>
+inline void HorizontalScalar(
+    const uint8_t* row,
+    const ScaleCoefficients& table,
+    int32_t begin,
+    int32_t end,
+    uint8_t* out)
+{
+    for (int32_t i = begin; i < end; i++)
+    {
+        const uint8_t* p = row + (size_t)table.Start(i) * Channels;
+        const int16_t* weights = table.Weights(i);
+        const uint32_t count = table.Count(i);
+        for (uint32_t c = 0; c < Channels; c++)
+        {
+            int32_t sum = 0;
+            for (uint32_t t = 0; t < count; t++)
+            {
+                sum += weights[t] * p[t * Channels + c];
+            }
+            out[(size_t)i * Channels + c] = RoundWeighted(sum);
+        }
+    }
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+//
+// 盒式内核先用pshufb把要相加的同通道字节排到一起，再用maddubs(x, 1)两两相加：
+//     2:1  BGRA每8字节 (0,4,1,5,2,6,3,7)，UV每4字节 (0,2,1,3)，Y不需要重排
+//     4:1  BGRA每16字节 (0,4,8,12,...)，UV每8字节 (0,2,4,6,1,3,5,7)；四行的16位和
+//          再用madd(x, 1)相加成32位
+// 横向重采样内核把一块源字节按通道重排成 [通道0的各抽头, 通道1的各抽头, ...]，
+// 零扩展后与展开的权重madd，最后用hadd归约出每个通道的和。
+//
+template <uint32_t Channels, uint32_t Factor>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i BoxShuffleSse41()
+{
+    if (Factor == 2)
+    {
+        return Channels == 4 ? _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15)
+            : _mm_setr_epi8(0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15);
+    }
+
+    return Channels == 4 ? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+        : _mm_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15);
+}
+
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i HorizontalShuffleSse41()
+{
+    return Channels == 4 ? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+        : _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+}
+
+template <uint32_t Channels, uint32_t Factor>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i BoxLoadSse41(const uint8_t* p, __m128i shuffle)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return Channels == 1 ? v : _mm_shuffle_epi8(v, shuffle);
+}
+
+template <uint32_t Channels, uint32_t Factor>
+EXPANDSCREEN_TARGET_SSE41
+inline void BoxSse41(const uint8_t* const* rows, uint8_t* out, uint32_t begin, uint32_t end)
+{
+    const __m128i shuffle = BoxShuffleSse41<Channels, Factor>();
+    const __m128i ones8 = _mm_set1_epi8(1);
+    const uint32_t step = 16 / Channels;
+
+    uint32_t x = begin;
+    if (Factor == 2)
+    {
+        const __m128i round = _mm_set1_epi16(2);
+        for (; x + step <= end; x += step)
+        {
+            const size_t in = (size_t)x * 2 * Channels;
+            __m128i s0 = _mm_add_epi16(
+                _mm_maddubs_epi16(BoxLoadSse41<Channels, Factor>(rows[0] + in, shuffle), ones8),
+                _mm_maddubs_epi16(BoxLoadSse41<Channels, Factor>(rows[1] + in, shuffle), ones8));
+            __m128i s1 = _mm_add_epi16(
+                _mm_maddubs_epi16(BoxLoadSse41<Channels, Factor>(rows[0] + in + 16, shuffle), ones8),
+                _mm_maddubs_epi16(BoxLoadSse41<Channels, Factor>(rows[1] + in + 16, shuffle), ones8));
+            s0 = _mm_srli_epi16(_mm_add_epi16(s0, round), 2);
+            s1 = _mm_srli_epi16(_mm_add_epi16(s1, round), 2);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (size_t)x * Channels), _mm_packus_epi16(s0, s1));
+        }
+    }
+    else
+    {
+        const __m128i ones16 = _mm_set1_epi16(1);
+        const __m128i round = _mm_set1_epi32(8);
+        for (; x + step <= end; x += step)
+        {
+            const size_t in = (size_t)x * 4 * Channels;
+            __m128i sums[4];
+            for (int j = 0; j < 4; j++)
+            {
+                __m128i s = _mm_setzero_si128();
+                for (int r = 0; r < 4; r++)
+                {
+                    s = _mm_add_epi16(s, _mm_maddubs_epi16(
+                        BoxLoadSse41<Channels, Factor>(rows[r] + in + j * 16, shuffle), ones8));
+                }
+                sums[j] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(s, ones16), round), 4);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (size_t)x * Channels),
+                ColorDetail::PackSse41(sums[0], sums[1], sums[2], sums[3]));
+        }
+    }
+
+    BoxScalar<Channels, Factor>(rows, out, x, end);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i RoundWeightedSse41(__m128i sum)
+{
+    return _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << (ScaleWeightShift - 1))), ScaleWeightShift);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline void VerticalSse41(
+    const uint8_t* const* rows,
+    const int16_t* weights,
+    uint32_t taps,
+    uint32_t begin,
+    uint32_t end,
+    uint8_t* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    uint32_t b = begin;
+    for (; b + 16 <= end; b += 16)
+    {
+        __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+        for (uint32_t k = 0; k < taps; k += 2)
+        {
+            // 抽头数为奇数时最后一个抽头与自身配对，第二个权重为0
+            const bool pair = k + 1 < taps;
+            const __m128i w = _mm_set1_epi32(ColorDetail::PackCoefficients(weights[k], pair ? weights[k + 1] : 0));
+            const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + b));
+            const __m128i r1 = pair ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1] + b)) : r0;
+
+            const __m128i a = _mm_cvtepu8_epi16(r0), ah = _mm_unpackhi_epi8(r0, zero);
+            const __m128i c = _mm_cvtepu8_epi16(r1), ch = _mm_unpackhi_epi8(r1, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a, c), w));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a, c), w));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ah, ch), w));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ah, ch), w));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b), ColorDetail::PackSse41(
+            RoundWeightedSse41(acc0), RoundWeightedSse41(acc1), RoundWeightedSse41(acc2), RoundWeightedSse41(acc3)));
+    }
+
+    VerticalScalar(rows, weights, taps, b, end, out);
+}
+
+// 单个输出像素的部分和：1通道为4个待归约的部分和，2通道为[U01, U23, V01, V23]，4通道已是[B, G, R, A]
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i PartialSse41(const uint8_t* row, const ScaleCoefficients& table, int32_t i, __m128i shuffle)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const uint8_t* p = row + (size_t)table.Start(i) * Channels;
+    const int16_t* lanes = table.Lanes(i);
+    __m128i low = zero, high = zero;
+    for (uint32_t j = 0; j < table.Chunks(); j++)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j * 16));
+        if (Channels != 1)
+        {
+            v = _mm_shuffle_epi8(v, shuffle);
+        }
+        const __m128i* w = reinterpret_cast<const __m128i*>(lanes + j * 16);
+        low = _mm_add_epi32(low, _mm_madd_epi16(_mm_cvtepu8_epi16(v), _mm_loadu_si128(w)));
+        high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), _mm_loadu_si128(w + 1)));
+    }
+
+    return Channels == 1 ? _mm_add_epi32(low, high) : _mm_hadd_epi32(low, high);
+}
+
+//
+// 连续4个32位结果（1通道为4个输出，2通道为2个输出，4通道为1个输出）。
+// 归约的hadd由多个输出分摊，而不是每个输出各自归约到单个通道
+//
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i GroupSse41(const uint8_t* row, const ScaleCoefficients& table, int32_t i, __m128i shuffle)
+{
+    if (Channels == 1)
+    {
+        return _mm_hadd_epi32(
+            _mm_hadd_epi32(PartialSse41<1>(row, table, i, shuffle), PartialSse41<1>(row, table, i + 1, shuffle)),
+            _mm_hadd_epi32(PartialSse41<1>(row, table, i + 2, shuffle), PartialSse41<1>(row, table, i + 3, shuffle)));
+    }
+
+    if (Channels == 2)
+    {
+        return _mm_hadd_epi32(PartialSse41<2>(row, table, i, shuffle), PartialSse41<2>(row, table, i + 1, shuffle));
+    }
+
+    return PartialSse41<Channels>(row, table, i, shuffle);
+}
+
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_SSE41
+inline void HorizontalSse41(
+    const uint8_t* row,
+    const ScaleCoefficients& table,
+    int32_t begin,
+    int32_t end,
+    uint8_t* out)
+{
+    const __m128i shuffle = HorizontalShuffleSse41<Channels>();
+    const int32_t group = 4 / Channels;
+
+    int32_t i = begin;
+    for (; i + 4 * group <= end; i += 4 * group)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (size_t)i * Channels), ColorDetail::PackSse41(
+            RoundWeightedSse41(GroupSse41<Channels>(row, table, i, shuffle)),
+            RoundWeightedSse41(GroupSse41<Channels>(row, table, i + group, shuffle)),
+            RoundWeightedSse41(GroupSse41<Channels>(row, table, i + 2 * group, shuffle)),
+            RoundWeightedSse41(GroupSse41<Channels>(row, table, i + 3 * group, shuffle))));
+    }
+
+    // 尾部逐像素归约
+    for (; i < end; i++)
+    {
+        __m128i sums = PartialSse41<Channels>(row, table, i, shuffle);
+        if (Channels != 4)
+        {
+            sums = _mm_hadd_epi32(sums, sums);
+        }
+        if (Channels == 1)
+        {
+            sums = _mm_hadd_epi32(sums, sums);
+        }
+
+        const __m128i words = _mm_packs_epi32(RoundWeightedSse41(sums), _mm_setzero_si128());
+        const uint32_t packed = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(out + (size_t)i * Channels, &packed, Channels);
+    }
+}
+
+template <uint32_t Channels, uint32_t Factor>
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i BoxLoadAvx2(const uint8_t* p, __m256i shuffle)
+{
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return Channels == 1 ? v : _mm256_shuffle_epi8(v, shuffle);
+}
+
+template <uint32_t Channels, uint32_t Factor>
+EXPANDSCREEN_TARGET_AVX2
+inline void BoxAvx2(const uint8_t* const* rows, uint8_t* out, uint32_t begin, uint32_t end)
+{
+    const __m128i shuffle128 = BoxShuffleSse41<Channels, Factor>();
+    const __m256i shuffle = _mm256_broadcastsi128_si256(shuffle128);
+    const __m256i ones8 = _mm256_set1_epi8(1);
+    const uint32_t step = 32 / Channels;
+
+    uint32_t x = begin;
+    if (Factor == 2)
+    {
+        const __m256i round = _mm256_set1_epi16(2);
+        for (; x + step <= end; x += step)
+        {
+            const size_t in = (size_t)x * 2 * Channels;
+            __m256i s0 = _mm256_add_epi16(
+                _mm256_maddubs_epi16(BoxLoadAvx2<Channels, Factor>(rows[0] + in, shuffle), ones8),
+                _mm256_maddubs_epi16(BoxLoadAvx2<Channels, Factor>(rows[1] + in, shuffle), ones8));
+            __m256i s1 = _mm256_add_epi16(
+                _mm256_maddubs_epi16(BoxLoadAvx2<Channels, Factor>(rows[0] + in + 32, shuffle), ones8),
+                _mm256_maddubs_epi16(BoxLoadAvx2<Channels, Factor>(rows[1] + in + 32, shuffle), ones8));
+            s0 = _mm256_srli_epi16(_mm256_add_epi16(s0, round), 2);
+            s1 = _mm256_srli_epi16(_mm256_add_epi16(s1, round), 2);
+
+            // packus按128位通道交错，按64位重排恢复顺序
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (size_t)x * Channels),
+                _mm256_permute4x64_epi64(_mm256_packus_epi16(s0, s1), 0xD8));
+        }
+    }
+    else
+    {
+        const __m256i ones16 = _mm256_set1_epi16(1);
+        const __m256i round = _mm256_set1_epi32(8);
+        for (; x + step <= end; x += step)
+        {
+            const size_t in = (size_t)x * 4 * Channels;
+            __m256i sums[4];
+            for (int j = 0; j < 4; j++)
+            {
+                __m256i s = _mm256_setzero_si256();
+                for (int r = 0; r < 4; r++)
+                {
+                    s = _mm256_add_epi16(s, _mm256_maddubs_epi16(
+                        BoxLoadAvx2<Channels, Factor>(rows[r] + in + j * 32, shuffle), ones8));
+                }
+                sums[j] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(s, ones16), round), 4);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (size_t)x * Channels),
+                ColorDetail::PackAvx2(sums[0], sums[1], sums[2], sums[3]));
+        }
+    }
+
+    BoxScalar<Channels, Factor>(rows, out, x, end);
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i RoundWeightedAvx2(__m256i sum)
+{
+    return _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(1 << (ScaleWeightShift - 1))), ScaleWeightShift);
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline void VerticalAvx2(
+    const uint8_t* const* rows,
+    const int16_t* weights,
+    uint32_t taps,
+    uint32_t begin,
+    uint32_t end,
+    uint8_t* out)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint32_t b = begin;
+    for (; b + 32 <= end; b += 32)
+    {
+        // 每个累加器的低128位与高128位分别对应相隔8字节的两组像素
+        __m256i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+        for (uint32_t k = 0; k < taps; k += 2)
+        {
+            const bool pair = k + 1 < taps;
+            const __m256i w = _mm256_set1_epi32(ColorDetail::PackCoefficients(weights[k], pair ? weights[k + 1] : 0));
+            const uint8_t* p0 = rows[k] + b;
+            const uint8_t* p1 = pair ? rows[k + 1] + b : p0;
+
+            const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0)));
+            const __m256i ah = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + 16)));
+            const __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1)));
+            const __m256i ch = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + 16)));
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, c), w));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, c), w));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ah, ch), w));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ah, ch), w));
+        }
+
+        const __m256i low = _mm256_packs_epi32(RoundWeightedAvx2(acc0), RoundWeightedAvx2(acc1));
+        const __m256i high = _mm256_packs_epi32(RoundWeightedAvx2(acc2), RoundWeightedAvx2(acc3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + b),
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8));
+    }
+
+    VerticalScalar(rows, weights, taps, b, end, out);
+}
+
+// 两个输出像素的部分和，分占低、高128位，布局同PartialSse41
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i PartialAvx2(const uint8_t* row, const ScaleCoefficients& table, int32_t i0, int32_t i1, __m256i shuffle)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const uint8_t* p0 = row + (size_t)table.Start(i0) * Channels;
+    const uint8_t* p1 = row + (size_t)table.Start(i1) * Channels;
+    const int16_t* lanes0 = table.Lanes(i0);
+    const int16_t* lanes1 = table.Lanes(i1);
+    __m256i low = zero, high = zero;
+    for (uint32_t j = 0; j < table.Chunks(); j++)
+    {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + j * 16))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + j * 16)), 1);
+        if (Channels != 1)
+        {
+            v = _mm256_shuffle_epi8(v, shuffle);
+        }
+        const __m128i* w0 = reinterpret_cast<const __m128i*>(lanes0 + j * 16);
+        const __m128i* w1 = reinterpret_cast<const __m128i*>(lanes1 + j * 16);
+        const __m256i wLow = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(w0)), _mm_loadu_si128(w1), 1);
+        const __m256i wHigh = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(w0 + 1)), _mm_loadu_si128(w1 + 1), 1);
+        low = _mm256_add_epi32(low, _mm256_madd_epi16(_mm256_unpacklo_epi8(v, zero), wLow));
+        high = _mm256_add_epi32(high, _mm256_madd_epi16(_mm256_unpackhi_epi8(v, zero), wHigh));
+    }
+
+    return Channels == 1 ? _mm256_add_epi32(low, high) : _mm256_hadd_epi32(low, high);
+}
+
+// 连续8个32位结果：低128位是从i开始的一组，高128位是紧随其后的一组（hadd按128位通道进行）
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i GroupAvx2(const uint8_t* row, const ScaleCoefficients& table, int32_t i, __m256i shuffle)
+{
+    const int32_t half = 4 / Channels;
+
+    if (Channels == 1)
+    {
+        return _mm256_hadd_epi32(
+            _mm256_hadd_epi32(PartialAvx2<1>(row, table, i, i + 4, shuffle), PartialAvx2<1>(row, table, i + 1, i + 5, shuffle)),
+            _mm256_hadd_epi32(PartialAvx2<1>(row, table, i + 2, i + 6, shuffle), PartialAvx2<1>(row, table, i + 3, i + 7, shuffle)));
+    }
+
+    if (Channels == 2)
+    {
+        return _mm256_hadd_epi32(
+            PartialAvx2<2>(row, table, i, i + 2, shuffle), PartialAvx2<2>(row, table, i + 1, i + 3, shuffle));
+    }
+
+    return PartialAvx2<Channels>(row, table, i, i + half, shuffle);
+}
+
+template <uint32_t Channels>
+EXPANDSCREEN_TARGET_AVX2
+inline void HorizontalAvx2(
+    const uint8_t* row,
+    const ScaleCoefficients& table,
+    int32_t begin,
+    int32_t end,
+    uint8_t* out)
+{
+    const __m256i shuffle = _mm256_broadcastsi128_si256(HorizontalShuffleSse41<Channels>());
+    const int32_t group = 8 / Channels;
+
+    int32_t i = begin;
+    for (; i + 4 * group <= end; i += 4 * group)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (size_t)i * Channels), ColorDetail::PackAvx2(
+            RoundWeightedAvx2(GroupAvx2<Channels>(row, table, i, shuffle)),
+            RoundWeightedAvx2(GroupAvx2<Channels>(row, table, i + group, shuffle)),
+            RoundWeightedAvx2(GroupAvx2<Channels>(row, table, i + 2 * group, shuffle)),
+            RoundWeightedAvx2(GroupAvx2<Channels>(row, table, i + 3 * group, shuffle))));
+    }
+
+    HorizontalSse41<Channels>(row, table, i, end, out);
+}
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+} // namespace ScaleDetail
+
+using ScaleBoxKernel = void (*)(const uint8_t* const* rows, uint8_t* out, uint32_t begin, uint32_t end);
+
+using ScaleVerticalKernel = void (*)(
+    const uint8_t* const* rows,
+    const int16_t* weights,
+    uint32_t taps,
+    uint32_t begin,
+    uint32_t end,
+    uint8_t* out);
+
+using ScaleHorizontalKernel = void (*)(
+    const uint8_t* row,
+    const ScaleCoefficients& table,
+    int32_t begin,
+    int32_t end,
+    uint8_t* out);
+
+namespace ScaleDetail {
+
+// AVX-512级别使用AVX2内核
+inline CpuLevel ScaleLevel(CpuLevel level)
+{
+    level = ClampCpuLevel(level);
+    return level == CpuLevel::Avx512 ? CpuLevel::Avx2 : level;
+}
+
+template <uint32_t Channels, uint32_t Factor>
+inline ScaleBoxKernel SelectBoxKernelFor(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ScaleLevel(level))
+    {
+    case CpuLevel::Avx2: return BoxAvx2<Channels, Factor>;
+    case CpuLevel::Sse41: return BoxSse41<Channels, Factor>;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return BoxScalar<Channels, Factor>;
+}
+
+template <uint32_t Channels>
+inline ScaleHorizontalKernel SelectHorizontalKernelFor(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ScaleLevel(level))
+    {
+    case CpuLevel::Avx2: return HorizontalAvx2<Channels>;
+    case CpuLevel::Sse41: return HorizontalSse41<Channels>;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return HorizontalScalar<Channels>;
+}
+
+} // namespace ScaleDetail
+
+inline ScaleBoxKernel SelectBoxKernel(uint32_t channels, uint32_t factor, CpuLevel level)
+{
+    switch (channels * 10 + factor)
+    {
+    case 12: return ScaleDetail::SelectBoxKernelFor<1, 2>(level);
+    case 14: return ScaleDetail::SelectBoxKernelFor<1, 4>(level);
+    case 22: return ScaleDetail::SelectBoxKernelFor<2, 2>(level);
+    case 24: return ScaleDetail::SelectBoxKernelFor<2, 4>(level);
+    case 42: return ScaleDetail::SelectBoxKernelFor<4, 2>(level);
+    case 44: return ScaleDetail::SelectBoxKernelFor<4, 4>(level);
+    default: return nullptr;
+    }
+}
+
+inline ScaleVerticalKernel SelectVerticalKernel(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ScaleDetail::ScaleLevel(level))
+    {
+    case CpuLevel::Avx2: return ScaleDetail::VerticalAvx2;
+    case CpuLevel::Sse41: return ScaleDetail::VerticalSse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return ScaleDetail::VerticalScalar;
+}
+
+inline ScaleHorizontalKernel SelectHorizontalKernel(uint32_t channels, CpuLevel level)
+{
+    switch (channels)
+    {
+    case 1: return ScaleDetail::SelectHorizontalKernelFor<1>(level);
+    case 2: return ScaleDetail::SelectHorizontalKernelFor<2>(level);
+    case 4: return ScaleDetail::SelectHorizontalKernelFor<4>(level);
+    default: return nullptr;
+    }
+}
+
+//
+// 单个平面的缩小：通道数为1、2或4，目标不大于源
+//
+class PlaneScaler
+{
+public:
+    bool Configure(
+        uint32_t channels,
+        int32_t sourceWidth,
+        int32_t sourceHeight,
+        int32_t targetWidth,
+        int32_t targetHeight,
+        ScaleFilter filter,
+        CpuLevel level)
+    {
+        m_Valid = false;
+        if (targetWidth <= 0 || targetHeight <= 0 ||
+            targetWidth > sourceWidth || targetHeight > sourceHeight ||
+            SelectHorizontalKernel(channels, level) == nullptr)
+        {
+            return false;
+        }
+
+        m_Channels = channels;
+        m_SourceWidth = sourceWidth;
+        m_SourceHeight = sourceHeight;
+        m_TargetWidth = targetWidth;
+        m_TargetHeight = targetHeight;
+
+        // 盒式且两个方向同为2倍或4倍时走整数倍内核
+        m_BoxFactor = 0;
+        m_Box = nullptr;
+        if (filter == ScaleFilter::Box)
+        {
+            for (uint32_t factor : { 2u, 4u })
+            {
+                if (sourceWidth == targetWidth * (int32_t)factor && sourceHeight == targetHeight * (int32_t)factor)
+                {
+                    m_BoxFactor = factor;
+                    m_Box = SelectBoxKernel(channels, factor, level);
+                }
+            }
+        }
+
+        if (m_BoxFactor == 0)
+        {
+            if (!m_Horizontal.Build(sourceWidth, targetWidth, filter, channels) ||
+                !m_Vertical.Build(sourceHeight, targetHeight, filter, channels))
+            {
+                return false;
+            }
+
+            // 横向内核按块读取，合成行末尾留出一整段权重宽度
+            m_Row.assign(((size_t)sourceWidth + m_Horizontal.Chunks() * 16 + 16) * channels, 0);
+            m_Rows.resize(m_Vertical.MaxCount());
+            m_VerticalKernel = SelectVerticalKernel(level);
+            m_HorizontalKernel = SelectHorizontalKernel(channels, level);
+        }
+        else
+        {
+            m_Rows.resize(m_BoxFactor);
+        }
+
+        m_Valid = true;
+        return true;
+    }
+
+    bool IsValid() const
+    {
+        return m_Valid;
+    }
+
+    uint32_t BoxFactor() const
+    {
+        return m_BoxFactor;
+    }
+
+    //
+    // 源区域（平面坐标）影响的目标区域
+    //
+    FrameRect MapRect(const FrameRect& sourceRect) const
+    {
+        FrameRect rect = IntersectRect(sourceRect, { 0, 0, m_SourceWidth, m_SourceHeight });
+        if (!m_Valid || rect.IsEmpty())
+        {
+            return { 0, 0, 0, 0 };
+        }
+
+        if (m_BoxFactor != 0)
+        {
+            const int32_t f = (int32_t)m_BoxFactor;
+            return { rect.Left / f, rect.Top / f, (rect.Right + f - 1) / f, (rect.Bottom + f - 1) / f };
+        }
+
+        FrameRect target;
+        m_Horizontal.MapSpan(rect.Left, rect.Right, target.Left, target.Right);
+        m_Vertical.MapSpan(rect.Top, rect.Bottom, target.Top, target.Bottom);
+        return target.IsEmpty() ? FrameRect{ 0, 0, 0, 0 } : target;
+    }
+
+    //
+    // 重新计算目标区域targetRect（目标坐标）
+    //
+    void Scale(
+        const uint8_t* source,
+        size_t sourcePitch,
+        uint8_t* target,
+        size_t targetPitch,
+        const FrameRect& targetRect)
+    {
+        const FrameRect rect = IntersectRect(targetRect, { 0, 0, m_TargetWidth, m_TargetHeight });
+        if (!m_Valid || rect.IsEmpty())
+        {
+            return;
+        }
+
+        if (m_BoxFactor != 0)
+        {
+            for (int32_t y = rect.Top; y < rect.Bottom; y++)
+            {
+                for (uint32_t r = 0; r < m_BoxFactor; r++)
+                {
+                    m_Rows[r] = source + ((size_t)y * m_BoxFactor + r) * sourcePitch;
+                }
+                m_Box(m_Rows.data(), target + (size_t)y * targetPitch, (uint32_t)rect.Left, (uint32_t)rect.Right);
+            }
+            return;
+        }
+
+        // 纵向只合成目标列区间需要的源列
+        int32_t sourceBegin, sourceEnd;
+        m_Horizontal.SourceSpan(rect.Left, rect.Right, sourceBegin, sourceEnd);
+        const uint32_t columnBegin = (uint32_t)sourceBegin * m_Channels;
+        const uint32_t columnEnd = (uint32_t)sourceEnd * m_Channels;
+
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            const int32_t start = m_Vertical.Start(y);
+            const uint32_t taps = m_Vertical.Count(y);
+            for (uint32_t k = 0; k < taps; k++)
+            {
+                m_Rows[k] = source + (size_t)(start + (int32_t)k) * sourcePitch;
+            }
+
+            m_VerticalKernel(m_Rows.data(), m_Vertical.Weights(y), taps, columnBegin, columnEnd, m_Row.data());
+            m_HorizontalKernel(m_Row.data(), m_Horizontal, rect.Left, rect.Right, target + (size_t)y * targetPitch);
+        }
+    }
+
+private:
+    bool m_Valid = false;
+    uint32_t m_Channels = 0;
+    int32_t m_SourceWidth = 0;
+    int32_t m_SourceHeight = 0;
+    int32_t m_TargetWidth = 0;
+    int32_t m_TargetHeight = 0;
+    uint32_t m_BoxFactor = 0;
+    ScaleBoxKernel m_Box = nullptr;
+    ScaleCoefficients m_Horizontal;
+    ScaleCoefficients m_Vertical;
+    ScaleVerticalKernel m_VerticalKernel = nullptr;
+    ScaleHorizontalKernel m_HorizontalKernel = nullptr;
+    std::vector<uint8_t> m_Row;                 // 纵向合成后的一行
+    std::vector<const uint8_t*> m_Rows;         // 当前输出行用到的源行
+};
+
+//
+// BGRA8或NV12图像缩小。目标图像可以常驻：Scale只重新计算源损伤区域影响的部分
+//
+class Downscaler
+{
+public:
+    //
+    // NV12要求源与目标宽高均为偶数；目标不得大于源
+    //
+    bool Configure(
+        PixelFormat format,
+        int32_t sourceWidth,
+        int32_t sourceHeight,
+        int32_t targetWidth,
+        int32_t targetHeight,
+        ScaleFilter filter,
+        CpuLevel level = DetectCpuLevel())
+    {
+        m_Format = PixelFormat::Unknown;
+        bool configured = false;
+        if (format == PixelFormat::Bgra8)
+        {
+            configured = m_Luma.Configure(4, sourceWidth, sourceHeight, targetWidth, targetHeight, filter, level);
+        }
+        else if (format == PixelFormat::Nv12 &&
+            ((sourceWidth | sourceHeight | targetWidth | targetHeight) & 1) == 0)
+        {
+            configured =
+                m_Luma.Configure(1, sourceWidth, sourceHeight, targetWidth, targetHeight, filter, level) &&
+                m_Chroma.Configure(2, sourceWidth / 2, sourceHeight / 2, targetWidth / 2, targetHeight / 2, filter, level);
+        }
+
+        if (!configured)
+        {
+            return false;
+        }
+
+        m_Format = format;
+        m_Filter = filter;
+        m_Level = ScaleDetail::ScaleLevel(level);
+        m_SourceWidth = sourceWidth;
+        m_SourceHeight = sourceHeight;
+        m_TargetWidth = targetWidth;
+        m_TargetHeight = targetHeight;
+        return true;
+    }
+
+    bool IsValid() const
+    {
+        return m_Format != PixelFormat::Unknown;
+    }
+
+    PixelFormat Format() const
+    {
+        return m_Format;
+    }
+
+    ScaleFilter Filter() const
+    {
+        return m_Filter;
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    int32_t TargetWidth() const
+    {
+        return m_TargetWidth;
+    }
+
+    int32_t TargetHeight() const
+    {
+        return m_TargetHeight;
+    }
+
+    //
+    // 源损伤区域影响的目标区域（NV12时按色度对齐）
+    //
+    FrameRect MapRect(const FrameRect& sourceRect) const
+    {
+        if (m_Format == PixelFormat::Bgra8)
+        {
+            return m_Luma.MapRect(sourceRect);
+        }
+
+        if (m_Format != PixelFormat::Nv12)
+        {
+            return { 0, 0, 0, 0 };
+        }
+
+        const FrameRect aligned = AlignToChroma(sourceRect, m_SourceWidth, m_SourceHeight);
+        const FrameRect chroma = m_Chroma.MapRect({ aligned.Left / 2, aligned.Top / 2, aligned.Right / 2, aligned.Bottom / 2 });
+        const FrameRect luma = m_Luma.MapRect(aligned);
+        return AlignToChroma(
+            UnionRect(luma, { chroma.Left * 2, chroma.Top * 2, chroma.Right * 2, chroma.Bottom * 2 }),
+            m_TargetWidth,
+            m_TargetHeight);
+    }
+
+    //
+    // 按源损伤区域更新BGRA目标，返回更新的目标区域
+    //
+    FrameRect ScaleBgra(
+        const uint8_t* source,
+        size_t sourcePitch,
+        uint8_t* target,
+        size_t targetPitch,
+        const FrameRect& sourceRect)
+    {
+        if (m_Format != PixelFormat::Bgra8)
+        {
+            return { 0, 0, 0, 0 };
+        }
+
+        const FrameRect targetRect = m_Luma.MapRect(sourceRect);
+        m_Luma.Scale(source, sourcePitch, target, targetPitch, targetRect);
+        return targetRect;
+    }
+
+    //
+    // 按源损伤区域更新NV12目标，返回更新的目标区域（按色度对齐）
+    //
+    FrameRect ScaleNv12(
+        const Nv12Surface& source,
+        const Nv12Surface& target,
+        const FrameRect& sourceRect)
+    {
+        if (m_Format != PixelFormat::Nv12)
+        {
+            return { 0, 0, 0, 0 };
+        }
+
+        // 两个平面都重新计算合并后的区域，保证返回的区域内Y与UV一致
+        const FrameRect targetRect = MapRect(sourceRect);
+        if (targetRect.IsEmpty())
+        {
+            return targetRect;
+        }
+
+        m_Luma.Scale(source.Y, source.YPitch, target.Y, target.YPitch, targetRect);
+        m_Chroma.Scale(source.UV, source.UVPitch, target.UV, target.UVPitch,
+            { targetRect.Left / 2, targetRect.Top / 2, targetRect.Right / 2, targetRect.Bottom / 2 });
+        return targetRect;
+    }
+
+    void ScaleBgraFrame(const uint8_t* source, size_t sourcePitch, uint8_t* target, size_t targetPitch)
+    {
+        ScaleBgra(source, sourcePitch, target, targetPitch, { 0, 0, m_SourceWidth, m_SourceHeight });
+    }
+
+    void ScaleNv12Frame(const Nv12Surface& source, const Nv12Surface& target)
+    {
+        ScaleNv12(source, target, { 0, 0, m_SourceWidth, m_SourceHeight });
+    }
+
+private:
+    PixelFormat m_Format = PixelFormat::Unknown;
+    ScaleFilter m_Filter = ScaleFilter::Box;
+    CpuLevel m_Level = CpuLevel::Scalar;
+    int32_t m_SourceWidth = 0;
+    int32_t m_SourceHeight = 0;
+    int32_t m_TargetWidth = 0;
+    int32_t m_TargetHeight = 0;
+    PlaneScaler m_Luma;             // BGRA时为唯一平面
+    PlaneScaler m_Chroma;           // NV12的UV平面
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
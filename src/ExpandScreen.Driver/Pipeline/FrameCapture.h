@@ -0,0 +1,764 @@
+/*++
+
+Module Name:
+    FrameCapture.h
+
+Abstract:
+    帧录制文件：驱动把获取到的每次提交（像素、脏矩形、移动区域、时间戳）与光标
+    事件追加到一个内存映射的录制文件，Linux上的回放工具把它重新送进同一套可移植
+    帧处理模块（见ExpandScreen.Driver.Tests/Replay），按原速或最快速度回放并输出
+    各阶段耗时，便于在构建机上二分定位性能回退。
+
+    布局（偏移相对文件起始，索引与数据区按页对齐）：
+        [FrameCaptureHeader][索引：CaptureIndexEntry x MaxRecords][数据区]
+
+    写入者以原子加预留索引项与数据区空间，写完后把索引项状态置为已提交，因此帧
+    处理线程与光标线程可以并发追加，写入中途进程终止也只会留下未提交的索引项。
+    空间用完后的记录直接丢弃并计数，录制不会阻塞帧处理。
+
+    帧记录只保存相对上一次提交变化的像素：补丁为脏矩形与移动区域目标（裁剪到帧内），
+    按块用LosslessCodec.h无损压缩。第一帧、尺寸变化、IddCx未给出损伤区域以及上一帧
+    记录被丢弃之后写关键帧（整帧补丁）。回放时按顺序把补丁贴到上一帧的图像上即可
+    逐像素还原每次提交。
+
+    录制文件来自磁盘，读取者对全部偏移与长度做边界检查，无效记录读取失败。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CursorChannel.h"
+#include "FrameTypes.h"
+#include "LosslessCodec.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+constexpr uint32_t FrameCaptureMagic = 0x43465345;      // 'ESFC'
+constexpr uint32_t FrameCaptureVersion = 1;
+constexpr uint64_t FrameCapturePageSize = 4096;
+constexpr uint64_t FrameCaptureRecordAlignment = 16;
+constexpr int32_t FrameCapturePatchTile = 256;           // 补丁按此大小分块压缩，块越小越能跳过平坦区域
+constexpr uint32_t FrameCaptureMaxDimension = 16384;     // 读取时接受的最大帧宽高
+
+enum class CaptureRecordType : uint32_t
+{
+    Frame = 1,
+    Cursor = 2
+};
+
+// CaptureIndexEntry::State
+constexpr uint32_t CaptureRecordPending = 0;            // 已预留，写入中（或写入时进程终止）
+constexpr uint32_t CaptureRecordCommitted = 1;
+constexpr uint32_t CaptureRecordDropped = 2;            // 数据区不足，未写入
+
+// CaptureFrameRecord::Flags
+constexpr uint32_t CaptureFrameKeyframe = 0x1;          // 补丁覆盖整帧，不依赖之前的记录
+constexpr uint32_t CaptureFrameDamageUnknown = 0x2;     // IddCx未给出损伤区域，驱动按整帧处理
+
+enum class CapturePatchEncoding : uint32_t
+{
+    Raw = 0,            // 逐行BGRA
+    Lossless = 1        // LosslessTileEncoder的一个瓦片
+};
+
+//
+// 文件头（第一页）
+//
+struct FrameCaptureHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t MaxRecords;
+    uint32_t Reserved0;
+    uint64_t IndexOffset;
+    uint64_t DataOffset;
+    uint64_t Capacity;                              // 格式化时的文件大小
+    int64_t TicksPerSecond;                         // 记录中时间戳的频率（QPC）
+    uint32_t RefreshNumerator;                      // 录制时已提交模式的刷新率，0表示未知
+    uint32_t RefreshDenominator;
+    uint64_t Reserved[2];
+
+    alignas(64) std::atomic<uint64_t> RecordCount;  // 已预留的索引项数（可能超过MaxRecords）
+    std::atomic<uint64_t> DataUsed;                 // 已预留的数据区字节数
+    std::atomic<uint64_t> DroppedRecords;           // 空间不足丢弃的记录数
+};
+
+//
+// 索引项，按预留顺序排列
+//
+struct CaptureIndexEntry
+{
+    std::atomic<uint32_t> State;                    // CaptureRecord*
+    CaptureRecordType Type;
+    int64_t Time;                                   // 帧为获取缓冲区的时间，光标事件为事件时间（QPC）
+    uint64_t Offset;                                // 记录数据相对文件起始的偏移
+    uint64_t Size;
+};
+
+static_assert(sizeof(CaptureIndexEntry) == 32, "索引项布局固定为32字节");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+    "录制文件要求原子操作无锁，才能直接放在映射内存中");
+
+//
+// 帧记录，其后依次为FrameRect[DirtyRectCount]、FrameMoveRegion[MoveRegionCount]、
+// PatchCount个[CapturePatchHeader][数据]
+//
+struct CaptureFrameRecord
+{
+    uint32_t Width;
+    uint32_t Height;
+    int64_t PresentTime;                            // DWM提交时间（QPC），IddCx未给出时为获取时间
+    int64_t AcquireTime;
+    uint64_t PresentFrameNumber;
+    uint32_t Flags;                                 // CaptureFrame*
+    uint32_t DirtyRectCount;                        // IddCx原始脏矩形
+    uint32_t MoveRegionCount;                       // 裁剪后的移动区域
+    uint32_t PatchCount;
+};
+
+struct CapturePatchHeader
+{
+    FrameRect Rect;
+    CapturePatchEncoding Encoding;
+    uint32_t Size;                                  // 其后数据的字节数
+};
+
+//
+// 布局计算
+//
+struct FrameCaptureLayout
+{
+    static uint64_t AlignToPage(uint64_t value)
+    {
+        return (value + FrameCapturePageSize - 1) & ~(FrameCapturePageSize - 1);
+    }
+
+    static uint64_t IndexOffset()
+    {
+        return AlignToPage(sizeof(FrameCaptureHeader));
+    }
+
+    static uint64_t DataOffset(uint32_t maxRecords)
+    {
+        return AlignToPage(IndexOffset() + (uint64_t)maxRecords * sizeof(CaptureIndexEntry));
+    }
+
+    //
+    // 按文件大小取的默认索引容量：平均每页数据一项，足够容纳光标事件与小的增量帧
+    //
+    static uint32_t DefaultMaxRecords(uint64_t size)
+    {
+        const uint64_t records = size / FrameCapturePageSize;
+        return records < 256 ? 256 : (records > (1u << 24) ? (1u << 24) : (uint32_t)records);
+    }
+};
+
+//
+// 录制统计（只统计帧，由帧处理线程更新）
+//
+struct FrameCaptureStats
+{
+    uint64_t Frames = 0;            // 写入的帧记录数
+    uint64_t Keyframes = 0;
+    uint64_t DroppedFrames = 0;     // 空间不足丢弃的帧记录数
+    uint64_t PatchPixelBytes = 0;   // 补丁的原始BGRA字节数
+    uint64_t StoredBytes = 0;       // 帧记录实际占用的字节数
+};
+
+//
+// 录制写入者。WriteFrame只能由一个线程调用；WriteCursor只使用文件内的原子计数，
+// 可以在其他线程与之并发调用
+//
+class FrameCaptureWriter
+{
+public:
+    //
+    // 在新映射的文件上格式化，maxRecords为0时按文件大小取默认值
+    //
+    static bool Format(
+        void* memory,
+        uint64_t size,
+        uint32_t maxRecords,
+        int64_t ticksPerSecond,
+        uint32_t refreshNumerator,
+        uint32_t refreshDenominator)
+    {
+        if (maxRecords == 0)
+        {
+            maxRecords = FrameCaptureLayout::DefaultMaxRecords(size);
+        }
+        if (memory == nullptr || FrameCaptureLayout::DataOffset(maxRecords) >= size)
+        {
+            return false;
+        }
+
+        std::memset(memory, 0, (size_t)FrameCaptureLayout::DataOffset(maxRecords));
+
+        FrameCaptureHeader* header = static_cast<FrameCaptureHeader*>(memory);
+        header->Version = FrameCaptureVersion;
+        header->MaxRecords = maxRecords;
+        header->IndexOffset = FrameCaptureLayout::IndexOffset();
+        header->DataOffset = FrameCaptureLayout::DataOffset(maxRecords);
+        header->Capacity = size;
+        header->TicksPerSecond = ticksPerSecond;
+        header->RefreshNumerator = refreshNumerator;
+        header->RefreshDenominator = refreshDenominator;
+        header->RecordCount.store(0, std::memory_order_relaxed);
+        header->DataUsed.store(0, std::memory_order_relaxed);
+        header->DroppedRecords.store(0, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        header->Magic = FrameCaptureMagic;
+        return true;
+    }
+
+    bool Attach(void* memory, uint64_t size)
+    {
+        const FrameCaptureHeader* header = static_cast<const FrameCaptureHeader*>(memory);
+        if (memory == nullptr || size < FrameCaptureLayout::IndexOffset() ||
+            header->Magic != FrameCaptureMagic || header->Version != FrameCaptureVersion ||
+            header->DataOffset != FrameCaptureLayout::DataOffset(header->MaxRecords) ||
+            header->DataOffset >= size)
+        {
+            Detach();
+            return false;
+        }
+
+        m_Base = static_cast<uint8_t*>(memory);
+        m_Size = size;
+        m_NeedKeyframe = true;
+        return true;
+    }
+
+    void Detach()
+    {
+        m_Base = nullptr;
+        m_Size = 0;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Base != nullptr;
+    }
+
+    void SetEncoding(CapturePatchEncoding encoding)
+    {
+        m_Encoding = encoding;
+    }
+
+    const FrameCaptureStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 调用者漏记了一次提交（例如读回像素失败），下一帧写关键帧
+    //
+    void RequestKeyframe()
+    {
+        m_NeedKeyframe = true;
+    }
+
+    //
+    // 文件中有效内容的长度（关闭前可据此截断文件）
+    //
+    uint64_t UsedSize() const
+    {
+        if (!IsAttached())
+        {
+            return 0;
+        }
+        const uint64_t used = Header()->DataOffset + Header()->DataUsed.load(std::memory_order_acquire);
+        return used < m_Size ? used : m_Size;
+    }
+
+    uint64_t DroppedRecords() const
+    {
+        return IsAttached() ? Header()->DroppedRecords.load(std::memory_order_relaxed) : 0;
+    }
+
+    //
+    // 记录一次提交。frame的Flags、DirtyRectCount、MoveRegionCount与PatchCount由本函数
+    // 填写；damageKnown为false时dirty与moves被忽略，写整帧。bgra为提交的完整图像
+    //
+    bool WriteFrame(
+        const CaptureFrameRecord& frame,
+        const uint8_t* bgra,
+        size_t pitch,
+        const FrameRect* dirty,
+        uint32_t dirtyCount,
+        const FrameMoveRegion* moves,
+        uint32_t moveCount,
+        bool damageKnown)
+    {
+        if (!IsAttached() || frame.Width == 0 || frame.Height == 0)
+        {
+            return false;
+        }
+
+        const int32_t width = (int32_t)frame.Width;
+        const int32_t height = (int32_t)frame.Height;
+        const FrameRect bounds = { 0, 0, width, height };
+
+        CaptureFrameRecord record = frame;
+        record.Flags = 0;
+        if (!damageKnown)
+        {
+            dirtyCount = 0;
+            moveCount = 0;
+            record.Flags |= CaptureFrameDamageUnknown;
+        }
+        if (!damageKnown || m_NeedKeyframe || frame.Width != m_Width || frame.Height != m_Height)
+        {
+            record.Flags |= CaptureFrameKeyframe;
+        }
+        record.DirtyRectCount = dirtyCount;
+        record.MoveRegionCount = moveCount;
+
+        // 补丁：关键帧为整帧，否则为脏矩形与移动区域目标，按块切分后编码
+        m_Patches.clear();
+        if (record.Flags & CaptureFrameKeyframe)
+        {
+            AddPatch(bounds);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < dirtyCount; i++)
+            {
+                AddPatch(IntersectRect(dirty[i], bounds));
+            }
+            for (uint32_t i = 0; i < moveCount; i++)
+            {
+                AddPatch(IntersectRect(moves[i].Destination, bounds));
+            }
+        }
+
+        m_Payload.clear();
+        uint64_t pixelBytes = 0;
+        for (const FrameRect& rect : m_Patches)
+        {
+            const size_t headerAt = m_Payload.size();
+            m_Payload.resize(headerAt + sizeof(CapturePatchHeader));
+
+            CapturePatchHeader patch = {};
+            patch.Rect = rect;
+            patch.Encoding = m_Encoding;
+            if (m_Encoding == CapturePatchEncoding::Lossless)
+            {
+                patch.Size = (uint32_t)m_Encoder.Encode(bgra, pitch, rect, m_Payload);
+            }
+            else
+            {
+                const size_t rowBytes = (size_t)rect.Width() * 4;
+                const size_t dataAt = m_Payload.size();
+                m_Payload.resize(dataAt + rowBytes * rect.Height());
+                for (int32_t y = rect.Top; y < rect.Bottom; y++)
+                {
+                    std::memcpy(m_Payload.data() + dataAt + (size_t)(y - rect.Top) * rowBytes,
+                        bgra + (size_t)y * pitch + (size_t)rect.Left * 4, rowBytes);
+                }
+                patch.Size = (uint32_t)rowBytes * rect.Height();
+            }
+            std::memcpy(m_Payload.data() + headerAt, &patch, sizeof(patch));
+            pixelBytes += (uint64_t)rect.Area() * 4;
+        }
+        record.PatchCount = (uint32_t)m_Patches.size();
+
+        const uint64_t size = sizeof(record) +
+            (uint64_t)dirtyCount * sizeof(FrameRect) +
+            (uint64_t)moveCount * sizeof(FrameMoveRegion) +
+            m_Payload.size();
+
+        uint64_t slot;
+        uint8_t* out = Reserve(CaptureRecordType::Frame, frame.AcquireTime, size, slot);
+        if (out == nullptr)
+        {
+            // 之后的增量帧缺少基准，下一次重新写关键帧
+            m_NeedKeyframe = true;
+            m_Stats.DroppedFrames++;
+            return false;
+        }
+
+        std::memcpy(out, &record, sizeof(record));
+        out += sizeof(record);
+        if (dirtyCount != 0)
+        {
+            std::memcpy(out, dirty, (size_t)dirtyCount * sizeof(FrameRect));
+            out += (size_t)dirtyCount * sizeof(FrameRect);
+        }
+        if (moveCount != 0)
+        {
+            std::memcpy(out, moves, (size_t)moveCount * sizeof(FrameMoveRegion));
+            out += (size_t)moveCount * sizeof(FrameMoveRegion);
+        }
+        if (!m_Payload.empty())
+        {
+            std::memcpy(out, m_Payload.data(), m_Payload.size());
+        }
+        Commit(slot);
+
+        m_NeedKeyframe = false;
+        m_Width = frame.Width;
+        m_Height = frame.Height;
+        m_Stats.Frames++;
+        m_Stats.Keyframes += (record.Flags & CaptureFrameKeyframe) ? 1 : 0;
+        m_Stats.PatchPixelBytes += pixelBytes;
+        m_Stats.StoredBytes += size;
+        return true;
+    }
+
+    bool WriteCursor(const CursorEvent& event)
+    {
+        if (!IsAttached())
+        {
+            return false;
+        }
+
+        uint64_t slot;
+        uint8_t* out = Reserve(CaptureRecordType::Cursor, event.Time, sizeof(event), slot);
+        if (out == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(out, &event, sizeof(event));
+        Commit(slot);
+        return true;
+    }
+
+private:
+    FrameCaptureHeader* Header() const
+    {
+        return reinterpret_cast<FrameCaptureHeader*>(m_Base);
+    }
+
+    CaptureIndexEntry* Index() const
+    {
+        return reinterpret_cast<CaptureIndexEntry*>(m_Base + Header()->IndexOffset);
+    }
+
+    void AddPatch(const FrameRect& rect)
+    {
+        for (int32_t top = rect.Top; top < rect.Bottom; top += FrameCapturePatchTile)
+        {
+            for (int32_t left = rect.Left; left < rect.Right; left += FrameCapturePatchTile)
+            {
+                const FrameRect tile = {
+                    left,
+                    top,
+                    left + FrameCapturePatchTile < rect.Right ? left + FrameCapturePatchTile : rect.Right,
+                    top + FrameCapturePatchTile < rect.Bottom ? top + FrameCapturePatchTile : rect.Bottom
+                };
+                m_Patches.push_back(tile);
+            }
+        }
+    }
+
+    //
+    // 预留一个索引项与size字节的数据区，空间不足时返回nullptr并计入丢弃
+    //
+    uint8_t* Reserve(CaptureRecordType type, int64_t time, uint64_t size, uint64_t& slot)
+    {
+        FrameCaptureHeader* header = Header();
+        slot = header->RecordCount.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= header->MaxRecords)
+        {
+            header->DroppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        CaptureIndexEntry& entry = Index()[slot];
+        entry.Type = type;
+        entry.Time = time;
+        entry.Size = size;
+
+        const uint64_t aligned = (size + FrameCaptureRecordAlignment - 1) & ~(FrameCaptureRecordAlignment - 1);
+        const uint64_t offset = header->DataUsed.fetch_add(aligned, std::memory_order_relaxed);
+        if (offset + aligned > m_Size - header->DataOffset)
+        {
+            entry.Offset = 0;
+            entry.State.store(CaptureRecordDropped, std::memory_order_release);
+            header->DroppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        entry.Offset = header->DataOffset + offset;
+        return m_Base + entry.Offset;
+    }
+
+    void Commit(uint64_t slot)
+    {
+        Index()[slot].State.store(CaptureRecordCommitted, std::memory_order_release);
+    }
+
+    uint8_t* m_Base = nullptr;
+    uint64_t m_Size = 0;
+
+    CapturePatchEncoding m_Encoding = CapturePatchEncoding::Lossless;
+    LosslessTileEncoder m_Encoder;
+    std::vector<FrameRect> m_Patches;
+    std::vector<uint8_t> m_Payload;
+    bool m_NeedKeyframe = true;
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    FrameCaptureStats m_Stats;
+};
+
+//
+// 一条已提交的记录
+//
+struct CaptureRecordView
+{
+    CaptureRecordType Type;
+    int64_t Time;
+    const uint8_t* Data;
+    uint64_t Size;
+};
+
+//
+// 解析后的帧记录，指针指向映射的文件
+//
+struct CaptureFrameView
+{
+    CaptureFrameRecord Frame;
+    const FrameRect* DirtyRects;                    // 可能未对齐，只按字节拷贝读取
+    const FrameMoveRegion* MoveRegions;
+    const uint8_t* Patches;
+    uint64_t PatchBytes;
+};
+
+//
+// 录制读取者
+//
+class FrameCaptureReader
+{
+public:
+    bool Attach(const void* memory, uint64_t size)
+    {
+        m_Base = nullptr;
+        const FrameCaptureHeader* header = static_cast<const FrameCaptureHeader*>(memory);
+        if (memory == nullptr || size < FrameCaptureLayout::IndexOffset() ||
+            header->Magic != FrameCaptureMagic || header->Version != FrameCaptureVersion ||
+            header->MaxRecords == 0 ||
+            header->IndexOffset != FrameCaptureLayout::IndexOffset() ||
+            header->DataOffset != FrameCaptureLayout::DataOffset(header->MaxRecords) ||
+            header->DataOffset > size)
+        {
+            return false;
+        }
+
+        m_Base = static_cast<const uint8_t*>(memory);
+        m_Size = size;
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Base != nullptr;
+    }
+
+    const FrameCaptureHeader& Header() const
+    {
+        return *reinterpret_cast<const FrameCaptureHeader*>(m_Base);
+    }
+
+    //
+    // 索引项数（含未提交与丢弃的项）
+    //
+    uint32_t RecordCount() const
+    {
+        const uint64_t reserved = Header().RecordCount.load(std::memory_order_acquire);
+        return reserved < Header().MaxRecords ? (uint32_t)reserved : Header().MaxRecords;
+    }
+
+    //
+    // 读取第index条记录，未提交、被丢弃或越界时返回false
+    //
+    bool Record(uint32_t index, CaptureRecordView& record) const
+    {
+        if (index >= RecordCount())
+        {
+            return false;
+        }
+
+        const CaptureIndexEntry& entry =
+            reinterpret_cast<const CaptureIndexEntry*>(m_Base + Header().IndexOffset)[index];
+        if (entry.State.load(std::memory_order_acquire) != CaptureRecordCommitted ||
+            entry.Offset < Header().DataOffset || entry.Offset > m_Size || entry.Size > m_Size - entry.Offset)
+        {
+            return false;
+        }
+
+        record.Type = entry.Type;
+        record.Time = entry.Time;
+        record.Data = m_Base + entry.Offset;
+        record.Size = entry.Size;
+        return true;
+    }
+
+    static bool ParseFrame(const CaptureRecordView& record, CaptureFrameView& view)
+    {
+        if (record.Type != CaptureRecordType::Frame || record.Size < sizeof(CaptureFrameRecord))
+        {
+            return false;
+        }
+
+        std::memcpy(&view.Frame, record.Data, sizeof(view.Frame));
+        const uint64_t rects = (uint64_t)view.Frame.DirtyRectCount * sizeof(FrameRect) +
+            (uint64_t)view.Frame.MoveRegionCount * sizeof(FrameMoveRegion);
+        if (view.Frame.Width == 0 || view.Frame.Height == 0 ||
+            view.Frame.Width > FrameCaptureMaxDimension || view.Frame.Height > FrameCaptureMaxDimension ||
+            rects > record.Size - sizeof(CaptureFrameRecord))
+        {
+            return false;
+        }
+
+        const uint8_t* cursor = record.Data + sizeof(CaptureFrameRecord);
+        view.DirtyRects = reinterpret_cast<const FrameRect*>(cursor);
+        cursor += (size_t)view.Frame.DirtyRectCount * sizeof(FrameRect);
+        view.MoveRegions = reinterpret_cast<const FrameMoveRegion*>(cursor);
+        cursor += (size_t)view.Frame.MoveRegionCount * sizeof(FrameMoveRegion);
+        view.Patches = cursor;
+        view.PatchBytes = record.Size - sizeof(CaptureFrameRecord) - rects;
+        return true;
+    }
+
+    static bool ParseCursor(const CaptureRecordView& record, CursorEvent& event)
+    {
+        if (record.Type != CaptureRecordType::Cursor || record.Size != sizeof(CursorEvent))
+        {
+            return false;
+        }
+        std::memcpy(&event, record.Data, sizeof(event));
+        return true;
+    }
+
+private:
+    const uint8_t* m_Base = nullptr;
+    uint64_t m_Size = 0;
+};
+
+//
+// 按记录顺序还原每次提交的完整BGRA图像（紧凑行距）
+//
+class CaptureFrameCanvas
+{
+public:
+    int32_t Width() const
+    {
+        return m_Width;
+    }
+
+    int32_t Height() const
+    {
+        return m_Height;
+    }
+
+    size_t Pitch() const
+    {
+        return (size_t)m_Width * 4;
+    }
+
+    const uint8_t* Pixels() const
+    {
+        return m_Pixels.data();
+    }
+
+    void Reset()
+    {
+        m_Width = 0;
+        m_Height = 0;
+    }
+
+    //
+    // 把一帧的补丁贴到当前图像上。非关键帧要求尺寸与当前图像一致；
+    // 数据无效时返回false，图像作废，直到下一个关键帧
+    //
+    bool Apply(const CaptureFrameView& view)
+    {
+        const int32_t width = (int32_t)view.Frame.Width;
+        const int32_t height = (int32_t)view.Frame.Height;
+
+        if (view.Frame.Flags & CaptureFrameKeyframe)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_Pixels.assign((size_t)width * height * 4, 0);
+        }
+        else if (width != m_Width || height != m_Height)
+        {
+            Reset();
+            return false;
+        }
+
+        const uint8_t* in = view.Patches;
+        const uint8_t* end = view.Patches + view.PatchBytes;
+        for (uint32_t i = 0; i < view.Frame.PatchCount; i++)
+        {
+            CapturePatchHeader patch;
+            if ((size_t)(end - in) < sizeof(patch))
+            {
+                Reset();
+                return false;
+            }
+            std::memcpy(&patch, in, sizeof(patch));
+            in += sizeof(patch);
+
+            const FrameRect& rect = patch.Rect;
+            if (patch.Size > (size_t)(end - in) || rect.IsEmpty() ||
+                rect.Left < 0 || rect.Top < 0 || rect.Right > width || rect.Bottom > height ||
+                !ApplyPatch(patch, in))
+            {
+                Reset();
+                return false;
+            }
+            in += patch.Size;
+        }
+        return true;
+    }
+
+private:
+    bool ApplyPatch(const CapturePatchHeader& patch, const uint8_t* data)
+    {
+        const FrameRect& rect = patch.Rect;
+        if (patch.Encoding == CapturePatchEncoding::Raw)
+        {
+            const size_t rowBytes = (size_t)rect.Width() * 4;
+            if (patch.Size != rowBytes * rect.Height())
+            {
+                return false;
+            }
+            for (int32_t y = rect.Top; y < rect.Bottom; y++)
+            {
+                std::memcpy(m_Pixels.data() + (size_t)y * Pitch() + (size_t)rect.Left * 4,
+                    data + (size_t)(y - rect.Top) * rowBytes, rowBytes);
+            }
+            return true;
+        }
+
+        LosslessTileMode mode;
+        int32_t tileWidth, tileHeight;
+        return patch.Encoding == CapturePatchEncoding::Lossless &&
+            LosslessTileDecoder::PeekHeader(data, patch.Size, mode, tileWidth, tileHeight) &&
+            tileWidth == rect.Width() && tileHeight == rect.Height() &&
+            m_Decoder.Decode(data, patch.Size, m_Pixels.data(), Pitch(), m_Width, m_Height, rect.Left, rect.Top) ==
+                patch.Size;
+    }
+
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    std::vector<uint8_t> m_Pixels;
+    LosslessTileDecoder m_Decoder;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
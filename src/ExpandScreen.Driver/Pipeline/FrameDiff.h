@@ -0,0 +1,481 @@
+/*++
+
+Module Name:
+    FrameDiff.h
+
+Abstract:
+    与上一发布帧逐像素比较，把保守的脏矩形收缩为实际变化像素的包围盒
+
+    IddCx上报的脏矩形偏保守：一行文字变化时常常上报整个窗口。每个监视器常驻
+    一份最后发布的BGRA内容（参考帧），在每个脏矩形内按行比较新画面与参考帧：
+    每行从左找第一个不同像素、从右找最后一个不同像素，中间部分不再读取；
+    连续的变化行合并为一个包围盒，未变化行超过合并间隔时另起一个包围盒。
+    比较结果精确，不存在哈希碰撞，代价是每监视器多一份BGRA帧的内存。
+
+    行比较内核按块异或后做一次全零测试，遇到不同的块才逐像素定位；
+    标量、SSE4.1、AVX2、AVX-512内核结果一致，运行时按CPU特性选择。
+
+    正确性约束：参考帧必须等于消费者当前持有的内容。移动区域先在参考帧上
+    按消费者的方式执行；脏信息未知时调用Reset，下一帧整帧视为变化。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "FrameTypes.h"
+#include "MoveRegion.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+namespace FrameDiffDetail {
+
+inline uint32_t Load32(const uint8_t* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t Load64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+//
+// 第一个不同像素的下标，全部相同时返回pixels
+//
+inline int32_t FirstDifferenceScalar(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = 0;
+    for (; i + 2 <= pixels; i += 2)
+    {
+        if (Load64(a + (size_t)i * 4) != Load64(b + (size_t)i * 4))
+        {
+            break;
+        }
+    }
+
+    for (; i < pixels; i++)
+    {
+        if (Load32(a + (size_t)i * 4) != Load32(b + (size_t)i * 4))
+        {
+            return i;
+        }
+    }
+    return pixels;
+}
+
+//
+// 最后一个不同像素的下标加一，全部相同时返回0
+//
+inline int32_t LastDifferenceScalar(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = pixels;
+    for (; i >= 2; i -= 2)
+    {
+        if (Load64(a + (size_t)(i - 2) * 4) != Load64(b + (size_t)(i - 2) * 4))
+        {
+            break;
+        }
+    }
+
+    for (; i > 0; i--)
+    {
+        if (Load32(a + (size_t)(i - 1) * 4) != Load32(b + (size_t)(i - 1) * 4))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+// 16像素（64字节）的块是否完全相同
+EXPANDSCREEN_TARGET_SSE41
+inline bool BlockEqualSse41(const uint8_t* a, const uint8_t* b)
+{
+    const __m128i* pa = reinterpret_cast<const __m128i*>(a);
+    const __m128i* pb = reinterpret_cast<const __m128i*>(b);
+    const __m128i d0 = _mm_xor_si128(_mm_loadu_si128(pa), _mm_loadu_si128(pb));
+    const __m128i d1 = _mm_xor_si128(_mm_loadu_si128(pa + 1), _mm_loadu_si128(pb + 1));
+    const __m128i d2 = _mm_xor_si128(_mm_loadu_si128(pa + 2), _mm_loadu_si128(pb + 2));
+    const __m128i d3 = _mm_xor_si128(_mm_loadu_si128(pa + 3), _mm_loadu_si128(pb + 3));
+    const __m128i d = _mm_or_si128(_mm_or_si128(d0, d1), _mm_or_si128(d2, d3));
+    return _mm_testz_si128(d, d) != 0;
+}
+
+// 找到第一个不同的块后由标量代码在块内定位，行尾不足一块的部分同样交给标量
+EXPANDSCREEN_TARGET_SSE41
+inline int32_t FirstDifferenceSse41(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        if (!BlockEqualSse41(a + (size_t)i * 4, b + (size_t)i * 4))
+        {
+            break;
+        }
+    }
+
+    return i + FirstDifferenceScalar(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline int32_t LastDifferenceSse41(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = pixels;
+    for (; i >= 16; i -= 16)
+    {
+        if (!BlockEqualSse41(a + (size_t)(i - 16) * 4, b + (size_t)(i - 16) * 4))
+        {
+            break;
+        }
+    }
+
+    return LastDifferenceScalar(a, b, i);
+}
+
+// 32像素（128字节）的块是否完全相同
+EXPANDSCREEN_TARGET_AVX2
+inline bool BlockEqualAvx2(const uint8_t* a, const uint8_t* b)
+{
+    const __m256i* pa = reinterpret_cast<const __m256i*>(a);
+    const __m256i* pb = reinterpret_cast<const __m256i*>(b);
+    const __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256(pa), _mm256_loadu_si256(pb));
+    const __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256(pa + 1), _mm256_loadu_si256(pb + 1));
+    const __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256(pa + 2), _mm256_loadu_si256(pb + 2));
+    const __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256(pa + 3), _mm256_loadu_si256(pb + 3));
+    const __m256i d = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+    return _mm256_testz_si256(d, d) != 0;
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline int32_t FirstDifferenceAvx2(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = 0;
+    for (; i + 32 <= pixels; i += 32)
+    {
+        if (!BlockEqualAvx2(a + (size_t)i * 4, b + (size_t)i * 4))
+        {
+            break;
+        }
+    }
+
+    return i + FirstDifferenceSse41(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i);
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline int32_t LastDifferenceAvx2(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = pixels;
+    for (; i >= 32; i -= 32)
+    {
+        if (!BlockEqualAvx2(a + (size_t)(i - 32) * 4, b + (size_t)(i - 32) * 4))
+        {
+            break;
+        }
+    }
+
+    return LastDifferenceSse41(a, b, i);
+}
+
+EXPANDSCREEN_AVX512_BEGIN
+
+// 64像素（256字节）的块是否完全相同
+EXPANDSCREEN_TARGET_AVX512
+inline bool BlockEqualAvx512(const uint8_t* a, const uint8_t* b)
+{
+    const __m512i d0 = _mm512_xor_si512(_mm512_loadu_si512(a), _mm512_loadu_si512(b));
+    const __m512i d1 = _mm512_xor_si512(_mm512_loadu_si512(a + 64), _mm512_loadu_si512(b + 64));
+    const __m512i d2 = _mm512_xor_si512(_mm512_loadu_si512(a + 128), _mm512_loadu_si512(b + 128));
+    const __m512i d3 = _mm512_xor_si512(_mm512_loadu_si512(a + 192), _mm512_loadu_si512(b + 192));
+    const __m512i d = _mm512_or_si512(_mm512_or_si512(d0, d1), _mm512_or_si512(d2, d3));
+    return _mm512_test_epi64_mask(d, d) == 0;
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline int32_t FirstDifferenceAvx512(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = 0;
+    for (; i + 64 <= pixels; i += 64)
+    {
+        if (!BlockEqualAvx512(a + (size_t)i * 4, b + (size_t)i * 4))
+        {
+            break;
+        }
+    }
+
+    return i + FirstDifferenceAvx2(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i);
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline int32_t LastDifferenceAvx512(const uint8_t* a, const uint8_t* b, int32_t pixels)
+{
+    int32_t i = pixels;
+    for (; i >= 64; i -= 64)
+    {
+        if (!BlockEqualAvx512(a + (size_t)(i - 64) * 4, b + (size_t)(i - 64) * 4))
+        {
+            break;
+        }
+    }
+
+    return LastDifferenceAvx2(a, b, i);
+}
+
+EXPANDSCREEN_AVX512_END
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+} // namespace FrameDiffDetail
+
+//
+// 在两行BGRA像素（各pixels个）中查找不同像素：
+// First返回第一个不同像素的下标（全同返回pixels），Last返回最后一个不同像素的下标加一（全同返回0）
+//
+using RowDifferenceFunction = int32_t (*)(const uint8_t* a, const uint8_t* b, int32_t pixels);
+
+inline RowDifferenceFunction SelectFirstDifference(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return FrameDiffDetail::FirstDifferenceAvx512;
+    case CpuLevel::Avx2: return FrameDiffDetail::FirstDifferenceAvx2;
+    case CpuLevel::Sse41: return FrameDiffDetail::FirstDifferenceSse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return FrameDiffDetail::FirstDifferenceScalar;
+}
+
+inline RowDifferenceFunction SelectLastDifference(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return FrameDiffDetail::LastDifferenceAvx512;
+    case CpuLevel::Avx2: return FrameDiffDetail::LastDifferenceAvx2;
+    case CpuLevel::Sse41: return FrameDiffDetail::LastDifferenceSse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return FrameDiffDetail::LastDifferenceScalar;
+}
+
+//
+// 单次比较统计
+//
+struct FrameDiffStats
+{
+    uint32_t ChangedRows = 0;       // 有像素变化的行数（按脏矩形分别计）
+    uint64_t ComparedBytes = 0;     // 实际读取比较的新画面字节数
+    int64_t InputArea = 0;          // 输入脏矩形面积之和（裁剪到帧内）
+    int64_t OutputArea = 0;         // 输出包围盒面积之和
+    bool FullFrame = false;         // 参考帧无效，输入原样输出
+};
+
+//
+// 每监视器的参考帧与逐像素比较（BGRA8像素）
+//
+class FrameDiffer
+{
+public:
+    static constexpr int32_t DefaultMergeGap = 16;
+    static constexpr uint32_t BytesPerPixel = 4;
+
+    //
+    // mergeGap：同一脏矩形内两段变化行之间的未变化行不超过该值时合并为一个包围盒
+    //
+    explicit FrameDiffer(int32_t mergeGap = DefaultMergeGap, CpuLevel level = DetectCpuLevel())
+        : m_MergeGap(mergeGap >= 0 ? mergeGap : DefaultMergeGap),
+          m_Level(ClampCpuLevel(level)),
+          m_First(SelectFirstDifference(level)),
+          m_Last(SelectLastDifference(level))
+    {
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    const FrameDiffStats& LastStats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 作废参考帧，下一次比较整帧视为变化
+    //
+    void Reset()
+    {
+        m_Valid = false;
+    }
+
+    //
+    // 先在参考帧上执行移动区域（需已裁剪到帧内），再在每个脏矩形内与新画面比较。
+    // 输出实际变化像素的包围盒（互不越出各自的输入矩形），参考帧随之更新为新画面，
+    // 返回输出矩形数。参考帧无效或尺寸变化时整帧拷贝，输入矩形原样输出
+    //
+    uint32_t Diff(
+        const uint8_t* pixels,
+        size_t pitch,
+        int32_t width,
+        int32_t height,
+        const FrameRect* dirtyRects,
+        uint32_t dirtyRectCount,
+        const FrameMoveRegion* moves,
+        uint32_t moveCount,
+        std::vector<FrameRect>& output)
+    {
+        output.clear();
+        m_Stats = FrameDiffStats();
+
+        if (width <= 0 || height <= 0)
+        {
+            return 0;
+        }
+
+        const FrameRect frame = { 0, 0, width, height };
+
+        if (!m_Valid || width != m_Width || height != m_Height)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_Pitch = (size_t)width * BytesPerPixel;
+            m_Reference.resize(m_Pitch * (size_t)height);
+            CopyToReference(pixels, pitch, frame);
+            m_Valid = true;
+
+            m_Stats.FullFrame = true;
+            for (uint32_t i = 0; i < dirtyRectCount; i++)
+            {
+                FrameRect rect = IntersectRect(dirtyRects[i], frame);
+                if (!rect.IsEmpty())
+                {
+                    output.push_back(rect);
+                    m_Stats.InputArea += rect.Area();
+                    m_Stats.OutputArea += rect.Area();
+                }
+            }
+            return (uint32_t)output.size();
+        }
+
+        ApplyMoveRegions(m_Reference.data(), (uint32_t)m_Pitch, BytesPerPixel, moves, moveCount, width, height);
+
+        for (uint32_t i = 0; i < dirtyRectCount; i++)
+        {
+            FrameRect rect = IntersectRect(dirtyRects[i], frame);
+            if (rect.IsEmpty())
+            {
+                continue;
+            }
+
+            m_Stats.InputArea += rect.Area();
+            const size_t first = output.size();
+            DiffRect(pixels, pitch, rect, output);
+
+            // 包围盒之间互不重叠，逐个把新内容写回参考帧
+            for (size_t j = first; j < output.size(); j++)
+            {
+                CopyToReference(pixels, pitch, output[j]);
+                m_Stats.OutputArea += output[j].Area();
+            }
+        }
+
+        return (uint32_t)output.size();
+    }
+
+private:
+    void DiffRect(const uint8_t* pixels, size_t pitch, const FrameRect& rect, std::vector<FrameRect>& output)
+    {
+        const int32_t columns = rect.Width();
+        FrameRect box = {};
+        bool open = false;
+
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            const uint8_t* current = pixels + (size_t)y * pitch + (size_t)rect.Left * BytesPerPixel;
+            const uint8_t* reference = m_Reference.data() + (size_t)y * m_Pitch + (size_t)rect.Left * BytesPerPixel;
+
+            const int32_t left = m_First(current, reference, columns);
+            if (left == columns)
+            {
+                m_Stats.ComparedBytes += (uint64_t)columns * BytesPerPixel;
+                continue;
+            }
+
+            // 从右端向回找，只读到第一个不同像素为止
+            const size_t skip = (size_t)left * BytesPerPixel;
+            const int32_t right = left + m_Last(current + skip, reference + skip, columns - left);
+            const int32_t compared = left + 1 + columns - right + 1;
+            m_Stats.ComparedBytes += (uint64_t)(compared < columns ? compared : columns) * BytesPerPixel;
+            m_Stats.ChangedRows++;
+
+            if (open && y - box.Bottom > m_MergeGap)
+            {
+                output.push_back(box);
+                open = false;
+            }
+
+            if (!open)
+            {
+                box = { rect.Left + left, y, rect.Left + right, y + 1 };
+                open = true;
+                continue;
+            }
+
+            box.Left = rect.Left + left < box.Left ? rect.Left + left : box.Left;
+            box.Right = rect.Left + right > box.Right ? rect.Left + right : box.Right;
+            box.Bottom = y + 1;
+        }
+
+        if (open)
+        {
+            output.push_back(box);
+        }
+    }
+
+    void CopyToReference(const uint8_t* pixels, size_t pitch, const FrameRect& rect)
+    {
+        const size_t rowBytes = (size_t)rect.Width() * BytesPerPixel;
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            std::memcpy(m_Reference.data() + (size_t)y * m_Pitch + (size_t)rect.Left * BytesPerPixel,
+                pixels + (size_t)y * pitch + (size_t)rect.Left * BytesPerPixel, rowBytes);
+        }
+    }
+
+    int32_t m_MergeGap;
+    CpuLevel m_Level;
+    RowDifferenceFunction m_First;
+    RowDifferenceFunction m_Last;
+    FrameDiffStats m_Stats;
+
+    bool m_Valid = false;
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    size_t m_Pitch = 0;
+    std::vector<uint8_t> m_Reference;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,524 @@
+/*++
+
+Module Name:
+    FrameLatency.h
+
+Abstract:
+    端到端逐帧延迟打点与共享内存延迟统计
+
+    每帧携带一组时间戳（QPC）：DWM提交、驱动获取、驱动发布、用户态取出、
+    编码开始/结束、发送。前三个由驱动写入帧描述（FrameDescriptor），其余由用户态
+    在自己的FrameLatencyTracker记录上就地追加，不复制帧数据。
+
+    统计块（LatencyStatsBlock）是可放进共享内存的POD：每个相邻阶段区间与总延迟
+    各一个对数分桶直方图（每个2的幂区间16个子桶，相对误差不超过1/16），单写者在
+    seqlock保护下更新，读者复制快照后计算分位数。驱动在帧环头内维护一份，只含
+    提交->获取->发布；用户态可以在自己的共享内存中维护完整的一份。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 帧经过的阶段，按时间先后
+//
+enum class LatencyStage : uint32_t
+{
+    Present = 0,        // DWM提交（IddCx元数据中的PresentDisplayQPCTime）
+    Acquire,            // 驱动获取缓冲区
+    Publish,            // 驱动写入帧环
+    Consume,            // 用户态取出
+    EncodeStart,
+    EncodeEnd,
+    Send                // 离开主机
+};
+
+constexpr uint32_t LatencyStageCount = 7;
+
+inline const char* LatencyStageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+    case LatencyStage::Present: return "present";
+    case LatencyStage::Acquire: return "acquire";
+    case LatencyStage::Publish: return "publish";
+    case LatencyStage::Consume: return "consume";
+    case LatencyStage::EncodeStart: return "encode-start";
+    case LatencyStage::EncodeEnd: return "encode-end";
+    case LatencyStage::Send: return "send";
+    }
+    return "unknown";
+}
+
+//
+// 一帧的时间戳向量，0表示该阶段未打点
+//
+struct FrameTimestamps
+{
+    uint64_t FrameNumber;
+    int64_t Time[LatencyStageCount];
+
+    void Stamp(LatencyStage stage, int64_t time)
+    {
+        Time[(uint32_t)stage] = time;
+    }
+
+    int64_t Get(LatencyStage stage) const
+    {
+        return Time[(uint32_t)stage];
+    }
+};
+
+//
+// 对数分桶直方图（微秒）。小于16us的值各占一个桶，此后每个2的幂区间16个子桶，
+// 上限约67秒，超出的值计入最后一个桶
+//
+struct LatencyHistogram
+{
+    static constexpr uint32_t SubBucketBits = 4;
+    static constexpr uint32_t SubBuckets = 1u << SubBucketBits;
+    static constexpr uint32_t MaxExponent = 26;
+    static constexpr uint32_t BucketCount = (MaxExponent - SubBucketBits + 2) * SubBuckets;
+
+    uint64_t Count;
+    uint64_t SumUs;
+    uint64_t MaxUs;
+    uint32_t Buckets[BucketCount];
+
+    static uint32_t BucketOf(uint64_t us)
+    {
+        if (us < SubBuckets)
+        {
+            return (uint32_t)us;
+        }
+
+        // 最高置位的位置，二分查找
+        uint32_t exponent = 0;
+        for (uint32_t shift = 32; shift != 0; shift >>= 1)
+        {
+            if ((us >> (exponent + shift)) != 0)
+            {
+                exponent += shift;
+            }
+        }
+
+        if (exponent > MaxExponent)
+        {
+            return BucketCount - 1;
+        }
+
+        const uint32_t sub = (uint32_t)(us >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+        return (exponent - SubBucketBits + 1) * SubBuckets + sub;
+    }
+
+    //
+    // 桶内最大值（含）
+    //
+    static uint64_t BucketUpperBound(uint32_t bucket)
+    {
+        if (bucket < SubBuckets)
+        {
+            return bucket;
+        }
+
+        const uint32_t exponent = bucket / SubBuckets + SubBucketBits - 1;
+        const uint64_t sub = bucket % SubBuckets;
+        const uint64_t width = 1ull << (exponent - SubBucketBits);
+        return (1ull << exponent) + (sub + 1) * width - 1;
+    }
+
+    void Reset()
+    {
+        std::memset(this, 0, sizeof(*this));
+    }
+
+    void Record(uint64_t us)
+    {
+        Count++;
+        SumUs += us;
+        if (us > MaxUs)
+        {
+            MaxUs = us;
+        }
+        Buckets[BucketOf(us)]++;
+    }
+
+    //
+    // 第p百分位（0~100），返回所在桶的上界，不超过最大值；无样本时为0
+    //
+    uint64_t PercentileUs(double p) const
+    {
+        if (Count == 0)
+        {
+            return 0;
+        }
+
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)Count + 0.5);
+        if (rank < 1)
+        {
+            rank = 1;
+        }
+        if (rank > Count)
+        {
+            rank = Count;
+        }
+
+        uint64_t seen = 0;
+        for (uint32_t bucket = 0; bucket < BucketCount; bucket++)
+        {
+            seen += Buckets[bucket];
+            if (seen >= rank)
+            {
+                const uint64_t bound = BucketUpperBound(bucket);
+                return bound < MaxUs ? bound : MaxUs;
+            }
+        }
+
+        return MaxUs;
+    }
+
+    uint64_t MeanUs() const
+    {
+        return Count != 0 ? SumUs / Count : 0;
+    }
+};
+
+//
+// LatencyStatsBlock::Intervals的下标：0为总延迟（提交到最后一个已打点阶段），
+// i（i>=1）为阶段i-1到阶段i
+//
+constexpr uint32_t LatencyTotalInterval = 0;
+
+inline uint32_t LatencyIntervalOf(LatencyStage stage)
+{
+    return (uint32_t)stage;
+}
+
+inline const char* LatencyIntervalName(uint32_t interval)
+{
+    static const char* const names[LatencyStageCount] =
+    {
+        "total", "present->acquire", "acquire->publish", "publish->consume",
+        "consume->encode", "encode", "encode->send"
+    };
+    return interval < LatencyStageCount ? names[interval] : "unknown";
+}
+
+constexpr uint32_t LatencyStatsMagic = 0x4C545345;     // 'ESTL'
+constexpr uint32_t LatencyStatsVersion = 1;
+
+//
+// 共享内存延迟统计块，单写者
+//
+struct LatencyStatsBlock
+{
+    uint32_t Magic;
+    uint32_t Version;
+    int64_t TicksPerSecond;
+
+    alignas(64) std::atomic<uint64_t> Sequence;     // 偶数=稳定，奇数=写入中
+    uint64_t Frames;                                // 计入统计的帧数
+    uint64_t Dropped;                               // 未完成就被覆盖的记录（用户态追踪器）
+    LatencyHistogram Intervals[LatencyStageCount];
+};
+
+//
+// 统计快照，读者持有的普通副本
+//
+struct LatencyStatsSnapshot
+{
+    int64_t TicksPerSecond;
+    uint64_t Frames;
+    uint64_t Dropped;
+    LatencyHistogram Intervals[LatencyStageCount];
+};
+
+//
+// 写者：驱动或用户态各自维护自己的统计块
+//
+class LatencyStatsWriter
+{
+public:
+    static bool Format(void* memory, uint64_t size, int64_t ticksPerSecond)
+    {
+        if (memory == nullptr || size < sizeof(LatencyStatsBlock) || ticksPerSecond <= 0)
+        {
+            return false;
+        }
+
+        std::memset(memory, 0, sizeof(LatencyStatsBlock));
+
+        LatencyStatsBlock* block = static_cast<LatencyStatsBlock*>(memory);
+        block->Version = LatencyStatsVersion;
+        block->TicksPerSecond = ticksPerSecond;
+        block->Sequence.store(0, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        block->Magic = LatencyStatsMagic;
+        return true;
+    }
+
+    bool Attach(void* memory, uint64_t size)
+    {
+        m_Block = nullptr;
+        if (memory == nullptr || size < sizeof(LatencyStatsBlock))
+        {
+            return false;
+        }
+
+        LatencyStatsBlock* block = static_cast<LatencyStatsBlock*>(memory);
+        if (block->Magic != LatencyStatsMagic || block->Version != LatencyStatsVersion || block->TicksPerSecond <= 0)
+        {
+            return false;
+        }
+
+        m_Block = block;
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Block != nullptr;
+    }
+
+    //
+    // 计入一帧：每个两端都已打点的相邻区间与总延迟。时间倒退的区间按0计
+    //
+    void Record(const FrameTimestamps& timestamps)
+    {
+        const int64_t present = timestamps.Get(LatencyStage::Present);
+        if (present == 0)
+        {
+            return;
+        }
+
+        Begin();
+
+        int64_t last = present;
+        for (uint32_t stage = 1; stage < LatencyStageCount; stage++)
+        {
+            const int64_t time = timestamps.Time[stage];
+            if (time == 0)
+            {
+                continue;
+            }
+
+            const int64_t previous = timestamps.Time[stage - 1];
+            if (previous != 0)
+            {
+                m_Block->Intervals[stage].Record(ToMicroseconds(time - previous));
+            }
+            last = time;
+        }
+
+        m_Block->Intervals[LatencyTotalInterval].Record(ToMicroseconds(last - present));
+        m_Block->Frames++;
+
+        End();
+    }
+
+    void AddDropped(uint64_t count)
+    {
+        Begin();
+        m_Block->Dropped += count;
+        End();
+    }
+
+    void Reset()
+    {
+        Begin();
+        m_Block->Frames = 0;
+        m_Block->Dropped = 0;
+        for (LatencyHistogram& histogram : m_Block->Intervals)
+        {
+            histogram.Reset();
+        }
+        End();
+    }
+
+private:
+    void Begin()
+    {
+        uint64_t sequence = m_Block->Sequence.load(std::memory_order_relaxed);
+        m_Block->Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void End()
+    {
+        uint64_t sequence = m_Block->Sequence.load(std::memory_order_relaxed);
+        m_Block->Sequence.store(sequence + 1, std::memory_order_release);
+    }
+
+    uint64_t ToMicroseconds(int64_t ticks) const
+    {
+        return ticks > 0 ? (uint64_t)ticks * 1000000 / (uint64_t)m_Block->TicksPerSecond : 0;
+    }
+
+    LatencyStatsBlock* m_Block = nullptr;
+};
+
+//
+// 读者，只需要只读映射
+//
+class LatencyStatsReader
+{
+public:
+    bool Attach(const void* memory, uint64_t size)
+    {
+        m_Block = nullptr;
+        if (memory == nullptr || size < sizeof(LatencyStatsBlock))
+        {
+            return false;
+        }
+
+        const LatencyStatsBlock* block = static_cast<const LatencyStatsBlock*>(memory);
+        if (block->Magic != LatencyStatsMagic || block->Version != LatencyStatsVersion)
+        {
+            return false;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_Block = block;
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Block != nullptr;
+    }
+
+    //
+    // 复制一致的快照。写者持续更新时最多重试maxAttempts次
+    //
+    bool Snapshot(LatencyStatsSnapshot& snapshot, uint32_t maxAttempts = 16) const
+    {
+        for (uint32_t attempt = 0; attempt < maxAttempts; attempt++)
+        {
+            uint64_t sequence = m_Block->Sequence.load(std::memory_order_acquire);
+            if ((sequence & 1) != 0)
+            {
+                continue;
+            }
+
+            snapshot.TicksPerSecond = m_Block->TicksPerSecond;
+            snapshot.Frames = m_Block->Frames;
+            snapshot.Dropped = m_Block->Dropped;
+            std::memcpy(snapshot.Intervals, m_Block->Intervals, sizeof(snapshot.Intervals));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_Block->Sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    const LatencyStatsBlock* m_Block = nullptr;
+};
+
+//
+// 用户态逐帧追踪：取出帧时用驱动写入的三个时间戳开始一条记录，之后各阶段在记录上
+// 就地打点，完成时计入统计块。记录按帧号存放在固定容量的环中，未完成就被新帧
+// 覆盖的记录计为Dropped
+//
+class FrameLatencyTracker
+{
+public:
+    static constexpr uint32_t Capacity = 64;    // 同时在途的帧数上限，必须为2的幂
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "容量必须为2的幂");
+
+    explicit FrameLatencyTracker(LatencyStatsWriter* writer = nullptr)
+        : m_Writer(writer)
+    {
+        std::memset(m_Records, 0, sizeof(m_Records));
+    }
+
+    void SetWriter(LatencyStatsWriter* writer)
+    {
+        m_Writer = writer;
+    }
+
+    //
+    // 开始一帧。present/acquire/publish来自帧描述，consume为取出时间
+    //
+    FrameTimestamps* Begin(uint64_t frameNumber, int64_t present, int64_t acquire, int64_t publish, int64_t consume)
+    {
+        FrameTimestamps& record = m_Records[frameNumber & (Capacity - 1)];
+        if (record.FrameNumber != 0 && m_Writer != nullptr)
+        {
+            m_Writer->AddDropped(1);
+        }
+
+        std::memset(&record, 0, sizeof(record));
+        record.FrameNumber = frameNumber;
+        record.Stamp(LatencyStage::Present, present);
+        record.Stamp(LatencyStage::Acquire, acquire);
+        record.Stamp(LatencyStage::Publish, publish);
+        record.Stamp(LatencyStage::Consume, consume);
+        return &record;
+    }
+
+    //
+    // 在途帧的记录，帧号不在途时返回nullptr
+    //
+    FrameTimestamps* Find(uint64_t frameNumber)
+    {
+        FrameTimestamps& record = m_Records[frameNumber & (Capacity - 1)];
+        return (frameNumber != 0 && record.FrameNumber == frameNumber) ? &record : nullptr;
+    }
+
+    bool Stamp(uint64_t frameNumber, LatencyStage stage, int64_t time)
+    {
+        FrameTimestamps* record = Find(frameNumber);
+        if (record == nullptr)
+        {
+            return false;
+        }
+
+        record->Stamp(stage, time);
+        return true;
+    }
+
+    //
+    // 帧离开主机（或被丢弃）后调用，计入统计并释放记录
+    //
+    bool Complete(uint64_t frameNumber)
+    {
+        FrameTimestamps* record = Find(frameNumber);
+        if (record == nullptr)
+        {
+            return false;
+        }
+
+        if (m_Writer != nullptr)
+        {
+            m_Writer->Record(*record);
+        }
+
+        record->FrameNumber = 0;
+        return true;
+    }
+
+private:
+    LatencyStatsWriter* m_Writer;
+    FrameTimestamps m_Records[Capacity];
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,285 @@
+/*++
+
+Module Name:
+    FramePacer.h
+
+Abstract:
+    按提交模式的刷新率对输出帧定速
+
+    虚拟显示器没有真实的垂直同步，以第一次提交的时间为相位，把时间轴划分为
+    刷新周期长度的区间，每个区间最多发布一帧。区间内已发布过的帧之后到达的
+    提交先挂起，损伤区域并入待发布帧，到下一个区间边界再发布最新内容。
+
+    提交可以带挂起时间（见ContentCadence.h）：待发布的提交全部挂起时，发布推迟到
+    区间边界与最早的挂起时间中较晚者；任一提交不挂起即按区间边界发布。
+
+    所有时间都由调用者以QPC计数传入，本模块不读取时钟，可以用模拟时钟确定性地测试。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 定速统计，时间单位为调用者的计数（QPC）
+//
+struct FramePacerStats
+{
+    uint64_t Presents = 0;          // 收到的提交数
+    uint64_t Emits = 0;             // 发布的帧数
+    uint64_t Coalesced = 0;         // 被合并进后续帧、未单独发布的提交数
+    uint64_t Deferred = 0;          // 等到区间边界才发布的帧数
+    int64_t LatencyTotal = 0;       // 提交到发布的延迟之和（按待发布帧中最早的提交计）
+    int64_t LatencyMax = 0;
+    int64_t Jitter = 0;             // 延迟抖动，RFC 3550式平滑估计 J += (|D| - J) / 16
+    int64_t BoundaryErrorTotal = 0; // 延后发布时实际发布时间晚于区间边界的量之和
+    int64_t BoundaryErrorMax = 0;
+};
+
+class FramePacer
+{
+public:
+    //
+    // 设置刷新率（numerator/denominator Hz）。numerator为0时不定速，每次取空交换链后立即发布
+    //
+    void Configure(int64_t ticksPerSecond, uint32_t refreshNumerator, uint32_t refreshDenominator)
+    {
+        m_Period = 0;
+        if (ticksPerSecond > 0 && refreshNumerator != 0 && refreshDenominator != 0)
+        {
+            m_Period = ticksPerSecond * (int64_t)refreshDenominator / refreshNumerator;
+        }
+
+        m_Anchored = false;
+        m_NextBoundary = 0;
+        m_HoldUntil = 0;
+    }
+
+    int64_t Period() const
+    {
+        return m_Period;
+    }
+
+    void ResetStats()
+    {
+        m_Stats = FramePacerStats();
+        m_LastLatency = -1;
+    }
+
+    const FramePacerStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 收到一次提交。holdUntil非0时提交挂起到该时间（内容帧之间的重复提交）
+    //
+    void OnPresent(int64_t presentTime, int64_t holdUntil = 0)
+    {
+        m_Stats.Presents++;
+
+        if (!m_Anchored)
+        {
+            // 第一帧决定区间相位，立即可发布
+            m_Anchored = true;
+            m_NextBoundary = presentTime;
+        }
+
+        if (m_PendingCount == 0)
+        {
+            m_FirstPendingPresent = presentTime;
+            m_HoldUntil = holdUntil;
+        }
+        else
+        {
+            m_Stats.Coalesced++;
+            m_HoldUntil = holdUntil < m_HoldUntil ? holdUntil : m_HoldUntil;
+        }
+
+        m_PendingCount++;
+    }
+
+    bool HasPending() const
+    {
+        return m_PendingCount != 0;
+    }
+
+    uint32_t PendingCount() const
+    {
+        return m_PendingCount;
+    }
+
+    //
+    // 待发布帧最早可发布的时间，仅在HasPending时有意义
+    //
+    int64_t Deadline() const
+    {
+        return m_HoldUntil > m_NextBoundary ? m_HoldUntil : m_NextBoundary;
+    }
+
+    bool ShouldEmit(int64_t now) const
+    {
+        return m_PendingCount != 0 && (m_Period == 0 || now >= Deadline());
+    }
+
+    //
+    // 已发布待发布帧。now为发布时间
+    //
+    void OnEmit(int64_t now)
+    {
+        m_Stats.Emits++;
+
+        int64_t latency = now - m_FirstPendingPresent;
+        if (latency < 0)
+        {
+            latency = 0;
+        }
+
+        m_Stats.LatencyTotal += latency;
+        if (latency > m_Stats.LatencyMax)
+        {
+            m_Stats.LatencyMax = latency;
+        }
+
+        if (m_LastLatency >= 0)
+        {
+            int64_t delta = latency - m_LastLatency;
+            m_Stats.Jitter += ((delta < 0 ? -delta : delta) - m_Stats.Jitter) / 16;
+        }
+        m_LastLatency = latency;
+
+        if (m_Period != 0)
+        {
+            // 提交晚于边界时立即发布不算延后；否则记录定时唤醒晚于边界（或挂起时间）的量
+            if (m_FirstPendingPresent < Deadline())
+            {
+                int64_t error = now - Deadline();
+                m_Stats.Deferred++;
+                m_Stats.BoundaryErrorTotal += error;
+                if (error > m_Stats.BoundaryErrorMax)
+                {
+                    m_Stats.BoundaryErrorMax = error;
+                }
+            }
+
+            // 下一个边界：now所在区间的结束（长时间空闲后重新对齐到区间网格）
+            if (now >= m_NextBoundary)
+            {
+                m_NextBoundary += ((now - m_NextBoundary) / m_Period + 1) * m_Period;
+            }
+        }
+
+        m_PendingCount = 0;
+        m_HoldUntil = 0;
+    }
+
+private:
+    int64_t m_Period = 0;
+    bool m_Anchored = false;
+    int64_t m_NextBoundary = 0;
+    int64_t m_HoldUntil = 0;
+    uint32_t m_PendingCount = 0;
+    int64_t m_FirstPendingPresent = 0;
+    int64_t m_LastLatency = -1;
+    FramePacerStats m_Stats;
+};
+
+//
+// 跳过的提交的损伤合并
+//
+// 只有一个待发布提交时原样保留脏矩形与移动区域；合并多个提交时，后一帧的移动区域
+// 可能搬运前一帧尚未发布的脏内容，无法再交给消费者按顺序执行，此时全部移动区域
+// 降级为其目标区域的脏矩形。
+//
+class FrameDamageAccumulator
+{
+public:
+    void Add(
+        const FrameRect* dirty,
+        uint32_t dirtyCount,
+        const FrameMoveRegion* moves,
+        uint32_t moveCount)
+    {
+        if (m_FrameCount != 0 && (!m_Moves.empty() || moveCount != 0))
+        {
+            DemoteMoves();
+            for (uint32_t i = 0; i < moveCount; i++)
+            {
+                m_Dirty.push_back(moves[i].Destination);
+            }
+        }
+        else
+        {
+            m_Moves.insert(m_Moves.end(), moves, moves + moveCount);
+        }
+
+        m_Dirty.insert(m_Dirty.end(), dirty, dirty + dirtyCount);
+        m_FrameCount++;
+    }
+
+    //
+    // 变化未知（例如取脏矩形失败），待发布帧按整帧处理
+    //
+    void AddFullFrame()
+    {
+        m_FullFrame = true;
+        m_Moves.clear();
+        m_FrameCount++;
+    }
+
+    void Clear()
+    {
+        m_Dirty.clear();
+        m_Moves.clear();
+        m_FullFrame = false;
+        m_FrameCount = 0;
+    }
+
+    bool FullFrame() const
+    {
+        return m_FullFrame;
+    }
+
+    uint32_t FrameCount() const
+    {
+        return m_FrameCount;
+    }
+
+    const std::vector<FrameRect>& Dirty() const
+    {
+        return m_Dirty;
+    }
+
+    const std::vector<FrameMoveRegion>& Moves() const
+    {
+        return m_Moves;
+    }
+
+private:
+    void DemoteMoves()
+    {
+        for (const FrameMoveRegion& move : m_Moves)
+        {
+            m_Dirty.push_back(move.Destination);
+        }
+        m_Moves.clear();
+    }
+
+    std::vector<FrameRect> m_Dirty;
+    std::vector<FrameMoveRegion> m_Moves;
+    bool m_FullFrame = false;
+    uint32_t m_FrameCount = 0;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,505 @@
+/*++
+
+Module Name:
+    FramePool.h
+
+Abstract:
+    每监视器的帧缓冲池与每帧元数据的线性分配区
+
+    离开交换链路径的帧（缩小、P010、编码前暂存等）都需要整帧大小的内存。
+    4K60下每帧重新分配会带来大量缺页与分配器开销，因此按提交的模式一次性
+    分配若干页对齐的帧缓冲并预先触碰每一页，之后按引用计数循环使用：
+    TryAcquire取得一个空闲缓冲，FrameBufferRef复制时加引用，最后一个引用
+    释放时缓冲回到池中。取得与释放只用原子操作，可以跨线程传递引用。
+
+    每帧的小块元数据（脏矩形/移动区域数组、时间戳等）从FrameArena线性分配，
+    每帧开始时Reset，稳态下不调用堆分配器。容量不足时返回nullptr，由调用者
+    降级处理（例如按整帧处理）。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+namespace FramePoolDetail {
+
+constexpr size_t PageSize = 4096;
+
+inline size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+//
+// 页对齐分配并预先写零，使每一页在使用前都已映射
+//
+inline uint8_t* AllocatePages(size_t bytes)
+{
+    bytes = AlignUp(bytes, PageSize);
+#if defined(_MSC_VER)
+    void* memory = _aligned_malloc(bytes, PageSize);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, PageSize, bytes) != 0)
+    {
+        memory = nullptr;
+    }
+#endif
+    if (memory != nullptr)
+    {
+        std::memset(memory, 0, bytes);
+    }
+    return static_cast<uint8_t*>(memory);
+}
+
+inline void FreePages(uint8_t* memory)
+{
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+} // namespace FramePoolDetail
+
+//
+// 按像素格式计算的帧缓冲布局，行距按64字节对齐；NV12/P010的UV平面紧跟Y平面
+//
+struct FrameBufferLayout
+{
+    PixelFormat Format = PixelFormat::Unknown;
+    int32_t Width = 0;
+    int32_t Height = 0;
+    size_t Pitch = 0;           // 字节，各平面相同
+    size_t ChromaOffset = 0;    // UV平面相对缓冲起始的偏移，打包格式为0
+    size_t Bytes = 0;
+
+    static FrameBufferLayout For(PixelFormat format, int32_t width, int32_t height)
+    {
+        FrameBufferLayout layout;
+        if (width <= 0 || height <= 0)
+        {
+            return layout;
+        }
+
+        size_t rowBytes = 0;
+        bool planar = false;
+        switch (format)
+        {
+        case PixelFormat::Bgra8:
+        case PixelFormat::R10G10B10A2:
+            rowBytes = (size_t)width * 4;
+            break;
+        case PixelFormat::Nv12:
+            rowBytes = (size_t)width;
+            planar = true;
+            break;
+        case PixelFormat::P010:
+            rowBytes = (size_t)width * 2;
+            planar = true;
+            break;
+        default:
+            return layout;
+        }
+
+        if (planar && ((width | height) & 1) != 0)
+        {
+            return layout;
+        }
+
+        layout.Format = format;
+        layout.Width = width;
+        layout.Height = height;
+        layout.Pitch = FramePoolDetail::AlignUp(rowBytes, 64);
+        layout.ChromaOffset = planar ? layout.Pitch * (size_t)height : 0;
+        layout.Bytes = layout.Pitch * (size_t)height * (planar ? 3 : 2) / 2;
+        return layout;
+    }
+
+    bool IsValid() const
+    {
+        return Bytes != 0;
+    }
+
+    bool operator==(const FrameBufferLayout& other) const
+    {
+        return Format == other.Format && Width == other.Width && Height == other.Height;
+    }
+};
+
+struct FramePoolStats
+{
+    uint64_t Acquired = 0;          // 成功取得的次数
+    uint64_t Exhausted = 0;         // 没有空闲缓冲的次数
+    uint64_t Allocations = 0;       // 分配帧缓冲的次数（只在Configure中发生）
+};
+
+class FrameBufferPool;
+
+//
+// 帧缓冲的引用，复制加引用，析构减引用；最后一个引用释放时缓冲回到池中。
+// 池必须比所有引用活得久
+//
+class FrameBufferRef
+{
+public:
+    FrameBufferRef() = default;
+
+    FrameBufferRef(const FrameBufferRef& other)
+        : m_Pool(other.m_Pool), m_Index(other.m_Index)
+    {
+        AddRef();
+    }
+
+    FrameBufferRef(FrameBufferRef&& other) noexcept
+        : m_Pool(other.m_Pool), m_Index(other.m_Index)
+    {
+        other.m_Pool = nullptr;
+    }
+
+    FrameBufferRef& operator=(const FrameBufferRef& other)
+    {
+        if (this != &other)
+        {
+            FrameBufferRef copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    FrameBufferRef& operator=(FrameBufferRef&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            Swap(other);
+        }
+        return *this;
+    }
+
+    ~FrameBufferRef()
+    {
+        Reset();
+    }
+
+    explicit operator bool() const
+    {
+        return m_Pool != nullptr;
+    }
+
+    void Reset();
+
+    uint32_t Index() const
+    {
+        return m_Index;
+    }
+
+    uint8_t* Data() const;
+    uint8_t* Chroma() const;                // UV平面，打包格式为nullptr
+    const FrameBufferLayout& Layout() const;
+    uint32_t UseCount() const;
+
+private:
+    friend class FrameBufferPool;
+
+    FrameBufferRef(FrameBufferPool* pool, uint32_t index)
+        : m_Pool(pool), m_Index(index)
+    {
+    }
+
+    void AddRef();
+
+    void Swap(FrameBufferRef& other)
+    {
+        FrameBufferPool* pool = m_Pool;
+        uint32_t index = m_Index;
+        m_Pool = other.m_Pool;
+        m_Index = other.m_Index;
+        other.m_Pool = pool;
+        other.m_Index = index;
+    }
+
+    FrameBufferPool* m_Pool = nullptr;
+    uint32_t m_Index = 0;
+};
+
+//
+// 每监视器的帧缓冲池，按提交的模式配置
+//
+class FrameBufferPool
+{
+public:
+    static constexpr uint32_t MaxBuffers = 8;
+    static constexpr uint32_t DefaultBuffers = 4;
+
+    FrameBufferPool() = default;
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+    ~FrameBufferPool()
+    {
+        Release();
+    }
+
+    //
+    // 按格式与尺寸分配count个缓冲。布局与数量不变时什么也不做；
+    // 仍有缓冲被引用时不能重新配置，返回false
+    //
+    bool Configure(PixelFormat format, int32_t width, int32_t height, uint32_t count = DefaultBuffers)
+    {
+        const FrameBufferLayout layout = FrameBufferLayout::For(format, width, height);
+        if (!layout.IsValid() || count == 0 || count > MaxBuffers)
+        {
+            return false;
+        }
+
+        if (layout == m_Layout && count == m_Count)
+        {
+            return true;
+        }
+
+        if (Outstanding() != 0)
+        {
+            return false;
+        }
+
+        Release();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_Buffers[i] = FramePoolDetail::AllocatePages(layout.Bytes);
+            if (m_Buffers[i] == nullptr)
+            {
+                Release();
+                return false;
+            }
+            m_Stats.Allocations++;
+            m_Count = i + 1;
+        }
+
+        m_Layout = layout;
+        return true;
+    }
+
+    //
+    // 取得一个空闲缓冲，没有空闲时返回空引用（调用者丢弃或延后本帧）。
+    // Configure与TryAcquire由生产者线程调用，引用可以在任意线程释放
+    //
+    FrameBufferRef TryAcquire()
+    {
+        for (uint32_t i = 0; i < m_Count; i++)
+        {
+            uint32_t expected = 0;
+            if (m_RefCounts[i].compare_exchange_strong(expected, 1, std::memory_order_acquire))
+            {
+                m_Stats.Acquired++;
+                return FrameBufferRef(this, i);
+            }
+        }
+
+        m_Stats.Exhausted++;
+        return FrameBufferRef();
+    }
+
+    uint32_t Count() const
+    {
+        return m_Count;
+    }
+
+    //
+    // 仍被引用的缓冲数
+    //
+    uint32_t Outstanding() const
+    {
+        uint32_t outstanding = 0;
+        for (uint32_t i = 0; i < m_Count; i++)
+        {
+            outstanding += m_RefCounts[i].load(std::memory_order_acquire) != 0 ? 1 : 0;
+        }
+        return outstanding;
+    }
+
+    const FrameBufferLayout& Layout() const
+    {
+        return m_Layout;
+    }
+
+    const FramePoolStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    friend class FrameBufferRef;
+
+    void Release()
+    {
+        for (uint32_t i = 0; i < m_Count; i++)
+        {
+            FramePoolDetail::FreePages(m_Buffers[i]);
+            m_Buffers[i] = nullptr;
+        }
+        m_Count = 0;
+        m_Layout = FrameBufferLayout();
+    }
+
+    FrameBufferLayout m_Layout;
+    uint32_t m_Count = 0;
+    uint8_t* m_Buffers[MaxBuffers] = {};
+    std::atomic<uint32_t> m_RefCounts[MaxBuffers] = {};
+    FramePoolStats m_Stats;
+};
+
+inline void FrameBufferRef::AddRef()
+{
+    if (m_Pool != nullptr)
+    {
+        m_Pool->m_RefCounts[m_Index].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void FrameBufferRef::Reset()
+{
+    if (m_Pool != nullptr)
+    {
+        // 释放语义保证本线程对缓冲的写入先于下一次取得
+        m_Pool->m_RefCounts[m_Index].fetch_sub(1, std::memory_order_release);
+        m_Pool = nullptr;
+    }
+}
+
+inline uint8_t* FrameBufferRef::Data() const
+{
+    return m_Pool != nullptr ? m_Pool->m_Buffers[m_Index] : nullptr;
+}
+
+inline uint8_t* FrameBufferRef::Chroma() const
+{
+    if (m_Pool == nullptr || m_Pool->m_Layout.ChromaOffset == 0)
+    {
+        return nullptr;
+    }
+    return m_Pool->m_Buffers[m_Index] + m_Pool->m_Layout.ChromaOffset;
+}
+
+inline const FrameBufferLayout& FrameBufferRef::Layout() const
+{
+    static const FrameBufferLayout empty;
+    return m_Pool != nullptr ? m_Pool->m_Layout : empty;
+}
+
+inline uint32_t FrameBufferRef::UseCount() const
+{
+    return m_Pool != nullptr ? m_Pool->m_RefCounts[m_Index].load(std::memory_order_relaxed) : 0;
+}
+
+//
+// 每帧元数据的线性分配区：只能分配可平凡析构的类型，Reset后全部作废
+//
+class FrameArena
+{
+public:
+    static constexpr size_t DefaultCapacity = 64 * 1024;
+
+    explicit FrameArena(size_t capacity = DefaultCapacity)
+        : m_Memory(FramePoolDetail::AllocatePages(capacity)),
+          m_Capacity(m_Memory != nullptr ? FramePoolDetail::AlignUp(capacity, FramePoolDetail::PageSize) : 0)
+    {
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    ~FrameArena()
+    {
+        FramePoolDetail::FreePages(m_Memory);
+    }
+
+    //
+    // 分配count个未初始化的T，容量不足时返回nullptr并计数
+    //
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena不调用析构函数");
+        static_assert(alignof(T) <= 64, "FrameArena最多按64字节对齐");
+
+        const size_t offset = FramePoolDetail::AlignUp(m_Used, alignof(T));
+        if (count > (m_Capacity - (offset < m_Capacity ? offset : m_Capacity)) / sizeof(T))
+        {
+            m_Overflows++;
+            return nullptr;
+        }
+
+        m_Used = offset + count * sizeof(T);
+        m_HighWater = m_Used > m_HighWater ? m_Used : m_HighWater;
+        return reinterpret_cast<T*>(m_Memory + offset);
+    }
+
+    template <typename T>
+    T* Copy(const T* source, size_t count)
+    {
+        T* target = Allocate<T>(count);
+        if (target != nullptr && count != 0)
+        {
+            std::memcpy(target, source, count * sizeof(T));
+        }
+        return target;
+    }
+
+    //
+    // 每帧开始时调用，此前分配的内存全部作废
+    //
+    void Reset()
+    {
+        m_Used = 0;
+    }
+
+    size_t Used() const
+    {
+        return m_Used;
+    }
+
+    size_t Capacity() const
+    {
+        return m_Capacity;
+    }
+
+    size_t HighWater() const
+    {
+        return m_HighWater;
+    }
+
+    uint64_t Overflows() const
+    {
+        return m_Overflows;
+    }
+
+private:
+    uint8_t* m_Memory;
+    size_t m_Capacity;
+    size_t m_Used = 0;
+    size_t m_HighWater = 0;
+    uint64_t m_Overflows = 0;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,910 @@
+/*++
+
+Module Name:
+    FrameRing.h
+
+Abstract:
+    驱动与用户态之间的零拷贝共享内存帧环
+
+    布局（所有偏移相对共享内存起始，均按页对齐）：
+        [FrameRingHeader][槽位0][槽位1]...[槽位N-1]
+        槽位 = [FrameSlotHeader][像素数据]
+
+    每个槽位用seqlock保护：生产者写入前把Sequence置为奇数，写完置为下一个偶数；
+    消费者以只读方式映射，直接在共享内存中读取像素，结束后再次比较Sequence，
+    不一致说明读取期间槽位被覆盖，本次结果作废。消费者从不写共享内存。
+
+    每个槽位同时携带脏矩形和移动区域（滚动提示）。与上一帧连续的消费者先在
+    自己持有的上一帧图像上执行移动区域（见MoveRegion.h），再只处理脏矩形。
+
+    帧描述携带驱动侧的三个延迟时间戳（提交、获取、发布），环头内嵌驱动的延迟
+    统计块（见FrameLatency.h），消费者只读取。
+
+    槽位另带块内容类别图（见TileClassifier.h）与视频区域提示（见VideoRegion.h），
+    二者描述当前画面的状态，不是相对上一帧的变化。
+
+    交换链失效并重新分配后，生产者把最新帧原样再发布一次（Republish，带
+    FrameFlagRecovery，整帧脏矩形），帧号与环本身都延续，消费者不需要重新连接。
+
+    背压（最新帧优先）：消费者另有一个可写的确认块（FrameAckBlock，独立的共享内存），
+    BeginRead时写入正在读取的帧号，EndRead成功后写入已处理完的帧号。最新已发布帧
+    既未被确认也未被读取时，生产者把新帧写回同一槽位并沿用帧号，脏矩形为被覆盖帧
+    与新帧损伤的并集（移动区域降级为目标区域），消费者看到的帧仍然连续，不会因为
+    落后而被迫整帧处理，也不会读到正在被覆盖的槽位。各原因丢弃的帧数记录在环头。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameLatency.h"
+#include "FrameTypes.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+constexpr uint32_t FrameRingMagic = 0x52465345;     // 'ESFR'
+constexpr uint32_t FrameRingVersion = 8;
+constexpr uint32_t FrameRingMaxDirtyRects = 64;
+constexpr uint32_t FrameRingMaxMoveRegions = 16;
+constexpr uint32_t FrameRingMaxContentTiles = 4096;   // 内容类别图容量（ContentTileSize的块，4K为60x34）
+constexpr uint32_t FrameRingMaxVideoRegions = MaxVideoRegions;
+constexpr uint64_t FrameRingPageSize = 4096;
+
+// FrameDescriptor::Flags
+constexpr uint32_t FrameFlagRefinement = 0x1;       // 静止后的画质补偿帧：内容未变，应以高质量重新编码脏矩形
+constexpr uint32_t FrameFlagRecovery = 0x2;         // 交换链恢复后重发的最后一帧：内容未变，中断期间没有新帧，应整帧重新编码
+
+constexpr uint32_t FrameAckMagic = 0x41465345;      // 'ESFA'
+constexpr uint32_t FrameAckVersion = 1;
+
+//
+// 未成为独立帧的原因（FrameRingHeader::Drops下标）
+//
+enum class FrameDropReason : uint32_t
+{
+    Coalesced,      // 定速区间内的提交合并进同一帧
+    Unchanged,      // 上报的区域内容未变化，不发布
+    Superseded,     // 已发布但消费者尚未取走，被更新的帧覆盖
+    Failed,         // 映射暂存纹理等失败，本帧内容丢失
+    Count
+};
+
+constexpr uint32_t FrameDropReasonCount = (uint32_t)FrameDropReason::Count;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "帧环要求64位原子操作无锁，才能跨进程共享");
+
+inline uint64_t AlignToPage(uint64_t value)
+{
+    return (value + FrameRingPageSize - 1) & ~(FrameRingPageSize - 1);
+}
+
+//
+// 帧描述，生产者填写，消费者读取
+//
+struct FrameDescriptor
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Pitch;             // 每行字节数（NV12时Y与UV平面相同）
+    PixelFormat Format;
+    int64_t PresentTime;        // DWM提交时间（QPC）
+    int64_t PublishTime;        // 驱动发布时间（QPC）
+    YuvMatrix Matrix;           // 仅NV12有效
+    YuvRange Range;
+    uint32_t Flags;             // FrameFlag*
+    int64_t AcquireTime;        // 驱动获取缓冲区时间（QPC）
+    uint64_t PresentFrameNumber;    // DWM提交帧号（IddCx PresentationFrameNumber），合并提交时为最后一个
+};
+
+//
+// 环头
+//
+struct FrameRingHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t SlotCount;
+    uint32_t MaxDirtyRects;
+    uint64_t SlotStride;                    // 槽位间距
+    uint64_t SlotHeaderSize;                // 槽位内像素数据偏移
+    uint64_t MaxPixelBytes;                 // 槽位像素容量
+    uint32_t MaxMoveRegions;
+    uint32_t Reserved0;
+    uint64_t Reserved[2];
+
+    alignas(64) std::atomic<uint64_t> LatestFrame;  // 最新已发布帧号，0表示尚无帧
+    uint64_t PublishCount;                          // 累计写入次数（含覆盖），只由生产者使用
+    std::atomic<uint64_t> Drops[FrameDropReasonCount]; // 各原因丢弃的帧数
+
+    LatencyStatsBlock Latency;                      // 驱动侧延迟统计（提交->获取->发布），由驱动格式化
+};
+
+//
+// 槽位头
+//
+struct FrameSlotHeader
+{
+    alignas(64) std::atomic<uint64_t> Sequence;     // 偶数=稳定，奇数=写入中
+    uint64_t FrameNumber;
+    uint64_t PublishNumber;                         // 槽位内容对应的写入序号（覆盖时帧号不变、序号递增）
+    FrameDescriptor Descriptor;
+    uint32_t DirtyRectCount;
+    uint32_t MoveRegionCount;
+    FrameRect DirtyRects[FrameRingMaxDirtyRects];
+    FrameMoveRegion MoveRegions[FrameRingMaxMoveRegions];
+    uint32_t ContentColumns;                        // 内容类别图的块列数与行数，0表示没有类别图
+    uint32_t ContentRows;
+    uint8_t ContentClasses[FrameRingMaxContentTiles]; // TileContent，行优先
+    uint32_t VideoRegionCount;                      // 视频区域提示（感兴趣区域）
+    uint32_t Reserved1;
+    VideoRegionHint VideoRegions[FrameRingMaxVideoRegions];
+};
+
+//
+// 消费者确认块（独立的共享内存，驱动格式化，消费者读写）。驱动不信任其内容，
+// 只用于决定是否覆盖尚未取走的帧
+//
+struct FrameAckBlock
+{
+    uint32_t Magic;
+    uint32_t Version;
+    alignas(64) std::atomic<uint32_t> ConsumerActive;   // 非0时生产者启用背压
+    std::atomic<uint64_t> ReadingFrame;                 // 正在读取的帧号，0表示没有
+    std::atomic<uint64_t> AckedFrame;                   // 最近处理完的帧号
+};
+
+constexpr uint64_t FrameAckBlockSize = FrameRingPageSize;
+
+static_assert(sizeof(FrameAckBlock) <= FrameAckBlockSize, "确认块必须放得进一页");
+
+//
+// 布局计算
+//
+struct FrameRingLayout
+{
+    static uint64_t HeaderSize()
+    {
+        return AlignToPage(sizeof(FrameRingHeader));
+    }
+
+    static uint64_t SlotHeaderSize()
+    {
+        return AlignToPage(sizeof(FrameSlotHeader));
+    }
+
+    static uint64_t SlotStride(uint64_t maxPixelBytes)
+    {
+        return SlotHeaderSize() + AlignToPage(maxPixelBytes);
+    }
+
+    static uint64_t RequiredSize(uint32_t slotCount, uint64_t maxPixelBytes)
+    {
+        return HeaderSize() + (uint64_t)slotCount * SlotStride(maxPixelBytes);
+    }
+};
+
+namespace Detail {
+
+inline bool ValidateRing(const void* memory, uint64_t size)
+{
+    if (memory == nullptr || size < FrameRingLayout::HeaderSize())
+    {
+        return false;
+    }
+
+    const FrameRingHeader* header = static_cast<const FrameRingHeader*>(memory);
+
+    return header->Magic == FrameRingMagic &&
+        header->Version == FrameRingVersion &&
+        header->SlotCount >= 2 &&
+        header->MaxDirtyRects == FrameRingMaxDirtyRects &&
+        header->MaxMoveRegions == FrameRingMaxMoveRegions &&
+        FrameRingLayout::HeaderSize() + (uint64_t)header->SlotCount * header->SlotStride <= size;
+}
+
+inline bool ValidateAck(const void* memory, uint64_t size)
+{
+    if (memory == nullptr || size < sizeof(FrameAckBlock))
+    {
+        return false;
+    }
+
+    const FrameAckBlock* block = static_cast<const FrameAckBlock*>(memory);
+    return block->Magic == FrameAckMagic && block->Version == FrameAckVersion;
+}
+
+} // namespace Detail
+
+//
+// 生产者写入句柄
+//
+struct FrameWriteSlot
+{
+    FrameSlotHeader* Header;
+    uint8_t* Pixels;
+    uint64_t Capacity;
+    uint64_t FrameNumber;
+    uint64_t PublishNumber;     // 单调递增的写入序号
+    uint64_t PreviousPublish;   // 槽位此前内容的写入序号，0表示没有
+    bool Supersedes;            // 覆盖消费者尚未取走的最新帧（帧号不变）
+};
+
+//
+// 生产者（驱动侧）
+//
+// 状态全部保存在共享内存中，可以随时重新Attach，例如交换链重新分配之后。
+// 单生产者：同一个环同一时刻只能有一个线程调用BeginWrite/EndWrite。
+//
+class FrameRingProducer
+{
+public:
+    //
+    // 在新分配的共享内存上格式化环
+    //
+    static bool Format(void* memory, uint64_t size, uint32_t slotCount, uint64_t maxPixelBytes)
+    {
+        if (memory == nullptr || slotCount < 2 ||
+            FrameRingLayout::RequiredSize(slotCount, maxPixelBytes) > size)
+        {
+            return false;
+        }
+
+        std::memset(memory, 0, (size_t)FrameRingLayout::HeaderSize());
+
+        FrameRingHeader* header = static_cast<FrameRingHeader*>(memory);
+        header->SlotCount = slotCount;
+        header->MaxDirtyRects = FrameRingMaxDirtyRects;
+        header->MaxMoveRegions = FrameRingMaxMoveRegions;
+        header->SlotStride = FrameRingLayout::SlotStride(maxPixelBytes);
+        header->SlotHeaderSize = FrameRingLayout::SlotHeaderSize();
+        header->MaxPixelBytes = AlignToPage(maxPixelBytes);
+        header->LatestFrame.store(0, std::memory_order_relaxed);
+        header->PublishCount = 0;
+        for (uint32_t i = 0; i < FrameDropReasonCount; i++)
+        {
+            header->Drops[i].store(0, std::memory_order_relaxed);
+        }
+
+        uint8_t* slots = static_cast<uint8_t*>(memory) + FrameRingLayout::HeaderSize();
+        for (uint32_t i = 0; i < slotCount; i++)
+        {
+            std::memset(slots + (uint64_t)i * header->SlotStride, 0, sizeof(FrameSlotHeader));
+        }
+
+        header->Version = FrameRingVersion;
+
+        // Magic最后写入，消费者据此判断环已就绪
+        std::atomic_thread_fence(std::memory_order_release);
+        header->Magic = FrameRingMagic;
+        return true;
+    }
+
+    bool Attach(void* memory, uint64_t size)
+    {
+        if (!Detail::ValidateRing(memory, size))
+        {
+            m_Header = nullptr;
+            return false;
+        }
+
+        m_Header = static_cast<FrameRingHeader*>(memory);
+        m_Slots = static_cast<uint8_t*>(memory) + FrameRingLayout::HeaderSize();
+        return true;
+    }
+
+    //
+    // 在新分配的确认块上格式化，消费者尚未连接
+    //
+    static bool FormatAck(void* memory, uint64_t size)
+    {
+        if (memory == nullptr || size < sizeof(FrameAckBlock))
+        {
+            return false;
+        }
+
+        std::memset(memory, 0, sizeof(FrameAckBlock));
+        FrameAckBlock* block = static_cast<FrameAckBlock*>(memory);
+        block->Version = FrameAckVersion;
+        std::atomic_thread_fence(std::memory_order_release);
+        block->Magic = FrameAckMagic;
+        return true;
+    }
+
+    //
+    // 连接消费者确认块后启用背压；未连接时每帧都使用新帧号
+    //
+    bool AttachAck(const void* memory, uint64_t size)
+    {
+        m_Ack = Detail::ValidateAck(memory, size) ? static_cast<const FrameAckBlock*>(memory) : nullptr;
+        return m_Ack != nullptr;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Header != nullptr;
+    }
+
+    //
+    // 消费者最近确认处理完的帧号（未连接确认块时为0）
+    //
+    uint64_t AckedFrame() const
+    {
+        return m_Ack != nullptr ? m_Ack->AckedFrame.load(std::memory_order_acquire) : 0;
+    }
+
+    uint64_t Drops(FrameDropReason reason) const
+    {
+        return m_Header->Drops[(uint32_t)reason].load(std::memory_order_relaxed);
+    }
+
+    void RecordDrop(FrameDropReason reason, uint64_t count = 1)
+    {
+        std::atomic<uint64_t>& counter = m_Header->Drops[(uint32_t)reason];
+        counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    uint64_t MaxPixelBytes() const
+    {
+        return m_Header->MaxPixelBytes;
+    }
+
+    LatencyStatsBlock* Latency() const
+    {
+        return &m_Header->Latency;
+    }
+
+    //
+    // 开始写入下一帧，返回的槽位在EndWrite之前对消费者不可见。
+    // 消费者既未确认也未开始读取最新帧时覆盖该帧（Supersedes）
+    //
+    FrameWriteSlot BeginWrite()
+    {
+        const uint64_t latest = m_Header->LatestFrame.load(std::memory_order_relaxed);
+        bool supersedes = false;
+        uint64_t frameNumber = latest + 1;
+        FrameSlotHeader* slot = nullptr;
+        uint64_t sequence = 0;
+
+        // 先把最新帧的槽位置为写入中，再判断消费者是否落后：消费者BeginRead先声明正在读取
+        // 再检查Sequence，两边都是seq_cst，要么消费者看到奇数放弃本次读取，要么生产者看到
+        // 它正在读取或已确认。判断在前则消费者可能在两步之间取走该帧，覆盖的内容永远收不到
+        if (latest != 0 && ConsumerActive())
+        {
+            FrameSlotHeader* latestSlot = SlotAt(latest);
+            const uint64_t latestSequence = latestSlot->Sequence.load(std::memory_order_relaxed);
+            latestSlot->Sequence.store(latestSequence + 1, std::memory_order_seq_cst);
+
+            if (ConsumerBehind(latest))
+            {
+                supersedes = true;
+                frameNumber = latest;
+                slot = latestSlot;
+                sequence = latestSequence;
+            }
+            else
+            {
+                // 内容未动，恢复原序号，读取中的消费者校验仍然通过
+                latestSlot->Sequence.store(latestSequence, std::memory_order_release);
+            }
+        }
+
+        if (!supersedes)
+        {
+            slot = SlotAt(frameNumber);
+            sequence = slot->Sequence.load(std::memory_order_relaxed);
+            slot->Sequence.store(sequence + 1, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        FrameWriteSlot writeSlot;
+        writeSlot.Header = slot;
+        writeSlot.Pixels = reinterpret_cast<uint8_t*>(slot) + m_Header->SlotHeaderSize;
+        writeSlot.Capacity = m_Header->MaxPixelBytes;
+        writeSlot.FrameNumber = frameNumber;
+        writeSlot.PublishNumber = m_Header->PublishCount + 1;
+        writeSlot.PreviousPublish = slot->PublishNumber;
+        writeSlot.Supersedes = supersedes;
+
+        // 新帧号的槽位不沿用旧帧的类别图与视频区域；覆盖时保留，其中包含被覆盖帧损伤区域的类别
+        if (!supersedes)
+        {
+            slot->ContentColumns = 0;
+            slot->ContentRows = 0;
+            slot->VideoRegionCount = 0;
+        }
+        return writeSlot;
+    }
+
+    //
+    // 在BeginWrite与EndWrite之间填写块内容类别图（TileContent，行优先）。
+    // 类别图按块保存最近一次分类结果，覆盖未取走的帧时整体替换即可；超过容量时不发布
+    //
+    void SetContentClasses(const FrameWriteSlot& writeSlot, uint32_t columns, uint32_t rows, const uint8_t* classes)
+    {
+        FrameSlotHeader* slot = writeSlot.Header;
+        if (classes == nullptr || (uint64_t)columns * rows > FrameRingMaxContentTiles)
+        {
+            slot->ContentColumns = 0;
+            slot->ContentRows = 0;
+            return;
+        }
+
+        std::memcpy(slot->ContentClasses, classes, (size_t)columns * rows);
+        slot->ContentColumns = columns;
+        slot->ContentRows = rows;
+    }
+
+    //
+    // 在BeginWrite与EndWrite之间填写视频区域提示。区域描述当前状态而非相对上一帧的变化，
+    // 覆盖时同样整体替换；超过容量的部分丢弃（检测器按大小排列）
+    //
+    void SetVideoRegions(const FrameWriteSlot& writeSlot, const VideoRegionHint* regions, uint32_t count)
+    {
+        FrameSlotHeader* slot = writeSlot.Header;
+        const uint32_t published = regions == nullptr ? 0 :
+            count < FrameRingMaxVideoRegions ? count : FrameRingMaxVideoRegions;
+        if (published != 0)
+        {
+            std::memcpy(slot->VideoRegions, regions, published * sizeof(VideoRegionHint));
+        }
+        slot->VideoRegionCount = published;
+    }
+
+    //
+    // 填写元数据并发布。脏矩形超过容量时合并为一个包围矩形
+    //
+    void EndWrite(
+        const FrameWriteSlot& writeSlot,
+        const FrameDescriptor& descriptor,
+        const FrameRect* dirtyRects,
+        uint32_t dirtyRectCount)
+    {
+        EndWrite(writeSlot, descriptor, dirtyRects, dirtyRectCount, nullptr, 0);
+    }
+
+    //
+    // 同上，并携带移动区域。移动区域超过容量时全部放弃，
+    // 其目标区域与脏矩形一起合并为一个包围矩形，消费者按普通脏区域处理。
+    // 覆盖未取走的帧时，损伤与槽位中原有的损伤合并（见MergeSuperseded）
+    //
+    void EndWrite(
+        const FrameWriteSlot& writeSlot,
+        const FrameDescriptor& descriptor,
+        const FrameRect* dirtyRects,
+        uint32_t dirtyRectCount,
+        const FrameMoveRegion* moveRegions,
+        uint32_t moveRegionCount)
+    {
+        FrameSlotHeader* slot = writeSlot.Header;
+
+        FrameRect merged[FrameRingMaxDirtyRects * 2 + FrameRingMaxMoveRegions * 2];
+        uint32_t flags = descriptor.Flags;
+        if (writeSlot.Supersedes)
+        {
+            dirtyRectCount = MergeSuperseded(slot, dirtyRects, dirtyRectCount, moveRegions, moveRegionCount, merged);
+            dirtyRects = merged;
+            moveRegions = nullptr;
+            moveRegionCount = 0;
+
+            // 补偿帧只在两帧都是补偿帧时保留标志，内容变化优先；恢复帧的整帧重新编码不能丢
+            flags = (flags & slot->Descriptor.Flags & FrameFlagRefinement) |
+                ((flags | slot->Descriptor.Flags) & FrameFlagRecovery);
+            RecordDrop(FrameDropReason::Superseded);
+        }
+
+        slot->FrameNumber = writeSlot.FrameNumber;
+        slot->PublishNumber = writeSlot.PublishNumber;
+        slot->Descriptor = descriptor;
+        slot->Descriptor.Flags = flags;
+
+        bool movesFit = moveRegionCount <= FrameRingMaxMoveRegions;
+
+        if (dirtyRectCount <= FrameRingMaxDirtyRects && movesFit)
+        {
+            slot->DirtyRectCount = dirtyRectCount;
+            if (dirtyRectCount != 0)
+            {
+                std::memcpy(slot->DirtyRects, dirtyRects, dirtyRectCount * sizeof(FrameRect));
+            }
+        }
+        else
+        {
+            FrameRect bounds = { 0, 0, 0, 0 };
+            for (uint32_t i = 0; i < dirtyRectCount; i++)
+            {
+                bounds = UnionRect(bounds, dirtyRects[i]);
+            }
+            for (uint32_t i = 0; !movesFit && i < moveRegionCount; i++)
+            {
+                bounds = UnionRect(bounds, moveRegions[i].Destination);
+            }
+            slot->DirtyRectCount = 1;
+            slot->DirtyRects[0] = bounds;
+        }
+
+        slot->MoveRegionCount = movesFit ? moveRegionCount : 0;
+        if (slot->MoveRegionCount != 0)
+        {
+            std::memcpy(slot->MoveRegions, moveRegions, moveRegionCount * sizeof(FrameMoveRegion));
+        }
+
+        uint64_t sequence = slot->Sequence.load(std::memory_order_relaxed);
+        slot->Sequence.store(sequence + 1, std::memory_order_release);
+        m_Header->PublishCount = writeSlot.PublishNumber;
+        m_Header->LatestFrame.store(writeSlot.FrameNumber, std::memory_order_release);
+    }
+
+    //
+    // 把最新已发布帧再发布一次，整帧作为脏矩形，标志只有flags（例如交换链恢复后的
+    // FrameFlagRecovery）。像素、类别图与视频区域取自最新帧的槽位，消费者尚未取走
+    // 最新帧时在原槽位上覆盖。尚无已发布帧时返回false
+    //
+    bool Republish(uint32_t flags, int64_t publishTime)
+    {
+        const uint64_t latest = m_Header->LatestFrame.load(std::memory_order_relaxed);
+        if (latest == 0)
+        {
+            return false;
+        }
+
+        // 生产者是槽位唯一的写入者，读取已发布的槽位不需要seqlock
+        const FrameSlotHeader* source = SlotAt(latest);
+        FrameDescriptor descriptor = source->Descriptor;
+        const uint64_t rows = (descriptor.Format == PixelFormat::Nv12 || descriptor.Format == PixelFormat::P010) ?
+            (uint64_t)descriptor.Height * 3 / 2 : descriptor.Height;
+        const uint64_t pixelBytes = rows * descriptor.Pitch;
+        if (pixelBytes > m_Header->MaxPixelBytes)
+        {
+            return false;
+        }
+
+        FrameWriteSlot slot = BeginWrite();
+        if (slot.Header != source)
+        {
+            std::memcpy(slot.Pixels, reinterpret_cast<const uint8_t*>(source) + m_Header->SlotHeaderSize,
+                (size_t)pixelBytes);
+            SetContentClasses(slot, source->ContentColumns, source->ContentRows, source->ContentClasses);
+            SetVideoRegions(slot, source->VideoRegions, source->VideoRegionCount);
+        }
+
+        descriptor.Flags = flags;
+        descriptor.PublishTime = publishTime;
+        const FrameRect fullFrame = { 0, 0, (int32_t)descriptor.Width, (int32_t)descriptor.Height };
+        EndWrite(slot, descriptor, &fullFrame, 1);
+        return true;
+    }
+
+private:
+    bool ConsumerActive() const
+    {
+        return m_Ack != nullptr && m_Ack->ConsumerActive.load(std::memory_order_acquire) != 0;
+    }
+
+    //
+    // 须在最新帧的槽位置为写入中之后调用。EndRead先写确认再清除正在读取，这里按相反
+    // 顺序读取：看到已清除时一定也看到确认
+    //
+    bool ConsumerBehind(uint64_t latest) const
+    {
+        if (m_Ack->ReadingFrame.load(std::memory_order_seq_cst) == latest)
+        {
+            return false;
+        }
+
+        return m_Ack->AckedFrame.load(std::memory_order_seq_cst) < latest;
+    }
+
+    //
+    // 被覆盖帧的脏矩形与移动区域目标、新帧的脏矩形与移动区域目标的并集（相对被覆盖帧
+    // 之前的一帧）。两帧的移动区域无法按顺序交给消费者，全部降级为脏区域；被已有矩形
+    // 包含的矩形不重复加入
+    //
+    static uint32_t MergeSuperseded(
+        const FrameSlotHeader* slot,
+        const FrameRect* dirtyRects,
+        uint32_t dirtyRectCount,
+        const FrameMoveRegion* moveRegions,
+        uint32_t moveRegionCount,
+        FrameRect* merged)
+    {
+        uint32_t count = 0;
+        auto add = [&](const FrameRect& rect)
+        {
+            if (rect.IsEmpty())
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (merged[i].Left <= rect.Left && merged[i].Top <= rect.Top &&
+                    merged[i].Right >= rect.Right && merged[i].Bottom >= rect.Bottom)
+                {
+                    return;
+                }
+            }
+            merged[count++] = rect;
+        };
+
+        const uint32_t oldDirty = slot->DirtyRectCount <= FrameRingMaxDirtyRects ?
+            slot->DirtyRectCount : FrameRingMaxDirtyRects;
+        const uint32_t oldMoves = slot->MoveRegionCount <= FrameRingMaxMoveRegions ?
+            slot->MoveRegionCount : FrameRingMaxMoveRegions;
+        for (uint32_t i = 0; i < oldDirty; i++)
+        {
+            add(slot->DirtyRects[i]);
+        }
+        for (uint32_t i = 0; i < oldMoves; i++)
+        {
+            add(slot->MoveRegions[i].Destination);
+        }
+
+        // 新帧的损伤超过容量时EndWrite本来也会合并为包围矩形
+        if (dirtyRectCount > FrameRingMaxDirtyRects || moveRegionCount > FrameRingMaxMoveRegions)
+        {
+            FrameRect bounds = { 0, 0, 0, 0 };
+            for (uint32_t i = 0; i < dirtyRectCount; i++)
+            {
+                bounds = UnionRect(bounds, dirtyRects[i]);
+            }
+            for (uint32_t i = 0; i < moveRegionCount; i++)
+            {
+                bounds = UnionRect(bounds, moveRegions[i].Destination);
+            }
+            add(bounds);
+            return count;
+        }
+
+        for (uint32_t i = 0; i < dirtyRectCount; i++)
+        {
+            add(dirtyRects[i]);
+        }
+        for (uint32_t i = 0; i < moveRegionCount; i++)
+        {
+            add(moveRegions[i].Destination);
+        }
+        return count;
+    }
+
+    FrameSlotHeader* SlotAt(uint64_t frameNumber) const
+    {
+        uint64_t index = frameNumber % m_Header->SlotCount;
+        return reinterpret_cast<FrameSlotHeader*>(m_Slots + index * m_Header->SlotStride);
+    }
+
+    FrameRingHeader* m_Header = nullptr;
+    uint8_t* m_Slots = nullptr;
+    const FrameAckBlock* m_Ack = nullptr;
+};
+
+//
+// 消费者读取视图，像素指针直接指向共享内存
+//
+struct FrameReadView
+{
+    uint64_t FrameNumber;
+    uint64_t Sequence;
+    FrameDescriptor Descriptor;
+    uint32_t DirtyRectCount;
+    FrameRect DirtyRects[FrameRingMaxDirtyRects];
+    uint32_t MoveRegionCount;
+    FrameMoveRegion MoveRegions[FrameRingMaxMoveRegions];   // 相对上一帧，仅在Contiguous时可用
+    uint32_t ContentColumns;    // 块内容类别图，0表示没有
+    uint32_t ContentRows;
+    const uint8_t* ContentClasses;  // 与Pixels一样直接指向共享内存，EndRead校验后才可信
+    uint32_t VideoRegionCount;
+    VideoRegionHint VideoRegions[FrameRingMaxVideoRegions];  // 视频区域提示，按热块数从多到少
+    const uint8_t* Pixels;
+    const FrameSlotHeader* Slot;
+    bool Contiguous;            // 与上一次读到的帧连续；否则脏矩形不足以描述变化，应按整帧处理
+};
+
+enum class FrameReadResult
+{
+    Ok,
+    NoNewFrame,
+    Busy            // 槽位正在被覆盖，稍后重试
+};
+
+//
+// 消费者（用户态），只需要只读映射
+//
+class FrameRingConsumer
+{
+public:
+    bool Attach(const void* memory, uint64_t size)
+    {
+        if (!Detail::ValidateRing(memory, size))
+        {
+            m_Header = nullptr;
+            return false;
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_Header = static_cast<const FrameRingHeader*>(memory);
+        m_Slots = static_cast<const uint8_t*>(memory) + FrameRingLayout::HeaderSize();
+        return true;
+    }
+
+    bool IsAttached() const
+    {
+        return m_Header != nullptr;
+    }
+
+    //
+    // 连接确认块（可写映射），此后驱动在本消费者落后时覆盖未取走的帧而不是越过它
+    //
+    bool AttachAck(void* memory, uint64_t size)
+    {
+        if (!Detail::ValidateAck(memory, size))
+        {
+            m_Ack = nullptr;
+            return false;
+        }
+
+        m_Ack = static_cast<FrameAckBlock*>(memory);
+        m_Ack->ReadingFrame.store(0, std::memory_order_relaxed);
+        m_Ack->AckedFrame.store(m_LastFrame, std::memory_order_relaxed);
+        m_Ack->ConsumerActive.store(1, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // 断开确认块，驱动恢复为每帧使用新帧号
+    //
+    void DetachAck()
+    {
+        if (m_Ack != nullptr)
+        {
+            m_Ack->ConsumerActive.store(0, std::memory_order_release);
+            m_Ack = nullptr;
+        }
+    }
+
+    uint64_t LastFrame() const
+    {
+        return m_LastFrame;
+    }
+
+    uint64_t Drops(FrameDropReason reason) const
+    {
+        return m_Header->Drops[(uint32_t)reason].load(std::memory_order_relaxed);
+    }
+
+    const LatencyStatsBlock* Latency() const
+    {
+        return &m_Header->Latency;
+    }
+
+    //
+    // 获取最新帧。成功后可直接读取view.Pixels，读完必须调用EndRead校验
+    //
+    FrameReadResult BeginRead(FrameReadView& view)
+    {
+        uint64_t latest = m_Header->LatestFrame.load(std::memory_order_acquire);
+        if (latest == 0 || latest == m_LastFrame)
+        {
+            return FrameReadResult::NoNewFrame;
+        }
+
+        // 先声明正在读取，驱动此后不再覆盖这一帧；之前已开始的覆盖由seqlock发现
+        SetReading(latest);
+
+        // seq_cst与SetReading配对（见FrameRingProducer::BeginWrite）
+        const FrameSlotHeader* slot = SlotAt(latest);
+        uint64_t sequence = slot->Sequence.load(std::memory_order_seq_cst);
+        if ((sequence & 1) != 0)
+        {
+            SetReading(0);
+            return FrameReadResult::Busy;
+        }
+
+        view.FrameNumber = slot->FrameNumber;
+        view.Descriptor = slot->Descriptor;
+        view.DirtyRectCount = slot->DirtyRectCount;
+        if (view.DirtyRectCount > FrameRingMaxDirtyRects)
+        {
+            view.DirtyRectCount = FrameRingMaxDirtyRects;
+        }
+        std::memcpy(view.DirtyRects, slot->DirtyRects, view.DirtyRectCount * sizeof(FrameRect));
+        view.MoveRegionCount = slot->MoveRegionCount;
+        if (view.MoveRegionCount > FrameRingMaxMoveRegions)
+        {
+            view.MoveRegionCount = FrameRingMaxMoveRegions;
+        }
+        std::memcpy(view.MoveRegions, slot->MoveRegions, view.MoveRegionCount * sizeof(FrameMoveRegion));
+        view.ContentColumns = slot->ContentColumns;
+        view.ContentRows = slot->ContentRows;
+        if ((uint64_t)view.ContentColumns * view.ContentRows > FrameRingMaxContentTiles)
+        {
+            view.ContentColumns = 0;
+            view.ContentRows = 0;
+        }
+        view.ContentClasses = slot->ContentClasses;
+        view.VideoRegionCount = slot->VideoRegionCount;
+        if (view.VideoRegionCount > FrameRingMaxVideoRegions)
+        {
+            view.VideoRegionCount = FrameRingMaxVideoRegions;
+        }
+        std::memcpy(view.VideoRegions, slot->VideoRegions, view.VideoRegionCount * sizeof(VideoRegionHint));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->Sequence.load(std::memory_order_relaxed) != sequence || view.FrameNumber != latest)
+        {
+            SetReading(0);
+            return FrameReadResult::Busy;
+        }
+
+        view.Sequence = sequence;
+        view.Slot = slot;
+        view.Pixels = reinterpret_cast<const uint8_t*>(slot) + m_Header->SlotHeaderSize;
+        view.Contiguous = (latest == m_LastFrame + 1);
+        return FrameReadResult::Ok;
+    }
+
+    //
+    // 校验读取期间槽位未被覆盖。返回false时本次读到的像素不可用
+    //
+    bool EndRead(const FrameReadView& view)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (view.Slot->Sequence.load(std::memory_order_relaxed) != view.Sequence)
+        {
+            m_TornReads++;
+            SetReading(0);
+            return false;
+        }
+
+        m_SkippedFrames += view.FrameNumber - m_LastFrame - 1;
+        m_LastFrame = view.FrameNumber;
+        if (m_Ack != nullptr)
+        {
+            m_Ack->AckedFrame.store(view.FrameNumber, std::memory_order_release);
+            m_Ack->ReadingFrame.store(0, std::memory_order_release);
+        }
+        return true;
+    }
+
+    uint64_t TornReads() const
+    {
+        return m_TornReads;
+    }
+
+    uint64_t SkippedFrames() const
+    {
+        return m_SkippedFrames;
+    }
+
+private:
+    const FrameSlotHeader* SlotAt(uint64_t frameNumber) const
+    {
+        uint64_t index = frameNumber % m_Header->SlotCount;
+        return reinterpret_cast<const FrameSlotHeader*>(m_Slots + index * m_Header->SlotStride);
+    }
+
+    void SetReading(uint64_t frameNumber)
+    {
+        if (m_Ack != nullptr)
+        {
+            m_Ack->ReadingFrame.store(frameNumber, std::memory_order_seq_cst);
+        }
+    }
+
+    const FrameRingHeader* m_Header = nullptr;
+    FrameAckBlock* m_Ack = nullptr;
+    const uint8_t* m_Slots = nullptr;
+    uint64_t m_LastFrame = 0;
+    uint64_t m_TornReads = 0;
+    uint64_t m_SkippedFrames = 0;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,464 @@
+/*++
+
+Module Name:
+    FrameStageGraph.h
+
+Abstract:
+    交换链帧处理的流水线阶段图。
+
+    获取线程（FrameWorkerLoop）只做获取缓冲区、拷出到作业自己的暂存缓冲区并立即
+    释放表面；其后的比较/哈希、转换、发布等阶段各在一个线程上按顺序处理作业，
+    阶段之间用有界队列连接。帧N还在转换时帧N+1已经可以获取、拷出并开始比较，
+    稳态帧率由最慢的一级决定，而不是各级耗时之和。
+
+    作业只是槽位下标（0..JobCount-1），调用者按下标保存每帧的数据（暂存纹理、
+    损伤区域、时间戳）。槽位数限制同时在途的帧数：获取线程在AcquireJob上取空闲
+    槽位，全部在途时等待（背压），因此阶段之间的队列容量等于槽位数即不会满。
+    槽位离开最后一级（或某一级返回false提前结束）后并不自动归还，由阶段函数或
+    调用者在不再需要它的数据时调用Complete，例如最后一级保留最近发布的一帧。
+
+    每一级按到达顺序处理，帧顺序不变；阶段函数各自只访问自己那一级的状态，
+    跨级共享的状态由调用者自行同步。
+
+    Start时threaded为false（或创建线程失败）时串行：Submit在调用线程上依次执行
+    各级，与流水线结果相同，用于对比与回退。
+
+    每一级统计处理的作业数、忙/空闲时间与输入队列深度，占用率 = 忙时间 / 运行时间。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+constexpr uint32_t FrameStageMaxStages = 8;
+constexpr uint32_t FrameStageMaxJobs = 16;
+
+//
+// 阶段函数：处理job，返回true交给下一级，false在此结束（不再经过之后的各级）
+//
+using FrameStageFunction = bool(*)(void* context, uint32_t job);
+
+//
+// 每一级的统计
+//
+struct FrameStageStats
+{
+    uint64_t Jobs = 0;              // 处理的作业数
+    uint64_t Forwarded = 0;         // 交给下一级（最后一级为正常完成）的作业数
+    uint64_t BusyNs = 0;            // 执行阶段函数的时间
+    uint64_t IdleNs = 0;            // 等待输入的时间（串行时为0）
+    uint64_t QueueDepthTotal = 0;   // 每次取出作业时输入队列深度（含该作业）之和，平均深度 = Total / Jobs
+    uint32_t MaxQueueDepth = 0;
+};
+
+//
+// 整个阶段图的统计
+//
+struct FrameStageGraphStats
+{
+    uint64_t Submitted = 0;         // 提交的作业数
+    uint64_t Completed = 0;         // 归还的槽位数
+    uint64_t JobWaits = 0;          // AcquireJob因槽位全部在途而等待的次数
+    uint64_t JobWaitNs = 0;
+    uint32_t MaxInFlight = 0;       // 同时被占用的槽位数最大值
+    uint64_t ElapsedNs = 0;         // Start以来的时间
+};
+
+class FrameStageGraph
+{
+public:
+    FrameStageGraph() = default;
+
+    ~FrameStageGraph()
+    {
+        Stop();
+    }
+
+    FrameStageGraph(const FrameStageGraph&) = delete;
+    FrameStageGraph& operator=(const FrameStageGraph&) = delete;
+
+    //
+    // 启动：stages依次为各级，context传给每个阶段函数。已在运行时先Stop
+    //
+    bool Start(const FrameStageFunction* stages, uint32_t stageCount, void* context, uint32_t jobCount, bool threaded)
+    {
+        Stop();
+
+        if (stages == nullptr || stageCount == 0 || stageCount > FrameStageMaxStages ||
+            jobCount == 0 || jobCount > FrameStageMaxJobs)
+        {
+            return false;
+        }
+
+        m_StageCount = stageCount;
+        m_JobCount = jobCount;
+        m_Context = context;
+        m_Stats = FrameStageGraphStats();
+        m_Active = 0;
+        m_FreeHead = 0;
+        m_FreeCount = jobCount;
+        for (uint32_t i = 0; i < jobCount; i++)
+        {
+            m_Free[i] = i;
+        }
+
+        for (uint32_t i = 0; i < stageCount; i++)
+        {
+            Stage& stage = m_Stages[i];
+            stage.Function = stages[i];
+            stage.Head = 0;
+            stage.Count = 0;
+            stage.Closing = false;
+            stage.Stats = FrameStageStats();
+        }
+
+        m_Start = Clock::now();
+        m_Running = true;
+        m_Threaded = false;
+
+        if (threaded)
+        {
+            uint32_t started = 0;
+            try
+            {
+                for (; started < stageCount; started++)
+                {
+                    m_Stages[started].Thread = std::thread(&FrameStageGraph::StageMain, this, started);
+                }
+                m_Threaded = true;
+            }
+            catch (...)
+            {
+                // 线程创建失败时退回串行
+                for (uint32_t i = 0; i < started; i++)
+                {
+                    Close(i);
+                    m_Stages[i].Thread.join();
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // 处理完已提交的作业后停止各级线程；之后不再调用阶段函数
+    //
+    void Stop()
+    {
+        if (!m_Running)
+        {
+            return;
+        }
+
+        // 逐级关闭：前一级退出后它不会再放入作业，下一级取空即可退出
+        if (m_Threaded)
+        {
+            for (uint32_t i = 0; i < m_StageCount; i++)
+            {
+                Close(i);
+                m_Stages[i].Thread.join();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_PoolLock);
+            m_Stats.ElapsedNs = NsSince(m_Start);
+            m_Running = false;
+        }
+        m_JobFree.notify_all();
+    }
+
+    bool IsRunning() const
+    {
+        return m_Running;
+    }
+
+    //
+    // 最近一次Start是否以流水线方式运行（Stop后保留，供读取统计时使用）
+    //
+    bool Threaded() const
+    {
+        return m_Threaded;
+    }
+
+    uint32_t StageCount() const
+    {
+        return m_StageCount;
+    }
+
+    uint32_t JobCount() const
+    {
+        return m_JobCount;
+    }
+
+    //
+    // 取一个空闲槽位，全部在途时等待。未运行时返回false；串行时槽位全被调用者
+    // 保留则无法等到，也返回false
+    //
+    bool AcquireJob(uint32_t& job)
+    {
+        std::unique_lock<std::mutex> lock(m_PoolLock);
+        if (m_FreeCount == 0 && m_Running && m_Threaded && m_Active != 0)
+        {
+            const Clock::time_point start = Clock::now();
+            m_Stats.JobWaits++;
+            m_JobFree.wait(lock, [&] { return m_FreeCount != 0 || !m_Running || m_Active == 0; });
+            m_Stats.JobWaitNs += NsSince(start);
+        }
+        return TakeFree(job);
+    }
+
+    bool TryAcquireJob(uint32_t& job)
+    {
+        std::lock_guard<std::mutex> lock(m_PoolLock);
+        return TakeFree(job);
+    }
+
+    //
+    // 把已填好数据的槽位交给第一级。串行时在本线程上依次执行各级后返回；
+    // 与AcquireJob一样只能由一个线程调用，Stop之后忽略
+    //
+    void Submit(uint32_t job)
+    {
+        if (!m_Running)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_PoolLock);
+            m_Stats.Submitted++;
+            m_Active++;
+        }
+
+        if (m_Threaded)
+        {
+            Push(0, job);
+            return;
+        }
+
+        for (uint32_t i = 0; i < m_StageCount; i++)
+        {
+            Stage& stage = m_Stages[i];
+            stage.Stats.QueueDepthTotal++;
+            stage.Stats.MaxQueueDepth = stage.Stats.MaxQueueDepth > 1 ? stage.Stats.MaxQueueDepth : 1;
+
+            const Clock::time_point start = Clock::now();
+            const bool forward = stage.Function(m_Context, job);
+            stage.Stats.BusyNs += NsSince(start);
+            stage.Stats.Jobs++;
+            if (!forward)
+            {
+                break;
+            }
+            stage.Stats.Forwarded++;
+        }
+        Leave();
+    }
+
+    //
+    // 归还槽位（其数据不再使用）
+    //
+    void Complete(uint32_t job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_PoolLock);
+            if (job >= m_JobCount || m_FreeCount >= m_JobCount)
+            {
+                return;
+            }
+            m_Free[(m_FreeHead + m_FreeCount) % m_JobCount] = job;
+            m_FreeCount++;
+            m_Stats.Completed++;
+        }
+        m_JobFree.notify_all();
+    }
+
+    //
+    // 等待已提交的作业全部离开各级（各级线程空闲），例如在需要读取各级状态之前
+    //
+    void WaitIdle()
+    {
+        std::unique_lock<std::mutex> lock(m_PoolLock);
+        m_JobFree.wait(lock, [&] { return m_Active == 0; });
+    }
+
+    //
+    // 尚未离开各级的作业数
+    //
+    uint32_t ActiveJobs() const
+    {
+        std::lock_guard<std::mutex> lock(m_PoolLock);
+        return m_Active;
+    }
+
+    FrameStageStats StageStats(uint32_t stage) const
+    {
+        if (stage >= m_StageCount)
+        {
+            return FrameStageStats();
+        }
+        std::lock_guard<std::mutex> lock(m_Stages[stage].Lock);
+        return m_Stages[stage].Stats;
+    }
+
+    FrameStageGraphStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_PoolLock);
+        FrameStageGraphStats stats = m_Stats;
+        if (m_Running)
+        {
+            stats.ElapsedNs = NsSince(m_Start);
+        }
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage
+    {
+        FrameStageFunction Function = nullptr;
+        mutable std::mutex Lock;
+        std::condition_variable Ready;
+        uint32_t Jobs[FrameStageMaxJobs] = {};
+        uint32_t Head = 0;
+        uint32_t Count = 0;
+        bool Closing = false;
+        FrameStageStats Stats;
+        std::thread Thread;
+    };
+
+    static uint64_t NsSince(Clock::time_point start)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    // 调用者持有m_PoolLock
+    bool TakeFree(uint32_t& job)
+    {
+        if (!m_Running || m_FreeCount == 0)
+        {
+            return false;
+        }
+        job = m_Free[m_FreeHead];
+        m_FreeHead = (m_FreeHead + 1) % m_JobCount;
+        m_FreeCount--;
+
+        const uint32_t inFlight = m_JobCount - m_FreeCount;
+        m_Stats.MaxInFlight = inFlight > m_Stats.MaxInFlight ? inFlight : m_Stats.MaxInFlight;
+        return true;
+    }
+
+    //
+    // 放入第index级的输入队列；队列容量等于槽位数，不会满
+    //
+    void Push(uint32_t index, uint32_t job)
+    {
+        Stage& stage = m_Stages[index];
+        {
+            std::lock_guard<std::mutex> lock(stage.Lock);
+            stage.Jobs[(stage.Head + stage.Count) % FrameStageMaxJobs] = job;
+            stage.Count++;
+            stage.Stats.MaxQueueDepth = stage.Count > stage.Stats.MaxQueueDepth ? stage.Count : stage.Stats.MaxQueueDepth;
+        }
+        stage.Ready.notify_one();
+    }
+
+    void Close(uint32_t index)
+    {
+        Stage& stage = m_Stages[index];
+        {
+            std::lock_guard<std::mutex> lock(stage.Lock);
+            stage.Closing = true;
+        }
+        stage.Ready.notify_one();
+    }
+
+    //
+    // 作业离开各级
+    //
+    void Leave()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_PoolLock);
+            m_Active--;
+        }
+        m_JobFree.notify_all();
+    }
+
+    void StageMain(uint32_t index)
+    {
+        Stage& stage = m_Stages[index];
+        const bool last = index + 1 == m_StageCount;
+
+        for (;;)
+        {
+            uint32_t job;
+            {
+                std::unique_lock<std::mutex> lock(stage.Lock);
+                const Clock::time_point idle = Clock::now();
+                stage.Ready.wait(lock, [&] { return stage.Count != 0 || stage.Closing; });
+                if (stage.Count == 0)
+                {
+                    return;
+                }
+                stage.Stats.IdleNs += NsSince(idle);
+                stage.Stats.QueueDepthTotal += stage.Count;
+                job = stage.Jobs[stage.Head];
+                stage.Head = (stage.Head + 1) % FrameStageMaxJobs;
+                stage.Count--;
+            }
+
+            const Clock::time_point start = Clock::now();
+            const bool forward = stage.Function(m_Context, job);
+            const uint64_t busy = NsSince(start);
+            {
+                std::lock_guard<std::mutex> lock(stage.Lock);
+                stage.Stats.BusyNs += busy;
+                stage.Stats.Jobs++;
+                stage.Stats.Forwarded += forward ? 1 : 0;
+            }
+
+            if (forward && !last)
+            {
+                Push(index + 1, job);
+            }
+            else
+            {
+                Leave();
+            }
+        }
+    }
+
+    Stage m_Stages[FrameStageMaxStages];
+    uint32_t m_StageCount = 0;
+    uint32_t m_JobCount = 0;
+    void* m_Context = nullptr;
+    bool m_Running = false;
+    bool m_Threaded = false;
+    Clock::time_point m_Start;
+
+    mutable std::mutex m_PoolLock;
+    std::condition_variable m_JobFree;              // 槽位归还或作业离开各级
+    uint32_t m_Free[FrameStageMaxJobs] = {};
+    uint32_t m_FreeHead = 0;
+    uint32_t m_FreeCount = 0;
+    uint32_t m_Active = 0;                          // 已提交、尚未离开各级的作业数
+    FrameStageGraphStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,163 @@
+/*++
+
+Module Name:
+    FrameTypes.h
+
+Abstract:
+    帧处理可移植核心共用的基础类型
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 矩形，右/下边界不包含，内存布局与Win32 RECT一致
+//
+struct FrameRect
+{
+    int32_t Left;
+    int32_t Top;
+    int32_t Right;
+    int32_t Bottom;
+
+    int32_t Width() const { return Right - Left; }
+    int32_t Height() const { return Bottom - Top; }
+    bool IsEmpty() const { return Right <= Left || Bottom <= Top; }
+
+    int64_t Area() const
+    {
+        return IsEmpty() ? 0 : (int64_t)Width() * (int64_t)Height();
+    }
+
+    bool operator==(const FrameRect& other) const
+    {
+        return Left == other.Left && Top == other.Top &&
+            Right == other.Right && Bottom == other.Bottom;
+    }
+};
+
+inline FrameRect IntersectRect(const FrameRect& a, const FrameRect& b)
+{
+    FrameRect result =
+    {
+        std::max(a.Left, b.Left),
+        std::max(a.Top, b.Top),
+        std::min(a.Right, b.Right),
+        std::min(a.Bottom, b.Bottom)
+    };
+    return result.IsEmpty() ? FrameRect{ 0, 0, 0, 0 } : result;
+}
+
+inline FrameRect UnionRect(const FrameRect& a, const FrameRect& b)
+{
+    if (a.IsEmpty())
+    {
+        return b;
+    }
+
+    if (b.IsEmpty())
+    {
+        return a;
+    }
+
+    return
+    {
+        std::min(a.Left, b.Left),
+        std::min(a.Top, b.Top),
+        std::max(a.Right, b.Right),
+        std::max(a.Bottom, b.Bottom)
+    };
+}
+
+inline bool RectsOverlap(const FrameRect& a, const FrameRect& b)
+{
+    return a.Left < b.Right && b.Left < a.Right && a.Top < b.Bottom && b.Top < a.Bottom;
+}
+
+//
+// 移动区域：上一帧中以(SourceX, SourceY)为左上角的内容被移动到Destination，
+// 内存布局与DXGI_OUTDUPL_MOVE_RECT一致。应先应用移动区域，再覆盖脏矩形
+//
+struct FrameMoveRegion
+{
+    int32_t SourceX;
+    int32_t SourceY;
+    FrameRect Destination;
+
+    FrameRect Source() const
+    {
+        return
+        {
+            SourceX,
+            SourceY,
+            SourceX + Destination.Width(),
+            SourceY + Destination.Height()
+        };
+    }
+};
+
+//
+// 像素格式
+//
+enum class PixelFormat : uint32_t
+{
+    Unknown = 0,
+    Bgra8 = 1,      // DXGI_FORMAT_B8G8R8A8_UNORM
+    Nv12 = 2,       // Y平面后接交错的UV平面（半高），两者行距相同
+    P010 = 3,       // 布局同NV12，每个样本16位，10位有效值在高位
+    R10G10B10A2 = 4 // DXGI_FORMAT_R10G10B10A2_UNORM，R在低10位
+};
+
+//
+// YUV矩阵与范围
+//
+enum class YuvMatrix : uint32_t
+{
+    Bt601 = 0,
+    Bt709 = 1
+};
+
+enum class YuvRange : uint32_t
+{
+    Limited = 0,    // Y 16~235，UV 16~240
+    Full = 1
+};
+
+//
+// 块内容类别（TileClassifier.h），随帧发布，每块ContentTileSize x ContentTileSize像素
+//
+enum class TileContent : uint8_t
+{
+    Unknown = 0,    // 尚未分类
+    Text = 1,       // 文字与界面：锐利边缘、颜色少，应保持清晰
+    Natural = 2,    // 静态的自然图像（照片、渐变）
+    Video = 3       // 持续更新的自然图像
+};
+
+constexpr uint32_t TileContentCount = 4;
+constexpr int32_t ContentTileSize = 64;
+
+//
+// 视频区域提示（VideoRegion.h），随帧发布，供编码器按感兴趣区域分配码率
+//
+struct VideoRegionHint
+{
+    FrameRect Rect;         // 按ContentTileSize对齐并裁剪到帧内
+    int64_t Interval;       // 区域内块的平均更新间隔（QPC），可换算为区域帧率
+    uint32_t Tiles;         // 区域内稳定更新的块数
+    uint32_t Reserved;
+};
+
+constexpr uint32_t MaxVideoRegions = 8;
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,183 @@
+/*++
+
+Module Name:
+    FrameWorker.h
+
+Abstract:
+    交换链帧处理线程的可移植核心（获取/挂起/释放/终止状态机）
+    不依赖WDK，可由模拟交换链在Linux上驱动
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 一次获取缓冲区的结果
+//
+enum class AcquireResult
+{
+    Acquired,    // 获得新帧，处理后必须Release
+    Pending,     // 暂无新帧，需要等待事件
+    Failed       // 交换链已失效，线程应退出
+};
+
+//
+// 一次等待的结果
+//
+enum class WaitResult
+{
+    FrameAvailable,  // 新帧事件被触发
+    Timeout,         // 等待超时（用于兜底重试）
+    Terminate,       // 收到终止请求
+    Deadline         // 定速定时器到期，挂起的帧可以发布
+};
+
+//
+// 线程退出原因
+//
+enum class WorkerExitReason
+{
+    Terminated,
+    AcquireFailed
+};
+
+//
+// 帧处理线程统计
+//
+struct FrameWorkerStats
+{
+    uint64_t FramesProcessed = 0;   // 已处理（获取并释放）的帧数
+    uint64_t Wakeups = 0;           // 等待返回次数
+    uint64_t EmptyWakeups = 0;      // 被唤醒但没有取到帧的次数
+    uint64_t Timeouts = 0;          // 等待超时次数
+    uint64_t Deadlines = 0;         // 定速定时器唤醒次数
+    uint64_t MaxBurst = 0;          // 单次唤醒内连续取到的最大帧数
+};
+
+//
+// 帧处理循环
+//
+// TSwapChain需要提供：
+//   typename TSwapChain::Frame
+//   AcquireResult Acquire(Frame& frame);
+//   void Release(Frame& frame);
+//   WaitResult Wait();              // 阻塞在新帧事件和终止事件上
+//
+// TFrameSink需要提供：
+//   void OnFrame(const typename TSwapChain::Frame& frame);
+//   void OnDrained();               // 每次取空后调用，定速时在此发布到期的挂起帧
+//
+// 每次唤醒后在一个紧凑循环里取空所有可用缓冲区，直到Pending才重新等待，
+// 因此一次事件可以处理突发的多帧；Failed立即退出，由调用者负责重建交换链。
+//
+template <typename TSwapChain, typename TFrameSink>
+class FrameWorkerLoop
+{
+public:
+    using Frame = typename TSwapChain::Frame;
+
+    FrameWorkerLoop(TSwapChain& swapChain, TFrameSink& sink)
+        : m_SwapChain(swapChain), m_Sink(sink)
+    {
+    }
+
+    //
+    // 运行直到终止或交换链失效
+    //
+    WorkerExitReason Run()
+    {
+        for (;;)
+        {
+            if (!Drain())
+            {
+                return WorkerExitReason::AcquireFailed;
+            }
+
+            WaitResult wait = m_SwapChain.Wait();
+            m_Stats.Wakeups++;
+
+            if (wait == WaitResult::Terminate)
+            {
+                return WorkerExitReason::Terminated;
+            }
+
+            if (wait == WaitResult::Timeout)
+            {
+                m_Stats.Timeouts++;
+            }
+
+            if (wait == WaitResult::Deadline)
+            {
+                m_Stats.Deadlines++;
+            }
+
+            m_LastWait = wait;
+        }
+    }
+
+    //
+    // 取空当前所有可用帧，交换链失效时返回false
+    //
+    bool Drain()
+    {
+        uint64_t burst = 0;
+
+        for (;;)
+        {
+            Frame frame{};
+            AcquireResult result = m_SwapChain.Acquire(frame);
+
+            if (result == AcquireResult::Pending)
+            {
+                break;
+            }
+
+            if (result == AcquireResult::Failed)
+            {
+                return false;
+            }
+
+            m_Sink.OnFrame(frame);
+            m_SwapChain.Release(frame);
+
+            m_Stats.FramesProcessed++;
+            burst++;
+        }
+
+        // 定时器唤醒本来就不期望有新帧
+        if (burst == 0 && m_Stats.Wakeups != 0 && m_LastWait != WaitResult::Deadline)
+        {
+            m_Stats.EmptyWakeups++;
+        }
+
+        if (burst > m_Stats.MaxBurst)
+        {
+            m_Stats.MaxBurst = burst;
+        }
+
+        m_Sink.OnDrained();
+        return true;
+    }
+
+    const FrameWorkerStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    TSwapChain& m_SwapChain;
+    TFrameSink& m_Sink;
+    FrameWorkerStats m_Stats;
+    WaitResult m_LastWait = WaitResult::FrameAvailable;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,399 @@
+/*++
+
+Module Name:
+    IncrementalConvert.h
+
+Abstract:
+    增量NV12转换：每个监视器持有一份常驻NV12图像，每帧只重新转换
+    （按色度对齐的）脏矩形，移动区域尽量在NV12图像上直接执行
+
+    偶数对齐的移动区域（源与目标的坐标、宽高均为偶数）在Y与UV平面上直接
+    memmove，结果与重新转换逐位一致：每个2x2色度块只由它覆盖的四个像素决定。
+    其余移动区域的目标按脏区域重新转换。
+
+    帧环有多个槽位，每个槽位持有的是若干帧之前的图像。CopyTo按槽位上次持有的
+    帧号，只拷贝此后各帧损伤区域的并集（类似EGL buffer age），历史不足时整帧拷贝。
+    并集用DirtyRegionCoalescer合并去重，连续几帧重叠的损伤只拷贝一次。
+
+    设置了共享执行器时，需要重新转换的面积较大的帧按64行的行带拆成任务并行转换；
+    同一行带内的矩形由同一个任务依次转换，行带之间Y与UV行都不重叠。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "ColorConvert.h"
+#include "DirtyRegion.h"
+#include "MoveRegion.h"
+#include "TaskExecutor.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 单帧统计
+//
+struct IncrementalConvertStats
+{
+    int64_t ConvertedArea = 0;      // 重新转换的像素数
+    int64_t MovedArea = 0;          // 在NV12上直接移动的像素数
+    uint64_t CopiedBytes = 0;       // 最近一次CopyTo拷贝的字节数
+    bool FullFrame = false;         // 本帧整帧转换
+};
+
+class IncrementalNv12Converter
+{
+public:
+    static constexpr uint32_t DefaultHistoryDepth = 8;
+    static constexpr uint32_t MaxCopyRects = 16;
+    static constexpr int32_t BandRows = 64;                 // 并行转换的行带高度（偶数）
+    static constexpr int64_t MinParallelArea = 256 * 256;   // 小于此面积时在调用线程上转换
+
+    explicit IncrementalNv12Converter(
+        YuvMatrix matrix = YuvMatrix::Bt709,
+        YuvRange range = YuvRange::Limited,
+        CpuLevel level = DetectCpuLevel(),
+        uint32_t historyDepth = DefaultHistoryDepth)
+        : m_Converter(matrix, range, level),
+          m_HistoryDepth(historyDepth != 0 ? historyDepth : 1)
+    {
+    }
+
+    const Nv12Converter& Converter() const
+    {
+        return m_Converter;
+    }
+
+    int32_t Width() const
+    {
+        return m_Width;
+    }
+
+    int32_t Height() const
+    {
+        return m_Height;
+    }
+
+    //
+    // 常驻图像（行距等于宽度，UV平面紧随Y平面）
+    //
+    Nv12Surface Surface()
+    {
+        return { m_Pixels.data(), (size_t)m_Width, m_Pixels.data() + (size_t)m_Width * m_Height, (size_t)m_Width };
+    }
+
+    //
+    // 本帧NV12图像中发生变化的区域（按色度对齐，可能重叠）
+    //
+    const std::vector<FrameRect>& Damage() const
+    {
+        return m_Damage;
+    }
+
+    //
+    // 设置并行转换用的共享执行器，nullptr表示在调用线程上转换。执行器需比本对象存活更久
+    //
+    void SetExecutor(WorkStealingExecutor* executor)
+    {
+        m_Executor = executor;
+    }
+
+    const IncrementalConvertStats& LastStats() const
+    {
+        return m_Stats;
+    }
+
+    uint64_t CurrentFrame() const
+    {
+        return m_CurrentFrame;
+    }
+
+    //
+    // 常驻图像内容作废，下一次Update整帧转换
+    //
+    void Invalidate()
+    {
+        m_Valid = false;
+    }
+
+    //
+    // 用新一帧更新常驻图像。dirty/moves为相对上一次Update的变化（移动区域需已裁剪），
+    // frameNumber需单调递增。宽高需为偶数；尺寸变化或已作废时忽略dirty/moves整帧转换
+    //
+    bool Update(
+        const uint8_t* bgra,
+        size_t bgraPitch,
+        int32_t width,
+        int32_t height,
+        const FrameRect* dirty,
+        uint32_t dirtyCount,
+        const FrameMoveRegion* moves,
+        uint32_t moveCount,
+        uint64_t frameNumber)
+    {
+        if (width <= 0 || height <= 0 || (width & 1) != 0 || (height & 1) != 0 ||
+            frameNumber <= m_CurrentFrame)
+        {
+            return false;
+        }
+
+        m_Stats = IncrementalConvertStats();
+        m_Damage.clear();
+
+        const FrameRect fullFrame = { 0, 0, width, height };
+
+        if (!m_Valid || width != m_Width || height != m_Height)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_Pixels.resize((size_t)width * height * 3 / 2);
+            m_History.clear();
+            m_Valid = true;
+
+            // 此前的帧都无法增量追赶，作为已淘汰处理
+            m_EvictedFrame = frameNumber - 1;
+            m_Damage.push_back(fullFrame);
+            m_ConvertRects.assign(1, fullFrame);
+            ConvertRects(bgra, bgraPitch, width, height);
+            m_Stats.FullFrame = true;
+            RecordHistory(frameNumber);
+            return true;
+        }
+
+        Nv12Surface surface = Surface();
+
+        for (uint32_t i = 0; i < moveCount; i++)
+        {
+            const FrameMoveRegion& move = moves[i];
+            if (!IsChromaAligned(move))
+            {
+                m_Damage.push_back(AlignToChroma(move.Destination, width, height));
+                continue;
+            }
+
+            FrameMoveRegion chroma =
+            {
+                move.SourceX / 2,
+                move.SourceY / 2,
+                {
+                    move.Destination.Left / 2,
+                    move.Destination.Top / 2,
+                    move.Destination.Right / 2,
+                    move.Destination.Bottom / 2
+                }
+            };
+
+            ApplyMoveRegions(surface.Y, (uint32_t)surface.YPitch, 1, &move, 1, width, height);
+            ApplyMoveRegions(surface.UV, (uint32_t)surface.UVPitch, 2, &chroma, 1, (width + 1) / 2, (height + 1) / 2);
+            m_Damage.push_back(move.Destination);
+            m_Stats.MovedArea += move.Destination.Area();
+        }
+
+        for (uint32_t i = 0; i < dirtyCount; i++)
+        {
+            FrameRect aligned = AlignToChroma(dirty[i], width, height);
+            if (!aligned.IsEmpty())
+            {
+                m_Damage.push_back(aligned);
+            }
+        }
+
+        // m_Damage前moveCount项与移动区域一一对应，未对齐的移动区域目标与脏矩形一起重新转换
+        m_ConvertRects.clear();
+        for (size_t i = 0; i < m_Damage.size(); i++)
+        {
+            if (i >= moveCount || !IsChromaAligned(moves[i]))
+            {
+                m_ConvertRects.push_back(m_Damage[i]);
+            }
+        }
+        ConvertRects(bgra, bgraPitch, width, height);
+
+        RecordHistory(frameNumber);
+        return true;
+    }
+
+    //
+    // 把常驻图像同步到target。targetFrame为target当前持有的帧号（0表示未知），
+    // 只拷贝此后的损伤区域；历史不足或损伤过大时整帧拷贝
+    //
+    void CopyTo(const Nv12Surface& target, uint64_t targetFrame)
+    {
+        m_Stats.CopiedBytes = 0;
+        if (!m_Valid || m_CurrentFrame == 0 || targetFrame == m_CurrentFrame)
+        {
+            return;
+        }
+
+        bool full = targetFrame == 0 || targetFrame < m_EvictedFrame || targetFrame > m_CurrentFrame;
+
+        m_CopyRects.clear();
+        for (size_t i = 0; !full && i < m_History.size(); i++)
+        {
+            if (m_History[i].FrameNumber > targetFrame)
+            {
+                m_CopyRects.insert(m_CopyRects.end(), m_History[i].Damage.begin(), m_History[i].Damage.end());
+            }
+        }
+
+        // 连续几帧的损伤大多重叠（视频、同一窗格滚动），先合并为互不重叠的集合；
+        // 分散拷贝的行开销高于连续拷贝，合并后超过半帧时直接整帧拷贝
+        FrameRect merged[MaxCopyRects];
+        uint32_t mergedCount = 0;
+        if (!full)
+        {
+            mergedCount = m_CopyRegions.Coalesce(
+                m_CopyRects.data(), (uint32_t)m_CopyRects.size(), m_Width, m_Height, merged, MaxCopyRects);
+            full = m_CopyRegions.LastStats().OutputArea * 2 > (int64_t)m_Width * m_Height;
+        }
+
+        if (full)
+        {
+            merged[0] = { 0, 0, m_Width, m_Height };
+            mergedCount = 1;
+        }
+
+        const Nv12Surface source = Surface();
+        for (uint32_t i = 0; i < mergedCount; i++)
+        {
+            CopyRect(source, target, merged[i]);
+        }
+    }
+
+private:
+    struct HistoryEntry
+    {
+        uint64_t FrameNumber;
+        std::vector<FrameRect> Damage;
+    };
+
+    struct BandJob
+    {
+        const IncrementalNv12Converter* Self;
+        const uint8_t* Bgra;
+        size_t BgraPitch;
+        int32_t Width;
+        int32_t Height;
+        int32_t FirstRow;
+        Nv12Surface Surface;
+    };
+
+    //
+    // 转换m_ConvertRects（已按色度对齐，可能重叠）
+    //
+    void ConvertRects(const uint8_t* bgra, size_t bgraPitch, int32_t width, int32_t height)
+    {
+        int32_t top = height, bottom = 0;
+        for (const FrameRect& rect : m_ConvertRects)
+        {
+            m_Stats.ConvertedArea += rect.Area();
+            top = rect.Top < top ? rect.Top : top;
+            bottom = rect.Bottom > bottom ? rect.Bottom : bottom;
+        }
+
+        const Nv12Surface surface = Surface();
+        if (m_Executor == nullptr || m_Stats.ConvertedArea < MinParallelArea)
+        {
+            for (const FrameRect& rect : m_ConvertRects)
+            {
+                m_Converter.Convert(bgra, bgraPitch, width, height, surface, rect);
+            }
+            return;
+        }
+
+        BandJob job = { this, bgra, bgraPitch, width, height, top - top % BandRows, surface };
+        const uint32_t bands = (uint32_t)((bottom - job.FirstRow + BandRows - 1) / BandRows);
+        TaskGroup group;
+        m_Executor->ParallelFor(group, bands, &ConvertBand, &job);
+        m_Executor->Wait(group);
+    }
+
+    static void ConvertBand(void* context, uint32_t index)
+    {
+        const BandJob& job = *static_cast<const BandJob*>(context);
+        const int32_t top = job.FirstRow + (int32_t)index * BandRows;
+        const FrameRect band = { 0, top, job.Width, top + BandRows };
+
+        for (const FrameRect& rect : job.Self->m_ConvertRects)
+        {
+            const FrameRect part = IntersectRect(rect, band);
+            if (!part.IsEmpty())
+            {
+                job.Self->m_Converter.Convert(job.Bgra, job.BgraPitch, job.Width, job.Height, job.Surface, part);
+            }
+        }
+    }
+
+    static bool IsChromaAligned(const FrameMoveRegion& move)
+    {
+        return ((move.SourceX | move.SourceY | move.Destination.Left | move.Destination.Top |
+            move.Destination.Right | move.Destination.Bottom) & 1) == 0 &&
+            !move.Destination.IsEmpty();
+    }
+
+    void RecordHistory(uint64_t frameNumber)
+    {
+        // 复用最旧一项的向量，稳态下不分配内存
+        if (m_History.size() == m_HistoryDepth)
+        {
+            HistoryEntry oldest = std::move(m_History.front());
+            m_History.erase(m_History.begin());
+            m_EvictedFrame = oldest.FrameNumber;
+            oldest.FrameNumber = frameNumber;
+            oldest.Damage.assign(m_Damage.begin(), m_Damage.end());
+            m_History.push_back(std::move(oldest));
+        }
+        else
+        {
+            m_History.push_back({ frameNumber, m_Damage });
+        }
+
+        m_CurrentFrame = frameNumber;
+    }
+
+    void CopyRect(const Nv12Surface& source, const Nv12Surface& target, const FrameRect& rect)
+    {
+        const size_t lumaBytes = (size_t)rect.Width();
+        for (int32_t y = rect.Top; y < rect.Bottom; y++)
+        {
+            std::memcpy(target.Y + (size_t)y * target.YPitch + rect.Left,
+                source.Y + (size_t)y * source.YPitch + rect.Left, lumaBytes);
+        }
+
+        // 色度行与亮度行同宽（每2像素一对UV）
+        for (int32_t y = rect.Top / 2; y < rect.Bottom / 2; y++)
+        {
+            std::memcpy(target.UV + (size_t)y * target.UVPitch + rect.Left,
+                source.UV + (size_t)y * source.UVPitch + rect.Left, lumaBytes);
+        }
+
+        m_Stats.CopiedBytes += lumaBytes * (size_t)rect.Height() * 3 / 2;
+    }
+
+    Nv12Converter m_Converter;
+    uint32_t m_HistoryDepth;
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    bool m_Valid = false;
+    std::vector<uint8_t> m_Pixels;
+    std::vector<FrameRect> m_Damage;
+    std::vector<FrameRect> m_ConvertRects;
+    WorkStealingExecutor* m_Executor = nullptr;
+    std::vector<FrameRect> m_CopyRects;
+    DirtyRegionCoalescer m_CopyRegions;     // 16像素对齐，结果仍按色度对齐
+    std::vector<HistoryEntry> m_History;
+    uint64_t m_CurrentFrame = 0;
+    uint64_t m_EvictedFrame = 0;
+    IncrementalConvertStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
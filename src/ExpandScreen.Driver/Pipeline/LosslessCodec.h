@@ -0,0 +1,782 @@
+/*++
+
+Module Name:
+    LosslessCodec.h
+
+Abstract:
+    文字与界面区域的无损瓦片编解码
+
+    视频编码器在Wi-Fi可用的码率下会把小字号文字抹糊，而大多数脏区域是颜色很少的
+    平坦界面，无损压缩率很高。本编解码器把一个BGRA矩形编码为逐像素精确的字节流，
+    这些区域可以绕过视频编码器直接发送。
+
+    瓦片格式：[模式 1字节][宽 u16][高 u16][数据]，多字节整数为小端，变长整数为LEB128。
+    三种模式，编码器按内容选择：
+
+    调色板（不超过15种颜色）：颜色表后是按行的记号，每个记号一个字节
+        高4位为颜色下标（15表示“与上一行相同”），低4位r：游程r+1，r为15时游程为
+        16加后随的变长整数。游程不跨行。
+    预测（QOI式）：按行扫描，前一像素跨行延续，64项哈希颜色表
+        00xxxxxx 颜色表下标      01rrggbb 与前一像素的小差值（-2..1）
+        10gggggg 亮度差值+1字节  11000000..11101111 前一像素重复1..48次
+        0xF0 前一像素重复49+变长整数次   0xF1 与上一行相同1+变长整数个像素
+        0xFE BGR三字节（alpha不变）      0xFF BGRA四字节
+        0xF2..0xFD未定义，解码失败。游程与上一行匹配不更新颜色表。
+    原始：逐行BGRA，压缩后反而更大时使用，最坏情况只多5字节头。
+
+    游程长度与上一行匹配长度用FrameDiff的SIMD行比较内核求：与左移一个像素的自身
+    比较即得到相同像素的游程，与上一行比较即得到匹配长度。平坦区域因此按内存带宽
+    编码，逐像素的标量路径只处理文字边缘等真正变化的像素。
+
+    解码器对输入做完整的边界检查（数据来自网络），无效数据返回0。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "FrameDiff.h"
+#include "FrameTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+enum class LosslessTileMode : uint8_t
+{
+    Raw = 0,
+    Palette = 1,
+    Predictive = 2
+};
+
+constexpr uint32_t LosslessTileModeCount = 3;
+constexpr size_t LosslessTileHeaderSize = 5;
+
+namespace LosslessDetail {
+
+constexpr uint8_t OpIndex = 0x00;
+constexpr uint8_t OpDiff = 0x40;
+constexpr uint8_t OpLuma = 0x80;
+constexpr uint8_t OpRun = 0xC0;
+constexpr uint32_t MaxShortRun = 48;
+constexpr uint8_t OpLongRun = 0xF0;
+constexpr uint8_t OpUp = 0xF1;
+constexpr uint8_t OpBgr = 0xFE;
+constexpr uint8_t OpBgra = 0xFF;
+constexpr uint32_t PaletteUp = 15;
+constexpr uint32_t StartPixel = 0xFF000000u;   // 不透明黑
+
+inline uint32_t Hash(uint32_t pixel)
+{
+    const uint32_t b = pixel & 0xFF, g = (pixel >> 8) & 0xFF, r = (pixel >> 16) & 0xFF, a = pixel >> 24;
+    return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+inline uint8_t* PutVarint(uint8_t* out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+inline bool GetVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value)
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 7)
+    {
+        if (in == end)
+        {
+            return false;
+        }
+        const uint8_t byte = *in++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace LosslessDetail
+
+//
+// 累计统计
+//
+struct LosslessCodecStats
+{
+    uint64_t Tiles = 0;
+    uint64_t InputBytes = 0;        // 原始BGRA字节数
+    uint64_t OutputBytes = 0;       // 编码后字节数（含头）
+    uint64_t ModeTiles[LosslessTileModeCount] = {};
+};
+
+class LosslessTileEncoder
+{
+public:
+    static constexpr uint32_t MaxPaletteColors = 15;
+    static constexpr int32_t MaxTileSize = 65535;
+
+    explicit LosslessTileEncoder(CpuLevel level = DetectCpuLevel())
+        : m_Level(ClampCpuLevel(level)),
+          m_Match(SelectFirstDifference(m_Level))
+    {
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    const LosslessCodecStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    LosslessTileMode LastMode() const
+    {
+        return m_LastMode;
+    }
+
+    //
+    // 单个瓦片编码后的最大字节数
+    //
+    static size_t MaxEncodedSize(int32_t width, int32_t height)
+    {
+        return LosslessTileHeaderSize + (size_t)width * height * 4;
+    }
+
+    //
+    // 把rect内的像素（宽高不超过MaxTileSize）编码后追加到output，返回追加的字节数，
+    // rect为空或过大时返回0。output的容量被复用，稳态下不分配内存
+    //
+    size_t Encode(const uint8_t* bgra, size_t pitch, const FrameRect& rect, std::vector<uint8_t>& output)
+    {
+        const int32_t width = rect.Width();
+        const int32_t height = rect.Height();
+        if (rect.IsEmpty() || width > MaxTileSize || height > MaxTileSize)
+        {
+            return 0;
+        }
+
+        const size_t start = output.size();
+        output.resize(start + MaxEncodedSize(width, height));
+        uint8_t* header = output.data() + start;
+        const uint8_t* origin = bgra + (size_t)rect.Top * pitch + (size_t)rect.Left * 4;
+        const size_t rawBytes = (size_t)width * height * 4;
+
+        uint8_t* payload = header + LosslessTileHeaderSize;
+        uint8_t* end = nullptr;
+        LosslessTileMode mode;
+        if (CollectPalette(origin, pitch, width, height))
+        {
+            mode = LosslessTileMode::Palette;
+            end = EncodePalette(origin, pitch, width, height, payload, payload + rawBytes);
+        }
+        else
+        {
+            mode = LosslessTileMode::Predictive;
+            end = EncodePredictive(origin, pitch, width, height, payload, payload + rawBytes);
+        }
+
+        // 调色板与预测模式输出达到原始大小时提前放弃，改用原样存储，因此输出不超过MaxEncodedSize
+        if (end == nullptr || (size_t)(end - payload) >= rawBytes)
+        {
+            mode = LosslessTileMode::Raw;
+            end = payload;
+            for (int32_t y = 0; y < height; y++)
+            {
+                std::memcpy(end, origin + (size_t)y * pitch, (size_t)width * 4);
+                end += (size_t)width * 4;
+            }
+        }
+
+        header[0] = (uint8_t)mode;
+        header[1] = (uint8_t)width;
+        header[2] = (uint8_t)(width >> 8);
+        header[3] = (uint8_t)height;
+        header[4] = (uint8_t)(height >> 8);
+
+        const size_t written = (size_t)(end - header);
+        output.resize(start + written);
+
+        m_LastMode = mode;
+        m_Stats.Tiles++;
+        m_Stats.InputBytes += rawBytes;
+        m_Stats.OutputBytes += written;
+        m_Stats.ModeTiles[(uint32_t)mode]++;
+        return written;
+    }
+
+private:
+    //
+    // 从a开始与b逐像素相同的像素数。短游程先标量比较，避免为一两个像素调用内核
+    //
+    uint32_t MatchLength(const uint32_t* a, const uint32_t* b, uint32_t count) const
+    {
+        uint32_t n = 0;
+        for (; n < count && n < 8; n++)
+        {
+            if (a[n] != b[n])
+            {
+                return n;
+            }
+        }
+        if (n == count)
+        {
+            return n;
+        }
+        return n + (uint32_t)m_Match(reinterpret_cast<const uint8_t*>(a + n),
+            reinterpret_cast<const uint8_t*>(b + n), (int32_t)(count - n));
+    }
+
+    //
+    // 统计颜色，不超过MaxPaletteColors种时建立调色板
+    //
+    bool CollectPalette(const uint8_t* origin, size_t pitch, int32_t width, int32_t height)
+    {
+        m_PaletteSize = 0;
+        uint32_t last = 0;
+        bool haveLast = false;
+
+        for (int32_t y = 0; y < height; y++)
+        {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(origin + (size_t)y * pitch);
+            for (int32_t x = 0; x < width; x++)
+            {
+                const uint32_t pixel = row[x];
+                if (haveLast && pixel == last)
+                {
+                    continue;
+                }
+
+                haveLast = true;
+                last = pixel;
+                if (FindColor(pixel) < 0)
+                {
+                    if (m_PaletteSize == MaxPaletteColors)
+                    {
+                        return false;
+                    }
+                    m_Palette[m_PaletteSize++] = pixel;
+                }
+            }
+        }
+        return true;
+    }
+
+    int32_t FindColor(uint32_t pixel) const
+    {
+        for (uint32_t i = 0; i < m_PaletteSize; i++)
+        {
+            if (m_Palette[i] == pixel)
+            {
+                return (int32_t)i;
+            }
+        }
+        return -1;
+    }
+
+    static uint8_t* PutToken(uint8_t* out, uint32_t symbol, uint32_t run)
+    {
+        if (run <= 15)
+        {
+            *out++ = (uint8_t)((symbol << 4) | (run - 1));
+            return out;
+        }
+        *out++ = (uint8_t)((symbol << 4) | 15);
+        return LosslessDetail::PutVarint(out, run - 16);
+    }
+
+    //
+    // 调色板编码，超过limit时返回nullptr
+    //
+    uint8_t* EncodePalette(
+        const uint8_t* origin,
+        size_t pitch,
+        int32_t width,
+        int32_t height,
+        uint8_t* out,
+        const uint8_t* limit) const
+    {
+        // 调色板本身就不小于原始大小（例如1x1瓦片）时直接放弃
+        if ((size_t)(limit - out) <= 1 + (size_t)m_PaletteSize * 4)
+        {
+            return nullptr;
+        }
+
+        // 每个记号最多1字节加5字节变长整数；每写一个记号检查一次上限
+        limit = limit > out + 6 ? limit - 6 : out;
+
+        *out++ = (uint8_t)m_PaletteSize;
+        for (uint32_t i = 0; i < m_PaletteSize; i++)
+        {
+            std::memcpy(out, &m_Palette[i], 4);
+            out += 4;
+        }
+
+        const uint32_t* above = nullptr;
+        int32_t lastIndex = 0;
+        for (int32_t y = 0; y < height; y++)
+        {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(origin + (size_t)y * pitch);
+            uint32_t x = 0;
+            while (x < (uint32_t)width)
+            {
+                if (out >= limit)
+                {
+                    return nullptr;
+                }
+
+                const uint32_t remaining = (uint32_t)width - x;
+                const uint32_t run = 1 + MatchLength(row + x + 1, row + x, remaining - 1);
+
+                if (above != nullptr && row[x] == above[x])
+                {
+                    const uint32_t up = MatchLength(row + x, above + x, remaining);
+                    if (up > run)
+                    {
+                        out = PutToken(out, LosslessDetail::PaletteUp, up);
+                        x += up;
+                        continue;
+                    }
+                }
+
+                if (m_Palette[lastIndex] != row[x])
+                {
+                    lastIndex = FindColor(row[x]);
+                }
+                out = PutToken(out, (uint32_t)lastIndex, run);
+                x += run;
+            }
+            above = row;
+        }
+        return out;
+    }
+
+    //
+    // QOI式预测编码，超过limit时返回nullptr
+    //
+    uint8_t* EncodePredictive(
+        const uint8_t* origin,
+        size_t pitch,
+        int32_t width,
+        int32_t height,
+        uint8_t* out,
+        const uint8_t* limit)
+    {
+        using namespace LosslessDetail;
+
+        std::memset(m_Index, 0, sizeof(m_Index));
+        uint32_t previous = StartPixel;
+        const uint32_t* above = nullptr;
+
+        // 每个像素最多5字节，变长整数最多5字节；每处理一个记号检查一次上限
+        limit = limit > out + 10 ? limit - 10 : out;
+
+        for (int32_t y = 0; y < height; y++)
+        {
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(origin + (size_t)y * pitch);
+            uint32_t x = 0;
+            while (x < (uint32_t)width)
+            {
+                if (out >= limit)
+                {
+                    return nullptr;
+                }
+
+                const uint32_t pixel = row[x];
+                const uint32_t remaining = (uint32_t)width - x;
+
+                uint32_t run = 0;
+                if (pixel == previous)
+                {
+                    run = 1 + MatchLength(row + x + 1, row + x, remaining - 1);
+                }
+
+                if (above != nullptr && pixel == above[x])
+                {
+                    const uint32_t up = MatchLength(row + x, above + x, remaining);
+                    if (up > run && up >= 2)
+                    {
+                        *out++ = OpUp;
+                        out = PutVarint(out, up - 1);
+                        x += up;
+                        previous = row[x - 1];
+                        continue;
+                    }
+                }
+
+                if (run != 0)
+                {
+                    if (run <= MaxShortRun)
+                    {
+                        *out++ = (uint8_t)(OpRun | (run - 1));
+                    }
+                    else
+                    {
+                        *out++ = OpLongRun;
+                        out = PutVarint(out, run - MaxShortRun - 1);
+                    }
+                    x += run;
+                    continue;
+                }
+
+                const uint32_t hash = Hash(pixel);
+                if (m_Index[hash] == pixel)
+                {
+                    *out++ = (uint8_t)(OpIndex | hash);
+                }
+                else
+                {
+                    m_Index[hash] = pixel;
+
+                    if ((pixel >> 24) == (previous >> 24))
+                    {
+                        const int32_t db = (int32_t)(pixel & 0xFF) - (int32_t)(previous & 0xFF);
+                        const int32_t dg = (int32_t)((pixel >> 8) & 0xFF) - (int32_t)((previous >> 8) & 0xFF);
+                        const int32_t dr = (int32_t)((pixel >> 16) & 0xFF) - (int32_t)((previous >> 16) & 0xFF);
+                        const int8_t vb = (int8_t)db, vg = (int8_t)dg, vr = (int8_t)dr;
+                        const int32_t drg = vr - vg, dbg = vb - vg;
+
+                        if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1)
+                        {
+                            *out++ = (uint8_t)(OpDiff | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+                        }
+                        else if (vg >= -32 && vg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+                        {
+                            *out++ = (uint8_t)(OpLuma | (vg + 32));
+                            *out++ = (uint8_t)(((drg + 8) << 4) | (dbg + 8));
+                        }
+                        else
+                        {
+                            *out++ = OpBgr;
+                            out[0] = (uint8_t)pixel;
+                            out[1] = (uint8_t)(pixel >> 8);
+                            out[2] = (uint8_t)(pixel >> 16);
+                            out += 3;
+                        }
+                    }
+                    else
+                    {
+                        *out++ = OpBgra;
+                        std::memcpy(out, &pixel, 4);
+                        out += 4;
+                    }
+                }
+
+                previous = pixel;
+                x++;
+            }
+            above = row;
+        }
+        return out;
+    }
+
+    CpuLevel m_Level;
+    RowDifferenceFunction m_Match;
+    uint32_t m_Palette[MaxPaletteColors] = {};
+    uint32_t m_PaletteSize = 0;
+    uint32_t m_Index[64] = {};
+    LosslessTileMode m_LastMode = LosslessTileMode::Raw;
+    LosslessCodecStats m_Stats;
+};
+
+class LosslessTileDecoder
+{
+public:
+    //
+    // 读取瓦片头，数据不足或模式无效时返回false
+    //
+    static bool PeekHeader(const uint8_t* data, size_t size, LosslessTileMode& mode, int32_t& width, int32_t& height)
+    {
+        if (size < LosslessTileHeaderSize || data[0] >= LosslessTileModeCount)
+        {
+            return false;
+        }
+        mode = (LosslessTileMode)data[0];
+        width = data[1] | (data[2] << 8);
+        height = data[3] | (data[4] << 8);
+        return width != 0 && height != 0;
+    }
+
+    //
+    // 把一个瓦片解码到bgra（frameWidth x frameHeight）的(left, top)处，
+    // 返回消耗的字节数；数据无效或越界时返回0，目标内容可能已被部分改写
+    //
+    size_t Decode(
+        const uint8_t* data,
+        size_t size,
+        uint8_t* bgra,
+        size_t pitch,
+        int32_t frameWidth,
+        int32_t frameHeight,
+        int32_t left,
+        int32_t top)
+    {
+        LosslessTileMode mode;
+        int32_t width, height;
+        if (!PeekHeader(data, size, mode, width, height) ||
+            left < 0 || top < 0 || left > frameWidth - width || top > frameHeight - height)
+        {
+            return 0;
+        }
+
+        const uint8_t* in = data + LosslessTileHeaderSize;
+        const uint8_t* end = data + size;
+        uint8_t* origin = bgra + (size_t)top * pitch + (size_t)left * 4;
+        bool ok = false;
+
+        switch (mode)
+        {
+        case LosslessTileMode::Raw:
+            ok = DecodeRaw(in, end, origin, pitch, width, height);
+            break;
+        case LosslessTileMode::Palette:
+            ok = DecodePalette(in, end, origin, pitch, width, height);
+            break;
+        case LosslessTileMode::Predictive:
+            ok = DecodePredictive(in, end, origin, pitch, width, height);
+            break;
+        }
+
+        return ok ? (size_t)(in - data) : 0;
+    }
+
+private:
+    static void Fill(uint32_t* row, uint32_t pixel, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            row[i] = pixel;
+        }
+    }
+
+    static bool DecodeRaw(const uint8_t*& in, const uint8_t* end, uint8_t* origin, size_t pitch,
+        int32_t width, int32_t height)
+    {
+        const size_t rowBytes = (size_t)width * 4;
+        if ((size_t)(end - in) < rowBytes * height)
+        {
+            return false;
+        }
+        for (int32_t y = 0; y < height; y++)
+        {
+            std::memcpy(origin + (size_t)y * pitch, in, rowBytes);
+            in += rowBytes;
+        }
+        return true;
+    }
+
+    static bool DecodePalette(const uint8_t*& in, const uint8_t* end, uint8_t* origin, size_t pitch,
+        int32_t width, int32_t height)
+    {
+        if (in == end)
+        {
+            return false;
+        }
+        const uint32_t colors = *in++;
+        if (colors == 0 || colors > LosslessTileEncoder::MaxPaletteColors || (size_t)(end - in) < colors * 4)
+        {
+            return false;
+        }
+        uint32_t palette[LosslessTileEncoder::MaxPaletteColors];
+        std::memcpy(palette, in, colors * 4);
+        in += colors * 4;
+
+        const uint32_t* above = nullptr;
+        for (int32_t y = 0; y < height; y++)
+        {
+            uint32_t* row = reinterpret_cast<uint32_t*>(origin + (size_t)y * pitch);
+            uint32_t x = 0;
+            while (x < (uint32_t)width)
+            {
+                if (in == end)
+                {
+                    return false;
+                }
+                const uint8_t token = *in++;
+                const uint32_t symbol = token >> 4;
+                uint32_t run = (token & 15) + 1;
+                if (run == 16)
+                {
+                    uint32_t extra;
+                    if (!LosslessDetail::GetVarint(in, end, extra) || extra > (uint32_t)width)
+                    {
+                        return false;
+                    }
+                    run += extra;
+                }
+                if (run > (uint32_t)width - x)
+                {
+                    return false;
+                }
+
+                if (symbol == LosslessDetail::PaletteUp)
+                {
+                    if (above == nullptr)
+                    {
+                        return false;
+                    }
+                    std::memcpy(row + x, above + x, (size_t)run * 4);
+                }
+                else
+                {
+                    if (symbol >= colors)
+                    {
+                        return false;
+                    }
+                    Fill(row + x, palette[symbol], run);
+                }
+                x += run;
+            }
+            above = row;
+        }
+        return true;
+    }
+
+    bool DecodePredictive(const uint8_t*& in, const uint8_t* end, uint8_t* origin, size_t pitch,
+        int32_t width, int32_t height)
+    {
+        using namespace LosslessDetail;
+
+        std::memset(m_Index, 0, sizeof(m_Index));
+        uint32_t previous = StartPixel;
+        const uint32_t* above = nullptr;
+
+        for (int32_t y = 0; y < height; y++)
+        {
+            uint32_t* row = reinterpret_cast<uint32_t*>(origin + (size_t)y * pitch);
+            uint32_t x = 0;
+            while (x < (uint32_t)width)
+            {
+                if (in == end)
+                {
+                    return false;
+                }
+                const uint8_t op = *in++;
+                const uint32_t remaining = (uint32_t)width - x;
+
+                if (op == OpUp || op == OpLongRun)
+                {
+                    uint32_t value;
+                    if (!GetVarint(in, end, value) || value >= remaining)
+                    {
+                        return false;
+                    }
+                    if (op == OpUp)
+                    {
+                        const uint32_t count = value + 1;
+                        if (above == nullptr || count < 2)
+                        {
+                            return false;
+                        }
+                        std::memcpy(row + x, above + x, (size_t)count * 4);
+                        x += count;
+                        previous = row[x - 1];
+                    }
+                    else
+                    {
+                        const uint32_t count = value + MaxShortRun + 1;
+                        if (count > remaining)
+                        {
+                            return false;
+                        }
+                        Fill(row + x, previous, count);
+                        x += count;
+                    }
+                    continue;
+                }
+
+                if (op >= OpRun && op < OpLongRun)
+                {
+                    const uint32_t count = (uint32_t)(op & 0x3F) + 1;
+                    if (count > remaining)
+                    {
+                        return false;
+                    }
+                    Fill(row + x, previous, count);
+                    x += count;
+                    continue;
+                }
+
+                uint32_t pixel;
+                if (op == OpBgr)
+                {
+                    if (end - in < 3)
+                    {
+                        return false;
+                    }
+                    pixel = (previous & 0xFF000000u) | in[0] | (in[1] << 8) | ((uint32_t)in[2] << 16);
+                    in += 3;
+                    m_Index[Hash(pixel)] = pixel;
+                }
+                else if (op == OpBgra)
+                {
+                    if (end - in < 4)
+                    {
+                        return false;
+                    }
+                    std::memcpy(&pixel, in, 4);
+                    in += 4;
+                    m_Index[Hash(pixel)] = pixel;
+                }
+                else if (op < OpDiff)
+                {
+                    pixel = m_Index[op];
+                }
+                else if (op < OpLuma)
+                {
+                    const int32_t dr = ((op >> 4) & 3) - 2, dg = ((op >> 2) & 3) - 2, db = (op & 3) - 2;
+                    pixel = Offset(previous, dr, dg, db);
+                    m_Index[Hash(pixel)] = pixel;
+                }
+                else if (op < OpRun)
+                {
+                    if (in == end)
+                    {
+                        return false;
+                    }
+                    const uint8_t second = *in++;
+                    const int32_t dg = (op & 0x3F) - 32;
+                    pixel = Offset(previous, dg + (second >> 4) - 8, dg, dg + (second & 15) - 8);
+                    m_Index[Hash(pixel)] = pixel;
+                }
+                else
+                {
+                    // 0xF2..0xFD未定义
+                    return false;
+                }
+
+                row[x++] = pixel;
+                previous = pixel;
+            }
+            above = row;
+        }
+        return true;
+    }
+
+    static uint32_t Offset(uint32_t pixel, int32_t dr, int32_t dg, int32_t db)
+    {
+        const uint32_t b = (uint32_t)((int32_t)(pixel & 0xFF) + db) & 0xFF;
+        const uint32_t g = (uint32_t)((int32_t)((pixel >> 8) & 0xFF) + dg) & 0xFF;
+        const uint32_t r = (uint32_t)((int32_t)((pixel >> 16) & 0xFF) + dr) & 0xFF;
+        return (pixel & 0xFF000000u) | (r << 16) | (g << 8) | b;
+    }
+
+    uint32_t m_Index[64] = {};
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,197 @@
+/*++
+
+Module Name:
+    MoveRegion.h
+
+Abstract:
+    移动区域（滚动提示）处理
+
+    IddCx在滚动、拖动窗口时报告移动区域：目标区域的内容等于上一帧源区域的内容。
+    消费者持有上一帧图像时，可以先在本地执行移动（内存搬移），
+    再只转换/编码剩余的脏矩形，把一次滚动变成廉价拷贝加一条细的脏条带。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 把移动区域裁剪到帧内（源和目标同时裁剪），丢弃空区域和零位移区域，
+// 原地压缩数组，返回保留的数量
+//
+inline uint32_t ClipMoveRegions(
+    FrameMoveRegion* moves,
+    uint32_t count,
+    int32_t frameWidth,
+    int32_t frameHeight)
+{
+    const FrameRect frame = { 0, 0, frameWidth, frameHeight };
+    uint32_t kept = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        FrameMoveRegion move = moves[i];
+        int32_t dx = move.Destination.Left - move.SourceX;
+        int32_t dy = move.Destination.Top - move.SourceY;
+
+        if (dx == 0 && dy == 0)
+        {
+            continue;
+        }
+
+        // 目标裁剪到帧内，再把对应的源平移回去裁剪，取交集
+        FrameRect destination = IntersectRect(move.Destination, frame);
+        FrameRect source = IntersectRect(
+            { destination.Left - dx, destination.Top - dy, destination.Right - dx, destination.Bottom - dy },
+            frame);
+        destination = { source.Left + dx, source.Top + dy, source.Right + dx, source.Bottom + dy };
+
+        if (destination.IsEmpty())
+        {
+            continue;
+        }
+
+        moves[kept].SourceX = source.Left;
+        moves[kept].SourceY = source.Top;
+        moves[kept].Destination = destination;
+        kept++;
+    }
+
+    return kept;
+}
+
+//
+// 在持有上一帧内容的图像上原地执行移动区域，正确处理源与目标重叠。
+// 不做裁剪：移动区域必须已经过ClipMoveRegions裁剪到frameWidth x frameHeight内，
+// 调试版本断言源与目标都在图像内
+//
+inline void ApplyMoveRegions(
+    uint8_t* pixels,
+    uint32_t pitch,
+    uint32_t bytesPerPixel,
+    const FrameMoveRegion* moves,
+    uint32_t count,
+    int32_t frameWidth,
+    int32_t frameHeight)
+{
+    (void)frameWidth;
+    (void)frameHeight;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const FrameMoveRegion& move = moves[i];
+        const int32_t width = move.Destination.Width();
+        const int32_t height = move.Destination.Height();
+        const size_t rowBytes = (size_t)width * bytesPerPixel;
+
+        if (width <= 0 || height <= 0)
+        {
+            continue;
+        }
+
+        assert(move.Destination.Left >= 0 && move.Destination.Top >= 0 &&
+            move.Destination.Right <= frameWidth && move.Destination.Bottom <= frameHeight);
+        assert(move.SourceX >= 0 && move.SourceY >= 0 &&
+            move.SourceX + width <= frameWidth && move.SourceY + height <= frameHeight);
+
+        // 向下移动时自底向上拷贝，避免覆盖尚未读取的源行；行内用memmove处理水平重叠
+        const bool bottomUp = move.Destination.Top > move.SourceY;
+
+        for (int32_t row = 0; row < height; row++)
+        {
+            int32_t y = bottomUp ? (height - 1 - row) : row;
+            uint8_t* destination = pixels +
+                (size_t)(move.Destination.Top + y) * pitch + (size_t)move.Destination.Left * bytesPerPixel;
+            const uint8_t* source = pixels +
+                (size_t)(move.SourceY + y) * pitch + (size_t)move.SourceX * bytesPerPixel;
+            std::memmove(destination, source, rowBytes);
+        }
+    }
+}
+
+//
+// 移动区域带来的节省：目标区域中未被脏矩形覆盖的部分无需转换和编码。
+// 按像素精确统计，脏矩形之间、移动区域之间的重叠只计一次
+//
+inline int64_t MovedAreaNotDirty(
+    const FrameMoveRegion* moves,
+    uint32_t moveCount,
+    const FrameRect* dirtyRects,
+    uint32_t dirtyCount)
+{
+    int64_t saved = 0;
+
+    for (uint32_t i = 0; i < moveCount; i++)
+    {
+        const FrameRect& destination = moves[i].Destination;
+
+        for (int32_t y = destination.Top; y < destination.Bottom; y++)
+        {
+            for (int32_t x = destination.Left; x < destination.Right; )
+            {
+                // 跳过被之前的移动区域或任一脏矩形覆盖的像素段
+                int32_t skipTo = x;
+                for (uint32_t j = 0; j < i; j++)
+                {
+                    const FrameRect& other = moves[j].Destination;
+                    if (y >= other.Top && y < other.Bottom && x >= other.Left && x < other.Right)
+                    {
+                        skipTo = other.Right > skipTo ? other.Right : skipTo;
+                    }
+                }
+                for (uint32_t j = 0; j < dirtyCount; j++)
+                {
+                    const FrameRect& dirty = dirtyRects[j];
+                    if (y >= dirty.Top && y < dirty.Bottom && x >= dirty.Left && x < dirty.Right)
+                    {
+                        skipTo = dirty.Right > skipTo ? dirty.Right : skipTo;
+                    }
+                }
+
+                if (skipTo > x)
+                {
+                    x = skipTo;
+                    continue;
+                }
+
+                // 找到下一个被覆盖的位置，统计中间的未覆盖段
+                int32_t end = destination.Right;
+                for (uint32_t j = 0; j < i; j++)
+                {
+                    const FrameRect& other = moves[j].Destination;
+                    if (y >= other.Top && y < other.Bottom && other.Left > x && other.Left < end)
+                    {
+                        end = other.Left;
+                    }
+                }
+                for (uint32_t j = 0; j < dirtyCount; j++)
+                {
+                    const FrameRect& dirty = dirtyRects[j];
+                    if (y >= dirty.Top && y < dirty.Bottom && dirty.Left > x && dirty.Left < end)
+                    {
+                        end = dirty.Left;
+                    }
+                }
+
+                saved += end - x;
+                x = end;
+            }
+        }
+    }
+
+    return saved;
+}
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,647 @@
+/*++
+
+Module Name:
+    P010Convert.h
+
+Abstract:
+    BGRA8 / R10G10B10A2 到P010的10位颜色转换
+
+    P010与NV12布局相同，但每个样本16位，10位有效值放在高位（值 << 6）。
+    8位源不做抖动，按目标范围直接扩展：有限范围的结果恰为8位结果的4倍
+    （未舍入前），完整范围按1023/255放大，渐变在10位下不再出现8位的量化台阶。
+
+    定点实现与ColorConvert.h相同的思路：亮度系数按2^13缩放（8位源完整范围的
+    放大系数在2^14下超出int16），色度对2x2像素求和后乘以同一组系数（等效2^15）。
+    标量、SSE4.1、AVX2、AVX-512结果逐位一致。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "ColorConvert.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+constexpr int Yuv10LumaShift = 13;
+constexpr int Yuv10ChromaShift = 15;
+constexpr int32_t Yuv10Max = 1023;
+
+//
+// 10位输出的定点系数，sourceBits为源每分量位数（8或10）
+//
+inline YuvCoefficients MakeYuv10Coefficients(YuvMatrix matrix, YuvRange range, int sourceBits)
+{
+    const double kr = matrix == YuvMatrix::Bt709 ? 0.2126 : 0.299;
+    const double kb = matrix == YuvMatrix::Bt709 ? 0.0722 : 0.114;
+    const bool full = range == YuvRange::Full;
+    const double sourceMax = (double)((1 << sourceBits) - 1);
+    const double lumaScale = (full ? 1023.0 : 876.0) / sourceMax * (1 << Yuv10LumaShift);
+    const double chromaScale = (full ? 1023.0 : 896.0) / sourceMax * (1 << Yuv10LumaShift);
+
+    YuvCoefficients c;
+    c.YR = (int16_t)std::lround(kr * lumaScale);
+    c.YB = (int16_t)std::lround(kb * lumaScale);
+    c.YG = (int16_t)(std::lround(lumaScale) - c.YR - c.YB);
+
+    c.UB = (int16_t)std::lround(0.5 * chromaScale);
+    c.UR = (int16_t)std::lround(-kr / (2.0 * (1.0 - kb)) * chromaScale);
+    c.UG = (int16_t)(-c.UB - c.UR);
+
+    c.VR = (int16_t)std::lround(0.5 * chromaScale);
+    c.VB = (int16_t)std::lround(-kb / (2.0 * (1.0 - kr)) * chromaScale);
+    c.VG = (int16_t)(-c.VR - c.VB);
+
+    c.YBias = ((full ? 0 : 64) << Yuv10LumaShift) + (1 << (Yuv10LumaShift - 1));
+    c.ChromaBias = (512 << Yuv10ChromaShift) + (1 << (Yuv10ChromaShift - 1));
+    return c;
+}
+
+//
+// P010目标图像（不持有内存），行距以字节计
+//
+struct P010Surface
+{
+    uint8_t* Y;
+    size_t YPitch;
+    uint8_t* UV;
+    size_t UVPitch;
+};
+
+inline bool IsP010Source(PixelFormat format)
+{
+    return format == PixelFormat::Bgra8 || format == PixelFormat::R10G10B10A2;
+}
+
+namespace ColorDetail {
+
+inline uint16_t ToP010(int32_t value)
+{
+    return (uint16_t)((value < 0 ? 0 : (value > Yuv10Max ? Yuv10Max : value)) << 6);
+}
+
+// 取出一个源像素的R、G、B分量
+template <PixelFormat Source>
+inline void LoadRgb(const uint8_t* pixel, int32_t& r, int32_t& g, int32_t& b)
+{
+    if (Source == PixelFormat::Bgra8)
+    {
+        b = pixel[0];
+        g = pixel[1];
+        r = pixel[2];
+    }
+    else
+    {
+        const uint32_t value = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8) |
+            ((uint32_t)pixel[2] << 16) | ((uint32_t)pixel[3] << 24);
+        r = (int32_t)(value & 0x3FF);
+        g = (int32_t)((value >> 10) & 0x3FF);
+        b = (int32_t)((value >> 20) & 0x3FF);
+    }
+}
+
+//
+// 转换一对像素行：输出两行Y与一行UV（16位样本）。begin/end为偶数像素坐标
+//
+template <PixelFormat Source>
+inline void ConvertRowPairP010Scalar(
+    const uint8_t* src0,
+    const uint8_t* src1,
+    uint16_t* y0,
+    uint16_t* y1,
+    uint16_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    for (uint32_t x = begin; x < end; x += 2)
+    {
+        int32_t r[4], g[4], b[4];
+        LoadRgb<Source>(src0 + (size_t)x * 4, r[0], g[0], b[0]);
+        LoadRgb<Source>(src0 + (size_t)x * 4 + 4, r[1], g[1], b[1]);
+        LoadRgb<Source>(src1 + (size_t)x * 4, r[2], g[2], b[2]);
+        LoadRgb<Source>(src1 + (size_t)x * 4 + 4, r[3], g[3], b[3]);
+
+        y0[x] = ToP010((c.YB * b[0] + c.YG * g[0] + c.YR * r[0] + c.YBias) >> Yuv10LumaShift);
+        y0[x + 1] = ToP010((c.YB * b[1] + c.YG * g[1] + c.YR * r[1] + c.YBias) >> Yuv10LumaShift);
+        y1[x] = ToP010((c.YB * b[2] + c.YG * g[2] + c.YR * r[2] + c.YBias) >> Yuv10LumaShift);
+        y1[x + 1] = ToP010((c.YB * b[3] + c.YG * g[3] + c.YR * r[3] + c.YBias) >> Yuv10LumaShift);
+
+        const int32_t sb = b[0] + b[1] + b[2] + b[3];
+        const int32_t sg = g[0] + g[1] + g[2] + g[3];
+        const int32_t sr = r[0] + r[1] + r[2] + r[3];
+
+        uv[x] = ToP010((c.UB * sb + c.UG * sg + c.UR * sr + c.ChromaBias) >> Yuv10ChromaShift);
+        uv[x + 1] = ToP010((c.VB * sb + c.VG * sg + c.VR * sr + c.ChromaBias) >> Yuv10ChromaShift);
+    }
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+//
+// SIMD内核与NV12内核相同，区别在于拆分源像素与输出：
+//     BGRA8:       and 0x00FF00FF -> (B, R)，srli_epi16 8 -> (G, A)
+//     R10G10B10A2: (p & 0x3FF) | ((p >> 4) & 0x03FF0000) -> (R, B)，(p >> 10) & 0x3FF -> (G, 0)
+// 第一对分量的系数顺序随源格式交换。10位分量四像素求和最大4092，仍在int16内。
+// 结果钳位到1023后用packus_epi32打包成16位并左移6位。
+//
+
+struct P010ConstantsSse41
+{
+    __m128i LowMask, HighMask, GreenMask;
+    __m128i Y01, Y2;
+    __m128i U01, U2;
+    __m128i V01, V2;
+    __m128i YBias;
+    __m128i ChromaBias;
+    __m128i Max;
+};
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_SSE41
+inline P010ConstantsSse41 MakeP010ConstantsSse41(const YuvCoefficients& c)
+{
+    const bool bgra = Source == PixelFormat::Bgra8;
+    P010ConstantsSse41 k;
+    k.LowMask = _mm_set1_epi32(bgra ? 0x00FF00FF : 0x000003FF);
+    k.HighMask = _mm_set1_epi32(0x03FF0000);
+    k.GreenMask = _mm_set1_epi32(0x000003FF);
+    k.Y01 = _mm_set1_epi32(bgra ? PackCoefficients(c.YB, c.YR) : PackCoefficients(c.YR, c.YB));
+    k.U01 = _mm_set1_epi32(bgra ? PackCoefficients(c.UB, c.UR) : PackCoefficients(c.UR, c.UB));
+    k.V01 = _mm_set1_epi32(bgra ? PackCoefficients(c.VB, c.VR) : PackCoefficients(c.VR, c.VB));
+    k.Y2 = _mm_set1_epi32(PackCoefficients(c.YG, 0));
+    k.U2 = _mm_set1_epi32(PackCoefficients(c.UG, 0));
+    k.V2 = _mm_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm_set1_epi32(c.YBias);
+    k.ChromaBias = _mm_set1_epi32(c.ChromaBias);
+    k.Max = _mm_set1_epi32(Yuv10Max);
+    return k;
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_SSE41
+inline void SplitP010Sse41(__m128i pixels, const P010ConstantsSse41& k, __m128i& pair01, __m128i& pair2)
+{
+    if (Source == PixelFormat::Bgra8)
+    {
+        pair01 = _mm_and_si128(pixels, k.LowMask);
+        pair2 = _mm_srli_epi16(pixels, 8);
+    }
+    else
+    {
+        pair01 = _mm_or_si128(_mm_and_si128(pixels, k.LowMask), _mm_and_si128(_mm_srli_epi32(pixels, 4), k.HighMask));
+        pair2 = _mm_and_si128(_mm_srli_epi32(pixels, 10), k.GreenMask);
+    }
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i LumaP010Sse41(__m128i pixels, const P010ConstantsSse41& k)
+{
+    __m128i pair01, pair2;
+    SplitP010Sse41<Source>(pixels, k, pair01, pair2);
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(pair01, k.Y01), _mm_madd_epi16(pair2, k.Y2));
+    return _mm_min_epi32(_mm_srai_epi32(_mm_add_epi32(sum, k.YBias), Yuv10LumaShift), k.Max);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i ChromaP010Sse41(__m128i row0, __m128i row1, const P010ConstantsSse41& k)
+{
+    __m128i a01, a2, b01, b2;
+    SplitP010Sse41<Source>(row0, k, a01, a2);
+    SplitP010Sse41<Source>(row1, k, b01, b2);
+    __m128i pair01 = _mm_add_epi16(a01, b01);
+    __m128i pair2 = _mm_add_epi16(a2, b2);
+    pair01 = _mm_add_epi16(pair01, _mm_srli_epi64(pair01, 32));
+    pair2 = _mm_add_epi16(pair2, _mm_srli_epi64(pair2, 32));
+    __m128i u = _mm_add_epi32(_mm_madd_epi16(pair01, k.U01), _mm_madd_epi16(pair2, k.U2));
+    __m128i v = _mm_add_epi32(_mm_madd_epi16(pair01, k.V01), _mm_madd_epi16(pair2, k.V2));
+    __m128i both = _mm_blend_epi16(u, _mm_slli_epi64(v, 32), 0xCC);
+    return _mm_min_epi32(_mm_srai_epi32(_mm_add_epi32(both, k.ChromaBias), Yuv10ChromaShift), k.Max);
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i PackP010Sse41(__m128i a, __m128i b)
+{
+    return _mm_slli_epi16(_mm_packus_epi32(a, b), 6);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_SSE41
+inline void ConvertRowPairP010Sse41(
+    const uint8_t* src0,
+    const uint8_t* src1,
+    uint16_t* y0,
+    uint16_t* y1,
+    uint16_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const P010ConstantsSse41 k = MakeP010ConstantsSse41<Source>(c);
+
+    uint32_t x = begin;
+    for (; x + 8 <= end; x += 8)
+    {
+        const __m128i* p0 = reinterpret_cast<const __m128i*>(src0 + (size_t)x * 4);
+        const __m128i* p1 = reinterpret_cast<const __m128i*>(src1 + (size_t)x * 4);
+        __m128i a0 = _mm_loadu_si128(p0), a1 = _mm_loadu_si128(p0 + 1);
+        __m128i b0 = _mm_loadu_si128(p1), b1 = _mm_loadu_si128(p1 + 1);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x),
+            PackP010Sse41(LumaP010Sse41<Source>(a0, k), LumaP010Sse41<Source>(a1, k)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x),
+            PackP010Sse41(LumaP010Sse41<Source>(b0, k), LumaP010Sse41<Source>(b1, k)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x),
+            PackP010Sse41(ChromaP010Sse41<Source>(a0, b0, k), ChromaP010Sse41<Source>(a1, b1, k)));
+    }
+
+    ConvertRowPairP010Scalar<Source>(src0, src1, y0, y1, uv, x, end, c);
+}
+
+struct P010ConstantsAvx2
+{
+    __m256i LowMask, HighMask, GreenMask;
+    __m256i Y01, Y2;
+    __m256i U01, U2;
+    __m256i V01, V2;
+    __m256i YBias;
+    __m256i ChromaBias;
+    __m256i Max;
+};
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX2
+inline P010ConstantsAvx2 MakeP010ConstantsAvx2(const YuvCoefficients& c)
+{
+    const bool bgra = Source == PixelFormat::Bgra8;
+    P010ConstantsAvx2 k;
+    k.LowMask = _mm256_set1_epi32(bgra ? 0x00FF00FF : 0x000003FF);
+    k.HighMask = _mm256_set1_epi32(0x03FF0000);
+    k.GreenMask = _mm256_set1_epi32(0x000003FF);
+    k.Y01 = _mm256_set1_epi32(bgra ? PackCoefficients(c.YB, c.YR) : PackCoefficients(c.YR, c.YB));
+    k.U01 = _mm256_set1_epi32(bgra ? PackCoefficients(c.UB, c.UR) : PackCoefficients(c.UR, c.UB));
+    k.V01 = _mm256_set1_epi32(bgra ? PackCoefficients(c.VB, c.VR) : PackCoefficients(c.VR, c.VB));
+    k.Y2 = _mm256_set1_epi32(PackCoefficients(c.YG, 0));
+    k.U2 = _mm256_set1_epi32(PackCoefficients(c.UG, 0));
+    k.V2 = _mm256_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm256_set1_epi32(c.YBias);
+    k.ChromaBias = _mm256_set1_epi32(c.ChromaBias);
+    k.Max = _mm256_set1_epi32(Yuv10Max);
+    return k;
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX2
+inline void SplitP010Avx2(__m256i pixels, const P010ConstantsAvx2& k, __m256i& pair01, __m256i& pair2)
+{
+    if (Source == PixelFormat::Bgra8)
+    {
+        pair01 = _mm256_and_si256(pixels, k.LowMask);
+        pair2 = _mm256_srli_epi16(pixels, 8);
+    }
+    else
+    {
+        pair01 = _mm256_or_si256(_mm256_and_si256(pixels, k.LowMask), _mm256_and_si256(_mm256_srli_epi32(pixels, 4), k.HighMask));
+        pair2 = _mm256_and_si256(_mm256_srli_epi32(pixels, 10), k.GreenMask);
+    }
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i LumaP010Avx2(__m256i pixels, const P010ConstantsAvx2& k)
+{
+    __m256i pair01, pair2;
+    SplitP010Avx2<Source>(pixels, k, pair01, pair2);
+    __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(pair01, k.Y01), _mm256_madd_epi16(pair2, k.Y2));
+    return _mm256_min_epi32(_mm256_srai_epi32(_mm256_add_epi32(sum, k.YBias), Yuv10LumaShift), k.Max);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i ChromaP010Avx2(__m256i row0, __m256i row1, const P010ConstantsAvx2& k)
+{
+    __m256i a01, a2, b01, b2;
+    SplitP010Avx2<Source>(row0, k, a01, a2);
+    SplitP010Avx2<Source>(row1, k, b01, b2);
+    __m256i pair01 = _mm256_add_epi16(a01, b01);
+    __m256i pair2 = _mm256_add_epi16(a2, b2);
+    pair01 = _mm256_add_epi16(pair01, _mm256_srli_epi64(pair01, 32));
+    pair2 = _mm256_add_epi16(pair2, _mm256_srli_epi64(pair2, 32));
+    __m256i u = _mm256_add_epi32(_mm256_madd_epi16(pair01, k.U01), _mm256_madd_epi16(pair2, k.U2));
+    __m256i v = _mm256_add_epi32(_mm256_madd_epi16(pair01, k.V01), _mm256_madd_epi16(pair2, k.V2));
+    __m256i both = _mm256_blend_epi32(u, _mm256_slli_epi64(v, 32), 0xAA);
+    return _mm256_min_epi32(_mm256_srai_epi32(_mm256_add_epi32(both, k.ChromaBias), Yuv10ChromaShift), k.Max);
+}
+
+// packus_epi32按128位通道交错，按64位重排恢复顺序
+EXPANDSCREEN_TARGET_AVX2
+inline __m256i PackP010Avx2(__m256i a, __m256i b)
+{
+    return _mm256_slli_epi16(_mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8), 6);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX2
+inline void ConvertRowPairP010Avx2(
+    const uint8_t* src0,
+    const uint8_t* src1,
+    uint16_t* y0,
+    uint16_t* y1,
+    uint16_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const P010ConstantsAvx2 k = MakeP010ConstantsAvx2<Source>(c);
+
+    uint32_t x = begin;
+    for (; x + 16 <= end; x += 16)
+    {
+        const __m256i* p0 = reinterpret_cast<const __m256i*>(src0 + (size_t)x * 4);
+        const __m256i* p1 = reinterpret_cast<const __m256i*>(src1 + (size_t)x * 4);
+        __m256i a0 = _mm256_loadu_si256(p0), a1 = _mm256_loadu_si256(p0 + 1);
+        __m256i b0 = _mm256_loadu_si256(p1), b1 = _mm256_loadu_si256(p1 + 1);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x),
+            PackP010Avx2(LumaP010Avx2<Source>(a0, k), LumaP010Avx2<Source>(a1, k)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x),
+            PackP010Avx2(LumaP010Avx2<Source>(b0, k), LumaP010Avx2<Source>(b1, k)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x),
+            PackP010Avx2(ChromaP010Avx2<Source>(a0, b0, k), ChromaP010Avx2<Source>(a1, b1, k)));
+    }
+
+    ConvertRowPairP010Scalar<Source>(src0, src1, y0, y1, uv, x, end, c);
+}
+
+EXPANDSCREEN_AVX512_BEGIN
+
+struct P010ConstantsAvx512
+{
+    __m512i LowMask, HighMask, GreenMask;
+    __m512i Y01, Y2;
+    __m512i U01, U2;
+    __m512i V01, V2;
+    __m512i YBias;
+    __m512i ChromaBias;
+    __m512i Max;
+};
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX512
+inline P010ConstantsAvx512 MakeP010ConstantsAvx512(const YuvCoefficients& c)
+{
+    const bool bgra = Source == PixelFormat::Bgra8;
+    P010ConstantsAvx512 k;
+    k.LowMask = _mm512_set1_epi32(bgra ? 0x00FF00FF : 0x000003FF);
+    k.HighMask = _mm512_set1_epi32(0x03FF0000);
+    k.GreenMask = _mm512_set1_epi32(0x000003FF);
+    k.Y01 = _mm512_set1_epi32(bgra ? PackCoefficients(c.YB, c.YR) : PackCoefficients(c.YR, c.YB));
+    k.U01 = _mm512_set1_epi32(bgra ? PackCoefficients(c.UB, c.UR) : PackCoefficients(c.UR, c.UB));
+    k.V01 = _mm512_set1_epi32(bgra ? PackCoefficients(c.VB, c.VR) : PackCoefficients(c.VR, c.VB));
+    k.Y2 = _mm512_set1_epi32(PackCoefficients(c.YG, 0));
+    k.U2 = _mm512_set1_epi32(PackCoefficients(c.UG, 0));
+    k.V2 = _mm512_set1_epi32(PackCoefficients(c.VG, 0));
+    k.YBias = _mm512_set1_epi32(c.YBias);
+    k.ChromaBias = _mm512_set1_epi32(c.ChromaBias);
+    k.Max = _mm512_set1_epi32(Yuv10Max);
+    return k;
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX512
+inline void SplitP010Avx512(__m512i pixels, const P010ConstantsAvx512& k, __m512i& pair01, __m512i& pair2)
+{
+    if (Source == PixelFormat::Bgra8)
+    {
+        pair01 = _mm512_and_si512(pixels, k.LowMask);
+        pair2 = _mm512_srli_epi16(pixels, 8);
+    }
+    else
+    {
+        pair01 = _mm512_or_si512(_mm512_and_si512(pixels, k.LowMask), _mm512_and_si512(_mm512_srli_epi32(pixels, 4), k.HighMask));
+        pair2 = _mm512_and_si512(_mm512_srli_epi32(pixels, 10), k.GreenMask);
+    }
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i LumaP010Avx512(__m512i pixels, const P010ConstantsAvx512& k)
+{
+    __m512i pair01, pair2;
+    SplitP010Avx512<Source>(pixels, k, pair01, pair2);
+    __m512i sum = _mm512_add_epi32(_mm512_madd_epi16(pair01, k.Y01), _mm512_madd_epi16(pair2, k.Y2));
+    return _mm512_min_epi32(_mm512_srai_epi32(_mm512_add_epi32(sum, k.YBias), Yuv10LumaShift), k.Max);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i ChromaP010Avx512(__m512i row0, __m512i row1, const P010ConstantsAvx512& k)
+{
+    __m512i a01, a2, b01, b2;
+    SplitP010Avx512<Source>(row0, k, a01, a2);
+    SplitP010Avx512<Source>(row1, k, b01, b2);
+    __m512i pair01 = _mm512_add_epi16(a01, b01);
+    __m512i pair2 = _mm512_add_epi16(a2, b2);
+    pair01 = _mm512_add_epi16(pair01, _mm512_srli_epi64(pair01, 32));
+    pair2 = _mm512_add_epi16(pair2, _mm512_srli_epi64(pair2, 32));
+    __m512i u = _mm512_add_epi32(_mm512_madd_epi16(pair01, k.U01), _mm512_madd_epi16(pair2, k.U2));
+    __m512i v = _mm512_add_epi32(_mm512_madd_epi16(pair01, k.V01), _mm512_madd_epi16(pair2, k.V2));
+    __m512i both = _mm512_mask_blend_epi32(0xAAAA, u, _mm512_slli_epi64(v, 32));
+    return _mm512_min_epi32(_mm512_srai_epi32(_mm512_add_epi32(both, k.ChromaBias), Yuv10ChromaShift), k.Max);
+}
+
+EXPANDSCREEN_TARGET_AVX512
+inline __m512i PackP010Avx512(__m512i a, __m512i b)
+{
+    return _mm512_slli_epi16(
+        _mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), _mm512_packus_epi32(a, b)), 6);
+}
+
+template <PixelFormat Source>
+EXPANDSCREEN_TARGET_AVX512
+inline void ConvertRowPairP010Avx512(
+    const uint8_t* src0,
+    const uint8_t* src1,
+    uint16_t* y0,
+    uint16_t* y1,
+    uint16_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& c)
+{
+    const P010ConstantsAvx512 k = MakeP010ConstantsAvx512<Source>(c);
+
+    uint32_t x = begin;
+    for (; x + 32 <= end; x += 32)
+    {
+        const uint8_t* p0 = src0 + (size_t)x * 4;
+        const uint8_t* p1 = src1 + (size_t)x * 4;
+        __m512i a0 = _mm512_loadu_si512(p0), a1 = _mm512_loadu_si512(p0 + 64);
+        __m512i b0 = _mm512_loadu_si512(p1), b1 = _mm512_loadu_si512(p1 + 64);
+
+        _mm512_storeu_si512(y0 + x,
+            PackP010Avx512(LumaP010Avx512<Source>(a0, k), LumaP010Avx512<Source>(a1, k)));
+        _mm512_storeu_si512(y1 + x,
+            PackP010Avx512(LumaP010Avx512<Source>(b0, k), LumaP010Avx512<Source>(b1, k)));
+        _mm512_storeu_si512(uv + x,
+            PackP010Avx512(ChromaP010Avx512<Source>(a0, b0, k), ChromaP010Avx512<Source>(a1, b1, k)));
+    }
+
+    // 剩余部分交给AVX2内核（其尾部再交给标量）
+    ConvertRowPairP010Avx2<Source>(src0, src1, y0, y1, uv, x, end, c);
+}
+
+EXPANDSCREEN_AVX512_END
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+template <PixelFormat Source>
+inline auto SelectP010KernelFor(CpuLevel level) -> decltype(&ConvertRowPairP010Scalar<Source>)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return ConvertRowPairP010Avx512<Source>;
+    case CpuLevel::Avx2: return ConvertRowPairP010Avx2<Source>;
+    case CpuLevel::Sse41: return ConvertRowPairP010Sse41<Source>;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return ConvertRowPairP010Scalar<Source>;
+}
+
+} // namespace ColorDetail
+
+using P010RowPairKernel = void (*)(
+    const uint8_t* src0,
+    const uint8_t* src1,
+    uint16_t* y0,
+    uint16_t* y1,
+    uint16_t* uv,
+    uint32_t begin,
+    uint32_t end,
+    const YuvCoefficients& coefficients);
+
+//
+// 按源格式与CPU级别选择内核，源格式不受支持时返回nullptr
+//
+inline P010RowPairKernel SelectP010Kernel(PixelFormat source, CpuLevel level)
+{
+    switch (source)
+    {
+    case PixelFormat::Bgra8: return ColorDetail::SelectP010KernelFor<PixelFormat::Bgra8>(level);
+    case PixelFormat::R10G10B10A2: return ColorDetail::SelectP010KernelFor<PixelFormat::R10G10B10A2>(level);
+    default: return nullptr;
+    }
+}
+
+//
+// BGRA8 / R10G10B10A2 -> P010转换器，内核在构造时按源格式与CPU特性选定。
+// 源格式不受支持时IsValid为false，Convert不做任何事
+//
+class P010Converter
+{
+public:
+    explicit P010Converter(
+        PixelFormat source = PixelFormat::Bgra8,
+        YuvMatrix matrix = YuvMatrix::Bt709,
+        YuvRange range = YuvRange::Limited,
+        CpuLevel level = DetectCpuLevel())
+        : m_Source(source),
+          m_Matrix(matrix),
+          m_Range(range),
+          m_Level(ClampCpuLevel(level)),
+          m_Coefficients(MakeYuv10Coefficients(matrix, range, source == PixelFormat::R10G10B10A2 ? 10 : 8)),
+          m_Kernel(SelectP010Kernel(source, level))
+    {
+    }
+
+    bool IsValid() const
+    {
+        return m_Kernel != nullptr;
+    }
+
+    PixelFormat Source() const
+    {
+        return m_Source;
+    }
+
+    YuvMatrix Matrix() const
+    {
+        return m_Matrix;
+    }
+
+    YuvRange Range() const
+    {
+        return m_Range;
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    //
+    // 转换rect覆盖的区域（先按色度对齐）。width/height为帧尺寸，需为偶数
+    //
+    void Convert(
+        const uint8_t* source,
+        size_t sourcePitch,
+        int32_t width,
+        int32_t height,
+        const P010Surface& target,
+        const FrameRect& rect) const
+    {
+        FrameRect aligned = AlignToChroma(rect, width, height);
+        if (m_Kernel == nullptr || aligned.IsEmpty())
+        {
+            return;
+        }
+
+        for (int32_t y = aligned.Top; y < aligned.Bottom; y += 2)
+        {
+            const uint8_t* row0 = source + (size_t)y * sourcePitch;
+            m_Kernel(
+                row0,
+                row0 + sourcePitch,
+                reinterpret_cast<uint16_t*>(target.Y + (size_t)y * target.YPitch),
+                reinterpret_cast<uint16_t*>(target.Y + (size_t)(y + 1) * target.YPitch),
+                reinterpret_cast<uint16_t*>(target.UV + (size_t)(y / 2) * target.UVPitch),
+                (uint32_t)aligned.Left,
+                (uint32_t)aligned.Right,
+                m_Coefficients);
+        }
+    }
+
+    void ConvertFrame(
+        const uint8_t* source,
+        size_t sourcePitch,
+        int32_t width,
+        int32_t height,
+        const P010Surface& target) const
+    {
+        Convert(source, sourcePitch, width, height, target, { 0, 0, width, height });
+    }
+
+private:
+    PixelFormat m_Source;
+    YuvMatrix m_Matrix;
+    YuvRange m_Range;
+    CpuLevel m_Level;
+    YuvCoefficients m_Coefficients;
+    P010RowPairKernel m_Kernel;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
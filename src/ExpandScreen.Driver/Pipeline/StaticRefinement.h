@@ -0,0 +1,214 @@
+/*++
+
+Module Name:
+    StaticRefinement.h
+
+Abstract:
+    静止桌面的画质补偿（refinement）策略
+
+    负载高时编码器以低码率编码，画面一旦静止就不再有新帧，模糊的画面会一直保留。
+    本策略记录自上次补偿以来发布过的损伤区域，连续若干个刷新区间没有变化后，
+    再对这些区域发布有限个补偿帧（帧环中带FrameFlagRefinement标志，消费者以高质量
+    重新编码），之后完全空闲直到下一次变化。补偿期间出现新变化则重新计时。
+
+    所有时间都由调用者以QPC计数传入，可以用模拟时钟确定性地测试。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "DirtyRegion.h"
+#include "FrameTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 补偿策略配置，每个监视器一份
+//
+struct StaticRefinementConfig
+{
+    uint32_t IdleIntervals = 30;        // 判定静止所需的无变化刷新区间数（60Hz下0.5秒）
+    uint32_t RefineFrames = 2;          // 静止后发布的补偿帧数，0表示关闭
+    uint32_t SpacingIntervals = 2;      // 相邻补偿帧之间的刷新区间数
+    uint32_t MaxRects = 16;             // 补偿区域的矩形数上限（不超过帧环的脏矩形上限）
+};
+
+struct StaticRefinementStats
+{
+    uint64_t Activations = 0;           // 进入补偿的静止期数
+    uint64_t RefinementFrames = 0;      // 发布的补偿帧数
+    uint64_t Interrupted = 0;           // 补偿未完成就出现新变化的次数
+    int64_t RefinedArea = 0;            // 补偿帧覆盖的像素面积之和
+};
+
+class StaticRefinementPolicy
+{
+public:
+    //
+    // period为刷新周期（计数），必须大于0；不定速的交换链由调用者给出默认周期
+    //
+    void Configure(const StaticRefinementConfig& config, int64_t period)
+    {
+        m_Config = config;
+        m_Period = period > 0 ? period : 1;
+        Reset();
+    }
+
+    const StaticRefinementConfig& Config() const
+    {
+        return m_Config;
+    }
+
+    //
+    // 丢弃记录的区域与计划中的补偿帧，例如交换链重新分配之后
+    //
+    void Reset()
+    {
+        m_Region.clear();
+        m_Remaining = 0;
+        m_Refined = 0;
+        m_Deadline = 0;
+    }
+
+    void ResetStats()
+    {
+        m_Stats = StaticRefinementStats();
+    }
+
+    const StaticRefinementStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 发布了有变化的帧：rects为本帧发布的脏矩形与移动区域目标，now为发布时间
+    //
+    void OnDamage(
+        const FrameRect* rects,
+        uint32_t count,
+        int32_t frameWidth,
+        int32_t frameHeight,
+        int64_t now)
+    {
+        if (m_Config.RefineFrames == 0 || count == 0)
+        {
+            return;
+        }
+
+        // 尺寸变化后旧区域的坐标已无意义
+        if (frameWidth != m_Width || frameHeight != m_Height)
+        {
+            m_Region.clear();
+            m_Width = frameWidth;
+            m_Height = frameHeight;
+        }
+
+        if (m_Refined != 0 && m_Remaining != 0)
+        {
+            m_Stats.Interrupted++;
+        }
+
+        m_Region.insert(m_Region.end(), rects, rects + count);
+        if (m_Region.size() > m_Config.MaxRects)
+        {
+            m_Merged.resize(m_Config.MaxRects);
+            uint32_t merged = m_Coalescer.Coalesce(
+                m_Region.data(),
+                (uint32_t)m_Region.size(),
+                m_Width,
+                m_Height,
+                m_Merged.data(),
+                m_Config.MaxRects);
+            m_Region.assign(m_Merged.begin(), m_Merged.begin() + merged);
+        }
+
+        m_Remaining = m_Config.RefineFrames;
+        m_Refined = 0;
+        m_Deadline = now + (int64_t)m_Config.IdleIntervals * m_Period;
+    }
+
+    bool HasPending() const
+    {
+        return m_Remaining != 0 && !m_Region.empty();
+    }
+
+    //
+    // 下一个补偿帧的发布时间，仅在HasPending时有意义
+    //
+    int64_t Deadline() const
+    {
+        return m_Deadline;
+    }
+
+    bool ShouldRefine(int64_t now) const
+    {
+        return HasPending() && now >= m_Deadline;
+    }
+
+    //
+    // 补偿帧覆盖的区域（已合并，不超过MaxRects个）
+    //
+    const std::vector<FrameRect>& Region() const
+    {
+        return m_Region;
+    }
+
+    //
+    // 已发布一个补偿帧（无论成功与否都计入，避免失败时反复重试）
+    //
+    void OnRefined(int64_t now)
+    {
+        if (!HasPending())
+        {
+            return;
+        }
+
+        if (m_Refined == 0)
+        {
+            m_Stats.Activations++;
+        }
+
+        m_Stats.RefinementFrames++;
+        for (const FrameRect& rect : m_Region)
+        {
+            m_Stats.RefinedArea += rect.Area();
+        }
+
+        m_Refined++;
+        m_Remaining--;
+
+        if (m_Remaining == 0)
+        {
+            // 补偿完成，完全空闲直到下一次变化
+            m_Region.clear();
+            m_Refined = 0;
+        }
+        else
+        {
+            m_Deadline = now + (int64_t)m_Config.SpacingIntervals * m_Period;
+        }
+    }
+
+private:
+    StaticRefinementConfig m_Config;
+    int64_t m_Period = 1;
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    std::vector<FrameRect> m_Region;
+    std::vector<FrameRect> m_Merged;
+    DirtyRegionCoalescer m_Coalescer;
+    uint32_t m_Remaining = 0;
+    uint32_t m_Refined = 0;
+    int64_t m_Deadline = 0;
+    StaticRefinementStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,221 @@
+/*++
+
+Module Name:
+    SwapChainRecovery.h
+
+Abstract:
+    交换链失效（渲染适配器重置：驱动更新、TDR、GPU切换）后的恢复状态机
+
+    交换链失效时帧处理线程取帧失败退出，驱动删除失效的交换链，IddCx随后取消分配
+    并在新的适配器上重新分配。监视器级的状态（帧环、常驻NV12图像、参考帧、块哈希、
+    消费者的编码会话）都不随交换链释放，重新分配后继续使用：
+
+        Unassigned --分配--> Running --取帧失败--> Lost --分配--> Recovering
+                                ^                   ^               |
+                                |                   +---再次失效----+
+                                +-----------新交换链的第一帧--------+
+
+    失效后的第一次分配要求调用者立即重发最后一帧（帧环中带FrameFlagRecovery），
+    消费者不必等桌面下一次变化就能重新出图；同一次中断只重发一次。从失效到重发、
+    从失效到新交换链的第一帧的时间都计入统计。
+
+    Running时取消分配是正常结束（模式切换、监视器关闭）；Lost与Recovering时
+    取消分配是恢复过程的一部分，状态不变，中断继续计时。
+
+    调用者保证串行调用：分配与取消分配回调分别在帧处理线程启动前、退出后调用，
+    OnLost与OnFrame只在帧处理线程上调用。所有时间都由调用者以QPC计数传入。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+enum class SwapChainState : uint32_t
+{
+    Unassigned,     // 尚未分配，或已正常取消分配
+    Running,        // 交换链正常出图
+    Lost,           // 交换链已失效，等待重新分配
+    Recovering      // 已重新分配，尚未取得新交换链的第一帧
+};
+
+struct SwapChainRecoveryStats
+{
+    uint64_t Assigns = 0;               // 成功分配的次数（含恢复）
+    uint64_t AssignFailures = 0;        // 分配失败的次数
+    uint64_t Losses = 0;                // 中断次数（一次中断内再次失效不重复计）
+    uint64_t Relosses = 0;              // 恢复中的交换链在第一帧之前再次失效的次数
+    uint64_t Recoveries = 0;            // 取得新交换链第一帧的中断数
+    uint64_t Retransmits = 0;           // 重发最后一帧的次数
+    int64_t RetransmitTimeTotal = 0;    // 失效到重发（计数）
+    int64_t RetransmitTimeMax = 0;
+    int64_t RecoveryTimeLast = 0;       // 失效到新交换链第一帧（计数）
+    int64_t RecoveryTimeMax = 0;
+    int64_t RecoveryTimeTotal = 0;
+};
+
+class SwapChainRecovery
+{
+public:
+    SwapChainState State() const
+    {
+        return m_State;
+    }
+
+    bool Recovering() const
+    {
+        return m_State == SwapChainState::Recovering;
+    }
+
+    //
+    // 当前中断的开始时间（Lost与Recovering时有效）
+    //
+    int64_t LossTime() const
+    {
+        return m_LossTime;
+    }
+
+    void ResetStats()
+    {
+        m_Stats = SwapChainRecoveryStats();
+    }
+
+    const SwapChainRecoveryStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 交换链已分配且帧处理线程即将启动。返回true表示这是失效后的重新分配且本次
+    // 中断还没有重发过，调用者应在帧处理线程发布新帧之前重发最后一帧
+    //
+    bool OnAssign(int64_t now)
+    {
+        (void)now;
+        m_Stats.Assigns++;
+
+        if (m_State != SwapChainState::Lost)
+        {
+            m_State = SwapChainState::Running;
+            return false;
+        }
+
+        m_State = SwapChainState::Recovering;
+        return !m_Retransmitted;
+    }
+
+    //
+    // 分配失败（设备创建失败等），驱动删除交换链，IddCx会再次分配。
+    // 恢复中的分配失败时中断继续
+    //
+    void OnAssignFailed(int64_t now)
+    {
+        (void)now;
+        m_Stats.AssignFailures++;
+
+        if (m_State == SwapChainState::Recovering)
+        {
+            m_State = SwapChainState::Lost;
+        }
+        else if (m_State == SwapChainState::Running)
+        {
+            m_State = SwapChainState::Unassigned;
+        }
+    }
+
+    //
+    // 最后一帧已重发
+    //
+    void OnRetransmit(int64_t now)
+    {
+        m_Retransmitted = true;
+        m_Stats.Retransmits++;
+
+        const int64_t elapsed = now - m_LossTime;
+        m_Stats.RetransmitTimeTotal += elapsed;
+        if (elapsed > m_Stats.RetransmitTimeMax)
+        {
+            m_Stats.RetransmitTimeMax = elapsed;
+        }
+    }
+
+    //
+    // 帧处理线程因取帧失败退出。返回true表示调用者应删除失效的交换链，
+    // 让IddCx重新分配；未分配时（例如已在取消分配）返回false
+    //
+    bool OnLost(int64_t now)
+    {
+        switch (m_State)
+        {
+        case SwapChainState::Running:
+            m_State = SwapChainState::Lost;
+            m_LossTime = now;
+            m_Retransmitted = false;
+            m_Stats.Losses++;
+            return true;
+
+        case SwapChainState::Recovering:
+            // 同一次中断，仍从最初失效时计时
+            m_State = SwapChainState::Lost;
+            m_Stats.Relosses++;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    //
+    // 交换链已取消分配，帧处理线程已退出
+    //
+    void OnUnassign(int64_t now)
+    {
+        (void)now;
+
+        if (m_State == SwapChainState::Running)
+        {
+            m_State = SwapChainState::Unassigned;
+        }
+        else if (m_State == SwapChainState::Recovering)
+        {
+            m_State = SwapChainState::Lost;
+        }
+    }
+
+    //
+    // 取得一帧。恢复中的第一帧结束本次中断
+    //
+    void OnFrame(int64_t now)
+    {
+        if (m_State != SwapChainState::Recovering)
+        {
+            return;
+        }
+
+        m_State = SwapChainState::Running;
+
+        const int64_t elapsed = now - m_LossTime;
+        m_Stats.Recoveries++;
+        m_Stats.RecoveryTimeLast = elapsed;
+        m_Stats.RecoveryTimeTotal += elapsed;
+        if (elapsed > m_Stats.RecoveryTimeMax)
+        {
+            m_Stats.RecoveryTimeMax = elapsed;
+        }
+    }
+
+private:
+    SwapChainState m_State = SwapChainState::Unassigned;
+    int64_t m_LossTime = 0;
+    bool m_Retransmitted = false;
+    SwapChainRecoveryStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,309 @@
+/*++
+
+Module Name:
+    TaskExecutor.h
+
+Abstract:
+    多监视器共享的工作窃取任务执行器
+
+    每个交换链仍有自己的处理线程（IddCx要求按交换链获取缓冲区），但一帧内
+    可并行的工作（按行带转换NV12等）拆成任务交给整个设备共享的执行器，
+    空闲的核心可以帮忙处理别的监视器的帧，而不是按监视器固定分配线程。
+
+    每个工作线程有一个定长双端队列：自己从尾部取（刚放入的任务数据还在缓存里），
+    其他线程从头部窃取。提交线程把一批任务按轮转分散到各队列，队列满时在
+    提交线程上直接执行。任务只是函数指针+上下文+下标，提交和执行都不分配内存。
+
+    任务按TaskGroup分组，Wait在组完成前让等待线程也参与执行（没有工作线程时
+    全部在等待线程上执行）。交换链线程每帧ParallelFor后Wait，下一帧在上一帧
+    全部任务完成后才开始，因此每个监视器内的帧顺序不变。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+using TaskFunction = void(*)(void* context, uint32_t index);
+
+//
+// 一组任务，Pending为尚未执行完的任务数
+//
+struct TaskGroup
+{
+    std::atomic<uint32_t> Pending{ 0 };
+};
+
+//
+// 执行器累计统计
+//
+struct TaskExecutorStats
+{
+    uint64_t Submitted = 0;         // 提交的任务数
+    uint64_t Stolen = 0;            // 从其他队列窃取执行的任务数
+    uint64_t Helped = 0;            // 在Wait中由等待线程执行的任务数
+    uint64_t Inline = 0;            // 队列满时在提交线程上直接执行的任务数
+};
+
+class WorkStealingExecutor
+{
+public:
+    static constexpr uint32_t MaxWorkers = 16;
+    static constexpr uint32_t QueueCapacity = 256;
+
+    //
+    // 默认工作线程数：保留一个核心给交换链线程（它们在Wait中也参与执行）
+    //
+    static uint32_t DefaultWorkerCount()
+    {
+        const uint32_t cores = std::thread::hardware_concurrency();
+        const uint32_t workers = cores > 1 ? cores - 1 : 0;
+        return workers < MaxWorkers ? workers : MaxWorkers;
+    }
+
+    explicit WorkStealingExecutor(uint32_t workers = DefaultWorkerCount())
+        : m_WorkerCount(workers < MaxWorkers ? workers : MaxWorkers),
+          m_QueueCount(m_WorkerCount != 0 ? m_WorkerCount : 1)
+    {
+        for (uint32_t i = 0; i < m_WorkerCount; i++)
+        {
+            m_Workers[i] = std::thread(&WorkStealingExecutor::WorkerMain, this, i);
+        }
+    }
+
+    ~WorkStealingExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stop = true;
+        }
+        m_WorkAvailable.notify_all();
+
+        for (uint32_t i = 0; i < m_WorkerCount; i++)
+        {
+            m_Workers[i].join();
+        }
+    }
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    uint32_t WorkerCount() const
+    {
+        return m_WorkerCount;
+    }
+
+    TaskExecutorStats Stats() const
+    {
+        TaskExecutorStats stats;
+        stats.Submitted = m_Submitted.load(std::memory_order_relaxed);
+        stats.Stolen = m_Stolen.load(std::memory_order_relaxed);
+        stats.Helped = m_Helped.load(std::memory_order_relaxed);
+        stats.Inline = m_Inline.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    //
+    // 提交function(context, 0..count-1)，加入group；随后需Wait(group)。
+    // context在Wait返回前必须保持有效
+    //
+    void ParallelFor(TaskGroup& group, uint32_t count, TaskFunction function, void* context)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        group.Pending.fetch_add(count, std::memory_order_relaxed);
+        m_Submitted.fetch_add(count, std::memory_order_relaxed);
+
+        // 按轮转分散到各队列，每个队列只加锁一次
+        const uint32_t first = m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_QueueCount;
+        uint32_t next = 0;
+        uint32_t queued = 0;
+        for (uint32_t q = 0; q < m_QueueCount && next < count; q++)
+        {
+            WorkQueue& queue = m_Queues[(first + q) % m_QueueCount];
+            const uint32_t share = (count - next + (m_QueueCount - q) - 1) / (m_QueueCount - q);
+
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            uint32_t pushed = 0;
+            for (; pushed < share && queue.Count < QueueCapacity; pushed++, next++)
+            {
+                queue.Tasks[(queue.Head + queue.Count) % QueueCapacity] = { function, context, next, &group };
+                queue.Count++;
+            }
+
+            // 在队列锁内计数，取走时的减少总在增加之后
+            m_Queued.fetch_add(pushed, std::memory_order_release);
+            queued += pushed;
+        }
+
+        if (queued != 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_SleepMutex);
+            }
+            if (queued == 1)
+            {
+                m_WorkAvailable.notify_one();
+            }
+            else
+            {
+                m_WorkAvailable.notify_all();
+            }
+        }
+
+        // 所有队列都满，剩余任务在提交线程上执行
+        for (; next < count; next++)
+        {
+            m_Inline.fetch_add(1, std::memory_order_relaxed);
+            Run({ function, context, next, &group });
+        }
+    }
+
+    //
+    // 等待group中的任务全部完成，等待期间执行任意队列中的任务
+    //
+    void Wait(TaskGroup& group)
+    {
+        while (group.Pending.load(std::memory_order_acquire) != 0)
+        {
+            Task task;
+            if (TryTake(0, task, false))
+            {
+                m_Helped.fetch_add(1, std::memory_order_relaxed);
+                Run(task);
+                continue;
+            }
+
+            // 队列已空，剩余任务正在工作线程上执行
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_GroupDone.wait(lock, [&]
+            {
+                return group.Pending.load(std::memory_order_acquire) == 0 ||
+                    m_Queued.load(std::memory_order_acquire) != 0;
+            });
+        }
+    }
+
+private:
+    struct Task
+    {
+        TaskFunction Function;
+        void* Context;
+        uint32_t Index;
+        TaskGroup* Group;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex Mutex;
+        uint32_t Head = 0;
+        uint32_t Count = 0;
+        Task Tasks[QueueCapacity];
+    };
+
+    //
+    // 先取自己队列的尾部，再从其他队列头部窃取
+    //
+    bool TryTake(uint32_t home, Task& task, bool owner)
+    {
+        for (uint32_t q = 0; q < m_QueueCount; q++)
+        {
+            const uint32_t index = (home + q) % m_QueueCount;
+            WorkQueue& queue = m_Queues[index];
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            if (queue.Count == 0)
+            {
+                continue;
+            }
+
+            if (owner && q == 0)
+            {
+                task = queue.Tasks[(queue.Head + queue.Count - 1) % QueueCapacity];
+            }
+            else
+            {
+                task = queue.Tasks[queue.Head];
+                queue.Head = (queue.Head + 1) % QueueCapacity;
+                if (owner)
+                {
+                    m_Stolen.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            queue.Count--;
+            m_Queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    void Run(const Task& task)
+    {
+        task.Function(task.Context, task.Index);
+
+        if (task.Group->Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_SleepMutex);
+            }
+            m_GroupDone.notify_all();
+        }
+    }
+
+    void WorkerMain(uint32_t index)
+    {
+        for (;;)
+        {
+            Task task;
+            if (TryTake(index, task, true))
+            {
+                Run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_WorkAvailable.wait(lock, [&]
+            {
+                return m_Stop || m_Queued.load(std::memory_order_acquire) != 0;
+            });
+            if (m_Stop)
+            {
+                return;
+            }
+        }
+    }
+
+    const uint32_t m_WorkerCount;
+    const uint32_t m_QueueCount;
+    WorkQueue m_Queues[MaxWorkers];
+    std::thread m_Workers[MaxWorkers];
+
+    std::atomic<uint32_t> m_Queued{ 0 };            // 各队列中的任务总数
+    std::atomic<uint32_t> m_NextQueue{ 0 };
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WorkAvailable;        // 工作线程等待新任务
+    std::condition_variable m_GroupDone;            // Wait等待组完成或新任务
+    bool m_Stop = false;
+
+    std::atomic<uint64_t> m_Submitted{ 0 };
+    std::atomic<uint64_t> m_Stolen{ 0 };
+    std::atomic<uint64_t> m_Helped{ 0 };
+    std::atomic<uint64_t> m_Inline{ 0 };
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,543 @@
+/*++
+
+Module Name:
+    TileClassifier.h
+
+Abstract:
+    按块区分文字/界面、自然图像与视频
+
+    代码编辑器与网页中的视频播放器用同一套编码参数时，要么文字糊掉，要么视频
+    浪费码率。本分类器对每个脏的64x64块（ContentTileSize）给出内容类别，随帧
+    发布给消费者，编码器据此为文字选择无损或高质量、为视频选择低延迟码控。
+
+    特征（按ContentClassifierConfig::SampleRowStep隔行采样，每块只读少量行）：
+        平坦比例：与左邻像素完全相同的像素比例，界面与文字背景很高，照片几乎为0
+        边缘比例：变化像素中通道差达到EdgeThreshold的比例，文字笔画锐利，照片平滑
+        颜色数：变化像素中的不同颜色数（上限MaxCountedColors），界面调色板很小
+        更新频率：块连续被更新的次数，相邻两次更新间隔不超过VideoMaxGapIntervals个
+                 刷新区间时累加，否则重新计数
+    判定：颜色少、或平坦比例高、或变化像素以锐利边缘为主时为文字/界面；否则为
+    自然图像，连续更新达到VideoMinUpdates次的自然图像为视频。
+
+    行特征内核一次比较一行（至多64像素）与左移一个像素的自身，返回变化像素的
+    位掩码与锐利边缘数；标量、SSE4.1、AVX2、AVX-512内核结果一致。
+
+    类别图按块保存最近一次分类结果，未脏的块保留原类别，尺寸变化时清空。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "FrameTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 分类配置，每个监视器一份
+//
+struct ContentClassifierConfig
+{
+    int32_t SampleRowStep = 8;          // 每块每隔多少行采样一行
+    uint32_t EdgeThreshold = 64;        // 相邻像素最大通道差达到此值视为锐利边缘
+    uint32_t PaletteColors = 24;        // 变化像素的颜色数不超过此值视为界面
+    uint32_t TextFlatPercent = 45;      // 平坦比例达到此值视为文字/界面
+    uint32_t TextEdgePercent = 35;      // 变化像素中锐利边缘比例达到此值视为文字
+    uint32_t VideoMinUpdates = 6;       // 自然图像块连续更新达到此次数视为视频
+    uint32_t VideoMaxGapIntervals = 4;  // 连续更新之间的最大间隔（刷新区间数，60Hz下约67ms）
+};
+
+struct TileClassifierStats
+{
+    uint32_t Tiles = 0;                 // 本帧分类的块数
+    uint32_t Classes[TileContentCount] = {};
+    uint64_t SampledPixels = 0;         // 本帧读取比较的像素数
+};
+
+namespace TileClassifierDetail {
+
+constexpr uint32_t MaxCountedColors = 64;
+constexpr uint32_t ColorTableSize = 256;
+
+inline uint32_t Load32(const uint8_t* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t CountBits(uint64_t value)
+{
+#if defined(_MSC_VER)
+    uint32_t count = 0;
+    for (; value != 0; value &= value - 1)
+    {
+        count++;
+    }
+    return count;
+#else
+    return (uint32_t)__builtin_popcountll(value);
+#endif
+}
+
+inline uint32_t LowestBit(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32_t)index;
+#elif defined(_MSC_VER)
+    uint32_t index = 0;
+    for (; (value & 1) == 0; value >>= 1)
+    {
+        index++;
+    }
+    return index;
+#else
+    return (uint32_t)__builtin_ctzll(value);
+#endif
+}
+
+//
+// 比较a与b（b为a左移一个像素）的pixels个像素（不超过64），忽略alpha：
+// 返回变化像素的位掩码，edges为最大通道差达到threshold的像素数
+//
+inline uint64_t RowActivityScalar(const uint8_t* a, const uint8_t* b, int32_t pixels, uint32_t threshold,
+    uint32_t& edges)
+{
+    uint64_t changed = 0;
+    edges = 0;
+    for (int32_t i = 0; i < pixels; i++)
+    {
+        const uint32_t pa = Load32(a + (size_t)i * 4), pb = Load32(b + (size_t)i * 4);
+        if (((pa ^ pb) & 0x00FFFFFFu) == 0)
+        {
+            continue;
+        }
+
+        changed |= 1ull << i;
+        uint32_t maximum = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            const int32_t d = (int32_t)((pa >> shift) & 0xFF) - (int32_t)((pb >> shift) & 0xFF);
+            const uint32_t magnitude = (uint32_t)(d < 0 ? -d : d);
+            maximum = magnitude > maximum ? magnitude : maximum;
+        }
+        edges += maximum >= threshold ? 1 : 0;
+    }
+    return changed;
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+// 每个像素的最大通道差（低字节），alpha已清零
+EXPANDSCREEN_TARGET_SSE41
+inline __m128i MaxChannelDifferenceSse41(__m128i a, __m128i b)
+{
+    const __m128i rgb = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)), rgb);
+    const __m128i m = _mm_max_epu8(_mm_max_epu8(d, _mm_srli_epi32(d, 8)), _mm_srli_epi32(d, 16));
+    return _mm_and_si128(m, _mm_set1_epi32(0xFF));
+}
+
+EXPANDSCREEN_TARGET_SSE41
+inline uint64_t RowActivitySse41(const uint8_t* a, const uint8_t* b, int32_t pixels, uint32_t threshold,
+    uint32_t& edges)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi32((int32_t)threshold - 1);
+    uint64_t changed = 0;
+    uint32_t edgeCount = 0;
+    int32_t i = 0;
+    for (; i + 4 <= pixels; i += 4)
+    {
+        const __m128i m = MaxChannelDifferenceSse41(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + (size_t)i * 4)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + (size_t)i * 4)));
+        const uint32_t flat = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(m, zero)));
+        const uint32_t edge = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(m, limit)));
+        changed |= (uint64_t)(~flat & 0xF) << i;
+        edgeCount += CountBits(edge);
+    }
+
+    uint32_t tailEdges = 0;
+    if (i < pixels)
+    {
+        changed |= RowActivityScalar(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i, threshold, tailEdges) << i;
+    }
+    edges = edgeCount + tailEdges;
+    return changed;
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline uint64_t RowActivityAvx2(const uint8_t* a, const uint8_t* b, int32_t pixels, uint32_t threshold,
+    uint32_t& edges)
+{
+    const __m256i rgb = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i low = _mm256_set1_epi32(0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi32((int32_t)threshold - 1);
+    uint64_t changed = 0;
+    uint32_t edgeCount = 0;
+    int32_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + (size_t)i * 4));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + (size_t)i * 4));
+        const __m256i d = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va)), rgb);
+        const __m256i m = _mm256_and_si256(
+            _mm256_max_epu8(_mm256_max_epu8(d, _mm256_srli_epi32(d, 8)), _mm256_srli_epi32(d, 16)), low);
+        const uint32_t flat = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(m, zero)));
+        const uint32_t edge = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(m, limit)));
+        changed |= (uint64_t)(~flat & 0xFF) << i;
+        edgeCount += CountBits(edge);
+    }
+
+    uint32_t tailEdges = 0;
+    if (i < pixels)
+    {
+        changed |= RowActivitySse41(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i, threshold, tailEdges) << i;
+    }
+    edges = edgeCount + tailEdges;
+    return changed;
+}
+
+EXPANDSCREEN_AVX512_BEGIN
+
+EXPANDSCREEN_TARGET_AVX512
+inline uint64_t RowActivityAvx512(const uint8_t* a, const uint8_t* b, int32_t pixels, uint32_t threshold,
+    uint32_t& edges)
+{
+    const __m512i rgb = _mm512_set1_epi32(0x00FFFFFF);
+    const __m512i low = _mm512_set1_epi32(0xFF);
+    const __m512i limit = _mm512_set1_epi32((int32_t)threshold);
+    uint64_t changed = 0;
+    uint32_t edgeCount = 0;
+    int32_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        const __m512i va = _mm512_loadu_si512(a + (size_t)i * 4);
+        const __m512i vb = _mm512_loadu_si512(b + (size_t)i * 4);
+        const __m512i d = _mm512_and_si512(_mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va)), rgb);
+        const __m512i m = _mm512_and_si512(
+            _mm512_max_epu8(_mm512_max_epu8(d, _mm512_srli_epi32(d, 8)), _mm512_srli_epi32(d, 16)), low);
+        changed |= (uint64_t)_mm512_test_epi32_mask(m, m) << i;
+        edgeCount += CountBits(_mm512_cmpge_epu32_mask(m, limit));
+    }
+
+    uint32_t tailEdges = 0;
+    if (i < pixels)
+    {
+        changed |= RowActivityAvx2(a + (size_t)i * 4, b + (size_t)i * 4, pixels - i, threshold, tailEdges) << i;
+    }
+    edges = edgeCount + tailEdges;
+    return changed;
+}
+
+EXPANDSCREEN_AVX512_END
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+} // namespace TileClassifierDetail
+
+using RowActivityFunction = uint64_t (*)(const uint8_t* a, const uint8_t* b, int32_t pixels, uint32_t threshold,
+    uint32_t& edges);
+
+inline RowActivityFunction SelectRowActivity(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return TileClassifierDetail::RowActivityAvx512;
+    case CpuLevel::Avx2: return TileClassifierDetail::RowActivityAvx2;
+    case CpuLevel::Sse41: return TileClassifierDetail::RowActivitySse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return TileClassifierDetail::RowActivityScalar;
+}
+
+class TileContentClassifier
+{
+public:
+    explicit TileContentClassifier(CpuLevel level = DetectCpuLevel())
+        : m_Level(ClampCpuLevel(level)),
+          m_RowActivity(SelectRowActivity(m_Level))
+    {
+    }
+
+    //
+    // period为刷新周期（计数），必须大于0；不定速的交换链由调用者给出默认周期
+    //
+    void Configure(const ContentClassifierConfig& config, int64_t period)
+    {
+        m_Config = config;
+        if (m_Config.SampleRowStep < 1)
+        {
+            m_Config.SampleRowStep = 1;
+        }
+        if (m_Config.EdgeThreshold < 1)
+        {
+            m_Config.EdgeThreshold = 1;
+        }
+        m_Period = period > 0 ? period : 1;
+        Reset();
+    }
+
+    const ContentClassifierConfig& Config() const
+    {
+        return m_Config;
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    //
+    // 清空类别图与更新历史，例如交换链重新分配之后
+    //
+    void Reset()
+    {
+        m_Width = 0;
+        m_Height = 0;
+        m_Columns = 0;
+        m_Rows = 0;
+        m_Classes.clear();
+        m_Tiles.clear();
+    }
+
+    uint32_t Columns() const
+    {
+        return m_Columns;
+    }
+
+    uint32_t Rows() const
+    {
+        return m_Rows;
+    }
+
+    //
+    // 按行优先排列的类别图（TileContent），Columns()*Rows()项
+    //
+    const uint8_t* Classes() const
+    {
+        return m_Classes.data();
+    }
+
+    TileContent ClassAt(uint32_t column, uint32_t row) const
+    {
+        return column < m_Columns && row < m_Rows ?
+            (TileContent)m_Classes[(size_t)row * m_Columns + column] : TileContent::Unknown;
+    }
+
+    const TileClassifierStats& LastStats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 对dirty覆盖的每个块重新分类（每块每帧一次），now为本帧时间。返回分类的块数
+    //
+    uint32_t Classify(
+        const uint8_t* bgra,
+        size_t pitch,
+        int32_t width,
+        int32_t height,
+        const FrameRect* dirty,
+        uint32_t dirtyCount,
+        int64_t now)
+    {
+        m_Stats = TileClassifierStats();
+        if (width <= 0 || height <= 0)
+        {
+            return 0;
+        }
+
+        if (width != m_Width || height != m_Height)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_Columns = (uint32_t)((width + ContentTileSize - 1) / ContentTileSize);
+            m_Rows = (uint32_t)((height + ContentTileSize - 1) / ContentTileSize);
+            m_Classes.assign((size_t)m_Columns * m_Rows, (uint8_t)TileContent::Unknown);
+            m_Tiles.assign((size_t)m_Columns * m_Rows, TileState());
+        }
+
+        m_Frame++;
+        const FrameRect frame = { 0, 0, width, height };
+        for (uint32_t i = 0; i < dirtyCount; i++)
+        {
+            const FrameRect rect = IntersectRect(dirty[i], frame);
+            if (rect.IsEmpty())
+            {
+                continue;
+            }
+
+            const uint32_t firstColumn = (uint32_t)(rect.Left / ContentTileSize);
+            const uint32_t lastColumn = (uint32_t)((rect.Right - 1) / ContentTileSize);
+            const uint32_t firstRow = (uint32_t)(rect.Top / ContentTileSize);
+            const uint32_t lastRow = (uint32_t)((rect.Bottom - 1) / ContentTileSize);
+            for (uint32_t row = firstRow; row <= lastRow; row++)
+            {
+                for (uint32_t column = firstColumn; column <= lastColumn; column++)
+                {
+                    const size_t index = (size_t)row * m_Columns + column;
+                    if (m_Tiles[index].Frame == m_Frame)
+                    {
+                        continue;
+                    }
+
+                    const TileContent content = ClassifyTile(bgra, pitch, column, row, m_Tiles[index], now);
+                    m_Classes[index] = (uint8_t)content;
+                    m_Stats.Tiles++;
+                    m_Stats.Classes[(uint32_t)content]++;
+                }
+            }
+        }
+
+        return m_Stats.Tiles;
+    }
+
+private:
+    struct TileState
+    {
+        uint64_t Frame = 0;         // 最近一次分类时的m_Frame
+        int64_t LastUpdate = 0;
+        uint32_t Streak = 0;        // 连续更新次数
+    };
+
+    TileContent ClassifyTile(const uint8_t* bgra, size_t pitch, uint32_t column, uint32_t row,
+        TileState& state, int64_t now)
+    {
+        using namespace TileClassifierDetail;
+
+        // 更新频率
+        state.Streak = state.Streak != 0 && now - state.LastUpdate <= m_Period * m_Config.VideoMaxGapIntervals ?
+            state.Streak + 1 : 1;
+        state.LastUpdate = now;
+        state.Frame = m_Frame;
+
+        const int32_t left = (int32_t)column * ContentTileSize;
+        const int32_t top = (int32_t)row * ContentTileSize;
+        const int32_t right = left + ContentTileSize < m_Width ? left + ContentTileSize : m_Width;
+        const int32_t bottom = top + ContentTileSize < m_Height ? top + ContentTileSize : m_Height;
+
+        // 与左邻比较，帧最左一列没有左邻
+        const int32_t first = left > 0 ? left : 1;
+        const int32_t pixels = right - first;
+        const int32_t step = m_Config.SampleRowStep;
+        const int32_t offset = (step - 1) / 2 < bottom - top ? (step - 1) / 2 : 0;
+
+        // 先只统计变化与边缘，多数块（平坦的界面、锐利的文字）据此即可判定
+        uint64_t masks[ContentTileSize];
+        uint32_t sampledRows = 0, samples = 0, changed = 0, edges = 0;
+        for (int32_t y = top + offset; pixels > 0 && y < bottom; y += step)
+        {
+            const uint8_t* a = bgra + (size_t)y * pitch + (size_t)first * 4;
+            uint32_t rowEdges;
+            masks[sampledRows] = m_RowActivity(a, a - 4, pixels, m_Config.EdgeThreshold, rowEdges);
+
+            samples += (uint32_t)pixels;
+            changed += CountBits(masks[sampledRows]);
+            edges += rowEdges;
+            sampledRows++;
+        }
+        m_Stats.SampledPixels += samples;
+
+        if (samples == 0 ||
+            (uint64_t)(samples - changed) * 100 >= (uint64_t)samples * m_Config.TextFlatPercent ||
+            (uint64_t)edges * 100 >= (uint64_t)changed * m_Config.TextEdgePercent ||
+            CountColors(bgra, pitch, top + offset, first, masks, sampledRows) <= m_Config.PaletteColors)
+        {
+            return TileContent::Text;
+        }
+
+        return state.Streak >= m_Config.VideoMinUpdates ? TileContent::Video : TileContent::Natural;
+    }
+
+    //
+    // 采样行中变化像素的不同颜色数，超过MaxCountedColors即停止
+    //
+    uint32_t CountColors(const uint8_t* bgra, size_t pitch, int32_t firstRow, int32_t first,
+        const uint64_t* masks, uint32_t sampledRows)
+    {
+        using namespace TileClassifierDetail;
+
+        if (++m_ColorStamp == 0)
+        {
+            std::memset(m_ColorStamps, 0, sizeof(m_ColorStamps));
+            m_ColorStamp = 1;
+        }
+        m_ColorCount = 0;
+
+        for (uint32_t i = 0; i < sampledRows && m_ColorCount <= MaxCountedColors; i++)
+        {
+            const uint8_t* a = bgra + (size_t)(firstRow + (int32_t)i * m_Config.SampleRowStep) * pitch + (size_t)first * 4;
+            for (uint64_t mask = masks[i]; mask != 0 && m_ColorCount <= MaxCountedColors; mask &= mask - 1)
+            {
+                AddColor(Load32(a + (size_t)LowestBit(mask) * 4) & 0x00FFFFFFu);
+            }
+        }
+        return m_ColorCount;
+    }
+
+    //
+    // 开放寻址的颜色集合，按块的印记区分，无需逐块清空
+    //
+    void AddColor(uint32_t color)
+    {
+        using namespace TileClassifierDetail;
+
+        uint32_t slot = (color * 0x9E3779B1u) >> 24;
+        for (;;)
+        {
+            if (m_ColorStamps[slot] != m_ColorStamp)
+            {
+                m_ColorStamps[slot] = m_ColorStamp;
+                m_Colors[slot] = color;
+                m_ColorCount++;
+                return;
+            }
+            if (m_Colors[slot] == color)
+            {
+                return;
+            }
+            slot = (slot + 1) % ColorTableSize;
+        }
+    }
+
+    CpuLevel m_Level;
+    RowActivityFunction m_RowActivity;
+    ContentClassifierConfig m_Config;
+    int64_t m_Period = 1;
+
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    uint32_t m_Columns = 0;
+    uint32_t m_Rows = 0;
+    std::vector<uint8_t> m_Classes;
+    std::vector<TileState> m_Tiles;
+    uint64_t m_Frame = 0;
+
+    uint32_t m_Colors[TileClassifierDetail::ColorTableSize] = {};
+    uint32_t m_ColorStamps[TileClassifierDetail::ColorTableSize] = {};
+    uint32_t m_ColorStamp = 0;
+    uint32_t m_ColorCount = 0;
+
+    TileClassifierStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,626 @@
+/*++
+
+Module Name:
+    TileHash.h
+
+Abstract:
+    分块内容哈希，过滤内容实际未变化的脏区域
+
+    DWM经常上报像素并未变化的脏矩形（光标闪烁原样重绘、整窗无效化等）。
+    每个监视器保存一张块哈希表（默认64x64像素一块），脏矩形覆盖的块重新计算
+    哈希，与上一次相同的块从脏区域中剔除。
+
+    哈希采用XXH3长输入结构：8路64位累加器按64字节条带累加，每行末尾扰乱一次，
+    行序与条带位置都参与哈希。标量、SSE4.1、AVX2、AVX-512内核逐位一致，
+    运行时按CPU特性选择。
+
+    正确性约束：块哈希必须等于消费者当前持有的该块内容。移动区域的目标块
+    由调用者通过Invalidate作废；脏信息未知时调用Reset。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "CpuFeatures.h"
+#include "FrameTypes.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+namespace TileHashDetail {
+
+constexpr uint32_t Prime32_1 = 0x9E3779B1u;
+constexpr uint32_t Prime32_2 = 0x85EBCA77u;
+constexpr uint32_t Prime32_3 = 0xC2B2AE3Du;
+constexpr uint64_t Prime64_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t Prime64_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t Prime64_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t Prime64_5 = 0x27D4EB2F165667C5ull;
+
+constexpr uint32_t StripeBytes = 64;
+constexpr uint32_t SecretWords = 24;        // 条带密钥按8字节步进取[0, 16)，行扰乱用[16, 24)
+constexpr uint32_t ScrambleKey = 16;
+
+struct Secret
+{
+    uint64_t Words[SecretWords];
+};
+
+constexpr Secret MakeSecret()
+{
+    Secret secret = {};
+    uint64_t state = 0x4553465248415348ull;     // 'ESFRHASH'
+    for (uint32_t i = 0; i < SecretWords; i++)
+    {
+        // splitmix64
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        secret.Words[i] = z ^ (z >> 31);
+    }
+    return secret;
+}
+
+inline const uint64_t* SecretKey()
+{
+    static constexpr Secret secret = MakeSecret();
+    return secret.Words;
+}
+
+inline uint64_t Load64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t Rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline void InitAccumulators(uint64_t acc[8])
+{
+    acc[0] = Prime32_3;
+    acc[1] = Prime64_1;
+    acc[2] = Prime64_2;
+    acc[3] = Prime64_3;
+    acc[4] = Prime64_4;
+    acc[5] = Prime32_2;
+    acc[6] = Prime64_5;
+    acc[7] = Prime32_1;
+}
+
+inline void AccumulateStripeScalar(uint64_t acc[8], const uint8_t* data, const uint64_t* key)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t value = Load64(data + 8 * i);
+        uint64_t keyed = value ^ key[i];
+        acc[i ^ 1] += value;
+        acc[i] += (keyed & 0xFFFFFFFFu) * (keyed >> 32);
+    }
+}
+
+inline void ScrambleScalar(uint64_t acc[8], const uint64_t* key)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t value = acc[i];
+        value ^= value >> 47;
+        value ^= key[i];
+        acc[i] = value * Prime32_1;
+    }
+}
+
+//
+// 行尾不足64字节的部分补零后按一个条带处理
+//
+inline void AccumulateTailScalar(uint64_t acc[8], const uint8_t* data, uint32_t bytes, const uint64_t* key)
+{
+    uint8_t stripe[StripeBytes] = {};
+    std::memcpy(stripe, data, bytes);
+    AccumulateStripeScalar(acc, stripe, key);
+}
+
+inline uint64_t Finalize(const uint64_t acc[8], uint32_t rowBytes, uint32_t rows)
+{
+    uint64_t hash = ((uint64_t)rows << 32 | rowBytes) * Prime64_5 + Prime64_1;
+
+    for (int i = 0; i < 8; i++)
+    {
+        uint64_t round = Rotl64(acc[i] * Prime64_2, 31) * Prime64_1;
+        hash ^= round;
+        hash = Rotl64(hash, 27) * Prime64_1 + Prime64_4;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime64_2;
+    hash ^= hash >> 29;
+    hash *= Prime64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline uint64_t HashScalar(const uint8_t* pixels, size_t pitch, uint32_t rowBytes, uint32_t rows)
+{
+    const uint64_t* key = SecretKey();
+    const uint32_t stripes = rowBytes / StripeBytes;
+    const uint32_t tail = rowBytes % StripeBytes;
+    uint64_t acc[8];
+    InitAccumulators(acc);
+
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * pitch;
+        for (uint32_t s = 0; s < stripes; s++)
+        {
+            AccumulateStripeScalar(acc, row + (size_t)s * StripeBytes, key + (s % 8));
+        }
+        if (tail != 0)
+        {
+            AccumulateTailScalar(acc, row + (size_t)stripes * StripeBytes, tail, key + (stripes % 8));
+        }
+        ScrambleScalar(acc, key + ScrambleKey);
+    }
+
+    return Finalize(acc, rowBytes, rows);
+}
+
+#if EXPANDSCREEN_PIPELINE_X86
+
+EXPANDSCREEN_TARGET_SSE41
+inline uint64_t HashSse41(const uint8_t* pixels, size_t pitch, uint32_t rowBytes, uint32_t rows)
+{
+    const uint64_t* key = SecretKey();
+    const uint32_t stripes = rowBytes / StripeBytes;
+    const uint32_t tail = rowBytes % StripeBytes;
+    const __m128i prime = _mm_set1_epi32((int)Prime32_1);
+
+    alignas(16) uint64_t init[8];
+    InitAccumulators(init);
+    __m128i acc[4];
+    for (int i = 0; i < 4; i++)
+    {
+        acc[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(init) + i);
+    }
+
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * pitch;
+        for (uint32_t s = 0; s <= stripes; s++)
+        {
+            alignas(16) uint8_t tailStripe[StripeBytes];
+            const uint8_t* data = row + (size_t)s * StripeBytes;
+            if (s == stripes)
+            {
+                if (tail == 0)
+                {
+                    break;
+                }
+                std::memset(tailStripe, 0, sizeof(tailStripe));
+                std::memcpy(tailStripe, data, tail);
+                data = tailStripe;
+            }
+
+            const __m128i* keyVec = reinterpret_cast<const __m128i*>(key + (s % 8));
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+                __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128(keyVec + i));
+                __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+                __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+                acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+            }
+        }
+
+        const __m128i* scrambleKey = reinterpret_cast<const __m128i*>(key + ScrambleKey);
+        for (int i = 0; i < 4; i++)
+        {
+            __m128i value = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+            value = _mm_xor_si128(value, _mm_loadu_si128(scrambleKey + i));
+            __m128i low = _mm_mul_epu32(value, prime);
+            __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+            acc[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+        }
+    }
+
+    alignas(16) uint64_t result[8];
+    for (int i = 0; i < 4; i++)
+    {
+        _mm_store_si128(reinterpret_cast<__m128i*>(result) + i, acc[i]);
+    }
+    return Finalize(result, rowBytes, rows);
+}
+
+EXPANDSCREEN_TARGET_AVX2
+inline uint64_t HashAvx2(const uint8_t* pixels, size_t pitch, uint32_t rowBytes, uint32_t rows)
+{
+    const uint64_t* key = SecretKey();
+    const uint32_t stripes = rowBytes / StripeBytes;
+    const uint32_t tail = rowBytes % StripeBytes;
+    const __m256i prime = _mm256_set1_epi32((int)Prime32_1);
+
+    alignas(32) uint64_t init[8];
+    InitAccumulators(init);
+    __m256i acc0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init));
+    __m256i acc1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(init) + 1);
+
+    const __m256i scrambleKey0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + ScrambleKey));
+    const __m256i scrambleKey1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + ScrambleKey) + 1);
+
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * pitch;
+        for (uint32_t s = 0; s <= stripes; s++)
+        {
+            alignas(32) uint8_t tailStripe[StripeBytes];
+            const uint8_t* data = row + (size_t)s * StripeBytes;
+            if (s == stripes)
+            {
+                if (tail == 0)
+                {
+                    break;
+                }
+                std::memset(tailStripe, 0, sizeof(tailStripe));
+                std::memcpy(tailStripe, data, tail);
+                data = tailStripe;
+            }
+
+            const __m256i* keyVec = reinterpret_cast<const __m256i*>(key + (s % 8));
+
+            __m256i value0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i value1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + 1);
+            __m256i keyed0 = _mm256_xor_si256(value0, _mm256_loadu_si256(keyVec));
+            __m256i keyed1 = _mm256_xor_si256(value1, _mm256_loadu_si256(keyVec + 1));
+            __m256i product0 = _mm256_mul_epu32(keyed0, _mm256_srli_epi64(keyed0, 32));
+            __m256i product1 = _mm256_mul_epu32(keyed1, _mm256_srli_epi64(keyed1, 32));
+            acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(product0,
+                _mm256_shuffle_epi32(value0, _MM_SHUFFLE(1, 0, 3, 2))));
+            acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(product1,
+                _mm256_shuffle_epi32(value1, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+
+        __m256i value0 = _mm256_xor_si256(_mm256_xor_si256(acc0, _mm256_srli_epi64(acc0, 47)), scrambleKey0);
+        __m256i value1 = _mm256_xor_si256(_mm256_xor_si256(acc1, _mm256_srli_epi64(acc1, 47)), scrambleKey1);
+        acc0 = _mm256_add_epi64(_mm256_mul_epu32(value0, prime),
+            _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value0, 32), prime), 32));
+        acc1 = _mm256_add_epi64(_mm256_mul_epu32(value1, prime),
+            _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value1, 32), prime), 32));
+    }
+
+    alignas(32) uint64_t result[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(result), acc0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(result) + 1, acc1);
+    return Finalize(result, rowBytes, rows);
+}
+
+EXPANDSCREEN_AVX512_BEGIN
+
+EXPANDSCREEN_TARGET_AVX512
+inline uint64_t HashAvx512(const uint8_t* pixels, size_t pitch, uint32_t rowBytes, uint32_t rows)
+{
+    const uint64_t* key = SecretKey();
+    const uint32_t stripes = rowBytes / StripeBytes;
+    const uint32_t tail = rowBytes % StripeBytes;
+    const __m512i prime = _mm512_set1_epi32((int)Prime32_1);
+    const __m512i scrambleKey = _mm512_loadu_si512(key + ScrambleKey);
+
+    // 行尾用掩码加载，被屏蔽的字节为零，与补零条带等价
+    const __mmask64 tailMask = tail == 0 ? 0 : (~0ull >> (64 - tail));
+
+    alignas(64) uint64_t init[8];
+    InitAccumulators(init);
+    __m512i acc = _mm512_load_si512(init);
+
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * pitch;
+        for (uint32_t s = 0; s <= stripes; s++)
+        {
+            __m512i value;
+            if (s < stripes)
+            {
+                value = _mm512_loadu_si512(row + (size_t)s * StripeBytes);
+            }
+            else if (tail != 0)
+            {
+                value = _mm512_maskz_loadu_epi8(tailMask, row + (size_t)s * StripeBytes);
+            }
+            else
+            {
+                break;
+            }
+
+            __m512i keyed = _mm512_xor_si512(value, _mm512_loadu_si512(key + (s % 8)));
+            __m512i product = _mm512_mul_epu32(keyed, _mm512_srli_epi64(keyed, 32));
+            __m512i swapped = _mm512_shuffle_epi32(value, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2));
+            acc = _mm512_add_epi64(acc, _mm512_add_epi64(product, swapped));
+        }
+
+        __m512i value = _mm512_xor_si512(_mm512_xor_si512(acc, _mm512_srli_epi64(acc, 47)), scrambleKey);
+        acc = _mm512_add_epi64(_mm512_mul_epu32(value, prime),
+            _mm512_slli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(value, 32), prime), 32));
+    }
+
+    alignas(64) uint64_t result[8];
+    _mm512_store_si512(result, acc);
+    return Finalize(result, rowBytes, rows);
+}
+
+EXPANDSCREEN_AVX512_END
+
+#endif // EXPANDSCREEN_PIPELINE_X86
+
+} // namespace TileHashDetail
+
+//
+// 哈希一块像素区域：rows行，每行rowBytes字节，行距pitch
+//
+using TileHashFunction = uint64_t (*)(const uint8_t* pixels, size_t pitch, uint32_t rowBytes, uint32_t rows);
+
+inline TileHashFunction SelectTileHash(CpuLevel level)
+{
+#if EXPANDSCREEN_PIPELINE_X86
+    switch (ClampCpuLevel(level))
+    {
+    case CpuLevel::Avx512: return TileHashDetail::HashAvx512;
+    case CpuLevel::Avx2: return TileHashDetail::HashAvx2;
+    case CpuLevel::Sse41: return TileHashDetail::HashSse41;
+    default: break;
+    }
+#else
+    (void)level;
+#endif
+    return TileHashDetail::HashScalar;
+}
+
+//
+// 单次过滤统计
+//
+struct TileHashStats
+{
+    uint32_t DirtyTiles = 0;        // 脏矩形覆盖的块数（去重）
+    uint32_t ChangedTiles = 0;
+    uint64_t HashedBytes = 0;
+    int64_t InputArea = 0;          // 输入脏矩形面积之和（裁剪到帧内）
+    int64_t OutputArea = 0;         // 输出脏矩形面积之和
+};
+
+//
+// 每监视器的块哈希表（BGRA8像素）
+//
+class TileHasher
+{
+public:
+    static constexpr int32_t DefaultTileSize = 64;
+    static constexpr uint32_t BytesPerPixel = 4;
+
+    explicit TileHasher(int32_t tileSize = DefaultTileSize, CpuLevel level = DetectCpuLevel())
+        : m_TileSize(tileSize > 0 ? tileSize : DefaultTileSize),
+          m_Level(ClampCpuLevel(level)),
+          m_Hash(SelectTileHash(level))
+    {
+    }
+
+    CpuLevel Level() const
+    {
+        return m_Level;
+    }
+
+    int32_t TileSize() const
+    {
+        return m_TileSize;
+    }
+
+    const TileHashStats& LastStats() const
+    {
+        return m_Stats;
+    }
+
+    //
+    // 作废全部块，下一次覆盖到的块一律视为变化
+    //
+    void Reset()
+    {
+        std::fill(m_Valid.begin(), m_Valid.end(), (uint8_t)0);
+    }
+
+    //
+    // 作废与给定矩形相交的块（例如移动区域的目标）
+    //
+    void Invalidate(const FrameRect* rects, uint32_t count)
+    {
+        const FrameRect frame = { 0, 0, m_Width, m_Height };
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            FrameRect clipped = IntersectRect(rects[i], frame);
+            if (clipped.IsEmpty())
+            {
+                continue;
+            }
+
+            for (int32_t ty = clipped.Top / m_TileSize; ty <= (clipped.Bottom - 1) / m_TileSize; ty++)
+            {
+                for (int32_t tx = clipped.Left / m_TileSize; tx <= (clipped.Right - 1) / m_TileSize; tx++)
+                {
+                    m_Valid[(size_t)ty * m_GridWidth + tx] = 0;
+                }
+            }
+        }
+    }
+
+    //
+    // 对脏矩形覆盖的块重新哈希，剔除内容未变化的块。
+    // 输出为输入矩形与变化块的交集（按块行合并水平连续的块），返回输出矩形数
+    //
+    uint32_t Filter(
+        const uint8_t* pixels,
+        size_t pitch,
+        int32_t width,
+        int32_t height,
+        const FrameRect* dirtyRects,
+        uint32_t dirtyRectCount,
+        std::vector<FrameRect>& output)
+    {
+        output.clear();
+        m_Stats = TileHashStats();
+
+        if (width <= 0 || height <= 0)
+        {
+            return 0;
+        }
+
+        PrepareGrid(width, height);
+
+        const FrameRect frame = { 0, 0, width, height };
+
+        for (uint32_t i = 0; i < dirtyRectCount; i++)
+        {
+            FrameRect rect = IntersectRect(dirtyRects[i], frame);
+            if (rect.IsEmpty())
+            {
+                continue;
+            }
+
+            m_Stats.InputArea += rect.Area();
+
+            const int32_t tx0 = rect.Left / m_TileSize;
+            const int32_t ty0 = rect.Top / m_TileSize;
+            const int32_t tx1 = (rect.Right - 1) / m_TileSize + 1;
+            const int32_t ty1 = (rect.Bottom - 1) / m_TileSize + 1;
+
+            uint32_t changed = 0;
+            for (int32_t ty = ty0; ty < ty1; ty++)
+            {
+                for (int32_t tx = tx0; tx < tx1; tx++)
+                {
+                    changed += TileChanged(pixels, pitch, tx, ty) ? 1 : 0;
+                }
+            }
+
+            if (changed == 0)
+            {
+                continue;
+            }
+
+            // 全部块都变化时原样输出，避免无谓的拆分
+            if (changed == (uint32_t)((tx1 - tx0) * (ty1 - ty0)))
+            {
+                output.push_back(rect);
+                m_Stats.OutputArea += rect.Area();
+                continue;
+            }
+
+            for (int32_t ty = ty0; ty < ty1; ty++)
+            {
+                int32_t tx = tx0;
+                while (tx < tx1)
+                {
+                    if (!m_Changed[(size_t)ty * m_GridWidth + tx])
+                    {
+                        tx++;
+                        continue;
+                    }
+
+                    int32_t start = tx;
+                    while (tx < tx1 && m_Changed[(size_t)ty * m_GridWidth + tx])
+                    {
+                        tx++;
+                    }
+
+                    FrameRect piece = IntersectRect(rect,
+                        { start * m_TileSize, ty * m_TileSize, tx * m_TileSize, (ty + 1) * m_TileSize });
+                    output.push_back(piece);
+                    m_Stats.OutputArea += piece.Area();
+                }
+            }
+        }
+
+        return (uint32_t)output.size();
+    }
+
+private:
+    void PrepareGrid(int32_t width, int32_t height)
+    {
+        if (width != m_Width || height != m_Height)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_GridWidth = (width + m_TileSize - 1) / m_TileSize;
+            m_GridHeight = (height + m_TileSize - 1) / m_TileSize;
+
+            size_t tiles = (size_t)m_GridWidth * m_GridHeight;
+            m_Hashes.assign(tiles, 0);
+            m_Valid.assign(tiles, 0);
+            m_Changed.assign(tiles, 0);
+            m_Stamp.assign(tiles, 0);
+            m_Epoch = 0;
+        }
+
+        // 每次过滤一个新纪元，同一块在一帧内只哈希一次
+        if (++m_Epoch == 0)
+        {
+            std::fill(m_Stamp.begin(), m_Stamp.end(), 0u);
+            m_Epoch = 1;
+        }
+    }
+
+    bool TileChanged(const uint8_t* pixels, size_t pitch, int32_t tx, int32_t ty)
+    {
+        size_t index = (size_t)ty * m_GridWidth + tx;
+        if (m_Stamp[index] == m_Epoch)
+        {
+            return m_Changed[index] != 0;
+        }
+
+        const int32_t left = tx * m_TileSize;
+        const int32_t top = ty * m_TileSize;
+        const uint32_t columns = (uint32_t)(m_Width - left < m_TileSize ? m_Width - left : m_TileSize);
+        const uint32_t rows = (uint32_t)(m_Height - top < m_TileSize ? m_Height - top : m_TileSize);
+
+        uint64_t hash = m_Hash(pixels + (size_t)top * pitch + (size_t)left * BytesPerPixel,
+            pitch, columns * BytesPerPixel, rows);
+
+        bool changed = !m_Valid[index] || m_Hashes[index] != hash;
+        m_Hashes[index] = hash;
+        m_Valid[index] = 1;
+        m_Changed[index] = changed ? 1 : 0;
+        m_Stamp[index] = m_Epoch;
+
+        m_Stats.DirtyTiles++;
+        m_Stats.ChangedTiles += changed ? 1 : 0;
+        m_Stats.HashedBytes += (uint64_t)columns * BytesPerPixel * rows;
+        return changed;
+    }
+
+    int32_t m_TileSize;
+    CpuLevel m_Level;
+    TileHashFunction m_Hash;
+    TileHashStats m_Stats;
+
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    int32_t m_GridWidth = 0;
+    int32_t m_GridHeight = 0;
+    uint32_t m_Epoch = 0;
+    std::vector<uint64_t> m_Hashes;
+    std::vector<uint8_t> m_Valid;
+    std::vector<uint8_t> m_Changed;
+    std::vector<uint32_t> m_Stamp;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
@@ -0,0 +1,383 @@
+/*++
+
+Module Name:
+    VideoRegion.h
+
+Abstract:
+    视频区域检测：按ContentTileSize的块网格维护更新热度，找出以稳定节奏持续更新的
+    矩形区域（窗口内播放的视频、动画），作为感兴趣区域提示随帧发布，编码器据此在
+    区域内分配码率、区域外跳过。
+
+    每块记录最近更新时间、更新间隔与间隔抖动的滑动平均和连续更新次数。连续更新达到
+    VideoRegionConfig::MinUpdates次、间隔不超过MaxIntervalPeriods个刷新区间且抖动
+    足够小的块为热块；光标闪烁、时钟等低频变化与打字等不规则变化不会变热。
+
+    只依据损伤区域，不读取像素。每帧只访问脏块与热块（热块在最近几个刷新区间内
+    更新过，本身就是近期的脏块），热块集合变化时才重建区域，稳定播放时
+    每帧代价与脏块数成正比。
+
+Environment:
+    User mode / portable C++17
+
+--*/
+
+#pragma once
+
+#include "FrameTypes.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ExpandScreen {
+namespace Pipeline {
+
+//
+// 检测配置，每个监视器一份
+//
+struct VideoRegionConfig
+{
+    uint32_t MinUpdates = 10;           // 块连续稳定更新达到此次数成为热块（60Hz下约0.17秒）
+    uint32_t MaxIntervalPeriods = 4;    // 更新间隔上限（刷新区间数），超过即中断连续更新
+    uint32_t JitterPercent = 35;        // 间隔抖动（平均绝对偏差）不超过平均间隔的此百分比
+    uint32_t MinTiles = 4;              // 区域至少包含的热块数
+    uint32_t MinFillPercent = 40;       // 热块占区域包围矩形的比例下限
+};
+
+struct VideoRegionStats
+{
+    uint64_t RegionFrames = 0;          // 带视频区域的帧数
+    uint64_t Rebuilds = 0;              // 热块集合变化后重建区域的次数
+    uint64_t Detections = 0;            // 重建后新出现的区域数（与上次区域不相交）
+    uint32_t MaxRegions = 0;            // 同时存在的最多区域数
+};
+
+class VideoRegionDetector
+{
+public:
+    //
+    // period为刷新周期（计数），必须大于0；不定速的交换链由调用者给出默认周期
+    //
+    void Configure(const VideoRegionConfig& config, int64_t period)
+    {
+        m_Config = config;
+        if (m_Config.MinUpdates < 2)
+        {
+            m_Config.MinUpdates = 2;
+        }
+        if (m_Config.MaxIntervalPeriods < 1)
+        {
+            m_Config.MaxIntervalPeriods = 1;
+        }
+        m_Period = period > 0 ? period : 1;
+        Reset();
+    }
+
+    const VideoRegionConfig& Config() const
+    {
+        return m_Config;
+    }
+
+    //
+    // 清空热度与区域，例如交换链重新分配之后
+    //
+    void Reset()
+    {
+        m_Width = 0;
+        m_Height = 0;
+        m_Columns = 0;
+        m_Rows = 0;
+        m_Tiles.clear();
+        m_Hot.clear();
+        m_RegionCount = 0;
+    }
+
+    const VideoRegionStats& Stats() const
+    {
+        return m_Stats;
+    }
+
+    void ResetStats()
+    {
+        m_Stats = VideoRegionStats();
+    }
+
+    //
+    // 当前的视频区域，按热块数从多到少排列
+    //
+    const VideoRegionHint* Regions() const
+    {
+        return m_Regions;
+    }
+
+    uint32_t RegionCount() const
+    {
+        return m_RegionCount;
+    }
+
+    uint32_t HotTiles() const
+    {
+        return (uint32_t)m_Hot.size();
+    }
+
+    bool IsHot(uint32_t column, uint32_t row) const
+    {
+        return column < m_Columns && row < m_Rows && m_Tiles[(size_t)row * m_Columns + column].HotSlot != 0;
+    }
+
+    //
+    // 记录一帧的损伤区域（now为本帧发布时间），返回更新后的区域数
+    //
+    uint32_t Update(
+        int32_t width,
+        int32_t height,
+        const FrameRect* damage,
+        uint32_t damageCount,
+        int64_t now)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            return m_RegionCount;
+        }
+
+        bool changed = false;
+        if (width != m_Width || height != m_Height)
+        {
+            m_Width = width;
+            m_Height = height;
+            m_Columns = (uint32_t)((width + ContentTileSize - 1) / ContentTileSize);
+            m_Rows = (uint32_t)((height + ContentTileSize - 1) / ContentTileSize);
+            m_Tiles.assign((size_t)m_Columns * m_Rows, TileHeat());
+            m_Hot.clear();
+            changed = m_RegionCount != 0;
+        }
+
+        m_Frame++;
+        const int64_t maxGap = m_Period * m_Config.MaxIntervalPeriods;
+        const FrameRect frame = { 0, 0, width, height };
+        for (uint32_t i = 0; i < damageCount; i++)
+        {
+            const FrameRect rect = IntersectRect(damage[i], frame);
+            if (rect.IsEmpty())
+            {
+                continue;
+            }
+
+            const uint32_t firstColumn = (uint32_t)(rect.Left / ContentTileSize);
+            const uint32_t lastColumn = (uint32_t)((rect.Right - 1) / ContentTileSize);
+            const uint32_t firstRow = (uint32_t)(rect.Top / ContentTileSize);
+            const uint32_t lastRow = (uint32_t)((rect.Bottom - 1) / ContentTileSize);
+            for (uint32_t row = firstRow; row <= lastRow; row++)
+            {
+                for (uint32_t column = firstColumn; column <= lastColumn; column++)
+                {
+                    const uint32_t index = row * m_Columns + column;
+                    if (m_Tiles[index].Frame != m_Frame)
+                    {
+                        changed |= Touch(index, now, maxGap);
+                    }
+                }
+            }
+        }
+
+        // 超过最大间隔没有更新的热块冷却（暂停、关闭窗口）
+        for (size_t i = 0; i < m_Hot.size();)
+        {
+            TileHeat& heat = m_Tiles[m_Hot[i]];
+            if (now - heat.LastUpdate > maxGap)
+            {
+                heat.Streak = 0;
+                RemoveHot(m_Hot[i]);
+                changed = true;
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if (changed)
+        {
+            Rebuild();
+        }
+
+        if (m_RegionCount != 0)
+        {
+            m_Stats.RegionFrames++;
+        }
+        return m_RegionCount;
+    }
+
+private:
+    struct TileHeat
+    {
+        uint64_t Frame = 0;         // 最近一次计入更新时的m_Frame
+        uint64_t Visit = 0;         // 重建区域时的访问印记
+        int64_t LastUpdate = 0;
+        int64_t Interval = 0;       // 更新间隔的滑动平均（1/4权重）
+        int64_t Jitter = 0;         // 间隔与平均值之差的绝对值的滑动平均
+        uint32_t Streak = 0;        // 连续更新次数
+        uint32_t HotSlot = 0;       // 在m_Hot中的下标+1，0表示不是热块
+    };
+
+    //
+    // 记录一块的更新，返回热块集合是否变化
+    //
+    bool Touch(uint32_t index, int64_t now, int64_t maxGap)
+    {
+        TileHeat& heat = m_Tiles[index];
+        heat.Frame = m_Frame;
+
+        const int64_t interval = now - heat.LastUpdate;
+        if (heat.Streak == 0 || interval <= 0 || interval > maxGap)
+        {
+            heat.Streak = 1;
+            heat.Interval = 0;
+            heat.Jitter = 0;
+        }
+        else if (heat.Streak == 1)
+        {
+            heat.Streak = 2;
+            heat.Interval = interval;
+            heat.Jitter = 0;
+        }
+        else
+        {
+            const int64_t deviation = interval > heat.Interval ? interval - heat.Interval : heat.Interval - interval;
+            heat.Jitter += (deviation - heat.Jitter) / 4;
+            heat.Interval += (interval - heat.Interval) / 4;
+            heat.Streak = heat.Streak < m_Config.MinUpdates ? heat.Streak + 1 : m_Config.MinUpdates;
+        }
+        heat.LastUpdate = now;
+
+        const bool steady = heat.Streak >= m_Config.MinUpdates &&
+            heat.Jitter * 100 <= heat.Interval * (int64_t)m_Config.JitterPercent;
+        if (steady && heat.HotSlot == 0)
+        {
+            m_Hot.push_back(index);
+            heat.HotSlot = (uint32_t)m_Hot.size();
+            return true;
+        }
+        if (!steady && heat.HotSlot != 0)
+        {
+            RemoveHot(index);
+            return true;
+        }
+        return false;
+    }
+
+    void RemoveHot(uint32_t index)
+    {
+        const uint32_t slot = m_Tiles[index].HotSlot - 1;
+        const uint32_t last = m_Hot.back();
+        m_Hot[slot] = last;
+        m_Tiles[last].HotSlot = slot + 1;
+        m_Hot.pop_back();
+        m_Tiles[index].HotSlot = 0;
+    }
+
+    //
+    // 热块分成连通块（相隔不超过一块即相连，视频中静止的一行/一列不会把区域切开），
+    // 包围矩形中热块足够多的作为区域
+    //
+    void Rebuild()
+    {
+        m_Stats.Rebuilds++;
+        m_Visit++;
+        m_Candidates.clear();
+
+        for (uint32_t start : m_Hot)
+        {
+            if (m_Tiles[start].Visit == m_Visit)
+            {
+                continue;
+            }
+
+            uint32_t minColumn = m_Columns, minRow = m_Rows, maxColumn = 0, maxRow = 0, tiles = 0;
+            int64_t intervalSum = 0;
+            m_Tiles[start].Visit = m_Visit;
+            m_Stack.assign(1, start);
+            while (!m_Stack.empty())
+            {
+                const uint32_t index = m_Stack.back();
+                m_Stack.pop_back();
+                const uint32_t column = index % m_Columns, row = index / m_Columns;
+                minColumn = std::min(minColumn, column);
+                maxColumn = std::max(maxColumn, column);
+                minRow = std::min(minRow, row);
+                maxRow = std::max(maxRow, row);
+                tiles++;
+                intervalSum += m_Tiles[index].Interval;
+
+                for (uint32_t y = row > 1 ? row - 2 : 0; y <= row + 2 && y < m_Rows; y++)
+                {
+                    for (uint32_t x = column > 1 ? column - 2 : 0; x <= column + 2 && x < m_Columns; x++)
+                    {
+                        TileHeat& neighbor = m_Tiles[(size_t)y * m_Columns + x];
+                        if (neighbor.HotSlot != 0 && neighbor.Visit != m_Visit)
+                        {
+                            neighbor.Visit = m_Visit;
+                            m_Stack.push_back(y * m_Columns + x);
+                        }
+                    }
+                }
+            }
+
+            const uint64_t area = (uint64_t)(maxColumn - minColumn + 1) * (maxRow - minRow + 1);
+            if (tiles < m_Config.MinTiles || (uint64_t)tiles * 100 < area * m_Config.MinFillPercent)
+            {
+                continue;
+            }
+
+            VideoRegionHint region = {};
+            region.Rect.Left = (int32_t)minColumn * ContentTileSize;
+            region.Rect.Top = (int32_t)minRow * ContentTileSize;
+            region.Rect.Right = std::min((int32_t)(maxColumn + 1) * ContentTileSize, m_Width);
+            region.Rect.Bottom = std::min((int32_t)(maxRow + 1) * ContentTileSize, m_Height);
+            region.Interval = intervalSum / tiles;
+            region.Tiles = tiles;
+            m_Candidates.push_back(region);
+        }
+
+        std::sort(m_Candidates.begin(), m_Candidates.end(),
+            [](const VideoRegionHint& a, const VideoRegionHint& b) { return a.Tiles > b.Tiles; });
+
+        // 与上次区域都不相交的区域计为新检测到
+        const uint32_t count = (uint32_t)std::min<size_t>(m_Candidates.size(), MaxVideoRegions);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            bool known = false;
+            for (uint32_t j = 0; j < m_RegionCount && !known; j++)
+            {
+                known = !IntersectRect(m_Candidates[i].Rect, m_Regions[j].Rect).IsEmpty();
+            }
+            m_Stats.Detections += known ? 0 : 1;
+        }
+
+        std::copy(m_Candidates.begin(), m_Candidates.begin() + count, m_Regions);
+        m_RegionCount = count;
+        m_Stats.MaxRegions = std::max(m_Stats.MaxRegions, count);
+    }
+
+    VideoRegionConfig m_Config;
+    int64_t m_Period = 1;
+
+    int32_t m_Width = 0;
+    int32_t m_Height = 0;
+    uint32_t m_Columns = 0;
+    uint32_t m_Rows = 0;
+    std::vector<TileHeat> m_Tiles;
+    std::vector<uint32_t> m_Hot;            // 热块下标，无序
+    uint64_t m_Frame = 0;
+    uint64_t m_Visit = 0;
+
+    std::vector<uint32_t> m_Stack;
+    std::vector<VideoRegionHint> m_Candidates;
+    VideoRegionHint m_Regions[MaxVideoRegions] = {};
+    uint32_t m_RegionCount = 0;
+
+    VideoRegionStats m_Stats;
+};
+
+} // namespace Pipeline
+} // namespace ExpandScreen
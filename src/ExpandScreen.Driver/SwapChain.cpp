@@ -12,82 +12,749 @@ Environment:
 --*/
 
 #include "Driver.h"
+#include "Pipeline/FrameWorker.h"
+#include <avrt.h>
 #include "SwapChain.tmh"
 
 #ifdef ALLOC_PRAGMA
-#pragma alloc_text(PAGE, ProcessSwapChainFrame)
+#pragma alloc_text(PAGE, StartSwapChainProcessing)
+#pragma alloc_text(PAGE, StopSwapChainProcessing)
 #endif
 
+using namespace ExpandScreen::Pipeline;
+
+// 等待新帧事件的兜底超时（毫秒），正常情况下由事件唤醒
+#define SWAPCHAIN_WAIT_TIMEOUT_MS 100
+
+namespace
+{
+
+//
+// IddCx交换链适配层，供FrameWorkerLoop驱动
+//
+class IddCxSwapChainSource
+{
+public:
+    using Frame = IDARG_OUT_RELEASEANDACQUIREBUFFER;
+
+    explicit IddCxSwapChainSource(PSWAPCHAIN_CONTEXT SwapChainContext)
+        : m_Context(SwapChainContext)
+    {
+    }
+
+    AcquireResult Acquire(Frame& frame)
+    {
+        IDARG_IN_RELEASEANDACQUIREBUFFER bufferArgs = {};
+
+        NTSTATUS status = IddCxSwapChainReleaseAndAcquireBuffer(
+            m_Context->SwapChain, &bufferArgs, &frame);
+
+        if (status == STATUS_PENDING)
+        {
+            return AcquireResult::Pending;
+        }
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+                "获取交换链帧失败，状态=%!STATUS!", status);
+            return AcquireResult::Failed;
+        }
+
+        return AcquireResult::Acquired;
+    }
+
+    void Release(Frame& frame)
+    {
+        IDARG_IN_RELEASEANDACQUIREBUFFER releaseArgs = {};
+        releaseArgs.pSurface = frame.pSurface;
+
+        NTSTATUS status = IddCxSwapChainReleaseAndAcquireBuffer(
+            m_Context->SwapChain, &releaseArgs, nullptr);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+                "释放交换链帧失败，状态=%!STATUS!", status);
+        }
+
+        // 通知IddCx本帧已处理完毕，DWM可以继续提交
+        IddCxSwapChainFinishedProcessingFrame(m_Context->SwapChain);
+    }
+
+    WaitResult Wait()
+    {
+        HANDLE waitHandles[] =
+        {
+            m_Context->FrameAvailableEvent,
+            m_Context->TerminateEvent,
+            m_Context->PacingTimer
+        };
+
+        // 有挂起帧时定时器设在下一个区间边界，画面静止后设在下一个补偿帧的时间，
+        // 否则只等新帧与终止
+        DWORD handleCount = 2;
+        const PFRAME_PIPELINE pipeline = m_Context->MonitorContext->FramePipeline;
+        BOOLEAN timed = FALSE;
+        INT64 deadline = 0;
+
+        if (pipeline->Pacer.HasPending())
+        {
+            timed = TRUE;
+            deadline = pipeline->Pacer.Deadline();
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(pipeline->FeedbackLock);
+            if (pipeline->Refinement.HasPending())
+            {
+                timed = TRUE;
+                deadline = pipeline->Refinement.Deadline();
+            }
+        }
+
+        if (timed && m_Context->PacingTimer != nullptr)
+        {
+            LARGE_INTEGER now;
+            LARGE_INTEGER frequency;
+            QueryPerformanceCounter(&now);
+            QueryPerformanceFrequency(&frequency);
+
+            // 相对时间以100ns为单位，负值
+            INT64 remaining = deadline - now.QuadPart;
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = remaining > 0 ? -(remaining * 10000000 / frequency.QuadPart) : -1;
+
+            if (SetWaitableTimer(m_Context->PacingTimer, &dueTime, 0, nullptr, nullptr, FALSE))
+            {
+                handleCount = 3;
+            }
+        }
+
+        DWORD waitResult = WaitForMultipleObjects(
+            handleCount, waitHandles, FALSE, SWAPCHAIN_WAIT_TIMEOUT_MS);
+
+        if (handleCount == 3 && waitResult != WAIT_OBJECT_0 + 2)
+        {
+            CancelWaitableTimer(m_Context->PacingTimer);
+        }
+
+        switch (waitResult)
+        {
+        case WAIT_OBJECT_0:
+            return WaitResult::FrameAvailable;
+        case WAIT_OBJECT_0 + 2:
+            return WaitResult::Deadline;
+        case WAIT_TIMEOUT:
+            return WaitResult::Timeout;
+        default:
+            // 终止事件或等待失败都结束线程
+            return WaitResult::Terminate;
+        }
+    }
+
+private:
+    PSWAPCHAIN_CONTEXT m_Context;
+};
+
+//
+// 帧处理回调适配层
+//
+class SwapChainFrameSink
+{
+public:
+    explicit SwapChainFrameSink(PSWAPCHAIN_CONTEXT SwapChainContext)
+        : m_Context(SwapChainContext)
+    {
+    }
+
+    void OnFrame(const IDARG_OUT_RELEASEANDACQUIREBUFFER& frame)
+    {
+        // 失效后重新分配的交换链取得第一帧，本次中断结束
+        SwapChainRecovery& recovery = m_Context->MonitorContext->FramePipeline->Recovery;
+        if (recovery.Recovering())
+        {
+            LARGE_INTEGER now;
+            LARGE_INTEGER frequency;
+            QueryPerformanceCounter(&now);
+            QueryPerformanceFrequency(&frequency);
+            recovery.OnFrame(now.QuadPart);
+            TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+                "交换链已恢复，失效到第一帧=%lldus", recovery.Stats().RecoveryTimeLast * 1000000 / frequency.QuadPart);
+        }
+
+        ProcessSwapChainFrame(m_Context, &frame);
+    }
+
+    // 一次唤醒内的突发只发布一次；区间内已发布过时留到区间边界由定时器唤醒发布。
+    // 没有待发布帧且画面已静止足够久时发布补偿帧。发布交给比较级与发布级，
+    // 这里只封存待发布帧，不等它写入帧环
+    void OnDrained()
+    {
+        PFRAME_PIPELINE pipeline = m_Context->MonitorContext->FramePipeline;
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+
+        if (pipeline->Pacer.ShouldEmit(now.QuadPart))
+        {
+            NTSTATUS status = SubmitPendingFrame(m_Context);
+            if (!NT_SUCCESS(status))
+            {
+                TraceEvents(TRACE_LEVEL_WARNING, TRACE_SWAPCHAIN,
+                    "发布帧失败，状态=%!STATUS!", status);
+            }
+        }
+        else if (!pipeline->Pacer.HasPending() && ShouldRefine(pipeline, now.QuadPart))
+        {
+            NTSTATUS status = SubmitRefinementFrame(m_Context);
+            if (!NT_SUCCESS(status))
+            {
+                TraceEvents(TRACE_LEVEL_WARNING, TRACE_SWAPCHAIN,
+                    "发布补偿帧失败，状态=%!STATUS!", status);
+            }
+        }
+    }
+
+private:
+    static bool ShouldRefine(PFRAME_PIPELINE Pipeline, INT64 Now)
+    {
+        std::lock_guard<std::mutex> lock(Pipeline->FeedbackLock);
+        return Pipeline->Refinement.ShouldRefine(Now);
+    }
+
+    PSWAPCHAIN_CONTEXT m_Context;
+};
+
 /*++
 
 Routine Description:
-    处理交换链帧数据
+    交换链帧处理线程入口
+
+Arguments:
+    Parameter - 交换链上下文
+
+Return Value:
+    线程退出码
+
+--*/
+DWORD WINAPI SwapChainProcessingThread(
+    _In_ LPVOID Parameter
+)
+{
+    PSWAPCHAIN_CONTEXT swapChainContext = (PSWAPCHAIN_CONTEXT)Parameter;
+
+    // 注册到MMCSS，降低被普通线程抢占导致的唤醒延迟
+    DWORD avTaskIndex = 0;
+    HANDLE avTask = AvSetMmThreadCharacteristicsW(L"Distribution", &avTaskIndex);
+
+    // 本线程只获取、拷出并释放表面，比较与发布在各级线程上进行
+    NTSTATUS status = StartFrameStages(swapChainContext);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "启动帧处理各级失败，状态=%!STATUS!", status);
+    }
+
+    IddCxSwapChainSource source(swapChainContext);
+    SwapChainFrameSink sink(swapChainContext);
+    FrameWorkerLoop<IddCxSwapChainSource, SwapChainFrameSink> loop(source, sink);
+
+    WorkerExitReason reason = loop.Run();
+    const FrameWorkerStats& stats = loop.Stats();
+
+    // 已封存的帧全部发布后各级才退出，此后下面的统计不再变化
+    StopFrameStages(swapChainContext);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "帧处理线程退出，原因=%d，处理帧数=%llu，唤醒次数=%llu，空唤醒=%llu，最大突发=%llu",
+        (int)reason, stats.FramesProcessed, stats.Wakeups, stats.EmptyWakeups, stats.MaxBurst);
+
+    // 定速统计换算为微秒
+    const FramePacerStats& pacing = swapChainContext->MonitorContext->FramePipeline->Pacer.Stats();
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    const INT64 ticksPerUs = frequency.QuadPart / 1000000 > 0 ? frequency.QuadPart / 1000000 : 1;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "定速：提交=%llu，发布=%llu，合并=%llu，延后=%llu，平均延迟=%lldus，最大延迟=%lldus，抖动=%lldus，最大边界误差=%lldus",
+        pacing.Presents, pacing.Emits, pacing.Coalesced, pacing.Deferred,
+        pacing.Emits != 0 ? pacing.LatencyTotal / (INT64)pacing.Emits / ticksPerUs : 0,
+        pacing.LatencyMax / ticksPerUs,
+        pacing.Jitter / ticksPerUs,
+        pacing.BoundaryErrorMax / ticksPerUs);
+
+    // 各级占用率（忙时间/运行时间）与最大输入队列深度，接近100%的一级决定帧率上限
+    const FrameStageGraph& stages = swapChainContext->MonitorContext->FramePipeline->Stages;
+    const FrameStageGraphStats stageStats = stages.Stats();
+    const FrameStageStats diffStats = stages.StageStats(0);
+    const FrameStageStats publishStats = stages.StageStats(1);
+    const UINT64 elapsedNs = stageStats.ElapsedNs != 0 ? stageStats.ElapsedNs : 1;
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "各级：%s，封存=%llu，比较占用=%llu%%（最大队列%u），发布占用=%llu%%（最大队列%u），等待作业=%llu次/%lluus，最多在途=%u",
+        stages.Threaded() ? "流水线" : "串行",
+        stageStats.Submitted,
+        diffStats.BusyNs * 100 / elapsedNs,
+        diffStats.MaxQueueDepth,
+        publishStats.BusyNs * 100 / elapsedNs,
+        publishStats.MaxQueueDepth,
+        stageStats.JobWaits,
+        stageStats.JobWaitNs / 1000,
+        stageStats.MaxInFlight);
+
+    const StaticRefinementStats& refinement = swapChainContext->MonitorContext->FramePipeline->Refinement.Stats();
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "静止补偿：静止期=%llu，补偿帧=%llu，中断=%llu，补偿面积=%lld",
+        refinement.Activations, refinement.RefinementFrames, refinement.Interrupted, refinement.RefinedArea);
+
+    const VideoRegionStats& video = swapChainContext->MonitorContext->FramePipeline->VideoRegions.Stats();
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "视频区域：带区域的帧=%llu，检测到=%llu，重建=%llu，最多同时=%u",
+        video.RegionFrames, video.Detections, video.Rebuilds, video.MaxRegions);
+
+    const ContentCadenceStats& cadence = swapChainContext->MonitorContext->FramePipeline->Cadence.Stats();
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "内容节奏：降频=%llu，挂起提交=%llu，退出（输入=%llu，区域外损伤=%llu，节奏变化=%llu）",
+        cadence.Activations, cadence.HeldPresents,
+        cadence.Exits[(UINT32)CadenceExitReason::Input],
+        cadence.Exits[(UINT32)CadenceExitReason::Damage],
+        cadence.Exits[(UINT32)CadenceExitReason::Irregular]);
+
+    const SwapChainRecoveryStats& recovery = swapChainContext->MonitorContext->FramePipeline->Recovery.Stats();
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "交换链恢复：中断=%llu，再次失效=%llu，分配失败=%llu，重发=%llu，恢复=%llu，失效到第一帧 最近=%lldus，最大=%lldus",
+        recovery.Losses, recovery.Relosses, recovery.AssignFailures, recovery.Retransmits, recovery.Recoveries,
+        recovery.RecoveryTimeLast / ticksPerUs, recovery.RecoveryTimeMax / ticksPerUs);
+
+    // 驱动侧延迟分位数（帧环头内的统计块，随监视器累计）
+    PMONITOR_CONTEXT monitorContext = swapChainContext->MonitorContext;
+    FrameRingConsumer ring;
+    LatencyStatsReader latencyReader;
+    LatencyStatsSnapshot latency;
+    if (ring.Attach(monitorContext->FrameRingView, monitorContext->FrameRingSize) &&
+        latencyReader.Attach(ring.Latency(), sizeof(LatencyStatsBlock)) &&
+        latencyReader.Snapshot(latency))
+    {
+        const UINT32 intervals[] =
+        {
+            LatencyIntervalOf(LatencyStage::Acquire),
+            LatencyIntervalOf(LatencyStage::Publish),
+            LatencyTotalInterval
+        };
+
+        for (UINT32 interval : intervals)
+        {
+            const LatencyHistogram& histogram = latency.Intervals[interval];
+            TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+                "延迟 %s：帧=%llu，p50=%lluus，p90=%lluus，p99=%lluus，最大=%lluus",
+                LatencyIntervalName(interval), histogram.Count,
+                histogram.PercentileUs(50), histogram.PercentileUs(90), histogram.PercentileUs(99), histogram.MaxUs);
+        }
+    }
+
+    // 各原因未成为独立帧的计数（随监视器累计），覆盖说明消费者跟不上
+    if (ring.IsAttached())
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+            "丢弃：合并=%llu，未变化=%llu，覆盖未取走=%llu，失败=%llu",
+            ring.Drops(FrameDropReason::Coalesced), ring.Drops(FrameDropReason::Unchanged),
+            ring.Drops(FrameDropReason::Superseded), ring.Drops(FrameDropReason::Failed));
+    }
+
+    if (avTask != nullptr)
+    {
+        AvRevertMmThreadCharacteristics(avTask);
+    }
+
+    // 取帧失败说明交换链已失效（适配器重置、TDR、GPU切换）。删除它，IddCx随后取消分配
+    // 并重新分配；正在停止时的失败不是失效。帧环与监视器级的状态都保留到重新分配
+    if (reason == WorkerExitReason::AcquireFailed &&
+        WaitForSingleObject(swapChainContext->TerminateEvent, 0) != WAIT_OBJECT_0)
+    {
+        LARGE_INTEGER lostTime;
+        QueryPerformanceCounter(&lostTime);
+        if (swapChainContext->MonitorContext->FramePipeline->Recovery.OnLost(lostTime.QuadPart))
+        {
+            TraceEvents(TRACE_LEVEL_WARNING, TRACE_SWAPCHAIN,
+                "监视器ID=%d的交换链已失效，请求重新分配", swapChainContext->MonitorContext->MonitorId);
+            WdfObjectDelete(swapChainContext->SwapChain);
+        }
+    }
+
+    return 0;
+}
+
+/*++
+
+Routine Description:
+    在IddCx指定的渲染适配器上创建D3D设备并关联到交换链
 
 Arguments:
     SwapChainContext - 交换链上下文
+    RenderAdapterLuid - 渲染适配器LUID
 
 Return Value:
     NTSTATUS
 
 --*/
-NTSTATUS ProcessSwapChainFrame(
+NTSTATUS CreateSwapChainDevice(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ LUID RenderAdapterLuid
+)
+{
+    IDXGIFactory5* factory = nullptr;
+    IDXGIAdapter1* adapter = nullptr;
+    IDXGIDevice* dxgiDevice = nullptr;
+    NTSTATUS status = STATUS_UNSUCCESSFUL;
+
+    HRESULT hr = CreateDXGIFactory2(0, IID_PPV_ARGS(&factory));
+    if (SUCCEEDED(hr))
+    {
+        hr = factory->EnumAdapterByLuid(RenderAdapterLuid, IID_PPV_ARGS(&adapter));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = D3D11CreateDevice(
+            adapter,
+            D3D_DRIVER_TYPE_UNKNOWN,
+            nullptr,
+            D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+            nullptr,
+            0,
+            D3D11_SDK_VERSION,
+            &SwapChainContext->Device,
+            nullptr,
+            &SwapChainContext->DeviceContext);
+    }
+
+    // 比较级与发布级在各自线程上映射暂存纹理，与帧处理线程的拷贝共用即时上下文
+    if (SUCCEEDED(hr))
+    {
+        ID3D11Multithread* multithread = nullptr;
+        hr = SwapChainContext->DeviceContext->QueryInterface(IID_PPV_ARGS(&multithread));
+        if (SUCCEEDED(hr))
+        {
+            multithread->SetMultithreadProtected(TRUE);
+            multithread->Release();
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        hr = SwapChainContext->Device->QueryInterface(IID_PPV_ARGS(&dxgiDevice));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        IDARG_IN_SWAPCHAINSETDEVICE setDevice = {};
+        setDevice.pDevice = dxgiDevice;
+        status = IddCxSwapChainSetDevice(SwapChainContext->SwapChain, &setDevice);
+    }
+    else
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建渲染适配器D3D设备失败，hr=0x%08X", hr);
+    }
+
+    if (dxgiDevice != nullptr)
+    {
+        dxgiDevice->Release();
+    }
+    if (adapter != nullptr)
+    {
+        adapter->Release();
+    }
+    if (factory != nullptr)
+    {
+        factory->Release();
+    }
+
+    return status;
+}
+
+/*++
+
+Routine Description:
+    释放交换链的D3D资源，调用前帧处理线程必须已退出
+
+Arguments:
+    SwapChainContext - 交换链上下文
+
+Return Value:
+    无
+
+--*/
+VOID ReleaseSwapChainDevice(
     _In_ PSWAPCHAIN_CONTEXT SwapChainContext
 )
+{
+    for (UINT32 i = 0; i < FRAME_JOB_COUNT; i++)
+    {
+        if (SwapChainContext->StagingTextures[i] != nullptr)
+        {
+            SwapChainContext->StagingTextures[i]->Release();
+            SwapChainContext->StagingTextures[i] = nullptr;
+        }
+    }
+
+    if (SwapChainContext->DeviceContext != nullptr)
+    {
+        SwapChainContext->DeviceContext->Release();
+        SwapChainContext->DeviceContext = nullptr;
+    }
+
+    if (SwapChainContext->Device != nullptr)
+    {
+        SwapChainContext->Device->Release();
+        SwapChainContext->Device = nullptr;
+    }
+}
+
+} // namespace
+
+/*++
+
+Routine Description:
+    为新分配的交换链创建上下文并启动帧处理线程
+
+Arguments:
+    MonitorContext - 监视器上下文
+    pInArgs - IddCx分配交换链参数
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS StartSwapChainProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext,
+    _In_ const IDARG_IN_SETSWAPCHAIN* pInArgs
+)
 {
     NTSTATUS status = STATUS_SUCCESS;
-    IDDCX_SWAPCHAIN swapChain = SwapChainContext->SwapChain;
+    WDF_OBJECT_ATTRIBUTES attributes;
+    PSWAPCHAIN_CONTEXT swapChainContext = nullptr;
 
     PAGED_CODE();
 
-    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
-        "%!FUNC! 处理交换链帧");
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&attributes, SWAPCHAIN_CONTEXT);
 
-    // 获取可用帧
-    IDARG_IN_RELEASEANDACQUIREBUFFER bufferArgs = {};
-    IDARG_OUT_RELEASEANDACQUIREBUFFER bufferArgsOut = {};
+    // 上下文挂在交换链对象上，随交换链一起释放
+    status = WdfObjectAllocateContext(pInArgs->hSwapChain, &attributes, (PVOID*)&swapChainContext);
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "分配交换链上下文失败，状态=%!STATUS!", status);
+        return status;
+    }
 
-    status = IddCxSwapChainReleaseAndAcquireBuffer(swapChain, &bufferArgs, &bufferArgsOut);
+    swapChainContext->SwapChain = pInArgs->hSwapChain;
+    swapChainContext->MonitorContext = MonitorContext;
+    swapChainContext->FrameAvailableEvent = pInArgs->hNextSurfaceAvailable;
 
+    status = CreateSwapChainDevice(swapChainContext, pInArgs->RenderAdapterLuid);
     if (!NT_SUCCESS(status))
     {
-        if (status != STATUS_PENDING)
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "关联交换链设备失败，状态=%!STATUS!", status);
+        ReleaseSwapChainDevice(swapChainContext);
+        return status;
+    }
+
+    // 自动重置事件，Stop时触发
+    swapChainContext->TerminateEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (swapChainContext->TerminateEvent == nullptr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建终止事件失败，错误=%d", GetLastError());
+        ReleaseSwapChainDevice(swapChainContext);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    // 高精度定时器（Windows 10 1803起），不支持时退回普通定时器
+    swapChainContext->PacingTimer = CreateWaitableTimerExW(
+        nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (swapChainContext->PacingTimer == nullptr)
+    {
+        swapChainContext->PacingTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+
+    // 按已提交模式的刷新率定速；新交换链的第一帧按整帧处理
+    PFRAME_PIPELINE pipeline = MonitorContext->FramePipeline;
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    pipeline->Pacer.Configure(
+        frequency.QuadPart, MonitorContext->RefreshNumerator, MonitorContext->RefreshDenominator);
+    pipeline->Pacer.ResetStats();
+    pipeline->PendingWidth = 0;
+    pipeline->PendingHeight = 0;
+
+    // 静止补偿按刷新区间计时，刷新率未知时按60Hz计
+    pipeline->Refinement.Configure(
+        pipeline->RefinementConfig,
+        pipeline->Pacer.Period() != 0 ? pipeline->Pacer.Period() : frequency.QuadPart / 60);
+    pipeline->Refinement.ResetStats();
+
+    // 视频判定的更新间隔同样按刷新区间计
+    pipeline->ContentClassifier.Configure(
+        pipeline->ContentConfig,
+        pipeline->Pacer.Period() != 0 ? pipeline->Pacer.Period() : frequency.QuadPart / 60);
+    pipeline->VideoRegions.Configure(
+        pipeline->VideoConfig,
+        pipeline->Pacer.Period() != 0 ? pipeline->Pacer.Period() : frequency.QuadPart / 60);
+    pipeline->VideoRegions.ResetStats();
+
+    // 不定速时没有刷新周期，不做节奏检测
+    pipeline->Cadence.Configure(pipeline->CadenceConfig, pipeline->Pacer.Period());
+    pipeline->Cadence.ResetStats();
+
+    // 交换链失效后的重新分配：帧处理线程启动前重发最后一帧，此时只有本线程写入帧环
+    LARGE_INTEGER assignTime;
+    QueryPerformanceCounter(&assignTime);
+    if (pipeline->Recovery.OnAssign(assignTime.QuadPart))
+    {
+        if (RetransmitLastFrame(MonitorContext, assignTime.QuadPart))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
-                "获取交换链帧失败，状态=%!STATUS!", status);
+            LARGE_INTEGER retransmitTime;
+            QueryPerformanceCounter(&retransmitTime);
+            pipeline->Recovery.OnRetransmit(retransmitTime.QuadPart);
         }
-        return status;
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+            "监视器ID=%d交换链重新分配，距失效%lldus，累计重发=%llu",
+            MonitorContext->MonitorId,
+            (assignTime.QuadPart - pipeline->Recovery.LossTime()) * 1000000 / frequency.QuadPart,
+            pipeline->Recovery.Stats().Retransmits);
+    }
+    else if (!pipeline->Recovery.Recovering())
+    {
+        pipeline->DiffKeepReference = FALSE;
     }
 
-    // 检查是否有新帧
-    if (bufferArgsOut.MetaData.DirtyRectCount == 0)
+    // 帧处理线程在交换链失效时删除交换链，保留引用使上下文在取消分配回调中仍然有效
+    WdfObjectReference(swapChainContext->SwapChain);
+
+    swapChainContext->ProcessingThread = CreateThread(
+        nullptr, 0, SwapChainProcessingThread, swapChainContext, 0, nullptr);
+
+    if (swapChainContext->ProcessingThread == nullptr)
     {
-        // 没有脏矩形，跳过处理
-        TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
-            "没有脏矩形，跳过帧");
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
+            "创建帧处理线程失败，错误=%d", GetLastError());
+        WdfObjectDereference(swapChainContext->SwapChain);
+        CloseHandle(swapChainContext->TerminateEvent);
+        swapChainContext->TerminateEvent = nullptr;
+        if (swapChainContext->PacingTimer != nullptr)
+        {
+            CloseHandle(swapChainContext->PacingTimer);
+            swapChainContext->PacingTimer = nullptr;
+        }
+        ReleaseSwapChainDevice(swapChainContext);
+        return STATUS_INSUFFICIENT_RESOURCES;
     }
-    else
+
+    MonitorContext->SwapChainContext = swapChainContext;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "%!FUNC! 监视器ID=%d的帧处理线程已启动", MonitorContext->MonitorId);
+
+    return status;
+}
+
+/*++
+
+Routine Description:
+    停止帧处理线程，返回时线程已退出且不再访问交换链
+
+Arguments:
+    MonitorContext - 监视器上下文
+
+Return Value:
+    无
+
+--*/
+VOID StopSwapChainProcessing(
+    _In_ PMONITOR_CONTEXT MonitorContext
+)
+{
+    PSWAPCHAIN_CONTEXT swapChainContext = MonitorContext->SwapChainContext;
+
+    PAGED_CODE();
+
+    if (swapChainContext == nullptr)
     {
-        TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
-            "处理帧: 脏矩形数=%d", bufferArgsOut.MetaData.DirtyRectCount);
+        return;
+    }
 
-        // TODO: 在这里实现实际的帧数据处理
-        // 1. 从Surface获取帧数据
-        // 2. 编码帧数据（在用户态完成）
-        // 3. 通过IOCTL传递给用户态应用程序
+    if (swapChainContext->ProcessingThread != nullptr)
+    {
+        SetEvent(swapChainContext->TerminateEvent);
+        WaitForSingleObject(swapChainContext->ProcessingThread, INFINITE);
+        CloseHandle(swapChainContext->ProcessingThread);
+        swapChainContext->ProcessingThread = nullptr;
+    }
 
-        // 当前实现：简单地标记帧为已处理
+    if (swapChainContext->TerminateEvent != nullptr)
+    {
+        CloseHandle(swapChainContext->TerminateEvent);
+        swapChainContext->TerminateEvent = nullptr;
+    }
+
+    if (swapChainContext->PacingTimer != nullptr)
+    {
+        CloseHandle(swapChainContext->PacingTimer);
+        swapChainContext->PacingTimer = nullptr;
     }
 
-    // 释放帧
-    IDARG_IN_RELEASEANDACQUIREBUFFER releaseArgs = {};
-    releaseArgs.pSurface = bufferArgsOut.pSurface;
+    ReleaseSwapChainDevice(swapChainContext);
 
-    status = IddCxSwapChainReleaseAndAcquireBuffer(swapChain, &releaseArgs, nullptr);
+    MonitorContext->SwapChainContext = nullptr;
 
+    // 启动时取得的引用，此后不再访问交换链上下文
+    WdfObjectDereference(swapChainContext->SwapChain);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_SWAPCHAIN,
+        "%!FUNC! 监视器ID=%d的帧处理线程已停止", MonitorContext->MonitorId);
+}
+
+/*++
+
+Routine Description:
+    处理一帧已获取的交换链缓冲区，由帧处理线程调用
+
+Arguments:
+    SwapChainContext - 交换链上下文
+    Buffer - 本次获取到的缓冲区
+
+Return Value:
+    NTSTATUS
+
+--*/
+NTSTATUS ProcessSwapChainFrame(
+    _In_ PSWAPCHAIN_CONTEXT SwapChainContext,
+    _In_ const IDARG_OUT_RELEASEANDACQUIREBUFFER* Buffer
+)
+{
+    NTSTATUS status;
+
+    // 检查是否有新帧（滚动时可能只有移动区域）
+    if (Buffer->MetaData.DirtyRectCount == 0 && Buffer->MetaData.MoveRegionCount == 0)
+    {
+        // 没有脏矩形和移动区域，跳过处理
+        TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
+            "没有脏矩形，跳过帧");
+        return STATUS_SUCCESS;
+    }
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_SWAPCHAIN,
+        "处理帧: 脏矩形数=%d, 移动区域数=%d",
+        Buffer->MetaData.DirtyRectCount, Buffer->MetaData.MoveRegionCount);
+
+    // 拷贝到暂存纹理并合并损伤区域，按定速发布到共享内存帧环（见OnDrained）
+    status = CaptureFrame(SwapChainContext, Buffer);
     if (!NT_SUCCESS(status))
     {
-        TraceEvents(TRACE_LEVEL_ERROR, TRACE_SWAPCHAIN,
-            "释放交换链帧失败，状态=%!STATUS!", status);
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_SWAPCHAIN,
+            "捕获帧失败，状态=%!STATUS!", status);
     }
 
     return status;
@@ -25,6 +25,7 @@ Environment:
         WPP_DEFINE_BIT(TRACE_SWAPCHAIN)   /* bit  3 = 0x00000008 */ \
         WPP_DEFINE_BIT(TRACE_EDID)        /* bit  4 = 0x00000010 */ \
         WPP_DEFINE_BIT(TRACE_IOCTL)       /* bit  5 = 0x00000020 */ \
+        WPP_DEFINE_BIT(TRACE_CURSOR)      /* bit  6 = 0x00000040 */ \
         )
 
 #define WPP_LEVEL_FLAGS_LOGGER(lvl,flags) \